@@ -78,8 +78,10 @@ typedef struct sgw_pdn_connection_s {
   // NOT NEEDED s_gw_gre_key_for_dl_traffic_up         ///< user plane for downlink traffic. (For PMIP-based S5/S8 only)
   ebi_t                default_bearer;                 ///< Identifies the default bearer within the PDN connection by its EPS Bearer Id. (For PMIP based S5/S8.)
 
-  // eps bearers
-  hash_table_ts_t     *sgw_eps_bearers;
+  // eps bearers, indexed by EBI - EPS_BEARER_IDENTITY_FIRST, NULL if not created
+  sgw_eps_bearer_entry_t *sgw_eps_bearers[BEARERS_PER_UE];
+  // storage of the first bearer created (the default bearer), others come from the SGW bearer pool
+  sgw_eps_bearer_entry_t  embedded_bearer;
 
 } sgw_pdn_connection_t;
 
@@ -137,7 +139,7 @@ typedef struct pgw_eps_bearer_context_information_s {
   // NOT NEEDED OMC identity                           ///< Identifies the OMC that shall receive the trace record(s).
 
   // TO BE CONTINUED...
-  obj_hash_table_t    *apns;
+  obj_hash_table_t    *apns;                           ///< Not allocated, APNs are not tracked yet.
 } pgw_eps_bearer_context_information_t;
 
 
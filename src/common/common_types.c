@@ -30,6 +30,7 @@
 
 #include "string.h"
 #include "common_types.h"
+#include "obj_hashtable.h"
 
 /* Clear GUTI without free it */
 void clear_guti(guti_t * const guti)
@@ -62,4 +63,18 @@ void clear_tai(tai_t * const tai)
   memset(tai, 0, sizeof(tai_t));
 }
 
+/* Typed hash of a guti_t key: the GUMMEI and the M-TMSI are mixed as two
+ * words, whatever the padding bytes of the structure. */
+size_t guti_hashfunc(const void * const guti, int key_size)
+{
+  const guti_t * const guti_p = (const guti_t *)guti;
+  const uint8_t * const plmn = (const uint8_t *)&guti_p->gummei.plmn;
+  uint64_t gummei = 0;
 
+  if (key_size != sizeof(guti_t)) {
+    return obj_hashtable_hash(guti, key_size);
+  }
+  gummei = ((uint64_t)plmn[0]) | ((uint64_t)plmn[1] << 8) | ((uint64_t)plmn[2] << 16) |
+           ((uint64_t)guti_p->gummei.mme_gid << 24) | ((uint64_t)guti_p->gummei.mme_code << 40);
+  return obj_hashtable_hash_2x64(gummei, guti_p->m_tmsi);
+}
@@ -33,6 +33,7 @@
 #define FILE_COMMON_TYPES_SEEN
 
 #include <stdint.h>
+#include <stddef.h>
 #include "3gpp_23.003.h"
 #include "3gpp_24.007.h"
 #include "3gpp_24.008.h"
@@ -47,6 +48,8 @@ void clear_imsi(imsi_t * const imsi);
 void clear_imei(imei_t * const imei);
 void clear_imeisv(imeisv_t * const imeisv);
 void clear_tai(tai_t * const tai);
+// hash function of obj_hashtables keyed by guti_t
+size_t guti_hashfunc(const void * const guti, int key_size);
 
 typedef uint16_t                 sctp_stream_id_t;
 typedef uint32_t                 sctp_assoc_id_t;
@@ -358,6 +361,8 @@ typedef enum {
 
 typedef enum {
   DIAMETER_SUCCESS = 2001,
+  DIAMETER_UNABLE_TO_DELIVER = 3002,
+  DIAMETER_TOO_BUSY = 3004,
 } s6a_base_result_t;
 
 typedef struct {
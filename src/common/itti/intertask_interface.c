@@ -47,6 +47,8 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "intertask_interface_trace.h"
+#include "intertask_interface_stats.h"
 
 #include "memory_pools.h"
 
@@ -93,6 +95,7 @@ typedef struct message_list_s {
 
   message_number_t                        message_number;       ///< Unique message number
   uint32_t                                message_priority;     ///< Message priority
+  uint64_t                                enqueue_ns;           ///< Time of enqueue, for the queue statistics
 } message_list_t;
 
 typedef struct thread_desc_s {
@@ -361,6 +364,8 @@ itti_alloc_new_message_sized (
   temp->ittiMsgHeader.messageId = message_id;
   temp->ittiMsgHeader.originTaskId = origin_task_id;
   temp->ittiMsgHeader.ittiMsgSize = size;
+  temp->ittiMsgHeader.trace_id = itti_trace_current;
+  temp->ittiMsgHeader.trace_hop = ITTI_TRACE_MAX_HOPS;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, 0);
   return temp;
 }
@@ -431,6 +436,10 @@ itti_send_msg_to_task (
       new->msg = message;
       new->message_number = message_number;
       new->message_priority = priority;
+      if (message->ittiMsgHeader.trace_id != ITTI_TRACE_ID_NONE) {
+        message->ittiMsgHeader.trace_hop = itti_trace_enqueue (message->ittiMsgHeader.trace_id, message_id, origin_task_id, destination_task_id);
+      }
+      new->enqueue_ns = itti_stats_enqueue (destination_task_id);
       /*
        * Enqueue message in destination task queue
        */
@@ -553,6 +562,8 @@ itti_receive_msg_internal_event_fd (
   AssertFatal (received_msg != NULL, "Received message is NULL!\n");
   thread_id = TASK_GET_THREAD_ID (task_id);
   *received_msg = NULL;
+  itti_stats_handler_end ();
+  itti_trace_dequeue (task_id, NULL);
 
   if (polling) {
     /*
@@ -609,6 +620,8 @@ itti_receive_msg_internal_event_fd (
 
       AssertFatal (message != NULL, "Message from message queue is NULL!\n");
       *received_msg = message->msg;
+      itti_stats_dequeue (task_id, ITTI_MSG_ID (message->msg), message->enqueue_ns);
+      itti_trace_dequeue (task_id, *received_msg);
       result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
       /*
@@ -637,6 +650,7 @@ itti_poll_msg (
 {
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
+  itti_stats_handler_end ();
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
   {
     struct message_list_s                  *message;
@@ -645,12 +659,15 @@ itti_poll_msg (
       int                                     result;
 
       *received_msg = message->msg;
+      itti_stats_dequeue (task_id, ITTI_MSG_ID (message->msg), message->enqueue_ns);
+      itti_trace_dequeue (task_id, *received_msg);
       result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
     }
   }
 
   if (*received_msg == NULL) {
+    itti_trace_dequeue (task_id, NULL);
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
   }
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_and_and_fetch (&itti_desc.vcd_poll_msg, ~(1L << task_id)));
@@ -806,6 +823,7 @@ itti_init (
    * Allocates memory for threads info
    */
   itti_desc.threads = calloc (itti_desc.thread_max, sizeof (thread_desc_t));
+  CHECK_INIT_RETURN (itti_stats_init (itti_desc.task_max, itti_desc.messages_id_max));
 
   /*
    * Initializing each queue and related stuff
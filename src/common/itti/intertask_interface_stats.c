@@ -0,0 +1,336 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_stats.c
+  \brief Queue depth, queue wait time and handler time of the ITTI tasks.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "log.h"
+#include "metrics.h"
+#include "intertask_interface.h"
+#include "intertask_interface_stats.h"
+
+/*
+ * The depth and the counters of a task are updated by the senders with atomic
+ * operations, the wait histogram by the thread receiving the messages of the
+ * task only, on another cache line. The handler statistics of a task are also
+ * written by its receiving thread only, readers may see a count and a sum not
+ * yet in sync which is fine for statistics.
+ */
+typedef struct itti_task_stats_s {
+  int64_t                                 depth;
+  int64_t                                 max_depth;
+  uint64_t                                nb_enqueued;
+  uint64_t                                nb_overloads;
+  uint32_t                                overloaded;
+  metrics_histogram_cell_t                wait __attribute__ ((aligned (64)));   // microseconds
+} __attribute__ ((aligned (64))) itti_task_stats_t;
+
+typedef struct itti_handler_stats_s {
+  uint64_t                                count;
+  uint64_t                                sum_ns;
+  uint64_t                                max_ns;
+} itti_handler_stats_t;
+
+static struct {
+  itti_task_stats_t                      *tasks;
+  itti_handler_stats_t                   *handlers;     // [task_max][messages_id_max]
+  task_id_t                               task_max;
+  MessagesIds                             messages_id_max;
+  uint32_t                                high_watermark;
+  uint32_t                                low_watermark;
+} itti_stats = {.tasks = NULL, .handlers = NULL};
+
+// message being handled by the thread
+static __thread itti_handler_stats_t   *itti_stats_handler = NULL;
+static __thread uint64_t                itti_stats_handler_start_ns = 0;
+
+//------------------------------------------------------------------------------
+int itti_stats_init (const task_id_t task_max, const MessagesIds messages_id_max)
+{
+  void                                   *tasks = NULL;
+
+  if (posix_memalign (&tasks, 64, task_max * sizeof (itti_task_stats_t))) {
+    return RETURNerror;
+  }
+  itti_stats.tasks = tasks;
+  memset (itti_stats.tasks, 0, task_max * sizeof (itti_task_stats_t));
+  itti_stats.handlers = calloc ((size_t)task_max * messages_id_max, sizeof (itti_handler_stats_t));
+  if (!itti_stats.handlers) {
+    free (itti_stats.tasks);
+    itti_stats.tasks = NULL;
+    return RETURNerror;
+  }
+  itti_stats.task_max = task_max;
+  itti_stats.messages_id_max = messages_id_max;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Expected at init, before the tasks are started.
+ */
+void itti_stats_set_high_watermark (const uint32_t high_watermark)
+{
+  itti_stats.high_watermark = high_watermark;
+  itti_stats.low_watermark = high_watermark / 2;
+  if (high_watermark) {
+    OAILOG_INFO (LOG_ITTI, "Tasks are overloaded above %u queued messages, until they drain to %u\n", itti_stats.high_watermark, itti_stats.low_watermark);
+  }
+}
+
+//------------------------------------------------------------------------------
+uint64_t itti_stats_enqueue (const task_id_t task_id)
+{
+  itti_task_stats_t                      *stats = &itti_stats.tasks[task_id];
+  int64_t                                 depth = __atomic_add_fetch (&stats->depth, 1, __ATOMIC_RELAXED);
+  int64_t                                 max_depth = __atomic_load_n (&stats->max_depth, __ATOMIC_RELAXED);
+
+  while ((depth > max_depth) && !__atomic_compare_exchange_n (&stats->max_depth, &max_depth, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  __atomic_fetch_add (&stats->nb_enqueued, 1, __ATOMIC_RELAXED);
+  if ((itti_stats.high_watermark) && (depth >= itti_stats.high_watermark) && !__atomic_load_n (&stats->overloaded, __ATOMIC_RELAXED)) {
+    // only the sender raising the flag reports it
+    if (0 == __atomic_exchange_n (&stats->overloaded, 1, __ATOMIC_RELAXED)) {
+      __atomic_fetch_add (&stats->nb_overloads, 1, __ATOMIC_RELAXED);
+      OAILOG_WARNING (LOG_ITTI, "Task %s overloaded, %" PRId64 " messages queued\n", itti_get_task_name (task_id), depth);
+    }
+  }
+  return metrics_now_ns ();
+}
+
+//------------------------------------------------------------------------------
+void itti_stats_dequeue (const task_id_t task_id, const MessagesIds message_id, const uint64_t enqueue_ns)
+{
+  itti_task_stats_t                      *stats = &itti_stats.tasks[task_id];
+  metrics_histogram_cell_t               *wait = &stats->wait;
+  const uint64_t                          now_ns = metrics_now_ns ();
+  const uint64_t                          wait_us = (now_ns > enqueue_ns) ? (now_ns - enqueue_ns) / 1000 : 0;
+  const int                               bucket = metrics_histogram_bucket (wait_us);
+  int64_t                                 depth = __atomic_sub_fetch (&stats->depth, 1, __ATOMIC_RELAXED);
+
+  if ((depth <= itti_stats.low_watermark) && __atomic_load_n (&stats->overloaded, __ATOMIC_RELAXED)) {
+    __atomic_store_n (&stats->overloaded, 0, __ATOMIC_RELAXED);
+    OAILOG_INFO (LOG_ITTI, "Task %s no longer overloaded, %" PRId64 " messages queued\n", itti_get_task_name (task_id), depth);
+  }
+  // single writer, the atomic stores only keep the readers from seeing torn values
+  __atomic_store_n (&wait->buckets[bucket], wait->buckets[bucket] + 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&wait->sum, wait->sum + wait_us, __ATOMIC_RELAXED);
+  __atomic_store_n (&wait->count, wait->count + 1, __ATOMIC_RELAXED);
+
+  itti_stats_handler = &itti_stats.handlers[(size_t)task_id * itti_stats.messages_id_max + message_id];
+  itti_stats_handler_start_ns = now_ns;
+}
+
+//------------------------------------------------------------------------------
+void itti_stats_handler_end (void)
+{
+  itti_handler_stats_t                   *handler = itti_stats_handler;
+  uint64_t                                elapsed_ns = 0;
+
+  if (handler) {
+    elapsed_ns = metrics_now_ns () - itti_stats_handler_start_ns;
+    __atomic_store_n (&handler->sum_ns, handler->sum_ns + elapsed_ns, __ATOMIC_RELAXED);
+    __atomic_store_n (&handler->count, handler->count + 1, __ATOMIC_RELAXED);
+    if (elapsed_ns > handler->max_ns) {
+      __atomic_store_n (&handler->max_ns, elapsed_ns, __ATOMIC_RELAXED);
+    }
+    itti_stats_handler = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+int64_t itti_task_queue_depth (const task_id_t task_id)
+{
+  return __atomic_load_n (&itti_stats.tasks[task_id].depth, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+bool itti_task_overloaded (const task_id_t task_id)
+{
+  return 0 != __atomic_load_n (&itti_stats.tasks[task_id].overloaded, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+static void itti_stats_get_wait (const task_id_t task_id, metrics_histogram_report_t * const report)
+{
+  const metrics_histogram_cell_t         *wait = &itti_stats.tasks[task_id].wait;
+
+  report->count = __atomic_load_n (&wait->count, __ATOMIC_RELAXED);
+  report->sum = __atomic_load_n (&wait->sum, __ATOMIC_RELAXED);
+  for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+    report->buckets[b] = __atomic_load_n (&wait->buckets[b], __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline bool itti_stats_task_used (const task_id_t task_id)
+{
+  return 0 != __atomic_load_n (&itti_stats.tasks[task_id].nb_enqueued, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+void itti_stats_dump_text (bstring out)
+{
+  metrics_histogram_report_t             *report = NULL;
+  const itti_handler_stats_t             *handler = NULL;
+  uint64_t                                count = 0;
+
+  if (!itti_stats.tasks) {
+    return;
+  }
+  report = malloc (sizeof (metrics_histogram_report_t));
+  if (!report) {
+    return;
+  }
+  bformata (out, "Task                   |  depth |    max | enqueued |overloads| wait p50 us | p99 us | p99.9 us |\n");
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+    if (itti_stats_task_used (task_id)) {
+      itti_stats_get_wait (task_id, report);
+      bformata (out, "%-23s|%7" PRId64 " |%7" PRId64 " |%9" PRIu64 " |%8" PRIu64 " |%12" PRIu64 " |%7" PRIu64 " |%9" PRIu64 " |%s\n",
+          itti_get_task_name (task_id), itti_task_queue_depth (task_id), __atomic_load_n (&itti_stats.tasks[task_id].max_depth, __ATOMIC_RELAXED),
+          __atomic_load_n (&itti_stats.tasks[task_id].nb_enqueued, __ATOMIC_RELAXED),
+          __atomic_load_n (&itti_stats.tasks[task_id].nb_overloads, __ATOMIC_RELAXED),
+          metrics_histogram_percentile (report, 50.0), metrics_histogram_percentile (report, 99.0), metrics_histogram_percentile (report, 99.9),
+          itti_task_overloaded (task_id) ? " OVERLOADED" : "");
+    }
+  }
+  free (report);
+
+  bformata (out, "Task                   | Message                                  |    count |  mean us |   max us | total ms |\n");
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+    for (MessagesIds message_id = 0; message_id < itti_stats.messages_id_max; message_id++) {
+      handler = &itti_stats.handlers[(size_t)task_id * itti_stats.messages_id_max + message_id];
+      count = __atomic_load_n (&handler->count, __ATOMIC_RELAXED);
+      if (count) {
+        bformata (out, "%-23s| %-41s|%9" PRIu64 " |%9" PRIu64 " |%9" PRIu64 " |%9" PRIu64 " |\n",
+            itti_get_task_name (task_id), itti_get_message_name (message_id), count,
+            __atomic_load_n (&handler->sum_ns, __ATOMIC_RELAXED) / count / 1000,
+            __atomic_load_n (&handler->max_ns, __ATOMIC_RELAXED) / 1000,
+            __atomic_load_n (&handler->sum_ns, __ATOMIC_RELAXED) / 1000000);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_stats_display (void)
+{
+  bstring                                 out = bfromcstr ("");
+  struct bstrList                        *lines = NULL;
+
+  itti_stats_dump_text (out);
+  lines = bsplit (out, '\n');
+  if (lines) {
+    OAILOG_INFO (LOG_ITTI, "================================ ITTI STATISTICS ================================\n");
+    for (int i = 0; i < lines->qty; i++) {
+      if (blength (lines->entry[i])) {
+        OAILOG_INFO (LOG_ITTI, "%s\n", bdata (lines->entry[i]));
+      }
+    }
+    bstrListDestroy (lines);
+  }
+  bdestroy (out);
+}
+
+//------------------------------------------------------------------------------
+static void itti_stats_dump_task_family (bstring out, const char * const name, const char * const type, const char * const help,
+    const size_t offset)
+{
+  bformata (out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+    if (itti_stats_task_used (task_id)) {
+      bformata (out, "%s{task=\"%s\"} %" PRId64 "\n", name, itti_get_task_name (task_id),
+          __atomic_load_n ((int64_t *)((char *)&itti_stats.tasks[task_id] + offset), __ATOMIC_RELAXED));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Registered as a metrics collector, the per task and per message values are
+ * labelled so they are not metrics of their own. The queue wait times are
+ * exported as summaries.
+ */
+void itti_stats_dump_prometheus (bstring out)
+{
+  static const double                     quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  metrics_histogram_report_t             *report = NULL;
+  const itti_handler_stats_t             *handler = NULL;
+
+  if (!itti_stats.tasks) {
+    return;
+  }
+  itti_stats_dump_task_family (out, "itti_queue_depth", "gauge", "Messages in the queue of the task", offsetof (itti_task_stats_t, depth));
+  itti_stats_dump_task_family (out, "itti_queue_max_depth", "gauge", "Maximum number of messages in the queue of the task", offsetof (itti_task_stats_t, max_depth));
+  itti_stats_dump_task_family (out, "itti_messages_enqueued_total", "counter", "Messages sent to the task", offsetof (itti_task_stats_t, nb_enqueued));
+  itti_stats_dump_task_family (out, "itti_queue_overloads_total", "counter", "Times the queue of the task reached the high watermark", offsetof (itti_task_stats_t, nb_overloads));
+
+  report = malloc (sizeof (metrics_histogram_report_t));
+  if (report) {
+    bformata (out, "# HELP itti_queue_wait_seconds Time spent by the messages in the queue of the task\n# TYPE itti_queue_wait_seconds summary\n");
+    for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+      if (itti_stats_task_used (task_id)) {
+        itti_stats_get_wait (task_id, report);
+        for (int q = 0; q < sizeof (quantiles) / sizeof (quantiles[0]); q++) {
+          bformata (out, "itti_queue_wait_seconds{task=\"%s\",quantile=\"%g\"} %.6f\n", itti_get_task_name (task_id), quantiles[q],
+              (double)metrics_histogram_percentile (report, quantiles[q] * 100.0) / 1000000.0);
+        }
+        bformata (out, "itti_queue_wait_seconds_sum{task=\"%s\"} %.6f\nitti_queue_wait_seconds_count{task=\"%s\"} %" PRIu64 "\n",
+            itti_get_task_name (task_id), (double)report->sum / 1000000.0, itti_get_task_name (task_id), report->count);
+      }
+    }
+    free (report);
+  }
+
+  bformata (out, "# HELP itti_handler_seconds Time spent by the task handling the message\n# TYPE itti_handler_seconds summary\n");
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+    for (MessagesIds message_id = 0; message_id < itti_stats.messages_id_max; message_id++) {
+      handler = &itti_stats.handlers[(size_t)task_id * itti_stats.messages_id_max + message_id];
+      if (__atomic_load_n (&handler->count, __ATOMIC_RELAXED)) {
+        bformata (out, "itti_handler_seconds_sum{task=\"%s\",message=\"%s\"} %.9f\nitti_handler_seconds_count{task=\"%s\",message=\"%s\"} %" PRIu64 "\n",
+            itti_get_task_name (task_id), itti_get_message_name (message_id), (double)__atomic_load_n (&handler->sum_ns, __ATOMIC_RELAXED) / 1000000000.0,
+            itti_get_task_name (task_id), itti_get_message_name (message_id), __atomic_load_n (&handler->count, __ATOMIC_RELAXED));
+      }
+    }
+  }
+  bformata (out, "# HELP itti_handler_max_seconds Longest handling of the message by the task\n# TYPE itti_handler_max_seconds gauge\n");
+  for (task_id_t task_id = TASK_FIRST; task_id < itti_stats.task_max; task_id++) {
+    for (MessagesIds message_id = 0; message_id < itti_stats.messages_id_max; message_id++) {
+      handler = &itti_stats.handlers[(size_t)task_id * itti_stats.messages_id_max + message_id];
+      if (__atomic_load_n (&handler->count, __ATOMIC_RELAXED)) {
+        bformata (out, "itti_handler_max_seconds{task=\"%s\",message=\"%s\"} %.9f\n", itti_get_task_name (task_id), itti_get_message_name (message_id),
+            (double)__atomic_load_n (&handler->max_ns, __ATOMIC_RELAXED) / 1000000000.0);
+      }
+    }
+  }
+}
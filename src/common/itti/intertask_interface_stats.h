@@ -0,0 +1,73 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_stats.h
+  \brief Queue depth, queue wait time and handler time of the ITTI tasks.
+  \author
+  \company
+  \email
+*/
+#ifndef INTERTASK_INTERFACE_STATS_H_
+#define INTERTASK_INTERFACE_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+#include "intertask_interface_types.h"
+
+/*
+ * For every task: the current and maximum depth of its queue and the time
+ * spent by the messages in the queue. For every task and message id: the
+ * number of messages handled and the time spent handling them, that is the
+ * time between the reception of the message and the next call of the task to
+ * itti_receive_msg/itti_poll_msg.
+ *
+ * A task whose queue reaches the high watermark is overloaded until its queue
+ * drains to half of the watermark, the producers of new work (S1AP for the
+ * initial UE messages) may test it to shed load. A watermark of 0 disables the
+ * signal.
+ *
+ * The statistics are dumped in the log on SIGUSR2, served on GET /itti and
+ * exported with the metrics.
+ */
+
+int  itti_stats_init (const task_id_t task_max, const MessagesIds messages_id_max);
+
+void itti_stats_set_high_watermark (const uint32_t high_watermark);
+
+// Called by itti_send_msg_to_task, returns the enqueue timestamp to store along the message
+uint64_t itti_stats_enqueue (const task_id_t task_id);
+
+// Called by the reception of a message by task_id, closes the handling of the previous message
+void     itti_stats_dequeue (const task_id_t task_id, const MessagesIds message_id, const uint64_t enqueue_ns);
+
+// Called at the start of itti_receive_msg/itti_poll_msg, the previous message has been handled
+void     itti_stats_handler_end (void);
+
+int64_t  itti_task_queue_depth (const task_id_t task_id);
+bool     itti_task_overloaded (const task_id_t task_id);
+
+void itti_stats_display (void);
+void itti_stats_dump_text (bstring out);
+void itti_stats_dump_prometheus (bstring out);
+
+#endif /* INTERTASK_INTERFACE_STATS_H_ */
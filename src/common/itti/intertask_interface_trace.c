@@ -0,0 +1,409 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_trace.c
+  \brief End to end tracing of procedures across the ITTI tasks.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "log.h"
+#include "intertask_interface.h"
+#include "intertask_interface_trace.h"
+
+/*
+ * The traces in progress are kept in a table of ITTI_TRACE_MAX_ACTIVE slots.
+ * The state of a slot packs a generation (odd while the slot is in use) and
+ * the number of hops, so that adding a hop and closing the trace are single
+ * compare and swap operations. A trace id is the slot index plus the low bits
+ * of the generation, the ids of closed traces (messages still in flight, UE
+ * contexts) are thus detected and ignored. A hop is reserved by the compare
+ * and swap then written, its generation is published last so that closing the
+ * trace waits for the hops reserved but not yet written.
+ */
+#define ITTI_TRACE_SLOT_BITS            10
+#define ITTI_TRACE_GENERATION_MASK      ((1U << (32 - ITTI_TRACE_SLOT_BITS)) - 1)
+#define ITTI_TRACE_START_ATTEMPTS       8
+// tid of the queue tracks in the export, the handler tracks use the task id
+#define ITTI_TRACE_QUEUE_TRACK_OFFSET   1000
+
+typedef struct itti_trace_slot_s {
+  uint64_t                                state;        // generation << 32 | number of hops
+  uint32_t                                hop_generation[ITTI_TRACE_MAX_HOPS]; // generation of the trace that wrote the hop
+  itti_trace_t                            trace;
+} __attribute__ ((aligned (64))) itti_trace_slot_t;
+
+__thread itti_trace_id_t                itti_trace_current = ITTI_TRACE_ID_NONE;
+uint32_t                                itti_trace_sampling = 0;
+
+// message being handled by the thread, first hop of a started or resumed trace
+static __thread MessagesIds             itti_trace_last_message_id = MESSAGES_ID_MAX;
+static __thread task_id_t               itti_trace_last_origin_task_id = TASK_UNKNOWN;
+static __thread task_id_t               itti_trace_last_destination_task_id = TASK_UNKNOWN;
+static __thread uint32_t                itti_trace_sample_counter = 0;
+
+static struct {
+  itti_trace_slot_t                      *slots;
+  uint32_t                                cursor;
+  uint32_t                                nb_dropped;   // no free slot
+  uint32_t                                nb_timeouts;  // never completed
+
+  pthread_mutex_t                         mutex;        // completed traces
+  itti_trace_t                           *buffer;
+  uint32_t                                buffer_size;
+  uint64_t                                nb_completed;
+} itti_trace_desc = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_trace_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static inline itti_trace_slot_t *itti_trace_slot (const itti_trace_id_t trace_id)
+{
+  if ((ITTI_TRACE_ID_NONE == trace_id) || (NULL == itti_trace_desc.slots)) {
+    return NULL;
+  }
+  return &itti_trace_desc.slots[trace_id & (ITTI_TRACE_MAX_ACTIVE - 1)];
+}
+
+//------------------------------------------------------------------------------
+static inline bool itti_trace_state_match (const uint64_t state, const itti_trace_id_t trace_id)
+{
+  uint32_t                                generation = (uint32_t)(state >> 32);
+
+  return (generation & 1) && ((generation & ITTI_TRACE_GENERATION_MASK) == (trace_id >> ITTI_TRACE_SLOT_BITS));
+}
+
+//------------------------------------------------------------------------------
+int itti_trace_init (const uint32_t sampling, const uint32_t buffer_size)
+{
+  if (0 == sampling) {
+    return RETURNok;
+  }
+  itti_trace_desc.slots = calloc (ITTI_TRACE_MAX_ACTIVE, sizeof (itti_trace_slot_t));
+  itti_trace_desc.buffer_size = (buffer_size) ? buffer_size : ITTI_TRACE_DEFAULT_BUFFER_SIZE;
+  itti_trace_desc.buffer = calloc (itti_trace_desc.buffer_size, sizeof (itti_trace_t));
+  if ((NULL == itti_trace_desc.slots) || (NULL == itti_trace_desc.buffer)) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to allocate the procedure traces\n");
+    free (itti_trace_desc.slots);
+    free (itti_trace_desc.buffer);
+    itti_trace_desc.slots = NULL;
+    itti_trace_desc.buffer = NULL;
+    return RETURNerror;
+  }
+  itti_trace_sampling = sampling;
+  OAILOG_INFO (LOG_ITTI, "Tracing 1 procedure out of %u, %u completed traces kept\n", sampling, itti_trace_desc.buffer_size);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static uint16_t itti_trace_add_hop (const itti_trace_id_t trace_id, const MessagesIds message_id,
+                                    const task_id_t origin_task_id, const task_id_t destination_task_id,
+                                    const uint64_t enqueue_ns, const uint64_t dequeue_ns)
+{
+  itti_trace_slot_t                      *slot = itti_trace_slot (trace_id);
+  itti_trace_hop_t                       *hop = NULL;
+  uint64_t                                state = 0;
+
+  if (NULL == slot) {
+    return ITTI_TRACE_MAX_HOPS;
+  }
+  state = __atomic_load_n (&slot->state, __ATOMIC_ACQUIRE);
+  do {
+    if ((!itti_trace_state_match (state, trace_id)) || ((uint32_t)state >= ITTI_TRACE_MAX_HOPS)) {
+      return ITTI_TRACE_MAX_HOPS;
+    }
+  } while (!__atomic_compare_exchange_n (&slot->state, &state, state + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  hop = &slot->trace.hops[(uint32_t)state];
+  hop->message_id = message_id;
+  hop->origin_task_id = origin_task_id;
+  hop->destination_task_id = destination_task_id;
+  hop->enqueue_ns = enqueue_ns;
+  hop->dequeue_ns = dequeue_ns;
+  __atomic_store_n (&slot->hop_generation[(uint32_t)state], (uint32_t)(state >> 32), __ATOMIC_RELEASE);
+  return (uint16_t)(uint32_t)state;
+}
+
+//------------------------------------------------------------------------------
+itti_trace_id_t itti_trace_start (const char * const procedure, const uint64_t key)
+{
+  itti_trace_slot_t                      *slot = NULL;
+  uint64_t                                now = 0;
+  uint64_t                                state = 0;
+  uint32_t                                generation = 0;
+  uint32_t                                index = 0;
+  itti_trace_id_t                         trace_id = ITTI_TRACE_ID_NONE;
+
+  if ((0 == itti_trace_sampling) || (++itti_trace_sample_counter % itti_trace_sampling)) {
+    return ITTI_TRACE_ID_NONE;
+  }
+  now = itti_trace_now_ns ();
+  for (int i = 0; i < ITTI_TRACE_START_ATTEMPTS; i++) {
+    index = __atomic_fetch_add (&itti_trace_desc.cursor, 1, __ATOMIC_RELAXED) & (ITTI_TRACE_MAX_ACTIVE - 1);
+    slot = &itti_trace_desc.slots[index];
+    state = __atomic_load_n (&slot->state, __ATOMIC_ACQUIRE);
+    generation = (uint32_t)(state >> 32);
+    if (generation & 1) {
+      if (now - slot->trace.start_ns < ITTI_TRACE_TIMEOUT_NS) {
+        continue;
+      }
+      // the procedure was never completed (aborted, UE gone), the slot is reused
+      generation += 2;
+    } else {
+      generation += 1;
+    }
+    if (__atomic_compare_exchange_n (&slot->state, &state, (uint64_t)generation << 32, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      if (generation - (uint32_t)(state >> 32) == 2) {
+        __atomic_fetch_add (&itti_trace_desc.nb_timeouts, 1, __ATOMIC_RELAXED);
+      }
+      trace_id = ((generation & ITTI_TRACE_GENERATION_MASK) << ITTI_TRACE_SLOT_BITS) | index;
+      slot->trace.id = trace_id;
+      slot->trace.procedure = procedure;
+      slot->trace.key = key;
+      slot->trace.start_ns = now;
+      slot->trace.end_ns = 0;
+      itti_trace_current = trace_id;
+      itti_trace_add_hop (trace_id, itti_trace_last_message_id, itti_trace_last_origin_task_id, itti_trace_last_destination_task_id, 0, now);
+      return trace_id;
+    }
+  }
+  __atomic_fetch_add (&itti_trace_desc.nb_dropped, 1, __ATOMIC_RELAXED);
+  return ITTI_TRACE_ID_NONE;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_set_procedure (const itti_trace_id_t trace_id, const char * const procedure, const uint64_t key)
+{
+  itti_trace_slot_t                      *slot = itti_trace_slot (trace_id);
+
+  if ((slot) && (itti_trace_state_match (__atomic_load_n (&slot->state, __ATOMIC_ACQUIRE), trace_id))) {
+    slot->trace.procedure = procedure;
+    slot->trace.key = key;
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_resume (const itti_trace_id_t trace_id)
+{
+  if (ITTI_TRACE_ID_NONE == trace_id) {
+    return;
+  }
+  if (ITTI_TRACE_MAX_HOPS > itti_trace_add_hop (trace_id, itti_trace_last_message_id, itti_trace_last_origin_task_id,
+                                                itti_trace_last_destination_task_id, 0, itti_trace_now_ns ())) {
+    itti_trace_current = trace_id;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void itti_trace_close (const itti_trace_id_t trace_id, const bool keep)
+{
+  itti_trace_slot_t                      *slot = itti_trace_slot (trace_id);
+  itti_trace_t                           *trace = NULL;
+  uint64_t                                state = 0;
+  uint32_t                                nb_hops = 0;
+
+  if (NULL == slot) {
+    return;
+  }
+  if (keep) {
+    trace = malloc (sizeof (itti_trace_t));
+    if (NULL == trace) {
+      return;
+    }
+  }
+  state = __atomic_load_n (&slot->state, __ATOMIC_ACQUIRE);
+  do {
+    if (!itti_trace_state_match (state, trace_id)) {
+      free (trace);
+      return;
+    }
+    nb_hops = (uint32_t)state;
+    for (uint32_t h = 0; h < nb_hops; h++) {
+      // reserved by another thread which is writing it
+      while (__atomic_load_n (&slot->hop_generation[h], __ATOMIC_ACQUIRE) != (uint32_t)(state >> 32)) {
+        sched_yield ();
+      }
+    }
+    if (trace) {
+      // copied before the slot is released, a hop added meanwhile makes the swap fail
+      memcpy (trace, &slot->trace, offsetof (itti_trace_t, hops) + nb_hops * sizeof (itti_trace_hop_t));
+    }
+  } while (!__atomic_compare_exchange_n (&slot->state, &state, (state & ~0xFFFFFFFFULL) + (1ULL << 32), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  if (itti_trace_current == trace_id) {
+    itti_trace_current = ITTI_TRACE_ID_NONE;
+  }
+  if (trace) {
+    trace->nb_hops = nb_hops;
+    trace->end_ns = itti_trace_now_ns ();
+    pthread_mutex_lock (&itti_trace_desc.mutex);
+    memcpy (&itti_trace_desc.buffer[itti_trace_desc.nb_completed % itti_trace_desc.buffer_size], trace,
+        offsetof (itti_trace_t, hops) + nb_hops * sizeof (itti_trace_hop_t));
+    itti_trace_desc.nb_completed++;
+    pthread_mutex_unlock (&itti_trace_desc.mutex);
+    free (trace);
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_end (const itti_trace_id_t trace_id)
+{
+  itti_trace_close (trace_id, true);
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_abort (const itti_trace_id_t trace_id)
+{
+  itti_trace_close (trace_id, false);
+}
+
+//------------------------------------------------------------------------------
+uint16_t itti_trace_enqueue (const itti_trace_id_t trace_id, const MessagesIds message_id,
+                             const task_id_t origin_task_id, const task_id_t destination_task_id)
+{
+  return itti_trace_add_hop (trace_id, message_id, origin_task_id, destination_task_id, itti_trace_now_ns (), 0);
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_dequeue (const task_id_t task_id, const MessageDef * const message)
+{
+  itti_trace_slot_t                      *slot = NULL;
+  uint16_t                                hop = 0;
+
+  itti_trace_last_destination_task_id = task_id;
+  if (NULL == message) {
+    itti_trace_current = ITTI_TRACE_ID_NONE;
+    itti_trace_last_message_id = MESSAGES_ID_MAX;
+    itti_trace_last_origin_task_id = TASK_UNKNOWN;
+    return;
+  }
+  itti_trace_current = message->ittiMsgHeader.trace_id;
+  itti_trace_last_message_id = message->ittiMsgHeader.messageId;
+  itti_trace_last_origin_task_id = message->ittiMsgHeader.originTaskId;
+  if ((slot = itti_trace_slot (itti_trace_current))) {
+    hop = message->ittiMsgHeader.trace_hop;
+    if ((itti_trace_state_match (__atomic_load_n (&slot->state, __ATOMIC_ACQUIRE), itti_trace_current)) && (hop < ITTI_TRACE_MAX_HOPS)) {
+      slot->trace.hops[hop].dequeue_ns = itti_trace_now_ns ();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static const char *itti_trace_message_name (const MessagesIds message_id)
+{
+  return (MESSAGES_ID_MAX > message_id) ? itti_get_message_name (message_id) : "EVENT";
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The handling of a message by a task is shown up to the last message this
+ * task sent in the trace before it handled the next one.
+ */
+static uint64_t itti_trace_handler_end (const itti_trace_t * const trace, const uint32_t h)
+{
+  const itti_trace_hop_t                 *hop = &trace->hops[h];
+  uint64_t                                end = hop->dequeue_ns;
+
+  for (uint32_t i = h + 1; i < trace->nb_hops; i++) {
+    if (trace->hops[i].destination_task_id == hop->destination_task_id) {
+      if ((trace->hops[i].dequeue_ns) && (trace->hops[i].dequeue_ns > hop->dequeue_ns)) {
+        break;
+      }
+    }
+    if ((trace->hops[i].origin_task_id == hop->destination_task_id) && (trace->hops[i].enqueue_ns > end)) {
+      end = trace->hops[i].enqueue_ns;
+    }
+  }
+  return end;
+}
+
+//------------------------------------------------------------------------------
+static void itti_trace_dump_trace_json (bstring out, const itti_trace_t * const trace)
+{
+  const itti_trace_hop_t                 *hop = NULL;
+
+  bformata (out, ",\n{\"name\":\"%s\",\"cat\":\"procedure\",\"ph\":\"b\",\"id\":%" PRIu32 ",\"pid\":1,\"tid\":0,\"ts\":%.3f,"
+      "\"args\":{\"ue\":%" PRIu64 ",\"hops\":%" PRIu32 "}}",
+      trace->procedure, trace->id, trace->start_ns / 1000.0, trace->key, trace->nb_hops);
+  for (uint32_t h = 0; h < trace->nb_hops; h++) {
+    hop = &trace->hops[h];
+    if ((hop->enqueue_ns) && (hop->dequeue_ns)) {
+      bformata (out, ",\n{\"name\":\"%s\",\"cat\":\"queue\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+          "\"args\":{\"trace\":%" PRIu32 ",\"from\":\"%s\"}}",
+          itti_trace_message_name (hop->message_id), ITTI_TRACE_QUEUE_TRACK_OFFSET + (int)hop->destination_task_id,
+          hop->enqueue_ns / 1000.0, (hop->dequeue_ns - hop->enqueue_ns) / 1000.0, trace->id, itti_get_task_name (hop->origin_task_id));
+    }
+    if (hop->dequeue_ns) {
+      bformata (out, ",\n{\"name\":\"%s\",\"cat\":\"handler\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+          "\"args\":{\"trace\":%" PRIu32 ",\"from\":\"%s\",\"resumed\":%s}}",
+          itti_trace_message_name (hop->message_id), (int)hop->destination_task_id, hop->dequeue_ns / 1000.0,
+          (itti_trace_handler_end (trace, h) - hop->dequeue_ns) / 1000.0, trace->id, itti_get_task_name (hop->origin_task_id),
+          (hop->enqueue_ns) ? "false" : "true");
+    }
+  }
+  bformata (out, ",\n{\"name\":\"%s\",\"cat\":\"procedure\",\"ph\":\"e\",\"id\":%" PRIu32 ",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+      trace->procedure, trace->id, trace->end_ns / 1000.0);
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_dump_json (bstring out)
+{
+  uint64_t                                first = 0;
+
+  bcatcstr (out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bformata (out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"procedures\"}}");
+  for (int task_id = TASK_FIRST; task_id < TASK_MAX; task_id++) {
+    bformata (out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        task_id, itti_get_task_name ((task_id_t)task_id));
+    bformata (out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s queue\"}}",
+        ITTI_TRACE_QUEUE_TRACK_OFFSET + task_id, itti_get_task_name ((task_id_t)task_id));
+  }
+  if (itti_trace_desc.buffer) {
+    pthread_mutex_lock (&itti_trace_desc.mutex);
+    first = (itti_trace_desc.nb_completed > itti_trace_desc.buffer_size) ? itti_trace_desc.nb_completed - itti_trace_desc.buffer_size : 0;
+    for (uint64_t i = first; i < itti_trace_desc.nb_completed; i++) {
+      itti_trace_dump_trace_json (out, &itti_trace_desc.buffer[i % itti_trace_desc.buffer_size]);
+    }
+    bformata (out, "\n],\"otherData\":{\"completed\":%" PRIu64 ",\"dropped\":%" PRIu32 ",\"timeouts\":%" PRIu32 "}}\n",
+        itti_trace_desc.nb_completed, itti_trace_desc.nb_dropped, itti_trace_desc.nb_timeouts);
+    pthread_mutex_unlock (&itti_trace_desc.mutex);
+  } else {
+    bcatcstr (out, "\n]}\n");
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_trace.h
+  \brief End to end tracing of procedures across the ITTI tasks.
+  \author
+  \company
+  \email
+*/
+#ifndef INTERTASK_INTERFACE_TRACE_H_
+#define INTERTASK_INTERFACE_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+#include "intertask_interface_types.h"
+
+/*
+ * A trace follows one procedure (attach, TAU, ...) of one UE. It is started by
+ * the task receiving the first message of the procedure and becomes the
+ * current trace of this thread. Every message allocated by a thread inherits
+ * its current trace, and every traced message records a hop (time of enqueue
+ * and of dequeue) in the trace. The receiver of a traced message takes its
+ * trace as current trace, so the trace follows the chain of messages without
+ * change to the tasks.
+ *
+ * Messages coming from outside ITTI (S1AP uplink, S6A answers, S11
+ * responses) are not traced: the task handling them resumes the trace it kept
+ * in the UE context. Completed traces are kept in a ring buffer, exported as
+ * Chrome trace events (chrome://tracing, Perfetto).
+ *
+ * Only one procedure out of sampling is traced, with 0 tracing is disabled
+ * and costs a test per message.
+ */
+#define ITTI_TRACE_MAX_HOPS             64
+#define ITTI_TRACE_MAX_ACTIVE           1024      // traces in progress, power of 2
+#define ITTI_TRACE_TIMEOUT_NS           (30ULL * 1000000000ULL)
+#define ITTI_TRACE_DEFAULT_BUFFER_SIZE  1024      // completed traces kept
+
+typedef struct itti_trace_hop_s {
+  MessagesIds                             message_id;
+  task_id_t                               origin_task_id;
+  task_id_t                               destination_task_id;
+  uint64_t                                enqueue_ns;   // 0 if the trace was resumed by the destination task
+  uint64_t                                dequeue_ns;
+} itti_trace_hop_t;
+
+typedef struct itti_trace_s {
+  itti_trace_id_t                         id;
+  const char                             *procedure;    // static string
+  uint64_t                                key;          // UE identifier, display only
+  uint64_t                                start_ns;
+  uint64_t                                end_ns;
+  uint32_t                                nb_hops;
+  itti_trace_hop_t                        hops[ITTI_TRACE_MAX_HOPS];
+} itti_trace_t;
+
+// Trace of the messages allocated by the calling thread
+extern __thread itti_trace_id_t         itti_trace_current;
+extern uint32_t                         itti_trace_sampling;
+
+int  itti_trace_init (const uint32_t sampling, const uint32_t buffer_size);
+
+/*
+ * Starts (if sampled) the trace of a procedure and makes it the current trace
+ * of the thread, the message being handled is its first hop.
+ */
+itti_trace_id_t itti_trace_start (const char * const procedure, const uint64_t key);
+
+// Names the procedure once it is known (the trace of an initial UE message becomes an attach, ...) and the UE
+void itti_trace_set_procedure (const itti_trace_id_t trace_id, const char * const procedure, const uint64_t key);
+
+// Makes trace_id the current trace of the thread, records the message being handled as a hop
+void itti_trace_resume (const itti_trace_id_t trace_id);
+
+// Completes the trace, the ids of a completed or aborted trace are ignored
+void itti_trace_end (const itti_trace_id_t trace_id);
+void itti_trace_abort (const itti_trace_id_t trace_id);
+
+// Lets the callers skip the lookup of the trace to resume
+static inline bool itti_trace_enabled (void)
+{
+  return 0 != itti_trace_sampling;
+}
+
+// Called by itti_send_msg_to_task and by the reception of a message by task_id (NULL if none)
+uint16_t itti_trace_enqueue (const itti_trace_id_t trace_id, const MessagesIds message_id,
+                             const task_id_t origin_task_id, const task_id_t destination_task_id);
+void     itti_trace_dequeue (const task_id_t task_id, const MessageDef * const message);
+
+// Completed traces in the Chrome trace event format
+void itti_trace_dump_json (bstring out);
+
+#endif /* INTERTASK_INTERFACE_TRACE_H_ */
@@ -117,6 +117,10 @@ typedef union msg_s {
 
 typedef uint16_t MessageHeaderSize;
 
+/* Identifier of a procedure trace (see intertask_interface_trace.h) */
+typedef uint32_t itti_trace_id_t;
+#define ITTI_TRACE_ID_NONE  ((itti_trace_id_t)0)
+
 typedef struct itti_lte_time_s {
   struct timeval time;
 } itti_lte_time_t;
@@ -134,6 +138,9 @@ typedef struct MessageHeader_s {
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
   itti_lte_time_t lte_time;       /**< Reference LTE time */
+
+  itti_trace_id_t trace_id;       /**< Procedure trace of the message, ITTI_TRACE_ID_NONE if not traced */
+  uint16_t        trace_hop;      /**< Index of the message in the hops of its trace */
 } MessageHeader;
 
 /** @struct MessageDef
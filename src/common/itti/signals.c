@@ -42,6 +42,7 @@
 #include <errno.h>
 
 #include "intertask_interface.h"
+#include "intertask_interface_stats.h"
 #include "timer.h"
 #include "backtrace.h"
 #include "assertions.h"
@@ -62,6 +63,14 @@
 #endif
 
 static sigset_t                         set;
+static int                            (*signal_reload_handler) (void) = NULL;
+
+void
+signal_set_reload_handler (
+  int (*reload_handler) (void))
+{
+  signal_reload_handler = reload_handler;
+}
 
 int
 signal_mask (
@@ -75,9 +84,11 @@ signal_mask (
   sigemptyset (&set);
   sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
+  sigaddset (&set, SIGUSR2);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
   sigaddset (&set, SIGINT);
+  sigaddset (&set, SIGHUP);
 
   if (sigprocmask (SIG_BLOCK, &set, NULL) < 0) {
     perror ("sigprocmask");
@@ -97,9 +108,11 @@ signal_handle (
   sigemptyset (&set);
   sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
+  sigaddset (&set, SIGUSR2);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
   sigaddset (&set, SIGINT);
+  sigaddset (&set, SIGHUP);
 
   if (sigprocmask (SIG_BLOCK, &set, NULL) < 0) {
     perror ("sigprocmask");
@@ -133,6 +146,17 @@ signal_handle (
       *end = 1;
       break;
 
+    case SIGUSR2:
+      itti_stats_display ();
+      break;
+
+    case SIGHUP:
+      SIG_DEBUG ("Received SIGHUP\n");
+      if (signal_reload_handler) {
+        signal_reload_handler ();
+      }
+      break;
+
     case SIGSEGV:              /* Fall through */
     case SIGABRT:
       SIG_DEBUG ("Received SIGABORT\n");
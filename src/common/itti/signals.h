@@ -34,4 +34,7 @@ int signal_mask(void);
 
 int signal_handle(int *end);
 
+/* Called by signal_handle() on SIGHUP, to reload the configuration */
+void signal_set_reload_handler(int (*reload_handler)(void));
+
 #endif /* SIGNALS_H_ */
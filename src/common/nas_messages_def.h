@@ -63,10 +63,14 @@ MESSAGE_DEF(NAS_RAB_RELEASE_REQ,                MESSAGE_PRIORITY_MED,   itti_nas
 /* NAS layer -> MME app messages */
 MESSAGE_DEF(NAS_AUTHENTICATION_PARAM_REQ,       MESSAGE_PRIORITY_MED,   itti_nas_auth_param_req_t,       nas_auth_param_req)
 MESSAGE_DEF(NAS_DETACH_REQ,       		MESSAGE_PRIORITY_MED,   itti_nas_detach_req_t,           	nas_detach_req)
+MESSAGE_DEF(NAS_UE_RECORD_RSP,                  MESSAGE_PRIORITY_MED,   itti_nas_ue_record_t,            nas_ue_record_rsp)
 
 /* MME app -> NAS layer messages */
 MESSAGE_DEF(NAS_PDN_CONNECTIVITY_RSP,           MESSAGE_PRIORITY_MED,   itti_nas_pdn_connectivity_rsp_t,   nas_pdn_connectivity_rsp)
 MESSAGE_DEF(NAS_PDN_CONNECTIVITY_FAIL,          MESSAGE_PRIORITY_MED,   itti_nas_pdn_connectivity_fail_t,  nas_pdn_connectivity_fail)
+MESSAGE_DEF(NAS_UE_RECORD_REQ,                  MESSAGE_PRIORITY_MED,   itti_nas_ue_record_t,            nas_ue_record_req)
+MESSAGE_DEF(NAS_UE_EVICT_IND,                   MESSAGE_PRIORITY_MED,   itti_nas_ue_evict_ind_t,         nas_ue_evict_ind)
+MESSAGE_DEF(NAS_UE_RESTORE_IND,                 MESSAGE_PRIORITY_MED,   itti_nas_ue_record_t,            nas_ue_restore_ind)
 
 // handover (Forwarding the MBR to NAS for handover processing)
 MESSAGE_DEF(NAS_HO_BEARER_MODIFICATION_RSP,     MESSAGE_PRIORITY_MED,   itti_nas_ho_bearer_modification_rsp_t,    nas_ho_bearer_modification_rsp)
@@ -56,6 +56,7 @@
 #define NAS_PDN_CONNECTIVITY_FAIL(mSGpTR)           (mSGpTR)->ittiMsg.nas_pdn_connectivity_fail
 #define NAS_INITIAL_UE_MESSAGE(mSGpTR)              (mSGpTR)->ittiMsg.nas_initial_ue_message
 #define NAS_CONNECTION_ESTABLISHMENT_CNF(mSGpTR)    (mSGpTR)->ittiMsg.nas_conn_est_cnf
+#define NAS_CONNECTION_RELEASE_IND(mSGpTR)          (mSGpTR)->ittiMsg.nas_conn_rel_ind
 
 #define NAS_BEARER_PARAM(mSGpTR)                    (mSGpTR)->ittiMsg.nas_bearer_param
 // Handover related signaling sent by MME_APP to NAS for handover processing after MBR
@@ -70,6 +71,10 @@
 #define NAS_AUTHENTICATION_PARAM_REQ(mSGpTR)        (mSGpTR)->ittiMsg.nas_auth_param_req
 #define NAS_DETACH_REQ(mSGpTR)                      (mSGpTR)->ittiMsg.nas_detach_req
 #define NAS_IMPLICIT_DETACH_UE_IND(mSGpTR)          (mSGpTR)->ittiMsg.nas_implicit_detach_ue_ind
+#define NAS_UE_RECORD_REQ(mSGpTR)                   (mSGpTR)->ittiMsg.nas_ue_record_req
+#define NAS_UE_RECORD_RSP(mSGpTR)                   (mSGpTR)->ittiMsg.nas_ue_record_rsp
+#define NAS_UE_EVICT_IND(mSGpTR)                    (mSGpTR)->ittiMsg.nas_ue_evict_ind
+#define NAS_UE_RESTORE_IND(mSGpTR)                  (mSGpTR)->ittiMsg.nas_ue_restore_ind
 #define NAS_DATA_LENGHT_MAX     256
 
 typedef enum pdn_conn_rsp_cause_e {
@@ -315,8 +320,9 @@ typedef struct itti_nas_conn_est_cnf_s {
   uint16_t                integrity_algorithm_capabilities;
 } itti_nas_conn_est_cnf_t;
 
+// sent by MME_APP when the UE enters ECM-IDLE
 typedef struct itti_nas_conn_rel_ind_s {
-
+  mme_ue_s1ap_id_t        ue_id;            /* UE lower layer identifier   */
 } itti_nas_conn_rel_ind_t;
 
 // handover related confirmation rejection message sent by NAS to MME_APP
@@ -432,7 +438,31 @@ typedef struct itti_nas_detach_req_s {
 typedef struct itti_nas_implicit_detach_ue_ind_s {
   /* UE identifier */
   mme_ue_s1ap_id_t ue_id;
+  /* sent for a UE in ECM-IDLE: ignored if the UE established a NAS signalling connection since */
+  bool             is_idle;
 } itti_nas_implicit_detach_ue_ind_t;
 
+// checkpoint record of a UE in ECM-IDLE: MME_APP fills its part and asks the NAS task owning the EMM context for the rest,
+// NAS_UE_RESTORE_IND gives a record back to NAS to rebuild the EMM context of an evicted UE
+struct mme_app_checkpoint_record_s;
+typedef struct itti_nas_ue_record_s {
+  /* UE identifier */
+  mme_ue_s1ap_id_t ue_id;
+  /* MME_APP record generation of the UE when requested, a stale response is dropped */
+  uint32_t         generation;
+  /* requested by the eviction of the UE (mme_app_eviction.c), else by its checkpoint */
+  bool             is_eviction;
+  /* EMM and ESM parts filled by NAS, false if the UE cannot be restored from a record */
+  bool             is_valid;
+  /* allocated by MME_APP, freed by MME_APP when handling NAS_UE_RECORD_RSP, by NAS when handling NAS_UE_RESTORE_IND */
+  struct mme_app_checkpoint_record_s *record;
+} itti_nas_ue_record_t;
+
+// MME_APP evicted the UE in ECM-IDLE, NAS releases its EMM and ESM contexts unless the UE is back
+typedef struct itti_nas_ue_evict_ind_s {
+  /* UE identifier */
+  mme_ue_s1ap_id_t ue_id;
+} itti_nas_ue_evict_ind_t;
+
 
 #endif /* FILE_NAS_MESSAGES_TYPES_SEEN */
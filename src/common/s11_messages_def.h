@@ -35,3 +35,5 @@ MESSAGE_DEF(S11_DELETE_SESSION_REQUEST,  MESSAGE_PRIORITY_MED, itti_s11_delete_s
 MESSAGE_DEF(S11_DELETE_SESSION_RESPONSE, MESSAGE_PRIORITY_MED, itti_s11_delete_session_response_t, s11_delete_session_response)
 MESSAGE_DEF(S11_RELEASE_ACCESS_BEARERS_REQUEST, MESSAGE_PRIORITY_MED, itti_s11_release_access_bearers_request_t, s11_release_access_bearers_request)
 MESSAGE_DEF(S11_RELEASE_ACCESS_BEARERS_RESPONSE, MESSAGE_PRIORITY_MED, itti_s11_release_access_bearers_response_t, s11_release_access_bearers_response)
+MESSAGE_DEF(S11_DOWNLINK_DATA_NOTIFICATION, MESSAGE_PRIORITY_MED, itti_s11_downlink_data_notification_t, s11_downlink_data_notification)
+MESSAGE_DEF(S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE, MESSAGE_PRIORITY_MED, itti_s11_downlink_data_notification_acknowledge_t, s11_downlink_data_notification_acknowledge)
@@ -39,6 +39,8 @@
 #define S11_DELETE_SESSION_RESPONSE(mSGpTR)        (mSGpTR)->ittiMsg.s11_delete_session_response
 #define S11_RELEASE_ACCESS_BEARERS_REQUEST(mSGpTR) (mSGpTR)->ittiMsg.s11_release_access_bearers_request
 #define S11_RELEASE_ACCESS_BEARERS_RESPONSE(mSGpTR) (mSGpTR)->ittiMsg.s11_release_access_bearers_response
+#define S11_DOWNLINK_DATA_NOTIFICATION(mSGpTR)     (mSGpTR)->ittiMsg.s11_downlink_data_notification
+#define S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE(mSGpTR) (mSGpTR)->ittiMsg.s11_downlink_data_notification_acknowledge
 
 //-----------------------------------------------------------------------------
 /** @struct itti_s11_create_session_request_t
@@ -934,4 +936,42 @@ typedef struct itti_s11_release_access_bearers_response_s {
   void       *trxn;
   uint32_t    peer_ip;
 } itti_s11_release_access_bearers_response_t;
+
+
+//-----------------------------------------------------------------------------
+/** @struct itti_s11_downlink_data_notification_t
+ *  @brief Downlink Data Notification
+ *
+ * The Downlink Data Notification message is sent on the S11 interface by the SGW to the MME as part of the S1 paging
+ * procedure, when downlink data arrives for a UE in ECM-IDLE state.
+ */
+typedef struct itti_s11_downlink_data_notification_s {
+  teid_t      teid;                   ///< S11 MME Tunnel Endpoint Identifier
+  ebi_t       eps_bearer_id;          ///< optional, bearer on which the downlink data arrived, 0 if absent
+  // Cause, ARP, Indication flags ///< optional
+  // Private Extension  ///< optional
+  /* GTPv2-C specific parameters */
+  void       *trxn;
+  uint32_t    peer_ip;
+} itti_s11_downlink_data_notification_t;
+
+
+//-----------------------------------------------------------------------------
+/** @struct itti_s11_downlink_data_notification_acknowledge_t
+ *  @brief Downlink Data Notification Acknowledge
+ *
+ * Possible Cause values are specified in Table 8.4-1. Message specific cause values are:
+ * - "Request accepted".
+ * - "Unable to page UE".
+ * - "Context not found".
+ */
+typedef struct itti_s11_downlink_data_notification_acknowledge_s {
+  teid_t      teid;                   ///< S11 SGW Tunnel Endpoint Identifier
+  SGWCause_t  cause;
+  // Data Notification Delay  ///< optional
+  // Private Extension  ///< optional
+  /* GTPv2-C specific parameters */
+  void       *trxn;
+  uint32_t    peer_ip;
+} itti_s11_downlink_data_notification_acknowledge_t;
 #endif /* FILE_S11_MESSAGES_TYPES_SEEN */
@@ -51,3 +51,5 @@ MESSAGE_DEF(S1AP_UE_CONTEXT_RELEASE_COMPLETE, MESSAGE_PRIORITY_MED, itti_s1ap_ue
 MESSAGE_DEF(S1AP_NAS_DL_DATA_REQ           ,  MESSAGE_PRIORITY_MED, itti_s1ap_nas_dl_data_req_t           ,  s1ap_nas_dl_data_req)
 MESSAGE_DEF(S1AP_ENB_INITIATED_RESET_REQ   ,  MESSAGE_PRIORITY_MED, itti_s1ap_enb_initiated_reset_req_t   ,  s1ap_enb_initiated_reset_req)
 MESSAGE_DEF(S1AP_ENB_INITIATED_RESET_ACK   ,  MESSAGE_PRIORITY_MED, itti_s1ap_enb_initiated_reset_ack_t   ,  s1ap_enb_initiated_reset_ack)
+MESSAGE_DEF(S1AP_UE_TAI_IND                ,  MESSAGE_PRIORITY_MED, itti_s1ap_ue_tai_ind_t                ,  s1ap_ue_tai_ind)
+MESSAGE_DEF(S1AP_PAGING_REQUEST           ,  MESSAGE_PRIORITY_MED, itti_s1ap_paging_request_t            ,  s1ap_paging_request)
@@ -37,6 +37,8 @@
 #define S1AP_NAS_DL_DATA_REQ(mSGpTR)        (mSGpTR)->ittiMsg.s1ap_nas_dl_data_req
 #define S1AP_ENB_INITIATED_RESET_REQ(mSGpTR) (mSGpTR)->ittiMsg.s1ap_enb_initiated_reset_req
 #define S1AP_ENB_INITIATED_RESET_ACK(mSGpTR) (mSGpTR)->ittiMsg.s1ap_enb_initiated_reset_ack
+#define S1AP_UE_TAI_IND(mSGpTR)             (mSGpTR)->ittiMsg.s1ap_ue_tai_ind
+#define S1AP_PAGING_REQUEST(mSGpTR)         (mSGpTR)->ittiMsg.s1ap_paging_request
 
 typedef struct itti_s1ap_initial_ue_message_s {
   mme_ue_s1ap_id_t     mme_ue_s1ap_id;
@@ -82,6 +84,12 @@ typedef struct itti_s1ap_ue_cap_ind_s {
   size_t            radio_capabilities_length;
 } itti_s1ap_ue_cap_ind_t;
 
+// TAI of an S1AP message of the UE that differs from the TAI of the previous one
+typedef struct itti_s1ap_ue_tai_ind_s {
+  mme_ue_s1ap_id_t  mme_ue_s1ap_id;
+  tai_t             tai;
+} itti_s1ap_ue_tai_ind_t;
+
 #define S1AP_ITTI_UE_PER_DEREGISTER_MESSAGE 128
 typedef struct itti_s1ap_eNB_deregistered_ind_s {
   uint8_t          nb_ue_to_deregister;
@@ -154,6 +162,16 @@ typedef struct itti_s1ap_ue_context_release_complete_s {
   enb_ue_s1ap_id_t  enb_ue_s1ap_id:24;
 } itti_s1ap_ue_context_release_complete_t;
 
+// Paging of an idle UE, sent once to every eNB serving one of the TAIs
+typedef struct itti_s1ap_paging_request_s {
+  mme_ue_s1ap_id_t  mme_ue_s1ap_id;
+  mme_code_t        mme_code;           /* S-TMSI the UE is paged with      */
+  tmsi_t            m_tmsi;
+  uint16_t          ue_identity_index;  /* IMSI mod 1024, TS 36.304         */
+  uint8_t           nb_tais;
+  tai_t             tai[TAI_LIST_MAX_SIZE];
+} itti_s1ap_paging_request_t;
+
 
 // handover messaging
 typedef struct itti_s1ap_path_switch_req_s {
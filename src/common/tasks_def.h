@@ -39,6 +39,37 @@ TASK_DEF(TASK_FW_IP,    TASK_PRIORITY_MED, 200)
 TASK_DEF(TASK_MME_APP,  TASK_PRIORITY_MED, 200)
 /// NAS task
 TASK_DEF(TASK_NAS_MME,  TASK_PRIORITY_MED, 200)
+/// MME Applicative and NAS worker tasks, UE contexts are sharded on TASK_MME_APP/TASK_NAS_MME and these pairs
+TASK_DEF(TASK_MME_APP_1, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_2, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_3, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_4, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_5, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_6, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_7, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_8, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_9, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_10, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_11, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_12, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_13, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_14, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_MME_APP_15, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_1, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_2, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_3, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_4, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_5, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_6, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_7, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_8, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_9, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_10, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_11, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_12, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_13, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_14, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_NAS_MME_15, TASK_PRIORITY_MED, 200)
 /// S11 task
 TASK_DEF(TASK_S11,      TASK_PRIORITY_MED, 200)
 /// S1AP task
@@ -49,6 +80,22 @@ TASK_DEF(TASK_S6A,      TASK_PRIORITY_MED, 200)
 TASK_DEF(TASK_SCTP,     TASK_PRIORITY_MED, 200)
 /// Serving and Proxy Gateway Application task
 TASK_DEF(TASK_SPGW_APP, TASK_PRIORITY_MED, 200)
+/// Serving and Proxy Gateway Application worker tasks, sessions are sharded on TASK_SPGW_APP and these tasks by S11 TEID
+TASK_DEF(TASK_SPGW_APP_1, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_2, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_3, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_4, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_5, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_6, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_7, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_8, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_9, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_10, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_11, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_12, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_13, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_14, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_SPGW_APP_15, TASK_PRIORITY_MED, 200)
 /// UDP task
 TASK_DEF(TASK_UDP,      TASK_PRIORITY_MED, 200)
 //MESSAGE GENERATOR TASK
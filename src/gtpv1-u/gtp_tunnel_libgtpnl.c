@@ -24,6 +24,20 @@ static struct {
   bool                is_enabled;
 } gtp_nl;
 
+// tunnels are programmed by all the SPGW_APP shards, each thread has its own genetlink socket
+static __thread struct mnl_socket      *gtp_nl_thread_socket = NULL;
+
+static struct mnl_socket *libgtpnl_thread_socket (void)
+{
+  if (gtp_nl_thread_socket == NULL) {
+    gtp_nl_thread_socket = genl_socket_open();
+    if (gtp_nl_thread_socket == NULL) {
+      OAILOG_ERROR (LOG_GTPV1U, "Cannot create genetlink socket\n");
+    }
+  }
+  return gtp_nl_thread_socket;
+}
+
 
 #define GTP_DEVNAME "gtp0"
 
@@ -128,11 +142,15 @@ int libgtpnl_reset(void)
 int libgtpnl_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei)
 {
   struct gtp_tunnel *t;
+  struct mnl_socket *nl;
   int ret;
 
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
+  if ((nl = libgtpnl_thread_socket()) == NULL)
+    return RETURNerror;
+
   t = gtp_tunnel_alloc();
   if (t == NULL)
     return RETURNerror;
@@ -145,7 +163,7 @@ int libgtpnl_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, u
   gtp_tunnel_set_i_tei(t, i_tei);
   gtp_tunnel_set_o_tei(t, o_tei);
 
-  ret = gtp_add_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
+  ret = gtp_add_tunnel(gtp_nl.genl_id, nl, t);
   gtp_tunnel_free(t);
 
   return ret;
@@ -154,11 +172,15 @@ int libgtpnl_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, u
 int libgtpnl_del_tunnel(uint32_t i_tei, uint32_t o_tei)
 {
   struct gtp_tunnel *t;
+  struct mnl_socket *nl;
   int ret;
 
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
+  if ((nl = libgtpnl_thread_socket()) == NULL)
+    return RETURNerror;
+
   t = gtp_tunnel_alloc();
   if (t == NULL)
     return RETURNerror;
@@ -170,7 +192,7 @@ int libgtpnl_del_tunnel(uint32_t i_tei, uint32_t o_tei)
   gtp_tunnel_set_i_tei(t, i_tei);
   gtp_tunnel_set_o_tei(t, o_tei);
 
-  ret = gtp_del_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
+  ret = gtp_del_tunnel(gtp_nl.genl_id, nl, t);
   gtp_tunnel_free(t);
 
   return ret;
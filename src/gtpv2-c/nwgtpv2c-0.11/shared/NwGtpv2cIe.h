@@ -144,7 +144,7 @@
 #define NW_GTPV2C_IE_INSTANCE_TWO                                       (2)
 #define NW_GTPV2C_IE_INSTANCE_THREE                                     (3)
 #define NW_GTPV2C_IE_INSTANCE_FOUR                                      (4)
-#define NW_GTPV2C_IE_INSTANCE_MAXIMUM                                   (NW_GTPV2C_IE_INSTANCE_FOUR)
+#define NW_GTPV2C_IE_INSTANCE_MAXIMUM                                   (NW_GTPV2C_IE_INSTANCE_FOUR + 1) /**< Number of IE instances, sizes the IE tables */
 
 #define NW_GTPV2C_IE_PRESENCE_MANDATORY                                 (1)
 #define NW_GTPV2C_IE_PRESENCE_CONDITIONAL                               (2)
@@ -127,9 +127,21 @@ extern                                  "C" {
   static NwRcT                            nwGtpv2cTmrMinHeapInsert (
   NwGtpv2cTmrMinHeapT * thiz,
   NwGtpv2cTimeoutInfoT * pTimerEvent) {
-    int                                     holeIndex = thiz->currSize++;
+    int                                     holeIndex = 0;
+    NwGtpv2cTimeoutInfoT                  **pHeap = NULL;
 
-    NW_ASSERT (thiz->currSize < thiz->maxSize);
+    /*
+     * Answered transactions keep a timer until their retransmission window
+     * closes, the heap grows with the rate of the requests
+     */
+    if (thiz->currSize + 1 >= thiz->maxSize) {
+      pHeap = (NwGtpv2cTimeoutInfoT **) realloc (thiz->pHeap, 2 * thiz->maxSize * sizeof (NwGtpv2cTimeoutInfoT *));
+      NW_ASSERT (pHeap);
+      thiz->pHeap = pHeap;
+      thiz->maxSize *= 2;
+    }
+
+    holeIndex = thiz->currSize++;
 
     while ((holeIndex > 0) && NW_GTPV2C_TIMER_CMP_P (&(thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)])->tvTimeout, &(pTimerEvent->tvTimeout), >)) {
       thiz->pHeap[holeIndex] = thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)];
@@ -662,10 +674,10 @@ extern                                  "C" {
     pReqTrxn->pMsg = (NwGtpv2cMsgT *) pUlpRsp->hMsg;
     rc = nwGtpv2cTrxnStartDulpicateRequestWaitTimer (pReqTrxn);
 
-    // todo: assert tunnel exists!!
-//    if ((pUlpRsp->apiType & 0xFF000000) == NW_GTPV2C_ULP_API_FLAG_CREATE_LOCAL_TUNNEL) {
-//      rc = nwGtpv2cCreateLocalTunnel (thiz, pUlpRsp->apiInfo.triggeredRspInfo.teidLocal, pReqTrxn->peerIp, pUlpRsp->apiInfo.triggeredRspInfo.hUlpTunnel, &pUlpRsp->apiInfo.triggeredRspInfo.hTunnel);
-//    }
+    // a responder (SGW side) registers its tunnel so that the next requests of the peer are accepted
+    if ((pUlpRsp->apiType & 0xFF000000) == NW_GTPV2C_ULP_API_FLAG_CREATE_LOCAL_TUNNEL) {
+      rc = nwGtpv2cCreateLocalTunnel (thiz, pUlpRsp->apiInfo.triggeredRspInfo.teidLocal, pReqTrxn->peerIp, pUlpRsp->apiInfo.triggeredRspInfo.hUlpTunnel, &pUlpRsp->apiInfo.triggeredRspInfo.hTunnel);
+    }
 
     OAILOG_FUNC_RETURN( LOG_GTPV2C, rc);
   }
@@ -973,6 +985,8 @@ extern                                  "C" {
       NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_MODIFY_BEARER_RSP);
       NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_RELEASE_ACCESS_BEARERS_REQ);
       NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_RELEASE_ACCESS_BEARERS_RSP);
+      NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_DOWNLINK_DATA_NOTIFICATION);
+      NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_DOWNLINK_DATA_NOTIFICATION_ACK);
       /*
        * For S10 interface
        */
@@ -1132,6 +1146,11 @@ extern                                  "C" {
       OAILOG_FUNC_RETURN (LOG_GTPV2C, NW_OK);
     }
 
+    if (udpDataLen > NW_GTPV2C_MAX_MSG_LEN) {
+      OAILOG_WARNING (LOG_GTPV2C,  "Received message of %u bytes larger than %u bytes! Discarding.\n", udpDataLen, NW_GTPV2C_MAX_MSG_LEN);
+      OAILOG_FUNC_RETURN (LOG_GTPV2C, NW_OK);
+    }
+
     if ((ntohs (*((uint16_t *) ((uint8_t *) udpData + 2)))      /* Length */
          +((*((uint8_t *) (udpData)) & 0x08) ? 4 : 0) /* Extra Header length if TEID present */ ) > udpDataLen) {
       OAILOG_WARNING (LOG_GTPV2C,  "Received message with erroneous length of %u against expected length of %u! Discarding\n", udpDataLen, ntohs (*((uint16_t *) ((uint8_t *) udpData + 2))) + ((*((uint8_t *) (udpData)) & 0x08) ? 4 : 0));
@@ -1162,6 +1181,7 @@ extern                                  "C" {
     case NW_GTP_UPDATE_BEARER_REQ:
     case NW_GTP_DELETE_BEARER_REQ:
     case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
+    case NW_GTP_DOWNLINK_DATA_NOTIFICATION:
     case NW_GTP_CREATE_INDIRECT_DATA_FORWARDING_TUNNEL_REQ:
     case NW_GTP_DELETE_INDIRECT_DATA_FORWARDING_TUNNEL_REQ:{
         rc = nwGtpv2cHandleInitialReq (thiz, msgType, udpData, udpDataLen, peerPort, peerIp);
@@ -1179,6 +1199,7 @@ extern                                  "C" {
     case NW_GTP_UPDATE_BEARER_RSP:
     case NW_GTP_DELETE_BEARER_RSP:
     case NW_GTP_RELEASE_ACCESS_BEARERS_RSP:
+    case NW_GTP_DOWNLINK_DATA_NOTIFICATION_ACK:
     case NW_GTP_CREATE_INDIRECT_DATA_FORWARDING_TUNNEL_RSP:
     case NW_GTP_DELETE_INDIRECT_DATA_FORWARDING_TUNNEL_RSP: {
         rc = nwGtpv2cHandleTriggeredRsp (thiz, msgType, udpData, udpDataLen, peerPort, peerIp);
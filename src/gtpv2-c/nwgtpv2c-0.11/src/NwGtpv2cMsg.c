@@ -106,6 +106,13 @@ extern                                  "C" {
 
     NW_ASSERT (pStack);
 
+    // the header is 4 bytes longer when the TEID is present
+    if ((bufLen < NW_GTPV2C_MINIMUM_HEADER_SIZE) || (bufLen > NW_GTPV2C_MAX_MSG_LEN) ||
+        (((*pBuf) & 0x08) && (bufLen < NW_GTPV2C_MINIMUM_HEADER_SIZE + 4))) {
+      OAILOG_WARNING (LOG_GTPV2C, "Cannot create message from buffer of %u bytes!\n", bufLen);
+      return NW_FAILURE;
+    }
+
     if (gpGtpv2cMsgPool) {
       pMsg = gpGtpv2cMsgPool;
       gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
@@ -435,7 +442,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv1T                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTv1T *) thiz->pIe[type][instance];
@@ -460,7 +467,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv2T                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTv2T *) thiz->pIe[type][instance];
@@ -485,7 +492,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv4T                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTv4T *) thiz->pIe[type][instance];
@@ -510,7 +517,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv8T                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTv8T *) thiz->pIe[type][instance];
@@ -538,7 +545,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTlvT *) thiz->pIe[type][instance];
@@ -566,7 +573,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[type][instance]) {
       pIe = (NwGtpv2cIeTlvT *) thiz->pIe[type][instance];
@@ -593,7 +600,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[NW_GTPV2C_IE_CAUSE][instance]) {
       pIe = (NwGtpv2cIeTlvT *) thiz->pIe[NW_GTPV2C_IE_CAUSE][instance];
@@ -621,7 +628,7 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *thiz = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
-    NW_ASSERT (instance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+    NW_ASSERT (instance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
 
     if (thiz->isIeValid[NW_GTPV2C_IE_FTEID][instance]) {
       pIe = (NwGtpv2cIeTlvT *) thiz->pIe[NW_GTPV2C_IE_FTEID][instance];
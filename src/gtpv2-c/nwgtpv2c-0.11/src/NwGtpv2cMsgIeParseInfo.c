@@ -225,6 +225,35 @@ extern                                  "C" {
     {0, 0, 0}
   };
 
+  static
+  NwGtpv2cMsgIeInfoT                      downlinkDataNotificationIeInfoTbl[] = {
+    {NW_GTPV2C_IE_CAUSE, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, NULL},
+    {NW_GTPV2C_IE_EBI, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_IMSI, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_FTEID, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_INDICATION, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_PRIVATE_EXTENSION, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, NULL},
+
+    /*
+     * Do not add below this
+     */
+    {0, 0, 0}
+  };
+
+  static
+  NwGtpv2cMsgIeInfoT                      downlinkDataNotificationAckIeInfoTbl[] = {
+    {NW_GTPV2C_IE_CAUSE, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, NULL},
+    {NW_GTPV2C_IE_DELAY_VALUE, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_RECOVERY, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, NULL},
+    {NW_GTPV2C_IE_IMSI, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, NULL},
+    {NW_GTPV2C_IE_PRIVATE_EXTENSION, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, NULL},
+
+    /*
+     * Do not add below this
+     */
+    {0, 0, 0}
+  };
+
   static
   NwGtpv2cMsgIeInfoT                      releaseAccessBearersRspIeInfoTbl[] = {
     {NW_GTPV2C_IE_CAUSE, 0, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, NULL},
@@ -672,6 +701,18 @@ extern                                  "C" {
         }
         break;
 
+      case NW_GTP_DOWNLINK_DATA_NOTIFICATION:{
+          rc = nwGtpv2cMsgIeParseInfoUpdate (thiz, downlinkDataNotificationIeInfoTbl);
+          NW_ASSERT (NW_OK == rc);
+        }
+        break;
+
+      case NW_GTP_DOWNLINK_DATA_NOTIFICATION_ACK:{
+          rc = nwGtpv2cMsgIeParseInfoUpdate (thiz, downlinkDataNotificationAckIeInfoTbl);
+          NW_ASSERT (NW_OK == rc);
+        }
+        break;
+
       case NW_GTP_FORWARD_RELOCATION_REQ:{
           rc = nwGtpv2cMsgIeParseInfoUpdate (thiz, forwardRelocationReqIeInfoTbl);
           NW_ASSERT (NW_OK == rc);
@@ -778,7 +819,6 @@ extern                                  "C" {
       ieType = pIe->t;
       ieLength = ntohs (pIe->l);
       ieInstance = pIe->i & 0x0F;
-      NW_ASSERT (NW_GTPV2C_IE_INSTANCE_MAXIMUM >= ieInstance);
       OAILOG_DEBUG (LOG_GTPV2C,  "Received IE %u with instance %u of length %u in msg-type %u!\n", ieType, ieInstance, ieLength, thiz->msgType);
 
       if (pIeBufStart + 4 + ieLength > pIeBufEnd) {
@@ -789,6 +829,16 @@ extern                                  "C" {
         return NW_FAILURE;
       }
 
+      if (ieInstance >= NW_GTPV2C_IE_INSTANCE_MAXIMUM) {
+        /*
+         * No IE of the supported messages has such an instance, the
+         * instance comes from the peer and must not index the tables
+         */
+        OAILOG_WARNING (LOG_GTPV2C,  "Unexpected IE %u with instance %u of length %u received in msg %u!\n", ieType, ieInstance, ieLength, thiz->msgType);
+        pIeBufStart += (ieLength + 4);
+        continue;
+      }
+
       if ((thiz->ieParseInfo[ieType][ieInstance].iePresence)) {
         if ((ieLength < (thiz->ieParseInfo[ieType][ieInstance].ieMinLength))) {
           if (thiz->ieParseInfo[ieType][ieInstance].iePresence == NW_GTPV2C_IE_PRESENCE_OPTIONAL) {
@@ -129,7 +129,7 @@ extern                                  "C" {
     NW_ASSERT (thiz);
 
     if (thiz->ieParseInfo[ieType][ieInstance].iePresence == 0) {
-      NW_ASSERT (ieInstance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM);
+      NW_ASSERT (ieInstance < NW_GTPV2C_IE_INSTANCE_MAXIMUM);
       thiz->ieParseInfo[ieType][ieInstance].ieReadCallback = ieReadCallback;
       thiz->ieParseInfo[ieType][ieInstance].ieReadCallbackArg = ieReadCallbackArg;
       thiz->ieParseInfo[ieType][ieInstance].iePresence = iePresence;
@@ -197,6 +197,13 @@ extern                                  "C" {
         return NW_GTPV2C_MSG_MALFORMED;
       }
 
+      if (pIe->i >= NW_GTPV2C_IE_INSTANCE_MAXIMUM) {
+        // The spare bits and the instance come from the peer and must not index the tables
+        OAILOG_WARNING (LOG_GTPV2C,  "Unexpected IE %u with instance %u of length %u received in msg %u!\n", pIe->t, pIe->i, ieLength, thiz->msgType);
+        pIeStart += (ieLength + 4);
+        continue;
+      }
+
       if ((thiz->ieParseInfo[pIe->t][pIe->i].iePresence)) {
         thiz->pIe[pIe->t][pIe->i] = (uint8_t *) pIeStart;
         pMsg->pIe[pIe->t][pIe->i] = (uint8_t *) pIeStart;
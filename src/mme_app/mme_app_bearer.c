@@ -40,10 +40,14 @@
 #include "mme_app_defs.h"
 #include "mme_app_itti_messaging.h"
 #include "mme_config.h"
+#include "mme_config_snapshot.h"
 #include "emmData.h"
 #include "mme_app_statistics.h"
+#include "intertask_interface_trace.h"
+#include "mme_app_shard.h"
 #include "timer.h"
 #include "s1ap_mme.h"
+#include "nas_buffer.h"
 
 //----------------------------------------------------------------------------
 static bool mme_app_construct_guti(const plmn_t * const plmn_p, const as_stmsi_t * const s_tmsi_p,  guti_t * const guti_p);
@@ -96,13 +100,17 @@ mme_app_send_s11_create_session_req (
   MessageDef                             *message_p = NULL;
   itti_s11_create_session_request_t      *session_request_p = NULL;
   struct apn_configuration_s             *default_apn_p = NULL;
+  ue_subscription_t                      *subscription_p = NULL;
+  ue_context_t                           *other_context_p = NULL;
   int                                     rc = RETURNok;
 
   OAILOG_FUNC_IN (LOG_MME_APP);
   DevAssert (ue_context_pP );
   OAILOG_DEBUG (LOG_MME_APP, "Handling imsi " IMSI_64_FMT "\n", ue_context_pP->imsi);
+  subscription_p = ue_context_pP->subscription;
+  DevAssert (subscription_p);
 
-  if (ue_context_pP->sub_status != SS_SERVICE_GRANTED) {
+  if (subscription_p->sub_status != SS_SERVICE_GRANTED) {
     /*
      * HSS rejected the bearer creation or roaming is not allowed for this
      * UE. This result will trigger an ESM Failure message sent to UE.
@@ -140,22 +148,22 @@ mme_app_send_s11_create_session_req (
   /*
    * Copy the MSISDN
    */
-  memcpy (session_request_p->msisdn.digit, ue_context_pP->msisdn, ue_context_pP->msisdn_length);
-  session_request_p->msisdn.length = ue_context_pP->msisdn_length;
+  memcpy (session_request_p->msisdn.digit, subscription_p->msisdn, subscription_p->msisdn_length);
+  session_request_p->msisdn.length = subscription_p->msisdn_length;
   session_request_p->rat_type = RAT_EUTRAN;
   /*
    * Copy the subscribed ambr to the sgw create session request message
    */
-  memcpy (&session_request_p->ambr, &ue_context_pP->subscribed_ambr, sizeof (ambr_t));
+  memcpy (&session_request_p->ambr, &subscription_p->subscribed_ambr, sizeof (ambr_t));
 
-  if (ue_context_pP->apn_profile.nb_apns == 0) {
+  if (subscription_p->apn_profile.nb_apns == 0) {
     DevMessage ("No APN returned by the HSS");
   }
 
-  context_identifier = ue_context_pP->apn_profile.context_identifier;
+  context_identifier = subscription_p->apn_profile.context_identifier;
 
-  for (i = 0; i < ue_context_pP->apn_profile.nb_apns; i++) {
-    default_apn_p = &ue_context_pP->apn_profile.apn_configuration[i];
+  for (i = 0; i < subscription_p->apn_profile.nb_apns; i++) {
+    default_apn_p = &subscription_p->apn_profile.apn_configuration[i];
 
     /*
      * OK we got our default APN
@@ -186,14 +194,16 @@ mme_app_send_s11_create_session_req (
    * Asking for default bearer in initial UE message.
    * Use the address of ue_context as unique TEID: Need to find better here
    * and will generate unique id only for 32 bits platforms.
+   * The context is cache line aligned, its low bits carry the shard of the UE for S11 routing.
    */
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  session_request_p->sender_fteid_for_cp.teid = (teid_t) ue_context_pP;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  session_request_p->sender_fteid_for_cp.teid = mme_app_shard_tag ((teid_t)(uintptr_t) ue_context_pP, ue_context_pP->mme_ue_s1ap_id);
+  // a UE context restored from the checkpoint or an evicted UE may hold this TEID
+  while (((other_context_p = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, session_request_p->sender_fteid_for_cp.teid)) &&
+          (other_context_p != ue_context_pP)) || (mme_app_eviction_is_s11_teid_used (session_request_p->sender_fteid_for_cp.teid))) {
+    session_request_p->sender_fteid_for_cp.teid += 1 << MME_APP_SHARD_TAG_BITS;
+  }
   session_request_p->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
-  mme_config_read_lock (&mme_config);
   session_request_p->sender_fteid_for_cp.ipv4_address = mme_config.ipv4.s11;
-  mme_config_unlock (&mme_config);
   session_request_p->sender_fteid_for_cp.ipv4 = 1;
 
   //ue_context_pP->mme_s11_teid = session_request_p->sender_fteid_for_cp.teid;
@@ -234,12 +244,12 @@ mme_app_send_s11_create_session_req (
     }
   }
 
-  copy_protocol_configuration_options (&session_request_p->pco, &ue_context_pP->pending_pdn_connectivity_req_pco);
-  clear_protocol_configuration_options(&ue_context_pP->pending_pdn_connectivity_req_pco);
+  if (ue_context_pP->pending_pdn_connectivity_req) {
+    copy_protocol_configuration_options (&session_request_p->pco, &ue_context_pP->pending_pdn_connectivity_req->pco);
+    clear_protocol_configuration_options(&ue_context_pP->pending_pdn_connectivity_req->pco);
+  }
 
-  mme_config_read_lock (&mme_config);
   session_request_p->peer_ip = mme_config.ipv4.sgw_s11;
-  mme_config_unlock (&mme_config);
   session_request_p->serving_network.mcc[0] = ue_context_pP->e_utran_cgi.plmn.mcc_digit1;
   session_request_p->serving_network.mcc[1] = ue_context_pP->e_utran_cgi.plmn.mcc_digit2;
   session_request_p->serving_network.mcc[2] = ue_context_pP->e_utran_cgi.plmn.mcc_digit3;
@@ -249,6 +259,7 @@ mme_app_send_s11_create_session_req (
   session_request_p->selection_mode = MS_O_N_P_APN_S_V;
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0,
       "0 S11_CREATE_SESSION_REQUEST imsi " IMSI_64_FMT, ue_context_pP->imsi);
+  ue_context_pP->s11_csr_start_ns = metrics_now_ns ();
   rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
@@ -261,6 +272,7 @@ mme_app_handle_nas_pdn_connectivity_req (
   itti_nas_pdn_connectivity_req_t * const nas_pdn_connectivity_req_pP)
 {
   struct ue_context_s                    *ue_context_p = NULL;
+  pending_pdn_connectivity_req_t         *pending_p = NULL;
   imsi64_t                                imsi64 = INVALID_IMSI64;
   int                                     rc = RETURNok;
 
@@ -281,43 +293,48 @@ mme_app_handle_nas_pdn_connectivity_req (
    */
   ue_context_p->imsi_auth = IMSI_AUTHENTICATED;
   // Temp: save request, in near future merge wisely params in context
-  memset (ue_context_p->pending_pdn_connectivity_req_imsi, 0, 16);
+  pending_p = mme_app_get_pending_pdn_connectivity_req (ue_context_p);
+  if (!pending_p) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to allocate pending PDN connectivity request for imsi " IMSI_64_FMT "\n", imsi64);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  memset (pending_p->imsi, 0, 16);
   AssertFatal ((nas_pdn_connectivity_req_pP->imsi_length > 0)
                && (nas_pdn_connectivity_req_pP->imsi_length < 16), "BAD IMSI LENGTH %d", nas_pdn_connectivity_req_pP->imsi_length);
   AssertFatal ((nas_pdn_connectivity_req_pP->imsi_length > 0)
                && (nas_pdn_connectivity_req_pP->imsi_length < 16), "STOP ON IMSI LENGTH %d", nas_pdn_connectivity_req_pP->imsi_length);
-  memcpy (ue_context_p->pending_pdn_connectivity_req_imsi, nas_pdn_connectivity_req_pP->imsi, nas_pdn_connectivity_req_pP->imsi_length);
-  ue_context_p->pending_pdn_connectivity_req_imsi_length = nas_pdn_connectivity_req_pP->imsi_length;
+  memcpy (pending_p->imsi, nas_pdn_connectivity_req_pP->imsi, nas_pdn_connectivity_req_pP->imsi_length);
+  pending_p->imsi_length = nas_pdn_connectivity_req_pP->imsi_length;
 
   // copy
-  if (ue_context_p->pending_pdn_connectivity_req_apn) {
-    bdestroy (ue_context_p->pending_pdn_connectivity_req_apn);
+  if (pending_p->apn) {
+    bdestroy (pending_p->apn);
   }
-  ue_context_p->pending_pdn_connectivity_req_apn =  nas_pdn_connectivity_req_pP->apn;
+  pending_p->apn =  nas_pdn_connectivity_req_pP->apn;
   nas_pdn_connectivity_req_pP->apn = NULL;
 
   // copy
-  if (ue_context_p->pending_pdn_connectivity_req_pdn_addr) {
-    bdestroy (ue_context_p->pending_pdn_connectivity_req_pdn_addr);
+  if (pending_p->pdn_addr) {
+    bdestroy (pending_p->pdn_addr);
   }
-  ue_context_p->pending_pdn_connectivity_req_pdn_addr =  nas_pdn_connectivity_req_pP->pdn_addr;
+  pending_p->pdn_addr =  nas_pdn_connectivity_req_pP->pdn_addr;
   nas_pdn_connectivity_req_pP->pdn_addr = NULL;
 
-  ue_context_p->pending_pdn_connectivity_req_pti = nas_pdn_connectivity_req_pP->pti;
-  ue_context_p->pending_pdn_connectivity_req_ue_id = nas_pdn_connectivity_req_pP->ue_id;
-  copy_protocol_configuration_options (&ue_context_p->pending_pdn_connectivity_req_pco, &nas_pdn_connectivity_req_pP->pco);
+  pending_p->pti = nas_pdn_connectivity_req_pP->pti;
+  pending_p->ue_id = nas_pdn_connectivity_req_pP->ue_id;
+  copy_protocol_configuration_options (&pending_p->pco, &nas_pdn_connectivity_req_pP->pco);
   clear_protocol_configuration_options(&nas_pdn_connectivity_req_pP->pco);
 #define TEMPORARY_DEBUG 1
 #if TEMPORARY_DEBUG
-  bstring b = protocol_configuration_options_to_xml(&ue_context_p->pending_pdn_connectivity_req_pco);
+  bstring b = protocol_configuration_options_to_xml(&pending_p->pco);
   OAILOG_DEBUG (LOG_MME_APP, "PCO %s\n", bdata(b));
   bdestroy(b);
 #endif
 
-  memcpy (&ue_context_p->pending_pdn_connectivity_req_qos, &nas_pdn_connectivity_req_pP->qos, sizeof (network_qos_t));
-  ue_context_p->pending_pdn_connectivity_req_proc_data = nas_pdn_connectivity_req_pP->proc_data;
+  memcpy (&pending_p->qos, &nas_pdn_connectivity_req_pP->qos, sizeof (network_qos_t));
+  pending_p->proc_data = nas_pdn_connectivity_req_pP->proc_data;
   nas_pdn_connectivity_req_pP->proc_data = NULL;
-  ue_context_p->pending_pdn_connectivity_req_request_type = nas_pdn_connectivity_req_pP->request_type;
+  pending_p->request_type = nas_pdn_connectivity_req_pP->request_type;
   //if ((nas_pdn_connectivity_req_pP->apn.value == NULL) || (nas_pdn_connectivity_req_pP->apn.length == 0)) {
   /*
    * TODO: Get keys...
@@ -354,6 +371,19 @@ mme_app_handle_conn_est_cnf (
   if (ue_context_p == NULL) {
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "NAS_CONNECTION_ESTABLISHMENT_CNF Unknown ue %u", nas_conn_est_cnf_pP->ue_id);
     OAILOG_ERROR (LOG_MME_APP, "UE context doesn't exist for UE %06" PRIX32 "/dec%u\n", nas_conn_est_cnf_pP->ue_id, nas_conn_est_cnf_pP->ue_id);
+    nas_buffer_free ((bstring *)&nas_conn_est_cnf_pP->nas_msg);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  if (nas_conn_est_cnf_pP->nas_msg) {
+    // not a service request (attach accept, TAU accept), timed by NAS
+    ue_context_p->service_request_start_ns = 0;
+  }
+
+  bearer_id = ue_context_p->default_bearer_id;
+  current_bearer_p = (bearer_id < BEARERS_PER_UE) ? ue_context_p->eps_bearers[bearer_id] : NULL;
+  if (!current_bearer_p) {
+    OAILOG_ERROR (LOG_MME_APP, "No default bearer %u for UE id %d\n", bearer_id, ue_context_p->mme_ue_s1ap_id);
+    nas_buffer_free ((bstring *)&nas_conn_est_cnf_pP->nas_msg);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
 
@@ -374,8 +404,6 @@ mme_app_handle_conn_est_cnf (
             establishment_cnf_p->ue_radio_cap_length);
   }
 
-  bearer_id = ue_context_p->default_bearer_id;
-  current_bearer_p = &ue_context_p->eps_bearers[bearer_id];
   establishment_cnf_p->eps_bearer_id = bearer_id;
   establishment_cnf_p->bearer_s1u_sgw_fteid.interface_type = S1_U_SGW_GTP_U;
   establishment_cnf_p->bearer_s1u_sgw_fteid.teid = current_bearer_p->s_gw_teid;
@@ -397,8 +425,10 @@ mme_app_handle_conn_est_cnf (
   establishment_cnf_p->bearer_qos_pre_emp_vulnerability = current_bearer_p->pre_emp_vulnerability;
   establishment_cnf_p->bearer_qos_pre_emp_capability = current_bearer_p->pre_emp_capability;
 //#pragma message  "Check ue_context_p ambr"
-  establishment_cnf_p->ambr.br_ul = ue_context_p->subscribed_ambr.br_ul;
-  establishment_cnf_p->ambr.br_dl = ue_context_p->subscribed_ambr.br_dl;
+  if (ue_context_p->subscription) {
+    establishment_cnf_p->ambr.br_ul = ue_context_p->subscription->subscribed_ambr.br_ul;
+    establishment_cnf_p->ambr.br_dl = ue_context_p->subscription->subscribed_ambr.br_dl;
+  }
   establishment_cnf_p->security_capabilities_encryption_algorithms =
     nas_conn_est_cnf_pP->encryption_algorithm_capabilities;
   establishment_cnf_p->security_capabilities_integrity_algorithms =
@@ -430,7 +460,7 @@ mme_app_handle_conn_est_cnf (
    * or SERVICE REQUEST. Send UE context release command to eNB
    */
   if (timer_setup (ue_context_p->initial_context_setup_rsp_timer.sec, 0, 
-                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *) &(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->initial_context_setup_rsp_timer.id)) < 0) { 
+                mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *) &(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->initial_context_setup_rsp_timer.id)) < 0) { 
     OAILOG_ERROR (LOG_MME_APP, "Failed to start initial context setup response timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
     ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
   } else {
@@ -467,13 +497,18 @@ mme_app_handle_handover_cnf (
      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
 
+  bearer_id = ue_context_p->default_bearer_id;
+  current_bearer_p = (bearer_id < BEARERS_PER_UE) ? ue_context_p->eps_bearers[bearer_id] : NULL;
+  if (!current_bearer_p) {
+    OAILOG_ERROR (LOG_MME_APP, "No default bearer %u for UE id %d\n", bearer_id, ue_context_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+
   message_p = itti_alloc_new_message (TASK_MME_APP, MME_APP_HANDOVER_CNF);
   handover_cnf_p = &message_p->ittiMsg.mme_app_handover_cnf;
   memset (handover_cnf_p, 0, sizeof (itti_mme_app_handover_cnf_t));
   memcpy (&handover_cnf_p->nas_handover_cnf, nas_handover_cnf_pP, sizeof (itti_nas_handover_cnf_t));
 
-  bearer_id = ue_context_p->default_bearer_id;
-  current_bearer_p = &ue_context_p->eps_bearers[bearer_id];
   handover_cnf_p->eps_bearer_id = bearer_id;
   handover_cnf_p->bearer_s1u_sgw_fteid.interface_type = S1_U_SGW_GTP_U;
   handover_cnf_p->bearer_s1u_sgw_fteid.teid = current_bearer_p->s_gw_teid;
@@ -612,8 +647,27 @@ mme_app_handle_initial_ue_message (
     is_guti_valid = mme_app_construct_guti(&(initial_pP->tai.plmn),&(initial_pP->opt_s_tmsi),&guti);
     if (is_guti_valid)
     {
-      ue_nas_ctx = emm_data_context_get_by_guti (&_emm_data, &guti);
-      if (ue_nas_ctx) 
+      // an evicted UE is restored first, NAS may not have released its EMM context yet
+      if (!(ue_context_p = mme_app_eviction_restore_ue_by_guti (&guti))) {
+        ue_nas_ctx = emm_data_context_get_by_guti (&_emm_data, &guti);
+      }
+      if ((ue_nas_ctx) && (!mme_app_is_ue_id_in_current_shard (ue_nas_ctx->ue_id))) {
+        // The M-TMSI was not allocated with the current number of workers, the task owning the context handles the UE
+        OAILOG_DEBUG (LOG_MME_APP, "MME_APP_INITIAL_UE_MESSAGE S-TMSI %u of UE id " MME_UE_S1AP_ID_FMT " forwarded to its shard\n",
+            initial_pP->opt_s_tmsi.m_tmsi, ue_nas_ctx->ue_id);
+        message_p = itti_alloc_new_message (TASK_MME_APP, MME_APP_INITIAL_UE_MESSAGE);
+        MME_APP_INITIAL_UE_MESSAGE (message_p) = *initial_pP;
+        initial_pP->nas = NULL;
+        itti_send_msg_to_task (mme_app_task_of_ue_id (ue_nas_ctx->ue_id), INSTANCE_DEFAULT, message_p);
+        OAILOG_FUNC_OUT (LOG_MME_APP);
+      }
+      if (ue_context_p) {
+        initial_pP->mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
+        ue_context_p->enb_ue_s1ap_id = initial_pP->enb_ue_s1ap_id;
+        MME_APP_ENB_S1AP_ID_KEY(enb_s1ap_id_key, initial_pP->enb_id, initial_pP->enb_ue_s1ap_id);
+        mme_ue_context_update_coll_keys (&mme_app_desc.mme_ue_contexts, ue_context_p, enb_s1ap_id_key, ue_context_p->mme_ue_s1ap_id,
+                                         ue_context_p->imsi, ue_context_p->mme_s11_teid, &guti);
+      } else if (ue_nas_ctx) 
       {
         // Get the UE context using mme_ue_s1ap_id 
         ue_context_p =  mme_ue_context_exists_mme_ue_s1ap_id(&mme_app_desc.mme_ue_contexts,ue_nas_ctx->ue_id);
@@ -668,7 +722,7 @@ mme_app_handle_initial_ue_message (
       OAILOG_FUNC_OUT (LOG_MME_APP);
     }
     // Allocate new mme_ue_s1ap_id
-    ue_context_p->mme_ue_s1ap_id    = mme_app_ctx_get_new_ue_id ();
+    ue_context_p->mme_ue_s1ap_id    = mme_app_shard_new_ue_id ();
     if (ue_context_p->mme_ue_s1ap_id  == INVALID_MME_UE_S1AP_ID) {
       OAILOG_CRITICAL (LOG_MME_APP, "MME_APP_INITIAL_UE_MESSAGE. MME_UE_S1AP_ID allocation Failed.\n");
       mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p);
@@ -681,13 +735,24 @@ mme_app_handle_initial_ue_message (
   }
   ue_context_p->sctp_assoc_id_key = initial_pP->sctp_assoc_id;
   ue_context_p->e_utran_cgi = initial_pP->cgi;
+  ue_context_p->last_tai = initial_pP->tai;
   // Notify S1AP about the mapping between mme_ue_s1ap_id and sctp assoc id + enb_ue_s1ap_id 
   notify_s1ap_new_ue_mme_s1ap_id_association (ue_context_p);
+  // The UE answers the paging, if any
+  mme_app_paging_stop (ue_context_p);
   // Initialize timers to INVALID IDs
   ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
   ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
   ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
   ue_context_p->initial_context_setup_rsp_timer.sec = MME_APP_INITIAL_CONTEXT_SETUP_RSP_TIMER_VALUE;
+  // cleared by NAS_CONNECTION_ESTABLISHMENT_CNF unless the NAS message is a service request
+  ue_context_p->service_request_start_ns = metrics_now_ns ();
+  if (ue_context_p->trace_id != itti_trace_current) {
+    // the previous signalling connection was not released
+    itti_trace_abort (ue_context_p->trace_id);
+    ue_context_p->trace_id = itti_trace_current;
+    itti_trace_set_procedure (ue_context_p->trace_id, "initial_ue", ue_context_p->mme_ue_s1ap_id);
+  }
 
   message_p = itti_alloc_new_message (TASK_MME_APP, NAS_INITIAL_UE_MESSAGE);
   // do this because of same message types name but not same struct in different .h
@@ -704,7 +769,7 @@ mme_app_handle_initial_ue_message (
   message_p->ittiMsg.nas_initial_ue_message.nas.initial_nas_msg   =  initial_pP->nas;
   memcpy (&message_p->ittiMsg.nas_initial_ue_message.transparent, (const void*)&initial_pP->transparent, sizeof (message_p->ittiMsg.nas_initial_ue_message.transparent));
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_NAS_MME, NULL, 0, "0 NAS_INITIAL_UE_MESSAGE");
-  itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
@@ -735,7 +800,19 @@ mme_app_handle_initial_ue_message_check_duplicate (
 
     if (is_guti_valid)
     {
-      ue_nas_ctx = emm_data_context_get_by_guti (&_emm_data, &guti);
+      // an evicted UE has no S1 connection, NAS may not have released its EMM context yet
+      if (!mme_app_eviction_is_m_tmsi_used (guti.m_tmsi)) {
+        ue_nas_ctx = emm_data_context_get_by_guti (&_emm_data, &guti);
+      }
+      if ((ue_nas_ctx) && (!mme_app_is_ue_id_in_current_shard (ue_nas_ctx->ue_id))) {
+        OAILOG_DEBUG (LOG_MME_APP, "MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE S-TMSI %u of UE id " MME_UE_S1AP_ID_FMT " forwarded to its shard\n",
+            initial_check_duplicate_pP->opt_s_tmsi.m_tmsi, ue_nas_ctx->ue_id);
+        message_p = itti_alloc_new_message (TASK_MME_APP, MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE);
+        MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE (message_p) = *initial_check_duplicate_pP;
+        initial_check_duplicate_pP->nas = NULL;
+        itti_send_msg_to_task (mme_app_task_of_ue_id (ue_nas_ctx->ue_id), INSTANCE_DEFAULT, message_p);
+        OAILOG_FUNC_OUT (LOG_MME_APP);
+      }
       if (ue_nas_ctx)
       {
         // Get the UE context using mme_ue_s1ap_id
@@ -934,6 +1011,9 @@ mme_app_handle_create_sess_resp (
   }
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
     create_sess_resp_pP->teid, ue_context_p->imsi);
+  itti_trace_resume (ue_context_p->trace_id);
+  update_mme_app_stats_latency (MME_APP_LATENCY_S11_CSR, ue_context_p->s11_csr_start_ns);
+  ue_context_p->s11_csr_start_ns = 0;
 
   /* Whether SGW has created the session (IP address allocation, local GTP-U end point creation etc.) 
    * successfully or not , it is indicated by cause value in create session response message.
@@ -948,10 +1028,13 @@ mme_app_handle_create_sess_resp (
     message_p = itti_alloc_new_message (TASK_MME_APP, NAS_PDN_CONNECTIVITY_FAIL);
     itti_nas_pdn_connectivity_fail_t *nas_pdn_connectivity_fail = &message_p->ittiMsg.nas_pdn_connectivity_fail;
     memset ((void *)nas_pdn_connectivity_fail, 0, sizeof (itti_nas_pdn_connectivity_fail_t));
-    nas_pdn_connectivity_fail->pti = ue_context_p->pending_pdn_connectivity_req_pti;  
-    nas_pdn_connectivity_fail->ue_id = ue_context_p->pending_pdn_connectivity_req_ue_id; 
+    if (ue_context_p->pending_pdn_connectivity_req) {
+      nas_pdn_connectivity_fail->pti = ue_context_p->pending_pdn_connectivity_req->pti;
+      nas_pdn_connectivity_fail->ue_id = ue_context_p->pending_pdn_connectivity_req->ue_id;
+    }
     nas_pdn_connectivity_fail->cause = (pdn_conn_rsp_cause_t)(create_sess_resp_pP->cause); 
-    rc = itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    mme_app_free_pending_pdn_connectivity_req (ue_context_p);
+    rc = itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
   }
 
@@ -986,7 +1069,8 @@ mme_app_handle_create_sess_resp (
   update_mme_app_stats_default_bearer_add();
 
   // todo: multiple bearers of the current context (per apn session) may be updated!
-  current_bearer_p = &ue_context_p->eps_bearers[bearer_id];
+  current_bearer_p = mme_app_get_bearer_context (ue_context_p, bearer_id);
+  DevAssert (current_bearer_p);
   current_bearer_p->s_gw_teid = create_sess_resp_pP->bearer_contexts_created.bearer_contexts[0].s1u_sgw_fteid.teid;
 
   switch (create_sess_resp_pP->bearer_contexts_created.bearer_contexts[0].s1u_sgw_fteid.ipv4 +
@@ -1042,7 +1126,7 @@ mme_app_handle_create_sess_resp (
     OAILOG_DEBUG (LOG_MME_APP, "Set qci %u in bearer %u\n", current_bearer_p->qci, ue_context_p->default_bearer_id);
   } else {
     // if null, it is not modified
-    //current_bearer_p->qci                    = ue_context_p->pending_pdn_connectivity_req_qos.qci;
+    //current_bearer_p->qci                    = ue_context_p->pending_pdn_connectivity_req->qos.qci;
 //#pragma message  "may force QCI here to 9"
     current_bearer_p->qci = 9;
     current_bearer_p->prio_level = 1;
@@ -1056,31 +1140,35 @@ mme_app_handle_create_sess_resp (
     //uint8_t *keNB = NULL;
     message_p = itti_alloc_new_message (TASK_MME_APP, NAS_PDN_CONNECTIVITY_RSP);
     itti_nas_pdn_connectivity_rsp_t *nas_pdn_connectivity_rsp = &message_p->ittiMsg.nas_pdn_connectivity_rsp;
+    pending_pdn_connectivity_req_t  *pending_p = ue_context_p->pending_pdn_connectivity_req;
+    ue_subscription_t               *subscription_p = ue_context_p->subscription;
     memset ((void *)nas_pdn_connectivity_rsp, 0, sizeof (itti_nas_pdn_connectivity_rsp_t));
     // moved to NAS_CONNECTION_ESTABLISHMENT_CONF, keNB not handled in NAS MME
     //derive_keNB(ue_context_p->vector_in_use->kasme, 156, &keNB);
     //memcpy(NAS_PDN_CONNECTIVITY_RSP(message_p).keNB, keNB, 32);
     //free(keNB);
-    nas_pdn_connectivity_rsp->pti = ue_context_p->pending_pdn_connectivity_req_pti;  // NAS internal ref
-    nas_pdn_connectivity_rsp->ue_id = ue_context_p->pending_pdn_connectivity_req_ue_id;      // NAS internal ref
+    if (pending_p) {
+      nas_pdn_connectivity_rsp->pti = pending_p->pti;  // NAS internal ref
+      nas_pdn_connectivity_rsp->ue_id = pending_p->ue_id;      // NAS internal ref
+    }
 
     // TO REWORK:
-    if (ue_context_p->pending_pdn_connectivity_req_apn) {
-      nas_pdn_connectivity_rsp->apn = bstrcpy (ue_context_p->pending_pdn_connectivity_req_apn);
+    if ((pending_p) && (pending_p->apn)) {
+      nas_pdn_connectivity_rsp->apn = bstrcpy (pending_p->apn);
       OAILOG_DEBUG (LOG_MME_APP, "SET APN FROM NAS PDN CONNECTIVITY CREATE: %s\n", bdata(nas_pdn_connectivity_rsp->apn));
-    } else {
+    } else if (subscription_p) {
       int                                     i;
-      context_identifier_t                    context_identifier = ue_context_p->apn_profile.context_identifier;
+      context_identifier_t                    context_identifier = subscription_p->apn_profile.context_identifier;
 
-      for (i = 0; i < ue_context_p->apn_profile.nb_apns; i++) {
-        if (ue_context_p->apn_profile.apn_configuration[i].context_identifier == context_identifier) {
-          AssertFatal (ue_context_p->apn_profile.apn_configuration[i].service_selection_length > 0, "Bad APN string (len = 0)");
+      for (i = 0; i < subscription_p->apn_profile.nb_apns; i++) {
+        if (subscription_p->apn_profile.apn_configuration[i].context_identifier == context_identifier) {
+          AssertFatal (subscription_p->apn_profile.apn_configuration[i].service_selection_length > 0, "Bad APN string (len = 0)");
 
-          if (ue_context_p->apn_profile.apn_configuration[i].service_selection_length > 0) {
-            nas_pdn_connectivity_rsp->apn = blk2bstr(ue_context_p->apn_profile.apn_configuration[i].service_selection,
-                ue_context_p->apn_profile.apn_configuration[i].service_selection_length);
-            AssertFatal (ue_context_p->apn_profile.apn_configuration[i].service_selection_length <= APN_MAX_LENGTH, "Bad APN string length %d",
-                ue_context_p->apn_profile.apn_configuration[i].service_selection_length);
+          if (subscription_p->apn_profile.apn_configuration[i].service_selection_length > 0) {
+            nas_pdn_connectivity_rsp->apn = blk2bstr(subscription_p->apn_profile.apn_configuration[i].service_selection,
+                subscription_p->apn_profile.apn_configuration[i].service_selection_length);
+            AssertFatal (subscription_p->apn_profile.apn_configuration[i].service_selection_length <= APN_MAX_LENGTH, "Bad APN string length %d",
+                subscription_p->apn_profile.apn_configuration[i].service_selection_length);
 
             OAILOG_DEBUG (LOG_MME_APP, "SET APN FROM HSS ULA: %s\n", bdata(nas_pdn_connectivity_rsp->apn));
             break;
@@ -1120,11 +1208,13 @@ mme_app_handle_create_sess_resp (
     }
 
     nas_pdn_connectivity_rsp->pdn_type = create_sess_resp_pP->paa.pdn_type;
-    nas_pdn_connectivity_rsp->proc_data = ue_context_p->pending_pdn_connectivity_req_proc_data;      // NAS internal ref
-    ue_context_p->pending_pdn_connectivity_req_proc_data = NULL;
+    if (pending_p) {
+      nas_pdn_connectivity_rsp->proc_data = pending_p->proc_data;      // NAS internal ref
+      pending_p->proc_data = NULL;
+    }
 //#pragma message  "QOS hardcoded here"
     //memcpy(&NAS_PDN_CONNECTIVITY_RSP(message_p).qos,
-    //        &ue_context_p->pending_pdn_connectivity_req_qos,
+    //        &pending_p->qos,
     //        sizeof(network_qos_t));
     nas_pdn_connectivity_rsp->qos.gbrUL = 64;        /* 64=64kb/s   Guaranteed Bit Rate for uplink   */
     nas_pdn_connectivity_rsp->qos.gbrDL = 120;       /* 120=512kb/s Guaranteed Bit Rate for downlink */
@@ -1135,8 +1225,9 @@ mme_app_handle_create_sess_resp (
      * in Activate Default EPS Bearer Context Setup Request message 
      */ 
     nas_pdn_connectivity_rsp->qos.qci = 9;   /* QoS Class Identifier                           */
-    nas_pdn_connectivity_rsp->request_type = ue_context_p->pending_pdn_connectivity_req_request_type;        // NAS internal ref
-    ue_context_p->pending_pdn_connectivity_req_request_type = 0;
+    if (pending_p) {
+      nas_pdn_connectivity_rsp->request_type = pending_p->request_type;        // NAS internal ref
+    }
     // here at this point OctetString are saved in resp, no loss of memory (apn, pdn_addr)
     nas_pdn_connectivity_rsp->ue_id = ue_context_p->mme_ue_s1ap_id;
     nas_pdn_connectivity_rsp->ebi = bearer_id;
@@ -1146,14 +1237,18 @@ mme_app_handle_create_sess_resp (
     nas_pdn_connectivity_rsp->pre_emp_capability = current_bearer_p->pre_emp_capability;
     nas_pdn_connectivity_rsp->sgw_s1u_teid = current_bearer_p->s_gw_teid;
     memcpy (&nas_pdn_connectivity_rsp->sgw_s1u_address, &current_bearer_p->s_gw_address, sizeof (ip_address_t));
-    nas_pdn_connectivity_rsp->ambr.br_ul = ue_context_p->subscribed_ambr.br_ul;
-    nas_pdn_connectivity_rsp->ambr.br_dl = ue_context_p->subscribed_ambr.br_dl;
+    if (subscription_p) {
+      nas_pdn_connectivity_rsp->ambr.br_ul = subscription_p->subscribed_ambr.br_ul;
+      nas_pdn_connectivity_rsp->ambr.br_dl = subscription_p->subscribed_ambr.br_dl;
+    }
     copy_protocol_configuration_options (&nas_pdn_connectivity_rsp->pco, &create_sess_resp_pP->pco);
     clear_protocol_configuration_options(&create_sess_resp_pP->pco);
+    // the PDN connectivity procedure is over on the MME_APP side
+    mme_app_free_pending_pdn_connectivity_req (ue_context_p);
 
     MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_NAS_MME, NULL, 0, "0 NAS_PDN_CONNECTIVITY_RSP sgw_s1u_teid %u ebi %u qci %u prio %u", current_bearer_p->s_gw_teid, bearer_id, current_bearer_p->qci, current_bearer_p->prio_level);
 
-    rc = itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    rc = itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
   }
   OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
@@ -1187,6 +1282,14 @@ mme_app_handle_modify_bearer_resp (
    * Updating statistics
    */
   update_mme_app_stats_s1u_bearer_add();
+  itti_trace_resume (ue_context_p->trace_id);
+  if ((modify_bearer_resp_pP->cause == REQUEST_ACCEPTED) && (ue_context_p->service_request_start_ns)) {
+    update_mme_app_stats_latency (MME_APP_LATENCY_SERVICE_REQUEST, ue_context_p->service_request_start_ns);
+    itti_trace_set_procedure (ue_context_p->trace_id, "service_request", ue_context_p->mme_ue_s1ap_id);
+    itti_trace_end (ue_context_p->trace_id);
+    ue_context_p->trace_id = ITTI_TRACE_ID_NONE;
+  }
+  ue_context_p->service_request_start_ns = 0;
 
 
   /* Whether SGW has created the session (IP address allocation, local GTP-U end point creation etc.)
@@ -1232,7 +1335,7 @@ mme_app_handle_modify_bearer_resp (
   // todo: bearer contexts already  have latest info !! not updating them --> eventually later updating the bearer contexts
   // todo: multiple bearers of the current context (per apn session) may be updated!
   // tood: checking received bearer id
-  current_bearer_p = &ue_context_p->eps_bearers[ue_context_p->default_bearer_id];
+  current_bearer_p = ue_context_p->eps_bearers[ue_context_p->default_bearer_id];
 //  current_bearer_p->s_gw_teid = modify_bearer_resp_pP->bearer_contexts_modified.bearer_contexts[0].s1u_sgw_fteid.teid;
 
 //  switch (modify_bearer_resp_pP->bearer_contexts_modified.bearer_contexts[0].s1u_sgw_fteid.ipv4 +
@@ -1299,7 +1402,7 @@ mme_app_handle_modify_bearer_resp (
     memset ((void *)nas_ho_bearer_modification_rsp, 0, sizeof (itti_nas_ho_bearer_modification_rsp_t));
     nas_ho_bearer_modification_rsp->ue_id = ue_context_p->mme_ue_s1ap_id;      // NAS internal ref
 
-    rc = itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    rc = itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
     // todo: later add a message which contains the MBResps
     //    message_p = itti_alloc_new_message (TASK_MME_APP, NAS_MODIFY_BEARER_RSP);
 
@@ -1346,6 +1449,7 @@ mme_app_handle_initial_context_setup_rsp (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "MME_APP_INITIAL_CONTEXT_SETUP_RSP Unknown ue %u", initial_ctxt_setup_rsp_pP->mme_ue_s1ap_id);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
+  itti_trace_resume (ue_context_p->trace_id);
   // Stop Initial context setup process guard timer,if running 
   if (ue_context_p->initial_context_setup_rsp_timer.id != MME_APP_TIMER_INACTIVE_ID) {
     if (timer_remove(ue_context_p->initial_context_setup_rsp_timer.id)) {
@@ -1509,7 +1613,7 @@ mme_app_handle_mobile_reachability_timer_expiry (struct ue_context_s *ue_context
   OAILOG_INFO (LOG_MME_APP, "Expired- Mobile Reachability Timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
   // Start Implicit Detach timer 
   if (timer_setup (ue_context_p->implicit_detach_timer.sec, 0, 
-                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->implicit_detach_timer.id)) < 0) { 
+                mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->implicit_detach_timer.id)) < 0) { 
     OAILOG_ERROR (LOG_MME_APP, "Failed to start Implicit Detach timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
     ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
   } else {
@@ -1526,13 +1630,21 @@ mme_app_handle_implicit_detach_timer_expiry (struct ue_context_s *ue_context_p)
   MessageDef                             *message_p = NULL;
   OAILOG_INFO (LOG_MME_APP, "Expired- Implicit Detach timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
   ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  if (ECM_IDLE != ue_context_p->ecm_state) {
+    // the expiry was queued before the UE came back and the timer was stopped
+    OAILOG_INFO (LOG_MME_APP, "UE id  %d no longer in ECM-IDLE, not detached\n", ue_context_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  // no record is built or kept for a UE being detached
+  mme_app_checkpoint_ue_forget (ue_context_p);
   
   // Initiate Implicit Detach for the UE
   message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IMPLICIT_DETACH_UE_IND);
   DevAssert (message_p != NULL);
   message_p->ittiMsg.nas_implicit_detach_ue_ind.ue_id = ue_context_p->mme_ue_s1ap_id;
+  message_p->ittiMsg.nas_implicit_detach_ue_ind.is_idle = true;
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_NAS_MME, NULL, 0, "0 NAS_IMPLICIT_DETACH_UE_IND_MESSAGE");
-  itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
@@ -1556,7 +1668,8 @@ mme_app_handle_initial_context_setup_rsp_timer_expiry (struct ue_context_s *ue_c
     message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IMPLICIT_DETACH_UE_IND);
     DevAssert (message_p != NULL);
     message_p->ittiMsg.nas_implicit_detach_ue_ind.ue_id = ue_context_p->mme_ue_s1ap_id;
-    itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    message_p->ittiMsg.nas_implicit_detach_ue_ind.is_idle = false;
+    itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   } else {
     // Release S1-U bearer and move the UE to idle mode 
     mme_app_send_s11_release_access_bearers_req(ue_context_p);
@@ -1597,7 +1710,8 @@ mme_app_handle_initial_context_setup_failure (
     message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IMPLICIT_DETACH_UE_IND);
     DevAssert (message_p != NULL);
     message_p->ittiMsg.nas_implicit_detach_ue_ind.ue_id = ue_context_p->mme_ue_s1ap_id;
-    itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    message_p->ittiMsg.nas_implicit_detach_ue_ind.is_idle = false;
+    itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   } else {
     // Release S1-U bearer and move the UE to idle mode 
     mme_app_send_s11_release_access_bearers_req(ue_context_p);
@@ -1614,49 +1728,32 @@ static bool mme_app_construct_guti_2(const plmn_t * const plmn_p, uint32_t m_tms
    */
 
   bool                                    is_guti_valid = false; // Set to true if serving MME is found and GUTI is constructed
-  uint8_t                                 num_mme       = 0;     // Number of configured MME in the MME pool
+  const mme_config_snapshot_t            *snapshot      = NULL;
+  const gummei_t                         *gummei_p      = NULL;  // served GUMMEI of the PLMN and MME code
   guti_p->m_tmsi = m_tmsi;
   guti_p->gummei.mme_code = mmec;
   // Create GUTI by using PLMN Id and MME-Group Id of serving MME
   OAILOG_DEBUG (LOG_MME_APP,
                 "Construct GUTI using S-TMSI received form UE and MME Group Id and PLMN id from MME Conf: %u, %u \n",
                 m_tmsi, mmec);
-  mme_config_read_lock (&mme_config);
+  snapshot = mme_config_snapshot_acquire ();
   /*
-   * Check number of MMEs in the pool.
    * At present it is assumed that one MME is supported in MME pool but in case there are more
-   * than one MME configured then search the serving MME using MME code.
+   * than one MME configured then search the serving MME using PLMN and MME code.
    * Assumption is that within one PLMN only one pool of MME will be configured
    */
-  if (mme_config.gummei.nb > 1)
-  {
-    OAILOG_DEBUG (LOG_MME_APP, "More than one MMEs are configured.");
-  }
-  for (num_mme = 0; num_mme < mme_config.gummei.nb; num_mme++)
-  {
-    /*Verify that the MME code within S-TMSI is same as what is configured in MME conf*/
-    if ((plmn_p->mcc_digit2 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit2) &&
-        (plmn_p->mcc_digit1 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit1) &&
-        (plmn_p->mnc_digit3 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit3) &&
-        (plmn_p->mcc_digit3 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit3) &&
-        (plmn_p->mnc_digit2 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit2) &&
-        (plmn_p->mnc_digit1 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit1) &&
-        (guti_p->gummei.mme_code == mme_config.gummei.gummei[num_mme].mme_code))
-    {
-      break;
-    }
-  }
-  if (num_mme >= mme_config.gummei.nb)
+  gummei_p = mme_config_snapshot_find_gummei (snapshot, plmn_p, guti_p->gummei.mme_code);
+  if (!gummei_p)
   {
     OAILOG_DEBUG (LOG_MME_APP, "No MME serves this UE");
   }
   else
   {
-    guti_p->gummei.plmn = mme_config.gummei.gummei[num_mme].plmn;
-    guti_p->gummei.mme_gid = mme_config.gummei.gummei[num_mme].mme_gid;
+    guti_p->gummei.plmn = gummei_p->plmn;
+    guti_p->gummei.mme_gid = gummei_p->mme_gid;
     is_guti_valid = true;
   }
-  mme_config_unlock (&mme_config);
+  mme_config_snapshot_release ();
   return is_guti_valid;
 }
 
@@ -1670,49 +1767,32 @@ static bool mme_app_construct_guti(const plmn_t * const plmn_p, const as_stmsi_t
    */
   
   bool                                    is_guti_valid = false; // Set to true if serving MME is found and GUTI is constructed 
-  uint8_t                                 num_mme       = 0;     // Number of configured MME in the MME pool  
+  const mme_config_snapshot_t            *snapshot      = NULL;
+  const gummei_t                         *gummei_p      = NULL;  // served GUMMEI of the PLMN and MME code
   guti_p->m_tmsi = s_tmsi_p->m_tmsi;
   guti_p->gummei.mme_code = s_tmsi_p->mme_code;
   // Create GUTI by using PLMN Id and MME-Group Id of serving MME
   OAILOG_DEBUG (LOG_MME_APP,
                 "Construct GUTI using S-TMSI received form UE and MME Group Id and PLMN id from MME Conf: %u, %u \n",
                 s_tmsi_p->m_tmsi, s_tmsi_p->mme_code);
-  mme_config_read_lock (&mme_config);
+  snapshot = mme_config_snapshot_acquire ();
   /*
-   * Check number of MMEs in the pool.
-   * At present it is assumed that one MME is supported in MME pool but in case there are more 
-   * than one MME configured then search the serving MME using MME code. 
+   * At present it is assumed that one MME is supported in MME pool but in case there are more
+   * than one MME configured then search the serving MME using PLMN and MME code.
    * Assumption is that within one PLMN only one pool of MME will be configured
    */
-  if (mme_config.gummei.nb > 1) 
-  {
-    OAILOG_DEBUG (LOG_MME_APP, "More than one MMEs are configured.");
-  }
-  for (num_mme = 0; num_mme < mme_config.gummei.nb; num_mme++)
-  {
-    /*Verify that the MME code within S-TMSI is same as what is configured in MME conf*/
-    if ((plmn_p->mcc_digit2 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit2) &&
-        (plmn_p->mcc_digit1 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit1) &&
-        (plmn_p->mnc_digit3 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit3) &&
-        (plmn_p->mcc_digit3 == mme_config.gummei.gummei[num_mme].plmn.mcc_digit3) &&
-        (plmn_p->mnc_digit2 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit2) && 
-        (plmn_p->mnc_digit1 == mme_config.gummei.gummei[num_mme].plmn.mnc_digit1) &&
-        (guti_p->gummei.mme_code == mme_config.gummei.gummei[num_mme].mme_code))
-    {
-      break;
-    }
-  }          
-  if (num_mme >= mme_config.gummei.nb)
+  gummei_p = mme_config_snapshot_find_gummei (snapshot, plmn_p, guti_p->gummei.mme_code);
+  if (!gummei_p)
   {
     OAILOG_DEBUG (LOG_MME_APP, "No MME serves this UE");
   }
-  else 
+  else
   {
-    guti_p->gummei.plmn = mme_config.gummei.gummei[num_mme].plmn;
-    guti_p->gummei.mme_gid = mme_config.gummei.gummei[num_mme].mme_gid;
+    guti_p->gummei.plmn = gummei_p->plmn;
+    guti_p->gummei.mme_gid = gummei_p->mme_gid;
     is_guti_valid = true;
   }
-  mme_config_unlock (&mme_config);
+  mme_config_snapshot_release ();
   return is_guti_valid;
 }
 
@@ -0,0 +1,747 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_checkpoint.c
+  \brief Checkpoint of the registered UEs in ECM-IDLE in a memory mapped file
+  and their restore at startup, so that they resume with a TAU or a SERVICE
+  REQUEST after a restart of the MME instead of attaching again.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "assertions.h"
+#include "log.h"
+#include "metrics.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_statistics.h"
+#include "mme_app_checkpoint_file.h"
+#include "mme_config.h"
+#include "emmData.h"
+#include "emm_cause.h"
+#include "emm_fsm.h"
+#include "esmData.h"
+#include "esm_ebr.h"
+#include "esm_ebr_context.h"
+#include "mme_app_shard.h"
+#include "timer.h"
+
+// downlink NAS messages a UE may receive before the release of its record reaches the disk
+#define MME_APP_CHECKPOINT_DL_COUNT_MARGIN  32
+
+/*
+ * Every MME_APP task lists the UEs of its shard which entered ECM-IDLE. On its
+ * checkpoint timer, the task fills the MME_APP part of the record of batch UEs
+ * at most from the head of its list and sends it in a NAS_UE_RECORD_REQ to
+ * the NAS task of the UE: the EMM and ESM contexts belong to that task and
+ * are only read by it. The record comes back in a NAS_UE_RECORD_RSP and is
+ * written in the slot of the UE, or the slot is released if the UE cannot be
+ * restored (procedure in progress, PDN or bearer not supported by the
+ * record). A response is dropped if the UE left ECM-IDLE or was removed in
+ * the meantime, checkpoint_generation tells. No snapshot of the contexts is
+ * taken: a UE in ECM-IDLE has no signalling in progress, its record is
+ * rewritten the next time it enters ECM-IDLE and released when it leaves
+ * ECM-IDLE or is detached, so the file holds the registered UEs in ECM-IDLE,
+ * none of the tasks is stopped.
+ *
+ * At startup, before the MME_APP tasks start, the MME_APP, EMM and ESM contexts
+ * of every valid record are rebuilt as if the UE had attached and then
+ * released its signalling connection. The current EPS security context (KASME
+ * and NAS COUNTs) is restored without authenticating the UE again: it is the
+ * context the UE itself keeps in EMM-REGISTERED and ECM-IDLE, and it is
+ * checked by the integrity protection of the next NAS message of the UE. No
+ * NAS message is sent to a UE in ECM-IDLE, so the COUNTs of the record are
+ * the last ones used, and the record is released as soon as the UE leaves
+ * ECM-IDLE. The release reaches the disk with the next sync only: after a
+ * crash of the host, a record released in the last period can come back
+ * while the UE received more downlink NAS messages. The restored DL COUNT is
+ * advanced by MME_APP_CHECKPOINT_DL_COUNT_MARGIN so that it is not used
+ * twice, the margin stays below the 256 values the UE recovers from the
+ * sequence number. The authentication vectors not in
+ * use, the non-current security context and the old GUTI are not kept: the
+ * UE is authenticated again with new vectors on its next attach.
+ *
+ * The same records, packed, keep the UEs evicted from memory by
+ * mme_app_eviction.c, restored with the same functions when they come back.
+ */
+
+TAILQ_HEAD (mme_app_checkpoint_list_s, ue_context_s);
+
+static struct {
+  bool                                    enabled;
+  uint32_t                                period_ms;
+  uint32_t                                batch;
+  uint64_t                                nb_restored;
+  uint64_t                                nb_rejected;
+  uint64_t                                restore_ms;
+  int                                     nb_exited;      // shards done with the file
+} mme_app_checkpoint = {0};
+
+// Only the task of the shard updates its list
+static struct {
+  struct mme_app_checkpoint_list_s        pending_list;
+  uint64_t                                nb_pending;
+  long                                    timer_id;
+} mme_app_checkpoint_shards[MME_APP_MAX_WORKERS];
+
+//------------------------------------------------------------------------------
+bool mme_app_checkpoint_fill_ue (const ue_context_t * const ue_context_p, mme_app_checkpoint_record_t * const record)
+{
+  int                                     nb_bearers = 0;
+
+  if ((ECM_IDLE != ue_context_p->ecm_state) || (UE_REGISTERED != ue_context_p->mm_state) || (!ue_context_p->is_guti_set) || (!ue_context_p->imsi) ||
+      (!ue_context_p->mme_s11_teid) || (!ue_context_p->sgw_s11_teid) || (ue_context_p->pending_pdn_connectivity_req)) {
+    return false;
+  }
+
+  memset (record, 0, sizeof (*record));
+  record->mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
+  record->imsi = ue_context_p->imsi;
+  record->guti = ue_context_p->guti;
+  record->mme_s11_teid = ue_context_p->mme_s11_teid;
+  record->sgw_s11_teid = ue_context_p->sgw_s11_teid;
+  record->default_bearer_id = ue_context_p->default_bearer_id;
+  record->last_tai = ue_context_p->last_tai;
+  record->e_utran_cgi = ue_context_p->e_utran_cgi;
+  record->used_ambr = ue_context_p->used_ambr;
+  record->paa = ue_context_p->paa;
+  if (ue_context_p->subscription) {
+    record->has_subscription = true;
+    record->subscription = *ue_context_p->subscription;
+  }
+  for (ebi_t ebi = ESM_EBI_MIN; (ebi <= ESM_EBI_MAX) && (ebi < BEARERS_PER_UE); ebi++) {
+    if (!ue_context_p->eps_bearers[ebi]) {
+      continue;
+    }
+    if (nb_bearers == MME_APP_CHECKPOINT_MAX_BEARERS) {
+      return false;
+    }
+    record->bearers[nb_bearers].ebi = ebi;
+    record->bearers[nb_bearers].has_context = true;
+    record->bearers[nb_bearers].context = *ue_context_p->eps_bearers[ebi];
+    nb_bearers++;
+  }
+  for (int k = 0; k < MME_APP_CHECKPOINT_MAX_PDNS; k++) {
+    record->pdns[k].pid = -1;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called by the NAS task of the UE, which owns its EMM context, on a
+ * NAS_UE_RECORD_REQ: completes the record filled by MME_APP with the EMM
+ * context and the ESM PDN connections and bearers.
+ */
+bool mme_app_checkpoint_fill_nas (const emm_data_context_t * const emm_ctx, mme_app_checkpoint_record_t * const record)
+{
+  const esm_data_context_t               *esm_ctx = &emm_ctx->esm_data_ctx;
+  const esm_ebr_context_t                *ebr_ctx = NULL;
+  const esm_pdn_t                        *pdn = NULL;
+  const esm_bearer_t                     *esm_bearer = NULL;
+  int                                     nb_pdns = 0;
+  int                                     pdn_index[ESM_DATA_PDN_MAX] = {0};
+
+  if ((EMM_REGISTERED != emm_ctx->_emm_fsm_status) || (emm_ctx->common_proc_mask) || (emm_ctx->specific_proc_mask) ||
+      (!IS_EMM_CTXT_PRESENT_GUTI (emm_ctx)) || (memcmp (&emm_ctx->_guti, &record->guti, sizeof (guti_t))) ||
+      (!IS_EMM_CTXT_VALID_SECURITY (emm_ctx)) || (emm_ctx->_security.vector_index < 0) || (emm_ctx->_security.vector_index >= MAX_EPS_AUTH_VECTORS)) {
+    return false;
+  }
+
+  record->member_present_mask = emm_ctx->member_present_mask;
+  record->member_valid_mask = emm_ctx->member_valid_mask;
+  record->is_emergency = emm_ctx->is_emergency;
+  record->attach_type = emm_ctx->attach_type;
+  record->nas_imsi = emm_ctx->_imsi;
+  record->imei = emm_ctx->_imei;
+  record->imeisv = emm_ctx->_imeisv;
+  record->tai_list = emm_ctx->_tai_list;
+  record->lvr_tai = emm_ctx->_lvr_tai;
+  record->ue_ksi = emm_ctx->ue_ksi;
+  record->eea = emm_ctx->eea;
+  record->eia = emm_ctx->eia;
+  record->ucs2 = emm_ctx->ucs2;
+  record->uea = emm_ctx->uea;
+  record->uia = emm_ctx->uia;
+  record->gea = emm_ctx->gea;
+  record->umts_present = emm_ctx->umts_present;
+  record->gprs_present = emm_ctx->gprs_present;
+  record->security = emm_ctx->_security;
+  record->vector = emm_ctx->_vector[emm_ctx->_security.vector_index];
+  record->ue_network_capability = emm_ctx->_ue_network_capability_ie;
+  record->ms_network_capability = emm_ctx->_ms_network_capability_ie;
+  record->current_drx_parameter = emm_ctx->_current_drx_parameter;
+  record->eps_bearer_context_status = emm_ctx->_eps_bearer_context_status;
+  record->eps_network_feature_support = emm_ctx->_eps_network_feature_support;
+
+  for (int pid = 0; pid < ESM_DATA_PDN_MAX; pid++) {
+    pdn = esm_ctx->pdn[pid].data;
+    if (!pdn) {
+      continue;
+    }
+    if ((nb_pdns == MME_APP_CHECKPOINT_MAX_PDNS) || (!esm_ctx->pdn[pid].is_active) || (blength (pdn->apn) > APN_MAX_LENGTH)) {
+      return false;
+    }
+    record->pdns[nb_pdns].pid = (int8_t)pid;
+    record->pdns[nb_pdns].is_emergency = pdn->is_emergency;
+    record->pdns[nb_pdns].pti = (uint8_t)pdn->pti;
+    record->pdns[nb_pdns].type = (uint8_t)pdn->type;
+    record->pdns[nb_pdns].ambr = pdn->ambr;
+    record->pdns[nb_pdns].addr_realloc = pdn->addr_realloc;
+    if (pdn->apn) {
+      memcpy (record->pdns[nb_pdns].apn, pdn->apn->data, blength (pdn->apn));
+    }
+    memcpy (record->pdns[nb_pdns].ip_addr, pdn->ip_addr, sizeof (pdn->ip_addr));
+    pdn_index[pid] = nb_pdns++;
+  }
+
+  // the ESM bearers join the MME_APP bearers of the same EBI
+  for (ebi_t ebi = ESM_EBI_MIN; ebi <= ESM_EBI_MAX; ebi++) {
+    mme_app_checkpoint_bearer_t          *bearer = NULL;
+
+    if (!(ebr_ctx = esm_ctx->ebr.context[ebi - ESM_EBI_MIN])) {
+      continue;
+    }
+    if ((ESM_EBR_ACTIVE != ebr_ctx->status) || (ebr_ctx->ebi != ebi)) {
+      return false;
+    }
+    for (int i = 0; (i < MME_APP_CHECKPOINT_MAX_BEARERS) && (!bearer); i++) {
+      if ((record->bearers[i].ebi == ebi) || (!record->bearers[i].ebi)) {
+        bearer = &record->bearers[i];
+      }
+    }
+    if (!bearer) {
+      return false;
+    }
+    esm_bearer = NULL;
+    for (int pid = 0; (pid < ESM_DATA_PDN_MAX) && (!esm_bearer); pid++) {
+      for (int bid = 0; (esm_ctx->pdn[pid].data) && (bid < ESM_DATA_EPS_BEARER_MAX); bid++) {
+        if ((esm_ctx->pdn[pid].data->bearer[bid]) && (esm_ctx->pdn[pid].data->bearer[bid]->ebi == ebi)) {
+          esm_bearer = esm_ctx->pdn[pid].data->bearer[bid];
+          bearer->pdn = (uint8_t)pdn_index[pid];
+          bearer->is_default = (0 == bid);
+          break;
+        }
+      }
+    }
+    // the traffic flow templates are not kept
+    if ((!esm_bearer) || (esm_bearer->tft.n_pkfs)) {
+      return false;
+    }
+    bearer->ebi = ebi;
+    bearer->has_esm = true;
+    bearer->qos = esm_bearer->qos;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Rebuilds the ESM PDN connections and EPS bearer contexts of the record, default bearers first
+static bool mme_app_checkpoint_restore_esm (const mme_app_checkpoint_record_t * const record, emm_data_context_t * const emm_ctx)
+{
+  esm_data_context_t                     *esm_ctx = &emm_ctx->esm_data_ctx;
+
+  for (int k = 0; k < MME_APP_CHECKPOINT_MAX_PDNS; k++) {
+    const mme_app_checkpoint_pdn_t       *record_pdn = &record->pdns[k];
+    esm_pdn_t                            *pdn = NULL;
+
+    if (record_pdn->pid < 0) {
+      continue;
+    }
+    if ((record_pdn->pid >= ESM_DATA_PDN_MAX) || (esm_ctx->pdn[record_pdn->pid].data)) {
+      return false;
+    }
+    pdn = (esm_pdn_t *) malloc (sizeof (esm_pdn_t));
+    if (!pdn) {
+      return false;
+    }
+    memset (pdn, 0, sizeof (esm_pdn_t));
+    esm_ctx->n_pdns += 1;
+    esm_ctx->pdn[record_pdn->pid].pid = record_pdn->pid;
+    esm_ctx->pdn[record_pdn->pid].is_active = false;
+    esm_ctx->pdn[record_pdn->pid].data = pdn;
+    pdn->pti = record_pdn->pti;
+    pdn->is_emergency = record_pdn->is_emergency;
+    pdn->ambr = record_pdn->ambr;
+    pdn->type = record_pdn->type;
+    pdn->addr_realloc = record_pdn->addr_realloc;
+    pdn->apn = blk2bstr (record_pdn->apn, strnlen (record_pdn->apn, APN_MAX_LENGTH));
+    memcpy (pdn->ip_addr, record_pdn->ip_addr, sizeof (pdn->ip_addr));
+  }
+  for (int is_default = 1; is_default >= 0; is_default--) {
+    for (int i = 0; i < MME_APP_CHECKPOINT_MAX_BEARERS; i++) {
+      const mme_app_checkpoint_bearer_t  *bearer = &record->bearers[i];
+
+      if ((!bearer->ebi) || (!bearer->has_esm) || (bearer->is_default != is_default)) {
+        continue;
+      }
+      if ((bearer->ebi < ESM_EBI_MIN) || (bearer->ebi > ESM_EBI_MAX) || (bearer->pdn >= MME_APP_CHECKPOINT_MAX_PDNS) ||
+          (record->pdns[bearer->pdn].pid < 0)) {
+        return false;
+      }
+      if ((esm_ebr_assign (emm_ctx, bearer->ebi) != bearer->ebi) ||
+          (ESM_EBI_UNASSIGNED == esm_ebr_context_create (emm_ctx, record->pdns[bearer->pdn].pid, bearer->ebi, is_default, &bearer->qos, NULL)) ||
+          (RETURNok != esm_ebr_set_status (emm_ctx, bearer->ebi, ESM_EBR_ACTIVE, false))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Rebuilds the MME_APP context of the record, in ECM-IDLE and UE_REGISTERED,
+ * and inserts it in the collections but the eNB UE S1AP id one, the UE has no
+ * signalling connection. NULL if a UE context holds one of its identities.
+ * The statistics and the timers are left to the caller.
+ */
+struct ue_context_s *mme_app_checkpoint_restore_ue_context (const mme_app_checkpoint_record_t * const record)
+{
+  mme_ue_context_t                       *mme_ue_context_p = &mme_app_desc.mme_ue_contexts;
+  ue_context_t                           *ue_context_p = NULL;
+
+  if ((mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_p, record->mme_ue_s1ap_id)) || (mme_ue_context_exists_imsi (mme_ue_context_p, record->imsi)) ||
+      (mme_ue_context_exists_s11_teid (mme_ue_context_p, record->mme_s11_teid)) || (mme_ue_context_exists_guti (mme_ue_context_p, &record->guti))) {
+    return NULL;
+  }
+  if (!(ue_context_p = mme_create_new_ue_context ())) {
+    return NULL;
+  }
+  ue_context_p->mme_ue_s1ap_id = record->mme_ue_s1ap_id;
+  ue_context_p->imsi = record->imsi;
+  ue_context_p->imsi_auth = IMSI_AUTHENTICATED;
+  ue_context_p->guti = record->guti;
+  ue_context_p->is_guti_set = true;
+  ue_context_p->mme_s11_teid = record->mme_s11_teid;
+  ue_context_p->sgw_s11_teid = record->sgw_s11_teid;
+  ue_context_p->default_bearer_id = record->default_bearer_id;
+  ue_context_p->last_tai = record->last_tai;
+  ue_context_p->e_utran_cgi = record->e_utran_cgi;
+  ue_context_p->used_ambr = record->used_ambr;
+  ue_context_p->paa = record->paa;
+  ue_context_p->mm_state = UE_REGISTERED;
+  ue_context_p->ecm_state = ECM_IDLE;
+  ue_context_p->mobile_reachability_timer.sec = ((mme_config.nas_config.t3412_min) + MME_APP_DELTA_T3412_REACHABILITY_TIMER) * 60;
+  ue_context_p->implicit_detach_timer.sec = (ue_context_p->mobile_reachability_timer.sec) + MME_APP_DELTA_REACHABILITY_IMPLICIT_DETACH_TIMER * 60;
+  if (record->has_subscription) {
+    if (!mme_app_get_ue_subscription (ue_context_p)) {
+      mme_remove_ue_context (mme_ue_context_p, ue_context_p);
+      return NULL;
+    }
+    *ue_context_p->subscription = record->subscription;
+    ue_context_p->subscription_known = SUBSCRIPTION_KNOWN;
+  }
+  for (int i = 0; i < MME_APP_CHECKPOINT_MAX_BEARERS; i++) {
+    bearer_context_t                     *bearer_context = NULL;
+
+    if ((record->bearers[i].ebi) && (record->bearers[i].has_context)) {
+      if (!(bearer_context = mme_app_get_bearer_context (ue_context_p, record->bearers[i].ebi))) {
+        mme_remove_ue_context (mme_ue_context_p, ue_context_p);
+        return NULL;
+      }
+      *bearer_context = record->bearers[i].context;
+    }
+  }
+  hashtable_ts_insert (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id, (void *)ue_context_p);
+  hashtable_ts_insert (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->imsi, (void *)((uintptr_t)ue_context_p->mme_ue_s1ap_id));
+  hashtable_ts_insert (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_s11_teid, (void *)((uintptr_t)ue_context_p->mme_ue_s1ap_id));
+  obj_hashtable_ts_insert (mme_ue_context_p->guti_ue_context_htbl, (const void *const)&ue_context_p->guti, sizeof (ue_context_p->guti),
+                           (void *)((uintptr_t)ue_context_p->mme_ue_s1ap_id));
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Rebuilds the EMM and ESM contexts of the record, in EMM-REGISTERED as at the
+ * end of the attach, from the NAS task of the UE or before the tasks start.
+ * NULL if they cannot be rebuilt. The statistics are left to the caller.
+ */
+emm_data_context_t *mme_app_checkpoint_restore_emm_context (const mme_app_checkpoint_record_t * const record)
+{
+  emm_data_context_t                     *emm_ctx = NULL;
+  const uint32_t                          not_kept = EMM_CTXT_MEMBER_OLD_GUTI | EMM_CTXT_MEMBER_AUTH_VECTORS | EMM_CTXT_MEMBER_NON_CURRENT_SECURITY |
+                                                     EMM_CTXT_MEMBER_PENDING_DRX_PARAMETER | ~(EMM_CTXT_MEMBER_AUTH_VECTOR0 - 1);
+
+  if ((record->security.vector_index < 0) || (record->security.vector_index >= MAX_EPS_AUTH_VECTORS)) {
+    return NULL;
+  }
+  if (!(emm_ctx = (emm_data_context_t *) slab_pool_alloc (_emm_data.ctx_pool))) {
+    return NULL;
+  }
+  emm_ctx->ue_id = record->mme_ue_s1ap_id;
+  emm_ctx->is_dynamic = true;
+  emm_ctx->is_attached = true;
+  emm_ctx->is_has_been_attached = true;
+  emm_ctx->is_emergency = record->is_emergency;
+  emm_ctx->attach_type = record->attach_type;
+  emm_ctx->emm_cause = EMM_CAUSE_SUCCESS;
+  emm_ctx->_emm_fsm_status = EMM_REGISTERED;
+  emm_ctx->T3450.id = NAS_TIMER_INACTIVE_ID;
+  emm_ctx->T3450.sec = T3450_DEFAULT_VALUE;
+  emm_ctx->T3460.id = NAS_TIMER_INACTIVE_ID;
+  emm_ctx->T3460.sec = T3460_DEFAULT_VALUE;
+  emm_ctx->T3470.id = NAS_TIMER_INACTIVE_ID;
+  emm_ctx->T3470.sec = T3470_DEFAULT_VALUE;
+  emm_ctx->timer_s6a_auth_info_rsp.id = NAS_TIMER_INACTIVE_ID;
+  emm_ctx->timer_s6a_auth_info_rsp.sec = TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE;
+  emm_ctx->timer_s6a_auth_info_rsp_arg = NULL;
+  emm_ctx_clear_old_guti (emm_ctx);
+  emm_ctx_clear_non_current_security (emm_ctx);
+  emm_ctx_clear_auth_vectors (emm_ctx);
+  emm_ctx_clear_pending_current_drx_parameter (emm_ctx);
+  emm_ctx->_imsi = record->nas_imsi;
+  emm_ctx->_imsi64 = record->imsi;
+  emm_ctx->_imei = record->imei;
+  emm_ctx->_imeisv = record->imeisv;
+  emm_ctx->_guti = record->guti;
+  emm_ctx->_tai_list = record->tai_list;
+  emm_ctx->_lvr_tai = record->lvr_tai;
+  emm_ctx->ue_ksi = record->ue_ksi;
+  emm_ctx->eea = record->eea;
+  emm_ctx->eia = record->eia;
+  emm_ctx->ucs2 = record->ucs2;
+  emm_ctx->uea = record->uea;
+  emm_ctx->uia = record->uia;
+  emm_ctx->gea = record->gea;
+  emm_ctx->umts_present = record->umts_present;
+  emm_ctx->gprs_present = record->gprs_present;
+  emm_ctx->_security = record->security;
+  // the vector is kept for the KASME only, the next authentication requests new vectors
+  emm_ctx->_vector[record->security.vector_index] = record->vector;
+  emm_ctx->_ue_network_capability_ie = record->ue_network_capability;
+  emm_ctx->_ms_network_capability_ie = record->ms_network_capability;
+  emm_ctx->_current_drx_parameter = record->current_drx_parameter;
+  emm_ctx->_eps_bearer_context_status = record->eps_bearer_context_status;
+  emm_ctx->_eps_network_feature_support = record->eps_network_feature_support;
+  emm_ctx->member_present_mask = record->member_present_mask & ~not_kept;
+  emm_ctx->member_valid_mask = record->member_valid_mask & ~not_kept;
+  if ((RETURNok != emm_data_context_add (&_emm_data, emm_ctx)) || (!mme_app_checkpoint_restore_esm (record, emm_ctx))) {
+    emm_data_context_remove (&_emm_data, emm_ctx);
+    free_emm_data_context (emm_ctx);
+    return NULL;
+  }
+  return emm_ctx;
+}
+
+//------------------------------------------------------------------------------
+// Skips the DL COUNTs possibly used after the record was written, see the top of the file
+static void mme_app_checkpoint_advance_dl_count (emm_security_context_t * const security)
+{
+  uint32_t                                seq_num = security->dl_count.seq_num + MME_APP_CHECKPOINT_DL_COUNT_MARGIN;
+
+  if (seq_num > 0xFF) {
+    security->dl_count.overflow += 1;
+  }
+  security->dl_count.seq_num = seq_num & 0xFF;
+}
+
+//------------------------------------------------------------------------------
+// Called by mme_app_checkpoint_file_open for every valid record, before the MME_APP tasks start
+static bool mme_app_checkpoint_restore_ue (const mme_app_checkpoint_record_t * const record, const int shard, const uint32_t slot, void * const arg)
+{
+  ue_context_t                           *ue_context_p = NULL;
+  emm_data_context_t                     *emm_ctx = NULL;
+
+  if ((INVALID_MME_UE_S1AP_ID == record->mme_ue_s1ap_id) || (shard != mme_app_shard_of_ue_id (record->mme_ue_s1ap_id)) ||
+      (mme_app_shard_of_tag (record->guti.m_tmsi) != shard) || (mme_app_shard_of_tag (record->mme_s11_teid) != shard) ||
+      (record->security.vector_index < 0) || (record->security.vector_index >= MAX_EPS_AUTH_VECTORS)) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint record %u of UE id " MME_UE_S1AP_ID_FMT " not consistent, not restored\n", slot, record->mme_ue_s1ap_id);
+    mme_app_checkpoint.nb_rejected++;
+    return false;
+  }
+  if (!(ue_context_p = mme_app_checkpoint_restore_ue_context (record))) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint record %u of UE id " MME_UE_S1AP_ID_FMT " duplicated, not restored\n", slot, record->mme_ue_s1ap_id);
+    mme_app_checkpoint.nb_rejected++;
+    return false;
+  }
+  if (!(emm_ctx = mme_app_checkpoint_restore_emm_context (record))) {
+    OAILOG_WARNING (LOG_MME_APP, "Checkpoint record %u of UE id " MME_UE_S1AP_ID_FMT " has bad PDN connections, not restored\n", slot, record->mme_ue_s1ap_id);
+    mme_app_checkpoint.nb_rejected++;
+    mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p);
+    return false;
+  }
+  mme_app_checkpoint_advance_dl_count (&emm_ctx->_security);
+
+  // statistics as at the end of the attach
+  update_mme_app_stats_attached_ue_add ();
+  update_mme_app_stats_default_bearer_add ();
+  mme_app_shard_reserve_ue_id (ue_context_p->mme_ue_s1ap_id);
+  ue_context_p->checkpoint_slot = slot;
+  if (mme_config.nas_config.t3412_min > 0) {
+    if (timer_setup (ue_context_p->mobile_reachability_timer.sec, 0, mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, TIMER_ONE_SHOT,
+                     (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->mobile_reachability_timer.id)) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to start Mobile Reachability timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
+      ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
+    }
+  }
+  mme_app_eviction_ue_idle (ue_context_p);
+  mme_app_checkpoint.nb_restored++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_checkpoint_init (void)
+{
+  uint32_t                                capacity = mme_config.checkpoint_config.capacity ? mme_config.checkpoint_config.capacity : mme_config.max_ues;
+  uint64_t                                start_ns = 0;
+  int                                     nb_restored = 0;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  memset (mme_app_checkpoint_shards, 0, sizeof (mme_app_checkpoint_shards));
+  for (int shard = 0; shard < MME_APP_MAX_WORKERS; shard++) {
+    TAILQ_INIT (&mme_app_checkpoint_shards[shard].pending_list);
+  }
+  mme_app_checkpoint.period_ms = mme_config.checkpoint_config.period_ms;
+  mme_app_checkpoint.batch = mme_config.checkpoint_config.batch;
+  if ((!mme_config.checkpoint_config.file) || (!mme_app_checkpoint.period_ms) || (!mme_app_checkpoint.batch)) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+  }
+
+  start_ns = metrics_now_ns ();
+  nb_restored = mme_app_checkpoint_file_open (bdata (mme_config.checkpoint_config.file), capacity, mme_app_nb_workers, &_emm_data.conf.gummei,
+                                              mme_app_checkpoint_restore_ue, NULL);
+  if (nb_restored < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to map the checkpoint file %s of %u records\n", bdata (mme_config.checkpoint_config.file), capacity);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  mme_app_checkpoint.restore_ms = (metrics_now_ns () - start_ns) / 1000000;
+  mme_app_checkpoint.enabled = true;
+  OAILOG_INFO (LOG_MME_APP, "Restored %d UE contexts from the checkpoint file %s in %" PRIu64 " ms (%" PRIu64 " records rejected)\n",
+      nb_restored, bdata (mme_config.checkpoint_config.file), mme_app_checkpoint.restore_ms, mme_app_checkpoint.nb_rejected);
+
+  if (metrics_register_collector (mme_app_checkpoint_dump_prometheus) < 0) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    if (timer_setup (mme_app_checkpoint.period_ms / 1000, (mme_app_checkpoint.period_ms % 1000) * 1000, mme_app_shard_tasks[shard],
+                     INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_checkpoint_shards[shard].timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to request the checkpoint timer of MME_APP task %d\n", shard);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  }
+  OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called by every MME_APP task when it terminates, the last one unmaps the
+ * file. The records of the UEs still waiting for their checkpoint are not
+ * written, the NAS tasks may have released their contexts already.
+ */
+void mme_app_checkpoint_exit (void)
+{
+  if (!mme_app_checkpoint.enabled) {
+    return;
+  }
+  timer_remove (mme_app_checkpoint_shards[mme_app_current_shard].timer_id);
+  if (__atomic_add_fetch (&mme_app_checkpoint.nb_exited, 1, __ATOMIC_ACQ_REL) == mme_app_nb_workers) {
+    mme_app_checkpoint_file_close ();
+  }
+}
+
+//------------------------------------------------------------------------------
+long mme_app_checkpoint_timer_id (void)
+{
+  return (mme_app_checkpoint.enabled) ? mme_app_checkpoint_shards[mme_app_current_shard].timer_id : MME_APP_TIMER_INACTIVE_ID;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_ue_idle (struct ue_context_s * const ue_context_p)
+{
+  int                                     shard = 0;
+
+  if ((!mme_app_checkpoint.enabled) || (ue_context_p->checkpoint_pending) || (INVALID_MME_UE_S1AP_ID == ue_context_p->mme_ue_s1ap_id)) {
+    return;
+  }
+  shard = mme_app_shard_of_ue_id (ue_context_p->mme_ue_s1ap_id);
+  ue_context_p->checkpoint_pending = true;
+  TAILQ_INSERT_TAIL (&mme_app_checkpoint_shards[shard].pending_list, ue_context_p, checkpoint_entries);
+  __atomic_store_n (&mme_app_checkpoint_shards[shard].nb_pending, mme_app_checkpoint_shards[shard].nb_pending + 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_ue_forget (struct ue_context_s * const ue_context_p)
+{
+  int                                     shard = 0;
+
+  // a NAS_UE_RECORD_RSP in flight is dropped
+  ue_context_p->checkpoint_generation++;
+  if ((!ue_context_p->checkpoint_pending) && (MME_APP_CHECKPOINT_SLOT_NONE == ue_context_p->checkpoint_slot)) {
+    return;
+  }
+  shard = mme_app_shard_of_ue_id (ue_context_p->mme_ue_s1ap_id);
+  if (ue_context_p->checkpoint_pending) {
+    TAILQ_REMOVE (&mme_app_checkpoint_shards[shard].pending_list, ue_context_p, checkpoint_entries);
+    ue_context_p->checkpoint_pending = false;
+    __atomic_store_n (&mme_app_checkpoint_shards[shard].nb_pending, mme_app_checkpoint_shards[shard].nb_pending - 1, __ATOMIC_RELAXED);
+  }
+  mme_app_checkpoint_file_release (shard, ue_context_p->checkpoint_slot);
+  ue_context_p->checkpoint_slot = MME_APP_CHECKPOINT_SLOT_NONE;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Fills the MME_APP part of the records of a batch of UEs and sends them to
+ * the NAS tasks of the UEs, the records are written by
+ * mme_app_checkpoint_handle_ue_record_rsp. The writes of the previous batch
+ * are synced first.
+ */
+void mme_app_checkpoint_timer_expiry (void)
+{
+  struct mme_app_checkpoint_list_s       *pending_list = &mme_app_checkpoint_shards[mme_app_current_shard].pending_list;
+  struct ue_context_s                    *ue_context_p = NULL;
+  mme_app_checkpoint_record_t            *record = NULL;
+  MessageDef                             *message_p = NULL;
+  uint32_t                                nb_checkpointed = 0;
+
+  mme_app_checkpoint_file_sync (mme_app_current_shard);
+  while ((nb_checkpointed < mme_app_checkpoint.batch) && (ue_context_p = TAILQ_FIRST (pending_list))) {
+    TAILQ_REMOVE (pending_list, ue_context_p, checkpoint_entries);
+    ue_context_p->checkpoint_pending = false;
+    nb_checkpointed++;
+    if ((!record) && (posix_memalign ((void **)&record, 64, sizeof (mme_app_checkpoint_record_t)))) {
+      record = NULL;
+      break;
+    }
+    if (!mme_app_checkpoint_fill_ue (ue_context_p, record)) {
+      mme_app_checkpoint_file_release (mme_app_current_shard, ue_context_p->checkpoint_slot);
+      ue_context_p->checkpoint_slot = MME_APP_CHECKPOINT_SLOT_NONE;
+      continue;
+    }
+    message_p = itti_alloc_new_message (TASK_MME_APP, NAS_UE_RECORD_REQ);
+    NAS_UE_RECORD_REQ (message_p).ue_id = ue_context_p->mme_ue_s1ap_id;
+    NAS_UE_RECORD_REQ (message_p).generation = ue_context_p->checkpoint_generation;
+    NAS_UE_RECORD_REQ (message_p).is_eviction = false;
+    NAS_UE_RECORD_REQ (message_p).is_valid = false;
+    NAS_UE_RECORD_REQ (message_p).record = record;
+    record = NULL;
+    itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+  }
+  free (record);
+  if (nb_checkpointed) {
+    __atomic_store_n (&mme_app_checkpoint_shards[mme_app_current_shard].nb_pending,
+                      mme_app_checkpoint_shards[mme_app_current_shard].nb_pending - nb_checkpointed, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Writes the record completed by NAS if the UE did not leave ECM-IDLE since
+ * it was requested, releases the slot of the UE if NAS found that the UE
+ * cannot be restored from a record.
+ */
+void mme_app_checkpoint_handle_ue_record_rsp (itti_nas_ue_record_t * const ue_record_rsp_p)
+{
+  struct ue_context_s                    *ue_context_p = NULL;
+
+  ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_record_rsp_p->ue_id);
+  if ((!mme_app_checkpoint.enabled) || (!ue_context_p) || (ECM_IDLE != ue_context_p->ecm_state) ||
+      (ue_record_rsp_p->generation != ue_context_p->checkpoint_generation)) {
+    free (ue_record_rsp_p->record);
+    ue_record_rsp_p->record = NULL;
+    return;
+  }
+  if (!ue_record_rsp_p->is_valid) {
+    mme_app_checkpoint_file_release (mme_app_current_shard, ue_context_p->checkpoint_slot);
+    ue_context_p->checkpoint_slot = MME_APP_CHECKPOINT_SLOT_NONE;
+  } else {
+    if (MME_APP_CHECKPOINT_SLOT_NONE == ue_context_p->checkpoint_slot) {
+      ue_context_p->checkpoint_slot = mme_app_checkpoint_file_alloc (mme_app_current_shard);
+    }
+    if (MME_APP_CHECKPOINT_SLOT_NONE != ue_context_p->checkpoint_slot) {
+      mme_app_checkpoint_file_write (mme_app_current_shard, ue_context_p->checkpoint_slot, ue_record_rsp_p->record);
+    }
+  }
+  free (ue_record_rsp_p->record);
+  ue_record_rsp_p->record = NULL;
+}
+
+//------------------------------------------------------------------------------
+// Writes the record of a UE evicted from memory in its slot, allocated if none
+uint32_t mme_app_checkpoint_write_record (uint32_t slot, mme_app_checkpoint_record_t * const record)
+{
+  if (!mme_app_checkpoint.enabled) {
+    return MME_APP_CHECKPOINT_SLOT_NONE;
+  }
+  if (MME_APP_CHECKPOINT_SLOT_NONE == slot) {
+    slot = mme_app_checkpoint_file_alloc (mme_app_current_shard);
+  }
+  if (MME_APP_CHECKPOINT_SLOT_NONE != slot) {
+    mme_app_checkpoint_file_write (mme_app_current_shard, slot, record);
+  }
+  return slot;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_release_record (const uint32_t slot)
+{
+  mme_app_checkpoint_file_release (mme_app_current_shard, slot);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_report (bstring str)
+{
+  mme_app_checkpoint_file_stats_t         stats = {0};
+  uint64_t                                nb_pending = 0;
+
+  if (!mme_app_checkpoint.enabled) {
+    return;
+  }
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    nb_pending += __atomic_load_n (&mme_app_checkpoint_shards[shard].nb_pending, __ATOMIC_RELAXED);
+  }
+  mme_app_checkpoint_file_get_stats (&stats);
+  bformata (str, "Checkpointed UEs         %10" PRIu64 " / %" PRIu64 " records (%" PRIu64 " B), %" PRIu64 " pending, %" PRIu64 " not written for lack of record\n",
+      stats.nb_records, stats.capacity, stats.file_bytes, nb_pending, stats.nb_full);
+  bformata (str, "Restored UEs             %10" PRIu64 " in %" PRIu64 " ms (%" PRIu64 " records rejected)\n",
+      mme_app_checkpoint.nb_restored, mme_app_checkpoint.restore_ms, mme_app_checkpoint.nb_rejected);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_dump_prometheus (bstring out)
+{
+  mme_app_checkpoint_file_stats_t         stats = {0};
+
+  mme_app_checkpoint_file_get_stats (&stats);
+  bformata (out, "# HELP mme_ue_checkpoint_records UE records in the checkpoint file\n# TYPE mme_ue_checkpoint_records gauge\n");
+  bformata (out, "mme_ue_checkpoint_records %" PRIu64 "\n", stats.nb_records);
+  bformata (out, "# HELP mme_ue_checkpoint_capacity UE records the checkpoint file can hold\n# TYPE mme_ue_checkpoint_capacity gauge\n");
+  bformata (out, "mme_ue_checkpoint_capacity %" PRIu64 "\n", stats.capacity);
+  bformata (out, "# HELP mme_ue_checkpoint_written_total UE records written\n# TYPE mme_ue_checkpoint_written_total counter\n");
+  bformata (out, "mme_ue_checkpoint_written_total %" PRIu64 "\n", stats.nb_written);
+  bformata (out, "# HELP mme_ue_checkpoint_released_total UE records released on connection or detach\n# TYPE mme_ue_checkpoint_released_total counter\n");
+  bformata (out, "mme_ue_checkpoint_released_total %" PRIu64 "\n", stats.nb_released);
+  bformata (out, "# HELP mme_ue_checkpoint_full_total UE records not written, no free record\n# TYPE mme_ue_checkpoint_full_total counter\n");
+  bformata (out, "mme_ue_checkpoint_full_total %" PRIu64 "\n", stats.nb_full);
+  bformata (out, "# HELP mme_ue_checkpoint_restored UE contexts restored at startup\n# TYPE mme_ue_checkpoint_restored gauge\n");
+  bformata (out, "mme_ue_checkpoint_restored %" PRIu64 "\n", mme_app_checkpoint.nb_restored);
+  bformata (out, "# HELP mme_ue_checkpoint_restore_seconds Duration of the restore at startup\n# TYPE mme_ue_checkpoint_restore_seconds gauge\n");
+  bformata (out, "mme_ue_checkpoint_restore_seconds %.3f\n", (double)mme_app_checkpoint.restore_ms / 1000.0);
+}
@@ -0,0 +1,395 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_checkpoint_file.c
+  \brief Memory mapped file of fixed size UE context records, see
+  mme_app_checkpoint_file.h.
+  \author
+  \company
+  \email
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mme_app_checkpoint_file.h"
+#include "mme_app_shard.h"
+
+/*
+ * The file is a header page followed by capacity records, slot n at index
+ * n - 1. The slots are split in equal ranges between the shards so that the
+ * tasks never share a free list nor write the same pages. A record is
+ * rewritten in place: its state is cleared, its content copied then its state
+ * set, all through the shared mapping, so a process crash leaves at most the
+ * record being written invalid. The write back to the disk is left to the
+ * kernel (msync MS_ASYNC), the checksum rejects the records torn by a crash of
+ * the host.
+ */
+#define MME_APP_CHECKPOINT_HEADER_SIZE    4096
+#define MME_APP_CHECKPOINT_RECORD_VALID   0x56414c44U     // "DLAV"
+
+typedef struct mme_app_checkpoint_header_s {
+  uint32_t                                magic;
+  uint32_t                                version;
+  uint32_t                                record_size;
+  uint32_t                                capacity;
+  uint32_t                                nb_shards;
+  uint16_t                                mme_gid;
+  uint8_t                                 mme_code;
+  uint8_t                                 plmn[6];
+} mme_app_checkpoint_header_t;
+
+static struct {
+  int                                     fd;
+  uint8_t                                *map;
+  size_t                                  map_bytes;
+  mme_app_checkpoint_record_t            *records;
+  uint32_t                                capacity;
+  uint32_t                                slots_per_shard;
+  int                                     nb_shards;
+} mme_app_checkpoint_file = {.fd = -1};
+
+// Only the task of the shard updates its state, the counters are read by the statistics
+static struct {
+  uint32_t                               *free_slots;
+  uint32_t                                nb_free;
+  uint32_t                                sync_first;     // slots written since the last sync, 0 if none
+  uint32_t                                sync_last;
+  uint64_t                                nb_records;
+  uint64_t                                nb_written;
+  uint64_t                                nb_released;
+  uint64_t                                nb_full;
+} __attribute__ ((aligned (64))) mme_app_checkpoint_shards[MME_APP_MAX_WORKERS];
+
+//------------------------------------------------------------------------------
+static uint32_t mme_app_checkpoint_checksum (const mme_app_checkpoint_record_t * const record)
+{
+  const uint64_t                         *word = (const uint64_t *)((const uint8_t *)record + offsetof (mme_app_checkpoint_record_t, mme_ue_s1ap_id));
+  const uint64_t                         *end = (const uint64_t *)(record + 1);
+  uint64_t                                h = 0xcbf29ce484222325ULL;
+
+  while (word < end) {
+    h = (h ^ *word++) * 0x100000001b3ULL;
+  }
+  return (uint32_t)(h ^ (h >> 32));
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_checkpoint_header_init (mme_app_checkpoint_header_t * const header, const uint32_t capacity,
+                                            const int nb_shards, const gummei_t * const gummei)
+{
+  memset (header, 0, sizeof (*header));
+  header->magic = MME_APP_CHECKPOINT_MAGIC;
+  header->version = MME_APP_CHECKPOINT_VERSION;
+  header->record_size = sizeof (mme_app_checkpoint_record_t);
+  header->capacity = capacity;
+  header->nb_shards = (uint32_t)nb_shards;
+  header->mme_gid = gummei->mme_gid;
+  header->mme_code = gummei->mme_code;
+  header->plmn[0] = gummei->plmn.mcc_digit1;
+  header->plmn[1] = gummei->plmn.mcc_digit2;
+  header->plmn[2] = gummei->plmn.mcc_digit3;
+  header->plmn[3] = gummei->plmn.mnc_digit1;
+  header->plmn[4] = gummei->plmn.mnc_digit2;
+  header->plmn[5] = gummei->plmn.mnc_digit3;
+}
+
+//------------------------------------------------------------------------------
+static inline int mme_app_checkpoint_shard_of_slot (const uint32_t slot)
+{
+  return (int)((slot - 1) / mme_app_checkpoint_file.slots_per_shard);
+}
+
+//------------------------------------------------------------------------------
+int mme_app_checkpoint_file_open (const char * const path, const uint32_t capacity, const int nb_shards, const gummei_t * const gummei,
+                                  mme_app_checkpoint_restore_cb_t restore, void * const arg)
+{
+  mme_app_checkpoint_header_t             header = {0};
+  struct stat                             st = {0};
+  size_t                                  map_bytes = 0;
+  uint32_t                                slots_per_shard = 0;
+  int                                     nb_restored = 0;
+
+  if ((!path) || (0 == capacity) || (nb_shards < 1) || (nb_shards > MME_APP_MAX_WORKERS)) {
+    return -1;
+  }
+  slots_per_shard = (capacity + nb_shards - 1) / nb_shards;
+  mme_app_checkpoint_header_init (&header, slots_per_shard * nb_shards, nb_shards, gummei);
+  map_bytes = MME_APP_CHECKPOINT_HEADER_SIZE + (size_t)header.capacity * sizeof (mme_app_checkpoint_record_t);
+  mme_app_checkpoint_file.fd = open (path, O_RDWR | O_CREAT, 0600);
+  if ((mme_app_checkpoint_file.fd < 0) || (fstat (mme_app_checkpoint_file.fd, &st) < 0)) {
+    goto error;
+  }
+  // a file of another size cannot have the expected header
+  if ((size_t)st.st_size != map_bytes) {
+    if ((ftruncate (mme_app_checkpoint_file.fd, 0) < 0) || (ftruncate (mme_app_checkpoint_file.fd, map_bytes) < 0)) {
+      goto error;
+    }
+  }
+  mme_app_checkpoint_file.map = mmap (NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mme_app_checkpoint_file.fd, 0);
+  if (MAP_FAILED == mme_app_checkpoint_file.map) {
+    mme_app_checkpoint_file.map = NULL;
+    goto error;
+  }
+  mme_app_checkpoint_file.map_bytes = map_bytes;
+  mme_app_checkpoint_file.records = (mme_app_checkpoint_record_t *)(mme_app_checkpoint_file.map + MME_APP_CHECKPOINT_HEADER_SIZE);
+  mme_app_checkpoint_file.capacity = header.capacity;
+  mme_app_checkpoint_file.slots_per_shard = slots_per_shard;
+  mme_app_checkpoint_file.nb_shards = nb_shards;
+  if (memcmp (mme_app_checkpoint_file.map, &header, sizeof (header))) {
+    // other layout, other shards or other MME: the records cannot be restored, zero them
+    munmap (mme_app_checkpoint_file.map, map_bytes);
+    if ((ftruncate (mme_app_checkpoint_file.fd, 0) < 0) || (ftruncate (mme_app_checkpoint_file.fd, map_bytes) < 0)) {
+      mme_app_checkpoint_file.map = NULL;
+      goto error;
+    }
+    mme_app_checkpoint_file.map = mmap (NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mme_app_checkpoint_file.fd, 0);
+    if (MAP_FAILED == mme_app_checkpoint_file.map) {
+      mme_app_checkpoint_file.map = NULL;
+      goto error;
+    }
+    mme_app_checkpoint_file.records = (mme_app_checkpoint_record_t *)(mme_app_checkpoint_file.map + MME_APP_CHECKPOINT_HEADER_SIZE);
+    memcpy (mme_app_checkpoint_file.map, &header, sizeof (header));
+    msync (mme_app_checkpoint_file.map, MME_APP_CHECKPOINT_HEADER_SIZE, MS_SYNC);
+  }
+
+  memset (mme_app_checkpoint_shards, 0, sizeof (mme_app_checkpoint_shards));
+  madvise (mme_app_checkpoint_file.records, (size_t)header.capacity * sizeof (mme_app_checkpoint_record_t), MADV_SEQUENTIAL);
+  for (int shard = 0; shard < nb_shards; shard++) {
+    mme_app_checkpoint_shards[shard].free_slots = malloc (slots_per_shard * sizeof (uint32_t));
+    if (!mme_app_checkpoint_shards[shard].free_slots) {
+      goto error;
+    }
+    // forward scan for the read ahead
+    for (uint32_t slot = shard * slots_per_shard + 1; slot <= (shard + 1) * slots_per_shard; slot++) {
+      mme_app_checkpoint_record_t        *record = &mme_app_checkpoint_file.records[slot - 1];
+
+      if (MME_APP_CHECKPOINT_RECORD_VALID == record->state) {
+        if ((record->checksum == mme_app_checkpoint_checksum (record)) && ((!restore) || (restore (record, shard, slot, arg)))) {
+          mme_app_checkpoint_shards[shard].nb_records++;
+          nb_restored++;
+          continue;
+        }
+      }
+      if (record->state) {
+        record->state = 0;
+      }
+      mme_app_checkpoint_shards[shard].free_slots[mme_app_checkpoint_shards[shard].nb_free++] = slot;
+    }
+    // the free slots are popped from the end, lowest slot first
+    for (uint32_t i = 0, j = mme_app_checkpoint_shards[shard].nb_free; i + 1 < j; i++, j--) {
+      uint32_t                            slot = mme_app_checkpoint_shards[shard].free_slots[i];
+
+      mme_app_checkpoint_shards[shard].free_slots[i] = mme_app_checkpoint_shards[shard].free_slots[j - 1];
+      mme_app_checkpoint_shards[shard].free_slots[j - 1] = slot;
+    }
+  }
+  // the scanned pages stay in the page cache, not in the MME resident set
+  madvise (mme_app_checkpoint_file.records, (size_t)header.capacity * sizeof (mme_app_checkpoint_record_t), MADV_DONTNEED);
+  madvise (mme_app_checkpoint_file.records, (size_t)header.capacity * sizeof (mme_app_checkpoint_record_t), MADV_RANDOM);
+  return nb_restored;
+
+error:
+  mme_app_checkpoint_file_close ();
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_file_close (void)
+{
+  if (mme_app_checkpoint_file.map) {
+    msync (mme_app_checkpoint_file.map, mme_app_checkpoint_file.map_bytes, MS_SYNC);
+    munmap (mme_app_checkpoint_file.map, mme_app_checkpoint_file.map_bytes);
+    mme_app_checkpoint_file.map = NULL;
+    mme_app_checkpoint_file.records = NULL;
+  }
+  if (mme_app_checkpoint_file.fd >= 0) {
+    close (mme_app_checkpoint_file.fd);
+    mme_app_checkpoint_file.fd = -1;
+  }
+  for (int shard = 0; shard < MME_APP_MAX_WORKERS; shard++) {
+    free (mme_app_checkpoint_shards[shard].free_slots);
+    mme_app_checkpoint_shards[shard].free_slots = NULL;
+    mme_app_checkpoint_shards[shard].nb_free = 0;
+  }
+  mme_app_checkpoint_file.capacity = 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t mme_app_checkpoint_file_alloc (const int shard)
+{
+  if (0 == mme_app_checkpoint_shards[shard].nb_free) {
+    __atomic_fetch_add (&mme_app_checkpoint_shards[shard].nb_full, 1, __ATOMIC_RELAXED);
+    return MME_APP_CHECKPOINT_SLOT_NONE;
+  }
+  return mme_app_checkpoint_shards[shard].free_slots[--mme_app_checkpoint_shards[shard].nb_free];
+}
+
+//------------------------------------------------------------------------------
+// Adds the slot to the range written back by the next mme_app_checkpoint_file_sync
+static void mme_app_checkpoint_file_dirty (const int shard, const uint32_t slot)
+{
+  if ((MME_APP_CHECKPOINT_SLOT_NONE == mme_app_checkpoint_shards[shard].sync_first) || (slot < mme_app_checkpoint_shards[shard].sync_first)) {
+    mme_app_checkpoint_shards[shard].sync_first = slot;
+  }
+  if (slot > mme_app_checkpoint_shards[shard].sync_last) {
+    mme_app_checkpoint_shards[shard].sync_last = slot;
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_file_write (const int shard, const uint32_t slot, mme_app_checkpoint_record_t * const record)
+{
+  mme_app_checkpoint_record_t            *dst = &mme_app_checkpoint_file.records[slot - 1];
+
+  if (dst->state != MME_APP_CHECKPOINT_RECORD_VALID) {
+    __atomic_fetch_add (&mme_app_checkpoint_shards[shard].nb_records, 1, __ATOMIC_RELAXED);
+  }
+  record->state = 0;
+  record->checksum = mme_app_checkpoint_checksum (record);
+  __atomic_store_n (&dst->state, 0, __ATOMIC_RELEASE);
+  memcpy ((uint8_t *)dst + sizeof (dst->state), (const uint8_t *)record + sizeof (record->state), sizeof (*record) - sizeof (record->state));
+  __atomic_store_n (&dst->state, MME_APP_CHECKPOINT_RECORD_VALID, __ATOMIC_RELEASE);
+  __atomic_fetch_add (&mme_app_checkpoint_shards[shard].nb_written, 1, __ATOMIC_RELAXED);
+  mme_app_checkpoint_file_dirty (shard, slot);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_file_release (const int shard, const uint32_t slot)
+{
+  mme_app_checkpoint_record_t            *dst = NULL;
+
+  if ((MME_APP_CHECKPOINT_SLOT_NONE == slot) || (mme_app_checkpoint_shard_of_slot (slot) != shard)) {
+    return;
+  }
+  dst = &mme_app_checkpoint_file.records[slot - 1];
+  if (MME_APP_CHECKPOINT_RECORD_VALID == dst->state) {
+    __atomic_store_n (&dst->state, 0, __ATOMIC_RELEASE);
+    __atomic_fetch_sub (&mme_app_checkpoint_shards[shard].nb_records, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&mme_app_checkpoint_shards[shard].nb_released, 1, __ATOMIC_RELAXED);
+    // the cleared state must reach the disk too, or the record comes back after a crash of the host
+    mme_app_checkpoint_file_dirty (shard, slot);
+  }
+  mme_app_checkpoint_shards[shard].free_slots[mme_app_checkpoint_shards[shard].nb_free++] = slot;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_file_sync (const int shard)
+{
+  uintptr_t                               first = 0;
+  uintptr_t                               last = 0;
+  uintptr_t                               page_size = (uintptr_t)sysconf (_SC_PAGESIZE);
+
+  if (MME_APP_CHECKPOINT_SLOT_NONE == mme_app_checkpoint_shards[shard].sync_first) {
+    return;
+  }
+  first = (uintptr_t)&mme_app_checkpoint_file.records[mme_app_checkpoint_shards[shard].sync_first - 1] & ~(page_size - 1);
+  last = (uintptr_t)&mme_app_checkpoint_file.records[mme_app_checkpoint_shards[shard].sync_last];
+  msync ((void *)first, last - first, MS_ASYNC);
+  mme_app_checkpoint_shards[shard].sync_first = MME_APP_CHECKPOINT_SLOT_NONE;
+  mme_app_checkpoint_shards[shard].sync_last = MME_APP_CHECKPOINT_SLOT_NONE;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_checkpoint_file_get_stats (mme_app_checkpoint_file_stats_t * const stats)
+{
+  memset (stats, 0, sizeof (*stats));
+  stats->capacity = mme_app_checkpoint_file.capacity;
+  stats->file_bytes = mme_app_checkpoint_file.map_bytes;
+  for (int shard = 0; shard < MME_APP_MAX_WORKERS; shard++) {
+    stats->nb_records += __atomic_load_n (&mme_app_checkpoint_shards[shard].nb_records, __ATOMIC_RELAXED);
+    stats->nb_written += __atomic_load_n (&mme_app_checkpoint_shards[shard].nb_written, __ATOMIC_RELAXED);
+    stats->nb_released += __atomic_load_n (&mme_app_checkpoint_shards[shard].nb_released, __ATOMIC_RELAXED);
+    stats->nb_full += __atomic_load_n (&mme_app_checkpoint_shards[shard].nb_full, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The record is mostly zeros (unused bearers and PDNs, subscription APNs), a
+ * control byte n < 0x80 introduces n + 1 literal bytes, 0x80 | (n - 1) a run
+ * of n zero bytes. A zero byte alone stays in the literals.
+ */
+size_t mme_app_checkpoint_record_pack (const mme_app_checkpoint_record_t * const record, uint8_t * const buffer, const size_t size)
+{
+  const uint8_t                          *src = (const uint8_t *)record;
+  size_t                                  length = 0;
+  size_t                                  i = 0;
+
+  while (i < sizeof (*record)) {
+    size_t                                n = 0;
+
+    if ((0 == src[i]) && (i + 1 < sizeof (*record)) && (0 == src[i + 1])) {
+      while ((i + n < sizeof (*record)) && (0 == src[i + n]) && (n < 128)) {
+        n++;
+      }
+      if (length + 1 > size) {
+        return 0;
+      }
+      buffer[length++] = (uint8_t)(0x80 | (n - 1));
+    } else {
+      while ((i + n < sizeof (*record)) && (n < 128) &&
+             ((0 != src[i + n]) || (i + n + 1 == sizeof (*record)) || (0 != src[i + n + 1]))) {
+        n++;
+      }
+      if (length + 1 + n > size) {
+        return 0;
+      }
+      buffer[length++] = (uint8_t)(n - 1);
+      memcpy (&buffer[length], &src[i], n);
+      length += n;
+    }
+    i += n;
+  }
+  return length;
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_checkpoint_record_unpack (const uint8_t * const buffer, const size_t length, mme_app_checkpoint_record_t * const record)
+{
+  uint8_t                                *dst = (uint8_t *)record;
+  size_t                                  i = 0;
+  size_t                                  j = 0;
+
+  while (i < length) {
+    size_t                                n = (buffer[i] & 0x7f) + 1;
+
+    if (j + n > sizeof (*record)) {
+      return false;
+    }
+    if (buffer[i++] & 0x80) {
+      memset (&dst[j], 0, n);
+    } else {
+      if (i + n > length) {
+        return false;
+      }
+      memcpy (&dst[j], &buffer[i], n);
+      i += n;
+    }
+    j += n;
+  }
+  return j == sizeof (*record);
+}
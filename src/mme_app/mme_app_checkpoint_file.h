@@ -0,0 +1,167 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_checkpoint_file.h
+  \brief Memory mapped file of fixed size UE context records, written in
+  place by the MME_APP tasks and read back at startup.
+  \author
+  \company
+  \email
+*/
+
+#ifndef FILE_MME_APP_CHECKPOINT_FILE_SEEN
+#define FILE_MME_APP_CHECKPOINT_FILE_SEEN
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "3gpp_23.003.h"
+#include "mme_app_ue_context.h"
+#include "emmData.h"
+
+/*
+ * The layout of the file is versioned: a change of the record below must
+ * increment MME_APP_CHECKPOINT_VERSION, a file of another version (or record
+ * size, capacity, number of shards, GUMMEI) is reset when opened.
+ */
+#define MME_APP_CHECKPOINT_MAGIC          0x4b43414fU     // "OACK"
+#define MME_APP_CHECKPOINT_VERSION        1
+#define MME_APP_CHECKPOINT_MAX_PDNS       2
+#define MME_APP_CHECKPOINT_MAX_BEARERS    4
+
+#define MME_APP_CHECKPOINT_SLOT_NONE      0               // slots are numbered from 1
+
+typedef struct mme_app_checkpoint_pdn_s {
+  int8_t                                  pid;            // index in the ESM PDN connections, -1 if unused
+  bool                                    is_emergency;
+  uint8_t                                 pti;
+  uint8_t                                 type;
+  int32_t                                 ambr;
+  int32_t                                 addr_realloc;
+  char                                    apn[APN_MAX_LENGTH + 1];
+  char                                    ip_addr[ESM_DATA_IP_ADDRESS_SIZE + 1];
+} mme_app_checkpoint_pdn_t;
+
+typedef struct mme_app_checkpoint_bearer_s {
+  ebi_t                                   ebi;            // 0 if unused
+  bool                                    has_context;    // MME_APP bearer context
+  bool                                    has_esm;        // ESM EPS bearer context
+  bool                                    is_default;
+  uint8_t                                 pdn;            // index in pdns
+  network_qos_t                           qos;            // ESM QoS
+  bearer_context_t                        context;
+} mme_app_checkpoint_bearer_t;
+
+typedef struct mme_app_checkpoint_record_s {
+  uint32_t                                state;          // written last
+  uint32_t                                checksum;       // of the fields below
+  // MME_APP
+  mme_ue_s1ap_id_t                        mme_ue_s1ap_id;
+  imsi64_t                                imsi;
+  guti_t                                  guti;
+  teid_t                                  mme_s11_teid;
+  teid_t                                  sgw_s11_teid;
+  ebi_t                                   default_bearer_id;
+  tai_t                                   last_tai;
+  ecgi_t                                  e_utran_cgi;
+  ambr_t                                  used_ambr;
+  PAA_t                                   paa;
+  mme_app_checkpoint_bearer_t             bearers[MME_APP_CHECKPOINT_MAX_BEARERS];
+  bool                                    has_subscription;
+  ue_subscription_t                       subscription;
+  // EMM
+  uint32_t                                member_present_mask;
+  uint32_t                                member_valid_mask;
+  bool                                    is_emergency;
+  uint8_t                                 attach_type;
+  imsi_t                                  nas_imsi;
+  imei_t                                  imei;
+  imeisv_t                                imeisv;
+  tai_list_t                              tai_list;
+  tai_t                                   lvr_tai;
+  ksi_t                                   ue_ksi;
+  int32_t                                 eea;
+  int32_t                                 eia;
+  int32_t                                 ucs2;
+  int32_t                                 uea;
+  int32_t                                 uia;
+  int32_t                                 gea;
+  bool                                    umts_present;
+  bool                                    gprs_present;
+  emm_security_context_t                  security;
+  auth_vector_t                           vector;         // of the security context, for the KeNB
+  UeNetworkCapability                     ue_network_capability;
+  MsNetworkCapability                     ms_network_capability;
+  DrxParameter                            current_drx_parameter;
+  EpsBearerContextStatus                  eps_bearer_context_status;
+  EpsNetworkFeatureSupport                eps_network_feature_support;
+  // ESM
+  mme_app_checkpoint_pdn_t                pdns[MME_APP_CHECKPOINT_MAX_PDNS];
+} __attribute__ ((aligned (64))) mme_app_checkpoint_record_t;
+
+typedef struct mme_app_checkpoint_file_stats_s {
+  uint64_t                                capacity;       // records
+  uint64_t                                nb_records;
+  uint64_t                                file_bytes;
+  uint64_t                                nb_written;
+  uint64_t                                nb_released;
+  uint64_t                                nb_full;        // records not written for lack of free slot
+} mme_app_checkpoint_file_stats_t;
+
+// called for every valid record found when the file is opened, false to release the record
+typedef bool (*mme_app_checkpoint_restore_cb_t) (const mme_app_checkpoint_record_t * const record, const int shard, const uint32_t slot, void * const arg);
+
+/*
+ * Maps the file, creating or resetting it if needed, calls restore for its
+ * valid records and returns the number of records kept, -1 on error. The
+ * slots are split between the shards, every shard allocates, writes and
+ * releases only its slots, from its own task.
+ */
+int  mme_app_checkpoint_file_open (const char * const path, const uint32_t capacity, const int nb_shards, const gummei_t * const gummei,
+                                   mme_app_checkpoint_restore_cb_t restore, void * const arg);
+// synchronous write back of the records, then unmaps the file
+void mme_app_checkpoint_file_close (void);
+
+uint32_t mme_app_checkpoint_file_alloc (const int shard);
+void mme_app_checkpoint_file_write (const int shard, const uint32_t slot, mme_app_checkpoint_record_t * const record);
+void mme_app_checkpoint_file_release (const int shard, const uint32_t slot);
+// asynchronous write back of the records written by the shard since its last sync
+void mme_app_checkpoint_file_sync (const int shard);
+
+void mme_app_checkpoint_file_get_stats (mme_app_checkpoint_file_stats_t * const stats);
+
+// compact copy of a record (mme_app_eviction.c keeps the evicted UEs in memory), 0 if the buffer is too small
+size_t mme_app_checkpoint_record_pack (const mme_app_checkpoint_record_t * const record, uint8_t * const buffer, const size_t size);
+bool mme_app_checkpoint_record_unpack (const uint8_t * const buffer, const size_t length, mme_app_checkpoint_record_t * const record);
+
+// records and UE contexts, see mme_app_checkpoint.c
+// MME_APP part of the record, filled by the MME_APP task of the UE, false if the UE cannot be restored from a record
+bool mme_app_checkpoint_fill_ue (const struct ue_context_s * const ue_context_p, mme_app_checkpoint_record_t * const record);
+// EMM and ESM parts of the record, filled by the NAS task of the UE, false if the UE cannot be restored from a record
+bool mme_app_checkpoint_fill_nas (const emm_data_context_t * const emm_ctx, mme_app_checkpoint_record_t * const record);
+struct ue_context_s *mme_app_checkpoint_restore_ue_context (const mme_app_checkpoint_record_t * const record);
+emm_data_context_t *mme_app_checkpoint_restore_emm_context (const mme_app_checkpoint_record_t * const record);
+// from the MME_APP task of the UE, MME_APP_CHECKPOINT_SLOT_NONE if the checkpoint is disabled or the file full
+uint32_t mme_app_checkpoint_write_record (uint32_t slot, mme_app_checkpoint_record_t * const record);
+void mme_app_checkpoint_release_record (const uint32_t slot);
+
+#endif /* FILE_MME_APP_CHECKPOINT_FILE_SEEN */
@@ -0,0 +1,200 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_cold_store.c
+  \brief GUTI to IMSI association of the UEs implicitly detached while
+  attached, see mme_app_cold_store.h.
+  \author
+  \company
+  \email
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "mme_app_cold_store.h"
+
+/*
+ * The records are direct mapped on a hash of the GUTI: a new record replaces
+ * the one of its slot whatever its age, so the store never grows beyond its
+ * capacity and needs no eviction of its own. A record is removed when it is
+ * found. The M-TMSI of a GUTI is derived from the address of a UE context,
+ * which the slab pool soon hands out again: mme_api_new_guti skips the GUTIs
+ * of the records, so the GUTI of a record always designates its IMSI. The
+ * slots are protected by a set of mutexes, the NAS tasks of all the shards
+ * save and take records concurrently.
+ */
+#define MME_APP_COLD_STORE_LOCKS          64      // power of 2
+
+typedef struct mme_app_cold_record_s {
+  guti_t                                  guti;
+  imsi_t                                  imsi;
+  bool                                    is_used;
+} mme_app_cold_record_t;
+
+static struct {
+  mme_app_cold_record_t                  *records;
+  uint32_t                                capacity;
+  pthread_mutex_t                         locks[MME_APP_COLD_STORE_LOCKS];
+  uint64_t                                nb_records;
+  uint64_t                                nb_saved;
+  uint64_t                                nb_replaced;
+  uint64_t                                nb_hits;
+  uint64_t                                nb_misses;
+} mme_app_cold_store = {0};
+
+//------------------------------------------------------------------------------
+static inline uint32_t mme_app_cold_store_slot (const guti_t * const guti)
+{
+  uint64_t                                key = ((uint64_t)guti->gummei.mme_gid << 40) | ((uint64_t)guti->gummei.mme_code << 32) | guti->m_tmsi;
+
+  // M-TMSIs are allocated 1 << MME_APP_SHARD_TAG_BITS apart, the multiplication spreads them
+  key *= 0x9E3779B97F4A7C15ULL;
+  return (uint32_t)((key >> 32) % mme_app_cold_store.capacity);
+}
+
+//------------------------------------------------------------------------------
+static inline bool mme_app_cold_store_guti_equal (const guti_t * const a, const guti_t * const b)
+{
+  return (a->m_tmsi == b->m_tmsi) && (a->gummei.mme_code == b->gummei.mme_code) && (a->gummei.mme_gid == b->gummei.mme_gid) &&
+         (a->gummei.plmn.mcc_digit1 == b->gummei.plmn.mcc_digit1) && (a->gummei.plmn.mcc_digit2 == b->gummei.plmn.mcc_digit2) &&
+         (a->gummei.plmn.mcc_digit3 == b->gummei.plmn.mcc_digit3) && (a->gummei.plmn.mnc_digit1 == b->gummei.plmn.mnc_digit1) &&
+         (a->gummei.plmn.mnc_digit2 == b->gummei.plmn.mnc_digit2) && (a->gummei.plmn.mnc_digit3 == b->gummei.plmn.mnc_digit3);
+}
+
+//------------------------------------------------------------------------------
+int mme_app_cold_store_init (const uint32_t capacity)
+{
+  memset (&mme_app_cold_store, 0, sizeof (mme_app_cold_store));
+  if (0 == capacity) {
+    return 0;
+  }
+  mme_app_cold_store.records = calloc (capacity, sizeof (mme_app_cold_record_t));
+  if (!mme_app_cold_store.records) {
+    return -1;
+  }
+  for (int i = 0; i < MME_APP_COLD_STORE_LOCKS; i++) {
+    pthread_mutex_init (&mme_app_cold_store.locks[i], NULL);
+  }
+  mme_app_cold_store.capacity = capacity;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_cold_store_exit (void)
+{
+  if (mme_app_cold_store.records) {
+    for (int i = 0; i < MME_APP_COLD_STORE_LOCKS; i++) {
+      pthread_mutex_destroy (&mme_app_cold_store.locks[i]);
+    }
+    free (mme_app_cold_store.records);
+  }
+  memset (&mme_app_cold_store, 0, sizeof (mme_app_cold_store));
+}
+
+//------------------------------------------------------------------------------
+void mme_app_cold_store_save (const guti_t * const guti, const imsi_t * const imsi)
+{
+  uint32_t                                slot = 0;
+  mme_app_cold_record_t                  *record = NULL;
+  pthread_mutex_t                        *lock = NULL;
+
+  if (0 == mme_app_cold_store.capacity) {
+    return;
+  }
+  slot = mme_app_cold_store_slot (guti);
+  record = &mme_app_cold_store.records[slot];
+  lock = &mme_app_cold_store.locks[slot & (MME_APP_COLD_STORE_LOCKS - 1)];
+  pthread_mutex_lock (lock);
+  if (!record->is_used) {
+    __sync_fetch_and_add (&mme_app_cold_store.nb_records, 1);
+  } else if (!mme_app_cold_store_guti_equal (&record->guti, guti)) {
+    __sync_fetch_and_add (&mme_app_cold_store.nb_replaced, 1);
+  }
+  record->guti = *guti;
+  record->imsi = *imsi;
+  record->is_used = true;
+  pthread_mutex_unlock (lock);
+  __sync_fetch_and_add (&mme_app_cold_store.nb_saved, 1);
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_cold_store_take (const guti_t * const guti, imsi_t * const imsi)
+{
+  uint32_t                                slot = 0;
+  mme_app_cold_record_t                  *record = NULL;
+  pthread_mutex_t                        *lock = NULL;
+  bool                                    found = false;
+
+  if (0 == mme_app_cold_store.capacity) {
+    return false;
+  }
+  slot = mme_app_cold_store_slot (guti);
+  record = &mme_app_cold_store.records[slot];
+  lock = &mme_app_cold_store.locks[slot & (MME_APP_COLD_STORE_LOCKS - 1)];
+  pthread_mutex_lock (lock);
+  if ((record->is_used) && (mme_app_cold_store_guti_equal (&record->guti, guti))) {
+    *imsi = record->imsi;
+    memset (record, 0, sizeof (*record));
+    found = true;
+  }
+  pthread_mutex_unlock (lock);
+  if (found) {
+    __sync_fetch_and_sub (&mme_app_cold_store.nb_records, 1);
+    __sync_fetch_and_add (&mme_app_cold_store.nb_hits, 1);
+  } else {
+    __sync_fetch_and_add (&mme_app_cold_store.nb_misses, 1);
+  }
+  return found;
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_cold_store_is_guti_used (const guti_t * const guti)
+{
+  uint32_t                                slot = 0;
+  mme_app_cold_record_t                  *record = NULL;
+  pthread_mutex_t                        *lock = NULL;
+  bool                                    found = false;
+
+  if (0 == mme_app_cold_store.capacity) {
+    return false;
+  }
+  slot = mme_app_cold_store_slot (guti);
+  record = &mme_app_cold_store.records[slot];
+  lock = &mme_app_cold_store.locks[slot & (MME_APP_COLD_STORE_LOCKS - 1)];
+  pthread_mutex_lock (lock);
+  found = (record->is_used) && (mme_app_cold_store_guti_equal (&record->guti, guti));
+  pthread_mutex_unlock (lock);
+  return found;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_cold_store_get_stats (mme_app_cold_store_stats_t * const stats)
+{
+  stats->capacity = mme_app_cold_store.capacity;
+  stats->nb_records = __atomic_load_n (&mme_app_cold_store.nb_records, __ATOMIC_RELAXED);
+  stats->memory_bytes = (uint64_t)mme_app_cold_store.capacity * sizeof (mme_app_cold_record_t);
+  stats->nb_saved = __atomic_load_n (&mme_app_cold_store.nb_saved, __ATOMIC_RELAXED);
+  stats->nb_replaced = __atomic_load_n (&mme_app_cold_store.nb_replaced, __ATOMIC_RELAXED);
+  stats->nb_hits = __atomic_load_n (&mme_app_cold_store.nb_hits, __ATOMIC_RELAXED);
+  stats->nb_misses = __atomic_load_n (&mme_app_cold_store.nb_misses, __ATOMIC_RELAXED);
+}
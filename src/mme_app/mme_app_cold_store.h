@@ -0,0 +1,62 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_cold_store.h
+  \brief GUTI to IMSI association of the UEs implicitly detached while
+  attached, kept after their contexts are released so that a UE attaching
+  again with its last GUTI is identified without IDENTITY REQUEST.
+  \author
+  \company
+  \email
+*/
+
+#ifndef FILE_MME_APP_COLD_STORE_SEEN
+#define FILE_MME_APP_COLD_STORE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "3gpp_23.003.h"
+
+typedef struct mme_app_cold_store_stats_s {
+  uint64_t                                capacity;       // records
+  uint64_t                                nb_records;
+  uint64_t                                memory_bytes;
+  uint64_t                                nb_saved;
+  uint64_t                                nb_replaced;    // records overwritten by a record of another GUTI
+  uint64_t                                nb_hits;
+  uint64_t                                nb_misses;
+} mme_app_cold_store_stats_t;
+
+// capacity 0 disables the cold store, save does nothing and take never finds a record
+int  mme_app_cold_store_init (const uint32_t capacity);
+void mme_app_cold_store_exit (void);
+
+// may be called by any thread
+void mme_app_cold_store_save (const guti_t * const guti, const imsi_t * const imsi);
+// finds the record of the GUTI and removes it, false if there is none
+bool mme_app_cold_store_take (const guti_t * const guti, imsi_t * const imsi);
+// whether a record holds the GUTI, which must not be allocated to another UE
+bool mme_app_cold_store_is_guti_used (const guti_t * const guti);
+
+void mme_app_cold_store_get_stats (mme_app_cold_store_stats_t * const stats);
+
+#endif /* FILE_MME_APP_COLD_STORE_SEEN */
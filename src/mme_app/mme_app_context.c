@@ -42,6 +42,8 @@
 #include "s1ap_mme.h"
 #include "timer.h"
 #include "mme_app_statistics.h"
+#include "intertask_interface_trace.h"
+#include "mme_app_shard.h"
 
 
 static void _mme_app_handle_s1ap_ue_context_release (const mme_ue_s1ap_id_t mme_ue_s1ap_id,
@@ -53,7 +55,11 @@ static void _mme_app_handle_s1ap_ue_context_release (const mme_ue_s1ap_id_t mme_
 //------------------------------------------------------------------------------
 ue_context_t *mme_create_new_ue_context (void)
 {
-  ue_context_t                           *new_p = calloc (1, sizeof (ue_context_t));
+  ue_context_t                           *new_p = slab_pool_alloc (mme_app_desc.mme_ue_contexts.ue_context_pool);
+
+  if (!new_p) {
+    return NULL;
+  }
   new_p->mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
   new_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
   // Initialize timers to INVALID IDs
@@ -63,11 +69,111 @@ ue_context_t *mme_create_new_ue_context (void)
   new_p->ue_radio_cap_length = 0;
 
   new_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  new_p->paging_timer.id = MME_APP_TIMER_INACTIVE_ID;
   new_p->ue_context_rel_cause = S1AP_INVALID_CAUSE;
 
   return new_p;
 }
 
+//------------------------------------------------------------------------------
+ue_subscription_t *mme_app_get_ue_subscription (ue_context_t * const ue_context_p)
+{
+  if (!ue_context_p->subscription) {
+    ue_context_p->subscription = slab_pool_alloc (mme_app_desc.mme_ue_contexts.subscription_pool);
+  }
+  return ue_context_p->subscription;
+}
+
+//------------------------------------------------------------------------------
+pending_pdn_connectivity_req_t *mme_app_get_pending_pdn_connectivity_req (ue_context_t * const ue_context_p)
+{
+  if (!ue_context_p->pending_pdn_connectivity_req) {
+    ue_context_p->pending_pdn_connectivity_req = slab_pool_alloc (mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool);
+  }
+  return ue_context_p->pending_pdn_connectivity_req;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_free_pending_pdn_connectivity_req (ue_context_t * const ue_context_p)
+{
+  pending_pdn_connectivity_req_t         *pending_p = ue_context_p->pending_pdn_connectivity_req;
+
+  if (pending_p) {
+    bdestroy (pending_p->apn);
+    bdestroy (pending_p->pdn_addr);
+    clear_protocol_configuration_options (&pending_p->pco);
+    // DO NOT FREE proc_data, IT IS esm_proc_data_t*
+    slab_pool_free (mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool, (void**) &ue_context_p->pending_pdn_connectivity_req);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_is_embedded_bearer_used (const ue_context_t * const ue_context_p)
+{
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if (ue_context_p->eps_bearers[i] == &ue_context_p->embedded_bearer) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bearer_context_t *mme_app_get_bearer_context (ue_context_t * const ue_context_p, const ebi_t ebi)
+{
+  if (ebi >= BEARERS_PER_UE) {
+    return NULL;
+  }
+  if (!ue_context_p->eps_bearers[ebi]) {
+    if (!mme_app_is_embedded_bearer_used (ue_context_p)) {
+      memset (&ue_context_p->embedded_bearer, 0, sizeof (bearer_context_t));
+      ue_context_p->eps_bearers[ebi] = &ue_context_p->embedded_bearer;
+    } else {
+      ue_context_p->eps_bearers[ebi] = slab_pool_alloc (mme_app_desc.mme_ue_contexts.bearer_context_pool);
+    }
+  }
+  return ue_context_p->eps_bearers[ebi];
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_ue_context_free_extensions (ue_context_t * const ue_context_p)
+{
+  slab_pool_free (mme_app_desc.mme_ue_contexts.subscription_pool, (void**) &ue_context_p->subscription);
+  mme_app_free_pending_pdn_connectivity_req (ue_context_p);
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if (ue_context_p->eps_bearers[i] == &ue_context_p->embedded_bearer) {
+      ue_context_p->eps_bearers[i] = NULL;
+    } else {
+      slab_pool_free (mme_app_desc.mme_ue_contexts.bearer_context_pool, (void**) &ue_context_p->eps_bearers[i]);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_ue_context_memory_report (bstring str)
+{
+  mme_ue_context_t                       *mme_ue_context_p = &mme_app_desc.mme_ue_contexts;
+  slab_pool_stats_t                       ue_context_stats = {0};
+  slab_pool_stats_t                       subscription_stats = {0};
+  slab_pool_stats_t                       pending_stats = {0};
+  slab_pool_stats_t                       bearer_stats = {0};
+  uint64_t                                bytes_in_use = 0;
+
+  slab_pool_get_stats (mme_ue_context_p->ue_context_pool, &ue_context_stats);
+  slab_pool_get_stats (mme_ue_context_p->subscription_pool, &subscription_stats);
+  slab_pool_get_stats (mme_ue_context_p->pending_pdn_connectivity_req_pool, &pending_stats);
+  slab_pool_get_stats (mme_ue_context_p->bearer_context_pool, &bearer_stats);
+  bytes_in_use = ue_context_stats.nb_in_use * ue_context_stats.object_size + subscription_stats.nb_in_use * subscription_stats.object_size +
+                 pending_stats.nb_in_use * pending_stats.object_size + bearer_stats.nb_in_use * bearer_stats.object_size;
+  bformata (str, "UE context core          %6zu B x %10" PRIu64 "\n", ue_context_stats.object_size, ue_context_stats.nb_in_use);
+  bformata (str, "Subscription data        %6zu B x %10" PRIu64 "\n", subscription_stats.object_size, subscription_stats.nb_in_use);
+  bformata (str, "Pending PDN conn. req.   %6zu B x %10" PRIu64 "\n", pending_stats.object_size, pending_stats.nb_in_use);
+  bformata (str, "Dedicated bearer ctxts   %6zu B x %10" PRIu64 "\n", bearer_stats.object_size, bearer_stats.nb_in_use);
+  bformata (str, "Memory per UE            %6" PRIu64 " B (all extensions allocated: %zu B)\n",
+      (ue_context_stats.nb_in_use) ? bytes_in_use / ue_context_stats.nb_in_use : 0,
+      ue_context_stats.object_size + subscription_stats.object_size + pending_stats.object_size + (BEARERS_PER_UE - 1) * bearer_stats.object_size);
+}
+
 //------------------------------------------------------------------------------
 void mme_app_ue_context_free_content (ue_context_t * const ue_context_p)
 {
@@ -80,29 +186,18 @@ void mme_app_ue_context_free_content (ue_context_t * const ue_context_p)
   //  eutran_vector_t       *vector_list;
   //  eutran_vector_t       *vector_in_use;
   //  unsigned               subscription_known:1;
-  //  uint8_t                msisdn[MSISDN_LENGTH+1];
-  //  uint8_t                msisdn_length;
   //  mm_state_t             mm_state;
   //  guti_t                 guti;
   //  me_identity_t          me_identity;
   //  ecgi_t                  e_utran_cgi;
   //  time_t                 cell_age;
-  //  network_access_mode_t  access_mode;
-  //  apn_config_profile_t   apn_profile;
-  //  ard_t                  access_restriction_data;
-  //  subscriber_status_t    sub_status;
-  //  ambr_t                 subscribed_ambr;
   //  ambr_t                 used_ambr;
-  //  rau_tau_timer_t        rau_tau_timer;
   // int                    ue_radio_cap_length;
   // teid_t                 mme_s11_teid;
   // teid_t                 sgw_s11_teid;
   // PAA_t                  paa;
-  // char                   pending_pdn_connectivity_req_imsi[16];
-  // uint8_t                pending_pdn_connectivity_req_imsi_length;
   DevAssert(ue_context_p != NULL);
-  bdestroy(ue_context_p->pending_pdn_connectivity_req_apn);
-  bdestroy(ue_context_p->pending_pdn_connectivity_req_pdn_addr);
+  mme_app_ue_context_free_extensions (ue_context_p);
   
   // Stop Mobile reachability timer,if running 
   if (ue_context_p->mobile_reachability_timer.id != MME_APP_TIMER_INACTIVE_ID) {
@@ -126,6 +221,8 @@ void mme_app_ue_context_free_content (ue_context_t * const ue_context_p)
     } 
     ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
   }
+  // Stop paging,if in progress
+  mme_app_paging_stop (ue_context_p);
   if (ue_context_p->ue_radio_capabilities) {
     free_wrapper((void**) &(ue_context_p->ue_radio_capabilities));
   }
@@ -134,17 +231,7 @@ void mme_app_ue_context_free_content (ue_context_t * const ue_context_p)
 
   ue_context_p->ue_context_rel_cause = S1AP_INVALID_CAUSE;
 
-
-  // int                    pending_pdn_connectivity_req_pti;
-  // unsigned               pending_pdn_connectivity_req_ue_id;
-  // network_qos_t          pending_pdn_connectivity_req_qos;
-  // pco_flat_t             pending_pdn_connectivity_req_pco;
-  // DO NOT FREE THE FOLLOWING POINTER, IT IS esm_proc_data_t*
-  // void                  *pending_pdn_connectivity_req_proc_data;
-  //int                    pending_pdn_connectivity_req_request_type;
   //ebi_t                  default_bearer_id;
-  //bearer_context_t       eps_bearers[BEARERS_PER_UE];
-
 }
 
 //------------------------------------------------------------------------------
@@ -241,8 +328,6 @@ void mme_app_move_context (ue_context_t *dst, ue_context_t *src)
     //mme_ue_s1ap_id
     dst->sctp_assoc_id_key       = src->sctp_assoc_id_key;
     dst->subscription_known      = src->subscription_known;
-    memcpy((void *)dst->msisdn, (const void *)src->msisdn, sizeof(src->msisdn));
-    dst->msisdn_length           = src->msisdn_length;src->msisdn_length = 0;
     dst->mm_state                = src->mm_state;
     dst->ecm_state               = src->ecm_state;
     dst->is_guti_set             = src->is_guti_set;
@@ -250,31 +335,25 @@ void mme_app_move_context (ue_context_t *dst, ue_context_t *src)
     dst->me_identity             = src->me_identity;
     dst->e_utran_cgi             = src->e_utran_cgi;
     dst->cell_age                = src->cell_age;
-    dst->access_mode             = src->access_mode;
-    dst->apn_profile             = src->apn_profile;
-    dst->access_restriction_data = src->access_restriction_data;
-    dst->sub_status              = src->sub_status;
-    dst->subscribed_ambr         = src->subscribed_ambr;
     dst->used_ambr               = src->used_ambr;
-    dst->rau_tau_timer           = src->rau_tau_timer;
     dst->mme_s11_teid            = src->mme_s11_teid;
     dst->sgw_s11_teid            = src->sgw_s11_teid;
-    memcpy((void *)dst->pending_pdn_connectivity_req_imsi, (const void *)src->pending_pdn_connectivity_req_imsi, sizeof(src->pending_pdn_connectivity_req_imsi));
-    dst->pending_pdn_connectivity_req_imsi_length = src->pending_pdn_connectivity_req_imsi_length;
-    dst->pending_pdn_connectivity_req_apn         = src->pending_pdn_connectivity_req_apn;
-    src->pending_pdn_connectivity_req_apn         = NULL;
-
-    dst->pending_pdn_connectivity_req_pdn_addr    = src->pending_pdn_connectivity_req_pdn_addr;
-    src->pending_pdn_connectivity_req_pdn_addr    = NULL;
-    dst->pending_pdn_connectivity_req_pti         = src->pending_pdn_connectivity_req_pti;
-    dst->pending_pdn_connectivity_req_ue_id       = src->pending_pdn_connectivity_req_ue_id;
-    dst->pending_pdn_connectivity_req_qos         = src->pending_pdn_connectivity_req_qos;
-    dst->pending_pdn_connectivity_req_pco         = src->pending_pdn_connectivity_req_pco;
-    dst->pending_pdn_connectivity_req_proc_data   = src->pending_pdn_connectivity_req_proc_data;
-    src->pending_pdn_connectivity_req_proc_data   = NULL;
-    dst->pending_pdn_connectivity_req_request_type= src->pending_pdn_connectivity_req_request_type;
     dst->default_bearer_id       = src->default_bearer_id;
-    memcpy((void *)dst->eps_bearers, (const void *)src->eps_bearers, sizeof(bearer_context_t)*BEARERS_PER_UE);
+    // cold extensions change hands, whatever dst had is released
+    mme_app_ue_context_free_extensions (dst);
+    dst->subscription                 = src->subscription;
+    src->subscription                 = NULL;
+    dst->pending_pdn_connectivity_req = src->pending_pdn_connectivity_req;
+    src->pending_pdn_connectivity_req = NULL;
+    for (int i = 0; i < BEARERS_PER_UE; i++) {
+      if (src->eps_bearers[i] == &src->embedded_bearer) {
+        memcpy((void *)&dst->embedded_bearer, (const void *)&src->embedded_bearer, sizeof(bearer_context_t));
+        dst->eps_bearers[i] = &dst->embedded_bearer;
+      } else {
+        dst->eps_bearers[i] = src->eps_bearers[i];
+      }
+      src->eps_bearers[i] = NULL;
+    }
     OAILOG_DEBUG (LOG_MME_APP,
            "mme_app_move_context("ENB_UE_S1AP_ID_FMT " <- " ENB_UE_S1AP_ID_FMT ") done\n",
            dst->enb_ue_s1ap_id, src->enb_ue_s1ap_id);
@@ -716,8 +795,11 @@ void mme_remove_ue_context (
           ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id);
   }
 
+  itti_trace_end (ue_context_p->trace_id);
+  mme_app_eviction_ue_forget (ue_context_p);
+  mme_app_checkpoint_ue_forget (ue_context_p);
   mme_app_ue_context_free_content(ue_context_p);
-  free_wrapper ((void**) &ue_context_p);
+  slab_pool_free (mme_ue_context_p->ue_context_pool, (void**) &ue_context_p);
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 //-------------------------------------------------------------------------------------------------------
@@ -730,6 +812,7 @@ void mme_ue_context_update_ue_sig_connection_state (
   // Function is used to update UE's Signaling Connection State 
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
   unsigned int                           *id = NULL;
+  MessageDef                             *message_p = NULL;
 
   OAILOG_FUNC_IN (LOG_MME_APP);
   DevAssert (mme_ue_context_p);
@@ -743,12 +826,16 @@ void mme_ue_context_update_ue_sig_connection_state (
                                   ue_context_p->enb_s1ap_id_key, ue_context_p->mme_ue_s1ap_id);
     }
     ue_context_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
+    // a signalling connection which was not a service request (TAU without active flag) ends here
+    ue_context_p->service_request_start_ns = 0;
+    itti_trace_end (ue_context_p->trace_id);
+    ue_context_p->trace_id = ITTI_TRACE_ID_NONE;
 
     OAILOG_DEBUG (LOG_MME_APP, "MME_APP: UE Connection State changed to IDLE. mme_ue_s1ap_id = %d\n", ue_context_p->mme_ue_s1ap_id);
     
     if (mme_config.nas_config.t3412_min > 0) {
       // Start Mobile reachability timer only if peroidic TAU timer is not disabled 
-      if (timer_setup (ue_context_p->mobile_reachability_timer.sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->mobile_reachability_timer.id)) < 0) {
+      if (timer_setup (ue_context_p->mobile_reachability_timer.sec, 0, mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->mobile_reachability_timer.id)) < 0) {
         OAILOG_ERROR (LOG_MME_APP, "Failed to start Mobile Reachability timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
         ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
       } else {
@@ -760,6 +847,14 @@ void mme_ue_context_update_ue_sig_connection_state (
       // Update Stats
       update_mme_app_stats_connected_ue_sub();
     }
+    mme_app_eviction_ue_idle (ue_context_p);
+    mme_app_checkpoint_ue_idle (ue_context_p);
+    // NAS keeps the EMM context of a UE with a signalling connection when told to evict or detach it in ECM-IDLE
+    if (INVALID_MME_UE_S1AP_ID != ue_context_p->mme_ue_s1ap_id) {
+      message_p = itti_alloc_new_message (TASK_MME_APP, NAS_CONNECTION_RELEASE_IND);
+      NAS_CONNECTION_RELEASE_IND (message_p).ue_id = ue_context_p->mme_ue_s1ap_id;
+      itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+    }
 
   }else if ((ue_context_p->ecm_state == ECM_IDLE) && (new_ecm_state == ECM_CONNECTED))
   {
@@ -784,6 +879,10 @@ void mme_ue_context_update_ue_sig_connection_state (
       } 
       ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
     }
+    // Stop paging,if in progress
+    mme_app_paging_stop (ue_context_p);
+    mme_app_eviction_ue_forget (ue_context_p);
+    mme_app_checkpoint_ue_forget (ue_context_p);
     // Update Stats
     update_mme_app_stats_connected_ue_add();
   }
@@ -832,34 +931,36 @@ mme_app_dump_ue_context (
     /*
      * Display UE info only if we know them
      */
-    if (SUBSCRIPTION_KNOWN == context_p->subscription_known) {
-      OAILOG_DEBUG (LOG_MME_APP, "    - Status .........: %s\n", (context_p->sub_status == SS_SERVICE_GRANTED) ? "Granted" : "Barred");
+    if ((SUBSCRIPTION_KNOWN == context_p->subscription_known) && (context_p->subscription)) {
+      const ue_subscription_t                *const subscription_p = context_p->subscription;
+
+      OAILOG_DEBUG (LOG_MME_APP, "    - Status .........: %s\n", (subscription_p->sub_status == SS_SERVICE_GRANTED) ? "Granted" : "Barred");
 #define DISPLAY_BIT_MASK_PRESENT(mASK)   \
-    ((context_p->access_restriction_data & mASK) ? 'X' : 'O')
+    ((subscription_p->access_restriction_data & mASK) ? 'X' : 'O')
       OAILOG_DEBUG (LOG_MME_APP, "    (O = allowed, X = !O) |UTRAN|GERAN|GAN|HSDPA EVO|E_UTRAN|HO TO NO 3GPP|\n");
       OAILOG_DEBUG (LOG_MME_APP,
           "    - Access restriction  |  %c  |  %c  | %c |    %c    |   %c   |      %c      |\n",
           DISPLAY_BIT_MASK_PRESENT (ARD_UTRAN_NOT_ALLOWED),
           DISPLAY_BIT_MASK_PRESENT (ARD_GERAN_NOT_ALLOWED),
           DISPLAY_BIT_MASK_PRESENT (ARD_GAN_NOT_ALLOWED), DISPLAY_BIT_MASK_PRESENT (ARD_I_HSDPA_EVO_NOT_ALLOWED), DISPLAY_BIT_MASK_PRESENT (ARD_E_UTRAN_NOT_ALLOWED), DISPLAY_BIT_MASK_PRESENT (ARD_HO_TO_NON_3GPP_NOT_ALLOWED));
-      OAILOG_DEBUG (LOG_MME_APP, "    - Access Mode ....: %s\n", ACCESS_MODE_TO_STRING (context_p->access_mode));
-      OAILOG_DEBUG (LOG_MME_APP, "    - MSISDN .........: %-*s\n", MSISDN_LENGTH, context_p->msisdn);
-      OAILOG_DEBUG (LOG_MME_APP, "    - RAU/TAU timer ..: %u\n", context_p->rau_tau_timer);
+      OAILOG_DEBUG (LOG_MME_APP, "    - Access Mode ....: %s\n", ACCESS_MODE_TO_STRING (subscription_p->access_mode));
+      OAILOG_DEBUG (LOG_MME_APP, "    - MSISDN .........: %-*s\n", MSISDN_LENGTH, subscription_p->msisdn);
+      OAILOG_DEBUG (LOG_MME_APP, "    - RAU/TAU timer ..: %u\n", subscription_p->rau_tau_timer);
       OAILOG_DEBUG (LOG_MME_APP, "    - IMEISV .........: %*s\n", IMEISV_DIGITS_MAX, context_p->me_identity.imeisv);
       OAILOG_DEBUG (LOG_MME_APP, "    - AMBR (bits/s)     ( Downlink |  Uplink  )\n");
-      OAILOG_DEBUG (LOG_MME_APP, "        Subscribed ...: (%010" PRIu64 "|%010" PRIu64 ")\n", context_p->subscribed_ambr.br_dl, context_p->subscribed_ambr.br_ul);
+      OAILOG_DEBUG (LOG_MME_APP, "        Subscribed ...: (%010" PRIu64 "|%010" PRIu64 ")\n", subscription_p->subscribed_ambr.br_dl, subscription_p->subscribed_ambr.br_ul);
       OAILOG_DEBUG (LOG_MME_APP, "        Allocated ....: (%010" PRIu64 "|%010" PRIu64 ")\n", context_p->used_ambr.br_dl, context_p->used_ambr.br_ul);
 
       OAILOG_DEBUG (LOG_MME_APP, "    - PDN List:\n");
 
-      for (j = 0; j < context_p->apn_profile.nb_apns; j++) {
-        struct apn_configuration_s             *apn_config_p;
+      for (j = 0; j < subscription_p->apn_profile.nb_apns; j++) {
+        const struct apn_configuration_s       *apn_config_p;
 
-        apn_config_p = &context_p->apn_profile.apn_configuration[j];
+        apn_config_p = &subscription_p->apn_profile.apn_configuration[j];
         /*
          * Default APN ?
          */
-        OAILOG_DEBUG (LOG_MME_APP, "        - Default APN ...: %s\n", (apn_config_p->context_identifier == context_p->apn_profile.context_identifier)
+        OAILOG_DEBUG (LOG_MME_APP, "        - Default APN ...: %s\n", (apn_config_p->context_identifier == subscription_p->apn_profile.context_identifier)
                      ? "TRUE" : "FALSE");
         OAILOG_DEBUG (LOG_MME_APP, "        - APN ...........: %s\n", apn_config_p->service_selection);
         OAILOG_DEBUG (LOG_MME_APP, "        - AMBR (bits/s) ( Downlink |  Uplink  )\n");
@@ -896,9 +997,9 @@ mme_app_dump_ue_context (
       for (j = 0; j < BEARERS_PER_UE; j++) {
         bearer_context_t                       *bearer_context_p;
 
-        bearer_context_p = &context_p->eps_bearers[j];
+        bearer_context_p = context_p->eps_bearers[j];
 
-        if (bearer_context_p->s_gw_teid != 0) {
+        if ((bearer_context_p) && (bearer_context_p->s_gw_teid != 0)) {
           OAILOG_DEBUG (LOG_MME_APP, "        Bearer id .......: %02u\n", j);
           OAILOG_DEBUG (LOG_MME_APP, "        S-GW TEID (UP)...: %08x\n", bearer_context_p->s_gw_teid);
           OAILOG_DEBUG (LOG_MME_APP, "        P-GW TEID (UP)...: %08x\n", bearer_context_p->p_gw_teid);
@@ -938,15 +1039,73 @@ mme_app_handle_s1ap_ue_context_release_req (
                                           S1AP_RADIO_EUTRAN_GENERATED_REASON);
 }
 
+//------------------------------------------------------------------------------
+/*
+ * eNB wide releases are received by the first shard, the UEs owned by the
+ * other shards are forwarded to them batched in S1AP_ENB_DEREGISTERED_IND.
+ * Returns false if the UE has to be released by the current shard.
+ */
+static bool
+_mme_app_forward_ue_release (
+  MessageDef ** const forward_messages,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+  const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+  const uint32_t enb_id)
+{
+  MessageDef                            **message_pp = NULL;
+  int                                     shard = 0;
+  int                                     i = 0;
+
+  if ((INVALID_MME_UE_S1AP_ID == mme_ue_s1ap_id) || (mme_app_is_ue_id_in_current_shard (mme_ue_s1ap_id))) {
+    return false;
+  }
+  shard = mme_app_shard_of_ue_id (mme_ue_s1ap_id);
+  message_pp = &forward_messages[shard];
+  if (!*message_pp) {
+    *message_pp = itti_alloc_new_message (TASK_MME_APP, S1AP_ENB_DEREGISTERED_IND);
+    DevAssert (*message_pp != NULL);
+    memset ((void *)&S1AP_ENB_DEREGISTERED_IND (*message_pp), 0, sizeof (itti_s1ap_eNB_deregistered_ind_t));
+    S1AP_ENB_DEREGISTERED_IND (*message_pp).enb_id = enb_id;
+  }
+  i = S1AP_ENB_DEREGISTERED_IND (*message_pp).nb_ue_to_deregister++;
+  S1AP_ENB_DEREGISTERED_IND (*message_pp).mme_ue_s1ap_id[i] = mme_ue_s1ap_id;
+  S1AP_ENB_DEREGISTERED_IND (*message_pp).enb_ue_s1ap_id[i] = enb_ue_s1ap_id;
+  if (S1AP_ITTI_UE_PER_DEREGISTER_MESSAGE == S1AP_ENB_DEREGISTERED_IND (*message_pp).nb_ue_to_deregister) {
+    itti_send_msg_to_task (mme_app_shard_tasks[shard], INSTANCE_DEFAULT, *message_pp);
+    *message_pp = NULL;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void
+_mme_app_flush_forwarded_ue_releases (
+  MessageDef ** const forward_messages)
+{
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    if (forward_messages[shard]) {
+      itti_send_msg_to_task (mme_app_shard_tasks[shard], INSTANCE_DEFAULT, forward_messages[shard]);
+      forward_messages[shard] = NULL;
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 void
 mme_app_handle_enb_deregister_ind(const itti_s1ap_eNB_deregistered_ind_t const * eNB_deregistered_ind) {
+  MessageDef                             *forward_messages[MME_APP_MAX_WORKERS] = {NULL};
+
   for (int i = 0; i < eNB_deregistered_ind->nb_ue_to_deregister; i++) {
+    if (_mme_app_forward_ue_release (forward_messages, eNB_deregistered_ind->mme_ue_s1ap_id[i],
+                                     eNB_deregistered_ind->enb_ue_s1ap_id[i], eNB_deregistered_ind->enb_id)) {
+      continue;
+    }
     _mme_app_handle_s1ap_ue_context_release(eNB_deregistered_ind->mme_ue_s1ap_id[i],
                                             eNB_deregistered_ind->enb_ue_s1ap_id[i],
                                             eNB_deregistered_ind->enb_id,
                                             S1AP_SCTP_SHUTDOWN_OR_RESET);
   }
+  _mme_app_flush_forwarded_ue_releases (forward_messages);
 } 
 
 //------------------------------------------------------------------------------
@@ -955,11 +1114,16 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t const *
 { 
   
   MessageDef *message_p;
+  MessageDef *forward_messages[MME_APP_MAX_WORKERS] = {NULL};
   OAILOG_DEBUG (LOG_MME_APP, " eNB Reset request received. eNB id = %d, reset_type  %d \n ", enb_reset_req->enb_id, enb_reset_req->s1ap_reset_type); 
   DevAssert (enb_reset_req->ue_to_reset_list != NULL);
   if (enb_reset_req->s1ap_reset_type == RESET_ALL) {
   // Full Reset. Trigger UE Context release release for all the connected UEs.
     for (int i = 0; i < enb_reset_req->num_ue; i++) {
+      if (_mme_app_forward_ue_release (forward_messages, *(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
+                                       *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id), enb_reset_req->enb_id)) {
+        continue;
+      }
       _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
                                             *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
                                             enb_reset_req->enb_id, 
@@ -971,6 +1135,10 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t const *
       if (enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id == NULL && 
                           enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id == NULL) 
         continue;
+      else if ((enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id) && (enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id) &&
+               (_mme_app_forward_ue_release (forward_messages, *(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
+                                             *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id), enb_reset_req->enb_id)))
+        continue;
       else 
         _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
                                             *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
@@ -979,6 +1147,7 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t const *
     } 
       
   }
+  _mme_app_flush_forwarded_ue_releases (forward_messages);
   // Send Reset Ack to S1AP module
 
   message_p = itti_alloc_new_message (TASK_MME_APP, S1AP_ENB_INITIATED_RESET_ACK);
@@ -1146,7 +1315,8 @@ _mme_app_handle_s1ap_ue_context_release (const mme_ue_s1ap_id_t mme_ue_s1ap_id,
     message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IMPLICIT_DETACH_UE_IND);
     DevAssert (message_p != NULL);
     message_p->ittiMsg.nas_implicit_detach_ue_ind.ue_id = ue_context_p->mme_ue_s1ap_id;
-    itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+    message_p->ittiMsg.nas_implicit_detach_ue_ind.is_idle = false;
+    itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   } else {
     // release S1-U tunnel mapping in S_GW for all the active bearers for the UE
     mme_app_send_s11_release_access_bearers_req (ue_context_p);
@@ -41,31 +41,8 @@ typedef struct {
   
   /* Reader/writer lock */
   pthread_rwlock_t rw_lock;
-  
-  /* ***************Statistics*************
-   * number of attached UE,number of connected UE,
-   * number of idle UE,number of default bearers, 
-   * number of S1_U bearers,number of PDN sessions
-   */ 
-  
-  uint32_t               nb_enb_connected;
-  uint32_t               nb_ue_attached;
-  uint32_t               nb_ue_connected;
-  uint32_t               nb_default_eps_bearers;
-  uint32_t               nb_s1u_bearers;
-  
-  /* ***************Changes in Statistics**************/
-
-  uint32_t               nb_ue_attached_since_last_stat;
-  uint32_t               nb_ue_detached_since_last_stat;
-  uint32_t               nb_ue_connected_since_last_stat;
-  uint32_t               nb_ue_disconnected_since_last_stat;
-  uint32_t               nb_eps_bearers_established_since_last_stat;
-  uint32_t               nb_eps_bearers_released_since_last_stat;
-  uint32_t               nb_enb_connected_since_last_stat;
-  uint32_t               nb_enb_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_established_since_last_stat;
+
+  /* Statistics are kept in metrics, see mme_app_statistics.c */
 } mme_app_desc_t;
 
 extern mme_app_desc_t mme_app_desc;
@@ -134,14 +111,71 @@ void mme_app_handle_initial_context_setup_rsp_timer_expiry (struct ue_context_s
 
 void mme_app_handle_enb_reset_req( const itti_s1ap_enb_initiated_reset_req_t const * enb_reset_req);
 
+// paging, see mme_app_paging.c
+void mme_app_paging_init (void);
+
+void mme_app_handle_downlink_data_notification (const itti_s11_downlink_data_notification_t * const notif_pP);
+
+void mme_app_handle_paging_timer_expiry (struct ue_context_s *ue_context_p);
+
+void mme_app_handle_s1ap_ue_tai_ind (const itti_s1ap_ue_tai_ind_t * const ue_tai_ind_pP);
+
+void mme_app_paging_stop (struct ue_context_s *ue_context_p);
+
+// eviction of the UEs in ECM-IDLE, see mme_app_eviction.c
+int  mme_app_eviction_init (void);
+
+void mme_app_eviction_exit (void);
+
+// eviction timer of the MME_APP task of the calling thread, MME_APP_TIMER_INACTIVE_ID if the eviction is disabled
+long mme_app_eviction_timer_id (void);
+
+void mme_app_eviction_timer_expiry (void);
+
+void mme_app_eviction_ue_idle (struct ue_context_s * const ue_context_p);
+
+void mme_app_eviction_ue_forget (struct ue_context_s * const ue_context_p);
+
+void mme_app_eviction_handle_ue_record_rsp (itti_nas_ue_record_t * const ue_record_rsp_p);
+
+// context of an evicted UE rebuilt in ECM-IDLE, NULL if the UE was not evicted by the task of the calling thread
+struct ue_context_s *mme_app_eviction_restore_ue_by_guti (const guti_t * const guti);
+
+struct ue_context_s *mme_app_eviction_restore_ue_by_s11_teid (const teid_t teid);
+
+// identifiers of the evicted UEs, not allocated again
+bool mme_app_eviction_is_m_tmsi_used (const tmsi_t m_tmsi);
+
+bool mme_app_eviction_is_s11_teid_used (const teid_t teid);
+
+void mme_app_eviction_report (bstring str);
+
+void mme_app_eviction_dump_prometheus (bstring out);
+
+// checkpoint of the registered UEs in ECM-IDLE and restore at startup, see mme_app_checkpoint.c
+int  mme_app_checkpoint_init (void);
+
+void mme_app_checkpoint_exit (void);
+
+// checkpoint timer of the MME_APP task of the calling thread, MME_APP_TIMER_INACTIVE_ID if the checkpoint is disabled
+long mme_app_checkpoint_timer_id (void);
+
+void mme_app_checkpoint_timer_expiry (void);
+
+void mme_app_checkpoint_ue_idle (struct ue_context_s * const ue_context_p);
+
+void mme_app_checkpoint_ue_forget (struct ue_context_s * const ue_context_p);
+
+void mme_app_checkpoint_handle_ue_record_rsp (itti_nas_ue_record_t * const ue_record_rsp_p);
+
+void mme_app_checkpoint_report (bstring str);
+
+void mme_app_checkpoint_dump_prometheus (bstring out);
+
 // handover messaging
 void mme_app_handle_path_switch_req(
      const itti_mme_app_path_switch_req_t * const path_switch_req_pP
     );
 
 
-#define mme_stats_read_lock(mMEsTATS)  pthread_rwlock_rdlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_write_lock(mMEsTATS) pthread_rwlock_wrlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_unlock(mMEsTATS)     pthread_rwlock_unlock(&(mMEsTATS)->rw_lock)
-
 #endif /* MME_APP_DEFS_H_ */
@@ -38,6 +38,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_itti_messaging.h"
 #include "mme_app_defs.h"
+#include "mme_app_shard.h"
 
 //------------------------------------------------------------------------------
 void
@@ -53,22 +54,16 @@ mme_app_send_delete_session_request (
   S11_DELETE_SESSION_REQUEST (message_p).teid = ue_context_p->sgw_s11_teid;
   S11_DELETE_SESSION_REQUEST (message_p).lbi = ue_context_p->default_bearer_id;
 
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = (teid_t) ue_context_p;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = mme_app_shard_tag ((teid_t)(uintptr_t) ue_context_p, ue_context_p->mme_ue_s1ap_id);
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
-  mme_config_read_lock (&mme_config);
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.ipv4_address = mme_config.ipv4.s11;
-  mme_config_unlock (&mme_config);
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.ipv4 = 1;
 
   /*
    * S11 stack specific parameter. Not used in standalone epc mode
    */
   S11_DELETE_SESSION_REQUEST  (message_p).trxn = NULL;
-  mme_config_read_lock (&mme_config);
   S11_DELETE_SESSION_REQUEST (message_p).peer_ip = mme_config.ipv4.sgw_s11;
-  mme_config_unlock (&mme_config);
 
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME,
                       NULL, 0, "0  S11_DELETE_SESSION_REQUEST teid %u lbi %u",
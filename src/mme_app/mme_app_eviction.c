@@ -0,0 +1,657 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_eviction.c
+  \brief Eviction of the UE contexts in ECM-IDLE, least recently idle first,
+  when the UE contexts take more memory than the configured budget or after an
+  idle timeout. An evicted UE is kept as a compact record and restored when it
+  comes back, it is detached on expiry of its implicit detach deadline. The UEs
+  are detached instead of evicted when the records are full.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "assertions.h"
+#include "log.h"
+#include "msc.h"
+#include "metrics.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_cold_store.h"
+#include "mme_app_checkpoint_file.h"
+#include "mme_config.h"
+#include "emmData.h"
+#include "mme_app_shard.h"
+#include "hashtable.h"
+#include "timer.h"
+
+/*
+ * Every MME_APP task lists the UEs of its shard in ECM-IDLE in the order they
+ * entered ECM-IDLE. On its eviction timer, the task takes from the head of its
+ * list the UEs idle for longer than the idle timeout and, while the UE
+ * contexts exceed the memory budget, its share of the UEs to evict to get back
+ * to the low watermark, batch UEs at most.
+ *
+ * An evicted UE stays registered: the task fills the MME_APP part of its
+ * checkpoint record (mme_app_checkpoint.c) and sends it to the NAS task of the
+ * UE, which adds the EMM and ESM parts. When the record comes back and the UE
+ * is still in ECM-IDLE, the record is packed (zero runs take most of it) and
+ * kept by the task, indexed by the M-TMSI and the S11 TEID of the UE, and
+ * written in the checkpoint file if enabled. The MME_APP context is removed,
+ * NAS releases the EMM and ESM contexts on NAS_UE_EVICT_IND unless the UE
+ * established a signalling connection since. The S11 session is kept.
+ *
+ * The UE is restored, in ECM-IDLE, by its next initial UE message with its
+ * S-TMSI (SERVICE REQUEST, TAU) and by a DOWNLINK DATA NOTIFICATION, which
+ * pages it as usual: MME_APP rebuilds its context and hands the record to NAS
+ * in a NAS_UE_RESTORE_IND, ahead of the NAS message of the UE. The security
+ * context is restored as from the checkpoint file: no NAS message is sent to
+ * the UE while it is evicted, so its NAS COUNTs are the last ones used. An
+ * evicted UE which does not come back is restored and implicitly detached
+ * when its implicit detach timer would have expired (its mobile reachability
+ * and implicit detach timers from the time it entered ECM-IDLE), after
+ * MME_APP_EVICTION_EXPIRY_SEC if the periodic TAU timer is disabled. The
+ * M-TMSI and the S11 TEID of an evicted UE are not allocated again.
+ *
+ * The records count in the memory budget. Every task keeps its share of
+ * max_evicted_ues records at most, and of the low watermark of the budget in
+ * records: over it, the UEs to evict are implicitly detached instead, their
+ * GUTI kept with their IMSI in the cold store.
+ */
+#define MME_APP_EVICTION_LOW_WATERMARK_PERCENT  90
+#define MME_APP_EVICTION_EXPIRY_SEC             (24 * 3600)
+#define MME_APP_EVICTION_MAX_RECORD_BYTES       (sizeof (mme_app_checkpoint_record_t) + sizeof (mme_app_checkpoint_record_t) / 128 + 1)
+
+TAILQ_HEAD (mme_app_idle_list_s, ue_context_s);
+
+typedef struct mme_app_evicted_ue_s {
+  TAILQ_ENTRY (mme_app_evicted_ue_s)      entries;        // in the expiry list of the shard
+  uint64_t                                deadline_ns;    // metrics_now_ns of its implicit detach
+  mme_ue_s1ap_id_t                        ue_id;
+  guti_t                                  guti;
+  teid_t                                  mme_s11_teid;
+  uint32_t                                checkpoint_slot;
+  uint32_t                                length;
+  uint8_t                                 data[];         // mme_app_checkpoint_record_pack
+} mme_app_evicted_ue_t;
+
+TAILQ_HEAD (mme_app_evicted_list_s, mme_app_evicted_ue_s);
+
+static struct {
+  bool                                    enabled;
+  uint64_t                                memory_budget_bytes;    // 0 for no budget
+  uint64_t                                idle_timeout_ns;        // 0 for no timeout
+  uint32_t                                period_ms;
+  uint32_t                                batch;
+  uint64_t                                max_evicted_per_shard;
+  // evicted UEs of all the shards, only the task of the shard of an UE inserts, gets and removes it
+  hash_table_ts_t                        *m_tmsi_htbl;
+  hash_table_ts_t                        *s11_teid_htbl;
+  metric_id_t                             evicted_budget_metric;
+  metric_id_t                             evicted_timeout_metric;
+  metric_id_t                             stored_metric;
+  metric_id_t                             stored_bytes_metric;
+  metric_id_t                             restored_metric;
+  metric_id_t                             expired_metric;
+  metric_id_t                             detached_metric;
+} mme_app_eviction = {
+  .evicted_budget_metric = METRIC_ID_INVALID,
+  .evicted_timeout_metric = METRIC_ID_INVALID,
+  .stored_metric = METRIC_ID_INVALID,
+  .stored_bytes_metric = METRIC_ID_INVALID,
+  .restored_metric = METRIC_ID_INVALID,
+  .expired_metric = METRIC_ID_INVALID,
+  .detached_metric = METRIC_ID_INVALID,
+};
+
+// Only the task of the shard updates its lists
+static struct {
+  struct mme_app_idle_list_s              idle_list;
+  uint64_t                                nb_idle;
+  struct mme_app_evicted_list_s           expiry_list;    // earliest deadline first
+  uint64_t                                nb_evicted;
+  uint64_t                                evicted_bytes;
+  long                                    timer_id;
+  uint8_t                                 pack_buffer[MME_APP_EVICTION_MAX_RECORD_BYTES];
+} mme_app_eviction_shards[MME_APP_MAX_WORKERS];
+
+//------------------------------------------------------------------------------
+// Memory of an evicted UE: its entry and its nodes in the two tables
+static uint64_t mme_app_eviction_entry_bytes (const mme_app_evicted_ue_t * const entry)
+{
+  return offsetof (mme_app_evicted_ue_t, data) + entry->length + 2 * sizeof (hash_node_t);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Memory of the UE contexts in use: MME_APP contexts and their extensions, EMM
+ * contexts and records of the evicted UEs, the latter in evicted_bytes.
+ */
+static uint64_t mme_app_eviction_memory_in_use (uint64_t * const nb_contexts, uint64_t * const evicted_bytes)
+{
+  slab_pool_t                            *pools[] = {mme_app_desc.mme_ue_contexts.ue_context_pool, mme_app_desc.mme_ue_contexts.subscription_pool,
+                                                     mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool,
+                                                     mme_app_desc.mme_ue_contexts.bearer_context_pool, _emm_data.ctx_pool};
+  slab_pool_stats_t                       stats = {0};
+  uint64_t                                bytes = 0;
+
+  for (int i = 0; i < sizeof (pools) / sizeof (pools[0]); i++) {
+    if (pools[i]) {
+      slab_pool_get_stats (pools[i], &stats);
+      bytes += stats.nb_in_use * stats.object_size;
+      if (0 == i) {
+        *nb_contexts = stats.nb_in_use;
+      }
+    }
+  }
+  *evicted_bytes = 0;
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    *evicted_bytes += __atomic_load_n (&mme_app_eviction_shards[shard].evicted_bytes, __ATOMIC_RELAXED);
+  }
+  return bytes + *evicted_bytes;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_eviction_init (void)
+{
+  bstring                                 b = NULL;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  memset (mme_app_eviction_shards, 0, sizeof (mme_app_eviction_shards));
+  for (int shard = 0; shard < MME_APP_MAX_WORKERS; shard++) {
+    TAILQ_INIT (&mme_app_eviction_shards[shard].idle_list);
+    TAILQ_INIT (&mme_app_eviction_shards[shard].expiry_list);
+  }
+  mme_app_eviction.memory_budget_bytes = (uint64_t)mme_config.eviction_config.memory_budget_mb * 1024 * 1024;
+  mme_app_eviction.idle_timeout_ns = (uint64_t)mme_config.eviction_config.idle_timeout_sec * 1000000000ULL;
+  mme_app_eviction.period_ms = mme_config.eviction_config.period_ms;
+  mme_app_eviction.batch = mme_config.eviction_config.batch;
+  mme_app_eviction.max_evicted_per_shard = ((mme_config.eviction_config.max_evicted_ues) ? mme_config.eviction_config.max_evicted_ues : mme_config.max_ues) /
+                                           mme_app_nb_workers + 1;
+  mme_app_eviction.enabled = (mme_app_eviction.period_ms) && (mme_app_eviction.batch) &&
+                             ((mme_app_eviction.memory_budget_bytes) || (mme_app_eviction.idle_timeout_ns));
+
+  mme_app_eviction.evicted_budget_metric = metrics_register_counter ("mme_ue_evicted_budget_total", "UEs in ECM-IDLE evicted over the memory budget");
+  mme_app_eviction.evicted_timeout_metric = metrics_register_counter ("mme_ue_evicted_idle_timeout_total", "UEs in ECM-IDLE evicted after the idle timeout");
+  mme_app_eviction.stored_metric = metrics_register_gauge ("mme_ue_evicted", "Evicted UEs kept as records");
+  mme_app_eviction.stored_bytes_metric = metrics_register_gauge ("mme_ue_evicted_bytes", "Memory of the records of the evicted UEs");
+  mme_app_eviction.restored_metric = metrics_register_counter ("mme_ue_evicted_restored_total", "Evicted UEs restored on their return or a downlink data notification");
+  mme_app_eviction.expired_metric = metrics_register_counter ("mme_ue_evicted_expired_total", "Evicted UEs implicitly detached on expiry of their implicit detach deadline");
+  mme_app_eviction.detached_metric = metrics_register_counter ("mme_ue_evicted_detached_total", "UEs in ECM-IDLE implicitly detached instead of evicted, the records being full");
+  if (mme_app_cold_store_init (mme_config.eviction_config.cold_store_size) < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to allocate the cold store of %u records\n", mme_config.eviction_config.cold_store_size);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  if (metrics_register_collector (mme_app_eviction_dump_prometheus) < 0) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  if (!mme_app_eviction.enabled) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+  }
+  b = bfromcstr ("mme_app_evicted_m_tmsi_htbl");
+  mme_app_eviction.m_tmsi_htbl = hashtable_ts_create (mme_config.max_ues, NULL, NULL, b);
+  bassigncstr (b, "mme_app_evicted_s11_teid_htbl");
+  mme_app_eviction.s11_teid_htbl = hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
+  bdestroy (b);
+  if ((!mme_app_eviction.m_tmsi_htbl) || (!mme_app_eviction.s11_teid_htbl)) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to allocate the tables of the evicted UEs\n");
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    if (timer_setup (mme_app_eviction.period_ms / 1000, (mme_app_eviction.period_ms % 1000) * 1000, mme_app_shard_tasks[shard],
+                     INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_eviction_shards[shard].timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to request the eviction timer of MME_APP task %d\n", shard);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  }
+  OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_exit (void)
+{
+  if (mme_app_eviction.enabled) {
+    for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+      timer_remove (mme_app_eviction_shards[shard].timer_id);
+    }
+    // the records are freed with the table of the M-TMSIs, the UEs stay in the checkpoint file
+    hashtable_ts_destroy (mme_app_eviction.s11_teid_htbl);
+    hashtable_ts_destroy (mme_app_eviction.m_tmsi_htbl);
+  }
+  mme_app_cold_store_exit ();
+}
+
+//------------------------------------------------------------------------------
+long mme_app_eviction_timer_id (void)
+{
+  return (mme_app_eviction.enabled) ? mme_app_eviction_shards[mme_app_current_shard].timer_id : MME_APP_TIMER_INACTIVE_ID;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_ue_idle (struct ue_context_s * const ue_context_p)
+{
+  int                                     shard = 0;
+
+  if ((!mme_app_eviction.enabled) || (ue_context_p->idle_since_ns) || (INVALID_MME_UE_S1AP_ID == ue_context_p->mme_ue_s1ap_id)) {
+    return;
+  }
+  shard = mme_app_shard_of_ue_id (ue_context_p->mme_ue_s1ap_id);
+  ue_context_p->idle_since_ns = metrics_now_ns ();
+  TAILQ_INSERT_TAIL (&mme_app_eviction_shards[shard].idle_list, ue_context_p, idle_entries);
+  __atomic_store_n (&mme_app_eviction_shards[shard].nb_idle, mme_app_eviction_shards[shard].nb_idle + 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_ue_forget (struct ue_context_s * const ue_context_p)
+{
+  int                                     shard = 0;
+
+  ue_context_p->evicting_since_ns = 0;
+  if (0 == ue_context_p->idle_since_ns) {
+    return;
+  }
+  shard = mme_app_shard_of_ue_id (ue_context_p->mme_ue_s1ap_id);
+  TAILQ_REMOVE (&mme_app_eviction_shards[shard].idle_list, ue_context_p, idle_entries);
+  ue_context_p->idle_since_ns = 0;
+  __atomic_store_n (&mme_app_eviction_shards[shard].nb_idle, mme_app_eviction_shards[shard].nb_idle - 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+// Time from the entry in ECM-IDLE to the implicit detach of the evicted UE
+static uint64_t mme_app_eviction_detach_delay_ns (const struct ue_context_s * const ue_context_p)
+{
+  if (0 == mme_config.nas_config.t3412_min) {
+    return MME_APP_EVICTION_EXPIRY_SEC * 1000000000ULL;
+  }
+  return ((uint64_t)ue_context_p->mobile_reachability_timer.sec + ue_context_p->implicit_detach_timer.sec) * 1000000000ULL;
+}
+
+//------------------------------------------------------------------------------
+// Whether the task keeps its share of records already, the UEs are then detached instead of evicted
+static bool mme_app_eviction_is_full (void)
+{
+  return (mme_app_eviction_shards[mme_app_current_shard].nb_evicted >= mme_app_eviction.max_evicted_per_shard) ||
+         ((mme_app_eviction.memory_budget_bytes) && (mme_app_eviction_shards[mme_app_current_shard].evicted_bytes >=
+                                                     mme_app_eviction.memory_budget_bytes / 100 * MME_APP_EVICTION_LOW_WATERMARK_PERCENT / mme_app_nb_workers));
+}
+
+//------------------------------------------------------------------------------
+// Implicitly detaches the UE in ECM-IDLE instead of evicting it, its GUTI is kept in the cold store by NAS
+static void mme_app_eviction_detach (struct ue_context_s * const ue_context_p)
+{
+  mme_app_eviction_ue_forget (ue_context_p);
+  // the implicit detach is started here, not by the timers
+  if (ue_context_p->mobile_reachability_timer.id != MME_APP_TIMER_INACTIVE_ID) {
+    timer_remove (ue_context_p->mobile_reachability_timer.id);
+    ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  if (ue_context_p->implicit_detach_timer.id != MME_APP_TIMER_INACTIVE_ID) {
+    timer_remove (ue_context_p->implicit_detach_timer.id);
+    ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  metrics_counter_add (mme_app_eviction.detached_metric, 1);
+  mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
+}
+
+//------------------------------------------------------------------------------
+// Asks the NAS task of the UE to complete its record, the UE is evicted by mme_app_eviction_handle_ue_record_rsp
+static bool mme_app_eviction_request_record (struct ue_context_s * const ue_context_p)
+{
+  mme_app_checkpoint_record_t            *record = NULL;
+  MessageDef                             *message_p = NULL;
+  uint64_t                                idle_since_ns = ue_context_p->idle_since_ns;
+
+  if (mme_app_eviction_is_full ()) {
+    mme_app_eviction_detach (ue_context_p);
+    return true;
+  }
+  // the UE leaves the list either way, it stays resident until its next ECM-IDLE if it cannot be evicted
+  mme_app_eviction_ue_forget (ue_context_p);
+  if (posix_memalign ((void **)&record, 64, sizeof (*record))) {
+    return false;
+  }
+  if (!mme_app_checkpoint_fill_ue (ue_context_p, record)) {
+    OAILOG_DEBUG (LOG_MME_APP, "UE id " MME_UE_S1AP_ID_FMT " in ECM-IDLE cannot be kept as a record, not evicted\n", ue_context_p->mme_ue_s1ap_id);
+    free (record);
+    return false;
+  }
+  ue_context_p->evicting_since_ns = idle_since_ns;
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_UE_RECORD_REQ);
+  NAS_UE_RECORD_REQ (message_p).ue_id = ue_context_p->mme_ue_s1ap_id;
+  NAS_UE_RECORD_REQ (message_p).generation = ue_context_p->checkpoint_generation;
+  NAS_UE_RECORD_REQ (message_p).is_eviction = true;
+  NAS_UE_RECORD_REQ (message_p).is_valid = false;
+  NAS_UE_RECORD_REQ (message_p).record = record;
+  itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Evicts the UE if it is still in ECM-IDLE and not paged: keeps its record,
+ * removes its MME_APP context and tells NAS to release its EMM context.
+ */
+void mme_app_eviction_handle_ue_record_rsp (itti_nas_ue_record_t * const ue_record_rsp_p)
+{
+  struct ue_context_s                    *ue_context_p = NULL;
+  mme_app_evicted_ue_t                   *entry = NULL;
+  mme_app_evicted_ue_t                   *prev = NULL;
+  MessageDef                             *message_p = NULL;
+  uint8_t                                *buffer = mme_app_eviction_shards[mme_app_current_shard].pack_buffer;
+  size_t                                  length = 0;
+  bool                                    is_timed_out = false;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_record_rsp_p->ue_id);
+  if ((!ue_context_p) || (ECM_IDLE != ue_context_p->ecm_state) || (!ue_context_p->evicting_since_ns) || (ue_context_p->paging_attempts) ||
+      (ue_record_rsp_p->generation != ue_context_p->checkpoint_generation)) {
+    // the UE came back, is paged or was detached in the meantime
+    free (ue_record_rsp_p->record);
+    ue_record_rsp_p->record = NULL;
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  if (mme_app_eviction_is_full ()) {
+    // filled by the other records requested in the same period
+    ue_context_p->evicting_since_ns = 0;
+    free (ue_record_rsp_p->record);
+    ue_record_rsp_p->record = NULL;
+    mme_app_eviction_detach (ue_context_p);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  // packed in the buffer of the task first, the entry is allocated at its size
+  if ((!ue_record_rsp_p->is_valid) || (!(length = mme_app_checkpoint_record_pack (ue_record_rsp_p->record, buffer, MME_APP_EVICTION_MAX_RECORD_BYTES))) ||
+      (!(entry = malloc (offsetof (mme_app_evicted_ue_t, data) + length)))) {
+    OAILOG_DEBUG (LOG_MME_APP, "UE id " MME_UE_S1AP_ID_FMT " in ECM-IDLE cannot be kept as a record, not evicted\n", ue_context_p->mme_ue_s1ap_id);
+    ue_context_p->evicting_since_ns = 0;
+    free (ue_record_rsp_p->record);
+    ue_record_rsp_p->record = NULL;
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  entry->length = (uint32_t)length;
+  memcpy (entry->data, buffer, length);
+  entry->deadline_ns = ue_context_p->evicting_since_ns + mme_app_eviction_detach_delay_ns (ue_context_p);
+  entry->ue_id = ue_context_p->mme_ue_s1ap_id;
+  entry->guti = ue_context_p->guti;
+  entry->mme_s11_teid = ue_context_p->mme_s11_teid;
+  // the slot of the UE belongs to the record from now on
+  entry->checkpoint_slot = mme_app_checkpoint_write_record (ue_context_p->checkpoint_slot, ue_record_rsp_p->record);
+  ue_context_p->checkpoint_slot = MME_APP_CHECKPOINT_SLOT_NONE;
+  free (ue_record_rsp_p->record);
+  ue_record_rsp_p->record = NULL;
+
+  // the identifiers stay used before the context is removed
+  hashtable_ts_insert (mme_app_eviction.m_tmsi_htbl, (const hash_key_t)entry->guti.m_tmsi, (void *)entry);
+  hashtable_ts_insert (mme_app_eviction.s11_teid_htbl, (const hash_key_t)entry->mme_s11_teid, (void *)entry);
+  // the UEs are mostly evicted in the order they entered ECM-IDLE
+  for (prev = TAILQ_LAST (&mme_app_eviction_shards[mme_app_current_shard].expiry_list, mme_app_evicted_list_s);
+       (prev) && (prev->deadline_ns > entry->deadline_ns); prev = TAILQ_PREV (prev, mme_app_evicted_list_s, entries));
+  if (prev) {
+    TAILQ_INSERT_AFTER (&mme_app_eviction_shards[mme_app_current_shard].expiry_list, prev, entry, entries);
+  } else {
+    TAILQ_INSERT_HEAD (&mme_app_eviction_shards[mme_app_current_shard].expiry_list, entry, entries);
+  }
+  __atomic_store_n (&mme_app_eviction_shards[mme_app_current_shard].nb_evicted, mme_app_eviction_shards[mme_app_current_shard].nb_evicted + 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&mme_app_eviction_shards[mme_app_current_shard].evicted_bytes,
+                    mme_app_eviction_shards[mme_app_current_shard].evicted_bytes + mme_app_eviction_entry_bytes (entry), __ATOMIC_RELAXED);
+  metrics_gauge_add (mme_app_eviction.stored_metric, 1);
+  metrics_gauge_add (mme_app_eviction.stored_bytes_metric, (int64_t)mme_app_eviction_entry_bytes (entry));
+  is_timed_out = (mme_app_eviction.idle_timeout_ns) && (metrics_now_ns () - ue_context_p->evicting_since_ns >= mme_app_eviction.idle_timeout_ns);
+  metrics_counter_add (is_timed_out ? mme_app_eviction.evicted_timeout_metric : mme_app_eviction.evicted_budget_metric, 1);
+
+  OAILOG_INFO (LOG_MME_APP, "Evicted UE id " MME_UE_S1AP_ID_FMT " in ECM-IDLE (record of %u B)\n", entry->ue_id, entry->length);
+  mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p);
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_UE_EVICT_IND);
+  NAS_UE_EVICT_IND (message_p).ue_id = entry->ue_id;
+  itti_send_msg_to_task (nas_task_of_ue_id (entry->ue_id), INSTANCE_DEFAULT, message_p);
+  OAILOG_FUNC_OUT (LOG_MME_APP);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Rebuilds the MME_APP context of the evicted UE, in ECM-IDLE, and sends its
+ * record to NAS for the EMM context. The implicit detach timer is started for
+ * the rest of the delay if start_timer, the UE is back otherwise. The entry is
+ * freed, NULL if the context cannot be rebuilt (the UE is then forgotten).
+ */
+static struct ue_context_s *mme_app_eviction_restore (mme_app_evicted_ue_t * const entry, const bool start_timer)
+{
+  struct ue_context_s                    *ue_context_p = NULL;
+  mme_app_checkpoint_record_t            *record = NULL;
+  MessageDef                             *message_p = NULL;
+  void                                   *unused = NULL;
+  uint64_t                                now_ns = metrics_now_ns ();
+
+  hashtable_ts_remove (mme_app_eviction.m_tmsi_htbl, (const hash_key_t)entry->guti.m_tmsi, &unused);
+  hashtable_ts_remove (mme_app_eviction.s11_teid_htbl, (const hash_key_t)entry->mme_s11_teid, &unused);
+  TAILQ_REMOVE (&mme_app_eviction_shards[mme_app_current_shard].expiry_list, entry, entries);
+  __atomic_store_n (&mme_app_eviction_shards[mme_app_current_shard].nb_evicted, mme_app_eviction_shards[mme_app_current_shard].nb_evicted - 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&mme_app_eviction_shards[mme_app_current_shard].evicted_bytes,
+                    mme_app_eviction_shards[mme_app_current_shard].evicted_bytes - mme_app_eviction_entry_bytes (entry), __ATOMIC_RELAXED);
+  metrics_gauge_add (mme_app_eviction.stored_metric, -1);
+  metrics_gauge_add (mme_app_eviction.stored_bytes_metric, -(int64_t)mme_app_eviction_entry_bytes (entry));
+
+  if (posix_memalign ((void **)&record, 64, sizeof (*record))) {
+    record = NULL;
+  }
+  if ((!record) || (!mme_app_checkpoint_record_unpack (entry->data, entry->length, record)) ||
+      (!(ue_context_p = mme_app_checkpoint_restore_ue_context (record)))) {
+    // another UE context holds one of its identities, the UE attached again
+    OAILOG_WARNING (LOG_MME_APP, "Evicted UE id " MME_UE_S1AP_ID_FMT " cannot be restored, forgotten\n", entry->ue_id);
+    mme_app_checkpoint_release_record (entry->checkpoint_slot);
+    free (record);
+    free (entry);
+    return NULL;
+  }
+  ue_context_p->checkpoint_slot = entry->checkpoint_slot;
+  mme_app_eviction_ue_idle (ue_context_p);
+  // its idle time and deadline are the ones of before the eviction
+  ue_context_p->idle_since_ns = entry->deadline_ns - mme_app_eviction_detach_delay_ns (ue_context_p);
+  if ((start_timer) && (timer_setup ((entry->deadline_ns > now_ns + 1000000000ULL) ? (entry->deadline_ns - now_ns) / 1000000000ULL : 1, 0,
+                                     mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, TIMER_ONE_SHOT,
+                                     (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->implicit_detach_timer.id)) < 0)) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to start Implicit Detach timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
+    ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  OAILOG_INFO (LOG_MME_APP, "Restored evicted UE id " MME_UE_S1AP_ID_FMT "\n", ue_context_p->mme_ue_s1ap_id);
+  // before any other message of the UE to NAS
+  message_p = itti_alloc_new_message (TASK_MME_APP, NAS_UE_RESTORE_IND);
+  NAS_UE_RESTORE_IND (message_p).ue_id = ue_context_p->mme_ue_s1ap_id;
+  NAS_UE_RESTORE_IND (message_p).generation = ue_context_p->checkpoint_generation;
+  NAS_UE_RESTORE_IND (message_p).is_eviction = true;
+  NAS_UE_RESTORE_IND (message_p).is_valid = true;
+  NAS_UE_RESTORE_IND (message_p).record = record;
+  itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+  free (entry);
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+struct ue_context_s *mme_app_eviction_restore_ue_by_guti (const guti_t * const guti)
+{
+  mme_app_evicted_ue_t                   *entry = NULL;
+  struct ue_context_s                    *ue_context_p = NULL;
+
+  if ((!mme_app_eviction.enabled) ||
+      (HASH_TABLE_OK != hashtable_ts_get (mme_app_eviction.m_tmsi_htbl, (const hash_key_t)guti->m_tmsi, (void **)&entry)) ||
+      (entry->guti.gummei.mme_code != guti->gummei.mme_code) || (entry->guti.gummei.mme_gid != guti->gummei.mme_gid)) {
+    return NULL;
+  }
+  if ((ue_context_p = mme_app_eviction_restore (entry, false))) {
+    metrics_counter_add (mme_app_eviction.restored_metric, 1);
+  }
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+struct ue_context_s *mme_app_eviction_restore_ue_by_s11_teid (const teid_t teid)
+{
+  mme_app_evicted_ue_t                   *entry = NULL;
+  struct ue_context_s                    *ue_context_p = NULL;
+
+  if ((!mme_app_eviction.enabled) || (HASH_TABLE_OK != hashtable_ts_get (mme_app_eviction.s11_teid_htbl, (const hash_key_t)teid, (void **)&entry))) {
+    return NULL;
+  }
+  // paged, it is detached on its deadline if it does not answer
+  if ((ue_context_p = mme_app_eviction_restore (entry, true))) {
+    metrics_counter_add (mme_app_eviction.restored_metric, 1);
+  }
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_eviction_is_m_tmsi_used (const tmsi_t m_tmsi)
+{
+  return (mme_app_eviction.enabled) && (HASH_TABLE_OK == hashtable_ts_is_key_exists (mme_app_eviction.m_tmsi_htbl, (const hash_key_t)m_tmsi));
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_eviction_is_s11_teid_used (const teid_t teid)
+{
+  return (mme_app_eviction.enabled) && (HASH_TABLE_OK == hashtable_ts_is_key_exists (mme_app_eviction.s11_teid_htbl, (const hash_key_t)teid));
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_timer_expiry (void)
+{
+  struct mme_app_idle_list_s             *idle_list = &mme_app_eviction_shards[mme_app_current_shard].idle_list;
+  struct mme_app_evicted_list_s          *expiry_list = &mme_app_eviction_shards[mme_app_current_shard].expiry_list;
+  struct ue_context_s                    *ue_context_p = NULL;
+  struct ue_context_s                    *next_p = NULL;
+  mme_app_evicted_ue_t                   *entry = NULL;
+  uint64_t                                now_ns = metrics_now_ns ();
+  uint64_t                                nb_contexts = 0;
+  uint64_t                                bytes = 0;
+  uint64_t                                evicted_bytes = 0;
+  uint64_t                                low_watermark = 0;
+  uint64_t                                nb_over_budget = 0;
+  uint32_t                                nb_evicted = 0;
+  uint32_t                                nb_expired = 0;
+  bool                                    is_timed_out = false;
+
+  // the evicted UEs past their deadline are detached as they would have been in memory
+  while ((nb_expired < mme_app_eviction.batch) && (entry = TAILQ_FIRST (expiry_list)) && (entry->deadline_ns <= now_ns)) {
+    nb_expired++;
+    if ((ue_context_p = mme_app_eviction_restore (entry, false))) {
+      metrics_counter_add (mme_app_eviction.expired_metric, 1);
+      mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
+    }
+  }
+  if (TAILQ_EMPTY (idle_list)) {
+    return;
+  }
+  if (mme_app_eviction.memory_budget_bytes) {
+    bytes = mme_app_eviction_memory_in_use (&nb_contexts, &evicted_bytes);
+    if ((bytes > mme_app_eviction.memory_budget_bytes) && (nb_contexts)) {
+      // every task evicts its share of the UEs over the low watermark, at the average memory per resident UE
+      low_watermark = mme_app_eviction.memory_budget_bytes / 100 * MME_APP_EVICTION_LOW_WATERMARK_PERCENT;
+      nb_over_budget = (bytes - low_watermark) / ((bytes - evicted_bytes) / nb_contexts + 1) / mme_app_nb_workers + 1;
+    }
+  }
+  for (ue_context_p = TAILQ_FIRST (idle_list); (ue_context_p) && (nb_evicted < mme_app_eviction.batch); ue_context_p = next_p) {
+    next_p = TAILQ_NEXT (ue_context_p, idle_entries);
+    is_timed_out = (mme_app_eviction.idle_timeout_ns) && (now_ns - ue_context_p->idle_since_ns >= mme_app_eviction.idle_timeout_ns);
+    if ((!is_timed_out) && (nb_evicted >= nb_over_budget)) {
+      // the UEs further in the list went idle later
+      break;
+    }
+    if (ue_context_p->paging_attempts) {
+      // downlink data is waiting for the UE
+      continue;
+    }
+    if (mme_app_eviction_request_record (ue_context_p)) {
+      nb_evicted++;
+    }
+  }
+  if (nb_evicted) {
+    OAILOG_DEBUG (LOG_MME_APP, "Evicting %u UEs in ECM-IDLE (UE contexts %" PRIu64 " B in use, budget %" PRIu64 " B)\n",
+        nb_evicted, bytes, mme_app_eviction.memory_budget_bytes);
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_report (bstring str)
+{
+  mme_app_cold_store_stats_t              cold_stats = {0};
+  uint64_t                                nb_contexts = 0;
+  uint64_t                                nb_idle = 0;
+  uint64_t                                evicted_bytes = 0;
+  uint64_t                                bytes = mme_app_eviction_memory_in_use (&nb_contexts, &evicted_bytes);
+
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    nb_idle += __atomic_load_n (&mme_app_eviction_shards[shard].nb_idle, __ATOMIC_RELAXED);
+  }
+  mme_app_cold_store_get_stats (&cold_stats);
+  bformata (str, "Resident UE contexts     %10" PRIu64 " (%" PRIu64 " in ECM-IDLE listed for eviction)\n", nb_contexts, nb_idle);
+  bformata (str, "UE memory                %10" PRIu64 " B (%" PRIu64 " B of evicted UE records, budget %" PRIu64 " B)\n",
+      bytes, evicted_bytes, mme_app_eviction.memory_budget_bytes);
+  bformata (str, "Evicted UEs              %10" PRIu64 " over budget, %" PRIu64 " idle timeout, %" PRIu64 " detached instead\n",
+      (uint64_t)metrics_get_value (mme_app_eviction.evicted_budget_metric), (uint64_t)metrics_get_value (mme_app_eviction.evicted_timeout_metric),
+      (uint64_t)metrics_get_value (mme_app_eviction.detached_metric));
+  bformata (str, "Evicted UE records       %10" PRIu64 " (%" PRIu64 " B), %" PRIu64 " restored, %" PRIu64 " expired\n",
+      (uint64_t)metrics_get_value (mme_app_eviction.stored_metric), (uint64_t)metrics_get_value (mme_app_eviction.stored_bytes_metric),
+      (uint64_t)metrics_get_value (mme_app_eviction.restored_metric), (uint64_t)metrics_get_value (mme_app_eviction.expired_metric));
+  bformata (str, "Cold store               %10" PRIu64 " / %" PRIu64 " records (%" PRIu64 " B), %" PRIu64 " hits, %" PRIu64 " misses\n",
+      cold_stats.nb_records, cold_stats.capacity, cold_stats.memory_bytes, cold_stats.nb_hits, cold_stats.nb_misses);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_eviction_dump_prometheus (bstring out)
+{
+  mme_app_cold_store_stats_t              cold_stats = {0};
+  uint64_t                                nb_contexts = 0;
+  uint64_t                                nb_idle = 0;
+  uint64_t                                evicted_bytes = 0;
+  uint64_t                                bytes = mme_app_eviction_memory_in_use (&nb_contexts, &evicted_bytes);
+
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    nb_idle += __atomic_load_n (&mme_app_eviction_shards[shard].nb_idle, __ATOMIC_RELAXED);
+  }
+  mme_app_cold_store_get_stats (&cold_stats);
+  bformata (out, "# HELP mme_ue_contexts_resident UE contexts in memory\n# TYPE mme_ue_contexts_resident gauge\n");
+  bformata (out, "mme_ue_contexts_resident %" PRIu64 "\n", nb_contexts);
+  bformata (out, "# HELP mme_ue_contexts_resident_bytes Memory of the UE contexts in use (MME_APP, extensions and EMM)\n# TYPE mme_ue_contexts_resident_bytes gauge\n");
+  bformata (out, "mme_ue_contexts_resident_bytes %" PRIu64 "\n", bytes - evicted_bytes);
+  bformata (out, "# HELP mme_ue_contexts_idle_listed UEs in ECM-IDLE candidate to eviction\n# TYPE mme_ue_contexts_idle_listed gauge\n");
+  bformata (out, "mme_ue_contexts_idle_listed %" PRIu64 "\n", nb_idle);
+  bformata (out, "# HELP mme_ue_contexts_budget_bytes Memory budget of the UE contexts, 0 for none\n# TYPE mme_ue_contexts_budget_bytes gauge\n");
+  bformata (out, "mme_ue_contexts_budget_bytes %" PRIu64 "\n", mme_app_eviction.memory_budget_bytes);
+  bformata (out, "# HELP mme_ue_cold_store_records GUTI to IMSI records of detached UEs\n# TYPE mme_ue_cold_store_records gauge\n");
+  bformata (out, "mme_ue_cold_store_records %" PRIu64 "\n", cold_stats.nb_records);
+  bformata (out, "# HELP mme_ue_cold_store_bytes Memory of the cold store\n# TYPE mme_ue_cold_store_bytes gauge\n");
+  bformata (out, "mme_ue_cold_store_bytes %" PRIu64 "\n", cold_stats.memory_bytes);
+  bformata (out, "# HELP mme_ue_cold_store_saved_total Records saved in the cold store\n# TYPE mme_ue_cold_store_saved_total counter\n");
+  bformata (out, "mme_ue_cold_store_saved_total %" PRIu64 "\n", cold_stats.nb_saved);
+  bformata (out, "# HELP mme_ue_cold_store_replaced_total Records overwritten by the record of another GUTI\n# TYPE mme_ue_cold_store_replaced_total counter\n");
+  bformata (out, "mme_ue_cold_store_replaced_total %" PRIu64 "\n", cold_stats.nb_replaced);
+  bformata (out, "# HELP mme_ue_cold_store_hits_total Attaches with an unknown GUTI identified from the cold store\n# TYPE mme_ue_cold_store_hits_total counter\n");
+  bformata (out, "mme_ue_cold_store_hits_total %" PRIu64 "\n", cold_stats.nb_hits);
+  bformata (out, "# HELP mme_ue_cold_store_misses_total Attaches with an unknown GUTI not found in the cold store\n# TYPE mme_ue_cold_store_misses_total counter\n");
+  bformata (out, "mme_ue_cold_store_misses_total %" PRIu64 "\n", cold_stats.nb_misses);
+}
@@ -41,6 +41,8 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_config.h"
+#include "mme_app_statistics.h"
+#include "intertask_interface_trace.h"
 
 int
 mme_app_send_s6a_update_location_req (
@@ -53,8 +55,12 @@ mme_app_send_s6a_update_location_req (
   int                                     rc = RETURNok;
 
   OAILOG_FUNC_IN (LOG_MME_APP);
+  if (!ue_context_pP->pending_pdn_connectivity_req) {
+    OAILOG_ERROR (LOG_MME_APP, "No pending PDN connectivity request for UE id %d\n", ue_context_pP->mme_ue_s1ap_id);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
   IMSI_STRING_TO_IMSI64 ((char *)
-                          ue_context_pP->pending_pdn_connectivity_req_imsi, &imsi);
+                          ue_context_pP->pending_pdn_connectivity_req->imsi, &imsi);
   OAILOG_DEBUG (LOG_MME_APP, "Handling imsi " IMSI_64_FMT "\n", imsi);
 
   if ((ue_context_p = mme_ue_context_exists_imsi (&mme_app_desc.mme_ue_contexts, imsi)) == NULL) {
@@ -80,6 +86,7 @@ mme_app_send_s6a_update_location_req (
    */
   s6a_ulr_p->skip_subscriber_data = 0;
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S6A_MME, NULL, 0, "0 S6A_UPDATE_LOCATION_REQ imsi " IMSI_64_FMT, imsi);
+  ue_context_p->s6a_ulr_start_ns = metrics_now_ns ();
   rc =  itti_send_msg_to_task (TASK_S6A, INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
@@ -92,6 +99,7 @@ mme_app_handle_s6a_update_location_ans (
 {
   uint64_t                                imsi = 0;
   struct ue_context_s                    *ue_context_p = NULL;
+  ue_subscription_t                      *subscription_p = NULL;
   int                                     rc = RETURNok;
 
   OAILOG_FUNC_IN (LOG_MME_APP);
@@ -123,31 +131,39 @@ mme_app_handle_s6a_update_location_ans (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_UPDATE_LOCATION unknown imsi " IMSI_64_FMT" ", imsi);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+  itti_trace_resume (ue_context_p->trace_id);
+  update_mme_app_stats_latency (MME_APP_LATENCY_S6A_ULR, ue_context_p->s6a_ulr_start_ns);
+  ue_context_p->s6a_ulr_start_ns = 0;
+
+  if ((subscription_p = mme_app_get_ue_subscription (ue_context_p)) == NULL) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to allocate the subscription data of UE id %d\n", ue_context_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
 
   // Updating the UE subscription without much validation!
 
   ue_context_p->subscription_known = SUBSCRIPTION_KNOWN;
-  ue_context_p->sub_status = ula_pP->subscription_data.subscriber_status;
-  ue_context_p->access_restriction_data = ula_pP->subscription_data.access_restriction;
+  subscription_p->sub_status = ula_pP->subscription_data.subscriber_status;
+  subscription_p->access_restriction_data = ula_pP->subscription_data.access_restriction;
   /*
    * Copy the subscribed ambr to the sgw create session request message
    */
-  memcpy (&ue_context_p->subscribed_ambr, &ula_pP->subscription_data.subscribed_ambr, sizeof (ambr_t));
+  memcpy (&subscription_p->subscribed_ambr, &ula_pP->subscription_data.subscribed_ambr, sizeof (ambr_t));
   // In Activate Default EPS Bearer Context Setup Request message APN-AMPBR is forced to 200Mbps and 100 Mbps for DL
   // and UL respectively. Since as of now we support only one bearer, forcing AMBR as well to APN-AMBR values.
-  ue_context_p->subscribed_ambr.br_ul = 100000000; // Setting it to 100 Mbps
-  ue_context_p->subscribed_ambr.br_dl = 200000000; // Setting it to 200 Mbps 
+  subscription_p->subscribed_ambr.br_ul = 100000000; // Setting it to 100 Mbps
+  subscription_p->subscribed_ambr.br_dl = 200000000; // Setting it to 200 Mbps 
   // TODO task#14477798 - Configure the policy driven values in HSS and use those here and in NAS.
   //ue_context_p->subscribed_ambr.br_ul = ue_context_p->subscribed_ambr.br_ul; // Setting it to 100 Mbps
   //ue_context_p->subscribed_ambr.br_dl = ue_context_p->subscribed_ambr.br_dl; // Setting it to 200 Mbps 
 
-  memcpy (ue_context_p->msisdn, ula_pP->subscription_data.msisdn, ula_pP->subscription_data.msisdn_length);
-  ue_context_p->msisdn_length = ula_pP->subscription_data.msisdn_length;
   AssertFatal (ula_pP->subscription_data.msisdn_length <= MSISDN_LENGTH, "MSISDN LENGTH is too high %u", MSISDN_LENGTH);
-  ue_context_p->msisdn[ue_context_p->msisdn_length] = '\0';
-  ue_context_p->rau_tau_timer = ula_pP->subscription_data.rau_tau_timer;
-  ue_context_p->access_mode = ula_pP->subscription_data.access_mode;
-  memcpy (&ue_context_p->apn_profile, &ula_pP->subscription_data.apn_config_profile, sizeof (apn_config_profile_t));
+  memcpy (subscription_p->msisdn, ula_pP->subscription_data.msisdn, ula_pP->subscription_data.msisdn_length);
+  subscription_p->msisdn_length = ula_pP->subscription_data.msisdn_length;
+  subscription_p->msisdn[subscription_p->msisdn_length] = '\0';
+  subscription_p->rau_tau_timer = ula_pP->subscription_data.rau_tau_timer;
+  subscription_p->access_mode = ula_pP->subscription_data.access_mode;
+  memcpy (&subscription_p->apn_profile, &ula_pP->subscription_data.apn_config_profile, sizeof (apn_config_profile_t));
   /*
    * Set the value of  Mobile Reachability timer based on value of T3412 (Periodic TAU timer) sent in Attach accept /TAU accept.
    * Set it to MME_APP_DELTA_T3412_REACHABILITY_TIMER minutes greater than T3412.
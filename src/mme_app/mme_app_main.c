@@ -31,6 +31,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "mme_app_shard.h"
 #include "assertions.h"
 #include "msc.h"
 
@@ -43,7 +44,10 @@ void *mme_app_thread (
   void *args)
 {
   struct ue_context_s                    *ue_context_p = NULL;
-  itti_mark_task_ready (TASK_MME_APP);
+  const task_id_t                         task_id = mme_app_shard_tasks[(int)(uintptr_t)args];
+
+  mme_app_current_shard = (int)(uintptr_t)args;
+  itti_mark_task_ready (task_id);
   MSC_START_USE ();
 
   while (1) {
@@ -54,7 +58,7 @@ void *mme_app_thread (
      * If the queue is empty, this function will block till a
      * message is sent to the task.
      */
-    itti_receive_msg (TASK_MME_APP, &received_message_p);
+    itti_receive_msg (task_id, &received_message_p);
     DevAssert (received_message_p );
 
     switch (ITTI_MSG_ID (received_message_p)) {
@@ -83,6 +87,11 @@ void *mme_app_thread (
       }
       break;
 
+    case S11_DOWNLINK_DATA_NOTIFICATION:{
+        mme_app_handle_downlink_data_notification (&received_message_p->ittiMsg.s11_downlink_data_notification);
+      }
+      break;
+
     case S11_DELETE_SESSION_RESPONSE: {
         mme_app_handle_delete_session_rsp (&received_message_p->ittiMsg.s11_delete_session_response);
       }
@@ -101,6 +110,15 @@ void *mme_app_thread (
       }
       break;
 
+    case NAS_UE_RECORD_RSP:{
+        if (NAS_UE_RECORD_RSP (received_message_p).is_eviction) {
+          mme_app_eviction_handle_ue_record_rsp (&NAS_UE_RECORD_RSP (received_message_p));
+        } else {
+          mme_app_checkpoint_handle_ue_record_rsp (&NAS_UE_RECORD_RSP (received_message_p));
+        }
+      }
+      break;
+
     case NAS_CONNECTION_ESTABLISHMENT_CNF:{
         mme_app_handle_conn_est_cnf (&NAS_CONNECTION_ESTABLISHMENT_CNF (received_message_p));
       }
@@ -156,6 +174,10 @@ void *mme_app_thread (
          */
         if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.statistic_timer_id) {
           mme_app_statistics_display ();
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_eviction_timer_id ()) {
+          mme_app_eviction_timer_expiry ();
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_checkpoint_timer_id ()) {
+          mme_app_checkpoint_timer_expiry ();
         } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) { 
           mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
           ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
@@ -172,6 +194,9 @@ void *mme_app_thread (
           } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->initial_context_setup_rsp_timer.id) {
             // Initial Context Setup Rsp Timer expiry handler
             mme_app_handle_initial_context_setup_rsp_timer_expiry (ue_context_p);
+          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->paging_timer.id) {
+            // Paging Timer (T3413) expiry handler
+            mme_app_handle_paging_timer_expiry (ue_context_p);
           } else {
             OAILOG_WARNING (LOG_MME_APP, "Timer expired but no assoicated timer_id for UE id %d\n",mme_ue_s1ap_id);
           }
@@ -182,13 +207,25 @@ void *mme_app_thread (
     case TERMINATE_MESSAGE:{
         /*
          * Termination message received TODO -> release any data allocated
+         * The shared tables and pools are released by the first shard only,
+         * once no MME_APP or NAS task uses them.
          */
+        mme_app_checkpoint_exit ();
+        mme_app_shard_exit_wait ();
+        if (mme_app_current_shard) {
+          itti_exit_task ();
+        }
         timer_remove(mme_app_desc.statistic_timer_id);
+        mme_app_eviction_exit ();
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
         obj_hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
+        slab_pool_destroy (mme_app_desc.mme_ue_contexts.ue_context_pool);
+        slab_pool_destroy (mme_app_desc.mme_ue_contexts.subscription_pool);
+        slab_pool_destroy (mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool);
+        slab_pool_destroy (mme_app_desc.mme_ue_contexts.bearer_context_pool);
         itti_exit_task ();
       }
       break;
@@ -198,6 +235,11 @@ void *mme_app_thread (
       }
       break;
 
+    case S1AP_UE_TAI_IND:{
+        mme_app_handle_s1ap_ue_tai_ind (&received_message_p->ittiMsg.s1ap_ue_tai_ind);
+      }
+      break;
+
     case S1AP_UE_CONTEXT_RELEASE_REQ:{
         mme_app_handle_s1ap_ue_context_release_req (&received_message_p->ittiMsg.s1ap_ue_context_release_req);
       }
@@ -253,15 +295,45 @@ mme_app_init (
   mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl = hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_guti_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = obj_hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, hash_free_int_func, b);
+  mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = obj_hashtable_ts_create (mme_config.max_ues, guti_hashfunc, hash_free_int_func, hash_free_int_func, b);
+  btrunc(b, 0);
+  bassigncstr(b, "ue_context_t");
+  mme_app_desc.mme_ue_contexts.ue_context_pool = slab_pool_create (sizeof (ue_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
+  btrunc(b, 0);
+  bassigncstr(b, "ue_subscription_t");
+  mme_app_desc.mme_ue_contexts.subscription_pool = slab_pool_create (sizeof (ue_subscription_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
+  btrunc(b, 0);
+  bassigncstr(b, "pending_pdn_connectivity_req_t");
+  mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool = slab_pool_create (sizeof (pending_pdn_connectivity_req_t), 0, false, b);
+  btrunc(b, 0);
+  bassigncstr(b, "bearer_context_t");
+  mme_app_desc.mme_ue_contexts.bearer_context_pool = slab_pool_create (sizeof (bearer_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
   bdestroy(b);
+  if ((!mme_app_desc.mme_ue_contexts.ue_context_pool) || (!mme_app_desc.mme_ue_contexts.subscription_pool) ||
+      (!mme_app_desc.mme_ue_contexts.pending_pdn_connectivity_req_pool) || (!mme_app_desc.mme_ue_contexts.bearer_context_pool)) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to create UE context pools\n");
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+
+  mme_app_paging_init ();
+  if (mme_app_eviction_init () < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to initialize the eviction of the UE contexts\n");
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  // restores the UE contexts of the previous run, before the tasks handle any UE
+  if (mme_app_checkpoint_init () < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to initialize the checkpoint of the UE contexts\n");
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
 
   /*
-   * Create the thread associated with MME applicative layer
+   * Create the threads associated with MME applicative layer, one per shard of UE contexts
    */
-  if (itti_create_task (TASK_MME_APP, &mme_app_thread, NULL) < 0) {
-    OAILOG_ERROR (LOG_MME_APP, "MME APP create task failed\n");
-    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    if (itti_create_task (mme_app_shard_tasks[shard], &mme_app_thread, (void *)(uintptr_t)shard) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "MME APP create task %d failed\n", shard);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
   }
 
   mme_app_desc.statistic_timer_period = mme_config_p->mme_statistic_timer;
@@ -0,0 +1,275 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_paging.c
+  \brief Paging of the UEs in ECM-IDLE on S11 DOWNLINK DATA NOTIFICATION:
+  retransmission on T3413, escalation from the last TAI to the TAI list of the
+  UE and throttling of the notifications.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "assertions.h"
+#include "log.h"
+#include "msc.h"
+#include "metrics.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_config.h"
+#include "emmData.h"
+#include "mme_app_shard.h"
+#include "timer.h"
+
+/*
+ * A UE is paged first with last_tai_attempts PAGINGs to the eNBs of its last
+ * TAI, then with tai_list_attempts PAGINGs to the eNBs of all the TAIs of its
+ * TAI list, each one guarded by T3413. The DOWNLINK DATA NOTIFICATION is
+ * acknowledged as soon as the paging starts, the notifications received while
+ * the UE is being paged or is connected are acknowledged without paging again.
+ */
+static struct {
+  uint32_t                                t3413_ms;
+  uint32_t                                last_tai_attempts;
+  uint32_t                                tai_list_attempts;
+  uint32_t                                rate;
+  metric_id_t                             started_metric;
+  metric_id_t                             throttled_metric;
+  metric_id_t                             rejected_metric;
+  metric_id_t                             expired_metric;
+} mme_app_paging = {
+  .started_metric = METRIC_ID_INVALID,
+  .throttled_metric = METRIC_ID_INVALID,
+  .rejected_metric = METRIC_ID_INVALID,
+  .expired_metric = METRIC_ID_INVALID,
+};
+
+/*
+ * Token bucket of the pagings started by every MME_APP task, one second of
+ * rate of burst. Only the task of the shard updates its bucket.
+ */
+static struct {
+  uint64_t                                last_ns;
+  uint64_t                                credit;     // in ns x rate, a paging costs 1 s x rate
+} mme_app_paging_buckets[MME_APP_MAX_WORKERS];
+
+//------------------------------------------------------------------------------
+void mme_app_paging_init (void)
+{
+  mme_app_paging.t3413_ms = mme_config.paging_config.t3413_ms;
+  mme_app_paging.last_tai_attempts = mme_config.paging_config.last_tai_attempts;
+  mme_app_paging.tai_list_attempts = mme_config.paging_config.tai_list_attempts;
+  mme_app_paging.rate = mme_config.paging_config.rate;
+  memset (mme_app_paging_buckets, 0, sizeof (mme_app_paging_buckets));
+
+  mme_app_paging.started_metric = metrics_register_counter ("mme_paging_started_total", "Pagings started on S11 DOWNLINK DATA NOTIFICATION");
+  mme_app_paging.throttled_metric = metrics_register_counter ("mme_paging_throttled_total", "S11 DOWNLINK DATA NOTIFICATIONs for a UE already paged or connected");
+  mme_app_paging.rejected_metric = metrics_register_counter ("mme_paging_rejected_total", "S11 DOWNLINK DATA NOTIFICATIONs answered unable to page UE");
+  mme_app_paging.expired_metric = metrics_register_counter ("mme_paging_expired_total", "Pagings without answer of the UE after the last attempt");
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_paging_admit (void)
+{
+  uint64_t                                now_ns = 0;
+  const uint64_t                          cost = 1000000000ULL * mme_app_paging.rate;
+
+  if (0 == mme_app_paging.rate) {
+    return true;
+  }
+  now_ns = metrics_now_ns ();
+  if (0 == mme_app_paging_buckets[mme_app_current_shard].last_ns) {
+    mme_app_paging_buckets[mme_app_current_shard].credit = cost;
+  } else {
+    mme_app_paging_buckets[mme_app_current_shard].credit += (now_ns - mme_app_paging_buckets[mme_app_current_shard].last_ns) * mme_app_paging.rate;
+    if (mme_app_paging_buckets[mme_app_current_shard].credit > cost) {
+      mme_app_paging_buckets[mme_app_current_shard].credit = cost;
+    }
+  }
+  mme_app_paging_buckets[mme_app_current_shard].last_ns = now_ns;
+  // a paging costs one token, 1 / rate second
+  if (mme_app_paging_buckets[mme_app_current_shard].credit < 1000000000ULL) {
+    return false;
+  }
+  mme_app_paging_buckets[mme_app_current_shard].credit -= 1000000000ULL;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// TAI list of the UE, the TAIs of the MME in the PLMN of its GUTI as given by mme_api_new_guti
+static uint8_t mme_app_paging_tai_list (const struct ue_context_s * const ue_context_p, tai_t * const tais)
+{
+  uint8_t                                 nb_tais = 0;
+
+  for (int i = 0; (i < _emm_data.conf.tai_list.n_tais) && (nb_tais < TAI_LIST_MAX_SIZE); i++) {
+    if (PLMNS_ARE_EQUAL (_emm_data.conf.tai_list.tai[i].plmn, ue_context_p->guti.gummei.plmn)) {
+      tais[nb_tais++] = _emm_data.conf.tai_list.tai[i];
+    }
+  }
+  return nb_tais;
+}
+
+//------------------------------------------------------------------------------
+// Sends the next PAGING of the UE and starts T3413, RETURNerror once all the attempts are done
+static int mme_app_paging_send (struct ue_context_s * const ue_context_p)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s1ap_paging_request_t             *paging_p = NULL;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  if ((!TAI_IS_VALID (ue_context_p->last_tai)) && (ue_context_p->paging_attempts < mme_app_paging.last_tai_attempts)) {
+    // no last TAI known, straight to the TAI list
+    ue_context_p->paging_attempts = mme_app_paging.last_tai_attempts;
+  }
+  if (ue_context_p->paging_attempts >= mme_app_paging.last_tai_attempts + mme_app_paging.tai_list_attempts) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  message_p = itti_alloc_new_message (TASK_MME_APP, S1AP_PAGING_REQUEST);
+  paging_p = &message_p->ittiMsg.s1ap_paging_request;
+  memset ((void *)paging_p, 0, sizeof (itti_s1ap_paging_request_t));
+  paging_p->mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
+  paging_p->mme_code = ue_context_p->guti.gummei.mme_code;
+  paging_p->m_tmsi = ue_context_p->guti.m_tmsi;
+  paging_p->ue_identity_index = (uint16_t)(ue_context_p->imsi % 1024);
+  if (ue_context_p->paging_attempts < mme_app_paging.last_tai_attempts) {
+    paging_p->tai[0] = ue_context_p->last_tai;
+    paging_p->nb_tais = 1;
+  } else {
+    paging_p->nb_tais = mme_app_paging_tai_list (ue_context_p, paging_p->tai);
+    if (0 == paging_p->nb_tais) {
+      itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  }
+  ue_context_p->paging_attempts++;
+  MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S1AP_MME, NULL, 0, "0 S1AP_PAGING_REQUEST ue id " MME_UE_S1AP_ID_FMT " attempt %u tais %u",
+      ue_context_p->mme_ue_s1ap_id, ue_context_p->paging_attempts, paging_p->nb_tais);
+  itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
+
+  if (timer_setup (mme_app_paging.t3413_ms / 1000, (mme_app_paging.t3413_ms % 1000) * 1000, mme_app_task_of_ue_id (ue_context_p->mme_ue_s1ap_id),
+                   INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->paging_timer.id)) < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to start paging timer for UE id " MME_UE_S1AP_ID_FMT "\n", ue_context_p->mme_ue_s1ap_id);
+    ue_context_p->paging_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_send_s11_downlink_data_notification_ack (const itti_s11_downlink_data_notification_t * const notif_pP,
+                                                             const teid_t sgw_s11_teid, const SGWCause_t cause)
+{
+  MessageDef                             *message_p = NULL;
+  itti_s11_downlink_data_notification_acknowledge_t *ack_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_MME_APP, S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE);
+  ack_p = &message_p->ittiMsg.s11_downlink_data_notification_acknowledge;
+  memset ((void *)ack_p, 0, sizeof (itti_s11_downlink_data_notification_acknowledge_t));
+  ack_p->teid = sgw_s11_teid;
+  ack_p->cause = cause;
+  ack_p->trxn = notif_pP->trxn;
+  ack_p->peer_ip = notif_pP->peer_ip;
+  MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE teid %u cause %u", sgw_s11_teid, cause);
+  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_handle_downlink_data_notification (const itti_s11_downlink_data_notification_t * const notif_pP)
+{
+  struct ue_context_s                    *ue_context_p = NULL;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  ue_context_p = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, notif_pP->teid);
+  if (!ue_context_p) {
+    // an evicted UE is paged as a resident one
+    ue_context_p = mme_app_eviction_restore_ue_by_s11_teid (notif_pP->teid);
+  }
+  if (!ue_context_p) {
+    OAILOG_WARNING (LOG_MME_APP, "DOWNLINK DATA NOTIFICATION for unknown local S11 teid " TEID_FMT "\n", notif_pP->teid);
+    mme_app_send_s11_downlink_data_notification_ack (notif_pP, 0, CONTEXT_NOT_FOUND);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  if ((ECM_CONNECTED == ue_context_p->ecm_state) || (ue_context_p->paging_attempts)) {
+    // the S1-U bearers are (being) established, the SGW buffers the data up to the MODIFY BEARER REQUEST
+    OAILOG_DEBUG (LOG_MME_APP, "DOWNLINK DATA NOTIFICATION for UE id " MME_UE_S1AP_ID_FMT " already %s\n",
+        ue_context_p->mme_ue_s1ap_id, (ECM_CONNECTED == ue_context_p->ecm_state) ? "connected" : "paged");
+    metrics_counter_add (mme_app_paging.throttled_metric, 1);
+    mme_app_send_s11_downlink_data_notification_ack (notif_pP, ue_context_p->sgw_s11_teid, REQUEST_ACCEPTED);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  if ((!ue_context_p->is_guti_set) || (!mme_app_paging_admit ()) || (RETURNok != mme_app_paging_send (ue_context_p))) {
+    OAILOG_INFO (LOG_MME_APP, "Unable to page UE id " MME_UE_S1AP_ID_FMT "\n", ue_context_p->mme_ue_s1ap_id);
+    metrics_counter_add (mme_app_paging.rejected_metric, 1);
+    mme_app_send_s11_downlink_data_notification_ack (notif_pP, ue_context_p->sgw_s11_teid, UNABLE_TO_PAGE_UE);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  metrics_counter_add (mme_app_paging.started_metric, 1);
+  mme_app_send_s11_downlink_data_notification_ack (notif_pP, ue_context_p->sgw_s11_teid, REQUEST_ACCEPTED);
+  OAILOG_FUNC_OUT (LOG_MME_APP);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_handle_paging_timer_expiry (struct ue_context_s *ue_context_p)
+{
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  DevAssert (ue_context_p != NULL);
+  ue_context_p->paging_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  if (RETURNok != mme_app_paging_send (ue_context_p)) {
+    OAILOG_INFO (LOG_MME_APP, "No answer to %u PAGINGs of UE id " MME_UE_S1AP_ID_FMT "\n", ue_context_p->paging_attempts, ue_context_p->mme_ue_s1ap_id);
+    metrics_counter_add (mme_app_paging.expired_metric, 1);
+    ue_context_p->paging_attempts = 0;
+  }
+  OAILOG_FUNC_OUT (LOG_MME_APP);
+}
+
+//------------------------------------------------------------------------------
+// The UE sent a TAU REQUEST or another S1AP message from a TA other than last_tai
+void mme_app_handle_s1ap_ue_tai_ind (const itti_s1ap_ue_tai_ind_t * const ue_tai_ind_pP)
+{
+  struct ue_context_s                    *ue_context_p = NULL;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_tai_ind_pP->mme_ue_s1ap_id);
+  if (!ue_context_p) {
+    OAILOG_DEBUG (LOG_MME_APP, "S1AP_UE_TAI_IND for unknown UE id " MME_UE_S1AP_ID_FMT "\n", ue_tai_ind_pP->mme_ue_s1ap_id);
+    OAILOG_FUNC_OUT (LOG_MME_APP);
+  }
+  ue_context_p->last_tai = ue_tai_ind_pP->tai;
+  OAILOG_FUNC_OUT (LOG_MME_APP);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_paging_stop (struct ue_context_s *ue_context_p)
+{
+  DevAssert (ue_context_p != NULL);
+  if (ue_context_p->paging_timer.id != MME_APP_TIMER_INACTIVE_ID) {
+    if (timer_remove (ue_context_p->paging_timer.id)) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to stop paging timer for UE id " MME_UE_S1AP_ID_FMT "\n", ue_context_p->mme_ue_s1ap_id);
+    }
+    ue_context_p->paging_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  ue_context_p->paging_attempts = 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_shard.c
+  \brief Routing of UE related messages to the MME_APP/NAS tasks owning the UE.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "log.h"
+#include "conversions.h"
+#include "intertask_interface.h"
+#include "intertask_interface_stats.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_shard.h"
+#include "emmData.h"
+
+int                                     mme_app_nb_workers = 1;
+__thread int                            mme_app_current_shard = 0;
+
+const task_id_t                         mme_app_shard_tasks[MME_APP_MAX_WORKERS] = {
+  TASK_MME_APP,    TASK_MME_APP_1,  TASK_MME_APP_2,  TASK_MME_APP_3,
+  TASK_MME_APP_4,  TASK_MME_APP_5,  TASK_MME_APP_6,  TASK_MME_APP_7,
+  TASK_MME_APP_8,  TASK_MME_APP_9,  TASK_MME_APP_10, TASK_MME_APP_11,
+  TASK_MME_APP_12, TASK_MME_APP_13, TASK_MME_APP_14, TASK_MME_APP_15
+};
+
+const task_id_t                         nas_shard_tasks[MME_APP_MAX_WORKERS] = {
+  TASK_NAS_MME,    TASK_NAS_MME_1,  TASK_NAS_MME_2,  TASK_NAS_MME_3,
+  TASK_NAS_MME_4,  TASK_NAS_MME_5,  TASK_NAS_MME_6,  TASK_NAS_MME_7,
+  TASK_NAS_MME_8,  TASK_NAS_MME_9,  TASK_NAS_MME_10, TASK_NAS_MME_11,
+  TASK_NAS_MME_12, TASK_NAS_MME_13, TASK_NAS_MME_14, TASK_NAS_MME_15
+};
+
+// one generator per shard, on its own cache line since each one is only incremented by its shard
+typedef struct mme_app_shard_ue_id_generator_s {
+  mme_ue_s1ap_id_t                        next;
+} __attribute__ ((aligned (64))) mme_app_shard_ue_id_generator_t;
+
+static mme_app_shard_ue_id_generator_t  mme_app_shard_ue_id_generators[MME_APP_MAX_WORKERS];
+
+// joined by the MME_APP and NAS tasks of all the shards when they terminate
+static pthread_barrier_t                mme_app_shard_exit_barrier;
+
+//------------------------------------------------------------------------------
+int mme_app_shard_init (const uint32_t nb_workers)
+{
+  if ((nb_workers < 1) || (nb_workers > MME_APP_MAX_WORKERS)) {
+    OAILOG_ERROR (LOG_MME_APP, "Bad number of MME_APP/NAS workers %u, must be in [1..%d]\n", nb_workers, MME_APP_MAX_WORKERS);
+    return RETURNerror;
+  }
+  mme_app_nb_workers = (int)nb_workers;
+  for (int i = 0; i < MME_APP_MAX_WORKERS; i++) {
+    mme_app_shard_ue_id_generators[i].next = 1;
+  }
+  pthread_barrier_init (&mme_app_shard_exit_barrier, NULL, 2 * nb_workers);
+  OAILOG_INFO (LOG_MME_APP, "UE contexts sharded on %d MME_APP/NAS workers\n", mme_app_nb_workers);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called by the MME_APP and NAS tasks on TERMINATE_MESSAGE, returns once all
+ * of them stopped handling messages: the first shard of each task then frees
+ * the shared UE tables and pools.
+ */
+void mme_app_shard_exit_wait (void)
+{
+  pthread_barrier_wait (&mme_app_shard_exit_barrier);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called by the MME_APP task receiving the initial UE message, the new UE
+ * belongs to this task. The ids of a shard are c * nb_workers + shard, c >= 1
+ * so that INVALID_MME_UE_S1AP_ID is never returned.
+ */
+mme_ue_s1ap_id_t mme_app_shard_new_ue_id (void)
+{
+  mme_ue_s1ap_id_t                        c = 0;
+
+  c = __sync_fetch_and_add (&mme_app_shard_ue_id_generators[mme_app_current_shard].next, 1);
+  return c * (mme_ue_s1ap_id_t)mme_app_nb_workers + (mme_ue_s1ap_id_t)mme_app_current_shard;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called before the MME_APP tasks run for the ids of the UE contexts restored
+ * from a checkpoint, the ids given afterwards by the shard are higher.
+ */
+void mme_app_shard_reserve_ue_id (const mme_ue_s1ap_id_t ue_id)
+{
+  int                                     shard = mme_app_shard_of_ue_id (ue_id);
+  mme_ue_s1ap_id_t                        c = ue_id / (mme_ue_s1ap_id_t)mme_app_nb_workers;
+
+  if (c >= mme_app_shard_ue_id_generators[shard].next) {
+    mme_app_shard_ue_id_generators[shard].next = c + 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * A UE coming back with a S-TMSI allocated by us goes to the shard owning its
+ * context, a new UE is spread on the shards by its S1 signalling connection.
+ */
+int mme_app_shard_of_initial_ue (const as_stmsi_t * const opt_s_tmsi, const uint32_t enb_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id)
+{
+  int                                     shard = -1;
+
+  if ((opt_s_tmsi) && (INVALID_M_TMSI != opt_s_tmsi->m_tmsi)) {
+    shard = mme_app_shard_of_tag (opt_s_tmsi->m_tmsi);
+  }
+  if (shard < 0) {
+    shard = (int)((((uint64_t)enb_id << 24) | (enb_ue_s1ap_id & ENB_UE_S1AP_ID_MASK)) % (uint64_t)mme_app_nb_workers);
+  }
+  return shard;
+}
+
+//------------------------------------------------------------------------------
+task_id_t mme_app_task_of_initial_ue (const as_stmsi_t * const opt_s_tmsi, const uint32_t enb_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id)
+{
+  return mme_app_shard_tasks[mme_app_shard_of_initial_ue (opt_s_tmsi, enb_id, enb_ue_s1ap_id)];
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_shard_overloaded (const int shard)
+{
+  return itti_task_overloaded (mme_app_shard_tasks[shard]) || itti_task_overloaded (nas_shard_tasks[shard]);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The HSS answers only carry the IMSI, the tables are only read here: they
+ * store the mme_ue_s1ap_id by value and are thread safe. An unknown IMSI goes
+ * to the first shard which will discard the answer.
+ */
+task_id_t mme_app_task_of_imsi (const char * const imsi)
+{
+  imsi64_t                                imsi64 = INVALID_IMSI64;
+  void                                   *id = NULL;
+
+  if (1 == mme_app_nb_workers) {
+    return TASK_MME_APP;
+  }
+  IMSI_STRING_TO_IMSI64 (imsi, &imsi64);
+  if (HASH_TABLE_OK == hashtable_ts_get (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, (const hash_key_t)imsi64, &id)) {
+    return mme_app_task_of_ue_id ((mme_ue_s1ap_id_t)(uintptr_t)id);
+  }
+  return TASK_MME_APP;
+}
+
+//------------------------------------------------------------------------------
+task_id_t nas_task_of_imsi (const char * const imsi)
+{
+  imsi64_t                                imsi64 = INVALID_IMSI64;
+  void                                   *id = NULL;
+
+  if (1 == mme_app_nb_workers) {
+    return TASK_NAS_MME;
+  }
+  IMSI_STRING_TO_IMSI64 (imsi, &imsi64);
+  if (HASH_TABLE_OK == hashtable_ts_get (_emm_data.ctx_coll_imsi, (const hash_key_t)imsi64, &id)) {
+    return nas_task_of_ue_id ((mme_ue_s1ap_id_t)(uintptr_t)id);
+  }
+  return TASK_NAS_MME;
+}
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_shard.h
+  \brief UE contexts are partitioned on nb_workers MME_APP/NAS task pairs (shards).
+  A UE belongs to the shard mme_ue_s1ap_id % nb_workers for its whole life and
+  only the tasks of this shard handle it. Identifiers given to peers before the
+  mme_ue_s1ap_id is known to them (M-TMSI, MME S11 TEID) carry the shard in their
+  MME_APP_SHARD_TAG_BITS low bits so that S1AP and S11 can route without lookup.
+  \author
+  \company
+  \email
+*/
+
+#ifndef FILE_MME_APP_SHARD_SEEN
+#define FILE_MME_APP_SHARD_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+#include "as_message.h"
+#include "intertask_interface_types.h"
+
+#define MME_APP_MAX_WORKERS       16
+#define MME_APP_SHARD_TAG_BITS    4
+#define MME_APP_SHARD_TAG_MASK    ((uint32_t)((1 << MME_APP_SHARD_TAG_BITS) - 1))
+
+extern int                              mme_app_nb_workers;
+extern const task_id_t                  mme_app_shard_tasks[MME_APP_MAX_WORKERS];
+extern const task_id_t                  nas_shard_tasks[MME_APP_MAX_WORKERS];
+// shard of the MME_APP or NAS task running on the calling thread, 0 for other threads
+extern __thread int                     mme_app_current_shard;
+
+int mme_app_shard_init (const uint32_t nb_workers);
+
+// Waits for the MME_APP and NAS tasks of all the shards to terminate
+void mme_app_shard_exit_wait (void);
+
+mme_ue_s1ap_id_t mme_app_shard_new_ue_id (void);
+
+// the id of a restored UE context will not be given again by mme_app_shard_new_ue_id
+void mme_app_shard_reserve_ue_id (const mme_ue_s1ap_id_t ue_id);
+
+int       mme_app_shard_of_initial_ue (const as_stmsi_t * const opt_s_tmsi, const uint32_t enb_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id);
+
+task_id_t mme_app_task_of_initial_ue (const as_stmsi_t * const opt_s_tmsi, const uint32_t enb_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id);
+
+// Tells S1AP to drop a new initial UE message, the MME_APP or NAS task of its shard is overloaded
+bool      mme_app_shard_overloaded (const int shard);
+
+task_id_t mme_app_task_of_imsi (const char * const imsi);
+
+task_id_t nas_task_of_imsi (const char * const imsi);
+
+static inline int mme_app_shard_of_ue_id (const mme_ue_s1ap_id_t ue_id)
+{
+  return (int)(ue_id % (mme_ue_s1ap_id_t)mme_app_nb_workers);
+}
+
+static inline task_id_t mme_app_task_of_ue_id (const mme_ue_s1ap_id_t ue_id)
+{
+  return mme_app_shard_tasks[mme_app_shard_of_ue_id (ue_id)];
+}
+
+static inline task_id_t nas_task_of_ue_id (const mme_ue_s1ap_id_t ue_id)
+{
+  return nas_shard_tasks[mme_app_shard_of_ue_id (ue_id)];
+}
+
+static inline bool mme_app_is_ue_id_in_current_shard (const mme_ue_s1ap_id_t ue_id)
+{
+  return mme_app_shard_of_ue_id (ue_id) == mme_app_current_shard;
+}
+
+// Replace the low bits of an identifier allocated for the UE by its shard.
+static inline uint32_t mme_app_shard_tag (const uint32_t value, const mme_ue_s1ap_id_t ue_id)
+{
+  return (value & ~MME_APP_SHARD_TAG_MASK) | (uint32_t)mme_app_shard_of_ue_id (ue_id);
+}
+
+// Shard carried by a tagged identifier, -1 if it was not allocated by this MME configuration.
+static inline int mme_app_shard_of_tag (const uint32_t tag)
+{
+  int                                     shard = (int)(tag & MME_APP_SHARD_TAG_MASK);
+
+  return (shard < mme_app_nb_workers) ? shard : -1;
+}
+
+static inline task_id_t mme_app_task_of_s11_teid (const teid_t teid)
+{
+  int                                     shard = mme_app_shard_of_tag (teid);
+
+  return mme_app_shard_tasks[(shard < 0) ? 0 : shard];
+}
+
+#endif /* FILE_MME_APP_SHARD_SEEN */
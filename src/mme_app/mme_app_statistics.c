@@ -20,147 +20,254 @@
  */
 
 
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
 
 #include "intertask_interface.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "metrics.h"
+
+/*
+ * The statistics are metrics (per thread cells, no lock on update), the
+ * current status are gauges and the changes are counters, the display
+ * computes the changes since the previous display from the counters.
+ */
+typedef enum {
+  MME_APP_STAT_ENB_CONNECTED = 0,
+  MME_APP_STAT_UE_ATTACHED,
+  MME_APP_STAT_UE_CONNECTED,
+  MME_APP_STAT_DEFAULT_BEARERS,
+  MME_APP_STAT_S1U_BEARERS,
+  MME_APP_STAT_S6A_REQUESTS,
+  MME_APP_STAT_MAX
+} mme_app_stat_t;
+
+static const struct {
+  const char *gauge;
+  const char *added;
+  const char *removed;
+  const char *help;
+} mme_app_stat_names[MME_APP_STAT_MAX] = {
+  {"mme_enb_connected",      "mme_enb_connected_total",                "mme_enb_released_total",                "eNBs"},
+  {"mme_ue_attached",        "mme_ue_attached_total",                  "mme_ue_detached_total",                 "attached UEs"},
+  {"mme_ue_connected",       "mme_ue_connected_total",                 "mme_ue_disconnected_total",             "ECM connected UEs"},
+  {"mme_default_bearers",    "mme_default_bearers_established_total",  "mme_default_bearers_released_total",    "default EPS bearers"},
+  {"mme_s1u_bearers",        "mme_s1u_bearers_established_total",      "mme_s1u_bearers_released_total",        "S1-U bearers"},
+  {"mme_s6a_outstanding",    "mme_s6a_requests_total",                 "mme_s6a_answers_total",                 "S6A requests waiting for their answer"},
+};
 
+static const struct {
+  const char *label;
+  const char *name;
+  const char *help;
+} mme_app_latency_names[MME_APP_LATENCY_MAX] = {
+  {"Attach",          "mme_attach_duration_seconds",          "Attach procedures, from attach request to attach complete"},
+  {"TAU",             "mme_tau_duration_seconds",             "Tracking area update procedures, from TAU request to TAU accept"},
+  {"Service request", "mme_service_request_duration_seconds", "Service requests, from initial UE message to S1-U bearer modified"},
+  {"S6A AIR",         "mme_s6a_air_duration_seconds",         "S6A Authentication Information Request round trips"},
+  {"S6A ULR",         "mme_s6a_ulr_duration_seconds",         "S6A Update Location Request round trips"},
+  {"S11 CSR",         "mme_s11_csr_duration_seconds",         "S11 Create Session Request round trips"},
+};
+
+static struct {
+  metric_id_t gauge[MME_APP_STAT_MAX];
+  metric_id_t added[MME_APP_STAT_MAX];
+  metric_id_t removed[MME_APP_STAT_MAX];
+  metric_id_t latency[MME_APP_LATENCY_MAX];
+  // S6A requests sent and neither answered nor failed, the gauge is set from it
+  int64_t     s6a_outstanding;
+  // counters at the previous display, only accessed by the MME_APP statistics timer
+  int64_t     last_added[MME_APP_STAT_MAX];
+  int64_t     last_removed[MME_APP_STAT_MAX];
+} mme_app_stats = {
+  .gauge   = {[0 ... MME_APP_STAT_MAX - 1] = METRIC_ID_INVALID},
+  .added   = {[0 ... MME_APP_STAT_MAX - 1] = METRIC_ID_INVALID},
+  .removed = {[0 ... MME_APP_STAT_MAX - 1] = METRIC_ID_INVALID},
+  .latency = {[0 ... MME_APP_LATENCY_MAX - 1] = METRIC_ID_INVALID},
+};
+
+//------------------------------------------------------------------------------
+/*
+ * Must be called before the tasks updating the statistics are started.
+ */
+int mme_app_statistics_init (
+  void)
+{
+  char                                    help[METRICS_HELP_MAX_LENGTH];
+
+  for (int i = 0; i < MME_APP_STAT_MAX; i++) {
+    snprintf (help, sizeof (help), "Current number of %s", mme_app_stat_names[i].help);
+    mme_app_stats.gauge[i] = metrics_register_gauge (mme_app_stat_names[i].gauge, help);
+    snprintf (help, sizeof (help), "Total number of %s added", mme_app_stat_names[i].help);
+    mme_app_stats.added[i] = metrics_register_counter (mme_app_stat_names[i].added, help);
+    snprintf (help, sizeof (help), "Total number of %s removed", mme_app_stat_names[i].help);
+    mme_app_stats.removed[i] = metrics_register_counter (mme_app_stat_names[i].removed, help);
+  }
+  for (int i = 0; i < MME_APP_LATENCY_MAX; i++) {
+    mme_app_stats.latency[i] = metrics_register_histogram (mme_app_latency_names[i].name, mme_app_latency_names[i].help);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
 int mme_app_statistics_display (
   void)
 {
+  int64_t                                 current[MME_APP_STAT_MAX];
+  int64_t                                 added[MME_APP_STAT_MAX];
+  int64_t                                 removed[MME_APP_STAT_MAX];
+  metrics_histogram_report_t             *report = NULL;
+
+  for (int i = 0; i < MME_APP_STAT_MAX; i++) {
+    current[i] = metrics_get_value (mme_app_stats.gauge[i]);
+    added[i] = metrics_get_value (mme_app_stats.added[i]);
+    removed[i] = metrics_get_value (mme_app_stats.removed[i]);
+  }
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
   OAILOG_DEBUG (LOG_MME_APP, "               |   Current Status| Added since last display|  Removed since last display |\n");
-  OAILOG_DEBUG (LOG_MME_APP, "Connected eNBs | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_enb_connected,
-                                          mme_app_desc.nb_enb_connected_since_last_stat,mme_app_desc.nb_enb_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Attached UEs   | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_attached,
-                                          mme_app_desc.nb_ue_attached_since_last_stat,mme_app_desc.nb_ue_detached_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Connected UEs  | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_connected,
-                                          mme_app_desc.nb_ue_connected_since_last_stat,mme_app_desc.nb_ue_disconnected_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Default Bearers| %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_default_eps_bearers,
-                                          mme_app_desc.nb_eps_bearers_established_since_last_stat,mme_app_desc.nb_eps_bearers_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10u      |     %10u              |    %10u               |\n\n",mme_app_desc.nb_s1u_bearers,
-                                          mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
+  OAILOG_DEBUG (LOG_MME_APP, "Connected eNBs | %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n",current[MME_APP_STAT_ENB_CONNECTED],
+                                          added[MME_APP_STAT_ENB_CONNECTED] - mme_app_stats.last_added[MME_APP_STAT_ENB_CONNECTED],
+                                          removed[MME_APP_STAT_ENB_CONNECTED] - mme_app_stats.last_removed[MME_APP_STAT_ENB_CONNECTED]);
+  OAILOG_DEBUG (LOG_MME_APP, "Attached UEs   | %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n",current[MME_APP_STAT_UE_ATTACHED],
+                                          added[MME_APP_STAT_UE_ATTACHED] - mme_app_stats.last_added[MME_APP_STAT_UE_ATTACHED],
+                                          removed[MME_APP_STAT_UE_ATTACHED] - mme_app_stats.last_removed[MME_APP_STAT_UE_ATTACHED]);
+  OAILOG_DEBUG (LOG_MME_APP, "Connected UEs  | %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n",current[MME_APP_STAT_UE_CONNECTED],
+                                          added[MME_APP_STAT_UE_CONNECTED] - mme_app_stats.last_added[MME_APP_STAT_UE_CONNECTED],
+                                          removed[MME_APP_STAT_UE_CONNECTED] - mme_app_stats.last_removed[MME_APP_STAT_UE_CONNECTED]);
+  OAILOG_DEBUG (LOG_MME_APP, "Default Bearers| %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n",current[MME_APP_STAT_DEFAULT_BEARERS],
+                                          added[MME_APP_STAT_DEFAULT_BEARERS] - mme_app_stats.last_added[MME_APP_STAT_DEFAULT_BEARERS],
+                                          removed[MME_APP_STAT_DEFAULT_BEARERS] - mme_app_stats.last_removed[MME_APP_STAT_DEFAULT_BEARERS]);
+  OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n",current[MME_APP_STAT_S1U_BEARERS],
+                                          added[MME_APP_STAT_S1U_BEARERS] - mme_app_stats.last_added[MME_APP_STAT_S1U_BEARERS],
+                                          removed[MME_APP_STAT_S1U_BEARERS] - mme_app_stats.last_removed[MME_APP_STAT_S1U_BEARERS]);
+  OAILOG_DEBUG (LOG_MME_APP, "S6A requests   | %10" PRId64 "      |     %10" PRId64 "              |    %10" PRId64 "               |\n\n",current[MME_APP_STAT_S6A_REQUESTS],
+                                          added[MME_APP_STAT_S6A_REQUESTS] - mme_app_stats.last_added[MME_APP_STAT_S6A_REQUESTS],
+                                          removed[MME_APP_STAT_S6A_REQUESTS] - mme_app_stats.last_removed[MME_APP_STAT_S6A_REQUESTS]);
+  report = malloc (sizeof (metrics_histogram_report_t));
+  if (report) {
+    OAILOG_DEBUG (LOG_MME_APP, "Latencies (us) |     count |      p50 |      p99 |    p99.9 |\n");
+    for (int i = 0; i < MME_APP_LATENCY_MAX; i++) {
+      metrics_get_histogram (mme_app_stats.latency[i], report);
+      OAILOG_DEBUG (LOG_MME_APP, "%-15s| %9" PRIu64 " | %8" PRIu64 " | %8" PRIu64 " | %8" PRIu64 " |\n", mme_app_latency_names[i].label, report->count,
+          metrics_histogram_percentile (report, 50.0), metrics_histogram_percentile (report, 99.0), metrics_histogram_percentile (report, 99.9));
+    }
+    free (report);
+  }
+  bstring pools = bfromcstr ("");
+  slab_pool_dump_stats (pools);
+  mme_app_ue_context_memory_report (pools);
+  mme_app_eviction_report (pools);
+  mme_app_checkpoint_report (pools);
+  OAILOG_DEBUG (LOG_MME_APP, "Context pools:\n%s\n", bdata (pools));
+  bdestroy (pools);
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
-  
-  mme_stats_write_lock (&mme_app_desc);
-  
-  // resetting stats for next display
-  mme_app_desc.nb_enb_connected_since_last_stat = 0;
-  mme_app_desc.nb_enb_released_since_last_stat  = 0;
-  mme_app_desc.nb_ue_connected_since_last_stat  = 0;
-  mme_app_desc.nb_ue_disconnected_since_last_stat  = 0;
-  mme_app_desc.nb_s1u_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_s1u_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_ue_attached_since_last_stat = 0;
-  mme_app_desc.nb_ue_detached_since_last_stat = 0;
-  
-  mme_stats_unlock(&mme_app_desc);
 
+  // changes for next display
+  for (int i = 0; i < MME_APP_STAT_MAX; i++) {
+    mme_app_stats.last_added[i] = added[i];
+    mme_app_stats.last_removed[i] = removed[i];
+  }
   return 0;
 }
 
 /*********************************** Utility Functions to update Statistics**************************************/
 
+//------------------------------------------------------------------------------
+static inline void update_mme_app_stats_add (const mme_app_stat_t stat)
+{
+  metrics_gauge_add (mme_app_stats.gauge[stat], 1);
+  metrics_counter_add (mme_app_stats.added[stat], 1);
+}
+
+//------------------------------------------------------------------------------
+static inline void update_mme_app_stats_sub (const mme_app_stat_t stat)
+{
+  metrics_gauge_add (mme_app_stats.gauge[stat], -1);
+  metrics_counter_add (mme_app_stats.removed[stat], 1);
+}
+
 // Number of Connected eNBs 
 void update_mme_app_stats_connected_enb_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_enb_connected)++;
-  (mme_app_desc.nb_enb_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_add (MME_APP_STAT_ENB_CONNECTED);
 }
 void update_mme_app_stats_connected_enb_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_enb_connected !=0)
-    (mme_app_desc.nb_enb_connected)--;
-  (mme_app_desc.nb_enb_released_since_last_stat)--;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_sub (MME_APP_STAT_ENB_CONNECTED);
 }
 
 /*****************************************************/
 // Number of Connected UEs
 void update_mme_app_stats_connected_ue_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_connected)++;
-  (mme_app_desc.nb_ue_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_add (MME_APP_STAT_UE_CONNECTED);
 }
 void update_mme_app_stats_connected_ue_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_connected !=0)
-    (mme_app_desc.nb_ue_connected)--;
-  (mme_app_desc.nb_ue_disconnected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_sub (MME_APP_STAT_UE_CONNECTED);
 }
 
 /*****************************************************/
 // Number of S1U Bearers 
 void update_mme_app_stats_s1u_bearer_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_s1u_bearers)++;
-  (mme_app_desc.nb_s1u_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_add (MME_APP_STAT_S1U_BEARERS);
 }
 void update_mme_app_stats_s1u_bearer_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_s1u_bearers !=0)
-    (mme_app_desc.nb_s1u_bearers)--;
-  (mme_app_desc.nb_s1u_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_sub (MME_APP_STAT_S1U_BEARERS);
 }
 
 /*****************************************************/
 // Number of Default EPS Bearers 
 void update_mme_app_stats_default_bearer_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_default_eps_bearers)++;
-  (mme_app_desc.nb_eps_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_add (MME_APP_STAT_DEFAULT_BEARERS);
 }
 void update_mme_app_stats_default_bearer_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_default_eps_bearers !=0)
-    (mme_app_desc.nb_default_eps_bearers)--;
-  (mme_app_desc.nb_eps_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_sub (MME_APP_STAT_DEFAULT_BEARERS);
 }
 
 /*****************************************************/
 // Number of Attached UEs 
 void update_mme_app_stats_attached_ue_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_attached)++;
-  (mme_app_desc.nb_ue_attached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_add (MME_APP_STAT_UE_ATTACHED);
 }
 void update_mme_app_stats_attached_ue_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_attached !=0)
-    (mme_app_desc.nb_ue_attached)--;
-  (mme_app_desc.nb_ue_detached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  update_mme_app_stats_sub (MME_APP_STAT_UE_ATTACHED);
+}
+
+/*****************************************************/
+// Number of S6A requests sent (AIR, ULR) waiting for their answer, removed on
+// the answer or when the request failed (no answer from any peer, rejected)
+void update_mme_app_stats_s6a_request_add(void)
+{
+  metrics_gauge_set (mme_app_stats.gauge[MME_APP_STAT_S6A_REQUESTS], __atomic_add_fetch (&mme_app_stats.s6a_outstanding, 1, __ATOMIC_RELAXED));
+  metrics_counter_add (mme_app_stats.added[MME_APP_STAT_S6A_REQUESTS], 1);
+}
+void update_mme_app_stats_s6a_request_sub(void)
+{
+  metrics_gauge_set (mme_app_stats.gauge[MME_APP_STAT_S6A_REQUESTS], __atomic_sub_fetch (&mme_app_stats.s6a_outstanding, 1, __ATOMIC_RELAXED));
+  metrics_counter_add (mme_app_stats.removed[MME_APP_STAT_S6A_REQUESTS], 1);
+}
+int64_t mme_app_stats_s6a_outstanding(void)
+{
+  return __atomic_load_n (&mme_app_stats.s6a_outstanding, __ATOMIC_RELAXED);
+}
+
+/*****************************************************/
+// Procedure latencies
+void update_mme_app_stats_latency(const mme_app_latency_t latency, const uint64_t start_ns)
+{
+  if (latency < MME_APP_LATENCY_MAX) {
+    metrics_histogram_record_since (mme_app_stats.latency[latency], start_ns);
+  }
 }
 /*****************************************************/
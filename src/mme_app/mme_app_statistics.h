@@ -23,6 +23,22 @@
 #ifndef FILE_MME_APP_STATISTICS_SEEN
 #define FILE_MME_APP_STATISTICS_SEEN
 
+#include <stdint.h>
+
+#include "metrics.h"
+
+// Procedures and round trips timed by the MME, see update_mme_app_stats_latency()
+typedef enum {
+  MME_APP_LATENCY_ATTACH = 0,             // Attach request to attach complete
+  MME_APP_LATENCY_TAU,                    // TAU request to TAU accept
+  MME_APP_LATENCY_SERVICE_REQUEST,        // Initial UE message to S1-U bearer modified
+  MME_APP_LATENCY_S6A_AIR,                // S6A Authentication Information round trip
+  MME_APP_LATENCY_S6A_ULR,                // S6A Update Location round trip
+  MME_APP_LATENCY_S11_CSR,                // S11 Create Session round trip
+  MME_APP_LATENCY_MAX
+} mme_app_latency_t;
+
+int mme_app_statistics_init(void);
 int mme_app_statistics_display(void);
 
 /*********************************** Utility Functions to update Statistics**************************************/
@@ -36,5 +52,11 @@ void update_mme_app_stats_default_bearer_add(void);
 void update_mme_app_stats_default_bearer_sub(void);
 void update_mme_app_stats_attached_ue_add(void);
 void update_mme_app_stats_attached_ue_sub(void);
+void update_mme_app_stats_s6a_request_add(void);
+void update_mme_app_stats_s6a_request_sub(void);
+int64_t mme_app_stats_s6a_outstanding(void);
+
+// start_ns is a metrics_now_ns() timestamp, 0 if the procedure was not timed
+void update_mme_app_stats_latency(const mme_app_latency_t latency, const uint64_t start_ns);
 
 #endif /* FILE_MME_APP_STATISTICS_SEEN */
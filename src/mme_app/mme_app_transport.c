@@ -39,6 +39,7 @@
 #include "sgw_ie_defs.h"
 #include "mme_app_itti_messaging.h"
 #include "secu_defs.h"
+#include "nas_buffer.h"
 
 #include "assertions.h"
 #include "common_types.h"
@@ -56,21 +57,23 @@ int mme_app_handle_nas_dl_req (
 
   OAILOG_FUNC_IN (LOG_MME_APP);
 
-  message_p = itti_alloc_new_message (TASK_MME_APP, S1AP_NAS_DL_DATA_REQ);
-  memset ((void *)&message_p->ittiMsg.s1ap_nas_dl_data_req, 0, sizeof (itti_s1ap_nas_dl_data_req_t));
-
   ue_context_t   *ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, nas_dl_req_pP->ue_id);
-  DevAssert(ue_context != NULL);
   if (ue_context) {
     enb_ue_s1ap_id = ue_context->enb_ue_s1ap_id;
   } else {
     OAILOG_WARNING (LOG_MME_APP, " MME_APP:DOWNLINK NAS TRANSPORT. Null UE Context for mme_ue_s1ap_id %d \n", nas_dl_req_pP->ue_id);
+    // the NAS message is not sent, its buffer is pooled
+    nas_buffer_free (&nas_dl_req_pP->nas_msg);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+
+  message_p = itti_alloc_new_message (TASK_MME_APP, S1AP_NAS_DL_DATA_REQ);
+  memset ((void *)&message_p->ittiMsg.s1ap_nas_dl_data_req, 0, sizeof (itti_s1ap_nas_dl_data_req_t));
   
   S1AP_NAS_DL_DATA_REQ (message_p).enb_ue_s1ap_id         = enb_ue_s1ap_id;
   S1AP_NAS_DL_DATA_REQ (message_p).mme_ue_s1ap_id         = nas_dl_req_pP->ue_id;
   S1AP_NAS_DL_DATA_REQ (message_p).nas_msg                = nas_dl_req_pP->nas_msg;
+  nas_dl_req_pP->nas_msg = NULL;
 
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,TASK_S1AP,NULL, 0,
       "0 DOWNLINK NAS TRANSPORT enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " ue id " MME_UE_S1AP_ID_FMT " ",
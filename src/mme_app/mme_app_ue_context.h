@@ -39,8 +39,10 @@
 #include <time.h>       /* to provide time_t */
 
 #include "tree.h"
+#include "queue.h"
 #include "hashtable.h"
 #include "obj_hashtable.h"
+#include "slab_pool.h"
 #include "bstrlib.h"
 #include "common_types.h"
 #include "s1ap_messages_types.h"
@@ -79,7 +81,6 @@ void mme_app_imsi_to_string(char * const imsi_dst, mme_app_imsi_t const * const
 uint64_t mme_app_imsi_to_u64 (mme_app_imsi_t imsi_src);
 void mme_app_ue_context_uint_to_imsi(uint64_t imsi_src, mme_app_imsi_t *imsi_dst);
 void mme_app_convert_imsi_to_imsi_mme (mme_app_imsi_t * imsi_dst, const imsi_t *imsi_src);
-mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void);
 /*
  * Timer identifier returned when in inactive state (timer is stopped or has
  * failed to be started)
@@ -124,11 +125,59 @@ typedef struct bearer_context_s {
 } bearer_context_t;
 
 
+/** @struct ue_subscription_t
+ *  @brief Subscription data of an UE, allocated on reception of the S6A
+ *  UPDATE LOCATION ANSWER.
+ */
+typedef struct ue_subscription_s {
+  subscriber_status_t    sub_status;                   // set by S6A UPDATE LOCATION ANSWER
+  ard_t                  access_restriction_data;      // set by S6A UPDATE LOCATION ANSWER
+  network_access_mode_t  access_mode;                  // set by S6A UPDATE LOCATION ANSWER
+  rau_tau_timer_t        rau_tau_timer;               // set by S6A UPDATE LOCATION ANSWER
+  ambr_t                 subscribed_ambr;              // set by S6A UPDATE LOCATION ANSWER
+  uint8_t                msisdn[MSISDN_LENGTH+1];     // set by S6A UPDATE LOCATION ANSWER
+  uint8_t                msisdn_length;               // set by S6A UPDATE LOCATION ANSWER
+  apn_config_profile_t   apn_profile;                  // set by S6A UPDATE LOCATION ANSWER
+} ue_subscription_t;
+
+/** @struct pending_pdn_connectivity_req_t
+ *  @brief NAS PDN connectivity request kept from its reception up to the
+ *  S11 CREATE SESSION RESPONSE.
+ */
+typedef struct pending_pdn_connectivity_req_s {
+  char                   imsi[16];
+  uint8_t                imsi_length;
+  bstring                apn;
+  bstring                pdn_addr;
+  int                    pti;
+  unsigned               ue_id;
+  network_qos_t          qos;
+  protocol_configuration_options_t   pco;
+  void                  *proc_data;                   // esm_proc_data_t*, not owned
+  int                    request_type;
+} pending_pdn_connectivity_req_t;
+
 /** @struct ue_context_t
  *  @brief Useful parameters to know in MME application layer. They are set
  * according to 3GPP TS.23.401 #5.7.2
+ *
+ * The fields read or written by most of the signalling procedures come first
+ * and fit in the first cache lines, the subscription data, the pending PDN
+ * connectivity request and the dedicated bearer contexts are allocated
+ * separately, only when and as long as they are needed.
  */
 typedef struct ue_context_s {
+  mme_ue_s1ap_id_t       mme_ue_s1ap_id;
+  enb_ue_s1ap_id_t       enb_ue_s1ap_id:24;
+  enb_s1ap_id_key_t      enb_s1ap_id_key; // key uniq among all connected eNBs
+  sctp_assoc_id_t        sctp_assoc_id_key;
+  mm_state_t             mm_state;
+  ecm_state_t            ecm_state;
+  enum s1cause           ue_context_rel_cause;
+  bool                   pending_handover;             // handover pending
+  bool                   is_guti_set;                 // is guti has been set
+  ebi_t                  default_bearer_id;
+
   /* Basic identifier for ue. IMSI is encoded on maximum of 15 digits of 4 bits,
    * so usage of an unsigned integer on 64 bits is necessary.
    */
@@ -137,57 +186,54 @@ typedef struct ue_context_s {
 #define IMSI_AUTHENTICATED    (0x1)
   /* Indicator to show the IMSI authentication state */
   unsigned               imsi_auth:1;                 // set by nas_auth_resp_t
-
-  enb_s1ap_id_key_t      enb_s1ap_id_key; // key uniq among all connected eNBs
-  enb_ue_s1ap_id_t       enb_ue_s1ap_id:24;
-  mme_ue_s1ap_id_t       mme_ue_s1ap_id;
-  sctp_assoc_id_t        sctp_assoc_id_key;
-
-  enum s1cause           ue_context_rel_cause;
-
-
 #define SUBSCRIPTION_UNKNOWN    0x0
 #define SUBSCRIPTION_KNOWN      0x1
   unsigned               subscription_known:1;        // set by S6A UPDATE LOCATION ANSWER
-  uint8_t                msisdn[MSISDN_LENGTH+1];     // set by S6A UPDATE LOCATION ANSWER
-  uint8_t                msisdn_length;               // set by S6A UPDATE LOCATION ANSWER
 
-  bool                   pending_handover;             // handover pending
-  mm_state_t             mm_state;
-  ecm_state_t            ecm_state;
+  teid_t                 mme_s11_teid;                // set by mme_app_send_s11_create_session_req
+  teid_t                 sgw_s11_teid;                // set by S11 CREATE_SESSION_RESPONSE
+
   /* Globally Unique Temporary Identity */
-  bool                   is_guti_set;                 // is guti has been set
   guti_t                 guti;                        // guti.gummei.plmn set by nas_auth_param_req_t
-  // read by S6A UPDATE LOCATION REQUEST
-  me_identity_t          me_identity;                 // not set/read except read by display utility
 
-  /* TODO: Add TAI list */
+  // Mobile Reachability Timer-Start when UE moves to idle state. Stop when UE moves to connected state
+  struct mme_app_timer_t       mobile_reachability_timer;
+  // Implicit Detach Timer-Start at the expiry of Mobile Reachability timer. Stop when UE moves to connected state
+  struct mme_app_timer_t       implicit_detach_timer;
+  // Initial Context Setup Procedure Guard timer
+  struct mme_app_timer_t       initial_context_setup_rsp_timer;
+
+  // Handover related stuff
+  struct mme_app_timer_t       path_switch_req_timer;
+
+  // Paging on S11 DOWNLINK DATA NOTIFICATION, T3413. Stop when UE moves to connected state
+  struct mme_app_timer_t       paging_timer;
+  uint8_t                paging_attempts;             // PAGINGs sent for the paging in progress, 0 if none
+
+  bearer_context_t      *eps_bearers[BEARERS_PER_UE];  // NULL until created by S11 CREATE_SESSION_RESPONSE
+  // Storage of the first bearer created (the default bearer for most UEs), others come from bearer_context_pool
+  bearer_context_t       embedded_bearer;
 
   /* Last known cell identity */
   ecgi_t                  e_utran_cgi;                 // set by nas_attach_req_t
   // read for S11 CREATE_SESSION_REQUEST
   /* Time when the cell identity was acquired */
   time_t                 cell_age;                    // set by nas_auth_param_req_t
+  /* Last known tracking area, where the paging starts */
+  tai_t                  last_tai;                    // TAI of the last S1AP message of the UE
 
+  /* TODO: Add TAI list */
   /* TODO: add csg_id */
   /* TODO: add csg_membership */
-
-  network_access_mode_t  access_mode;                  // set by S6A UPDATE LOCATION ANSWER
-
   /* TODO: add ue radio cap, ms classmarks, supported codecs */
-
   /* TODO: add ue network capability, ms network capability */
   /* TODO: add selected NAS algorithm */
-
   /* TODO: add DRX parameter */
 
-  apn_config_profile_t   apn_profile;                  // set by S6A UPDATE LOCATION ANSWER
-  ard_t                  access_restriction_data;      // set by S6A UPDATE LOCATION ANSWER
-  subscriber_status_t    sub_status;                   // set by S6A UPDATE LOCATION ANSWER
-  ambr_t                 subscribed_ambr;              // set by S6A UPDATE LOCATION ANSWER
+  // read by S6A UPDATE LOCATION REQUEST
+  me_identity_t          me_identity;                 // not set/read except read by display utility
   ambr_t                 used_ambr;
-
-  rau_tau_timer_t        rau_tau_timer;               // set by S6A UPDATE LOCATION ANSWER
+  PAA_t                  paa;                         // set by S11 CREATE_SESSION_RESPONSE
 
   /* Store the radio capabilities as received in S1AP UE capability indication
    * message.
@@ -195,35 +241,26 @@ typedef struct ue_context_s {
   uint8_t                  *ue_radio_capabilities;
   int                    ue_radio_cap_length;
 
-  teid_t                 mme_s11_teid;                // set by mme_app_send_s11_create_session_req
-  teid_t                 sgw_s11_teid;                // set by S11 CREATE_SESSION_RESPONSE
-  PAA_t                  paa;                         // set by S11 CREATE_SESSION_RESPONSE
+  /* Start (metrics_now_ns) of the timed procedures in progress, 0 if none */
+  uint64_t               s6a_ulr_start_ns;            // S6A UPDATE LOCATION round trip
+  uint64_t               s11_csr_start_ns;            // S11 CREATE SESSION round trip
+  uint64_t               service_request_start_ns;    // S1 initial UE message up to S11 MODIFY BEARER RESPONSE
+  // trace (itti_trace_id_t) of the signalling connection, resumed on the messages received from outside ITTI
+  uint32_t               trace_id;
 
-  // temp
-  char                   pending_pdn_connectivity_req_imsi[16];
-  uint8_t                pending_pdn_connectivity_req_imsi_length;
-  bstring                pending_pdn_connectivity_req_apn;
-  bstring                pending_pdn_connectivity_req_pdn_addr;
-  int                    pending_pdn_connectivity_req_pti;
-  unsigned               pending_pdn_connectivity_req_ue_id;
-  network_qos_t          pending_pdn_connectivity_req_qos;
-  protocol_configuration_options_t   pending_pdn_connectivity_req_pco;
-  void                  *pending_pdn_connectivity_req_proc_data;
-  int                    pending_pdn_connectivity_req_request_type;
-  ebi_t                  default_bearer_id;
-  bearer_context_t       eps_bearers[BEARERS_PER_UE];
-  
-  // Mobile Reachability Timer-Start when UE moves to idle state. Stop when UE moves to connected state
-  struct mme_app_timer_t       mobile_reachability_timer; 
-  // Implicit Detach Timer-Start at the expiry of Mobile Reachability timer. Stop when UE moves to connected state
-  struct mme_app_timer_t       implicit_detach_timer; 
-  // Initial Context Setup Procedure Guard timer 
-  struct mme_app_timer_t       initial_context_setup_rsp_timer; 
-
-  // Handover related stuff
-  struct mme_app_timer_t       path_switch_req_timer;
+  // position in the list of the UEs in ECM-IDLE of the shard, least recently idle first, see mme_app_eviction.c
+  TAILQ_ENTRY (ue_context_s) idle_entries;
+  uint64_t               idle_since_ns;               // metrics_now_ns when listed, 0 if not in the list
+  uint64_t               evicting_since_ns;           // idle_since_ns of the UE taken from the list to be evicted, 0 if none
+  // position in the list of the UEs of the shard waiting for their checkpoint, see mme_app_checkpoint.c
+  TAILQ_ENTRY (ue_context_s) checkpoint_entries;
+  uint32_t               checkpoint_slot;             // record of the UE in the checkpoint file, 0 if none
+  bool                   checkpoint_pending;          // in the list
+  uint32_t               checkpoint_generation;       // incremented when the record of the UE is forgotten, a record built before is dropped
 
-} ue_context_t;
+  ue_subscription_t                *subscription;                   // NULL until S6A UPDATE LOCATION ANSWER
+  pending_pdn_connectivity_req_t   *pending_pdn_connectivity_req;   // NULL outside PDN connectivity procedures
+} __attribute__ ((aligned (SLAB_POOL_OBJECT_ALIGN))) ue_context_t;
 
 
 typedef struct mme_ue_context_s {
@@ -232,6 +269,10 @@ typedef struct mme_ue_context_s {
   hash_table_ts_t       *mme_ue_s1ap_id_ue_context_htbl;
   hash_table_ts_t       *enb_ue_s1ap_id_ue_context_htbl;
   obj_hash_table_t      *guti_ue_context_htbl;
+  slab_pool_t           *ue_context_pool;       // storage of ue_context_t
+  slab_pool_t           *subscription_pool;     // storage of ue_subscription_t
+  slab_pool_t           *pending_pdn_connectivity_req_pool; // storage of pending_pdn_connectivity_req_t
+  slab_pool_t           *bearer_context_pool;   // storage of bearer_context_t
 } mme_ue_context_t;
 
 
@@ -351,6 +392,30 @@ void mme_remove_ue_context(mme_ue_context_t * const mme_ue_context,
  **/
 ue_context_t *mme_create_new_ue_context(void);
 
+/** \brief Get the subscription data of an UE context, allocated on first use
+ * @returns Pointer to the subscription data, NULL if allocation failed
+ **/
+ue_subscription_t *mme_app_get_ue_subscription(ue_context_t * const ue_context_p);
+
+/** \brief Get the pending PDN connectivity request of an UE context, allocated on first use
+ * @returns Pointer to the pending request, NULL if allocation failed
+ **/
+pending_pdn_connectivity_req_t *mme_app_get_pending_pdn_connectivity_req(ue_context_t * const ue_context_p);
+
+/** \brief Release the pending PDN connectivity request of an UE context, if any
+ **/
+void mme_app_free_pending_pdn_connectivity_req(ue_context_t * const ue_context_p);
+
+/** \brief Get a bearer context of an UE context, allocated on first use
+ * \param ebi EPS bearer identity, index in eps_bearers
+ * @returns Pointer to the bearer context, NULL if ebi is out of range or allocation failed
+ **/
+bearer_context_t *mme_app_get_bearer_context(ue_context_t * const ue_context_p, const ebi_t ebi);
+
+/** \brief Append the memory used per UE context to str
+ **/
+void mme_app_ue_context_memory_report(bstring str);
+
 /** \brief Dump the UE contexts present in the tree
  **/
 void mme_app_dump_ue_contexts(const mme_ue_context_t * const mme_ue_context);
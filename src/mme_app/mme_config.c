@@ -46,9 +46,11 @@
 #include "dynamic_memory_check.h"
 #include "log.h"
 #include "intertask_interface.h"
+#include "intertask_interface_trace.h"
 #include "spgw_config.h"
+#include "mme_config_snapshot.h"
 
-mme_config_t                            mme_config = {.rw_lock = PTHREAD_RWLOCK_INITIALIZER, 0};
+mme_config_t                            mme_config = {0};
 
 //------------------------------------------------------------------------------
 int mme_config_find_mnc_length (
@@ -62,7 +64,8 @@ int mme_config_find_mnc_length (
   uint16_t                                mcc = 100 * mcc_digit1P + 10 * mcc_digit2P + mcc_digit3P;
   uint16_t                                mnc3 = 100 * mnc_digit1P + 10 * mnc_digit2P + mnc_digit3P;
   uint16_t                                mnc2 = 10 * mnc_digit1P + mnc_digit2P;
-  int                                     plmn_index = 0;
+  const mme_config_snapshot_t            *snapshot = NULL;
+  int                                     mnc_length = 0;
 
   AssertFatal ((mcc_digit1P >= 0) && (mcc_digit1P <= 9)
                && (mcc_digit2P >= 0) && (mcc_digit2P <= 9)
@@ -70,27 +73,17 @@ int mme_config_find_mnc_length (
   AssertFatal ((mnc_digit2P >= 0) && (mnc_digit2P <= 9)
                && (mnc_digit1P >= 0) && (mnc_digit1P <= 9), "BAD MNC PARAMETER (%d.%d.%d)!\n", mnc_digit1P, mnc_digit2P, mnc_digit3P);
 
-  while (plmn_index < mme_config.served_tai.nb_tai) {
-    if (mme_config.served_tai.plmn_mcc[plmn_index] == mcc) {
-      if ((mme_config.served_tai.plmn_mnc[plmn_index] == mnc2) && (mme_config.served_tai.plmn_mnc_len[plmn_index] == 2)) {
-        return 2;
-      } else if ((mme_config.served_tai.plmn_mnc[plmn_index] == mnc3) && (mme_config.served_tai.plmn_mnc_len[plmn_index] == 3)) {
-        return 3;
-      }
-    }
-
-    plmn_index += 1;
-  }
-
-  return 0;
+  snapshot = mme_config_snapshot_acquire ();
+  mnc_length = mme_config_snapshot_mnc_length (snapshot, mcc, mnc2, mnc3);
+  mme_config_snapshot_release ();
+  return mnc_length;
 }
 
 
 //------------------------------------------------------------------------------
 static void mme_config_init (mme_config_t * config_pP)
 {
-  memset(&mme_config, 0, sizeof(mme_config));
-  pthread_rwlock_init (&config_pP->rw_lock, NULL);
+  memset(config_pP, 0, sizeof(*config_pP));
   config_pP->log_config.output             = NULL;
   config_pP->log_config.is_output_thread_safe = false;
   config_pP->log_config.color              = false;
@@ -112,6 +105,7 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->config_file = NULL;
   config_pP->max_enbs = 2;
   config_pP->max_ues = 2;
+  config_pP->nb_workers = 1;
   config_pP->unauthenticated_imsi_supported = 0;
   /*
    * EPS network feature support
@@ -132,8 +126,35 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->ipv4.port_s11 = 2123;
   config_pP->ipv4.sgw_s11 = 0;
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
+  config_pP->s6a_config.weighted_routing = false;
+  config_pP->s6a_config.inflight_window = 256;
+  config_pP->s6a_config.queue_size = 10000;
+  config_pP->s6a_config.request_timeout_ms = 5000;
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
+  config_pP->itti_config.trace_sampling = 0;
+  config_pP->itti_config.trace_buffer_size = ITTI_TRACE_DEFAULT_BUFFER_SIZE;
+  config_pP->itti_config.high_watermark = 0;
+  config_pP->metrics_config.unix_socket = NULL;
+  config_pP->metrics_config.port = 0;
+  config_pP->overload_config.period_ms = 0;
+  config_pP->overload_config.queue_depth = 0;
+  config_pP->overload_config.s6a_outstanding = 0;
+  config_pP->overload_config.cpu_percent = 0;
+  config_pP->paging_config.t3413_ms = 2000;
+  config_pP->paging_config.last_tai_attempts = 1;
+  config_pP->paging_config.tai_list_attempts = 2;
+  config_pP->paging_config.rate = 0;
+  config_pP->eviction_config.memory_budget_mb = 0;
+  config_pP->eviction_config.idle_timeout_sec = 0;
+  config_pP->eviction_config.period_ms = 1000;
+  config_pP->eviction_config.batch = 1000;
+  config_pP->eviction_config.max_evicted_ues = 0;
+  config_pP->eviction_config.cold_store_size = 0;
+  config_pP->checkpoint_config.file = NULL;
+  config_pP->checkpoint_config.capacity = 0;
+  config_pP->checkpoint_config.period_ms = 1000;
+  config_pP->checkpoint_config.batch = 10000;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
@@ -164,8 +185,21 @@ static void mme_config_init (mme_config_t * config_pP)
 }
 
 
+/*
+ * An invalid value stops the MME at startup. On a reload the MME keeps
+ * running with its current configuration: the value is logged and the
+ * parse fails.
+ */
+#define MME_CONFIG_CHECK(cOnD, ...) do {                                      \
+    if (!(cOnD)) {                                                            \
+      AssertFatal (is_reload, __VA_ARGS__);                                   \
+      OAILOG_ERROR (LOG_CONFIG, __VA_ARGS__);                                 \
+      goto invalid;                                                           \
+    }                                                                         \
+  } while (0)
+
 //------------------------------------------------------------------------------
-static int mme_config_parse_file (mme_config_t * config_pP)
+static int mme_config_parse_file (mme_config_t * config_pP, const bool is_reload)
 {
   config_t                                cfg = {0};
   config_setting_t                       *setting_mme = NULL;
@@ -199,13 +233,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
      */
     if (!config_read_file (&cfg, bdata(config_pP->config_file))) {
       OAILOG_ERROR (LOG_CONFIG, ": %s:%d - %s\n", bdata(config_pP->config_file), config_error_line (&cfg), config_error_text (&cfg));
-      config_destroy (&cfg);
-      AssertFatal (1 == 0, "Failed to parse MME configuration file %s!\n", bdata(config_pP->config_file));
+      MME_CONFIG_CHECK (0, "Failed to parse MME configuration file %s!\n", bdata(config_pP->config_file));
     }
   } else {
     OAILOG_ERROR (LOG_CONFIG, " No MME configuration file provided!\n");
-    config_destroy (&cfg);
-    AssertFatal (0, "No MME configuration file provided!\n");
+    MME_CONFIG_CHECK (0, "No MME configuration file provided!\n");
   }
 
   setting_mme = config_lookup (&cfg, MME_CONFIG_STRING_MME_CONFIG);
@@ -305,6 +337,7 @@ static int mme_config_parse_file (mme_config_t * config_pP)
     }
 
     if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_MAXENB, &aint))) {
+      MME_CONFIG_CHECK (0 < aint, "Bad %s %d, must be > 0\n", MME_CONFIG_STRING_MAXENB, aint);
       config_pP->max_enbs = (uint32_t) aint;
     }
 
@@ -313,9 +346,14 @@ static int mme_config_parse_file (mme_config_t * config_pP)
     }
 
     if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_RELATIVE_CAPACITY, &aint))) {
+      MME_CONFIG_CHECK ((0 <= aint) && (255 >= aint), "Bad %s %d, must be in [0, 255]\n", MME_CONFIG_STRING_RELATIVE_CAPACITY, aint);
       config_pP->relative_capacity = (uint8_t) aint;
     }
 
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_WORKERS, &aint))) {
+      config_pP->nb_workers = (uint32_t) aint;
+    }
+
     if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_STATISTIC_TIMER, &aint))) {
       config_pP->mme_statistic_timer = (uint32_t) aint;
     }
@@ -359,6 +397,104 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_SAMPLING, &aint))) {
+        config_pP->itti_config.trace_sampling = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_BUFFER_SIZE, &aint))) {
+        config_pP->itti_config.trace_buffer_size = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_HIGH_WATERMARK, &aint))) {
+        config_pP->itti_config.high_watermark = (uint32_t) aint;
+      }
+    }
+    // METRICS SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_METRICS_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_METRICS_UNIX_SOCKET, (const char **)&astring))) {
+        if (astring != NULL) {
+          config_pP->metrics_config.unix_socket = bfromcstr(astring);
+        }
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_METRICS_PORT, &aint))) {
+        config_pP->metrics_config.port = (uint16_t) aint;
+      }
+    }
+    // OVERLOAD SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_OVERLOAD_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_PERIOD_MS, &aint))) {
+        config_pP->overload_config.period_ms = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_QUEUE_DEPTH, &aint))) {
+        config_pP->overload_config.queue_depth = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_S6A_OUTSTANDING, &aint))) {
+        config_pP->overload_config.s6a_outstanding = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_CPU_PERCENT, &aint))) {
+        config_pP->overload_config.cpu_percent = (uint32_t) aint;
+      }
+    }
+    // PAGING SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_PAGING_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_PAGING_T3413_MS, &aint))) {
+        config_pP->paging_config.t3413_ms = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_PAGING_LAST_TAI_ATTEMPTS, &aint))) {
+        config_pP->paging_config.last_tai_attempts = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_PAGING_TAI_LIST_ATTEMPTS, &aint))) {
+        config_pP->paging_config.tai_list_attempts = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_PAGING_RATE, &aint))) {
+        config_pP->paging_config.rate = (uint32_t) aint;
+      }
+    }
+    // CONTEXT EVICTION SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_EVICTION_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_MEMORY_BUDGET_MB, &aint))) {
+        config_pP->eviction_config.memory_budget_mb = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_IDLE_TIMEOUT_SEC, &aint))) {
+        config_pP->eviction_config.idle_timeout_sec = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_PERIOD_MS, &aint))) {
+        config_pP->eviction_config.period_ms = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_BATCH, &aint))) {
+        config_pP->eviction_config.batch = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_MAX_EVICTED_UES, &aint))) {
+        config_pP->eviction_config.max_evicted_ues = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_EVICTION_COLD_STORE_SIZE, &aint))) {
+        config_pP->eviction_config.cold_store_size = (uint32_t) aint;
+      }
+    }
+    // CONTEXT CHECKPOINT SETTING
+    setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_CHECKPOINT_CONFIG);
+
+    if (setting != NULL) {
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_CHECKPOINT_FILE, (const char **)&astring))) {
+        if ((astring != NULL) && (astring[0])) {
+          config_pP->checkpoint_config.file = bfromcstr(astring);
+        }
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_CHECKPOINT_CAPACITY, &aint))) {
+        config_pP->checkpoint_config.capacity = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_CHECKPOINT_PERIOD_MS, &aint))) {
+        config_pP->checkpoint_config.period_ms = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_CHECKPOINT_BATCH, &aint))) {
+        config_pP->checkpoint_config.batch = (uint32_t) aint;
+      }
     }
     // S6A SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S6A_CONFIG);
@@ -382,9 +518,51 @@ static int mme_config_parse_file (mme_config_t * config_pP)
             config_pP->s6a_config.hss_host_name = bfromcstr(astring);
           }
         } else
-          AssertFatal (1 == 0, "You have to provide a valid HSS hostname %s=...\n", MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+          MME_CONFIG_CHECK (0, "You have to provide a valid HSS hostname %s=...\n", MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+      }
+
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_S6A_HSS_PEERS);
+      if (subsetting != NULL) {
+        num = config_setting_length (subsetting);
+        MME_CONFIG_CHECK (num <= MME_CONFIG_MAX_HSS_PEERS, "Too many HSS peers %d, max %d\n", num, MME_CONFIG_MAX_HSS_PEERS);
+        for (i = 0; i < num; i++) {
+          sub2setting = config_setting_get_elem (subsetting, i);
+
+          if (sub2setting != NULL) {
+            MME_CONFIG_CHECK (config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_S6A_HSS_HOSTNAME, (const char **)&astring) && astring,
+                         "You have to provide a valid HSS hostname in %s\n", MME_CONFIG_STRING_S6A_HSS_PEERS);
+            config_pP->s6a_config.hss[config_pP->s6a_config.nb_hss].host_name = bfromcstr(astring);
+            config_pP->s6a_config.hss[config_pP->s6a_config.nb_hss].weight = 1;
+            if ((config_setting_lookup_int (sub2setting, MME_CONFIG_STRING_S6A_HSS_WEIGHT, &aint)) && (0 < aint)) {
+              config_pP->s6a_config.hss[config_pP->s6a_config.nb_hss].weight = (uint32_t) aint;
+            }
+            config_pP->s6a_config.nb_hss += 1;
+          }
+        }
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_S6A_ROUTING, (const char **)&astring))) {
+        if (strcasecmp (astring, MME_CONFIG_STRING_S6A_ROUTING_WEIGHTED) == 0) {
+          config_pP->s6a_config.weighted_routing = true;
+        } else {
+          MME_CONFIG_CHECK (strcasecmp (astring, MME_CONFIG_STRING_S6A_ROUTING_LEAST_OUTSTANDING) == 0, "Bad S6A routing %s\n", astring);
+          config_pP->s6a_config.weighted_routing = false;
+        }
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_INFLIGHT_WINDOW, &aint))) {
+        config_pP->s6a_config.inflight_window = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_QUEUE_SIZE, &aint))) {
+        config_pP->s6a_config.queue_size = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT_MS, &aint))) {
+        config_pP->s6a_config.request_timeout_ms = (uint32_t) aint;
       }
     }
+    if ((0 == config_pP->s6a_config.nb_hss) && (config_pP->s6a_config.hss_host_name)) {
+      config_pP->s6a_config.hss[0].host_name = bstrcpy(config_pP->s6a_config.hss_host_name);
+      config_pP->s6a_config.hss[0].weight = 1;
+      config_pP->s6a_config.nb_hss = 1;
+    }
     // SCTP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_SCTP_CONFIG);
 
@@ -434,7 +612,7 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       }
 
       config_pP->served_tai.nb_tai = num;
-      AssertFatal(16 >= num , "Too many TAIs configured %d", num);
+      MME_CONFIG_CHECK (16 >= num , "Too many TAIs configured %d\n", num);
 
       for (i = 0; i < num; i++) {
         sub2setting = config_setting_get_elem (setting, i);
@@ -447,13 +625,13 @@ static int mme_config_parse_file (mme_config_t * config_pP)
           if ((config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_MNC, &mnc))) {
             config_pP->served_tai.plmn_mnc[i] = (uint16_t) atoi (mnc);
             config_pP->served_tai.plmn_mnc_len[i] = strlen (mnc);
-            AssertFatal ((config_pP->served_tai.plmn_mnc_len[i] == 2) || (config_pP->served_tai.plmn_mnc_len[i] == 3),
-                "Bad MNC length %u, must be 2 or 3", config_pP->served_tai.plmn_mnc_len[i]);
+            MME_CONFIG_CHECK ((config_pP->served_tai.plmn_mnc_len[i] == 2) || (config_pP->served_tai.plmn_mnc_len[i] == 3),
+                "Bad MNC length %u, must be 2 or 3\n", config_pP->served_tai.plmn_mnc_len[i]);
           }
 
           if ((config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_TAC, &tac))) {
             config_pP->served_tai.tac[i] = (uint16_t) atoi (tac);
-            AssertFatal(TAC_IS_VALID(config_pP->served_tai.tac[i]), "Invalid TAC value "TAC_FMT, config_pP->served_tai.tac[i]);
+            MME_CONFIG_CHECK (TAC_IS_VALID(config_pP->served_tai.tac[i]), "Invalid TAC value "TAC_FMT"\n", config_pP->served_tai.tac[i]);
           }
         }
       }
@@ -516,13 +694,13 @@ static int mme_config_parse_file (mme_config_t * config_pP)
     config_pP->gummei.nb = 0;
     if (setting != NULL) {
       num = config_setting_length (setting);
-      AssertFatal(num == 1, "Only one GUMMEI supported for this version of MME");
+      MME_CONFIG_CHECK (num == 1, "Only one GUMMEI supported for this version of MME\n");
       for (i = 0; i < num; i++) {
         sub2setting = config_setting_get_elem (setting, i);
 
         if (sub2setting != NULL) {
           if ((config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_MCC, &mcc))) {
-            AssertFatal( 3 == strlen(mcc), "Bad MCC length, it must be 3 digit ex: 001");
+            MME_CONFIG_CHECK (3 == strlen(mcc), "Bad MCC length, it must be 3 digit ex: 001\n");
             char c[2] = { mcc[0], 0};
             config_pP->gummei.gummei[i].plmn.mcc_digit1 = (uint8_t) atoi (c);
             c[0] = mcc[1];
@@ -532,7 +710,7 @@ static int mme_config_parse_file (mme_config_t * config_pP)
           }
 
           if ((config_setting_lookup_string (sub2setting, MME_CONFIG_STRING_MNC, &mnc))) {
-            AssertFatal( (3 == strlen(mnc)) || (2 == strlen(mnc)) , "Bad MCC length, it must be 3 digit ex: 001");
+            MME_CONFIG_CHECK ((3 == strlen(mnc)) || (2 == strlen(mnc)) , "Bad MNC length, it must be 2 or 3 digit ex: 01\n");
             char c[2] = { mnc[0], 0};
             config_pP->gummei.gummei[i].plmn.mnc_digit1 = (uint8_t) atoi (c);
             c[0] = mnc[1];
@@ -571,7 +749,10 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         config_pP->ipv4.if_name_s1_mme = bfromcstr(if_name_s1_mme);
         cidr = bfromcstr (s1_mme);
         struct bstrList *list = bsplit (cidr, '/');
-        AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
+        if (2 != list->qty) {
+          bstrListDestroy (list);
+          MME_CONFIG_CHECK (0, "Bad CIDR address %s\n", bdata(cidr));
+        }
         address = list->entry[0];
         mask    = list->entry[1];
         IPV4_STR_ADDR_TO_INT_NWBO (bdata(address), config_pP->ipv4.s1_mme, "BAD IP ADDRESS FORMAT FOR S1-MME !\n");
@@ -584,7 +765,10 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         config_pP->ipv4.if_name_s11 = bfromcstr(if_name_s11);
         cidr = bfromcstr (s11);
         list = bsplit (cidr, '/');
-        AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
+        if (2 != list->qty) {
+          bstrListDestroy (list);
+          MME_CONFIG_CHECK (0, "Bad CIDR address %s\n", bdata(cidr));
+        }
         address = list->entry[0];
         mask    = list->entry[1];
         IPV4_STR_ADDR_TO_INT_NWBO (bdata(address), config_pP->ipv4.s11, "BAD IP ADDRESS FORMAT FOR S11 !\n");
@@ -678,7 +862,10 @@ static int mme_config_parse_file (mme_config_t * config_pP)
 
       cidr = bfromcstr (sgw_ip_address_for_s11);
       struct bstrList *list = bsplit (cidr, '/');
-      AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
+      if (2 != list->qty) {
+        bstrListDestroy (list);
+        MME_CONFIG_CHECK (0, "Bad CIDR address %s\n", bdata(cidr));
+      }
       address = list->entry[0];
       IPV4_STR_ADDR_TO_INT_NWBO (bdata(address), config_pP->ipv4.sgw_s11, "BAD IP ADDRESS FORMAT FOR SGW S11 !\n");
       bstrListDestroy(list);
@@ -687,9 +874,12 @@ static int mme_config_parse_file (mme_config_t * config_pP)
     }
   }
 
-  OAILOG_SET_CONFIG(&config_pP->log_config);
   config_destroy (&cfg);
   return 0;
+
+invalid:
+  config_destroy (&cfg);
+  return -1;
 }
 
 
@@ -705,6 +895,7 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- Run mode .............................: %s\n", (RUN_MODE_TEST == config_pP->run_mode) ? "TEST":"NORMAL");
   OAILOG_INFO (LOG_CONFIG, "- Max eNBs .............................: %u\n", config_pP->max_enbs);
   OAILOG_INFO (LOG_CONFIG, "- Max UEs ..............................: %u\n", config_pP->max_ues);
+  OAILOG_INFO (LOG_CONFIG, "- MME_APP/NAS workers ..................: %u\n", config_pP->nb_workers);
   OAILOG_INFO (LOG_CONFIG, "- IMS voice over PS session in S1 ......: %s\n", config_pP->eps_network_feature_support.ims_voice_over_ps_session_in_s1 == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Emergency bearer services in S1 mode .: %s\n", config_pP->eps_network_feature_support.emergency_bearer_services_in_s1_mode == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Location services via epc ............: %s\n", config_pP->eps_network_feature_support.location_services_via_epc == 0 ? "false" : "true");
@@ -723,6 +914,34 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
   OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
+  OAILOG_INFO (LOG_CONFIG, "    trace sampling ...: %u\n", config_pP->itti_config.trace_sampling);
+  OAILOG_INFO (LOG_CONFIG, "    trace buffer size : %u (traces)\n", config_pP->itti_config.trace_buffer_size);
+  OAILOG_INFO (LOG_CONFIG, "    high watermark ...: %u (messages)\n", config_pP->itti_config.high_watermark);
+  OAILOG_INFO (LOG_CONFIG, "- METRICS:\n");
+  OAILOG_INFO (LOG_CONFIG, "    unix socket ......: %s\n", bdata(config_pP->metrics_config.unix_socket));
+  OAILOG_INFO (LOG_CONFIG, "    port .............: %u\n", config_pP->metrics_config.port);
+  OAILOG_INFO (LOG_CONFIG, "- OVERLOAD:\n");
+  OAILOG_INFO (LOG_CONFIG, "    period ...........: %u (ms)\n", config_pP->overload_config.period_ms);
+  OAILOG_INFO (LOG_CONFIG, "    queue depth ......: %u (messages)\n", config_pP->overload_config.queue_depth);
+  OAILOG_INFO (LOG_CONFIG, "    S6A outstanding ..: %u (requests)\n", config_pP->overload_config.s6a_outstanding);
+  OAILOG_INFO (LOG_CONFIG, "    CPU ..............: %u (%%)\n", config_pP->overload_config.cpu_percent);
+  OAILOG_INFO (LOG_CONFIG, "- PAGING:\n");
+  OAILOG_INFO (LOG_CONFIG, "    T3413 ............: %u (ms)\n", config_pP->paging_config.t3413_ms);
+  OAILOG_INFO (LOG_CONFIG, "    last TAI attempts : %u\n", config_pP->paging_config.last_tai_attempts);
+  OAILOG_INFO (LOG_CONFIG, "    TAI list attempts : %u\n", config_pP->paging_config.tai_list_attempts);
+  OAILOG_INFO (LOG_CONFIG, "    rate .............: %u (pagings/s per MME_APP task)\n", config_pP->paging_config.rate);
+  OAILOG_INFO (LOG_CONFIG, "- CONTEXT EVICTION:\n");
+  OAILOG_INFO (LOG_CONFIG, "    memory budget ....: %u (MB)\n", config_pP->eviction_config.memory_budget_mb);
+  OAILOG_INFO (LOG_CONFIG, "    idle timeout .....: %u (s)\n", config_pP->eviction_config.idle_timeout_sec);
+  OAILOG_INFO (LOG_CONFIG, "    period ...........: %u (ms)\n", config_pP->eviction_config.period_ms);
+  OAILOG_INFO (LOG_CONFIG, "    batch ............: %u (UEs per MME_APP task)\n", config_pP->eviction_config.batch);
+  OAILOG_INFO (LOG_CONFIG, "    max evicted UEs ..: %u (0 for max UEs)\n", config_pP->eviction_config.max_evicted_ues);
+  OAILOG_INFO (LOG_CONFIG, "    cold store .......: %u (records)\n", config_pP->eviction_config.cold_store_size);
+  OAILOG_INFO (LOG_CONFIG, "- CONTEXT CHECKPOINT:\n");
+  OAILOG_INFO (LOG_CONFIG, "    file .............: %s\n", (config_pP->checkpoint_config.file) ? bdata(config_pP->checkpoint_config.file) : "none");
+  OAILOG_INFO (LOG_CONFIG, "    capacity .........: %u (UEs)\n", config_pP->checkpoint_config.capacity);
+  OAILOG_INFO (LOG_CONFIG, "    period ...........: %u (ms)\n", config_pP->checkpoint_config.period_ms);
+  OAILOG_INFO (LOG_CONFIG, "    batch ............: %u (UEs per MME_APP task)\n", config_pP->checkpoint_config.batch);
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
@@ -755,6 +974,13 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  for (j = 0; j < config_pP->s6a_config.nb_hss; j++) {
+    OAILOG_INFO (LOG_CONFIG, "    HSS peer .........: %s (weight %u)\n", bdata(config_pP->s6a_config.hss[j].host_name), config_pP->s6a_config.hss[j].weight);
+  }
+  OAILOG_INFO (LOG_CONFIG, "    routing ..........: %s\n", (config_pP->s6a_config.weighted_routing) ? MME_CONFIG_STRING_S6A_ROUTING_WEIGHTED:MME_CONFIG_STRING_S6A_ROUTING_LEAST_OUTSTANDING);
+  OAILOG_INFO (LOG_CONFIG, "    in-flight window .: %u (requests per peer)\n", config_pP->s6a_config.inflight_window);
+  OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (requests)\n", config_pP->s6a_config.queue_size);
+  OAILOG_INFO (LOG_CONFIG, "    request timeout ..: %u (ms)\n", config_pP->s6a_config.request_timeout_ms);
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
@@ -847,13 +1073,56 @@ mme_config_parse_opt_line (
   if (!config_pP->config_file) {
     config_pP->config_file = bfromcstr("/usr/local/etc/oai/mme.conf");
   }
-  if (mme_config_parse_file (config_pP) != 0) {
+  if (mme_config_parse_file (config_pP, false) != 0) {
     return -1;
   }
+  OAILOG_SET_CONFIG(&config_pP->log_config);
 
   /*
    * Display the configuration
    */
   mme_config_display (config_pP);
-  return 0;
+  return mme_config_snapshot_publish (config_pP);
+}
+
+//------------------------------------------------------------------------------
+static void mme_config_free (mme_config_t * config_pP)
+{
+  bdestroy (config_pP->config_file);
+  bdestroy (config_pP->pid_dir);
+  bdestroy (config_pP->realm);
+  bdestroy (config_pP->ipv4.if_name_s1_mme);
+  bdestroy (config_pP->ipv4.if_name_s11);
+  bdestroy (config_pP->s6a_config.conf_file);
+  bdestroy (config_pP->s6a_config.hss_host_name);
+  for (int i = 0; i < config_pP->s6a_config.nb_hss; i++) {
+    bdestroy (config_pP->s6a_config.hss[i].host_name);
+  }
+  bdestroy (config_pP->itti_config.log_file);
+  bdestroy (config_pP->metrics_config.unix_socket);
+  bdestroy (config_pP->checkpoint_config.file);
+  bdestroy (config_pP->log_config.output);
+  free_wrapper ((void**) &config_pP->served_tai.plmn_mcc);
+  free_wrapper ((void**) &config_pP->served_tai.plmn_mnc);
+  free_wrapper ((void**) &config_pP->served_tai.plmn_mnc_len);
+  free_wrapper ((void**) &config_pP->served_tai.tac);
+}
+
+//------------------------------------------------------------------------------
+int mme_config_reload (void)
+{
+  mme_config_t                            config = {0};
+  int                                     rc = RETURNerror;
+
+  mme_config_init (&config);
+  config.config_file = bstrcpy (mme_config.config_file);
+  // an unreadable file or an invalid value leaves the current configuration in place
+  if (mme_config_parse_file (&config, true) == 0) {
+    OAILOG_INFO (LOG_CONFIG, "Reloading %s: served TAIs, GUMMEIs, relative capacity and maximum of eNBs\n", bdata(config.config_file));
+    rc = mme_config_snapshot_publish (&config);
+  } else {
+    OAILOG_ERROR (LOG_CONFIG, "Reload of %s failed, configuration kept\n", bdata(config.config_file));
+  }
+  mme_config_free (&config);
+  return rc;
 }
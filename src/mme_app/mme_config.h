@@ -48,6 +48,7 @@
 #define MME_CONFIG_STRING_MAXENB                         "MAXENB"
 #define MME_CONFIG_STRING_MAXUE                          "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY              "RELATIVE_CAPACITY"
+#define MME_CONFIG_STRING_WORKERS                        "WORKERS"
 #define MME_CONFIG_STRING_STATISTIC_TIMER                "MME_STATISTIC_TIMER"
 
 #define MME_CONFIG_STRING_EMERGENCY_ATTACH_SUPPORTED     "EMERGENCY_ATTACH_SUPPORTED"
@@ -61,10 +62,53 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG     "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_SAMPLING    "TRACE_SAMPLING"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_BUFFER_SIZE "TRACE_BUFFER_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_HIGH_WATERMARK    "QUEUE_HIGH_WATERMARK"
+
+#define MME_CONFIG_STRING_METRICS_CONFIG                 "METRICS"
+#define MME_CONFIG_STRING_METRICS_UNIX_SOCKET            "UNIX_SOCKET"
+#define MME_CONFIG_STRING_METRICS_PORT                   "PORT"
+
+#define MME_CONFIG_STRING_OVERLOAD_CONFIG                "OVERLOAD"
+#define MME_CONFIG_STRING_OVERLOAD_PERIOD_MS             "PERIOD_MS"
+#define MME_CONFIG_STRING_OVERLOAD_QUEUE_DEPTH           "QUEUE_DEPTH"
+#define MME_CONFIG_STRING_OVERLOAD_S6A_OUTSTANDING       "S6A_OUTSTANDING"
+#define MME_CONFIG_STRING_OVERLOAD_CPU_PERCENT           "CPU_PERCENT"
+
+#define MME_CONFIG_STRING_PAGING_CONFIG                  "PAGING"
+#define MME_CONFIG_STRING_PAGING_T3413_MS                "T3413_MS"
+#define MME_CONFIG_STRING_PAGING_LAST_TAI_ATTEMPTS       "LAST_TAI_ATTEMPTS"
+#define MME_CONFIG_STRING_PAGING_TAI_LIST_ATTEMPTS       "TAI_LIST_ATTEMPTS"
+#define MME_CONFIG_STRING_PAGING_RATE                    "RATE"
+
+#define MME_CONFIG_STRING_EVICTION_CONFIG                "CONTEXT_EVICTION"
+#define MME_CONFIG_STRING_EVICTION_MEMORY_BUDGET_MB      "MEMORY_BUDGET_MB"
+#define MME_CONFIG_STRING_EVICTION_IDLE_TIMEOUT_SEC      "IDLE_TIMEOUT_SEC"
+#define MME_CONFIG_STRING_EVICTION_PERIOD_MS             "PERIOD_MS"
+#define MME_CONFIG_STRING_EVICTION_BATCH                 "BATCH"
+#define MME_CONFIG_STRING_EVICTION_MAX_EVICTED_UES       "MAX_EVICTED_UES"
+#define MME_CONFIG_STRING_EVICTION_COLD_STORE_SIZE       "COLD_STORE_SIZE"
+
+#define MME_CONFIG_STRING_CHECKPOINT_CONFIG              "CONTEXT_CHECKPOINT"
+#define MME_CONFIG_STRING_CHECKPOINT_FILE                "FILE"
+#define MME_CONFIG_STRING_CHECKPOINT_CAPACITY            "CAPACITY"
+#define MME_CONFIG_STRING_CHECKPOINT_PERIOD_MS           "PERIOD_MS"
+#define MME_CONFIG_STRING_CHECKPOINT_BATCH               "BATCH"
 
 #define MME_CONFIG_STRING_S6A_CONFIG                     "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH             "S6A_CONF"
 #define MME_CONFIG_STRING_S6A_HSS_HOSTNAME               "HSS_HOSTNAME"
+#define MME_CONFIG_STRING_S6A_HSS_PEERS                  "HSS_PEERS"
+#define MME_CONFIG_STRING_S6A_HSS_WEIGHT                 "WEIGHT"
+#define MME_CONFIG_STRING_S6A_ROUTING                    "ROUTING"
+#define MME_CONFIG_STRING_S6A_INFLIGHT_WINDOW            "INFLIGHT_WINDOW"
+#define MME_CONFIG_STRING_S6A_QUEUE_SIZE                 "QUEUE_SIZE"
+#define MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT_MS         "REQUEST_TIMEOUT_MS"
+#define MME_CONFIG_STRING_S6A_ROUTING_LEAST_OUTSTANDING  "LEAST_OUTSTANDING"
+#define MME_CONFIG_STRING_S6A_ROUTING_WEIGHTED           "WEIGHTED"
+
+#define MME_CONFIG_MAX_HSS_PEERS                         8
 
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
@@ -112,11 +156,8 @@ typedef enum {
   RUN_MODE_OTHER
 } run_mode_t;
 
+// written at startup then read only, the reloadable part is read from mme_config_snapshot.h
 typedef struct mme_config_s {
-  /* Reader/writer lock for this configuration */
-  pthread_rwlock_t rw_lock;
-
-
   bstring config_file;
   bstring pid_dir;
   bstring realm;
@@ -128,6 +169,8 @@ typedef struct mme_config_s {
 
   uint8_t relative_capacity;
 
+  uint32_t nb_workers;   // number of MME_APP/NAS task pairs the UE contexts are sharded on
+
   uint32_t mme_statistic_timer;
 
   uint8_t unauthenticated_imsi_supported;
@@ -179,15 +222,68 @@ typedef struct mme_config_s {
     ipv4_nbo_t sgw_s11;
   } ipv4;
 
+  // HSS peers, each one also declared with ConnectPeer in conf_file
   struct {
-    bstring conf_file;
-    bstring hss_host_name;
+    bstring   conf_file;
+    bstring   hss_host_name;        // HSS_HOSTNAME, the only peer if there is no HSS_PEERS
+    int       nb_hss;
+    struct {
+      bstring   host_name;          // without the realm
+      uint32_t  weight;
+    } hss[MME_CONFIG_MAX_HSS_PEERS];
+    bool      weighted_routing;     // smooth weighted round robin, least outstanding requests per weight otherwise
+    uint32_t  inflight_window;      // requests sent to a peer and not answered yet, 0 for no limit
+    uint32_t  queue_size;           // requests waiting for a window
+    uint32_t  request_timeout_ms;   // then the request fails over to another peer
   } s6a_config;
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    uint32_t  trace_sampling;       // trace 1 procedure out of trace_sampling, 0 disables tracing
+    uint32_t  trace_buffer_size;    // completed traces kept
+    uint32_t  high_watermark;       // queued messages above which a task is overloaded, 0 disables
   } itti_config;
 
+  // Prometheus endpoint, disabled if no socket path and no port
+  struct {
+    bstring   unix_socket;
+    uint16_t  port;                 // on the loopback interface
+  } metrics_config;
+
+  // Overload control, the MME is overloaded when one of the loads reaches its threshold (0 ignores the load)
+  struct {
+    uint32_t  period_ms;            // evaluation period, 0 disables the overload control
+    uint32_t  queue_depth;          // messages queued in the S1AP, MME_APP or NAS tasks
+    uint32_t  s6a_outstanding;      // S6A requests waiting for their answer
+    uint32_t  cpu_percent;          // of the online CPUs
+  } overload_config;
+
+  // Paging on S11 DOWNLINK DATA NOTIFICATION, first in the last TAI of the UE then in its TAI list
+  struct {
+    uint32_t  t3413_ms;             // paging response guard timer
+    uint32_t  last_tai_attempts;    // PAGINGs sent to the eNBs of the last TAI
+    uint32_t  tai_list_attempts;    // PAGINGs sent next to the eNBs of the TAI list
+    uint32_t  rate;                 // pagings started per second and MME_APP task, 0 for no limit
+  } paging_config;
+
+  // Eviction of the UE contexts in ECM-IDLE, least recently idle first, the evicted UEs are kept as records
+  struct {
+    uint32_t  memory_budget_mb;     // UE contexts memory above which idle UEs are evicted, 0 for no budget
+    uint32_t  idle_timeout_sec;     // idle UEs evicted after this time, 0 for no timeout
+    uint32_t  period_ms;            // eviction period, 0 disables the eviction
+    uint32_t  batch;                // UEs evicted per period and MME_APP task at most
+    uint32_t  max_evicted_ues;      // records of evicted UEs, the UEs are implicitly detached over it, 0 for MAXUE
+    uint32_t  cold_store_size;      // GUTI to IMSI records kept for the re-attach of the detached UEs, 0 for none
+  } eviction_config;
+
+  // Checkpoint of the UE contexts in ECM-IDLE in a memory mapped file, restored at startup
+  struct {
+    bstring   file;                 // no checkpoint if NULL
+    uint32_t  capacity;             // UE records in the file, 0 for MAXUE
+    uint32_t  period_ms;            // checkpoint period
+    uint32_t  batch;                // UEs checkpointed per period and MME_APP task at most
+  } checkpoint_config;
+
   struct {
     uint8_t  prefered_integrity_algorithm[8];
     uint8_t  prefered_ciphering_algorithm[8];
@@ -211,9 +307,7 @@ int mme_config_find_mnc_length(const char mcc_digit1P,
                                const char mnc_digit2P,
                                const char mnc_digit3P);
 int mme_config_parse_opt_line(int argc, char *argv[], mme_config_t *mme_config);
-
-#define mme_config_read_lock(mMEcONFIG)  pthread_rwlock_rdlock(&(mMEcONFIG)->rw_lock)
-#define mme_config_write_lock(mMEcONFIG) pthread_rwlock_wrlock(&(mMEcONFIG)->rw_lock)
-#define mme_config_unlock(mMEcONFIG)     pthread_rwlock_unlock(&(mMEcONFIG)->rw_lock)
+// parses the configuration file again and publishes a new snapshot, on SIGHUP
+int mme_config_reload(void);
 
 #endif /* FILE_MME_CONFIG_SEEN */
@@ -0,0 +1,250 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_config_snapshot.c
+  \brief Immutable snapshots of the part of the MME configuration that can be
+  reloaded, read by the tasks without any lock.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "assertions.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "mme_config_snapshot.h"
+
+#define MME_CONFIG_SET_MASK               (MME_CONFIG_SNAPSHOT_SET_SIZE - 1)
+#define MME_CONFIG_SNAPSHOT_GRACE_POLL_US 100
+
+// generation of the snapshot a thread is reading, 0 if it reads none, alone on its cache line
+typedef struct mme_config_reader_s {
+  uint64_t                                generation;
+} __attribute__ ((aligned (64))) mme_config_reader_t;
+
+static struct {
+  mme_config_snapshot_t                  *current;
+  uint64_t                                generation;     // of current, stored after current
+  pthread_mutex_t                         writer_mutex;   // serializes the publications, never taken by readers
+  uint32_t                                nb_readers;
+  mme_config_reader_t                     readers[MME_CONFIG_SNAPSHOT_MAX_READERS];
+} mme_config_snapshots = {.writer_mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static __thread mme_config_reader_t    *t_mme_config_reader = NULL;
+static __thread uint32_t                t_mme_config_reader_nesting = 0;
+
+//------------------------------------------------------------------------------
+static inline uint32_t mme_config_set_hash (uint32_t key)
+{
+  key ^= key >> 16;
+  key *= 0x45d9f3b;
+  key ^= key >> 16;
+  return key & MME_CONFIG_SET_MASK;
+}
+
+//------------------------------------------------------------------------------
+static void mme_config_set_add (mme_config_set_t * const set, const uint32_t key, const uint32_t element_index)
+{
+  uint32_t                                i = mme_config_set_hash (key);
+
+  // the set is at least twice the number of elements, there is always a free slot
+  while ((set->slots[i]) && ((uint32_t)set->slots[i] != key)) {
+    i = (i + 1) & MME_CONFIG_SET_MASK;
+  }
+  if (!set->slots[i]) {
+    set->slots[i] = (((uint64_t)element_index + 1) << 32) | key;
+  }
+}
+
+//------------------------------------------------------------------------------
+static int mme_config_set_get (const mme_config_set_t * const set, const uint32_t key)
+{
+  uint32_t                                i = mme_config_set_hash (key);
+
+  for (int n = 0; n < MME_CONFIG_SNAPSHOT_SET_SIZE; n++) {
+    const uint64_t                          slot = set->slots[i];
+
+    if (!slot) {
+      return -1;
+    }
+    if ((uint32_t)slot == key) {
+      return (int)(slot >> 32) - 1;
+    }
+    i = (i + 1) & MME_CONFIG_SET_MASK;
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+static mme_config_snapshot_t *mme_config_snapshot_build (const mme_config_t * const config_pP)
+{
+  mme_config_snapshot_t                  *snapshot = calloc (1, sizeof (mme_config_snapshot_t));
+
+  if (!snapshot) {
+    return NULL;
+  }
+  snapshot->max_enbs = config_pP->max_enbs;
+  snapshot->relative_capacity = config_pP->relative_capacity;
+  snapshot->nb_tai = (config_pP->served_tai.nb_tai < MME_CONFIG_SNAPSHOT_MAX_TAIS) ? config_pP->served_tai.nb_tai : MME_CONFIG_SNAPSHOT_MAX_TAIS;
+  for (int i = 0; i < snapshot->nb_tai; i++) {
+    const uint32_t                          plmn_key = MME_CONFIG_PLMN_KEY (config_pP->served_tai.plmn_mcc[i],
+                                                                            config_pP->served_tai.plmn_mnc[i],
+                                                                            config_pP->served_tai.plmn_mnc_len[i]);
+
+    snapshot->plmn_mcc[i] = config_pP->served_tai.plmn_mcc[i];
+    snapshot->plmn_mnc[i] = config_pP->served_tai.plmn_mnc[i];
+    snapshot->plmn_mnc_len[i] = config_pP->served_tai.plmn_mnc_len[i];
+    snapshot->tac[i] = config_pP->served_tai.tac[i];
+    snapshot->tac_set[snapshot->tac[i] >> 6] |= ((uint64_t)1) << (snapshot->tac[i] & 0x3f);
+    if (0 > mme_config_set_get (&snapshot->plmn_set, plmn_key)) {
+      mme_config_set_add (&snapshot->plmn_set, plmn_key, snapshot->nb_served_plmns);
+      snapshot->served_plmns[snapshot->nb_served_plmns].mcc = snapshot->plmn_mcc[i];
+      snapshot->served_plmns[snapshot->nb_served_plmns].mnc = snapshot->plmn_mnc[i];
+      snapshot->served_plmns[snapshot->nb_served_plmns].mnc_len = snapshot->plmn_mnc_len[i];
+      snapshot->nb_served_plmns++;
+    }
+  }
+  snapshot->nb_gummei = (config_pP->gummei.nb < MAX_GUMMEI) ? config_pP->gummei.nb : MAX_GUMMEI;
+  for (int i = 0; i < snapshot->nb_gummei; i++) {
+    snapshot->gummei[i] = config_pP->gummei.gummei[i];
+    mme_config_set_add (&snapshot->gummei_set, MME_CONFIG_GUMMEI_KEY (&snapshot->gummei[i].plmn, snapshot->gummei[i].mme_code), i);
+  }
+  return snapshot;
+}
+
+//------------------------------------------------------------------------------
+// waits until no thread reads a snapshot older than generation
+static void mme_config_snapshot_synchronize (const uint64_t generation)
+{
+  const uint32_t                          nb_readers = __atomic_load_n (&mme_config_snapshots.nb_readers, __ATOMIC_ACQUIRE);
+
+  for (uint32_t r = 0; (r < nb_readers) && (r < MME_CONFIG_SNAPSHOT_MAX_READERS); r++) {
+    uint64_t                                reader_generation = 0;
+
+    while ((reader_generation = __atomic_load_n (&mme_config_snapshots.readers[r].generation, __ATOMIC_SEQ_CST))
+           && (reader_generation < generation)) {
+      usleep (MME_CONFIG_SNAPSHOT_GRACE_POLL_US);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+int mme_config_snapshot_publish (const mme_config_t * const config_pP)
+{
+  mme_config_snapshot_t                  *snapshot = mme_config_snapshot_build (config_pP);
+  mme_config_snapshot_t                  *previous = NULL;
+
+  if (!snapshot) {
+    OAILOG_ERROR (LOG_CONFIG, "Failed to allocate the configuration snapshot\n");
+    return RETURNerror;
+  }
+  pthread_mutex_lock (&mme_config_snapshots.writer_mutex);
+  previous = mme_config_snapshots.current;
+  snapshot->generation = (previous) ? previous->generation + 1 : 1;
+  /*
+   * The snapshot is published before its generation: a reader that loads the
+   * new generation then loads the new snapshot, a reader that loaded the
+   * previous snapshot has stored a lower generation in its slot.
+   */
+  __atomic_store_n (&mme_config_snapshots.current, snapshot, __ATOMIC_SEQ_CST);
+  __atomic_store_n (&mme_config_snapshots.generation, snapshot->generation, __ATOMIC_SEQ_CST);
+  if (previous) {
+    mme_config_snapshot_synchronize (snapshot->generation);
+    free_wrapper ((void **)&previous);
+  }
+  pthread_mutex_unlock (&mme_config_snapshots.writer_mutex);
+  OAILOG_INFO (LOG_CONFIG, "Configuration snapshot %" PRIu64 " published: %d TAIs, %d PLMNs, %d GUMMEIs, relative capacity %u\n",
+      snapshot->generation, snapshot->nb_tai, snapshot->nb_served_plmns, snapshot->nb_gummei, snapshot->relative_capacity);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void mme_config_snapshot_exit (void)
+{
+  pthread_mutex_lock (&mme_config_snapshots.writer_mutex);
+  free_wrapper ((void **)&mme_config_snapshots.current);
+  pthread_mutex_unlock (&mme_config_snapshots.writer_mutex);
+}
+
+//------------------------------------------------------------------------------
+const mme_config_snapshot_t *mme_config_snapshot_acquire (void)
+{
+  if (0 == t_mme_config_reader_nesting++) {
+    if (!t_mme_config_reader) {
+      const uint32_t                          r = __atomic_fetch_add (&mme_config_snapshots.nb_readers, 1, __ATOMIC_ACQ_REL);
+
+      AssertFatal (r < MME_CONFIG_SNAPSHOT_MAX_READERS, "Too many threads reading the configuration snapshot (%u)\n", r);
+      t_mme_config_reader = &mme_config_snapshots.readers[r];
+    }
+    // the generation store is ordered before the snapshot load (sequentially consistent)
+    __atomic_store_n (&t_mme_config_reader->generation, __atomic_load_n (&mme_config_snapshots.generation, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+  }
+  return __atomic_load_n (&mme_config_snapshots.current, __ATOMIC_SEQ_CST);
+}
+
+//------------------------------------------------------------------------------
+void mme_config_snapshot_release (void)
+{
+  if (0 == --t_mme_config_reader_nesting) {
+    __atomic_store_n (&t_mme_config_reader->generation, 0, __ATOMIC_RELEASE);
+  }
+}
+
+//------------------------------------------------------------------------------
+bool mme_config_snapshot_served_plmn (const mme_config_snapshot_t * const snapshot, const uint16_t mcc, const uint16_t mnc, const uint16_t mnc_len)
+{
+  return (0 <= mme_config_set_get (&snapshot->plmn_set, MME_CONFIG_PLMN_KEY (mcc, mnc, mnc_len)));
+}
+
+//------------------------------------------------------------------------------
+bool mme_config_snapshot_served_tac (const mme_config_snapshot_t * const snapshot, const uint16_t tac)
+{
+  return (0 != (snapshot->tac_set[tac >> 6] & (((uint64_t)1) << (tac & 0x3f))));
+}
+
+//------------------------------------------------------------------------------
+const gummei_t *mme_config_snapshot_find_gummei (const mme_config_snapshot_t * const snapshot, const plmn_t * const plmn, const mme_code_t mme_code)
+{
+  const int                               i = mme_config_set_get (&snapshot->gummei_set, MME_CONFIG_GUMMEI_KEY (plmn, mme_code));
+
+  return (0 <= i) ? &snapshot->gummei[i] : NULL;
+}
+
+//------------------------------------------------------------------------------
+int mme_config_snapshot_mnc_length (const mme_config_snapshot_t * const snapshot, const uint16_t mcc, const uint16_t mnc2, const uint16_t mnc3)
+{
+  if (mme_config_snapshot_served_plmn (snapshot, mcc, mnc2, 2)) {
+    return 2;
+  } else if (mme_config_snapshot_served_plmn (snapshot, mcc, mnc3, 3)) {
+    return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_config_snapshot.h
+  \brief Immutable snapshots of the part of the MME configuration that can be
+  reloaded, read by the tasks without any lock.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_MME_CONFIG_SNAPSHOT_SEEN
+#define FILE_MME_CONFIG_SNAPSHOT_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "3gpp_23.003.h"
+#include "common_dim.h"
+#include "mme_config.h"
+
+/*
+ * mme_config is written once at startup then only read. The served TAIs, the
+ * GUMMEIs, the relative capacity and the maximum number of eNBs can be
+ * reloaded from the configuration file on SIGHUP, they are read from an
+ * immutable snapshot that also holds the lookup sets built from them.
+ *
+ * A snapshot is read between mme_config_snapshot_acquire() and
+ * mme_config_snapshot_release(), never kept after. The reload publishes the
+ * new snapshot with an atomic pointer swap and frees the previous one once
+ * every thread that acquired it has released it (RCU): readers take no lock
+ * and write only to their own thread slot. Acquire/release pairs may nest.
+ *
+ * The NAS EMM configuration (TAI list of Attach/TAU Accept, GUTI allocation)
+ * is taken from mme_config at startup and is not reloaded.
+ */
+#define MME_CONFIG_SNAPSHOT_MAX_READERS   128     // threads acquiring a snapshot
+#define MME_CONFIG_SNAPSHOT_MAX_TAIS      16
+#define MME_CONFIG_SNAPSHOT_SET_SIZE      64      // power of 2, at least twice the TAIs and the GUMMEIs
+
+// (MCC, MNC, MNC length) as configured in TAI_LIST
+#define MME_CONFIG_PLMN_KEY(mCc, mNc, mNcLeN)  ((((uint32_t)(mCc)) << 12) | (((uint32_t)(mNc)) << 2) | ((uint32_t)(mNcLeN) & 0x3))
+// PLMN digits in the order of plmn_t then MME code
+#define MME_CONFIG_GUMMEI_KEY(pLmN_PtR, mMeCoDe)                    \
+  ((((uint32_t)(pLmN_PtR)->mcc_digit2) << 28) |                     \
+   (((uint32_t)(pLmN_PtR)->mcc_digit1) << 24) |                     \
+   (((uint32_t)(pLmN_PtR)->mnc_digit3) << 20) |                     \
+   (((uint32_t)(pLmN_PtR)->mcc_digit3) << 16) |                     \
+   (((uint32_t)(pLmN_PtR)->mnc_digit2) << 12) |                     \
+   (((uint32_t)(pLmN_PtR)->mnc_digit1) << 8)  |                     \
+   ((uint32_t)(mMeCoDe)))
+
+// open addressing set of 32 bits keys, a slot holds the index of the element + 1 (0 is free) and the key
+typedef struct mme_config_set_s {
+  uint64_t                        slots[MME_CONFIG_SNAPSHOT_SET_SIZE];
+} mme_config_set_t;
+
+typedef struct mme_config_served_plmn_s {
+  uint16_t                        mcc;
+  uint16_t                        mnc;
+  uint16_t                        mnc_len;
+} mme_config_served_plmn_t;
+
+typedef struct mme_config_snapshot_s {
+  uint64_t                        generation;     // 1 for the startup configuration, incremented by every reload
+
+  uint32_t                        max_enbs;
+  uint8_t                         relative_capacity;
+
+  uint8_t                         nb_tai;
+  uint16_t                        plmn_mcc[MME_CONFIG_SNAPSHOT_MAX_TAIS];
+  uint16_t                        plmn_mnc[MME_CONFIG_SNAPSHOT_MAX_TAIS];
+  uint16_t                        plmn_mnc_len[MME_CONFIG_SNAPSHOT_MAX_TAIS];
+  uint16_t                        tac[MME_CONFIG_SNAPSHOT_MAX_TAIS];
+
+  // distinct PLMNs of the served TAIs, in the order of the TAI list
+  uint8_t                         nb_served_plmns;
+  mme_config_served_plmn_t        served_plmns[MME_CONFIG_SNAPSHOT_MAX_TAIS];
+
+  int                             nb_gummei;
+  gummei_t                        gummei[MAX_GUMMEI];
+
+  mme_config_set_t                plmn_set;       // MME_CONFIG_PLMN_KEY -> served_plmns
+  mme_config_set_t                gummei_set;     // MME_CONFIG_GUMMEI_KEY -> gummei
+  uint64_t                        tac_set[(1 << 16) / 64];
+} mme_config_snapshot_t;
+
+// builds the snapshot of config_pP and makes it the current one, frees the previous one after a grace period
+int  mme_config_snapshot_publish (const mme_config_t * const config_pP);
+// frees the current snapshot, no reader may be left
+void mme_config_snapshot_exit (void);
+
+const mme_config_snapshot_t *mme_config_snapshot_acquire (void) __attribute__ ((hot));
+void mme_config_snapshot_release (void) __attribute__ ((hot));
+
+bool mme_config_snapshot_served_plmn (const mme_config_snapshot_t * const snapshot, const uint16_t mcc, const uint16_t mnc, const uint16_t mnc_len) __attribute__ ((hot));
+bool mme_config_snapshot_served_tac (const mme_config_snapshot_t * const snapshot, const uint16_t tac) __attribute__ ((hot));
+// the served GUMMEI of a PLMN and an MME code, NULL if none
+const gummei_t *mme_config_snapshot_find_gummei (const mme_config_snapshot_t * const snapshot, const plmn_t * const plmn, const mme_code_t mme_code) __attribute__ ((hot));
+// 2 or 3 if (MCC, MNC) is a served PLMN, 0 otherwise
+int  mme_config_snapshot_mnc_length (const mme_config_snapshot_t * const snapshot, const uint16_t mcc, const uint16_t mnc2, const uint16_t mnc3) __attribute__ ((hot));
+
+#endif /* FILE_MME_CONFIG_SNAPSHOT_SEEN */
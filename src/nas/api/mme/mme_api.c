@@ -46,6 +46,8 @@
 #include "sgw_ie_defs.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_shard.h"
+#include "mme_app_cold_store.h"
 #include "mme_config.h"
 #include <string.h>             // memcpy
 
@@ -76,7 +78,7 @@ static mme_api_ip_version_t             _mme_api_ip_capability = MME_API_IPV4V6_
 /* Total number of PDN connections (should not exceed MME_API_PDN_MAX) */
 static int                              _mme_api_pdn_id = 0;
 
-static tmsi_t                           mme_m_tmsi_generator = 0x00000001;
+static tmsi_t                           mme_m_tmsi_generator = 1 << MME_APP_SHARD_TAG_BITS;
 
 /****************************************************************************/
 /******************  E X P O R T E D    F U N C T I O N S  ******************/
@@ -338,6 +340,7 @@ mme_api_new_guti (
   tai_list_t * const tai_list)
 {
   ue_context_t                           *ue_context = NULL;
+  ue_context_t                           *other_context = NULL;
   imsi64_t                                mme_imsi = 0;
 
   OAILOG_FUNC_IN (LOG_NAS);
@@ -353,11 +356,18 @@ mme_api_new_guti (
     guti->gummei.plmn.mnc_digit1 = _emm_data.conf.gummei.plmn.mnc_digit1;
     guti->gummei.plmn.mnc_digit2 = _emm_data.conf.gummei.plmn.mnc_digit2;
     guti->gummei.plmn.mnc_digit3 = _emm_data.conf.gummei.plmn.mnc_digit3;
+    // the low bits of the M-TMSI carry the shard of the UE, see mme_app_shard.h
     if (RUN_MODE_TEST == mme_config.run_mode) {
-      guti->m_tmsi = __sync_fetch_and_add (&mme_m_tmsi_generator, 0x00000001);
+      guti->m_tmsi = __sync_fetch_and_add (&mme_m_tmsi_generator, 1 << MME_APP_SHARD_TAG_BITS);
     } else {
       guti->m_tmsi                 = (tmsi_t)(uintptr_t)ue_context;
     }
+    guti->m_tmsi = mme_app_shard_tag (guti->m_tmsi, ue_context->mme_ue_s1ap_id);
+    // a GUTI restored from the checkpoint, of an evicted UE or of a detached UE in the cold store may hold this M-TMSI
+    while (((other_context = mme_ue_context_exists_guti (&mme_app_desc.mme_ue_contexts, guti)) && (other_context != ue_context)) ||
+           (mme_app_eviction_is_m_tmsi_used (guti->m_tmsi)) || (mme_app_cold_store_is_guti_used (guti))) {
+      guti->m_tmsi += 1 << MME_APP_SHARD_TAG_BITS;
+    }
     if (guti->m_tmsi == INVALID_M_TMSI) {
       OAILOG_FUNC_RETURN (LOG_NAS, RETURNerror);
     }
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*****************************************************************************
+
+  Source    nas_buffer.c
+
+  Version   0.1
+
+  Date      2016/10/14
+
+  Product   NAS stack
+
+  Subsystem Application Programming Interface
+
+  Author
+
+  Description Pooled output buffers of the downlink NAS messages
+
+*****************************************************************************/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "log.h"
+#include "slab_pool.h"
+#include "nas_buffer.h"
+
+/****************************************************************************/
+/*******************  L O C A L    D E F I N I T I O N S  *******************/
+/****************************************************************************/
+
+typedef struct nas_buffer_s {
+  struct tagbstring                       b;
+  unsigned char                           data[];
+} nas_buffer_t;
+
+#define NAS_BUFFER_CAPACITY                 (NAS_BUFFER_SIZE - offsetof (nas_buffer_t, data))
+
+/*
+ * Never destroyed: S1AP may still release buffers after the NAS task exited.
+ */
+static slab_pool_t                     *_nas_buffer_pool = NULL;
+
+/****************************************************************************/
+/******************  E X P O R T E D    F U N C T I O N S  ******************/
+/****************************************************************************/
+
+//------------------------------------------------------------------------------
+int nas_buffer_init (void)
+{
+  if (_nas_buffer_pool) {
+    return RETURNok;
+  }
+  bstring b = bfromcstr ("nas_buffer_t");
+  _nas_buffer_pool = slab_pool_create (NAS_BUFFER_SIZE, 0, false, b);
+  bdestroy (b);
+  if (!_nas_buffer_pool) {
+    OAILOG_ERROR (LOG_NAS, "Failed to create the pool of NAS buffers\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+bstring nas_buffer_alloc (const size_t length)
+{
+  nas_buffer_t                           *buffer = NULL;
+
+  // bstrlib keeps room for a terminating NUL
+  if ((_nas_buffer_pool) && (length < NAS_BUFFER_CAPACITY)) {
+    buffer = slab_pool_alloc (_nas_buffer_pool);
+  }
+  if (!buffer) {
+    return bfromcstralloc (length, "");
+  }
+  buffer->b.mlen = -1;
+  buffer->b.slen = 0;
+  buffer->b.data = buffer->data;
+  return &buffer->b;
+}
+
+//------------------------------------------------------------------------------
+bool nas_buffer_is_pooled (const_bstring b)
+{
+  return (b) && (b->mlen < 0) && (b->data == ((const nas_buffer_t *)b)->data);
+}
+
+//------------------------------------------------------------------------------
+void nas_buffer_free (bstring *b)
+{
+  if (!b || !*b) {
+    return;
+  }
+  if (nas_buffer_is_pooled (*b)) {
+    slab_pool_free (_nas_buffer_pool, (void **)b);
+  } else {
+    bdestroy (*b);
+  }
+  *b = NULL;
+}
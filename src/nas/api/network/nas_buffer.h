@@ -0,0 +1,82 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*****************************************************************************
+
+Source      nas_buffer.h
+
+Version     0.1
+
+Date        2016/10/14
+
+Product     NAS stack
+
+Subsystem   Application Programming Interface
+
+Author
+
+Description Pooled output buffers of the downlink NAS messages
+
+*****************************************************************************/
+#ifndef FILE_NAS_BUFFER_SEEN
+#define FILE_NAS_BUFFER_SEEN
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+
+/****************************************************************************/
+/*********************  G L O B A L    C O N S T A N T S  *******************/
+/****************************************************************************/
+
+/*
+ * Size of a pooled buffer, bstring header included. It holds the largest
+ * downlink NAS messages but the ones carrying several ESM containers, which
+ * are allocated on the heap.
+ */
+#define NAS_BUFFER_SIZE                     512
+
+/****************************************************************************/
+/******************  E X P O R T E D    F U N C T I O N S  ******************/
+/****************************************************************************/
+
+/*
+ * The downlink NAS messages are encoded, integrity protected and ciphered in
+ * place in a buffer returned by nas_buffer_alloc. The bstring is handed over
+ * to S1AP through ITTI, S1AP encodes the NAS PDU IE straight from it then
+ * releases it with nas_buffer_free, from its own thread.
+ *
+ * A pooled bstring is write protected: bstrlib functions that would resize
+ * it fail and bdestroy leaves it alone, only nas_buffer_free releases it.
+ * nas_buffer_free also releases the bstrings allocated by bstrlib, the NAS
+ * messages forwarded as they are.
+ */
+int     nas_buffer_init (void);
+
+// Returns a bstring of capacity length at least, with slen 0
+bstring nas_buffer_alloc (const size_t length);
+
+bool    nas_buffer_is_pooled (const_bstring b);
+
+void    nas_buffer_free (bstring *b);
+
+#endif /* FILE_NAS_BUFFER_SEEN */
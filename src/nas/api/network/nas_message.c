@@ -960,28 +960,21 @@ static int _nas_message_protected_encode (
   OAILOG_FUNC_IN (LOG_NAS);
   emm_security_context_t                 *emm_security_context = (emm_security_context_t *) security;
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                          *plain_msg = (unsigned char *)calloc (1, length);
 
-  if (plain_msg) {
+  /*
+   * Encode the security protected NAS message as plain NAS message, straight
+   * into the output buffer
+   */
+  int                                     size = _nas_message_plain_encode (buffer, &msg->header,
+                                                                            &msg->plain, length);
+
+  if (size > 0) {
     /*
-     * Encode the security protected NAS message as plain NAS message
+     * Encrypt the encoded plain NAS message in place
      */
-    int                                     size = _nas_message_plain_encode (plain_msg, &msg->header,
-                                                                              &msg->plain, length);
-
-    if (size > 0) {
-      //static uint8_t seq = 0;
-      /*
-       * Encrypt the encoded plain NAS message
-       */
-      bytes = _nas_message_encrypt (buffer, plain_msg, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
-                                    SECU_DIRECTION_DOWNLINK,
-                                    size, emm_security_context);
-      //seq, size);
-      //seq ++;
-    }
-
-    free_wrapper ((void**) &plain_msg);
+    bytes = _nas_message_encrypt (buffer, buffer, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
+                                  SECU_DIRECTION_DOWNLINK,
+                                  size, emm_security_context);
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -1054,9 +1047,9 @@ static int _nas_message_decrypt (
             OAILOG_FUNC_RETURN (LOG_NAS, 0);
           }
           if (direction == SECU_DIRECTION_UPLINK) {
-            count = 0x00000000 || ((emm_security_context->ul_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->ul_count.seq_num & 0x000000FF);
+            count = 0x00000000 | ((emm_security_context->ul_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->ul_count.seq_num & 0x000000FF);
           } else {
-            count = 0x00000000 || ((emm_security_context->dl_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->dl_count.seq_num & 0x000000FF);
+            count = 0x00000000 | ((emm_security_context->dl_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->dl_count.seq_num & 0x000000FF);
           }
 
           OAILOG_DEBUG (LOG_NAS,
@@ -1089,9 +1082,9 @@ static int _nas_message_decrypt (
             OAILOG_FUNC_RETURN (LOG_NAS, 0);
           }
           if (direction == SECU_DIRECTION_UPLINK) {
-            count = 0x00000000 || ((emm_security_context->ul_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->ul_count.seq_num & 0x000000FF);
+            count = 0x00000000 | ((emm_security_context->ul_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->ul_count.seq_num & 0x000000FF);
           } else {
-            count = 0x00000000 || ((emm_security_context->dl_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->dl_count.seq_num & 0x000000FF);
+            count = 0x00000000 | ((emm_security_context->dl_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->dl_count.seq_num & 0x000000FF);
           }
 
           OAILOG_DEBUG (LOG_NAS,
@@ -1157,7 +1150,7 @@ static int _nas_message_decrypt (
  **                                                                        **
  ** Name:  _nas_message_encrypt()                                    **
  **                                                                        **
- ** Description: Encrypt plain NAS message                                 **
+ ** Description: Encrypt plain NAS message, in place if dest is src       **
  **                                                                        **
  ** Inputs   src:   Pointer to the decrypted data buffer       **
  **    security_header_type:    The security header type                   **
@@ -1200,7 +1193,9 @@ static int _nas_message_encrypt (
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED:
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW:
     OAILOG_DEBUG (LOG_NAS, "No encryption of message according to security header type 0x%02x\n", security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     OAILOG_FUNC_RETURN (LOG_NAS, length);
     break;
 
@@ -1209,9 +1204,9 @@ static int _nas_message_encrypt (
     switch (emm_security_context->selected_algorithms.encryption) {
     case NAS_SECURITY_ALGORITHMS_EEA1:{
         if (direction == SECU_DIRECTION_UPLINK) {
-          count = 0x00000000 || ((emm_security_context->ul_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->ul_count.seq_num & 0x000000FF);
+          count = 0x00000000 | ((emm_security_context->ul_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->ul_count.seq_num & 0x000000FF);
         } else {
-          count = 0x00000000 || ((emm_security_context->dl_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->dl_count.seq_num & 0x000000FF);
+          count = 0x00000000 | ((emm_security_context->dl_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->dl_count.seq_num & 0x000000FF);
         }
 
         OAILOG_DEBUG (LOG_NAS,
@@ -1234,9 +1229,9 @@ static int _nas_message_encrypt (
 
     case NAS_SECURITY_ALGORITHMS_EEA2:{
         if (direction == SECU_DIRECTION_UPLINK) {
-          count = 0x00000000 || ((emm_security_context->ul_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->ul_count.seq_num & 0x000000FF);
+          count = 0x00000000 | ((emm_security_context->ul_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->ul_count.seq_num & 0x000000FF);
         } else {
-          count = 0x00000000 || ((emm_security_context->dl_count.overflow && 0x0000FFFF) << 8) || (emm_security_context->dl_count.seq_num & 0x000000FF);
+          count = 0x00000000 | ((emm_security_context->dl_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->dl_count.seq_num & 0x000000FF);
         }
 
         OAILOG_DEBUG (LOG_NAS,
@@ -1259,7 +1254,9 @@ static int _nas_message_encrypt (
 
     case NAS_SECURITY_ALGORITHMS_EEA0:
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-      memcpy (dest, src, length);
+      if (dest != src) {
+        memcpy (dest, src, length);
+      }
       OAILOG_FUNC_RETURN (LOG_NAS, length);
       break;
 
@@ -75,7 +75,11 @@
 #include "mme_api.h"
 #include "mme_app_defs.h"
 #include "mme_app_ue_context.h"
+#include "mme_app_statistics.h"
+#include "intertask_interface_trace.h"
 #include "mme_config.h"
+#include "mme_app_cold_store.h"
+#include "mme_app_shard.h"
 #include "nas_itti_messaging.h"
 
 
@@ -300,7 +304,10 @@ emm_proc_attach_request (
     // Search UE context using GUTI -  
     if (guti) { // no need for  && (is_native_guti)
       guti_emm_ctx = emm_data_context_get_by_guti (&_emm_data, guti);
-      if (guti_emm_ctx) {
+      if ((guti_emm_ctx) && (!mme_app_is_ue_id_in_current_shard (guti_emm_ctx->ue_id))) {
+        // the old context belongs to the NAS task of another shard, which cleans it up
+        nas_itti_implicit_detach_ue_ind (guti_emm_ctx->ue_id);
+      } else if (guti_emm_ctx) {
         
         /* 
          * This implies either UE or eNB has not sent S-TMSI in intial UE message even though UE has old GUTI. 
@@ -494,7 +501,7 @@ emm_proc_attach_request (
     /*
      * Create UE's EMM context
      */
-    new_emm_ctx = (emm_data_context_t *) calloc (1, sizeof (emm_data_context_t));
+    new_emm_ctx = (emm_data_context_t *) slab_pool_alloc (_emm_data.ctx_pool);
 
     if (!new_emm_ctx) {
       OAILOG_WARNING (LOG_NAS_EMM, "EMM-PROC  - Failed to create EMM context\n");
@@ -572,6 +579,9 @@ emm_proc_attach_request (
       /*
        * Performs the sequence: UE identification, authentication, security mode
        */
+      new_emm_ctx->attach_start_ns = metrics_now_ns ();
+      new_emm_ctx->trace_id = itti_trace_current;
+      itti_trace_set_procedure (new_emm_ctx->trace_id, "attach", ue_id);
       rc = _emm_attach_identify (new_emm_ctx);
     }
   }
@@ -701,6 +711,10 @@ emm_proc_attach_complete (
      */
     emm_ctx->is_attached = true;
     emm_ctx->is_has_been_attached = true;
+    update_mme_app_stats_latency (MME_APP_LATENCY_ATTACH, emm_ctx->attach_start_ns);
+    emm_ctx->attach_start_ns = 0;
+    itti_trace_end (emm_ctx->trace_id);
+    emm_ctx->trace_id = ITTI_TRACE_ID_NONE;
     /*
      * Notify EMM that attach procedure has successfully completed
      */
@@ -1050,6 +1064,24 @@ _emm_attach_identify (
     }
   } else if (IS_EMM_CTXT_PRESENT_GUTI(emm_ctx)) {
     // The UE identifies itself using a GUTI
+    imsi_t                                  imsi = {0};
+
+    if (mme_app_cold_store_take (&emm_ctx->_guti, &imsi)) {
+      /*
+       * The GUTI was allocated to a UE implicitly detached since (implicit
+       * detach timer, expiry of an evicted UE), its IMSI is known: identify the UE
+       * with it and go on with the authentication, which proves it.
+       */
+      imsi64_t                                imsi64 = INVALID_IMSI64;
+
+      IMSI_TO_IMSI64 (&imsi, imsi64);
+      OAILOG_INFO (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " EMM-PROC  - GUTI (tmsi=%u) of IMSI " IMSI_64_FMT " found in the cold store\n",
+          emm_ctx->ue_id, emm_ctx->_guti.m_tmsi, imsi64);
+      emm_ctx_set_valid_imsi (emm_ctx, &imsi, imsi64);
+      emm_data_context_upsert_imsi (&_emm_data, emm_ctx);
+      rc = _emm_attach_identify (emm_ctx);
+      OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
+    }
     //LG Force identification here
     emm_ctx_clear_attribute_valid(emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTORS);
     OAILOG_WARNING (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " EMM-PROC  - Failed to identify the UE using provided GUTI (tmsi=%u)\n", emm_ctx->ue_id, emm_ctx->_guti.m_tmsi);
@@ -102,7 +102,7 @@ _clear_emm_ctxt(emm_data_context_t *emm_ctx) {
    * Release the EMM context
    */
   emm_data_context_remove(&_emm_data, emm_ctx);
-  free_wrapper((void **) &emm_ctx);
+  slab_pool_free(_emm_data.ctx_pool, (void **) &emm_ctx);
 }
 
 
@@ -54,6 +54,8 @@
 #include "emm_proc.h"
 #include "emm_sap.h"
 #include "mme_app_defs.h"
+#include "mme_app_statistics.h"
+#include "intertask_interface_trace.h"
 #include "emm_cause.h"
 
 
@@ -237,6 +239,9 @@ emm_proc_tracking_area_update_request (
   }
   OAILOG_DEBUG(LOG_NAS_EMM, "EMM-PROC-  Tracking Area Update request. TAU_Type=%d, active_flag=%d)\n",
         msg->epsupdatetype.epsupdatetypevalue, msg->epsupdatetype.activeflag);
+  ue_ctx->tau_start_ns = metrics_now_ns ();
+  ue_ctx->trace_id = itti_trace_current;
+  itti_trace_set_procedure (ue_ctx->trace_id, "tau", ue_id);
   // Check if it is not periodic update.
 
   if ( EPS_UPDATE_TYPE_PERIODIC_UPDATING != msg->epsupdatetype.epsupdatetypevalue) {
@@ -781,6 +786,12 @@ _emm_tracking_area_update_accept (
       emm_sap.primitive = EMMAS_DATA_REQ;
       rc = emm_sap_send (&emm_sap);
     }
+    if (rc != RETURNerror) {
+      update_mme_app_stats_latency (MME_APP_LATENCY_TAU, emm_ctx->tau_start_ns);
+      emm_ctx->tau_start_ns = 0;
+      itti_trace_end (emm_ctx->trace_id);
+      emm_ctx->trace_id = ITTI_TRACE_ID_NONE;
+    }
   } else {
     OAILOG_WARNING (LOG_NAS_EMM, "EMM-PROC  - emm_ctx NULL");
   }
@@ -43,6 +43,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "common_defs.h"
 #include "obj_hashtable.h"
 #include "hashtable.h"
+#include "slab_pool.h"
 #include "commonDef.h"
 #include "networkDef.h"
 #include "securityDef.h"
@@ -146,6 +147,7 @@ typedef struct emm_data_context_s {
   bool             is_attached; /* Attachment indicator                            */
   bool             is_emergency;/* Emergency bearer services indicator             */
   bool             is_has_been_attached; /* Attachment indicator                   */
+  bool             is_ecm_connected; /* NAS signalling connection, up to NAS_CONNECTION_RELEASE_IND */
 
   /*
    * attach_type has type emm_proc_attach_type_t.
@@ -300,6 +302,13 @@ typedef struct emm_data_context_s {
 
 #define           IS_EMM_CTXT_VALID_AUTH_VECTOR( eMmCtXtPtR, KsI )        (!!((eMmCtXtPtR)->member_valid_mask & ((EMM_CTXT_MEMBER_AUTH_VECTOR0) << KsI)))
 
+  /* Start of the procedures timed by the statistics (metrics_now_ns()), 0 if not running */
+  uint64_t        attach_start_ns;
+  uint64_t        tau_start_ns;
+  uint64_t        s6a_air_start_ns;
+  // trace (itti_trace_id_t) of the procedure in progress, resumed on the messages received from outside ITTI
+  uint32_t        trace_id;
+
   void *          specific_proc_data;
 } emm_data_context_t;
 
@@ -320,8 +329,9 @@ typedef struct emm_data_s {
    * ------------
    */
   hash_table_ts_t    *ctx_coll_ue_id; // key is emm ue id, data is struct emm_data_context_s
-  hash_table_ts_t    *ctx_coll_imsi;  // key is imsi_t, data is emm ue id (unsigned int)
+  hash_table_ts_t    *ctx_coll_imsi;  // key is imsi64_t, data is emm ue id (unsigned int) stored by value
   obj_hash_table_t   *ctx_coll_guti;  // key is guti, data is emm ue id (unsigned int)
+  slab_pool_t        *ctx_pool;       // storage of struct emm_data_context_s
 } emm_data_t;
 
 typedef struct s6a_auth_info_rsp_timer_arg_s {
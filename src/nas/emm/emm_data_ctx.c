@@ -55,7 +55,7 @@ _emm_data_context_hashtable_insert(
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
 
   if ( IS_EMM_CTXT_PRESENT_IMSI(elm)) {
-    h_rc = hashtable_ts_insert (emm_data->ctx_coll_imsi, elm->_imsi64, (void*)(&elm->ue_id));
+    h_rc = hashtable_ts_insert (emm_data->ctx_coll_imsi, elm->_imsi64, (void*)(uintptr_t)elm->ue_id);
   } else {
     // This should not happen. Possible UE bug?
     OAILOG_WARNING(LOG_NAS_EMM, "EMM-CTX doesn't contain valid imsi UE id " MME_UE_S1AP_ID_FMT "\n", elm->ue_id);
@@ -543,14 +543,15 @@ emm_data_context_get_by_imsi (
   imsi64_t     imsi64)
 {
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  mme_ue_s1ap_id_t                       *emm_ue_id_p = NULL;
+  void                                   *emm_ue_id = NULL;
 
   DevAssert (emm_data );
 
-  h_rc = hashtable_ts_get (emm_data->ctx_coll_imsi, (const hash_key_t)imsi64, (void **)&emm_ue_id_p);
+  // the UE id is stored by value, the MME_APP reads this table to route S6A answers to the NAS task of the UE
+  h_rc = hashtable_ts_get (emm_data->ctx_coll_imsi, (const hash_key_t)imsi64, (void **)&emm_ue_id);
 
   if (HASH_TABLE_OK == h_rc) {
-    struct emm_data_context_s * tmp = emm_data_context_get (emm_data, (const hash_key_t)*emm_ue_id_p);
+    struct emm_data_context_s * tmp = emm_data_context_get (emm_data, (const hash_key_t)(uintptr_t)emm_ue_id);
 #if DEBUG_IS_ON
     if ((tmp)) {
       OAILOG_DEBUG (LOG_NAS_EMM, "EMM-CTX - get UE id " MME_UE_S1AP_ID_FMT " context %p by imsi " IMSI_64_FMT "\n", tmp->ue_id, tmp, imsi64);
@@ -685,7 +686,7 @@ emm_data_context_add (
     if ( IS_EMM_CTXT_PRESENT_IMSI(elm)) {
       imsi64_t imsi64 = INVALID_IMSI64;
       IMSI_TO_IMSI64(&elm->_imsi,imsi64);
-      h_rc = hashtable_ts_insert (emm_data->ctx_coll_imsi, imsi64, (void*)&elm->ue_id);
+      h_rc = hashtable_ts_insert (emm_data->ctx_coll_imsi, imsi64, (void*)(uintptr_t)elm->ue_id);
 
       if (HASH_TABLE_OK == h_rc) {
         OAILOG_DEBUG (LOG_NAS_EMM, "EMM-CTX - Add in context UE id " MME_UE_S1AP_ID_FMT " with IMSI "IMSI_64_FMT"\n", elm->ue_id, imsi64);
@@ -856,7 +857,7 @@ void free_emm_data_context(
     emm_data_context_stop_all_timers(emm_ctx);
 
     free_esm_data_context(&emm_ctx->esm_data_ctx);
-    free_wrapper((void**) &emm_ctx);
+    slab_pool_free(_emm_data.ctx_pool, (void**) &emm_ctx);
   }
 }
 
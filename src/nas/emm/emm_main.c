@@ -45,6 +45,7 @@
 
 #include "mme_config.h"
 #include "obj_hashtable.h"
+#include "common_types.h"
 #include <string.h>
 
 
@@ -95,7 +96,10 @@ emm_main_initialize (
   _emm_data.ctx_coll_imsi  = hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "emm_data.ctx_coll_guti");
-  _emm_data.ctx_coll_guti  = obj_hashtable_ts_create (mme_config.max_ues, NULL, NULL, hash_free_int_func, b);
+  _emm_data.ctx_coll_guti  = obj_hashtable_ts_create (mme_config.max_ues, guti_hashfunc, NULL, hash_free_int_func, b);
+  btrunc(b, 0);
+  bassigncstr(b, "emm_data_context_t");
+  _emm_data.ctx_pool       = slab_pool_create (sizeof (emm_data_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
   bdestroy(b);
   OAILOG_FUNC_OUT(LOG_NAS_EMM);
 }
@@ -122,6 +126,7 @@ emm_main_cleanup (
   hashtable_ts_destroy(_emm_data.ctx_coll_ue_id);
   hashtable_ts_destroy(_emm_data.ctx_coll_imsi);
   obj_hashtable_ts_destroy(_emm_data.ctx_coll_guti);
+  slab_pool_destroy(_emm_data.ctx_pool);
   OAILOG_FUNC_OUT(LOG_NAS_EMM);
 }
 
@@ -293,7 +293,7 @@ encode_tracking_area_update_request (
    * Checking IEI and pointer
    */
   CHECK_PDU_POINTER_AND_LENGTH_ENCODER (buffer, TRACKING_AREA_UPDATE_REQUEST_MINIMUM_LENGTH, len);
-  *(buffer + encoded) = ((encode_u8_eps_update_type (&tracking_area_update_request->epsupdatetype) & 0x0f) << 4) | (encode_u8_nas_key_set_identifier (&tracking_area_update_request->naskeysetidentifier) & 0x0f);
+  *(buffer + encoded) = ((encode_u8_nas_key_set_identifier (&tracking_area_update_request->naskeysetidentifier) & 0x0f) << 4) | (encode_u8_eps_update_type (&tracking_area_update_request->epsupdatetype) & 0x0f);
   encoded++;
 
   if ((encode_result = encode_eps_mobile_identity (&tracking_area_update_request->oldguti, 0, buffer + encoded, len - encoded)) < 0)    //Return in case of error
@@ -53,6 +53,7 @@
 #include "TLVDecoder.h"
 #include "as_message.h"
 #include "nas_message.h"
+#include "nas_buffer.h"
 #include "emm_cause.h"
 #include "LowerLayer.h"
 #include "nas_itti_messaging.h"
@@ -644,7 +645,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
                                                 (0 == decode_status.mac_matched))) {
       *emm_cause = EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW;
       // Delete EMM,ESM conext, MMEAPP UE context and S1AP context
-      nas_proc_implicit_detach_ue_ind(emm_ctx->ue_id);       
+      nas_proc_implicit_detach_ue_ind(emm_ctx->ue_id, false);       
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
     }
     // Process Detach Request
@@ -841,9 +842,10 @@ static int _emm_as_encode (bstring *info, nas_message_t * msg,
   }
 
   /*
-   * Allocate memory to the NAS information container
+   * Allocate memory to the NAS information container, the message is
+   * encoded, integrity protected and ciphered in place
    */
-  *info = bfromcstralloc(length, "\0");
+  *info = nas_buffer_alloc (length);
 
   if (*info) {
     /*
@@ -854,8 +856,7 @@ static int _emm_as_encode (bstring *info, nas_message_t * msg,
     if (bytes > 0) {
       (*info)->slen = bytes;
     } else {
-      bdestroy (*info);
-      *info = NULL;
+      nas_buffer_free (info);
     }
   }
 
@@ -894,7 +895,7 @@ static int _emm_as_encrypt (bstring *info, const nas_message_security_header_t *
   /*
    * Allocate memory to the NAS information container
    */
-  *info = bfromcstralloc(length, "\0");
+  *info = nas_buffer_alloc (length);
 
   if (*info) {
     /*
@@ -905,8 +906,7 @@ static int _emm_as_encrypt (bstring *info, const nas_message_security_header_t *
     if (bytes > 0) {
       (*info)->slen = bytes;
     } else {
-      bdestroy(*info);
-      *info = NULL;
+      nas_buffer_free (info);
     }
   }
 
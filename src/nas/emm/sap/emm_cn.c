@@ -56,6 +56,7 @@
 #include "esm_sap.h"
 #include "EmmCommon.h"
 #include "3gpp_requirements_24.301.h"
+#include "mme_app_cold_store.h"
 
 extern int emm_cn_wrapper_attach_accept (emm_data_context_t * emm_ctx, void *data);
 extern int emm_cn_handover (emm_data_context_t * emm_ctx, void *data);
@@ -209,9 +210,15 @@ static int _emm_cn_deregister_ue (const uint32_t ue_id)
 static int _emm_cn_implicit_detach_ue (const uint32_t ue_id)
 {
   int                                     rc = RETURNok;
+  emm_data_context_t                     *emm_ctx = NULL;
 
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   OAILOG_DEBUG (LOG_NAS_EMM, "EMM-PROC Implicit Detach UE" MME_UE_S1AP_ID_FMT "\n", ue_id);
+  emm_ctx = emm_data_context_get (&_emm_data, ue_id);
+  if ((emm_ctx) && (emm_ctx->is_attached) && (IS_EMM_CTXT_VALID_IMSI (emm_ctx)) && (IS_EMM_CTXT_VALID_GUTI (emm_ctx))) {
+    // The UE still holds its GUTI, keep its IMSI for its next attach
+    mme_app_cold_store_save (&emm_ctx->_guti, &emm_ctx->_imsi);
+  }
   emm_proc_detach_request (ue_id, EMM_DETACH_TYPE_EPS, 1 /*switch_off */ , 0 /*native_ksi */ , 0 /*ksi */ ,
                            NULL /*guti */ , NULL /*imsi */ , NULL /*imei */ );
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
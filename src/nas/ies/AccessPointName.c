@@ -44,6 +44,7 @@ decode_access_point_name (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
@@ -43,6 +43,7 @@ decode_apn_aggregate_maximum_bit_rate (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
@@ -42,6 +42,8 @@ decode_drx_parameter (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 2, len);
+
   drxparameter->splitpgcyclecode = *(buffer + decoded);
   decoded++;
   drxparameter->cnspecificdrxcyclelengthcoefficientanddrxvaluefors1mode = (*(buffer + decoded) >> 4) & 0xf;
@@ -42,6 +42,8 @@ decode_emm_cause (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *emmcause = *(buffer + decoded);
   decoded++;
   return decoded;
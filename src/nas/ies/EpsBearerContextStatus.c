@@ -43,9 +43,11 @@ decode_eps_bearer_context_status (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  CHECK_LENGTH_DECODER (len - decoded, 2);
   //IES_DECODE_U16(*epsbearercontextstatus, *(buffer + decoded));
   IES_DECODE_U16 (buffer, decoded, *epsbearercontextstatus);
   return decoded;
@@ -58,28 +58,60 @@ decode_eps_mobile_identity (
   int                                     decoded_rc = TLV_VALUE_DOESNT_MATCH;
   int                                     decoded = 0;
   uint8_t                                 ielen = 0;
+  uint8_t                                 value[EPS_MOBILE_IDENTITY_MAXIMUM_LENGTH - 2];
+  uint8_t                                 typeofidentity = 0;
 
   if (iei > 0) {
     CHECK_IEI_DECODER (iei, *buffer);
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
-  uint8_t                                 typeofidentity = *(buffer + decoded) & 0x7;
+
+  if ((0 == ielen) || (ielen > sizeof (value))) {
+    return (TLV_VALUE_DOESNT_MATCH);
+  }
+
+  /*
+   * The identity decoders read the longest encoding of their type: copy the
+   * value part and pad it with the BCD filler so that only the ielen octets
+   * of this IE are taken from the message.
+   */
+  memset (value, 0xff, sizeof (value));
+  memcpy (value, buffer + decoded, ielen);
+  typeofidentity = value[0] & 0x7;
 
   if (typeofidentity == EPS_MOBILE_IDENTITY_IMSI) {
-    decoded_rc = decode_imsi_eps_mobile_identity (&epsmobileidentity->imsi, buffer + decoded);
+    decoded_rc = decode_imsi_eps_mobile_identity (&epsmobileidentity->imsi, value);
   } else if (typeofidentity == EPS_MOBILE_IDENTITY_GUTI) {
-    decoded_rc = decode_guti_eps_mobile_identity (&epsmobileidentity->guti, buffer + decoded);
+    /*
+     * The GUTI has no filler, all of its octets must be present
+     */
+    if (ielen != sizeof (value)) {
+      return (TLV_VALUE_DOESNT_MATCH);
+    }
+
+    decoded_rc = decode_guti_eps_mobile_identity (&epsmobileidentity->guti, value);
   } else if (typeofidentity == EPS_MOBILE_IDENTITY_IMEI) {
-    decoded_rc = decode_imei_eps_mobile_identity (&epsmobileidentity->imei, buffer + decoded);
+    decoded_rc = decode_imei_eps_mobile_identity (&epsmobileidentity->imei, value);
   }
 
   if (decoded_rc < 0) {
     return decoded_rc;
   }
+
+  /*
+   * A BCD identity with an even number of digits ends with the "1111" end
+   * mark in bits 5 to 8 of its last octet, wherever that octet is.
+   */
+  if ((EPS_MOBILE_IDENTITY_GUTI != typeofidentity) && (EPS_MOBILE_IDENTITY_EVEN == ((value[0] >> 3) & 0x1)) && (0xf != (value[ielen - 1] >> 4))) {
+    return (TLV_VALUE_DOESNT_MATCH);
+  }
+
+  decoded_rc = ielen;
 #if NAS_DEBUG
   dump_eps_mobile_identity_xml (epsmobileidentity, iei);
 #endif
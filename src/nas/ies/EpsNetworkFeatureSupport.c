@@ -43,10 +43,11 @@ decode_eps_network_feature_support (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
-  *epsnetworkfeaturesupport = *buffer & 0x1;
+  *epsnetworkfeaturesupport = *(buffer + decoded) & 0x1;
   decoded++;
 #if NAS_DEBUG
   dump_eps_network_feature_support_xml (epsnetworkfeaturesupport, iei);
@@ -42,6 +42,8 @@ decode_esm_cause (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *esmcause = *(buffer + decoded);
   decoded++;
 #if NAS_DEBUG
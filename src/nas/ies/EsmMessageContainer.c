@@ -46,6 +46,7 @@ decode_esm_message_container (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 2, len);
   DECODE_LENGTH_U16 (buffer + decoded, ielen, decoded);
   CHECK_LENGTH_DECODER (len - decoded, ielen);
 
@@ -42,6 +42,8 @@ decode_ksi_and_sequence_number (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   ksiandsequencenumber->ksi = (*(buffer + decoded) >> 5) & 0x7;
   ksiandsequencenumber->sequencenumber = *(buffer + decoded) & 0x1f;
   decoded++;
@@ -42,6 +42,8 @@ decode_lcs_indicator (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *lcsindicator = *(buffer + decoded);
   decoded++;
 #if NAS_DEBUG
@@ -42,6 +42,8 @@ decode_llc_service_access_point_identifier (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *llcserviceaccesspointidentifier = *buffer & 0xf;
   decoded++;
 #if NAS_DEBUG
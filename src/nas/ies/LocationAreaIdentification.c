@@ -42,6 +42,8 @@ decode_location_area_identification (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 5, len);
+
   locationareaidentification->mccdigit2 = (*(buffer + decoded) >> 4) & 0xf;
   locationareaidentification->mccdigit1 = *(buffer + decoded) & 0xf;
   decoded++;
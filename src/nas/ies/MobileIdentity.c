@@ -76,37 +76,62 @@ decode_mobile_identity (
   int                                     decoded_rc = TLV_VALUE_DOESNT_MATCH;
   int                                     decoded = 0;
   uint8_t                                 ielen = 0;
+  uint8_t                                 value[MOBILE_IDENTITY_MAXIMUM_LENGTH - 2];
+  uint8_t                                 typeofidentity = 0;
 
   if (iei > 0) {
     CHECK_IEI_DECODER (iei, *buffer);
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
-  uint8_t                                 typeofidentity = *(buffer + decoded) & 0x7;
+  CHECK_LENGTH_DECODER (len - decoded, ielen);
 
-  if (typeofidentity != MOBILE_IDENTITY_NOT_AVAILABLE) {
-    CHECK_LENGTH_DECODER (len - decoded, ielen);
+  if ((0 == ielen) || (ielen > sizeof (value))) {
+    return (TLV_VALUE_DOESNT_MATCH);
+  }
 
+  /*
+   * The identity decoders read the longest encoding of their type: copy the
+   * value part and pad it with the BCD filler so that only the ielen octets
+   * of this IE are taken from the message.
+   */
+  memset (value, 0xff, sizeof (value));
+  memcpy (value, buffer + decoded, ielen);
+  typeofidentity = value[0] & 0x7;
+
+  if (typeofidentity != MOBILE_IDENTITY_NOT_AVAILABLE) {
     if (typeofidentity == MOBILE_IDENTITY_IMSI) {
-      decoded_rc = decode_imsi_mobile_identity (&mobileidentity->imsi, buffer + decoded);
+      decoded_rc = decode_imsi_mobile_identity (&mobileidentity->imsi, value);
     } else if (typeofidentity == MOBILE_IDENTITY_IMEI) {
-      decoded_rc = decode_imei_mobile_identity (&mobileidentity->imei, buffer + decoded);
+      decoded_rc = decode_imei_mobile_identity (&mobileidentity->imei, value);
     } else if (typeofidentity == MOBILE_IDENTITY_IMEISV) {
-      decoded_rc = decode_imeisv_mobile_identity (&mobileidentity->imeisv, buffer + decoded);
+      decoded_rc = decode_imeisv_mobile_identity (&mobileidentity->imeisv, value);
     } else if (typeofidentity == MOBILE_IDENTITY_TMSI) {
-      decoded_rc = decode_tmsi_mobile_identity (&mobileidentity->tmsi, buffer + decoded);
+      decoded_rc = decode_tmsi_mobile_identity (&mobileidentity->tmsi, value);
     } else if (typeofidentity == MOBILE_IDENTITY_TMGI) {
-      decoded_rc = decode_tmgi_mobile_identity (&mobileidentity->tmgi, buffer + decoded);
+      decoded_rc = decode_tmgi_mobile_identity (&mobileidentity->tmgi, value);
     }
   } else if (ielen == MOBILE_IDENTITY_NOT_AVAILABLE_LTE_LENGTH) {
-    decoded_rc = decode_no_mobile_identity (&mobileidentity->no_id, buffer + decoded);
+    decoded_rc = decode_no_mobile_identity (&mobileidentity->no_id, value);
   }
 
   if (decoded_rc < 0) {
     return decoded_rc;
   }
+
+  /*
+   * A BCD identity with an even number of digits ends with the "1111" end
+   * mark in bits 5 to 8 of its last octet, wherever that octet is.
+   */
+  if (((MOBILE_IDENTITY_IMSI == typeofidentity) || (MOBILE_IDENTITY_IMEI == typeofidentity) || (MOBILE_IDENTITY_IMEISV == typeofidentity))
+      && (MOBILE_IDENTITY_EVEN == ((value[0] >> 3) & 0x1)) && (0xf != (value[ielen - 1] >> 4))) {
+    return (TLV_VALUE_DOESNT_MATCH);
+  }
+
+  decoded_rc = ielen;
 #if NAS_DEBUG
   dump_mobile_identity_xml (mobileidentity, iei);
 #endif
@@ -43,9 +43,11 @@ decode_mobile_station_classmark_2 (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  CHECK_LENGTH_DECODER (len - decoded, 3);
   mobilestationclassmark2->revisionlevel = (*(buffer + decoded) >> 5) & 0x3;
   mobilestationclassmark2->esind = (*(buffer + decoded) >> 4) & 0x1;
   mobilestationclassmark2->a51 = (*(buffer + decoded) >> 3) & 0x1;
@@ -44,10 +44,13 @@ decode_ms_network_capability (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   DECODE_U8 (buffer + decoded, ielen, decoded);
   memset (msnetworkcapability, 0, sizeof (MsNetworkCapability));
   OAILOG_INFO (LOG_NAS_EMM, "decode_ms_network_capability len = %d\n", ielen);
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  // the first octet is read whatever the IE length
+  CHECK_LENGTH_DECODER (len - decoded, 1);
 
   b = *(buffer + decoded);
   msnetworkcapability->gea1  = (b & MS_NETWORK_CAPABILITY_GEA1)                          >> 7;
@@ -42,6 +42,8 @@ decode_nas_security_algorithms (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   nassecurityalgorithms->typeofcipheringalgorithm = (*(buffer + decoded) >> 4) & 0x7;
   nassecurityalgorithms->typeofintegrityalgorithm = *(buffer + decoded) & 0x7;
   decoded++;
@@ -41,6 +41,8 @@ decode_nonce (
     CHECK_IEI_DECODER (iei, *buffer);
     decoded++;
   }
+
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 4, len);
   //IES_DECODE_U32(*nonce, *(buffer + decoded));
   IES_DECODE_U32 (buffer, decoded, *nonce);
 #if NAS_DEBUG
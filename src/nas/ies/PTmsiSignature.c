@@ -44,6 +44,8 @@ decode_p_tmsi_signature (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 3, len);
+
   if ((decode_result = decode_bstring (ptmsisignature, ielen, buffer + decoded, len - decoded)) < 0)
     return decode_result;
   else
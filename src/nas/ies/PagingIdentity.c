@@ -42,6 +42,8 @@ decode_paging_identity (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *pagingidentity = *buffer & 0x1;
   decoded++;
 #if NAS_DEBUG
@@ -41,6 +41,8 @@ decode_short_mac (
     CHECK_IEI_DECODER (iei, *buffer);
     decoded++;
   }
+
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 2, len);
   //IES_DECODE_U16(*shortmac, *(buffer + decoded));
   IES_DECODE_U16 (buffer, decoded, *shortmac);
 #if NAS_DEBUG
@@ -42,6 +42,8 @@ decode_ss_code (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *sscode = *(buffer + decoded);
   decoded++;
 #if NAS_DEBUG
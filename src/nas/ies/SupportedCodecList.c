@@ -43,9 +43,11 @@ decode_supported_codec_list (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  CHECK_LENGTH_DECODER (len - decoded, 4);
   supportedcodeclist->systemidentification = *(buffer + decoded);
   decoded++;
   supportedcodeclist->lengthofbitmap = *(buffer + decoded);
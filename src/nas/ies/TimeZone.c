@@ -42,6 +42,8 @@ decode_time_zone (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
+
   *timezone = *(buffer + decoded);
   decoded++;
 #if NAS_DEBUG
@@ -42,6 +42,8 @@ decode_time_zone_and_time (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 7, len);
+
   timezoneandtime->year = *(buffer + decoded);
   decoded++;
   timezoneandtime->month = *(buffer + decoded);
@@ -42,6 +42,8 @@ decode_tracking_area_identity (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 5, len);
+
   trackingareaidentity->mccdigit2 = (*(buffer + decoded) >> 4) & 0xf;
   trackingareaidentity->mccdigit1 = *(buffer + decoded) & 0xf;
   decoded++;
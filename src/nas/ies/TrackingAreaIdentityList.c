@@ -42,13 +42,20 @@ decode_tracking_area_identity_list (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  CHECK_LENGTH_DECODER (len - decoded, 1);
   trackingareaidentitylist->typeoflist = (*(buffer + decoded) >> 5) & 0x3;
   trackingareaidentitylist->numberofelements = *(buffer + decoded) & 0x1f;
   decoded++;
+  // the list holds up to 16 TAIs, the number of elements is coded minus one
+  if (trackingareaidentitylist->numberofelements >= (sizeof (trackingareaidentitylist->tac) / sizeof (trackingareaidentitylist->tac[0]))) {
+    return TLV_VALUE_DOESNT_MATCH;
+  }
   if (TRACKING_AREA_IDENTITY_LIST_ONE_PLMN_CONSECUTIVE_TACS == trackingareaidentitylist->typeoflist) {
+    CHECK_LENGTH_DECODER (len - decoded, 5);
     trackingareaidentitylist->mccdigit2[0] = (*(buffer + decoded) >> 4) & 0xf;
     trackingareaidentitylist->mccdigit1[0] = *(buffer + decoded) & 0xf;
     decoded++;
@@ -62,6 +69,7 @@ decode_tracking_area_identity_list (
     IES_DECODE_U16 (buffer, decoded, trackingareaidentitylist->tac[0]);
   } else if (TRACKING_AREA_IDENTITY_LIST_ONE_PLMN_NON_CONSECUTIVE_TACS == trackingareaidentitylist->typeoflist) {
     int i;
+    CHECK_LENGTH_DECODER (len - decoded, (3 + 2 * (trackingareaidentitylist->numberofelements + 1)));
     trackingareaidentitylist->mccdigit2[0] = (*(buffer + decoded) >> 4) & 0xf;
     trackingareaidentitylist->mccdigit1[0] = *(buffer + decoded) & 0xf;
     decoded++;
@@ -76,6 +84,7 @@ decode_tracking_area_identity_list (
     }
   } else if (TRACKING_AREA_IDENTITY_LIST_MANY_PLMNS == trackingareaidentitylist->typeoflist) {
     int i;
+    CHECK_LENGTH_DECODER (len - decoded, (5 * (trackingareaidentitylist->numberofelements + 1)));
     for (i=0; i <= trackingareaidentitylist->numberofelements; i++) {
       trackingareaidentitylist->mccdigit2[i] = (*(buffer + decoded) >> 4) & 0xf;
       trackingareaidentitylist->mccdigit1[i] = *(buffer + decoded) & 0xf;
@@ -45,10 +45,13 @@ decode_ue_network_capability (
     decoded++;
   }
 
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   DECODE_U8 (buffer + decoded, ielen, decoded);
   memset (uenetworkcapability, 0, sizeof (UeNetworkCapability));
   OAILOG_INFO (LOG_NAS_EMM, "decode_ue_network_capability len = %d\n", ielen);
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  // EEA and EIA octets are read whatever the IE length
+  CHECK_LENGTH_DECODER (len - decoded, ((ielen < 2) ? 2 : ielen));
   uenetworkcapability->eea = *(buffer + decoded);
   decoded++;
   uenetworkcapability->eia = *(buffer + decoded);
@@ -45,6 +45,7 @@ decode_ue_security_capability (
   }
 
   memset (uesecuritycapability, 0, sizeof (UeSecurityCapability));
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
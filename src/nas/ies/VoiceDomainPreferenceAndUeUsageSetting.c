@@ -45,9 +45,11 @@ decode_voice_domain_preference_and_ue_usage_setting (
   }
 
   memset (voicedomainpreferenceandueusagesetting, 0, sizeof (VoiceDomainPreferenceAndUeUsageSetting));
+  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, decoded + 1, len);
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+  CHECK_LENGTH_DECODER (len - decoded, 1);
   voicedomainpreferenceandueusagesetting->ue_usage_setting = (*(buffer + decoded) >> 2) & 0x1;
   voicedomainpreferenceandueusagesetting->voice_domain_for_eutran = *(buffer + decoded) & 0x3;
   decoded++;
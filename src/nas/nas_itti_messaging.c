@@ -27,6 +27,8 @@
 #include "intertask_interface.h"
 #include "msc.h"
 #include "mme_app_ue_context.h"
+#include "mme_app_shard.h"
+#include "metrics.h"
 #include "nas_itti_messaging.h"
 #include "nas_proc.h"
 #include "secu_defs.h"
@@ -214,7 +216,7 @@ nas_itti_dl_data_req (
   NAS_DL_DATA_REQ (message_p).transaction_status = transaction_status;
   MSC_LOG_TX_MESSAGE (MSC_NAS_MME, MSC_S1AP_MME, NULL, 0, "0 NAS_DOWNLINK_DATA_REQ ue id " MME_UE_S1AP_ID_FMT " len %u", ue_id, blength(nas_msg));
   // make a long way by MME_APP instead of S1AP to retrieve the sctp_association_id key.
-  return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (mme_app_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -293,7 +295,7 @@ void nas_itti_pdn_connectivity_req(
         "NAS_PDN_CONNECTIVITY_REQ ue id %06"PRIX32" IMSI %X",
         ue_idP, NAS_PDN_CONNECTIVITY_REQ(message_p).imsi);
 
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
 
   OAILOG_FUNC_OUT(LOG_NAS);
 }
@@ -350,6 +352,7 @@ void nas_itti_auth_info_req(
   timer_arg->resync = (auth_info_req->re_synchronization == 1) ? true : false;
 
   emm_ctx->timer_s6a_auth_info_rsp.id = nas_timer_start (emm_ctx->timer_s6a_auth_info_rsp.sec, _s6a_auth_info_rsp_timer_expiry_handler, timer_arg); 
+  emm_ctx->s6a_air_start_ns = metrics_now_ns ();
   
   OAILOG_DEBUG (LOG_NAS_EMM, "EMM-PROC  - Timer timer_s6_auth_info_rsp (%d) started in for UE  " MME_UE_S1AP_ID_FMT " \n ", emm_ctx->timer_s6a_auth_info_rsp.id, timer_arg->ue_id);
   
@@ -392,7 +395,7 @@ void nas_itti_establish_rej(
         "NAS_AUTHENTICATION_PARAM_REQ ue id %06"PRIX32" IMSI %s (establish reject)",
         ue_idP, NAS_AUTHENTICATION_PARAM_REQ(message_p).imsi);
 
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT(LOG_NAS);
 }
 
@@ -484,7 +487,7 @@ void nas_itti_establish_cnf(
         "NAS_CONNECTION_ESTABLISHMENT_CNF ue id %06"PRIX32" len %u sea %x sia %x ",
         ue_idP, blength(msgP), selected_encryption_algorithmP, selected_integrity_algorithmP);
 
-    itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
   }
 
   OAILOG_FUNC_OUT(LOG_NAS);
@@ -688,7 +691,7 @@ void nas_itti_handover_cnf(
         "NAS_HANDOVER_CNF ue id %06"PRIX32/*" len %u sea %x sia %x "*/,
         ue_idP, /*blength(msgP),*/ selected_encryption_algorithmP, selected_integrity_algorithmP);
 
-    itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
   }
 
   OAILOG_FUNC_OUT(LOG_NAS);
@@ -714,7 +717,7 @@ void nas_itti_handover_rej(
         "NAS_HANDOVER_REJ ue id %06"PRIX32" IMSI %s (establish reject)",
         ue_idP, NAS_AUTHENTICATION_PARAM_REQ(message_p).imsi);
 
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT(LOG_NAS);
 }
 
@@ -739,7 +742,54 @@ void nas_itti_detach_req(
                 "0 NAS_DETACH_REQ ue id %06"PRIX32" ",
           ue_idP);
 
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
+  OAILOG_FUNC_OUT(LOG_NAS);
+}
+//------------------------------------------------------------------------------
+/*
+ * The EMM context of the UE belongs to the NAS task of another shard, which
+ * detaches it.
+ */
+void nas_itti_implicit_detach_ue_ind(
+  const uint32_t      ue_idP)
+{
+  OAILOG_FUNC_IN(LOG_NAS);
+  MessageDef *message_p;
+
+  message_p = itti_alloc_new_message(TASK_NAS_MME, NAS_IMPLICIT_DETACH_UE_IND);
+  NAS_IMPLICIT_DETACH_UE_IND(message_p).ue_id = ue_idP;
+  NAS_IMPLICIT_DETACH_UE_IND(message_p).is_idle = false;
+
+  MSC_LOG_TX_MESSAGE(
+                MSC_NAS_MME,
+                MSC_NAS_MME,
+                NULL,0,
+                "0 NAS_IMPLICIT_DETACH_UE_IND ue id %06"PRIX32" ",
+          ue_idP);
+
+  itti_send_msg_to_task(nas_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
+  OAILOG_FUNC_OUT(LOG_NAS);
+}
+
+//------------------------------------------------------------------------------
+void nas_itti_ue_record_rsp(
+  const uint32_t      ue_idP,
+  const uint32_t      generationP,
+  const bool          is_evictionP,
+  const bool          is_validP,
+  struct mme_app_checkpoint_record_s *recordP)
+{
+  OAILOG_FUNC_IN(LOG_NAS);
+  MessageDef *message_p;
+
+  message_p = itti_alloc_new_message(TASK_NAS_MME, NAS_UE_RECORD_RSP);
+  NAS_UE_RECORD_RSP(message_p).ue_id = ue_idP;
+  NAS_UE_RECORD_RSP(message_p).generation = generationP;
+  NAS_UE_RECORD_RSP(message_p).is_eviction = is_evictionP;
+  NAS_UE_RECORD_RSP(message_p).is_valid = is_validP;
+  NAS_UE_RECORD_RSP(message_p).record = recordP;
+
+  itti_send_msg_to_task(mme_app_task_of_ue_id (ue_idP), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT(LOG_NAS);
 }
 //***************************************************************************
@@ -90,5 +90,15 @@ void nas_itti_handover_rej(
 void nas_itti_detach_req(
   const uint32_t      ue_idP);
 
+void nas_itti_implicit_detach_ue_ind(
+  const uint32_t      ue_idP);
+
+void nas_itti_ue_record_rsp(
+  const uint32_t      ue_idP,
+  const uint32_t      generationP,
+  const bool          is_evictionP,
+  const bool          is_validP,
+  struct mme_app_checkpoint_record_s *recordP);
+
 
 #endif /* FILE_NAS_ITTI_MESSAGING_SEEN */
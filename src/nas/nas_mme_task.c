@@ -34,20 +34,26 @@
 #include "nas_proc.h"
 #include "emm_main.h"
 #include "nas_timer.h"
+#include "mme_app_shard.h"
 
 static void nas_exit(void);
 
 //------------------------------------------------------------------------------
 static void *nas_intertask_interface (void *args_p)
 {
-  itti_mark_task_ready (TASK_NAS_MME);
+  const task_id_t                         task_id = nas_shard_tasks[(int)(uintptr_t)args_p];
+
+  mme_app_current_shard = (int)(uintptr_t)args_p;
+  // NAS timers are owned by the task of the UE
+  nas_timer_init ();
+  itti_mark_task_ready (task_id);
   OAILOG_START_USE ();
   MSC_START_USE ();
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_NAS_MME, &received_message_p);
+    itti_receive_msg (task_id, &received_message_p);
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case NAS_INITIAL_UE_MESSAGE:{
@@ -129,12 +135,35 @@ static void *nas_intertask_interface (void *args_p)
       break;
     
     case NAS_IMPLICIT_DETACH_UE_IND:{
-        nas_proc_implicit_detach_ue_ind (NAS_IMPLICIT_DETACH_UE_IND (received_message_p).ue_id);
+        nas_proc_implicit_detach_ue_ind (NAS_IMPLICIT_DETACH_UE_IND (received_message_p).ue_id, NAS_IMPLICIT_DETACH_UE_IND (received_message_p).is_idle);
+      }
+      break;
+
+    case NAS_CONNECTION_RELEASE_IND:{
+        nas_proc_connection_release_ind (NAS_CONNECTION_RELEASE_IND (received_message_p).ue_id);
+      }
+      break;
+
+    case NAS_UE_RECORD_REQ:{
+        nas_proc_ue_record_req (&NAS_UE_RECORD_REQ (received_message_p));
+      }
+      break;
+
+    case NAS_UE_EVICT_IND:{
+        nas_proc_ue_evict_ind (NAS_UE_EVICT_IND (received_message_p).ue_id);
+      }
+      break;
+
+    case NAS_UE_RESTORE_IND:{
+        nas_proc_ue_restore_ind (&NAS_UE_RESTORE_IND (received_message_p));
       }
       break;
 
     case TERMINATE_MESSAGE:{
-        nas_exit();
+        mme_app_shard_exit_wait ();
+        if (0 == mme_app_current_shard) {
+          nas_exit();
+        }
         itti_exit_task ();
       }
       break;
@@ -163,10 +192,12 @@ int nas_init (mme_config_t * mme_config_p)
   OAILOG_DEBUG (LOG_NAS, "Initializing NAS task interface\n");
   nas_network_initialize (mme_config_p);
 
-  if (itti_create_task (TASK_NAS_MME, &nas_intertask_interface, NULL) < 0) {
-    OAILOG_ERROR (LOG_NAS, "Create task failed");
-    OAILOG_DEBUG (LOG_NAS, "Initializing NAS task interface: FAILED\n");
-    return -1;
+  for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+    if (itti_create_task (nas_shard_tasks[shard], &nas_intertask_interface, (void *)(uintptr_t)shard) < 0) {
+      OAILOG_ERROR (LOG_NAS, "Create task %d failed", shard);
+      OAILOG_DEBUG (LOG_NAS, "Initializing NAS task interface: FAILED\n");
+      return -1;
+    }
   }
 
   OAILOG_DEBUG (LOG_NAS, "Initializing NAS task interface: DONE\n");
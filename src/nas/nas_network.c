@@ -40,6 +40,7 @@
 #include "common_types.h"
 #include "log.h"
 #include "nas_timer.h"
+#include "nas_buffer.h"
 #include "as_message.h"
 #include "nas_proc.h"
 
@@ -78,6 +79,7 @@ nas_network_initialize (
    * Initialize the internal NAS processing data
    */
   nas_timer_init ();
+  nas_buffer_init ();
   nas_proc_initialize (mme_config_p);
   OAILOG_FUNC_OUT (LOG_NAS);
 }
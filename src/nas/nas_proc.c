@@ -36,6 +36,7 @@
 
 *****************************************************************************/
 #include <stdio.h>
+#include <stdlib.h>
 #include "bstrlib.h"
 #include "log.h"
 #include "assertions.h"
@@ -49,6 +50,10 @@
 #include "msc.h"
 #include "s6a_defs.h"
 #include "dynamic_memory_check.h"
+#include "mme_app_statistics.h"
+#include "mme_app_checkpoint_file.h"
+#include "nas_itti_messaging.h"
+#include "intertask_interface_trace.h"
 
 /****************************************************************************/
 /****************  E X T E R N A L    D E F I N I T I O N S  ****************/
@@ -161,6 +166,7 @@ nas_proc_establish_ind (
 {
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   int                                     rc = RETURNerror;
+  emm_data_context_t                     *emm_ctx = NULL;
 
   if (msg) {
     emm_sap_t                               emm_sap = {0};
@@ -186,6 +192,10 @@ nas_proc_establish_ind (
     emm_sap.u.emm_as.u.establish.tac                = originating_tai.tac;
     emm_sap.u.emm_as.u.establish.ecgi               = cgi;
     rc = emm_sap_send (&emm_sap);
+    // the UE is in ECM-CONNECTED up to NAS_CONNECTION_RELEASE_IND
+    if ((emm_ctx = emm_data_context_get (&_emm_data, ue_id))) {
+      emm_ctx->is_ecm_connected = true;
+    }
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
@@ -363,6 +373,13 @@ nas_proc_ul_transfer_ind (
   if (msg) {
     emm_sap_t                               emm_sap = {0};
 
+    if (itti_trace_enabled ()) {
+      emm_data_context_t                     *ctxt = emm_data_context_get (&_emm_data, ue_id);
+
+      if (ctxt) {
+        itti_trace_resume (ctxt->trace_id);
+      }
+    }
     /*
      * Notify the EMM procedure call manager that data transfer
      * indication has been received from the Access-Stratum sublayer
@@ -420,6 +437,9 @@ nas_proc_authentication_info_answer (
       ctxt->timer_s6a_auth_info_rsp_arg = NULL;
     }  
   }
+  itti_trace_resume (ctxt->trace_id);
+  update_mme_app_stats_latency (MME_APP_LATENCY_S6A_AIR, ctxt->s6a_air_start_ns);
+  ctxt->s6a_air_start_ns = 0;
 
   if ((aia->result.present == S6A_RESULT_BASE)
        && (aia->result.choice.base == DIAMETER_SUCCESS)) {
@@ -592,18 +612,113 @@ nas_proc_smc_fail (
 //------------------------------------------------------------------------------
 int
 nas_proc_implicit_detach_ue_ind (
-  mme_ue_s1ap_id_t ue_id)
+  mme_ue_s1ap_id_t ue_id,
+  bool is_idle)
 {
   int                                     rc = RETURNerror;
   emm_sap_t                               emm_sap = {0};
+  emm_data_context_t                     *emm_ctx = NULL;
 
   OAILOG_FUNC_IN (LOG_NAS_EMM);
+  emm_ctx = emm_data_context_get (&_emm_data, ue_id);
+  if ((is_idle) && (emm_ctx) && (emm_ctx->is_ecm_connected)) {
+    // the UE established a signalling connection after MME_APP decided to detach it
+    OAILOG_INFO (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " no longer in ECM-IDLE, not implicitly detached\n", ue_id);
+    OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+  }
   emm_sap.primitive = EMMCN_IMPLICIT_DETACH_UE;
   emm_sap.u.emm_cn.u.emm_cn_implicit_detach.ue_id = ue_id;
   rc = emm_sap_send (&emm_sap);
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
 }
 
+//------------------------------------------------------------------------------
+/*
+ * Completes the checkpoint record of a UE in ECM-IDLE with its EMM and ESM
+ * contexts, which belong to this task, and gives it back to MME_APP.
+ */
+int
+nas_proc_ue_record_req (
+  itti_nas_ue_record_t * ue_record_req)
+{
+  emm_data_context_t                     *emm_ctx = NULL;
+  bool                                    is_valid = false;
+
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  emm_ctx = emm_data_context_get (&_emm_data, ue_record_req->ue_id);
+  if ((emm_ctx) && (!emm_ctx->is_ecm_connected)) {
+    is_valid = mme_app_checkpoint_fill_nas (emm_ctx, ue_record_req->record);
+  }
+  nas_itti_ue_record_rsp (ue_record_req->ue_id, ue_record_req->generation, ue_record_req->is_eviction, is_valid, ue_record_req->record);
+  ue_record_req->record = NULL;
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+int
+nas_proc_connection_release_ind (
+  mme_ue_s1ap_id_t ue_id)
+{
+  emm_data_context_t                     *emm_ctx = NULL;
+
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  emm_ctx = emm_data_context_get (&_emm_data, ue_id);
+  if (emm_ctx) {
+    emm_ctx->is_ecm_connected = false;
+  }
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * MME_APP evicted the UE, which it kept as a record: releases its EMM and ESM
+ * contexts unless the UE established a signalling connection or a procedure
+ * started since the record was filled.
+ */
+int
+nas_proc_ue_evict_ind (
+  mme_ue_s1ap_id_t ue_id)
+{
+  emm_data_context_t                     *emm_ctx = NULL;
+
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  emm_ctx = emm_data_context_get (&_emm_data, ue_id);
+  if (!emm_ctx) {
+    OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+  }
+  if ((emm_ctx->is_ecm_connected) || (EMM_REGISTERED != emm_ctx->_emm_fsm_status) || (emm_ctx->common_proc_mask) || (emm_ctx->specific_proc_mask)) {
+    OAILOG_WARNING (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " evicted by MME_APP no longer idle, EMM context kept\n", ue_id);
+    OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
+  }
+  emm_data_context_remove (&_emm_data, emm_ctx);
+  free_emm_data_context (emm_ctx);
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * MME_APP restored an evicted UE: rebuilds its EMM and ESM contexts from its
+ * record, before the NAS message of the UE if any. The record is freed.
+ */
+int
+nas_proc_ue_restore_ind (
+  itti_nas_ue_record_t * ue_restore_ind)
+{
+  int                                     rc = RETURNok;
+
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  if (emm_data_context_get (&_emm_data, ue_restore_ind->ue_id)) {
+    // the EMM context was kept on NAS_UE_EVICT_IND
+    OAILOG_DEBUG (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " restored by MME_APP has its EMM context\n", ue_restore_ind->ue_id);
+  } else if (!mme_app_checkpoint_restore_emm_context (ue_restore_ind->record)) {
+    OAILOG_ERROR (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " restored by MME_APP: EMM context not rebuilt\n", ue_restore_ind->ue_id);
+    rc = RETURNerror;
+  }
+  free (ue_restore_ind->record);
+  ue_restore_ind->record = NULL;
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
+}
+
 /****************************************************************************/
 /*********************  L O C A L    F U N C T I O N S  *********************/
 /****************************************************************************/
@@ -114,7 +114,11 @@ int nas_proc_pdn_connectivity_fail(itti_nas_pdn_connectivity_fail_t *nas_pdn_con
 int nas_proc_ho_bearer_modification_res (emm_cn_ho_bearer_mod_res_t * emm_cn_ho_bearer_mod_res);
 int nas_proc_ho_bearer_modification_fail (emm_cn_ho_bearer_mod_fail_t * emm_cn_ho_bearer_mod_fail);
 
-int nas_proc_implicit_detach_ue_ind (mme_ue_s1ap_id_t ue_id);
+int nas_proc_implicit_detach_ue_ind (mme_ue_s1ap_id_t ue_id, bool is_idle);
+int nas_proc_ue_record_req (itti_nas_ue_record_t * ue_record_req);
+int nas_proc_connection_release_ind (mme_ue_s1ap_id_t ue_id);
+int nas_proc_ue_evict_ind (mme_ue_s1ap_id_t ue_id);
+int nas_proc_ue_restore_ind (itti_nas_ue_record_t * ue_restore_ind);
 int nas_proc_smc_fail(emm_cn_smc_fail_t *emm_cn_smc_fail);
 
 #endif /* FILE_NAS_PROC_SEEN*/
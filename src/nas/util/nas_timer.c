@@ -47,6 +47,7 @@
 #if ENABLE_ITTI
 #  include "intertask_interface.h"
 #  include "timer.h"
+#  include "mme_app_shard.h"
 #else
 #  include <signal.h>
 #  include <time.h>             // clock_gettime
@@ -108,30 +109,30 @@ typedef struct {
   timer_queue_t                           tq[TIMER_DATABASE_SIZE];
   timer_queue_t                          *head; /* Pointer to the first timer entry to be fired  */
 
-#if ENABLE_ITTI == 0
   pthread_mutex_t                         mutex;
-#endif
 } nas_timer_database_t;
 
 /*
-   The timer database
+   The timer databases
+   With ITTI, each NAS task starts the timers of its UEs in its own database.
+   A timer identifier carries the index of its database, so that any thread
+   can stop or restart the timer under the lock of the database.
 */
-static nas_timer_database_t             _nas_timer_db = {
-  0,
-  {},
-  NULL
-#if ENABLE_ITTI == 0
-    , PTHREAD_MUTEX_INITIALIZER
-#endif
-};
-
 #if ENABLE_ITTI
-#  define nas_timer_lock_db()
-#  define nas_timer_unlock_db()
+#  define NAS_TIMER_NB_DATABASES MME_APP_MAX_WORKERS
+#  define NAS_TIMER_CURRENT_DB   (&_nas_timer_db[mme_app_current_shard])
 #else
-#  define nas_timer_lock_db()     pthread_mutex_lock(&_nas_timer_db.mutex)
-#  define nas_timer_unlock_db()   pthread_mutex_unlock(&_nas_timer_db.mutex)
+#  define NAS_TIMER_NB_DATABASES 1
+#  define NAS_TIMER_CURRENT_DB   (&_nas_timer_db[0])
 #endif
+static nas_timer_database_t             _nas_timer_db[NAS_TIMER_NB_DATABASES];
+
+#define NAS_TIMER_DB_OF_ID(iD)     (&_nas_timer_db[(iD) / TIMER_DATABASE_SIZE])
+#define NAS_TIMER_SLOT(iD)         ((iD) % TIMER_DATABASE_SIZE)
+#define NAS_TIMER_ID(dB, sLOT)     ((int)((dB) - _nas_timer_db) * TIMER_DATABASE_SIZE + (sLOT))
+
+#define nas_timer_lock_db(dB)      pthread_mutex_lock(&(dB)->mutex)
+#define nas_timer_unlock_db(dB)    pthread_mutex_unlock(&(dB)->mutex)
 
 /*
    The handler executed whenever the system timer expires
@@ -148,14 +149,15 @@ static void                             _nas_timer_handler (
 */
 static void
 _nas_timer_db_init (
-  void);
+  nas_timer_database_t * const db);
 
 static int
 _nas_timer_db_get_id (
-  void);
+  nas_timer_database_t * const db);
 
 static int
 _nas_timer_db_is_active (
+  nas_timer_database_t * const db,
   int id);
 
 static nas_timer_entry_t *
@@ -166,23 +168,28 @@ _nas_timer_db_create_entry (
 
 static void
 _nas_timer_db_delete_entry (
+  nas_timer_database_t * const db,
   int id);
 
 static void
 _nas_timer_db_insert_entry (
+  nas_timer_database_t * const db,
   int id,
   nas_timer_entry_t * te);
 
 static int
 _nas_timer_db_insert (
+  nas_timer_database_t * const db,
   timer_queue_t * entry);
 
 static nas_timer_entry_t *
 _nas_timer_db_remove_entry (
+  nas_timer_database_t * const db,
   int id);
 
 static int
 _nas_timer_db_remove (
+  nas_timer_database_t * const db,
   timer_queue_t * entry);
 
 /*
@@ -229,7 +236,7 @@ nas_timer_init (
   /*
    * Initialize the timer database
    */
-  _nas_timer_db_init ();
+  _nas_timer_db_init (NAS_TIMER_CURRENT_DB);
 #if ENABLE_ITTI == 0
   /*
    * Setup the timer database handler
@@ -281,12 +288,12 @@ nas_timer_start (
   nas_timer_callback_t cb,
   void *args)
 {
+  nas_timer_database_t                   *db = NAS_TIMER_CURRENT_DB;
   int                                     id;
   nas_timer_entry_t                      *te;
 
 #if ENABLE_ITTI
   int                                     ret;
-  long                                    timer_id;
 #endif
 
   /*
@@ -296,15 +303,17 @@ nas_timer_start (
     return (NAS_TIMER_INACTIVE_ID);
   }
 
+  nas_timer_lock_db (db);
   /*
    * Get an identifier for the new timer entry
    */
-  id = _nas_timer_db_get_id ();
+  id = _nas_timer_db_get_id (db);
 
   if (id < 0) {
     /*
      * No available timer entry found
      */
+    nas_timer_unlock_db (db);
     return (NAS_TIMER_INACTIVE_ID);
   }
 
@@ -314,22 +323,26 @@ nas_timer_start (
   te = _nas_timer_db_create_entry (sec, cb, args);
 
   if (te == NULL) {
+    nas_timer_unlock_db (db);
     return (NAS_TIMER_INACTIVE_ID);
   }
 
   /*
    * Insert the new entry into the timer queue
    */
-  _nas_timer_db_insert_entry (id, te);
+  _nas_timer_db_insert_entry (db, id, te);
 #if ENABLE_ITTI
-  ret = timer_setup (sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, args, &timer_id);
+  // the expiry is handled by the NAS task owning the database
+  ret = timer_setup (sec, 0, nas_shard_tasks[db - _nas_timer_db], INSTANCE_DEFAULT, TIMER_ONE_SHOT, args, &te->timer_id);
 
   if (ret == -1) {
+    _nas_timer_db_remove_entry (db, id);
+    _nas_timer_db_delete_entry (db, id);
+    nas_timer_unlock_db (db);
     return NAS_TIMER_INACTIVE_ID;
   }
-
-  te->timer_id = timer_id;
 #endif
+  nas_timer_unlock_db (db);
   return (id);
 }
 
@@ -352,16 +365,23 @@ int
 nas_timer_stop (
   int id)
 {
+  nas_timer_database_t                   *db = NULL;
+
+  if ((id < 0) || (id >= NAS_TIMER_NB_DATABASES * TIMER_DATABASE_SIZE)) {
+    return (id);
+  }
+  db = NAS_TIMER_DB_OF_ID (id);
+  nas_timer_lock_db (db);
   /*
    * Check if the timer entry is active
    */
-  if (_nas_timer_db_is_active (id)) {
+  if (_nas_timer_db_is_active (db, id)) {
     nas_timer_entry_t                      *entry;
 
     /*
      * Remove the entry from the timer queue
      */
-    entry = _nas_timer_db_remove_entry (id);
+    entry = _nas_timer_db_remove_entry (db, id);
 #if ENABLE_ITTI
     timer_remove (entry->timer_id);
 #else
@@ -370,10 +390,12 @@ nas_timer_stop (
     /*
      * Delete the timer entry
      */
-    _nas_timer_db_delete_entry (id);
+    _nas_timer_db_delete_entry (db, id);
+    nas_timer_unlock_db (db);
     return (NAS_TIMER_INACTIVE_ID);
   }
 
+  nas_timer_unlock_db (db);
   return (id);
 }
 
@@ -400,16 +422,22 @@ int
 nas_timer_restart (
   int id)
 {
+  nas_timer_database_t                   *db = NULL;
   int ret;
-  
+
+  if ((id < 0) || (id >= NAS_TIMER_NB_DATABASES * TIMER_DATABASE_SIZE)) {
+    return (NAS_TIMER_INACTIVE_ID);
+  }
+  db = NAS_TIMER_DB_OF_ID (id);
+  nas_timer_lock_db (db);
   /*
    * Check if the timer entry is active
    */
-  if (_nas_timer_db_is_active (id)) {
+  if (_nas_timer_db_is_active (db, id)) {
     /*
      * Remove the entry from the timer queue
      */
-    nas_timer_entry_t                      *te = _nas_timer_db_remove_entry (id);
+    nas_timer_entry_t                      *te = _nas_timer_db_remove_entry (db, id);
 
     /*
      * Initialize its interval timer value
@@ -418,18 +446,25 @@ nas_timer_restart (
     /*
      * Insert again the entry into the timer queue
      */
-    _nas_timer_db_insert_entry (id, te);
+    _nas_timer_db_insert_entry (db, id, te);
   #if ENABLE_ITTI
-    ret = timer_setup (te->itv.tv_sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, te->args, &(te->timer_id));
+    // one shot ITTI timers stay listed until they are removed
+    timer_remove (te->timer_id);
+    ret = timer_setup (te->itv.tv_sec, 0, nas_shard_tasks[db - _nas_timer_db], INSTANCE_DEFAULT, TIMER_ONE_SHOT, te->args, &(te->timer_id));
 
     if (ret == -1) {
+      _nas_timer_db_remove_entry (db, id);
+      _nas_timer_db_delete_entry (db, id);
+      nas_timer_unlock_db (db);
       return NAS_TIMER_INACTIVE_ID;
     }
   #endif
-    
+
+    nas_timer_unlock_db (db);
     return (id);
   }
 
+  nas_timer_unlock_db (db);
   return (NAS_TIMER_INACTIVE_ID);
 }
 
@@ -462,26 +497,43 @@ nas_timer_handle_signal_expiry (
   long timer_id,
   void *arg_p)
 {
+  nas_timer_database_t                   *db = NAS_TIMER_CURRENT_DB;
+  timer_queue_t                          *tq = NULL;
+  nas_timer_callback_t                    cb = NULL;
+  void                                   *args = NULL;
+
   /*
-   * Get the timer entry for which the system timer expired
+   * Get the timer entry for which the system timer expired, none if it was
+   * stopped or restarted by another thread once the expiry was queued
    */
-  nas_timer_entry_t                      *te = _nas_timer_db.head->entry;
-
-  te->cb (te->args);
+  nas_timer_lock_db (db);
+  for (tq = db->head; tq; tq = tq->next) {
+    if (tq->entry->timer_id == timer_id) {
+      cb = tq->entry->cb;
+      args = tq->entry->args;
+      break;
+    }
+  }
+  nas_timer_unlock_db (db);
+  if (cb) {
+    cb (args);
+  }
 }
 #else
 static void
 _nas_timer_handler (
   int signal)
 {
+  nas_timer_database_t                   *db = NAS_TIMER_CURRENT_DB;
+
   /*
    * At least one timer has been started
    */
-  assert ((_nas_timer_db.head ) && (_nas_timer_db.head->entry ));
+  assert ((db->head ) && (db->head->entry ));
   /*
    * Get the timer entry for which the system timer expired
    */
-  nas_timer_entry_t                      *te = _nas_timer_db.head->entry;
+  nas_timer_entry_t                      *te = db->head->entry;
 
   /*
    * Execute the callback function
@@ -534,13 +586,19 @@ _nas_timer_handler (
  ***************************************************************************/
 static void
 _nas_timer_db_init (
-  void)
+  nas_timer_database_t * const db)
 {
+  pthread_mutexattr_t                     attr;
   int                                     i;
 
   for (i = 0; i < TIMER_DATABASE_SIZE; i++) {
-    _nas_timer_db.tq[i].id = NAS_TIMER_INACTIVE_ID;
+    db->tq[i].id = NAS_TIMER_INACTIVE_ID;
   }
+  // the handler of the signal driven timers may stop a timer
+  pthread_mutexattr_init (&attr);
+  pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&db->mutex, &attr);
+  pthread_mutexattr_destroy (&attr);
 }
 
 /****************************************************************************
@@ -562,27 +620,27 @@ _nas_timer_db_init (
  ***************************************************************************/
 static int
 _nas_timer_db_get_id (
-  void)
+  nas_timer_database_t * const db)
 {
   int                                     i;
 
   /*
    * Search from the current timer entry to the last timer entry
    */
-  for (i = _nas_timer_db.timer_id; i < TIMER_DATABASE_SIZE; i++) {
-    if (_nas_timer_db.tq[i].id < 0) {
-      _nas_timer_db.timer_id = i + 1;
-      return i;
+  for (i = db->timer_id; i < TIMER_DATABASE_SIZE; i++) {
+    if (db->tq[i].id < 0) {
+      db->timer_id = i + 1;
+      return NAS_TIMER_ID (db, i);
     }
   }
 
   /*
    * Search from the first timer entry to the current timer entry
    */
-  for (i = 0; i < _nas_timer_db.timer_id; i++) {
-    if (_nas_timer_db.tq[i].id < 0) {
-      _nas_timer_db.timer_id = i + 1;
-      return i;
+  for (i = 0; i < db->timer_id; i++) {
+    if (db->tq[i].id < 0) {
+      db->timer_id = i + 1;
+      return NAS_TIMER_ID (db, i);
     }
   }
 
@@ -610,9 +668,10 @@ _nas_timer_db_get_id (
  ***************************************************************************/
 static int
 _nas_timer_db_is_active (
+  nas_timer_database_t * const db,
   int id)
 {
-  return ((id != NAS_TIMER_INACTIVE_ID) && (_nas_timer_db.tq[id].id != NAS_TIMER_INACTIVE_ID));
+  return ((id != NAS_TIMER_INACTIVE_ID) && (db->tq[NAS_TIMER_SLOT (id)].id == id));
 }
 
 /****************************************************************************
@@ -669,18 +728,19 @@ _nas_timer_db_create_entry (
  ***************************************************************************/
 static void
 _nas_timer_db_delete_entry (
+  nas_timer_database_t * const db,
   int id)
 {
   /*
    * The identifier of the timer is valid within the timer queue
    */
-  assert (_nas_timer_db.tq[id].id == id);
+  assert (db->tq[NAS_TIMER_SLOT (id)].id == id);
   /*
    * Delete the timer entry from the queue
    */
-  _nas_timer_db.tq[id].id = NAS_TIMER_INACTIVE_ID;
-  free_wrapper ((void**) &_nas_timer_db.tq[id].entry);
-  _nas_timer_db.tq[id].entry = NULL;
+  db->tq[NAS_TIMER_SLOT (id)].id = NAS_TIMER_INACTIVE_ID;
+  free_wrapper ((void**) &db->tq[NAS_TIMER_SLOT (id)].entry);
+  db->tq[NAS_TIMER_SLOT (id)].entry = NULL;
 }
 
 /****************************************************************************
@@ -703,6 +763,7 @@ _nas_timer_db_delete_entry (
  ***************************************************************************/
 static void
 _nas_timer_db_insert_entry (
+  nas_timer_database_t * const db,
   int id,
   nas_timer_entry_t * te)
 {
@@ -714,8 +775,8 @@ _nas_timer_db_insert_entry (
   /*
    * Enqueue the new timer entry
    */
-  _nas_timer_db.tq[id].id = id;
-  _nas_timer_db.tq[id].entry = te;
+  db->tq[NAS_TIMER_SLOT (id)].id = id;
+  db->tq[NAS_TIMER_SLOT (id)].entry = te;
   /*
    * Save its interval timer value
    */
@@ -734,9 +795,7 @@ _nas_timer_db_insert_entry (
   /*
    * Insert the new timer entry into the list of active entries
    */
-  nas_timer_lock_db ();
-  restart = _nas_timer_db_insert (&_nas_timer_db.tq[id]);
-  nas_timer_unlock_db ();
+  restart = _nas_timer_db_insert (db, &db->tq[NAS_TIMER_SLOT (id)]);
 #if ENABLE_ITTI == 0
 
   if (restart) {
@@ -753,6 +812,7 @@ _nas_timer_db_insert_entry (
 
 static int
 _nas_timer_db_insert (
+  nas_timer_database_t * const db,
   timer_queue_t * entry)
 {
   timer_queue_t                          *prev,
@@ -762,7 +822,7 @@ _nas_timer_db_insert (
    * Search the list of timer entries for the first entry with an interval
    * timer value greater than the interval timer value of the new timer entry
    */
-  for (prev = NULL, next = _nas_timer_db.head; next ; next = next->next) {
+  for (prev = NULL, next = db->head; next ; next = next->next) {
     if (_nas_timer_cmp (&next->entry->tv, &entry->entry->tv) > 0) {
       break;
     }
@@ -801,7 +861,7 @@ _nas_timer_db_insert (
     /*
      * The new entry is the first entry of the list
      */
-    _nas_timer_db.head = entry;
+    db->head = entry;
     return true;
   }
 
@@ -830,6 +890,7 @@ _nas_timer_db_insert (
  ***************************************************************************/
 static nas_timer_entry_t               *
 _nas_timer_db_remove_entry (
+  nas_timer_database_t * const db,
   int id)
 {
   int                                     restart;
@@ -837,13 +898,11 @@ _nas_timer_db_remove_entry (
   /*
    * The identifier of the timer is valid within the timer queue
    */
-  assert (_nas_timer_db.tq[id].id == id);
+  assert (db->tq[NAS_TIMER_SLOT (id)].id == id);
   /*
    * Remove the timer entry from the list of active entries
    */
-  nas_timer_lock_db ();
-  restart = _nas_timer_db_remove (&_nas_timer_db.tq[id]);
-  nas_timer_unlock_db ();
+  restart = _nas_timer_db_remove (db, &db->tq[NAS_TIMER_SLOT (id)]);
 
   if (restart) {
     int                                     rc;
@@ -863,9 +922,9 @@ _nas_timer_db_remove_entry (
     /*
      * tv = tv - time()
      */
-    rc = _nas_timer_sub (&_nas_timer_db.head->entry->tv, &tv, &it.it_value);
+    rc = _nas_timer_sub (&db->head->entry->tv, &tv, &it.it_value);
 #if ENABLE_ITTI
-    timer_remove (_nas_timer_db.head->entry->timer_id);
+    // every entry has its own ITTI timer, the next one keeps running
     (void)(rc);
 #else
 
@@ -887,11 +946,12 @@ _nas_timer_db_remove_entry (
   /*
    * Return a pointer to the removed entry
    */
-  return (_nas_timer_db.tq[id].entry);
+  return (db->tq[NAS_TIMER_SLOT (id)].entry);
 }
 
 static int
 _nas_timer_db_remove (
+  nas_timer_database_t * const db,
   timer_queue_t * entry)
 {
   /*
@@ -928,9 +988,9 @@ _nas_timer_db_remove (
     /*
      * The entry was the first entry of the list
      */
-    _nas_timer_db.head = entry->next;
+    db->head = entry->next;
 
-    if (_nas_timer_db.head ) {
+    if (db->head ) {
       /*
        * Other timers are scheduled to expire
        */
@@ -32,11 +32,14 @@
 #include "hss_config.h"
 
 typedef struct random_state_s {
-  pthread_mutex_t                         lock;
   gmp_randstate_t                         state;
+  unsigned int                            seed;
 } random_state_t;
 
-random_state_t                          random_state;
+/* Each S6a worker calls random_init() and draws from its own state, so
+ * vector generation does not serialize on a process wide lock.
+ */
+static __thread random_state_t          random_state;
 extern hss_config_t                     hss_config;
 static uint8_t                          no_random_delta = 0;
 
@@ -44,17 +47,15 @@ void
 random_init (
   void)
 {
-  pthread_mutex_init(&random_state.lock, NULL);
   if (hss_config.random_bool > 0) {
-    mpz_t number;
-    mpz_init(number);
     gmp_randinit_default(random_state.state);
     struct timeval     t1;
     gettimeofday (&t1, NULL);
-    srand (t1.tv_usec * t1.tv_sec);
+    random_state.seed = (unsigned int)(t1.tv_usec * t1.tv_sec) ^ (unsigned int)pthread_self();
+    gmp_randseed_ui(random_state.state, rand_r(&random_state.seed));
     FPRINTF_DEBUG ("Initialized random\n");
   } else {
-    srand (1);
+    random_state.seed = 1;
     FPRINTF_DEBUG ("Initialized pseudo-random\n");
   }
 }
@@ -70,26 +71,23 @@ generate_random (
   if (hss_config.random_bool > 0) {
     random_t random_nb;
     mpz_init_set_ui(random_nb, 0);
-    pthread_mutex_lock(&random_state.lock);
     mpz_urandomb(random_nb, random_state.state, 8 * length);
-    pthread_mutex_unlock(&random_state.lock);
     mpz_export(random_p, NULL, 1, length, 0, 0, random_nb);
+    mpz_clear(random_nb);
     int   r = 0,  mask = 0, shift;
     for (int i = 0; i < length; i++) {
       if ((i % sizeof(i)) == 0)
-        r = rand();
+        r = rand_r(&random_state.seed);
       shift = 8 * (i % sizeof(i));
       mask = 0xFF << shift;
       random_p[i] = (r & mask) >> shift;
     }
     FPRINTF_DEBUG ("Generated random\n");
   } else {
-    pthread_mutex_lock(&random_state.lock);
+    uint8_t delta = __sync_fetch_and_add (&no_random_delta, 1);
     for (int i = 0; i < length; i++) {
-      random_p[i] = i + no_random_delta;
+      random_p[i] = i + delta;
     }
-    no_random_delta += 1;
-    pthread_mutex_unlock(&random_state.lock);
     FPRINTF_DEBUG ("Generated pseudo-random\n");
   }
 }
@@ -30,7 +30,8 @@ typedef uint8_t                         u8;
 typedef uint32_t                        u32;
 
 /*-------------------- Rijndael round subkeys ---------------------*/
-u8                                      roundKeys[11][4][4];
+/* One key schedule per thread: the S6a workers derive vectors concurrently. */
+__thread u8                             roundKeys[11][4][4];
 
 /*--------------------- Rijndael S box table ----------------------*/
 u8                                      S[256] = {
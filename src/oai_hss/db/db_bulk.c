@@ -0,0 +1,778 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file db_bulk.c
+   \brief Bulk subscriber provisioning: stream a CSV file into the users table
+   with multi-row UPDATEs and INSERTs and export the table back in the same format.
+   \details CSV line format (one subscriber per line, '#' starts a comment):
+   imsi,key,opc,sqn,rand,msisdn,imei,ue_ambr_ul,ue_ambr_dl,access_restriction
+   key, opc and rand are 32 hex digits. Only imsi and key are mandatory, an
+   empty opc is computed from the operator key. For a new subscriber an empty
+   sqn or rand is 0 and the other empty fields take the column default. An
+   existing subscriber is updated in place by its IMSI, whatever the MME
+   identity its Update Location set, the columns of its empty fields keep
+   their value: a re-import does not reset its SQN or MSISDN.
+   \date 2017
+   \version 0.1
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <mysql/mysql.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "queue.h"
+#include "log.h"
+
+extern void                             ComputeOPc (
+  const uint8_t const kP[16],
+  const uint8_t const opP[16],
+  uint8_t opcP[16]);
+
+#define HSS_BULK_NB_FIELDS       (10)
+#define HSS_BULK_MSISDN_MAX      (46)
+/* Upper bound of one "(...)," VALUES tuple */
+#define HSS_BULK_ROW_SQL_MAX     (512)
+/* Parsed batches waiting for a loader, per loader */
+#define HSS_BULK_QUEUE_PER_LOADER (2)
+
+#define HSS_BULK_HAS_OPC         (1U)
+#define HSS_BULK_HAS_AMBR_UL     (1U << 1)
+#define HSS_BULK_HAS_AMBR_DL     (1U << 2)
+#define HSS_BULK_HAS_AR          (1U << 3)
+#define HSS_BULK_HAS_SQN         (1U << 4)
+#define HSS_BULK_HAS_RAND        (1U << 5)
+#define HSS_BULK_HAS_MSISDN      (1U << 6)
+#define HSS_BULK_HAS_IMEI        (1U << 7)
+/* Fields updating their column only when not empty */
+#define HSS_BULK_OPTIONAL_FIELDS (HSS_BULK_HAS_AMBR_UL | HSS_BULK_HAS_AMBR_DL | HSS_BULK_HAS_AR | HSS_BULK_HAS_SQN | \
+                                  HSS_BULK_HAS_RAND | HSS_BULK_HAS_MSISDN | HSS_BULK_HAS_IMEI)
+
+typedef struct hss_bulk_subscriber_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  char                                    msisdn[HSS_BULK_MSISDN_MAX + 1];
+  char                                    imei[IMEI_LENGTH_MAX + 1];
+  uint8_t                                 key[KEY_LENGTH];
+  uint8_t                                 opc[KEY_LENGTH];
+  uint8_t                                 rand[RAND_LENGTH];
+  uint64_t                                sqn;
+  uint64_t                                ue_ambr_ul;
+  uint64_t                                ue_ambr_dl;
+  uint32_t                                access_restriction;
+  uint32_t                                flags;
+} hss_bulk_subscriber_t;
+
+typedef struct hss_bulk_batch_s {
+  STAILQ_ENTRY (hss_bulk_batch_s)         entries;
+  int                                     nb_rows;
+  hss_bulk_subscriber_t                   rows[HSS_BULK_BATCH_SIZE];
+} hss_bulk_batch_t;
+
+typedef struct hss_bulk_import_s {
+  const hss_config_t                     *hss_config_p;
+  const uint8_t                          *opP;
+  pthread_mutex_t                         lock;
+  pthread_cond_t                          not_empty;
+  pthread_cond_t                          not_full;
+  STAILQ_HEAD (, hss_bulk_batch_s)        queue;
+  int                                     queue_depth;
+  int                                     queue_max;
+  bool                                    done;      /* end of file reached */
+  int                                     loaders;   /* loaders still running */
+  hss_bulk_stats_t                       *stats;
+} hss_bulk_import_t;
+
+static const char                       hss_bulk_header[] = "# imsi,key,opc,sqn,rand,msisdn,imei,ue_ambr_ul,ue_ambr_dl,access_restriction";
+
+static const struct {
+  uint32_t                                flag;
+  const char                             *column;
+} hss_bulk_optional_columns[] = {
+  {HSS_BULK_HAS_SQN, "sqn"},
+  {HSS_BULK_HAS_RAND, "rand"},
+  {HSS_BULK_HAS_MSISDN, "msisdn"},
+  {HSS_BULK_HAS_IMEI, "imei"},
+  {HSS_BULK_HAS_AMBR_UL, "ue_ambr_ul"},
+  {HSS_BULK_HAS_AMBR_DL, "ue_ambr_dl"},
+  {HSS_BULK_HAS_AR, "access_restriction"},
+};
+
+//------------------------------------------------------------------------------
+static double
+hss_bulk_now_sec (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static bool
+hss_bulk_parse_hex (
+  const char *str,
+  uint8_t * out,
+  size_t length)
+{
+  if (strlen (str) != 2 * length) {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    unsigned int                            byte;
+
+    if (!isxdigit ((unsigned char)str[2 * i]) || !isxdigit ((unsigned char)str[2 * i + 1]) || (sscanf (&str[2 * i], "%2x", &byte) != 1)) {
+      return false;
+    }
+
+    out[i] = (uint8_t) byte;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static bool
+hss_bulk_parse_digits (
+  const char *str,
+  char *out,
+  size_t max_length)
+{
+  size_t                                  length = strlen (str);
+
+  if (length > max_length) {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    if (!isdigit ((unsigned char)str[i])) {
+      return false;
+    }
+  }
+
+  memcpy (out, str, length + 1);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static bool
+hss_bulk_parse_u64 (
+  const char *str,
+  uint64_t * out)
+{
+  char                                    digits[21];
+
+  if ((*str == '\0') || !hss_bulk_parse_digits (str, digits, sizeof (digits) - 1)) {
+    return false;
+  }
+
+  *out = strtoull (digits, NULL, 10);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/* Parse one CSV line in place, returns false if the line is malformed */
+static bool
+hss_bulk_parse_line (
+  char *line,
+  hss_bulk_subscriber_t * sub)
+{
+  char                                   *fields[HSS_BULK_NB_FIELDS] = {NULL};
+  int                                     nb_fields = 0;
+  char                                   *cursor = line;
+  uint64_t                                value;
+
+  while ((cursor != NULL) && (nb_fields < HSS_BULK_NB_FIELDS)) {
+    fields[nb_fields++] = cursor;
+    cursor = strchr (cursor, ',');
+
+    if (cursor != NULL) {
+      *cursor++ = '\0';
+    }
+  }
+
+  if ((cursor != NULL) || (nb_fields < 2)) {
+    return false;
+  }
+
+  for (int i = nb_fields; i < HSS_BULK_NB_FIELDS; i++) {
+    fields[i] = "";
+  }
+
+  memset (sub, 0, sizeof (*sub));
+
+  if ((strlen (fields[0]) < 5) || !hss_bulk_parse_digits (fields[0], sub->imsi, IMSI_LENGTH_MAX)) {
+    return false;
+  }
+
+  if (!hss_bulk_parse_hex (fields[1], sub->key, KEY_LENGTH)) {
+    return false;
+  }
+
+  if (fields[2][0] != '\0') {
+    if (!hss_bulk_parse_hex (fields[2], sub->opc, KEY_LENGTH)) {
+      return false;
+    }
+
+    sub->flags |= HSS_BULK_HAS_OPC;
+  }
+
+  if (fields[3][0] != '\0') {
+    /*
+     * SQN is 48 bits
+     */
+    if (!hss_bulk_parse_u64 (fields[3], &sub->sqn) || (sub->sqn >> 48)) {
+      return false;
+    }
+
+    sub->flags |= HSS_BULK_HAS_SQN;
+  }
+
+  if (fields[4][0] != '\0') {
+    if (!hss_bulk_parse_hex (fields[4], sub->rand, RAND_LENGTH)) {
+      return false;
+    }
+
+    sub->flags |= HSS_BULK_HAS_RAND;
+  }
+
+  if (!hss_bulk_parse_digits (fields[5], sub->msisdn, HSS_BULK_MSISDN_MAX) || !hss_bulk_parse_digits (fields[6], sub->imei, IMEI_LENGTH_MAX)) {
+    return false;
+  }
+
+  if (sub->msisdn[0] != '\0') {
+    sub->flags |= HSS_BULK_HAS_MSISDN;
+  }
+
+  if (sub->imei[0] != '\0') {
+    sub->flags |= HSS_BULK_HAS_IMEI;
+  }
+
+  if (fields[7][0] != '\0') {
+    if (!hss_bulk_parse_u64 (fields[7], &sub->ue_ambr_ul)) {
+      return false;
+    }
+
+    sub->flags |= HSS_BULK_HAS_AMBR_UL;
+  }
+
+  if (fields[8][0] != '\0') {
+    if (!hss_bulk_parse_u64 (fields[8], &sub->ue_ambr_dl)) {
+      return false;
+    }
+
+    sub->flags |= HSS_BULK_HAS_AMBR_DL;
+  }
+
+  if (fields[9][0] != '\0') {
+    if (!hss_bulk_parse_u64 (fields[9], &value) || (value > UINT32_MAX)) {
+      return false;
+    }
+
+    sub->access_restriction = (uint32_t) value;
+    sub->flags |= HSS_BULK_HAS_AR;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static int
+hss_bulk_sql_hex (
+  char *out,
+  const uint8_t * in,
+  size_t length)
+{
+  int                                     n = sprintf (out, "UNHEX('");
+
+  for (size_t i = 0; i < length; i++) {
+    n += sprintf (&out[n], "%02x", in[i]);
+  }
+
+  return n + sprintf (&out[n], "')");
+}
+
+//------------------------------------------------------------------------------
+/* Append the SELECT of one subscriber to the rows of a batch, the columns are named by the first one.
+   sqn and rand are always there (0 for a new subscriber), the other optional columns only if in fields */
+static int
+hss_bulk_sql_select (
+  char *out,
+  const hss_bulk_subscriber_t * sub,
+  const uint32_t fields,
+  const bool first)
+{
+  int                                     n = 0;
+
+  n += sprintf (&out[n], first ? "SELECT '%s' AS `imsi`," : " UNION ALL SELECT '%s',", sub->imsi);
+  n += hss_bulk_sql_hex (&out[n], sub->key, KEY_LENGTH);
+  n += sprintf (&out[n], first ? " AS `key`," : ",");
+  n += hss_bulk_sql_hex (&out[n], sub->opc, KEY_LENGTH);
+  n += sprintf (&out[n], first ? " AS `OPc`,%" PRIu64 " AS `sqn`," : ",%" PRIu64 ",", sub->sqn);
+  n += hss_bulk_sql_hex (&out[n], sub->rand, RAND_LENGTH);
+  n += sprintf (&out[n], first ? " AS `rand`" : "");
+
+  if (fields & HSS_BULK_HAS_MSISDN) {
+    n += sprintf (&out[n], first ? ",'%s' AS `msisdn`" : ",'%s'", sub->msisdn);
+  }
+
+  if (fields & HSS_BULK_HAS_IMEI) {
+    n += sprintf (&out[n], first ? ",'%s' AS `imei`" : ",'%s'", sub->imei);
+  }
+
+  if (fields & HSS_BULK_HAS_AMBR_UL) {
+    n += sprintf (&out[n], first ? ",%" PRIu64 " AS `ue_ambr_ul`" : ",%" PRIu64, sub->ue_ambr_ul);
+  }
+
+  if (fields & HSS_BULK_HAS_AMBR_DL) {
+    n += sprintf (&out[n], first ? ",%" PRIu64 " AS `ue_ambr_dl`" : ",%" PRIu64, sub->ue_ambr_dl);
+  }
+
+  if (fields & HSS_BULK_HAS_AR) {
+    n += sprintf (&out[n], first ? ",%" PRIu32 " AS `access_restriction`" : ",%" PRIu32, sub->access_restriction);
+  }
+
+  return n;
+}
+
+//------------------------------------------------------------------------------
+/* UPDATE of the existing subscribers of the rows, every row of their IMSI whatever its MME identity:
+   the columns of the empty fields are left out */
+static int
+hss_bulk_sql_update (
+  char *out,
+  const char *rows,
+  const uint32_t fields)
+{
+  int                                     n = sprintf (out, "UPDATE `users` AS `u` JOIN (%s) AS `v` ON `u`.`imsi`=`v`.`imsi` "
+                                                       "SET `u`.`key`=`v`.`key`,`u`.`OPc`=`v`.`OPc`", rows);
+
+  for (size_t i = 0; i < sizeof (hss_bulk_optional_columns) / sizeof (hss_bulk_optional_columns[0]); i++) {
+    if (fields & hss_bulk_optional_columns[i].flag) {
+      n += sprintf (&out[n], ",`u`.`%s`=`v`.`%s`", hss_bulk_optional_columns[i].column, hss_bulk_optional_columns[i].column);
+    }
+  }
+
+  return n;
+}
+
+//------------------------------------------------------------------------------
+/* INSERT of the new subscribers of the rows, the columns of the empty fields take their default.
+   A subscriber inserted in the meantime by another loader is updated */
+static int
+hss_bulk_sql_insert (
+  char *out,
+  const char *rows,
+  const uint32_t fields)
+{
+  int                                     n = sprintf (out, "INSERT INTO `users` (`imsi`,`key`,`OPc`,`sqn`,`rand`");
+
+  for (size_t i = 0; i < sizeof (hss_bulk_optional_columns) / sizeof (hss_bulk_optional_columns[0]); i++) {
+    if ((fields & hss_bulk_optional_columns[i].flag) && !(hss_bulk_optional_columns[i].flag & (HSS_BULK_HAS_SQN | HSS_BULK_HAS_RAND))) {
+      n += sprintf (&out[n], ",`%s`", hss_bulk_optional_columns[i].column);
+    }
+  }
+
+  n += sprintf (&out[n], ") SELECT * FROM (%s) AS `v` WHERE NOT EXISTS (SELECT 1 FROM `users` AS `u` WHERE `u`.`imsi`=`v`.`imsi`)"
+                " ON DUPLICATE KEY UPDATE `key`=VALUES(`key`),`OPc`=VALUES(`OPc`)", rows);
+
+  for (size_t i = 0; i < sizeof (hss_bulk_optional_columns) / sizeof (hss_bulk_optional_columns[0]); i++) {
+    if (fields & hss_bulk_optional_columns[i].flag) {
+      n += sprintf (&out[n], ",`%s`=VALUES(`%s`)", hss_bulk_optional_columns[i].column, hss_bulk_optional_columns[i].column);
+    }
+  }
+
+  return n;
+}
+
+//------------------------------------------------------------------------------
+static void                            *
+hss_bulk_loader (
+  void *arg)
+{
+  hss_bulk_import_t                      *ctx = (hss_bulk_import_t *) arg;
+  hss_bulk_batch_t                       *batch = NULL;
+  char                                   *rows = NULL;
+  char                                   *query = NULL;
+  bool                                    connected = false;
+  bool                                    written[HSS_BULK_BATCH_SIZE];
+
+  rows = malloc (HSS_BULK_BATCH_SIZE * HSS_BULK_ROW_SQL_MAX);
+  query = malloc (HSS_BULK_BATCH_SIZE * HSS_BULK_ROW_SQL_MAX + 1024);
+  connected = (rows != NULL) && (query != NULL) && (hss_mysql_connect (ctx->hss_config_p) == 0);
+
+  if (!connected) {
+    FPRINTF_ERROR ("Bulk import: loader cannot connect to the database\n");
+  }
+
+  while (1) {
+    uint64_t                                opc_computed = 0;
+    uint32_t                                fields = 0;
+    int                                     nb_rows = 0;
+    int                                     n = 0;
+    bool                                    failed = false;
+
+    pthread_mutex_lock (&ctx->lock);
+
+    while (STAILQ_EMPTY (&ctx->queue) && !ctx->done) {
+      pthread_cond_wait (&ctx->not_empty, &ctx->lock);
+    }
+
+    batch = STAILQ_FIRST (&ctx->queue);
+
+    if (batch == NULL) {
+      pthread_mutex_unlock (&ctx->lock);
+      break;
+    }
+
+    STAILQ_REMOVE_HEAD (&ctx->queue, entries);
+    ctx->queue_depth--;
+    pthread_cond_signal (&ctx->not_full);
+    pthread_mutex_unlock (&ctx->lock);
+
+    if (!connected) {
+      /*
+       * Keep draining so that the reader never blocks on a dead pool
+       */
+      __sync_fetch_and_add (&ctx->stats->failed_batches, 1);
+      free (batch);
+      continue;
+    }
+
+    for (int i = 0; i < batch->nb_rows; i++) {
+      if (!(batch->rows[i].flags & HSS_BULK_HAS_OPC)) {
+        ComputeOPc (batch->rows[i].key, ctx->opP, batch->rows[i].opc);
+        opc_computed++;
+      }
+
+      written[i] = false;
+    }
+
+    /*
+     * One UPDATE and one INSERT per set of non empty fields, usually the same for the whole file.
+     * The primary key is the IMSI and the MME identity set by the Update Location: the existing
+     * subscribers are matched by their IMSI, not by the key
+     */
+    for (int first = 0; first < batch->nb_rows; first++) {
+      if (written[first]) {
+        continue;
+      }
+
+      fields = batch->rows[first].flags & HSS_BULK_OPTIONAL_FIELDS;
+      nb_rows = 0;
+      n = 0;
+
+      for (int i = first; i < batch->nb_rows; i++) {
+        if (written[i] || ((batch->rows[i].flags & HSS_BULK_OPTIONAL_FIELDS) != fields)) {
+          continue;
+        }
+
+        n += hss_bulk_sql_select (&rows[n], &batch->rows[i], fields, nb_rows++ == 0);
+        written[i] = true;
+      }
+
+      hss_bulk_sql_update (query, rows, fields);
+      failed = (mysql_query (db_desc->db_conn, query) != 0);
+
+      if (!failed) {
+        hss_bulk_sql_insert (query, rows, fields);
+        failed = (mysql_query (db_desc->db_conn, query) != 0);
+      }
+
+      if (failed) {
+        FPRINTF_ERROR ("Bulk import: %d subscribers from IMSI %s failed: %s\n", nb_rows, batch->rows[first].imsi, mysql_error (db_desc->db_conn));
+        __sync_fetch_and_add (&ctx->stats->failed_batches, 1);
+      } else {
+        __sync_fetch_and_add (&ctx->stats->rows, nb_rows);
+      }
+    }
+
+    __sync_fetch_and_add (&ctx->stats->opc_computed, opc_computed);
+    free (batch);
+  }
+
+  if (connected) {
+    hss_mysql_disconnect ();
+  }
+
+  free (rows);
+  free (query);
+  pthread_mutex_lock (&ctx->lock);
+  ctx->loaders--;
+  pthread_cond_signal (&ctx->not_full);
+  pthread_mutex_unlock (&ctx->lock);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/* Hand a full batch to the loaders, returns false if no loader is left */
+static bool
+hss_bulk_push (
+  hss_bulk_import_t * ctx,
+  hss_bulk_batch_t * batch)
+{
+  pthread_mutex_lock (&ctx->lock);
+
+  while ((ctx->queue_depth >= ctx->queue_max) && (ctx->loaders > 0)) {
+    pthread_cond_wait (&ctx->not_full, &ctx->lock);
+  }
+
+  if (ctx->loaders == 0) {
+    pthread_mutex_unlock (&ctx->lock);
+    free (batch);
+    return false;
+  }
+
+  STAILQ_INSERT_TAIL (&ctx->queue, batch, entries);
+  ctx->queue_depth++;
+  pthread_cond_signal (&ctx->not_empty);
+  pthread_mutex_unlock (&ctx->lock);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int
+hss_mysql_bulk_import (
+  const hss_config_t * hss_config_p,
+  const char *file_name,
+  const uint8_t * opP,
+  int nb_threads,
+  hss_bulk_stats_t * stats)
+{
+  hss_bulk_import_t                       ctx;
+  pthread_t                              *threads = NULL;
+  hss_bulk_batch_t                       *batch = NULL;
+  FILE                                   *file = NULL;
+  char                                   *line = NULL;
+  size_t                                  line_size = 0;
+  ssize_t                                 length;
+  uint64_t                                line_number = 0;
+  double                                  start = hss_bulk_now_sec ();
+  int                                     started = 0;
+  int                                     ret = 0;
+
+  if ((hss_config_p == NULL) || (file_name == NULL) || (stats == NULL) || (nb_threads < 1)) {
+    return EINVAL;
+  }
+
+  memset (stats, 0, sizeof (*stats));
+  file = (strcmp (file_name, "-") == 0) ? stdin : fopen (file_name, "r");
+
+  if (file == NULL) {
+    FPRINTF_ERROR ("Bulk import: cannot open %s: %s\n", file_name, strerror (errno));
+    return errno;
+  }
+
+  memset (&ctx, 0, sizeof (ctx));
+  ctx.hss_config_p = hss_config_p;
+  ctx.opP = opP;
+  ctx.queue_max = HSS_BULK_QUEUE_PER_LOADER * nb_threads;
+  ctx.stats = stats;
+  pthread_mutex_init (&ctx.lock, NULL);
+  pthread_cond_init (&ctx.not_empty, NULL);
+  pthread_cond_init (&ctx.not_full, NULL);
+  STAILQ_INIT (&ctx.queue);
+  threads = calloc (nb_threads, sizeof (pthread_t));
+
+  for (int i = 0; (threads != NULL) && (i < nb_threads); i++) {
+    pthread_mutex_lock (&ctx.lock);
+    ctx.loaders++;
+    pthread_mutex_unlock (&ctx.lock);
+
+    if (pthread_create (&threads[i], NULL, hss_bulk_loader, &ctx) != 0) {
+      pthread_mutex_lock (&ctx.lock);
+      ctx.loaders--;
+      pthread_mutex_unlock (&ctx.lock);
+      break;
+    }
+
+    started++;
+  }
+
+  if (started == 0) {
+    FPRINTF_ERROR ("Bulk import: cannot start the loader threads\n");
+    ret = -1;
+    goto out;
+  }
+
+  FPRINTF_NOTICE ("Bulk import of %s with %d loaders\n", file_name, started);
+
+  while ((length = getline (&line, &line_size, file)) != -1) {
+    line_number++;
+
+    while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'))) {
+      line[--length] = '\0';
+    }
+
+    if ((length == 0) || (line[0] == '#') || ((line_number == 1) && !isdigit ((unsigned char)line[0]))) {
+      continue;
+    }
+
+    if (batch == NULL) {
+      batch = malloc (sizeof (hss_bulk_batch_t));
+
+      if (batch == NULL) {
+        ret = ENOMEM;
+        break;
+      }
+
+      batch->nb_rows = 0;
+    }
+
+    if (!hss_bulk_parse_line (line, &batch->rows[batch->nb_rows])) {
+      FPRINTF_ERROR ("Bulk import: %s:%" PRIu64 ": malformed subscriber, skipped\n", file_name, line_number);
+      stats->rejected++;
+      continue;
+    }
+
+    if (!(batch->rows[batch->nb_rows].flags & HSS_BULK_HAS_OPC) && (opP == NULL)) {
+      FPRINTF_ERROR ("Bulk import: %s:%" PRIu64 ": no OPc and no operator key, skipped\n", file_name, line_number);
+      stats->rejected++;
+      continue;
+    }
+
+    if (++batch->nb_rows == HSS_BULK_BATCH_SIZE) {
+      if (!hss_bulk_push (&ctx, batch)) {
+        ret = -1;
+        batch = NULL;
+        break;
+      }
+
+      batch = NULL;
+    }
+  }
+
+  if ((batch != NULL) && (batch->nb_rows > 0) && (ret == 0)) {
+    if (!hss_bulk_push (&ctx, batch)) {
+      ret = -1;
+    }
+  } else {
+    free (batch);
+  }
+
+out:
+  pthread_mutex_lock (&ctx.lock);
+  ctx.done = true;
+  pthread_cond_broadcast (&ctx.not_empty);
+  pthread_mutex_unlock (&ctx.lock);
+
+  for (int i = 0; i < started; i++) {
+    pthread_join (threads[i], NULL);
+  }
+
+  free (threads);
+  free (line);
+
+  if (file != stdin) {
+    fclose (file);
+  }
+
+  pthread_cond_destroy (&ctx.not_full);
+  pthread_cond_destroy (&ctx.not_empty);
+  pthread_mutex_destroy (&ctx.lock);
+  stats->elapsed_sec = hss_bulk_now_sec () - start;
+
+  if ((ret == 0) && (stats->failed_batches > 0)) {
+    ret = -1;
+  }
+
+  return ret;
+}
+
+//------------------------------------------------------------------------------
+int
+hss_mysql_bulk_export (
+  const char *file_name,
+  hss_bulk_stats_t * stats)
+{
+  MYSQL_RES                              *res = NULL;
+  MYSQL_ROW                               row;
+  FILE                                   *file = NULL;
+  double                                  start = hss_bulk_now_sec ();
+  int                                     ret = 0;
+
+  if ((db_desc == NULL) || (db_desc->db_conn == NULL) || (file_name == NULL) || (stats == NULL)) {
+    return EINVAL;
+  }
+
+  memset (stats, 0, sizeof (*stats));
+  file = fopen (file_name, "w");
+
+  if (file == NULL) {
+    FPRINTF_ERROR ("Bulk export: cannot open %s: %s\n", file_name, strerror (errno));
+    return errno;
+  }
+
+  if (mysql_query (db_desc->db_conn, "SELECT `imsi`,HEX(`key`),HEX(`OPc`),`sqn`,HEX(`rand`),`msisdn`,`imei`,`ue_ambr_ul`,`ue_ambr_dl`,`access_restriction` FROM `users`")) {
+    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+    ret = EINVAL;
+    goto out;
+  }
+
+  /*
+   * Stream the rows instead of buffering the whole table client side
+   */
+  res = mysql_use_result (db_desc->db_conn);
+
+  if (res == NULL) {
+    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+    ret = EINVAL;
+    goto out;
+  }
+
+  fprintf (file, "%s\n", hss_bulk_header);
+
+  while ((row = mysql_fetch_row (res)) != NULL) {
+    for (int i = 0; i < HSS_BULK_NB_FIELDS; i++) {
+      fprintf (file, "%s%s", (i > 0) ? "," : "", (row[i] != NULL) ? row[i] : "");
+    }
+
+    fputc ('\n', file);
+    stats->rows++;
+  }
+
+  if (mysql_errno (db_desc->db_conn)) {
+    FPRINTF_ERROR ("Bulk export interrupted: %s\n", mysql_error (db_desc->db_conn));
+    ret = EINVAL;
+  }
+
+  mysql_free_result (res);
+out:
+
+  if ((fclose (file) != 0) && (ret == 0)) {
+    ret = errno;
+  }
+
+  stats->elapsed_sec = hss_bulk_now_sec () - start;
+  return ret;
+}
@@ -42,7 +42,7 @@ extern void                             ComputeOPc (
   uint8_t opcP[16]);
 
 
-database_t                             *db_desc;
+__thread database_t                    *db_desc;
 
 static void
 print_buffer (
@@ -115,8 +115,19 @@ void
 hss_mysql_disconnect (
   void)
 {
+  if (db_desc == NULL) {
+    return;
+  }
+
   mysql_close (db_desc->db_conn);
   mysql_thread_end();
+  free (db_desc->server);
+  free (db_desc->user);
+  free (db_desc->password);
+  free (db_desc->database);
+  pthread_mutex_destroy (&db_desc->db_cs_mutex);
+  free (db_desc);
+  db_desc = NULL;
 }
 
 int
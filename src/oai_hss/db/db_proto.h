@@ -41,7 +41,10 @@ typedef struct {
   pthread_mutex_t db_cs_mutex;
 } database_t;
 
-extern database_t *db_desc;
+/* One connection per thread: every S6a worker calls hss_mysql_connect() from
+ * its own thread and never shares the MYSQL handle.
+ */
+extern __thread database_t *db_desc;
 
 typedef uint32_t pre_emp_vul_t;
 typedef uint32_t pre_emp_cap_t;
@@ -193,5 +196,30 @@ int hss_mysql_increment_sqn(const char *imsi);
 
 int hss_mysql_check_opc_keys(const uint8_t const opP[16]);
 
+/* Rows per multi-row INSERT of the bulk loader */
+#define HSS_BULK_BATCH_SIZE (1000)
+
+typedef struct hss_bulk_stats_s {
+  uint64_t rows;           /* Subscribers written to the database or the file */
+  uint64_t rejected;       /* Malformed lines skipped */
+  uint64_t opc_computed;   /* OPc derived from the operator key */
+  uint64_t failed_batches; /* INSERT statements refused by the database */
+  double   elapsed_sec;
+} hss_bulk_stats_t;
+
+/* Stream a subscriber CSV file into the users table. The file is parsed by
+ * the calling thread, nb_threads loaders compute the missing OPc (opP may be
+ * NULL if every line carries its OPc) and run the multi-row UPDATEs and
+ * INSERTs on their own connection.
+ */
+int hss_mysql_bulk_import(const hss_config_t *hss_config_p,
+                          const char *file_name, const uint8_t *opP,
+                          int nb_threads, hss_bulk_stats_t *stats);
+
+/* Stream the users table to a CSV file in the import format, using the
+ * calling thread connection.
+ */
+int hss_mysql_bulk_export(const char *file_name, hss_bulk_stats_t *stats);
+
 
 #endif /* DB_PROTO_H_ */
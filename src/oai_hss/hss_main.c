@@ -30,12 +30,14 @@
 #include <errno.h>
 #include <syslog.h>
 #include <string.h>
+#include <inttypes.h>
 
 #include "hss_config.h"
 #include "db_proto.h"
 #include "s6a_proto.h"
 #include "auc.h"
 #include "pid_file.h"
+#include "log.h"
 
 hss_config_t                            hss_config;
 
@@ -46,6 +48,7 @@ main (
   char *argv[])
 {
   char   *pid_file_name = NULL;
+  int     stats_elapsed_sec = 0;
 
   pid_file_name = get_exe_basename();
 
@@ -108,10 +111,42 @@ main (
 
   random_init ();
 
+  if (hss_config.bulk_import_file || hss_config.bulk_export_file) {
+    hss_bulk_stats_t stats;
+    int              ret = 0;
+
+    if (hss_config.bulk_import_file) {
+      ret = hss_mysql_bulk_import (&hss_config, hss_config.bulk_import_file,
+                                   hss_config.valid_op ? (uint8_t *) hss_config.operator_key_bin : NULL,
+                                   hss_config.workers, &stats);
+      FPRINTF_NOTICE ("Imported %" PRIu64 " subscribers in %.1f s (%.0f/s), %" PRIu64 " OPc computed, %" PRIu64 " lines rejected, %" PRIu64 " batches failed\n",
+                      stats.rows, stats.elapsed_sec, (stats.elapsed_sec > 0) ? stats.rows / stats.elapsed_sec : 0.0,
+                      stats.opc_computed, stats.rejected, stats.failed_batches);
+    }
+
+    if ((ret == 0) && hss_config.bulk_export_file) {
+      ret = hss_mysql_bulk_export (hss_config.bulk_export_file, &stats);
+      FPRINTF_NOTICE ("Exported %" PRIu64 " subscribers in %.1f s (%.0f/s)\n",
+                      stats.rows, stats.elapsed_sec, (stats.elapsed_sec > 0) ? stats.rows / stats.elapsed_sec : 0.0);
+    }
+
+    hss_mysql_disconnect ();
+    pid_file_unlock();
+    free(pid_file_name);
+    return (ret == 0) ? 0 : -1;
+  }
+
   if (hss_config.valid_op) {
     hss_mysql_check_opc_keys ((uint8_t *) hss_config.operator_key_bin);
   }
 
+  /*
+   * Workers first: the s6a dispatch callbacks queue the requests to them
+   */
+  if (s6a_workers_init (&hss_config) != 0) {
+    return -1;
+  }
+
   s6a_init (&hss_config);
 
   while (1) {
@@ -119,6 +154,11 @@ main (
      * TODO: handle signals here
      */
     sleep (1);
+
+    if ((hss_config.stats_period_sec > 0) && (++stats_elapsed_sec >= hss_config.stats_period_sec)) {
+      s6a_workers_report ();
+      stats_elapsed_sec = 0;
+    }
   }
 
   pid_file_unlock();
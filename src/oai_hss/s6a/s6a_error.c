@@ -74,6 +74,9 @@ retcode_2_string (
   case ER_DIAMETER_INVALID_AVP_VALUE:
     return "DIAMETER_INVALID_AVP_VALUE";
 
+  case ER_DIAMETER_TOO_BUSY:
+    return "DIAMETER_TOO_BUSY";
+
   default:
     break;
   }
@@ -231,7 +231,7 @@ s6a_init (
   /*
    * Register the callbacks for S6A Application
    */
-  CHECK_FCT (fd_disp_register (s6a_auth_info_cb, DISP_HOW_CC, &when, NULL, &handle));
+  CHECK_FCT (fd_disp_register (s6a_workers_dispatch_cb, DISP_HOW_CC, &when, (void *)(intptr_t)S6A_REQUEST_AIR, &handle));
 
   if (handle == NULL) {
     strcpy (why, "cannot register authentication info req cb");
@@ -243,7 +243,7 @@ s6a_init (
   /*
    * Register the callbacks for S6A Application
    */
-  CHECK_FCT (fd_disp_register (s6a_up_loc_cb, DISP_HOW_CC, &when, NULL, &handle));
+  CHECK_FCT (fd_disp_register (s6a_workers_dispatch_cb, DISP_HOW_CC, &when, (void *)(intptr_t)S6A_REQUEST_ULR, &handle));
 
   if (handle == NULL) {
     strcpy (why, "cannot register update location req cb");
@@ -255,7 +255,7 @@ s6a_init (
   /*
    * Register the callbacks for S6A Application
    */
-  CHECK_FCT (fd_disp_register (s6a_purge_ue_cb, DISP_HOW_CC, &when, NULL, &handle));
+  CHECK_FCT (fd_disp_register (s6a_workers_dispatch_cb, DISP_HOW_CC, &when, (void *)(intptr_t)S6A_REQUEST_PUR, &handle));
 
   if (handle == NULL) {
     strcpy (why, "cannot register purge ue req cb");
@@ -205,7 +205,39 @@ int s6a_init(hss_config_t *hss_config_p);
  */
 int s6a_peer_validate(struct peer_info *info, int *auth, int (**cb2)(struct peer_info *));
 
-/* Callback called when corresponding request/answer is received */
+/* Requests served by the S6a worker pool, the value is passed as the opaque
+ * argument of the dispatch callback.
+ */
+typedef enum {
+  S6A_REQUEST_AIR = 0,
+  S6A_REQUEST_ULR,
+  S6A_REQUEST_PUR,
+  S6A_REQUEST_MAX
+} s6a_request_type_t;
+
+/** \brief Start the S6a worker threads. Each worker opens its own MySQL
+ * connection and random state before the call returns.
+ * \param hss_config_p pointer the global HSS configuration
+ * @returns 0 if all the workers are ready, != 0 in case of failure
+ */
+int s6a_workers_init(hss_config_t *hss_config_p);
+
+/** \brief freeDiameter dispatch callback: queue the request to the worker
+ * owning its IMSI, or answer DIAMETER_TOO_BUSY if that worker queue is full.
+ * The request type is given through opaque.
+ */
+int s6a_workers_dispatch_cb(struct msg **msg, struct avp *paramavp,
+                            struct session *sess, void *opaque,
+                            enum disp_action *act);
+
+/** \brief Log the request counters and per-stage latencies (queue wait,
+ * processing, total) accumulated since the previous report.
+ */
+void s6a_workers_report(void);
+
+/* Callback called when corresponding request/answer is received, run from
+ * the S6a worker threads.
+ */
 int s6a_auth_info_cb(struct msg **msg, struct avp *paramavp,
                      struct session *sess, void *opaque,
                      enum disp_action *act);
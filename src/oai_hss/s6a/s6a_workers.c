@@ -0,0 +1,443 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file s6a_workers.c
+   \brief S6a worker pool: the freeDiameter dispatch threads only queue the
+   requests, the workers query the database, derive the vectors and send the
+   answers.
+   \details A request is queued to the worker selected by a hash of its IMSI,
+   so all the requests of a subscriber are processed in order by the same
+   thread and the SQN read/update sequence of a subscriber is never run
+   concurrently. Each worker owns a MySQL connection (db_desc is thread local)
+   and its random and Rijndael state, nothing is shared on the request path.
+   \date 2017
+   \version 0.1
+*/
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <freeDiameter/freeDiameter-host.h>
+#include <freeDiameter/libfdcore.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "s6a_proto.h"
+#include "auc.h"
+#include "queue.h"
+#include "log.h"
+
+/* Latency histogram: bucket i counts the samples in [2^(i-1), 2^i[ us */
+#define S6A_WORKERS_LATENCY_BUCKETS (24)
+
+typedef enum {
+  S6A_STAGE_QUEUE = 0,  /* dispatch thread -> worker */
+  S6A_STAGE_PROCESS,    /* database, vectors and answer sending */
+  S6A_STAGE_TOTAL,
+  S6A_STAGE_MAX
+} s6a_stage_t;
+
+typedef struct s6a_latency_s {
+  uint64_t                                count;
+  uint64_t                                sum_us;
+  uint64_t                                buckets[S6A_WORKERS_LATENCY_BUCKETS];
+} s6a_latency_t;
+
+typedef struct s6a_request_stats_s {
+  uint64_t                                rejected;
+  s6a_latency_t                           stages[S6A_STAGE_MAX];
+} s6a_request_stats_t;
+
+typedef struct s6a_work_s {
+  STAILQ_ENTRY (s6a_work_s)               entries;
+  struct msg                             *msg;
+  s6a_request_type_t                      type;
+  uint64_t                                received_us;
+} s6a_work_t;
+
+typedef struct s6a_worker_s {
+  pthread_t                               thread;
+  int                                     index;
+  pthread_mutex_t                         lock;
+  pthread_cond_t                          cond;
+  STAILQ_HEAD (, s6a_work_s)              queue;
+  int                                     queue_depth;
+  /* Written by the worker (rejected by the dispatch threads) with atomic
+   * adds, read by s6a_workers_report().
+   */
+  s6a_request_stats_t                     stats[S6A_REQUEST_MAX];
+} s6a_worker_t;
+
+typedef int (*s6a_request_cb_t) (struct msg **, struct avp *, struct session *, void *, enum disp_action *);
+
+static const struct {
+  const char                             *name;
+  s6a_request_cb_t                        cb;
+} s6a_requests[S6A_REQUEST_MAX] = {
+  [S6A_REQUEST_AIR] = {"AIR", s6a_auth_info_cb},
+  [S6A_REQUEST_ULR] = {"ULR", s6a_up_loc_cb},
+  [S6A_REQUEST_PUR] = {"PUR", s6a_purge_ue_cb},
+};
+
+static const char                      *s6a_stage_names[S6A_STAGE_MAX] = {"queue", "process", "total"};
+
+static s6a_worker_t                    *s6a_workers = NULL;
+static int                              s6a_nb_workers = 0;
+static int                              s6a_worker_queue_size = 0;
+static const hss_config_t              *s6a_workers_config = NULL;
+
+/* Start-up handshake: s6a_workers_init() waits for every worker to connect */
+static pthread_mutex_t                  s6a_workers_start_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   s6a_workers_start_cond = PTHREAD_COND_INITIALIZER;
+static int                              s6a_workers_started = 0;
+static int                              s6a_workers_failed = 0;
+
+/* Previous report, the report shows the increments since then */
+static s6a_request_stats_t              s6a_last_report[S6A_REQUEST_MAX];
+static uint64_t                         s6a_last_report_us = 0;
+
+//------------------------------------------------------------------------------
+static uint64_t
+s6a_workers_now_us (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+static void
+s6a_workers_record (
+  s6a_latency_t * latency,
+  uint64_t us)
+{
+  int                                     bucket = (us == 0) ? 0 : 64 - __builtin_clzll (us);
+
+  if (bucket >= S6A_WORKERS_LATENCY_BUCKETS) {
+    bucket = S6A_WORKERS_LATENCY_BUCKETS - 1;
+  }
+
+  __atomic_add_fetch (&latency->count, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch (&latency->sum_us, us, __ATOMIC_RELAXED);
+  __atomic_add_fetch (&latency->buckets[bucket], 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+/* Hash the User-Name AVP (IMSI), requests without one go to the first worker
+ * which answers DIAMETER_MISSING_AVP.
+ */
+static int
+s6a_workers_select (
+  struct msg *qry)
+{
+  struct avp                             *avp = NULL;
+  struct avp_hdr                         *hdr = NULL;
+  uint32_t                                hash = 2166136261u;
+
+  if ((fd_msg_search_avp (qry, s6a_cnf.dataobj_s6a_imsi, &avp) != 0) || (avp == NULL)) {
+    return 0;
+  }
+
+  if ((fd_msg_avp_hdr (avp, &hdr) != 0) || (hdr->avp_value == NULL)) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < hdr->avp_value->os.len; i++) {
+    hash = (hash ^ hdr->avp_value->os.data[i]) * 16777619u;
+  }
+
+  return hash % s6a_nb_workers;
+}
+
+//------------------------------------------------------------------------------
+static int
+s6a_workers_reject (
+  struct msg **msg)
+{
+  CHECK_FCT (fd_msg_new_answer_from_req (fd_g_config->cnf_dict, msg, 0));
+  CHECK_FCT (s6a_add_result_code (*msg, NULL, ER_DIAMETER_TOO_BUSY, 0));
+  CHECK_FCT (fd_msg_send (msg, NULL, NULL));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void                            *
+s6a_worker_main (
+  void *arg)
+{
+  s6a_worker_t                           *worker = (s6a_worker_t *) arg;
+  s6a_work_t                             *work = NULL;
+  enum disp_action                        action = DISP_ACT_CONT;
+  int                                     ret = 0;
+
+  ret = hss_mysql_connect (s6a_workers_config);
+
+  if (ret == 0) {
+    random_init ();
+  }
+
+  pthread_mutex_lock (&s6a_workers_start_lock);
+  s6a_workers_started++;
+  s6a_workers_failed += (ret != 0);
+  pthread_cond_signal (&s6a_workers_start_cond);
+  pthread_mutex_unlock (&s6a_workers_start_lock);
+
+  if (ret != 0) {
+    FPRINTF_ERROR ("S6a worker %d: cannot connect to the database\n", worker->index);
+    return NULL;
+  }
+
+  while (1) {
+    uint64_t                                start_us,
+                                            end_us;
+    s6a_request_stats_t                    *stats;
+
+    pthread_mutex_lock (&worker->lock);
+
+    while (STAILQ_EMPTY (&worker->queue)) {
+      pthread_cond_wait (&worker->cond, &worker->lock);
+    }
+
+    work = STAILQ_FIRST (&worker->queue);
+    STAILQ_REMOVE_HEAD (&worker->queue, entries);
+    worker->queue_depth--;
+    pthread_mutex_unlock (&worker->lock);
+
+    start_us = s6a_workers_now_us ();
+    ret = s6a_requests[work->type].cb (&work->msg, NULL, NULL, NULL, &action);
+
+    if (ret != 0) {
+      /*
+       * The callback bailed out before sending, drop the request (and the
+       * answer if it was already created).
+       */
+      FPRINTF_ERROR ("S6a worker %d: %s processing failed (%d)\n", worker->index, s6a_requests[work->type].name, ret);
+
+      if (work->msg != NULL) {
+        fd_msg_free (work->msg);
+      }
+    }
+
+    end_us = s6a_workers_now_us ();
+    stats = &worker->stats[work->type];
+    s6a_workers_record (&stats->stages[S6A_STAGE_QUEUE], start_us - work->received_us);
+    s6a_workers_record (&stats->stages[S6A_STAGE_PROCESS], end_us - start_us);
+    s6a_workers_record (&stats->stages[S6A_STAGE_TOTAL], end_us - work->received_us);
+    free (work);
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int
+s6a_workers_init (
+  hss_config_t * hss_config_p)
+{
+  s6a_workers_config = hss_config_p;
+  s6a_nb_workers = hss_config_p->workers;
+  s6a_worker_queue_size = hss_config_p->worker_queue_size;
+  s6a_workers = calloc (s6a_nb_workers, sizeof (s6a_worker_t));
+
+  if (s6a_workers == NULL) {
+    return ENOMEM;
+  }
+
+  FPRINTF_NOTICE ("Starting %d S6a workers (queue size %d)\n", s6a_nb_workers, s6a_worker_queue_size);
+
+  for (int i = 0; i < s6a_nb_workers; i++) {
+    s6a_worker_t                           *worker = &s6a_workers[i];
+
+    worker->index = i;
+    pthread_mutex_init (&worker->lock, NULL);
+    pthread_cond_init (&worker->cond, NULL);
+    STAILQ_INIT (&worker->queue);
+
+    if (pthread_create (&worker->thread, NULL, s6a_worker_main, worker) != 0) {
+      FPRINTF_ERROR ("Cannot create S6a worker %d\n", i);
+      return -1;
+    }
+  }
+
+  pthread_mutex_lock (&s6a_workers_start_lock);
+
+  while (s6a_workers_started < s6a_nb_workers) {
+    pthread_cond_wait (&s6a_workers_start_cond, &s6a_workers_start_lock);
+  }
+
+  pthread_mutex_unlock (&s6a_workers_start_lock);
+
+  if (s6a_workers_failed > 0) {
+    FPRINTF_ERROR ("%d S6a workers failed to start\n", s6a_workers_failed);
+    return -1;
+  }
+
+  s6a_last_report_us = s6a_workers_now_us ();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int
+s6a_workers_dispatch_cb (
+  struct msg **msg,
+  struct avp *paramavp,
+  struct session *sess,
+  void *opaque,
+  enum disp_action *act)
+{
+  s6a_request_type_t                      type = (s6a_request_type_t) (intptr_t) opaque;
+  s6a_worker_t                           *worker = NULL;
+  s6a_work_t                             *work = NULL;
+
+  if ((msg == NULL) || (type >= S6A_REQUEST_MAX)) {
+    return EINVAL;
+  }
+
+  worker = &s6a_workers[s6a_workers_select (*msg)];
+  work = malloc (sizeof (s6a_work_t));
+
+  if (work != NULL) {
+    work->msg = *msg;
+    work->type = type;
+    work->received_us = s6a_workers_now_us ();
+    pthread_mutex_lock (&worker->lock);
+
+    if (worker->queue_depth < s6a_worker_queue_size) {
+      STAILQ_INSERT_TAIL (&worker->queue, work, entries);
+      worker->queue_depth++;
+      pthread_cond_signal (&worker->cond);
+      pthread_mutex_unlock (&worker->lock);
+      /*
+       * The worker owns the request now, freeDiameter must not touch it
+       */
+      *msg = NULL;
+      return 0;
+    }
+
+    pthread_mutex_unlock (&worker->lock);
+    free (work);
+  }
+
+  __atomic_add_fetch (&worker->stats[type].rejected, 1, __ATOMIC_RELAXED);
+  return s6a_workers_reject (msg);
+}
+
+//------------------------------------------------------------------------------
+/* Upper bound (us) of the bucket holding the given percentile */
+static uint64_t
+s6a_workers_percentile (
+  const s6a_latency_t * latency,
+  int percent)
+{
+  uint64_t                                rank = (latency->count * percent + 99) / 100;
+  uint64_t                                seen = 0;
+
+  for (int i = 0; i < S6A_WORKERS_LATENCY_BUCKETS; i++) {
+    seen += latency->buckets[i];
+
+    if ((seen >= rank) && (seen > 0)) {
+      return (uint64_t) 1 << i;
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void
+s6a_workers_report (
+  void)
+{
+  s6a_request_stats_t                     total[S6A_REQUEST_MAX];
+  uint64_t                                now_us = s6a_workers_now_us ();
+  double                                  period_sec = (now_us - s6a_last_report_us) / 1e6;
+  int                                     queued = 0;
+
+  if (s6a_workers == NULL) {
+    return;
+  }
+
+  memset (total, 0, sizeof (total));
+
+  for (int i = 0; i < s6a_nb_workers; i++) {
+    s6a_worker_t                           *worker = &s6a_workers[i];
+
+    queued += __atomic_load_n (&worker->queue_depth, __ATOMIC_RELAXED);
+
+    for (int t = 0; t < S6A_REQUEST_MAX; t++) {
+      total[t].rejected += __atomic_load_n (&worker->stats[t].rejected, __ATOMIC_RELAXED);
+
+      for (int s = 0; s < S6A_STAGE_MAX; s++) {
+        const s6a_latency_t                    *from = &worker->stats[t].stages[s];
+        s6a_latency_t                          *to = &total[t].stages[s];
+
+        to->count += __atomic_load_n (&from->count, __ATOMIC_RELAXED);
+        to->sum_us += __atomic_load_n (&from->sum_us, __ATOMIC_RELAXED);
+
+        for (int b = 0; b < S6A_WORKERS_LATENCY_BUCKETS; b++) {
+          to->buckets[b] += __atomic_load_n (&from->buckets[b], __ATOMIC_RELAXED);
+        }
+      }
+    }
+  }
+
+  FPRINTF_NOTICE ("S6a workers: %d workers, %d requests queued, last %.1f s:\n", s6a_nb_workers, queued, period_sec);
+
+  for (int t = 0; t < S6A_REQUEST_MAX; t++) {
+    s6a_request_stats_t                     delta;
+    char                                    stages[256];
+    int                                     len = 0;
+
+    delta.rejected = total[t].rejected - s6a_last_report[t].rejected;
+
+    for (int s = 0; s < S6A_STAGE_MAX; s++) {
+      s6a_latency_t                          *d = &delta.stages[s];
+
+      d->count = total[t].stages[s].count - s6a_last_report[t].stages[s].count;
+      d->sum_us = total[t].stages[s].sum_us - s6a_last_report[t].stages[s].sum_us;
+
+      for (int b = 0; b < S6A_WORKERS_LATENCY_BUCKETS; b++) {
+        d->buckets[b] = total[t].stages[s].buckets[b] - s6a_last_report[t].stages[s].buckets[b];
+      }
+
+      len += snprintf (stages + len, sizeof (stages) - len, " | %s avg %" PRIu64 " p50 %" PRIu64 " p99 %" PRIu64 " us",
+                       s6a_stage_names[s], (d->count > 0) ? d->sum_us / d->count : 0,
+                       s6a_workers_percentile (d, 50), s6a_workers_percentile (d, 99));
+    }
+
+    FPRINTF_NOTICE ("\t- %s: %" PRIu64 " answered (%.1f/s), %" PRIu64 " too busy%s\n",
+                    s6a_requests[t].name, delta.stages[S6A_STAGE_TOTAL].count,
+                    (period_sec > 0) ? delta.stages[S6A_STAGE_TOTAL].count / period_sec : 0.0, delta.rejected, stages);
+  }
+
+  memcpy (s6a_last_report, total, sizeof (total));
+  s6a_last_report_us = now_us;
+}
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Bulk provisioning throughput: generate a subscriber CSV file, load it into
+ * the HSS database with the bulk loader (OPc computed from OPERATOR_key) and
+ * export it back. Needs the MySQL database of the given HSS configuration,
+ * the users table is modified.
+ *
+ * hss_bulk_provision_benchmark -c hss.conf [-n subscribers] [-t loaders] [-f csv]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+
+#define NB_OF_SUBSCRIBERS (10 * 1000 * 1000)
+
+hss_config_t                            hss_config;
+
+static double now_sec (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int generate (const char *file_name, uint64_t nb_subscribers)
+{
+  FILE                                   *file = fopen (file_name, "w");
+
+  if (file == NULL) {
+    perror (file_name);
+    return -1;
+  }
+
+  for (uint64_t i = 0; i < nb_subscribers; i++) {
+    uint64_t                                k = (i + 1) * 0x9E3779B97F4A7C15ULL;
+
+    /* imsi,key,opc,sqn,rand,msisdn,imei: empty opc, computed by the loader */
+    fprintf (file, "0010%011" PRIu64 ",%016" PRIx64 "%016" PRIx64 ",,%" PRIu64 ",,336%08" PRIu64 ",35609204%07" PRIu64 "\n",
+             i, k, ~k, i % 1024, i % 100000000, i % 10000000);
+  }
+
+  return fclose (file);
+}
+
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_subscribers = NB_OF_SUBSCRIBERS;
+  int                                     nb_loaders = 0;
+  char                                   *config = NULL;
+  char                                    csv[] = "/tmp/hss_bulk_provision_XXXXXX";
+  char                                    export_csv[sizeof (csv) + 7];
+  char                                   *hss_argv[] = {argv[0], "-c", NULL, NULL};
+  hss_bulk_stats_t                        stats;
+  double                                  start;
+  int                                     c;
+  int                                     fd;
+
+  while ((c = getopt (argc, argv, "c:n:t:")) != -1) {
+    switch (c) {
+    case 'c': config = optarg; break;
+    case 'n': nb_subscribers = strtoull (optarg, NULL, 10); break;
+    case 't': nb_loaders = atoi (optarg); break;
+    default:
+      fprintf (stderr, "Usage: %s -c hss.conf [-n subscribers] [-t loaders]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (config == NULL) {
+    fprintf (stderr, "Usage: %s -c hss.conf [-n subscribers] [-t loaders]\n", argv[0]);
+    return 1;
+  }
+
+  hss_argv[2] = config;
+  optind = 1;
+  if ((hss_config_init (3, hss_argv, &hss_config) != 0) || !hss_config.valid_op) {
+    fprintf (stderr, "The configuration needs a valid OPERATOR_key\n");
+    return 1;
+  }
+  if (nb_loaders <= 0) {
+    nb_loaders = hss_config.workers;
+  }
+
+  if (((fd = mkstemp (csv)) < 0) || (close (fd) != 0)) {
+    perror ("mkstemp");
+    return 1;
+  }
+  snprintf (export_csv, sizeof (export_csv), "%s.export", csv);
+
+  start = now_sec ();
+  if (generate (csv, nb_subscribers) != 0) {
+    return 1;
+  }
+  printf ("generate  %" PRIu64 " subscribers in %.1f s\n", nb_subscribers, now_sec () - start);
+
+  if (hss_mysql_bulk_import (&hss_config, csv, (uint8_t *) hss_config.operator_key_bin, nb_loaders, &stats) != 0) {
+    fprintf (stderr, "import failed (%" PRIu64 " batches failed)\n", stats.failed_batches);
+    return 1;
+  }
+  printf ("import    %" PRIu64 " subscribers, %d loaders, %.1f s, %.0f subscribers/s, %" PRIu64 " OPc computed\n",
+          stats.rows, nb_loaders, stats.elapsed_sec, stats.rows / stats.elapsed_sec, stats.opc_computed);
+
+  if (hss_mysql_connect (&hss_config) != 0) {
+    return 1;
+  }
+  if (hss_mysql_bulk_export (export_csv, &stats) != 0) {
+    fprintf (stderr, "export failed\n");
+    return 1;
+  }
+  printf ("export    %" PRIu64 " subscribers, %.1f s, %.0f subscribers/s\n", stats.rows, stats.elapsed_sec, stats.rows / stats.elapsed_sec);
+  hss_mysql_disconnect ();
+
+  unlink (csv);
+  unlink (export_csv);
+  return 0;
+}
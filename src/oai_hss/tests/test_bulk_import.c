@@ -0,0 +1,118 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Re-import of a subscriber whose Update Location set the MME identity: the
+ * row is updated by its IMSI, no second row is inserted. Needs the MySQL
+ * database of the HSS configuration in $HSS_CONFIG (hss.conf by default).
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mysql/mysql.h>
+
+#include "config.h"
+#include "test_utils.h"
+#include "hss_config.h"
+#include "db_proto.h"
+
+#define TEST_IMSI "001019999999999"
+
+hss_config_t                            hss_config;
+
+static void
+do_query (
+  const char *query)
+{
+  if (mysql_query (db_desc->db_conn, query)) {
+    fail ("Fail: %s: %s\n", query, mysql_error (db_desc->db_conn));
+  }
+}
+
+void
+doit (
+  void)
+{
+  char                                    csv[] = "/tmp/test_bulk_import_XXXXXX";
+  char                                   *hss_argv[] = {"test_bulk_import", "-c", getenv ("HSS_CONFIG") ? getenv ("HSS_CONFIG") : "hss.conf", NULL};
+  hss_bulk_stats_t                        stats;
+  MYSQL_RES                              *res = NULL;
+  MYSQL_ROW                               row;
+  FILE                                   *file = NULL;
+  int                                     fd;
+
+  if (hss_config_init (3, hss_argv, &hss_config) != 0) {
+    fail ("Fail: hss_config_init\n");
+  }
+
+  if (hss_mysql_connect (&hss_config) != 0) {
+    fail ("Fail: hss_mysql_connect\n");
+  }
+
+  /*
+   * Subscriber registered by an MME: MME identity 1, SQN and MSISDN in use
+   */
+  do_query ("DELETE FROM `users` WHERE `imsi`='" TEST_IMSI "'");
+  do_query ("INSERT INTO `users` (`imsi`,`mmeidentity_idmmeidentity`,`key`,`OPc`,`sqn`,`rand`,`msisdn`) VALUES ('" TEST_IMSI "',1,"
+            "UNHEX('00000000000000000000000000000000'),UNHEX('00000000000000000000000000000000'),42,"
+            "UNHEX('00000000000000000000000000000000'),'33611111111')");
+
+  /*
+   * Re-import with a new key and OPc, empty sqn, rand and msisdn
+   */
+  if (((fd = mkstemp (csv)) < 0) || ((file = fdopen (fd, "w")) == NULL)) {
+    fail ("Fail: mkstemp\n");
+  }
+
+  fprintf (file, TEST_IMSI ",8baf473f2f8fd09487cccbd7097c6862,e734f8734007d6c5ce7a0508809e7e9c,,,,,,,\n");
+  fclose (file);
+
+  if ((hss_mysql_bulk_import (&hss_config, csv, NULL, 1, &stats) != 0) || (stats.rows != 1) || (stats.failed_batches != 0)) {
+    fail ("Fail: hss_mysql_bulk_import\n");
+  }
+
+  unlink (csv);
+  do_query ("SELECT `mmeidentity_idmmeidentity`,`sqn`,`msisdn`,HEX(`key`),HEX(`OPc`) FROM `users` WHERE `imsi`='" TEST_IMSI "'");
+
+  if ((res = mysql_store_result (db_desc->db_conn)) == NULL) {
+    fail ("Fail: mysql_store_result\n");
+  }
+
+  if (mysql_num_rows (res) != 1) {
+    fail ("Fail: %llu rows for IMSI " TEST_IMSI " after the re-import\n", (unsigned long long)mysql_num_rows (res));
+  }
+
+  row = mysql_fetch_row (res);
+
+  if ((atoi (row[0]) != 1) || (atoll (row[1]) != 42) || (strcmp (row[2], "33611111111") != 0) ||
+      (strcasecmp (row[3], "8baf473f2f8fd09487cccbd7097c6862") != 0) || (strcasecmp (row[4], "e734f8734007d6c5ce7a0508809e7e9c") != 0)) {
+    fail ("Fail: re-imported subscriber mme identity %s sqn %s msisdn %s key %s OPc %s\n", row[0], row[1], row[2], row[3], row[4]);
+  }
+
+  mysql_free_result (res);
+  do_query ("DELETE FROM `users` WHERE `imsi`='" TEST_IMSI "'");
+  hss_mysql_disconnect ();
+  success ("bulk re-import over a registered subscriber ok\n");
+}
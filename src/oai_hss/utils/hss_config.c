@@ -62,6 +62,9 @@
 #define HSS_CONFIG_STRING_OPERATOR_KEY             "OPERATOR_key"
 #define HSS_CONFIG_STRING_RANDOM                   "RANDOM"
 #define HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE   "FD_conf"
+#define HSS_CONFIG_STRING_WORKERS                  "WORKERS"
+#define HSS_CONFIG_STRING_WORKER_QUEUE_SIZE        "WORKER_QUEUE_SIZE"
+#define HSS_CONFIG_STRING_STATS_PERIOD             "STATS_PERIOD"
 
 
 // LG TODO fd_g_debug_lvl
@@ -82,10 +85,12 @@ static struct option                    long_options[] = {
   {"config", 1, 0, 'c'},
   {"help", 0, 0, 'h'},
   {"version", 0, 0, 'v'},
+  {"import", 1, 0, 'i'},
+  {"export", 1, 0, 'e'},
   {0, 0, 0, 0},
 };
 
-static const char                       option_string[] = "c:vh";
+static const char                       option_string[] = "c:vhi:e:";
 
 int
 hss_config_init (
@@ -177,6 +182,12 @@ usage (
   FPRINTF_NOTICE ( "\t\tSee template in conf dir\n\n");
   FPRINTF_NOTICE ( "\t--version\n\t-v\n");
   FPRINTF_NOTICE ( "\t\tPrint %s version and return\n", PACKAGE_NAME);
+  FPRINTF_NOTICE ( "\t--import=<path>\n\t-i<path>\n");
+  FPRINTF_NOTICE ( "\t\tBulk load the subscribers of a CSV file (- for stdin) and return\n");
+  FPRINTF_NOTICE ( "\t\tFormat: imsi,key,opc,sqn,rand,msisdn,imei,ue_ambr_ul,ue_ambr_dl,access_restriction\n");
+  FPRINTF_NOTICE ( "\t\timsi and key are mandatory, an empty opc is computed from OPERATOR_key\n\n");
+  FPRINTF_NOTICE ( "\t--export=<path>\n\t-e<path>\n");
+  FPRINTF_NOTICE ( "\t\tWrite all the subscribers to a CSV file in the import format and return\n");
 }
 
 static void
@@ -196,6 +207,10 @@ hss_config_display (
   FPRINTF_NOTICE ( "* Security:\n");
   FPRINTF_NOTICE ( "\t- Operator key......: %s\n", (hss_config_p->operator_key == NULL) ? "None" : "********************************");
   FPRINTF_NOTICE ( "\t- Random      ......: %s\n", hss_config_p->random);
+  FPRINTF_NOTICE ( "* S6a workers:\n");
+  FPRINTF_NOTICE ( "\t- Workers ..........: %d\n", hss_config_p->workers);
+  FPRINTF_NOTICE ( "\t- Queue size .......: %d\n", hss_config_p->worker_queue_size);
+  FPRINTF_NOTICE ( "\t- Stats period .....: %d s\n", hss_config_p->stats_period_sec);
 }
 
 static int
@@ -214,6 +229,16 @@ hss_config_parse_command_line (
       }
       break;
 
+    case 'i':{
+        hss_config_p->bulk_import_file = strdup (optarg);
+      }
+      break;
+
+    case 'e':{
+        hss_config_p->bulk_export_file = strdup (optarg);
+      }
+      break;
+
     case 'v':{
         /*
          * We display version and return immediately
@@ -246,6 +271,7 @@ hss_config_parse_file (
   int                                     ret = -1;
   config_t                                cfg;
   const char                             *astring = NULL;
+  int                                     aint = 0;
   config_setting_t                       *setting = NULL;
 
   if (hss_config_p == NULL) {
@@ -314,6 +340,33 @@ hss_config_parse_file (
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE);
       return ret;
     }
+
+    /*
+     * Optional S6a worker pool settings
+     */
+    hss_config_p->workers = HSS_CONFIG_DEFAULT_WORKERS;
+    hss_config_p->worker_queue_size = HSS_CONFIG_DEFAULT_WORKER_QUEUE_SIZE;
+    hss_config_p->stats_period_sec = HSS_CONFIG_DEFAULT_STATS_PERIOD_SEC;
+
+    if (  (config_setting_lookup_int( setting, HSS_CONFIG_STRING_WORKERS, &aint) )) {
+      if ((aint < 1) || (aint > HSS_CONFIG_MAX_WORKERS)) {
+        FPRINTF_ERROR( "Error in configuration file: %s: %d (allowed values [1..%d])\n", HSS_CONFIG_STRING_WORKERS, aint, HSS_CONFIG_MAX_WORKERS);
+        return ret;
+      }
+      hss_config_p->workers = aint;
+    }
+
+    if (  (config_setting_lookup_int( setting, HSS_CONFIG_STRING_WORKER_QUEUE_SIZE, &aint) )) {
+      if (aint < 1) {
+        FPRINTF_ERROR( "Error in configuration file: %s: %d (must be > 0)\n", HSS_CONFIG_STRING_WORKER_QUEUE_SIZE, aint);
+        return ret;
+      }
+      hss_config_p->worker_queue_size = aint;
+    }
+
+    if (  (config_setting_lookup_int( setting, HSS_CONFIG_STRING_STATS_PERIOD, &aint) )) {
+      hss_config_p->stats_period_sec = (aint > 0) ? aint : 0;
+    }
   } else {
     FPRINTF_ERROR( "Failed to parse HSS configuration file main HSS section not found!\n");
     return ret;
@@ -41,8 +41,25 @@ typedef struct hss_config_s {
 
   char *random;
   char  random_bool;
+
+  /* S6a worker pool: each worker owns a MySQL connection and its crypto state */
+  int   workers;
+  int   worker_queue_size;
+  /* Period of the S6a worker statistics report, 0 disables it */
+  int   stats_period_sec;
+
+  /* Bulk provisioning (command line only): import or export the subscribers
+   * then exit instead of starting the S6a layer.
+   */
+  char *bulk_import_file;
+  char *bulk_export_file;
 } hss_config_t;
 
+#define HSS_CONFIG_DEFAULT_WORKERS            (4)
+#define HSS_CONFIG_MAX_WORKERS                (64)
+#define HSS_CONFIG_DEFAULT_WORKER_QUEUE_SIZE  (1024)
+#define HSS_CONFIG_DEFAULT_STATS_PERIOD_SEC   (60)
+
 int hss_config_init(int argc, char *argv[], hss_config_t *hss_config_p);
 
 #endif /* HSS_CONFIG_H_ */
@@ -39,14 +39,21 @@
 #include "log.h"
 #include "msc.h"
 #include "mme_config.h"
+#include "mme_config_snapshot.h"
 
 #include "intertask_interface_init.h"
+#include "intertask_interface_trace.h"
+#include "intertask_interface_stats.h"
+#include "signals.h"
 
 #include "sctp_primitives_server.h"
 #include "udp_primitives_server.h"
 #include "s1ap_mme.h"
 #include "timer.h"
 #include "mme_app_extern.h"
+#include "mme_app_shard.h"
+#include "mme_app_statistics.h"
+#include "metrics.h"
 #include "nas_defs.h"
 #include "s11_mme.h"
 
@@ -54,6 +61,7 @@
 #include <freeDiameter/freeDiameter-host.h>
 #include <freeDiameter/libfdcore.h>
 #include "s6a_defs.h"
+#include "s6a_router.h"
 
 #include "oai_mme.h"
 #include "pid_file.h"
@@ -138,6 +146,14 @@ main (
 #endif
           NULL));
   MSC_INIT (MSC_MME, THREAD_MAX + TASK_MAX);
+  CHECK_INIT_RETURN (mme_app_shard_init (mme_config.nb_workers));
+  CHECK_INIT_RETURN (mme_app_statistics_init ());
+  CHECK_INIT_RETURN (itti_trace_init (mme_config.itti_config.trace_sampling, mme_config.itti_config.trace_buffer_size));
+  CHECK_INIT_RETURN (metrics_server_add_handler ("/trace", "application/json", itti_trace_dump_json));
+  itti_stats_set_high_watermark (mme_config.itti_config.high_watermark);
+  CHECK_INIT_RETURN (metrics_register_collector (itti_stats_dump_prometheus));
+  CHECK_INIT_RETURN (metrics_server_add_handler ("/itti", "text/plain", itti_stats_dump_text));
+  CHECK_INIT_RETURN (metrics_server_start (bdata (mme_config.metrics_config.unix_socket), mme_config.metrics_config.port));
   CHECK_INIT_RETURN (nas_init (&mme_config));
   CHECK_INIT_RETURN (sctp_init (&mme_config));
   CHECK_INIT_RETURN (udp_init ());
@@ -145,12 +161,16 @@ main (
   CHECK_INIT_RETURN (s1ap_mme_init());
   CHECK_INIT_RETURN (mme_app_init (&mme_config));
   CHECK_INIT_RETURN (s6a_init (&mme_config));
+  CHECK_INIT_RETURN (metrics_register_collector (s6a_router_dump_prometheus));
 
   OAILOG_DEBUG(LOG_MME_APP, "MME app initialization complete\n");
+  signal_set_reload_handler (mme_config_reload);
   /*
    * Handle signals here
    */
   itti_wait_tasks_end ();
+  metrics_server_stop ();
+  mme_config_snapshot_exit ();
   pid_file_unlock();
   free_wrapper((void**) &pid_file_name);
   return 0;
@@ -53,6 +53,11 @@ s11_imsi_ie_get (
   DevAssert (arg );
   imsi = (Imsi_t *) arg;
 
+  if ((0 == ieLength) || ((2 * ieLength) > sizeof (imsi->digit))) {
+    OAILOG_ERROR (LOG_S11, "Received IMSI IE of %u bytes\n", ieLength);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
   for (i = 0; i < ieLength * 2; i++) {
     if (mask == 0x0F) {
       imsi->digit[i] = (ieValue[i / 2] & (mask));
@@ -123,6 +128,11 @@ s11_msisdn_ie_get (
   DevAssert (arg );
   msisdn = (Msisdn_t *) arg;
 
+  if ((0 == ieLength) || ((2 * ieLength) > sizeof (msisdn->digit))) {
+    OAILOG_ERROR (LOG_S11, "Received MSISDN IE of %u bytes\n", ieLength);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
   for (i = 0; i < ieLength * 2; i++) {
     if (mask == 0x0F) {
       msisdn->digit[i] = (ieValue[i / 2] & (mask));
@@ -507,24 +517,34 @@ s11_bearer_context_to_be_created_ie_get (
   bearer_contexts_to_be_created_t         *bearer_contexts = (bearer_contexts_to_be_created_t *) arg;
   DevAssert (bearer_contexts );
   DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
   bearer_context_to_be_created_t          *bearer_context  = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
+  uint16_t                                read = 0;
   NwRcT                                   rc;
 
+  if (bearer_contexts->num_bearer_context >= MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS) {
+    OAILOG_ERROR (LOG_S11, "Received more than %u bearer contexts\n", MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
   while (ieLength > read) {
     NwGtpv2cIeTlvT                         *ie_p;
 
     ie_p = (NwGtpv2cIeTlvT *) & ieValue[read];
+    if ((read + sizeof (NwGtpv2cIeTlvT) > ieLength) || (read + sizeof (NwGtpv2cIeTlvT) + ntohs (ie_p->l) > ieLength)) {
+      OAILOG_ERROR (LOG_S11, "Received grouped IE %u with a truncated IE\n", ieType);
+      return NW_GTPV2C_IE_INCORRECT;
+    }
 
     switch (ie_p->t) {
     case NW_GTPV2C_IE_EBI:
-      rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
+      rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+      if (NW_OK != rc) {
+        return rc;
+      }
       break;
 
     case NW_GTPV2C_IE_BEARER_LEVEL_QOS:
-      rc = s11_bearer_qos_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->bearer_level_qos);
+      rc = s11_bearer_qos_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->bearer_level_qos);
       break;
 
     case NW_GTPV2C_IE_BEARER_TFT:
@@ -535,29 +555,31 @@ s11_bearer_context_to_be_created_ie_get (
     case NW_GTPV2C_IE_FTEID:
       switch (ie_p->i) {
         case 0:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_enb_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_enb_fteid);
           break;
         case 1:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgsn_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgsn_fteid);
           break;
         case 2:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_sgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_sgw_fteid);
           break;
         case 3:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
           break;
         case 4:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_rnc_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_rnc_fteid);
           break;
         case 5:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s2b_u_epdg_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s2b_u_epdg_fteid);
           break;
         default:
           OAILOG_ERROR (LOG_S11, "Received unexpected IE %u instance %u\n", ie_p->t, ie_p->i);
           return NW_GTPV2C_IE_INCORRECT;
 
       }
-      DevAssert (NW_OK == rc);
+      if (NW_OK != rc) {
+        return rc;
+      }
       break;
 
     default:
@@ -630,39 +652,51 @@ s11_bearer_context_to_be_modified_ie_get (
   bearer_contexts_to_be_modified_t       *bearer_contexts = (bearer_contexts_to_be_modified_t *) arg;
   DevAssert (bearer_contexts);
   DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_MODIFY_BEARER_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
   bearer_context_to_be_modified_t        *bearer_context = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
+  uint16_t                                read = 0;
   NwRcT                                   rc;
 
   DevAssert (bearer_context);
 
+  if (bearer_contexts->num_bearer_context >= MSG_MODIFY_BEARER_REQUEST_MAX_BEARER_CONTEXTS) {
+    OAILOG_ERROR (LOG_S11, "Received more than %u bearer contexts\n", MSG_MODIFY_BEARER_REQUEST_MAX_BEARER_CONTEXTS);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
   while (ieLength > read) {
     NwGtpv2cIeTlvT                         *ie_p;
 
     ie_p = (NwGtpv2cIeTlvT *) & ieValue[read];
+    if ((read + sizeof (NwGtpv2cIeTlvT) > ieLength) || (read + sizeof (NwGtpv2cIeTlvT) + ntohs (ie_p->l) > ieLength)) {
+      OAILOG_ERROR (LOG_S11, "Received grouped IE %u with a truncated IE\n", ieType);
+      return NW_GTPV2C_IE_INCORRECT;
+    }
 
     FTeid_t fteid;
     switch (ie_p->t) {
       case NW_GTPV2C_IE_EBI:
-        rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
-        DevAssert (NW_OK == rc);
+        rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+        if (NW_OK != rc) {
+          return rc;
+        }
         break;
 
       case NW_GTPV2C_IE_FTEID:
-        rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &fteid);
+        rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &fteid);
         switch (fteid.interface_type) {
           case S1_U_ENODEB_GTP_U:
-            rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1_eNB_fteid);
+            rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1_eNB_fteid);
             break;
           case S1_U_SGW_GTP_U:
-            rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
+            rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
             break;
           default:
             OAILOG_WARNING (LOG_S11, "Received unexpected F-TEID type %d\n", fteid.interface_type);
             break;
         }
-        DevAssert (NW_OK == rc);
+        if (NW_OK != rc) {
+          return rc;
+        }
         break;
 
       case NW_GTPV2C_IE_CAUSE:
@@ -690,46 +724,58 @@ s11_bearer_context_created_ie_get (
   bearer_contexts_created_t              *bearer_contexts = (bearer_contexts_created_t *) arg;
   DevAssert (bearer_contexts);
   DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
   bearer_context_created_t               *bearer_context = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
+  uint16_t                                read = 0;
   NwRcT                                   rc;
 
+  if (bearer_contexts->num_bearer_context >= MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS) {
+    OAILOG_ERROR (LOG_S11, "Received more than %u bearer contexts\n", MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
   while (ieLength > read) {
     NwGtpv2cIeTlvT                         *ie_p;
 
     ie_p = (NwGtpv2cIeTlvT *) & ieValue[read];
+    if ((read + sizeof (NwGtpv2cIeTlvT) > ieLength) || (read + sizeof (NwGtpv2cIeTlvT) + ntohs (ie_p->l) > ieLength)) {
+      OAILOG_ERROR (LOG_S11, "Received grouped IE %u with a truncated IE\n", ieType);
+      return NW_GTPV2C_IE_INCORRECT;
+    }
 
     switch (ie_p->t) {
     case NW_GTPV2C_IE_EBI:
-      rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
+      rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+      if (NW_OK != rc) {
+        return rc;
+      }
       break;
 
     case NW_GTPV2C_IE_FTEID:
       switch (ie_p->i) {
         case 0:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
           break;
         case 1:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgw_fteid);
           break;
         case 2:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
           break;
         case 3:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_sgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_sgw_fteid);
           break;
         default:
           OAILOG_ERROR (LOG_S11, "Received unexpected IE %u instance %u\n", ie_p->t, ie_p->i);
           return NW_GTPV2C_IE_INCORRECT;
 
       }
-      DevAssert (NW_OK == rc);
+      if (NW_OK != rc) {
+        return rc;
+      }
       break;
 
     case NW_GTPV2C_IE_CAUSE:
-      rc = s11_cause_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->cause);
+      rc = s11_cause_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->cause);
       break;
 
     default:
@@ -906,8 +952,16 @@ s11_fteid_ie_get (
   FTeid_t                                *fteid = (FTeid_t *) arg;
 
   DevAssert (fteid );
+  if (ieLength < 5) {
+    OAILOG_ERROR (LOG_S11, "Received F-TEID IE of %u bytes\n", ieLength);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
   fteid->ipv4 = (ieValue[0] & 0x80) >> 7;
   fteid->ipv6 = (ieValue[0] & 0x40) >> 6;
+  if (ieLength < 5 + (fteid->ipv4 ? 4 : 0) + (fteid->ipv6 ? 16 : 0)) {
+    OAILOG_ERROR (LOG_S11, "Received F-TEID IE of %u bytes\n", ieLength);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
   fteid->interface_type = ieValue[0] & 0x1F;
   OAILOG_DEBUG (LOG_S11, "\t- F-TEID type %d\n", fteid->interface_type);
   /*
@@ -1078,7 +1132,10 @@ s11_apn_ie_get (
   char                                   *apn = (char *)arg;
 
   DevAssert (apn );
-  DevCheck (ieLength <= APN_MAX_LENGTH, ieLength, APN_MAX_LENGTH, 0);
+  if (ieLength > APN_MAX_LENGTH) {
+    OAILOG_ERROR (LOG_S11, "Received APN IE of %u bytes\n", ieLength);
+    return NW_GTPV2C_IE_INCORRECT;
+  }
   word_length = ieValue[0];
 
   while (read < ieLength) {
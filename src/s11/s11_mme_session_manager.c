@@ -36,6 +36,7 @@
 #include "s11_common.h"
 #include "s11_mme_session_manager.h"
 #include "s11_ie_formatter.h"
+#include "mme_app_shard.h"
 
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
@@ -202,7 +203,7 @@ s11_mme_handle_create_session_response (
 
   MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " num bearer ctxt %u", resp_p->teid,
     resp_p->bearer_contexts_created.num_bearer_context);
-  return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (mme_app_task_of_s11_teid (resp_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -349,5 +350,5 @@ s11_mme_handle_delete_session_response (
 
   DevAssert (HASH_TABLE_OK == hash_rc);
 
-  return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (mme_app_task_of_s11_teid (resp_p->teid), INSTANCE_DEFAULT, message_p);
 }
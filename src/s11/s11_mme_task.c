@@ -95,6 +95,21 @@ s11_mme_ulp_process_stack_req_cb (
 
     break;
 
+  case NW_GTPV2C_ULP_API_INITIAL_REQ_IND:
+    OAILOG_DEBUG (LOG_S11, "Received initial request indication\n");
+
+    switch (pUlpApi->apiInfo.initialReqIndInfo.msgType) {
+    case NW_GTP_DOWNLINK_DATA_NOTIFICATION:
+      ret = s11_mme_handle_downlink_data_notification (&s11_mme_stack_handle, pUlpApi);
+      break;
+
+    default:
+      OAILOG_WARNING (LOG_S11, "Received unhandled message type %d\n", pUlpApi->apiInfo.initialReqIndInfo.msgType);
+      break;
+    }
+
+    break;
+
     // todo: add initial reqs --> CBR / UBR / DBR !
   default:
     break;
@@ -198,6 +213,11 @@ s11_mme_thread (
       }
       break;
 
+    case S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE:{
+        s11_mme_downlink_data_notification_acknowledge (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_downlink_data_notification_acknowledge);
+      }
+      break;
+
     case UDP_DATA_IND:{
         /*
          * We received new data to handle from the UDP layer
@@ -300,12 +320,10 @@ s11_mme_init (
   }
 
   DevAssert (NW_OK == nwGtpv2cSetLogLevel (s11_mme_stack_handle, NW_LOG_LEVEL_DEBG));
-  mme_config_read_lock (&mme_config);
   addr.s_addr = mme_config.ipv4.s11;
   s11_address_str = inet_ntoa (addr);
   DevAssert (s11_address_str );
   s11_send_init_udp (s11_address_str, mme_config.ipv4.port_s11);
-  mme_config_unlock (&mme_config);
 
   bstring b = bfromcstr("s11_mme_teid_2_gtv2c_teid_handle");
   s11_mme_teid_2_gtv2c_teid_handle = hashtable_ts_create(mme_config_p->max_ues, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, b);
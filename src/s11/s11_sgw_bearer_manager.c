@@ -36,6 +36,7 @@
 #include "s11_sgw_bearer_manager.h"
 #include "s11_ie_formatter.h"
 #include "log.h"
+#include "sgw_shard.h"
 
 //------------------------------------------------------------------------------
 int
@@ -139,7 +140,7 @@ s11_sgw_handle_modify_bearer_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_of_s11_teid (request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -260,7 +261,7 @@ s11_sgw_handle_release_access_bearers_request (
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_of_s11_teid (request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
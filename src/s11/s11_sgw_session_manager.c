@@ -36,6 +36,7 @@
 #include "s11_sgw_session_manager.h"
 #include "s11_ie_formatter.h"
 #include "log.h"
+#include "sgw_shard.h"
 
 //------------------------------------------------------------------------------
 int
@@ -225,7 +226,8 @@ s11_sgw_handle_create_session_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_of_create_session_request (create_session_request_p->teid, create_session_request_p->sender_fteid_for_cp.teid),
+                                INSTANCE_DEFAULT, message_p);
 }
 
 ////------------------------------------------------------------------------------
@@ -392,7 +394,7 @@ s11_sgw_handle_delete_session_request (
   DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
-  return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (sgw_task_of_s11_teid (delete_session_request_p->teid), INSTANCE_DEFAULT, message_p);
 }
 
 ////------------------------------------------------------------------------------
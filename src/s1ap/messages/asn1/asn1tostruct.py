@@ -344,6 +344,8 @@ for key in iesDefs:
         f.write("    void *app_key,\n")
         f.write("    %s_message *message_p);\n\n" % (fileprefix))
 
+f.write("/* Size of the string given as app_key to %s_xer__print2sp, the XER dump is truncated to it */\n" % (fileprefix.lower()))
+f.write("#define %s_XER_STRING_SIZE (10000)\n\n" % (fileprefix.upper()))
 f.write("int %s_xer__print2sp(const void *buffer, size_t size, void *app_key);\n\n" % (fileprefix.lower()))
 f.write("int %s_xer__print2fp(const void *buffer, size_t size, void *app_key);\n\n" % (fileprefix.lower()))
 f.write("extern size_t %s_string_total_size;\n\n" % (fileprefix.lower()))
@@ -693,8 +695,11 @@ f.write("""int
 
 f.write("""int %s_xer__print2sp(const void *buffer, size_t size, void *app_key) {
     char *string = (char *)app_key;
+    size_t left = %s_XER_STRING_SIZE - 1 - %s_string_total_size;
 
-    /* Copy buffer to the formatted string */
+    /* Copy buffer to the formatted string, the last byte stays NUL */
+    if (size > left)
+        size = left;
     memcpy(&string[%s_string_total_size], buffer, size);
 
     %s_string_total_size += size;
@@ -702,7 +707,7 @@ f.write("""int %s_xer__print2sp(const void *buffer, size_t size, void *app_key)
     return 0;
 }
 
-""" % (fileprefix.lower(), fileprefix.lower(), fileprefix.lower()))
+""" % (fileprefix.lower(), fileprefix.upper(), fileprefix.lower(), fileprefix.lower(), fileprefix.lower()))
 
 f.write("""static asn_enc_rval_t
 xer_encode_local(asn_TYPE_descriptor_t *td, void *sptr,
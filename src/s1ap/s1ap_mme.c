@@ -37,6 +37,9 @@
 #include "s1ap_mme_handlers.h"
 #include "s1ap_mme_nas_procedures.h"
 #include "s1ap_mme_itti_messaging.h"
+#include "s1ap_mme_overload.h"
+#include "s1ap_mme_paging.h"
+#include "slab_pool.h"
 #include "timer.h"
 
 #if S1AP_DEBUG_LIST
@@ -50,14 +53,18 @@
 
 bool                                    hss_associated = false;
 uint32_t                                nb_enb_associated = 0;
+// initial UE messages dropped because the MME_APP/NAS task of the UE is overloaded
+metric_id_t                             s1ap_initial_ue_shed_metric = METRIC_ID_INVALID;
 
 hash_table_ts_t g_s1ap_enb_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
 hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains sctp association id, key is mme_ue_s1ap_id;
+static slab_pool_t *g_s1ap_ue_pool = NULL; // storage of ue_description_t
 
 static int                              indent = 0;
  void *s1ap_mme_thread (void *args);
 
 static void s1ap_mme_exit(void);
+static void s1ap_free_ue_description (void **ue_ref);
 
 //------------------------------------------------------------------------------
 static int s1ap_send_init_sctp (void)
@@ -201,9 +208,16 @@ s1ap_mme_thread (
       }
       break;
 
+    case S1AP_PAGING_REQUEST:{
+        s1ap_mme_handle_paging_request (&S1AP_PAGING_REQUEST (received_message_p));
+      }
+      break;
+
     case TIMER_HAS_EXPIRED:{
         ue_description_t                       *ue_ref_p = NULL;
-        if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) { 
+        if (s1ap_mme_overload_is_timer (received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          s1ap_mme_overload_evaluate ();
+        } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) { 
           mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
           if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id)) == NULL) {
             OAILOG_WARNING (LOG_S1AP, "Timer expired but no assoicated UE context for UE id %d\n",mme_ue_s1ap_id);
@@ -271,11 +285,28 @@ s1ap_mme_init(void)
   bdestroy(bs2);
   if (!h) return RETURNerror;
 
+  bstring bs3 = bfromcstr("ue_description_t");
+  g_s1ap_ue_pool = slab_pool_create (sizeof (ue_description_t), 0, UE_CONTEXT_POOL_HUGEPAGES, bs3);
+  bdestroy(bs3);
+  if (!g_s1ap_ue_pool) return RETURNerror;
+
+  s1ap_initial_ue_shed_metric = metrics_register_counter ("s1ap_initial_ue_shed_total", "Initial UE messages dropped, MME_APP or NAS task overloaded");
+
   if (itti_create_task (TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP task\n");
     return RETURNerror;
   }
 
+  if (s1ap_mme_overload_init () < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Error while initializing the overload control\n");
+    return RETURNerror;
+  }
+
+  if (s1ap_mme_paging_init () < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Error while initializing the paging\n");
+    return RETURNerror;
+  }
+
   if (s1ap_send_init_sctp () < 0) {
     OAILOG_ERROR (LOG_S1AP, "Error while sendind SCTP_INIT_MSG to SCTP \n");
     return RETURNerror;
@@ -544,12 +575,19 @@ s1ap_new_enb (
   // Update number of eNB associated
   nb_enb_associated++;
   bstring bs = bfromcstr("s1ap_ue_coll");
-  hashtable_ts_init(&enb_ref->ue_coll, mme_config.max_ues, NULL, free_wrapper, bs);
+  hashtable_ts_init(&enb_ref->ue_coll, mme_config.max_ues, NULL, s1ap_free_ue_description, bs);
   bdestroy(bs);
   enb_ref->nb_ue_associated = 0;
   return enb_ref;
 }
 
+//------------------------------------------------------------------------------
+// free function of the eNB ue_coll hash tables
+static void s1ap_free_ue_description (void **ue_ref)
+{
+  slab_pool_free (g_s1ap_ue_pool, ue_ref);
+}
+
 //------------------------------------------------------------------------------
 ue_description_t                       *
 s1ap_new_ue (
@@ -560,7 +598,7 @@ s1ap_new_ue (
 
   enb_ref = s1ap_is_enb_assoc_id_in_list (sctp_assoc_id);
   DevAssert (enb_ref != NULL);
-  ue_ref = calloc (1, sizeof (ue_description_t));
+  ue_ref = slab_pool_alloc (g_s1ap_ue_pool);
   /*
    * Something bad happened during malloc...
    * * * * May be we are running out of memory.
@@ -573,7 +611,7 @@ s1ap_new_ue (
   hashtable_rc_t  hashrc = hashtable_ts_insert (&enb_ref->ue_coll, (const hash_key_t) enb_ue_s1ap_id, (void *)ue_ref);
   if (HASH_TABLE_OK != hashrc) {
     OAILOG_ERROR(LOG_S1AP, "Could not insert UE descr in ue_coll: %s\n", hashtable_rc_code2string(hashrc));
-    free_wrapper((void**) &ue_ref);
+    slab_pool_free (g_s1ap_ue_pool, (void**) &ue_ref);
     return NULL;
   }
   // Increment number of UE
@@ -638,6 +676,7 @@ s1ap_remove_enb (
 {
   if (enb_ref == NULL)
     return;
+  s1ap_mme_paging_remove_enb (enb_ref->sctp_assoc_id);
   hashtable_ts_destroy(&enb_ref->ue_coll);
   hashtable_ts_free (&g_s1ap_enb_coll, enb_ref->sctp_assoc_id);
   nb_enb_associated--;
@@ -651,5 +690,8 @@ s1ap_mme_exit(void) {
   if (hashtable_ts_destroy(&g_s1ap_mme_id2assoc_id_coll) != HASH_TABLE_OK) {
     OAI_FPRINTF_ERR("An error occured while destroying assoc_id hash table");
   }
+  slab_pool_destroy (g_s1ap_ue_pool);
+  g_s1ap_ue_pool = NULL;
+  s1ap_mme_paging_exit ();
 }
 
@@ -26,6 +26,7 @@
 
 #include "mme_config.h"
 #include "hashtable.h"
+#include "metrics.h"
 
 #ifndef FILE_S1AP_MME_SEEN
 #define FILE_S1AP_MME_SEEN
@@ -83,6 +84,7 @@ typedef struct ue_description_s {
 
   s11_teid_t       s11_sgw_teid;
   
+  tai_t            tai;                  ///< TAI of the last S1AP message of the UE carrying one
 
   /* Timer for procedure outcome issued by MME that should be answered */
   long outcome_response_timer_id;
@@ -124,6 +126,7 @@ typedef struct enb_description_s {
 extern bool             hss_associated;
 extern uint32_t         nb_enb_associated;
 extern mme_config_t    *global_mme_config_p;
+extern metric_id_t      s1ap_initial_ue_shed_metric;
 
 /** \brief S1AP layer top init
  * @returns -1 in case of failure
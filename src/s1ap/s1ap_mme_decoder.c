@@ -50,7 +50,7 @@ s1ap_mme_decode_initiating (
   OAILOG_FUNC_IN (LOG_S1AP);
  
   DevAssert (initiating_p != NULL);
-  message_string = calloc (10000, sizeof (char));
+  message_string = calloc (S1AP_XER_STRING_SIZE, sizeof (char));
   s1ap_string_total_size = 0;
   message->procedureCode = initiating_p->procedureCode;
   message->criticality = initiating_p->criticality;
@@ -111,6 +111,7 @@ s1ap_mme_decode_initiating (
         if (ret != -1) {
           ret = free_s1ap_errorindication(&message->msg.s1ap_ErrorIndicationIEs);
         }
+        free_wrapper ((void**) &message_string);
         OAILOG_FUNC_RETURN (LOG_S1AP, ret);
       }
       break;
@@ -124,6 +125,7 @@ s1ap_mme_decode_initiating (
     
     case S1ap_ProcedureCode_id_ENBConfigurationUpdate: {
         OAILOG_ERROR (LOG_S1AP, "eNB Configuration update is received. Ignoring it. Procedure code = %d\n", (int)initiating_p->procedureCode);
+        free_wrapper ((void**) &message_string);
         OAILOG_FUNC_RETURN (LOG_S1AP, ret);
         /*
          * TODO- Add handling for eNB Configuration Update
@@ -134,6 +136,7 @@ s1ap_mme_decode_initiating (
 
     default: {
         OAILOG_ERROR (LOG_S1AP, "Unknown procedure ID (%d) for initiating message\n", (int)initiating_p->procedureCode);
+        free_wrapper ((void**) &message_string);
         OAILOG_FUNC_RETURN (LOG_S1AP, ret);
       }
       break;
@@ -158,7 +161,7 @@ s1ap_mme_decode_successfull_outcome (
   char                                   *message_string = NULL;
   size_t                                  message_string_size = 0;
   DevAssert (successfullOutcome_p != NULL);
-  message_string = calloc (10000, sizeof (char));
+  message_string = calloc (S1AP_XER_STRING_SIZE, sizeof (char));
   s1ap_string_total_size = 0;
   message->procedureCode = successfullOutcome_p->procedureCode;
   message->criticality = successfullOutcome_p->criticality;
@@ -180,6 +183,8 @@ s1ap_mme_decode_successfull_outcome (
 
     default: {
         OAILOG_ERROR (LOG_S1AP, "Unknown procedure ID (%ld) for successfull outcome message\n", successfullOutcome_p->procedureCode);
+        free_wrapper ((void**) &message_string);
+        return ret;
       }
       break;
   }
@@ -203,7 +208,7 @@ s1ap_mme_decode_unsuccessfull_outcome (
   char                                   *message_string = NULL;
   size_t                                  message_string_size = 0;
   DevAssert (unSuccessfulOutcome_p != NULL);
-  message_string = calloc (10000, sizeof (char));
+  message_string = calloc (S1AP_XER_STRING_SIZE, sizeof (char));
   s1ap_string_total_size = 0;
   message->procedureCode = unSuccessfulOutcome_p->procedureCode;
   message->criticality = unSuccessfulOutcome_p->criticality;
@@ -218,6 +223,8 @@ s1ap_mme_decode_unsuccessfull_outcome (
 
     default: {
         OAILOG_ERROR (LOG_S1AP, "Unknown procedure ID (%d) for unsuccessfull outcome message\n", (int)unSuccessfulOutcome_p->procedureCode);
+        free_wrapper ((void**) &message_string);
+        return ret;
       }
       break;
   }
@@ -239,12 +246,14 @@ s1ap_mme_decode_pdu (
   S1AP_PDU_t                              pdu = {(S1AP_PDU_PR_NOTHING)};
   S1AP_PDU_t                             *pdu_p = &pdu;
   asn_dec_rval_t                          dec_ret = {(RC_OK)};
+  int                                     ret = -1;
   DevAssert (raw != NULL);
   memset ((void *)pdu_p, 0, sizeof (S1AP_PDU_t));
   dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, bdata(raw), blength(raw), 0, 0);
 
   if (dec_ret.code != RC_OK) {
     OAILOG_ERROR (LOG_S1AP, "Failed to decode PDU\n");
+    ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, pdu_p);
     return -1;
   }
 
@@ -252,21 +261,28 @@ s1ap_mme_decode_pdu (
 
   switch (pdu_p->present) {
     case S1AP_PDU_PR_initiatingMessage:
-      return s1ap_mme_decode_initiating (message, &pdu_p->choice.initiatingMessage, message_id);
+      ret = s1ap_mme_decode_initiating (message, &pdu_p->choice.initiatingMessage, message_id);
+      break;
 
     case S1AP_PDU_PR_successfulOutcome:
-      return s1ap_mme_decode_successfull_outcome (message, &pdu_p->choice.successfulOutcome, message_id);
+      ret = s1ap_mme_decode_successfull_outcome (message, &pdu_p->choice.successfulOutcome, message_id);
+      break;
 
     case S1AP_PDU_PR_unsuccessfulOutcome:
-      return s1ap_mme_decode_unsuccessfull_outcome (message, &pdu_p->choice.unsuccessfulOutcome, message_id);
+      ret = s1ap_mme_decode_unsuccessfull_outcome (message, &pdu_p->choice.unsuccessfulOutcome, message_id);
+      break;
 
     default:
       OAILOG_ERROR (LOG_S1AP, "Unknown message outcome (%d) or not implemented", (int)pdu_p->present);
       break;
   }
-  ASN_STRUCT_FREE(asn_DEF_S1AP_PDU, pdu_p);
+  /*
+   * The IEs were decoded from the open type value of the PDU to their own
+   * structures, the PDU is on the stack, only its contents are freed
+   */
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, pdu_p);
 
-  return -1;
+  return ret;
 }
 
 int s1ap_free_mme_decode_pdu(
@@ -54,6 +54,18 @@ static inline int                       s1ap_mme_encode_downlink_nas_transport (
   s1ap_message * message_p,
   uint8_t ** buffer,
   uint32_t * length);
+static inline int                       s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+static inline int                       s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+static inline int                       s1ap_mme_encode_paging (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
 
 static inline int                       s1ap_mme_encode_initiating (
   s1ap_message * message_p,
@@ -145,6 +157,15 @@ s1ap_mme_encode_initiating (
   case S1ap_ProcedureCode_id_UEContextRelease:
     return s1ap_mme_encode_ue_context_release_command (message_p, buffer, length);
 
+  case S1ap_ProcedureCode_id_OverloadStart:
+    return s1ap_mme_encode_overload_start (message_p, buffer, length);
+
+  case S1ap_ProcedureCode_id_OverloadStop:
+    return s1ap_mme_encode_overload_stop (message_p, buffer, length);
+
+  case S1ap_ProcedureCode_id_Paging:
+    return s1ap_mme_encode_paging (message_p, buffer, length);
+
   default:
     OAILOG_DEBUG (LOG_S1AP, "Unknown procedure ID (%d) for initiating message_p\n", (int)message_p->procedureCode);
     break;
@@ -337,3 +358,57 @@ s1ap_mme_encode_ue_context_release_command (
 
   return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_UEContextRelease, message_p->criticality, &asn_DEF_S1ap_UEContextReleaseCommand, ueContextReleaseCommand_p);
 }
+
+static inline int
+s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStart_t                    overloadStart;
+  S1ap_OverloadStart_t                   *overloadStart_p = &overloadStart;
+
+  memset (overloadStart_p, 0, sizeof (S1ap_OverloadStart_t));
+
+  if (s1ap_encode_s1ap_overloadstarties (overloadStart_p, &message_p->msg.s1ap_OverloadStartIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStart, S1ap_Criticality_ignore, &asn_DEF_S1ap_OverloadStart, overloadStart_p);
+}
+
+static inline int
+s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStop_t                     overloadStop;
+  S1ap_OverloadStop_t                    *overloadStop_p = &overloadStop;
+
+  memset (overloadStop_p, 0, sizeof (S1ap_OverloadStop_t));
+
+  if (s1ap_encode_s1ap_overloadstopies (overloadStop_p, &message_p->msg.s1ap_OverloadStopIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStop, S1ap_Criticality_reject, &asn_DEF_S1ap_OverloadStop, overloadStop_p);
+}
+
+static inline int
+s1ap_mme_encode_paging (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_Paging_t                           paging;
+  S1ap_Paging_t                          *paging_p = &paging;
+
+  memset (paging_p, 0, sizeof (S1ap_Paging_t));
+
+  if (s1ap_encode_s1ap_pagingies (paging_p, &message_p->msg.s1ap_PagingIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_Paging, S1ap_Criticality_ignore, &asn_DEF_S1ap_Paging, paging_p);
+}
@@ -31,12 +31,15 @@
 #include "assertions.h"
 #include "conversions.h"
 #include "mme_config.h"
+#include "mme_config_snapshot.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_encoder.h"
 #include "s1ap_mme_handlers.h"
 #include "s1ap_mme_nas_procedures.h"
 #include "s1ap_mme_itti_messaging.h"
+#include "s1ap_mme_overload.h"
+#include "s1ap_mme_paging.h"
 #include "s1ap_mme_ta.h"
 #include "mme_app_statistics.h"
 #include "timer.h"
@@ -351,11 +354,11 @@ s1ap_mme_handle_s1_setup_request (
   }
   OAILOG_MESSAGE_FINISH(context);
 
-  mme_config_read_lock (&mme_config);
-  max_enb_connected = mme_config.max_enbs;
-  mme_config_unlock (&mme_config);
+  max_enb_connected = mme_config_snapshot_acquire ()->max_enbs;
+  mme_config_snapshot_release ();
 
-  if (nb_enb_associated == max_enb_connected) {
+  // >= as MAX_ENBS may be reloaded below the number of eNBs already associated
+  if (nb_enb_associated >= max_enb_connected) {
     OAILOG_ERROR (LOG_S1AP, "There is too much eNB connected to MME, rejecting the association\n");
     OAILOG_DEBUG (LOG_S1AP, "Connected = %d, maximum allowed = %d\n", nb_enb_associated, max_enb_connected);
     /*
@@ -401,6 +404,8 @@ s1ap_mme_handle_s1_setup_request (
   rc = s1ap_generate_s1_setup_response(enb_association);
   if (rc == RETURNok) {
     update_mme_app_stats_connected_enb_add();
+    s1ap_mme_overload_new_enb (enb_association->sctp_assoc_id);
+    s1ap_mme_paging_new_enb (enb_association->sctp_assoc_id, &s1SetupRequest_p->supportedTAs);
   }
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
@@ -411,8 +416,9 @@ static
 s1ap_generate_s1_setup_response (
   enb_description_t * enb_association)
 {
-  int                                     i,j;
+  int                                     i = 0;
   int                                     enc_rval = 0;
+  const mme_config_snapshot_t            *snapshot = NULL;
   S1ap_S1SetupResponseIEs_t              *s1_setup_response_p = NULL;
   S1ap_ServedGUMMEIsItem_t               *servedGUMMEI = NULL;
   s1ap_message                            message = { 0 };
@@ -426,47 +432,34 @@ s1ap_generate_s1_setup_response (
   servedGUMMEI = calloc(1, sizeof *servedGUMMEI);
   // Generating response
   s1_setup_response_p = &message.msg.s1ap_S1SetupResponseIEs;
-  mme_config_read_lock (&mme_config);
-  s1_setup_response_p->relativeMMECapacity = mme_config.relative_capacity;
+  snapshot = mme_config_snapshot_acquire ();
+  s1_setup_response_p->relativeMMECapacity = snapshot->relative_capacity;
 
   /*
    * Use the gummei parameters provided by configuration
    * that should be sorted
    */
-  for (i = 0; i < mme_config.served_tai.nb_tai; i++) {
-    bool plmn_added = false;
-    for (j=0; j < i; j++) {
-      if ((mme_config.served_tai.plmn_mcc[j] == mme_config.served_tai.plmn_mcc[i]) &&
-        (mme_config.served_tai.plmn_mnc[j] == mme_config.served_tai.plmn_mnc[i]) &&
-        (mme_config.served_tai.plmn_mnc_len[j] == mme_config.served_tai.plmn_mnc_len[i])
-        ) {
-        plmn_added = true;
-        break;
-      }
-    }
-    if (false == plmn_added) {
-      S1ap_PLMNidentity_t                    *plmn = NULL;
-      plmn = calloc (1, sizeof (*plmn));
-      MCC_MNC_TO_PLMNID (mme_config.served_tai.plmn_mcc[i], mme_config.served_tai.plmn_mnc[i], mme_config.served_tai.plmn_mnc_len[i], plmn);
-      ASN_SEQUENCE_ADD (&servedGUMMEI->servedPLMNs.list, plmn);
-    }
+  for (i = 0; i < snapshot->nb_served_plmns; i++) {
+    S1ap_PLMNidentity_t                    *plmn = NULL;
+
+    plmn = calloc (1, sizeof (*plmn));
+    MCC_MNC_TO_PLMNID (snapshot->served_plmns[i].mcc, snapshot->served_plmns[i].mnc, snapshot->served_plmns[i].mnc_len, plmn);
+    ASN_SEQUENCE_ADD (&servedGUMMEI->servedPLMNs.list, plmn);
   }
 
-  for (i = 0; i < mme_config.gummei.nb; i++) {
+  for (i = 0; i < snapshot->nb_gummei; i++) {
     S1ap_MME_Group_ID_t                    *mme_gid = NULL;
     S1ap_MME_Code_t                        *mmec = NULL;
 
     mme_gid = calloc (1, sizeof (*mme_gid));
-    INT16_TO_OCTET_STRING (mme_config.gummei.gummei[i].mme_gid, mme_gid);
+    INT16_TO_OCTET_STRING (snapshot->gummei[i].mme_gid, mme_gid);
     ASN_SEQUENCE_ADD (&servedGUMMEI->servedGroupIDs.list, mme_gid);
 
     mmec = calloc (1, sizeof (*mmec));
-    INT8_TO_OCTET_STRING (mme_config.gummei.gummei[i].mme_code, mmec);
+    INT8_TO_OCTET_STRING (snapshot->gummei[i].mme_code, mmec);
     ASN_SEQUENCE_ADD (&servedGUMMEI->servedMMECs.list, mmec);
   }
-
-
-  mme_config_unlock (&mme_config);
+  mme_config_snapshot_release ();
   /*
    * The MME is only serving E-UTRAN RAT, so the list contains only one element
    */
@@ -561,7 +554,7 @@ s1ap_mme_handle_ue_cap_indication (
                         MSC_MMEAPP_MME,
                         NULL, 0, "0 S1AP_UE_CAPABILITIES_IND enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " len %u",
                         ue_cap_ind_p->enb_ue_s1ap_id, ue_cap_ind_p->mme_ue_s1ap_id, ue_cap_ind_p->radio_capabilities_length);
-    rc = itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+    rc = itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN (LOG_S1AP, rc);
   }
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
@@ -632,7 +625,7 @@ s1ap_mme_handle_initial_context_setup_response (
                       MME_APP_INITIAL_CONTEXT_SETUP_RSP (message_p).mme_ue_s1ap_id,
                       MME_APP_INITIAL_CONTEXT_SETUP_RSP (message_p).eps_bearer_id,
                       MME_APP_INITIAL_CONTEXT_SETUP_RSP (message_p).bearer_s1u_enb_fteid.teid);
-  rc =  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  rc =  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
 
@@ -721,7 +714,7 @@ s1ap_mme_handle_ue_context_release_request (
       S1AP_UE_CONTEXT_RELEASE_REQ (message_p).enb_id         = ue_ref_p->enb->enb_id;
       MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_REQ mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ",
               S1AP_UE_CONTEXT_RELEASE_REQ (message_p).mme_ue_s1ap_id);
-      rc =  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+      rc =  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN (LOG_S1AP, rc);
     } else {
       // abnormal case. No need to do anything. Ignore the message   
@@ -880,7 +873,7 @@ s1ap_mme_handle_ue_context_release_complete (
   memset ((void *)&message_p->ittiMsg.s1ap_ue_context_release_complete, 0, sizeof (itti_s1ap_ue_context_release_complete_t));
   S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = ue_ref_p->mme_ue_s1ap_id;
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   DevAssert(ue_ref_p->s1_ue_state == S1AP_UE_WAITING_CRR);
   s1ap_remove_ue (ue_ref_p);
   OAILOG_DEBUG (LOG_S1AP, "Removed UE " MME_UE_S1AP_ID_FMT "\n", (uint32_t) ueContextReleaseComplete_p->mme_ue_s1ap_id);
@@ -964,7 +957,7 @@ s1ap_mme_handle_initial_context_setup_failure (
   AssertFatal (message_p != NULL, "itti_alloc_new_message Failed");
   memset ((void *)&message_p->ittiMsg.mme_app_initial_context_setup_failure, 0, sizeof (itti_mme_app_initial_context_setup_failure_t));
   MME_APP_INITIAL_CONTEXT_SETUP_FAILURE (message_p).mme_ue_s1ap_id = ue_ref_p->mme_ue_s1ap_id;
-  rc =  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  rc =  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
 
@@ -985,6 +978,7 @@ s1ap_mme_handle_path_switch_request (
   ue_description_t                       *ue_ref_p = NULL;
   enb_ue_s1ap_id_t                        enb_ue_s1ap_id = 0;
   mme_ue_s1ap_id_t                        mme_ue_s1ap_id = 0;
+  tai_t                                   tai = {.plmn = {0}, .tac = INVALID_TAC_0000};
   MessageDef                             *message_p = NULL;
   int                                     rc = RETURNok;
 
@@ -1121,7 +1115,13 @@ s1ap_mme_handle_path_switch_request (
                           MME_APP_PATH_SWITCH_REQ (message_p).mme_ue_s1ap_id,
                           MME_APP_PATH_SWITCH_REQ (message_p).eps_bearer_id,
                           MME_APP_PATH_SWITCH_REQ (message_p).bearer_s1u_enb_fteid.teid);
-      rc =  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+      rc =  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+
+      // The target eNB may serve another TA
+      OCTET_STRING_TO_TAC (&pathSwitchRequest_p->tai.tAC, tai.tac);
+      DevAssert (pathSwitchRequest_p->tai.pLMNidentity.size == 3);
+      TBCD_TO_PLMN_T(&pathSwitchRequest_p->tai.pLMNidentity, &tai.plmn);
+      s1ap_mme_ue_tai_update (ue_ref_p, &tai);
       OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
   }
 }
@@ -1210,6 +1210,7 @@ static bool s1ap_send_enb_deregistered_ind (
     // max ues reached
     if (arg->current_ue_index == 0 && arg->handled_ues > 0) {
       S1AP_ENB_DEREGISTERED_IND (arg->message_p).nb_ue_to_deregister = S1AP_ITTI_UE_PER_DEREGISTER_MESSAGE;
+      // the first MME_APP task forwards the UEs of the other shards
       itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, arg->message_p);
       MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_NAS_MME, NULL, 0, "0 S1AP_ENB_DEREGISTERED_IND num ue to deregister %u",
           S1AP_ENB_DEREGISTERED_IND (arg->message_p).nb_ue_to_deregister);
@@ -1390,7 +1391,7 @@ s1ap_mme_handle_ue_context_rel_comp_timer_expiry (ue_description_t *ue_ref_p)
   memset ((void *)&message_p->ittiMsg.s1ap_ue_context_release_complete, 0, sizeof (itti_s1ap_ue_context_release_complete_t));
   S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = ue_ref_p->mme_ue_s1ap_id;
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_CONTEXT_RELEASE_COMPLETE mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ", S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id);
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (mme_app_task_of_ue_id (ue_ref_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   DevAssert(ue_ref_p->s1_ue_state == S1AP_UE_WAITING_CRR);
   OAILOG_DEBUG (LOG_S1AP, "Removed S1AP UE " MME_UE_S1AP_ID_FMT "\n", (uint32_t) ue_ref_p->mme_ue_s1ap_id);
   s1ap_remove_ue (ue_ref_p);
@@ -60,7 +60,23 @@ s1ap_mme_itti_nas_uplink_ind (
 
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_NAS_MME, NULL, 0, "0 NAS_UPLINK_DATA_IND ue_id " MME_UE_S1AP_ID_FMT " len %u",
       NAS_UL_DATA_IND (message_p).ue_id, blength(NAS_UL_DATA_IND (message_p).nas_msg));
-  return itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (nas_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_mme_itti_ue_tai_ind (
+  const mme_ue_s1ap_id_t  ue_id,
+  const tai_t      const* tai)
+{
+  MessageDef                             *message_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S1AP, S1AP_UE_TAI_IND);
+  S1AP_UE_TAI_IND (message_p).mme_ue_s1ap_id = ue_id;
+  S1AP_UE_TAI_IND (message_p).tai            = *tai;
+  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_MMEAPP_MME, NULL, 0, "0 S1AP_UE_TAI_IND ue_id " MME_UE_S1AP_ID_FMT " tac %u",
+      ue_id, tai->tac);
+  return itti_send_msg_to_task (mme_app_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
@@ -88,5 +104,5 @@ s1ap_mme_itti_nas_downlink_cnf (
   }
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_NAS_MME, NULL, 0, "0 NAS_DOWNLINK_DATA_CNF ue_id " MME_UE_S1AP_ID_FMT " err_code %u",
       NAS_DL_DATA_CNF (message_p).ue_id, NAS_DL_DATA_CNF (message_p).err_code);
-  return itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  return itti_send_msg_to_task (nas_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
 }
@@ -31,6 +31,7 @@
 #include "intertask_interface.h"
 #include "common_types.h"
 #include "s1ap_common.h"
+#include "mme_app_shard.h"
 
 #ifndef FILE_S1AP_MME_ITTI_MESSAGING_SEEN
 #define FILE_S1AP_MME_ITTI_MESSAGING_SEEN
@@ -47,6 +48,8 @@ int s1ap_mme_itti_nas_uplink_ind(const mme_ue_s1ap_id_t ue_id,
 
 int s1ap_mme_itti_nas_downlink_cnf (const mme_ue_s1ap_id_t ue_id, const bool is_success);
 
+int s1ap_mme_itti_ue_tai_ind (const mme_ue_s1ap_id_t ue_id, const tai_t const* tai);
+
 
 static inline void s1ap_mme_itti_mme_app_initial_ue_message(
   const sctp_assoc_id_t   assoc_id,
@@ -119,7 +122,8 @@ static inline void s1ap_mme_itti_mme_app_initial_ue_message(
         (9 < MME_APP_INITIAL_UE_MESSAGE(message_p).tai.plmn.mnc_digit3) ? ' ': (char)(MME_APP_INITIAL_UE_MESSAGE(message_p).tai.plmn.mnc_digit3 + 0x30),
         MME_APP_INITIAL_UE_MESSAGE(message_p).tai.tac,
         MME_APP_INITIAL_UE_MESSAGE(message_p).nas->slen);
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task((INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) ? mme_app_task_of_ue_id (mme_ue_s1ap_id) :
+      mme_app_task_of_initial_ue (opt_s_tmsi, enb_id, enb_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
@@ -196,7 +200,8 @@ static inline void s1ap_mme_itti_mme_app_initial_ue_check_duplicate_message(
         (char)(MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE(message_p).tai.plmn.mnc_digit2 + 0x30),
         (9 < MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE(message_p).tai.plmn.mnc_digit3) ? ' ': (char)(MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE(message_p).tai.plmn.mnc_digit3 + 0x30),
             MME_APP_INITIAL_UE_MESSAGE_CHECK_DUPLICATE(message_p).tai.tac);
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task((INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) ? mme_app_task_of_ue_id (mme_ue_s1ap_id) :
+      mme_app_task_of_initial_ue (opt_s_tmsi, enb_id, new_enb_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
@@ -238,7 +243,7 @@ static inline void s1ap_mme_itti_nas_establish_ind(
 
   // should be sent to MME_APP, but this one would forward it to NAS_MME, so send it directly to NAS_MME
   // but let's see
-  itti_send_msg_to_task(TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(nas_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 #endif
@@ -266,7 +271,7 @@ static inline void s1ap_mme_itti_nas_non_delivery_ind(
 
   // should be sent to MME_APP, but this one would forward it to NAS_MME, so send it directly to NAS_MME
   // but let's see
-  itti_send_msg_to_task(TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task(nas_task_of_ue_id (ue_id), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
@@ -30,14 +30,19 @@
 #include "msc.h"
 #include "conversions.h"
 #include "intertask_interface.h"
+#include "intertask_interface_trace.h"
 #include "asn1_conversions.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_encoder.h"
 #include "s1ap_mme_itti_messaging.h"
 #include "s1ap_mme.h"
+#include "s1ap_mme_overload.h"
 #include "dynamic_memory_check.h"
 #include "mme_app_messages_types.h"
+#include "mme_app_shard.h"
+#include "nas_buffer.h"
+#include "metrics.h"
 
 /* Every time a new UE is associated, increment this variable.
    But care if it wraps to increment also the mme_ue_s1ap_id_has_wrapped
@@ -85,6 +90,7 @@ static int s1ap_mme_process_new_initial_ue_message(
    ue_ref->enb_ue_s1ap_id = enb_ue_s1ap_id;
    // Will be allocated by NAS
    ue_ref->mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+   ue_ref->tai = *tai;
 
    OAILOG_DEBUG(LOG_S1AP, "UE_DESCRIPTION REFERENCE @ NEW INITIAL UE MESSAGE %x \n", ue_ref);
    OAILOG_DEBUG(LOG_S1AP, "UE_DESCRIPTION REFERENCE @ NEW INITIAL UE MESSAGE %p \n", ue_ref);
@@ -210,6 +216,34 @@ s1ap_mme_handle_initial_ue_message (
   if (ue_ref == NULL) {
     as_stmsi_t                              s_tmsi = {.mme_code = 0, .m_tmsi = INVALID_M_TMSI};
 
+    /*
+     * Apply the overload action sent to the eNBs in OVERLOAD START to the
+     * messages still received.
+     */
+    if (s1ap_mme_overload_reject_initial_ue (initialUEMessage_p->rrC_Establishment_Cause)) {
+      OAILOG_DEBUG (LOG_S1AP, "S1AP:Initial UE Message- MME overloaded, rejecting RRC establishment cause %ld, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n",
+          initialUEMessage_p->rrC_Establishment_Cause, enb_ue_s1ap_id);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+    }
+
+    if (initialUEMessage_p->presenceMask & S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT) {
+      OCTET_STRING_TO_MME_CODE(&initialUEMessage_p->s_tmsi.mMEC, s_tmsi.mme_code);
+      OCTET_STRING_TO_M_TMSI(&initialUEMessage_p->s_tmsi.m_TMSI, s_tmsi.m_tmsi);
+    }
+    /*
+     * Shed the new UEs while the tasks which would handle them are overloaded,
+     * so that the UEs already in a procedure are served. Without an answer the
+     * UE retries the RRC connection establishment later.
+     */
+    if (mme_app_shard_overloaded (mme_app_shard_of_initial_ue (&s_tmsi, eNB_ref->enb_id, enb_ue_s1ap_id))) {
+      OAILOG_WARNING (LOG_S1AP, "S1AP:Initial UE Message- MME overloaded, dropping the message, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      metrics_counter_add (s1ap_initial_ue_shed_metric, 1);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+    }
+
+    // the messages sent for this UE up to the end of the procedure are traced (if sampled)
+    itti_trace_start ("initial_ue", ((uint64_t)eNB_ref->enb_id << 24) | enb_ue_s1ap_id);
+
 //    OCTET_STRING_TO_TAC (&initialUEMessage_p->tai.tAC, tai.tac);
 //    DevAssert (initialUEMessage_p->tai.pLMNidentity.size == 3);
 //    TBCD_TO_PLMN_T(&initialUEMessage_p->tai.pLMNidentity, &tai.plmn);
@@ -217,9 +251,6 @@ s1ap_mme_handle_initial_ue_message (
     bstring nas = blk2bstr(initialUEMessage_p->nas_pdu.buf, initialUEMessage_p->nas_pdu.size);
 
     if (initialUEMessage_p->presenceMask & S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT) {
-      OCTET_STRING_TO_MME_CODE(&initialUEMessage_p->s_tmsi.mMEC, s_tmsi.mme_code);
-      OCTET_STRING_TO_M_TMSI(&initialUEMessage_p->s_tmsi.m_TMSI, s_tmsi.m_tmsi);
-
       OAILOG_DEBUG (LOG_S1AP, "INITIAL UE Message: Received mmeCode %u and S-TMSI %u from eNB. Not creating new S1AP UE description yet. "
           "Checking for duplicates. Will continue after checking for duplicates is complete. \n", initialUEMessage_p->s_tmsi.mMEC, initialUEMessage_p->s_tmsi.m_TMSI);
       enb_description_t *enb_ref = s1ap_is_enb_assoc_id_in_list (assoc_id);
@@ -312,6 +343,22 @@ s1ap_mme_handle_initial_ue_message_duplicate_cnf (
       initial_ue_message_duplicate_cnf_p->new_enb_ue_s1ap_id);
 }
 
+//------------------------------------------------------------------------------
+void
+s1ap_mme_ue_tai_update (
+  struct ue_description_s * const ue_ref,
+  const tai_t      const* tai)
+{
+  if (TAIS_ARE_EQUAL (ue_ref->tai, *tai)) {
+    return;
+  }
+  ue_ref->tai = *tai;
+  // else MME_APP takes the TAI of the INITIAL UE MESSAGE
+  if (INVALID_MME_UE_S1AP_ID != ue_ref->mme_ue_s1ap_id) {
+    s1ap_mme_itti_ue_tai_ind (ue_ref->mme_ue_s1ap_id, tai);
+  }
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_uplink_nas_transport (
@@ -387,6 +434,9 @@ s1ap_mme_handle_uplink_nas_transport (
                       (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID,
                       uplinkNASTransport_p->nas_pdu.size);
 
+  // a TAU REQUEST of a connected UE, or any NAS message after a handover
+  s1ap_mme_ue_tai_update (ue_ref, &tai);
+
   bstring b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
   s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
                                 &b,
@@ -470,6 +520,7 @@ s1ap_generate_downlink_nas_transport (
       ue_ref = s1ap_is_ue_enb_id_in_list (enb_ref,enb_ue_s1ap_id);
     } else {
       OAILOG_ERROR (LOG_S1AP, "No eNB for SCTP association id %d \n", sctp_assoc_id);
+      nas_buffer_free (payload);
       OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
     }
   }
@@ -484,6 +535,7 @@ s1ap_generate_downlink_nas_transport (
      * * * * the MME shall allocate a unique MME UE S1AP ID to be used for the UE.
      */
     OAILOG_WARNING (LOG_S1AP, "Unknown UE MME ID " MME_UE_S1AP_ID_FMT ", This case is not handled right now\n", ue_id);
+    nas_buffer_free (payload);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   } else {
     /*
@@ -503,13 +555,15 @@ s1ap_generate_downlink_nas_transport (
     downlinkNasTransport->mme_ue_s1ap_id = ue_ref->mme_ue_s1ap_id;
     downlinkNasTransport->eNB_UE_S1AP_ID = ue_ref->enb_ue_s1ap_id;
     /*eNB
-     * Fill in the NAS pdu
+     * Fill in the NAS pdu, encoded straight from the NAS buffer
      */
-    OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
-    bdestroy(*payload);
-    *payload = NULL;
+    downlinkNasTransport->nas_pdu.buf = bdata(*payload);
+    downlinkNasTransport->nas_pdu.size = blength(*payload);
+
+    int rc = s1ap_mme_encode_pdu (&message, &buffer_p, &length);
 
-    if (s1ap_mme_encode_pdu (&message, &buffer_p, &length) < 0) {
+    nas_buffer_free (payload);
+    if (rc < 0) {
       // TODO: handle something
       OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
     }
@@ -566,6 +620,8 @@ s1ap_handle_conn_est_cnf (
     }else{
       OAILOG_ERROR (LOG_S1AP, "Not creating a new ue reference for mme ue s1ap id (" MME_UE_S1AP_ID_FMT ").\n",conn_est_cnf_pP->nas_conn_est_cnf.ue_id);
       // There are some race conditions were NAS T3450 timer is stopped and removed at same time
+      nas_buffer_free ((bstring *)&conn_est_cnf_pP->nas_conn_est_cnf.nas_msg);
+      free_wrapper ((void**) &(conn_est_cnf_pP->ue_radio_capabilities));
       OAILOG_FUNC_OUT (LOG_S1AP);
     }
   }
@@ -704,7 +760,7 @@ s1ap_handle_conn_est_cnf (
   }
 
   if (conn_est_cnf_pP->nas_conn_est_cnf.nas_msg != NULL) {
-    bdestroy (conn_est_cnf_pP->nas_conn_est_cnf.nas_msg);
+    nas_buffer_free ((bstring *)&conn_est_cnf_pP->nas_conn_est_cnf.nas_msg);
   }
   OAILOG_NOTICE (LOG_S1AP, "Send S1AP_INITIAL_CONTEXT_SETUP_REQUEST message MME_UE_S1AP_ID = " MME_UE_S1AP_ID_FMT " eNB_UE_S1AP_ID = " ENB_UE_S1AP_ID_FMT "\n",
               (mme_ue_s1ap_id_t)initialContextSetupRequest_p->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)initialContextSetupRequest_p->eNB_UE_S1AP_ID);
@@ -48,6 +48,15 @@ int
 s1ap_mme_handle_initial_ue_message_duplicate_cnf (
     const itti_mme_app_s1ap_initial_ue_message_duplicate_cnf_t * const initial_ue_message_duplicate_cnf_p);
 
+/** \brief Record the TAI of an S1AP message of the UE.
+ * MME_APP is told when it differs from the previous one, the paging of the UE
+ * then starts in this TA.
+ * \param ue_ref The S1AP UE description
+ * \param tai The TAI IE of the message
+ **/
+void s1ap_mme_ue_tai_update(struct ue_description_s * const ue_ref,
+                            const tai_t const* tai);
+
 /** \brief Handle an Uplink NAS transport message.
  * Process the RRC transparent container and forward it to NAS entity.
  * \param assocId lower layer assoc id (SCTP)
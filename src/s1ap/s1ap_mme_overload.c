@@ -0,0 +1,262 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_overload.c
+  \brief Overload control of the MME: S1AP OVERLOAD START/STOP and rejection
+  of the initial UE messages driven by the load of the MME.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "assertions.h"
+#include "log.h"
+#include "msc.h"
+#include "metrics.h"
+#include "intertask_interface.h"
+#include "intertask_interface_stats.h"
+#include "timer.h"
+#include "mme_config.h"
+#include "mme_app_shard.h"
+#include "mme_app_statistics.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme_itti_messaging.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_overload.h"
+
+extern hash_table_ts_t g_s1ap_enb_coll; // contains eNB_description_s, key is eNB_description_s.assoc_id
+
+static const long                       s1ap_overload_actions[S1AP_OVERLOAD_LEVEL_MAX] = {
+  -1,
+  S1ap_OverloadAction_reject_delay_tolerant_access,
+  S1ap_OverloadAction_reject_non_emergency_mo_dt,
+  S1ap_OverloadAction_permit_high_priority_sessions_and_mobile_terminated_services_only,
+  S1ap_OverloadAction_permit_emergency_sessions_and_mobile_terminated_services_only,
+};
+
+/*
+ * Only the S1AP task evaluates the load and reads the level, the thresholds
+ * are copied from the configuration at init.
+ */
+static struct {
+  long                                    timer_id;
+  s1ap_overload_level_t                   level;
+  uint32_t                                queue_depth;
+  uint32_t                                s6a_outstanding;
+  uint32_t                                cpu_percent;
+  long                                    nb_cpus;
+  uint64_t                                last_wall_ns;
+  uint64_t                                last_cpu_ns;
+  metric_id_t                             level_metric;
+  metric_id_t                             load_metric;
+  metric_id_t                             rejected_metric;
+} s1ap_overload = {
+  .timer_id = 0,
+  .level = S1AP_OVERLOAD_NONE,
+  .level_metric = METRIC_ID_INVALID,
+  .load_metric = METRIC_ID_INVALID,
+  .rejected_metric = METRIC_ID_INVALID,
+};
+
+//------------------------------------------------------------------------------
+static uint64_t s1ap_mme_overload_cpu_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_overload_init (void)
+{
+  uint32_t                                period_ms = 0;
+
+  period_ms = mme_config.overload_config.period_ms;
+  s1ap_overload.queue_depth = mme_config.overload_config.queue_depth;
+  s1ap_overload.s6a_outstanding = mme_config.overload_config.s6a_outstanding;
+  s1ap_overload.cpu_percent = mme_config.overload_config.cpu_percent;
+
+  s1ap_overload.level_metric = metrics_register_gauge ("s1ap_overload_level", "Overload level of the MME, 0 if not overloaded");
+  s1ap_overload.load_metric = metrics_register_gauge ("s1ap_overload_load_percent", "Load of the MME in percent of the overload thresholds");
+  s1ap_overload.rejected_metric = metrics_register_counter ("s1ap_overload_rejected_total", "Initial UE messages rejected by the overload control");
+  if (0 == period_ms) {
+    return RETURNok;
+  }
+  s1ap_overload.nb_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  if (s1ap_overload.nb_cpus < 1) {
+    s1ap_overload.nb_cpus = 1;
+  }
+  s1ap_overload.last_wall_ns = metrics_now_ns ();
+  s1ap_overload.last_cpu_ns = s1ap_mme_overload_cpu_ns ();
+  if (timer_setup (period_ms / 1000, (period_ms % 1000) * 1000, TASK_S1AP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &s1ap_overload.timer_id) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to request new timer for the overload control with %u ms of periodicity\n", period_ms);
+    s1ap_overload.timer_id = 0;
+    return RETURNerror;
+  }
+  OAILOG_INFO (LOG_S1AP, "Overload control every %u ms, thresholds: queue depth %u, S6A outstanding %u, CPU %u%%\n",
+      period_ms, s1ap_overload.queue_depth, s1ap_overload.s6a_outstanding, s1ap_overload.cpu_percent);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_mme_overload_is_timer (const long timer_id)
+{
+  return (0 != s1ap_overload.timer_id) && (timer_id == s1ap_overload.timer_id);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t s1ap_mme_overload_load (void)
+{
+  int64_t                                 depth = itti_task_queue_depth (TASK_S1AP);
+  int64_t                                 outstanding = 0;
+  uint32_t                                load = 0;
+  uint32_t                                value = 0;
+  uint64_t                                now_ns = metrics_now_ns ();
+  uint64_t                                cpu_ns = s1ap_mme_overload_cpu_ns ();
+
+  if (s1ap_overload.queue_depth) {
+    for (int shard = 0; shard < mme_app_nb_workers; shard++) {
+      int64_t                                 shard_depth = itti_task_queue_depth (mme_app_shard_tasks[shard]);
+
+      if (shard_depth > depth) depth = shard_depth;
+      shard_depth = itti_task_queue_depth (nas_shard_tasks[shard]);
+      if (shard_depth > depth) depth = shard_depth;
+    }
+    if (depth > 0) {
+      value = (uint32_t)((depth * 100) / s1ap_overload.queue_depth);
+      if (value > load) load = value;
+    }
+  }
+  if (s1ap_overload.s6a_outstanding) {
+    outstanding = mme_app_stats_s6a_outstanding ();
+    if (outstanding > 0) {
+      value = (uint32_t)((outstanding * 100) / s1ap_overload.s6a_outstanding);
+      if (value > load) load = value;
+    }
+  }
+  if ((s1ap_overload.cpu_percent) && (now_ns > s1ap_overload.last_wall_ns)) {
+    // CPU time of the process over the time elapsed on all the CPUs, in percent of the threshold
+    value = (uint32_t)(((cpu_ns - s1ap_overload.last_cpu_ns) * 10000) /
+        ((now_ns - s1ap_overload.last_wall_ns) * s1ap_overload.nb_cpus * s1ap_overload.cpu_percent));
+    if (value > load) load = value;
+  }
+  s1ap_overload.last_wall_ns = now_ns;
+  s1ap_overload.last_cpu_ns = cpu_ns;
+  return load;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_mme_generate_overload (const sctp_assoc_id_t assoc_id, const s1ap_overload_level_t level)
+{
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = 0;
+  s1ap_message                            message = { 0 };
+
+  OAILOG_FUNC_IN (LOG_S1AP);
+  if (S1AP_OVERLOAD_NONE == level) {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStop;
+  } else {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStart;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.present = S1ap_OverloadResponse_PR_overloadAction;
+    message.msg.s1ap_OverloadStartIEs.overloadResponse.choice.overloadAction = s1ap_overload_actions[level];
+  }
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  if (s1ap_mme_encode_pdu (&message, &buffer_p, &length) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to encode overload %s\n", (S1AP_OVERLOAD_NONE == level) ? "stop" : "start");
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
+
+  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_S1AP_ENB, NULL, 0, "0 Overload%s assoc_id %u level %u", (S1AP_OVERLOAD_NONE == level) ? "Stop" : "Start", assoc_id, level);
+  /*
+   * Non-UE signalling -> stream 0
+   */
+  bstring b = blk2bstr(buffer_p, length);
+  free(buffer_p);
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_itti_send_sctp_request (&b, assoc_id, 0, INVALID_MME_UE_S1AP_ID));
+}
+
+//------------------------------------------------------------------------------
+static bool s1ap_mme_overload_notify_enb_cb (__attribute__((unused)) const hash_key_t keyP,
+               void * const eNB_void,
+               void __attribute__((unused)) *unused_parameterP,
+               void __attribute__((unused)) **unused_resultP)
+{
+  const enb_description_t * const enb_ref = (const enb_description_t *)eNB_void;
+
+  if ((enb_ref) && (S1AP_READY == enb_ref->s1_state)) {
+    s1ap_mme_generate_overload (enb_ref->sctp_assoc_id, s1ap_overload.level);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_overload_evaluate (void)
+{
+  const uint32_t                          load = s1ap_mme_overload_load ();
+  const s1ap_overload_level_t             level = s1ap_mme_overload_next_level (s1ap_overload.level, load);
+
+  metrics_gauge_set (s1ap_overload.load_metric, load);
+  if (level == s1ap_overload.level) {
+    return;
+  }
+  if (S1AP_OVERLOAD_NONE == level) {
+    OAILOG_WARNING (LOG_S1AP, "MME no longer overloaded (load %u%%), sending OVERLOAD STOP\n", load);
+  } else {
+    OAILOG_WARNING (LOG_S1AP, "MME overload level %d (load %u%%), sending OVERLOAD START\n", level, load);
+  }
+  metrics_gauge_set (s1ap_overload.level_metric, level);
+  s1ap_overload.level = level;
+  hashtable_ts_apply_callback_on_elements (&g_s1ap_enb_coll, s1ap_mme_overload_notify_enb_cb, NULL, NULL);
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_overload_new_enb (const sctp_assoc_id_t assoc_id)
+{
+  if (S1AP_OVERLOAD_NONE != s1ap_overload.level) {
+    s1ap_mme_generate_overload (assoc_id, s1ap_overload.level);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The eNBs apply the overload action once they received OVERLOAD START, the
+ * initial UE messages already on their way, or sent by eNBs not supporting
+ * the procedure, are rejected by the MME. There is no S1AP answer to an
+ * initial UE message without UE context, it is dropped and the UE will retry.
+ */
+bool s1ap_mme_overload_reject_initial_ue (const long rrc_cause)
+{
+  // as in the MME_APP initial UE message, the AS causes are the RRC causes + 1
+  if (s1ap_mme_overload_admit (s1ap_overload.level, (as_cause_t)(rrc_cause + 1))) {
+    return false;
+  }
+  metrics_counter_add (s1ap_overload.rejected_metric, 1);
+  return true;
+}
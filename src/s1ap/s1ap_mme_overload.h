@@ -0,0 +1,107 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_overload.h
+  \brief Overload control of the MME: S1AP OVERLOAD START/STOP and rejection
+  of the initial UE messages driven by the load of the MME.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_S1AP_MME_OVERLOAD_SEEN
+#define FILE_S1AP_MME_OVERLOAD_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+#include "as_message.h"
+
+/*
+ * The load of the MME is the highest of its queue depth, outstanding S6A
+ * requests and CPU loads, in percent of their threshold. Every level has a
+ * load threshold and an overload action (TS 36.413 9.2.3.20), sent to the
+ * eNBs in OVERLOAD START and applied by the MME to the initial UE messages
+ * still received. The level rises as soon as the load reaches the threshold
+ * of a higher level and falls one level at a time, when the load is below
+ * S1AP_OVERLOAD_HYSTERESIS_PERCENT of the threshold of the current level.
+ */
+typedef enum {
+  S1AP_OVERLOAD_NONE = 0,
+  S1AP_OVERLOAD_REJECT_DELAY_TOLERANT,      // reject-delay-tolerant-access
+  S1AP_OVERLOAD_REJECT_MO_DATA,             // reject-non-emergency-mo-dt
+  S1AP_OVERLOAD_PERMIT_HIGH_PRIORITY_MT,    // permit-high-priority-sessions-and-mobile-terminated-services-only
+  S1AP_OVERLOAD_PERMIT_EMERGENCY_MT,        // permit-emergency-sessions-and-mobile-terminated-services-only
+  S1AP_OVERLOAD_LEVEL_MAX
+} s1ap_overload_level_t;
+
+#define S1AP_OVERLOAD_HYSTERESIS_PERCENT  80
+
+static const uint32_t                   s1ap_overload_thresholds[S1AP_OVERLOAD_LEVEL_MAX] = {0, 100, 125, 150, 250};
+
+//------------------------------------------------------------------------------
+static inline s1ap_overload_level_t s1ap_mme_overload_next_level (const s1ap_overload_level_t level, const uint32_t load_percent)
+{
+  s1ap_overload_level_t                   next = S1AP_OVERLOAD_NONE;
+
+  while ((next + 1 < S1AP_OVERLOAD_LEVEL_MAX) && (load_percent >= s1ap_overload_thresholds[next + 1])) {
+    next++;
+  }
+  if (next >= level) {
+    return next;
+  }
+  if (load_percent * 100 < s1ap_overload_thresholds[level] * S1AP_OVERLOAD_HYSTERESIS_PERCENT) {
+    return level - 1;
+  }
+  return level;
+}
+
+//------------------------------------------------------------------------------
+// Whether an initial UE message with this RRC establishment cause is accepted at this level
+static inline bool s1ap_mme_overload_admit (const s1ap_overload_level_t level, const as_cause_t cause)
+{
+  switch (level) {
+  case S1AP_OVERLOAD_NONE:
+    return true;
+  case S1AP_OVERLOAD_REJECT_DELAY_TOLERANT:
+    return AS_CAUSE_V1020 != cause;
+  case S1AP_OVERLOAD_REJECT_MO_DATA:
+    return (AS_CAUSE_V1020 != cause) && (AS_CAUSE_MO_DATA != cause);
+  case S1AP_OVERLOAD_PERMIT_HIGH_PRIORITY_MT:
+    return (AS_CAUSE_EMERGENCY == cause) || (AS_CAUSE_HIGH_PRIO == cause) || (AS_CAUSE_MT_ACCESS == cause);
+  default:
+    return (AS_CAUSE_EMERGENCY == cause) || (AS_CAUSE_MT_ACCESS == cause);
+  }
+}
+
+int  s1ap_mme_overload_init (void);
+
+// Periodic evaluation of the load, on the S1AP task
+bool s1ap_mme_overload_is_timer (const long timer_id);
+void s1ap_mme_overload_evaluate (void);
+
+// The eNB just completed its S1 setup, it is told about the current overload
+void s1ap_mme_overload_new_enb (const sctp_assoc_id_t assoc_id);
+
+// rrc_cause is the S1AP RRC establishment cause of the initial UE message
+bool s1ap_mme_overload_reject_initial_ue (const long rrc_cause);
+
+#endif /* FILE_S1AP_MME_OVERLOAD_SEEN */
@@ -0,0 +1,207 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_paging.c
+  \brief Paging of the UEs in ECM-IDLE: S1AP PAGING sent to the eNBs serving
+  the TAIs the MME_APP pages the UE in.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "assertions.h"
+#include "log.h"
+#include "msc.h"
+#include "metrics.h"
+#include "conversions.h"
+#include "intertask_interface.h"
+#include "mme_config.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme_itti_messaging.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_tai_index.h"
+#include "s1ap_mme_paging.h"
+
+/*
+ * Only the S1AP task indexes the eNBs and sends the PAGINGs.
+ */
+static struct {
+  s1ap_tai_index_t                       *tai_index;
+  metric_id_t                             paging_metric;
+  metric_id_t                             enb_message_metric;
+  metric_id_t                             no_enb_metric;
+} s1ap_paging = {
+  .tai_index = NULL,
+  .paging_metric = METRIC_ID_INVALID,
+  .enb_message_metric = METRIC_ID_INVALID,
+  .no_enb_metric = METRIC_ID_INVALID,
+};
+
+// The PDU sent to every eNB of a paging
+typedef struct s1ap_paging_pdu_s {
+  uint8_t                                *buffer;
+  uint32_t                                length;
+  uint32_t                                nb_sent;
+} s1ap_paging_pdu_t;
+
+//------------------------------------------------------------------------------
+int s1ap_mme_paging_init (void)
+{
+  s1ap_paging.tai_index = s1ap_tai_index_create (mme_config.max_enbs);
+  if (!s1ap_paging.tai_index) {
+    return RETURNerror;
+  }
+  s1ap_paging.paging_metric = metrics_register_counter ("s1ap_paging_total", "S1AP PAGING procedures, one per paging attempt of a UE");
+  s1ap_paging.enb_message_metric = metrics_register_counter ("s1ap_paging_enb_messages_total", "S1AP PAGING messages sent to the eNBs");
+  s1ap_paging.no_enb_metric = metrics_register_counter ("s1ap_paging_no_enb_total", "S1AP PAGING procedures without any eNB serving the TAIs");
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_paging_exit (void)
+{
+  s1ap_tai_index_destroy (s1ap_paging.tai_index);
+  s1ap_paging.tai_index = NULL;
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_paging_new_enb (const sctp_assoc_id_t assoc_id, const S1ap_SupportedTAs_t * const supported_tas)
+{
+  tai_t                                  *tais = NULL;
+  uint32_t                                nb_tais = 0;
+  int                                     rc = RETURNok;
+
+  DevAssert (supported_tas != NULL);
+  tais = calloc (S1AP_TAI_INDEX_MAX_TAIS_PER_ENB, sizeof (tai_t));
+  if (!tais) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < supported_tas->list.count; i++) {
+    const S1ap_SupportedTAs_Item_t * const ta = supported_tas->list.array[i];
+    uint16_t                                tac = 0;
+
+    OCTET_STRING_TO_TAC (&ta->tAC, tac);
+    for (int j = 0; (j < ta->broadcastPLMNs.list.count) && (nb_tais < S1AP_TAI_INDEX_MAX_TAIS_PER_ENB); j++) {
+      TBCD_TO_PLMN_T (ta->broadcastPLMNs.list.array[j], &tais[nb_tais].plmn);
+      tais[nb_tais].tac = tac;
+      nb_tais++;
+    }
+  }
+  rc = s1ap_tai_index_add_enb (s1ap_paging.tai_index, assoc_id, tais, nb_tais);
+  OAILOG_DEBUG (LOG_S1AP, "eNB assoc_id %u serves %u TAIs\n", assoc_id, nb_tais);
+  free (tais);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_paging_remove_enb (const sctp_assoc_id_t assoc_id)
+{
+  s1ap_tai_index_remove_enb (s1ap_paging.tai_index, assoc_id);
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_mme_paging_send_enb_cb (const sctp_assoc_id_t assoc_id, void *arg)
+{
+  s1ap_paging_pdu_t                      *pdu = (s1ap_paging_pdu_t *)arg;
+  enb_description_t                      *enb_ref = s1ap_is_enb_assoc_id_in_list (assoc_id);
+
+  if ((!enb_ref) || (S1AP_READY != enb_ref->s1_state)) {
+    return;
+  }
+  /*
+   * Non-UE signalling -> stream 0
+   */
+  bstring b = blk2bstr (pdu->buffer, pdu->length);
+  if (RETURNok == s1ap_mme_itti_send_sctp_request (&b, assoc_id, 0, INVALID_MME_UE_S1AP_ID)) {
+    pdu->nb_sent++;
+  }
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_handle_paging_request (const itti_s1ap_paging_request_t * const paging_request_p)
+{
+  s1ap_message                            message = { 0 };
+  S1ap_PagingIEs_t                       *paging_p = &message.msg.s1ap_PagingIEs;
+  S1ap_TAIItem_t                          tai_items[TAI_LIST_MAX_SIZE];
+  s1ap_paging_pdu_t                       pdu = { 0 };
+  int                                     rc = RETURNok;
+
+  OAILOG_FUNC_IN (LOG_S1AP);
+  DevAssert (paging_request_p != NULL);
+  DevAssert (paging_request_p->nb_tais <= TAI_LIST_MAX_SIZE);
+  metrics_counter_add (s1ap_paging.paging_metric, 1);
+
+  message.procedureCode = S1ap_ProcedureCode_id_Paging;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  // UE identity index value, 10 bits
+  paging_p->ueIdentityIndexValue.buf = calloc (2, sizeof (uint8_t));
+  paging_p->ueIdentityIndexValue.buf[0] = (uint8_t)(paging_request_p->ue_identity_index >> 2);
+  paging_p->ueIdentityIndexValue.buf[1] = (uint8_t)((paging_request_p->ue_identity_index & 0x03) << 6);
+  paging_p->ueIdentityIndexValue.size = 2;
+  paging_p->ueIdentityIndexValue.bits_unused = 6;
+  paging_p->uePagingID.present = S1ap_UEPagingID_PR_s_TMSI;
+  MME_CODE_TO_OCTET_STRING (paging_request_p->mme_code, &paging_p->uePagingID.choice.s_TMSI.mMEC);
+  M_TMSI_TO_OCTET_STRING (paging_request_p->m_tmsi, &paging_p->uePagingID.choice.s_TMSI.m_TMSI);
+  paging_p->cnDomain = S1ap_CNDomain_ps;
+  // the items are on the stack, the list only points to them
+  memset (tai_items, 0, sizeof (tai_items));
+  for (int i = 0; i < paging_request_p->nb_tais; i++) {
+    const tai_t * const tai = &paging_request_p->tai[i];
+
+    tai_items[i].tAI.pLMNidentity.buf = calloc (3, sizeof (uint8_t));
+    tai_items[i].tAI.pLMNidentity.buf[0] = (tai->plmn.mcc_digit2 << 4) | tai->plmn.mcc_digit1;
+    tai_items[i].tAI.pLMNidentity.buf[1] = (tai->plmn.mnc_digit3 << 4) | tai->plmn.mcc_digit3;
+    tai_items[i].tAI.pLMNidentity.buf[2] = (tai->plmn.mnc_digit2 << 4) | tai->plmn.mnc_digit1;
+    tai_items[i].tAI.pLMNidentity.size = 3;
+    TAC_TO_ASN1 (tai->tac, &tai_items[i].tAI.tAC);
+    ASN_SEQUENCE_ADD (&paging_p->taiList.s1ap_TAIItem, &tai_items[i]);
+  }
+
+  rc = s1ap_mme_encode_pdu (&message, &pdu.buffer, &pdu.length);
+  free_s1ap_paging (paging_p);
+  // no free function set on the list, only its array is released
+  asn_sequence_empty (&paging_p->taiList.s1ap_TAIItem);
+  if (rc < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to encode paging of UE " MME_UE_S1AP_ID_FMT "\n", paging_request_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
+
+  s1ap_tai_index_lookup (s1ap_paging.tai_index, paging_request_p->tai, paging_request_p->nb_tais, s1ap_mme_paging_send_enb_cb, &pdu);
+  free (pdu.buffer);
+  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_S1AP_ENB, NULL, 0, "0 Paging mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %u eNBs",
+      paging_request_p->mme_ue_s1ap_id, pdu.nb_sent);
+  if (0 == pdu.nb_sent) {
+    OAILOG_WARNING (LOG_S1AP, "No eNB serving the %u TAIs to page UE " MME_UE_S1AP_ID_FMT "\n", paging_request_p->nb_tais, paging_request_p->mme_ue_s1ap_id);
+    metrics_counter_add (s1ap_paging.no_enb_metric, 1);
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
+  metrics_counter_add (s1ap_paging.enb_message_metric, pdu.nb_sent);
+  OAILOG_DEBUG (LOG_S1AP, "Paging UE " MME_UE_S1AP_ID_FMT " on %u eNBs\n", paging_request_p->mme_ue_s1ap_id, pdu.nb_sent);
+  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+}
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_paging.h
+  \brief Paging of the UEs in ECM-IDLE: S1AP PAGING sent to the eNBs serving
+  the TAIs the MME_APP pages the UE in.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_S1AP_MME_PAGING_SEEN
+#define FILE_S1AP_MME_PAGING_SEEN
+
+#include <stdint.h>
+
+#include "common_types.h"
+#include "s1ap_messages_types.h"
+#include "s1ap_common.h"
+
+int  s1ap_mme_paging_init (void);
+
+void s1ap_mme_paging_exit (void);
+
+// The eNB just completed its S1 setup, its supported TAs are indexed
+int  s1ap_mme_paging_new_enb (const sctp_assoc_id_t assoc_id, const S1ap_SupportedTAs_t * const supported_tas);
+
+void s1ap_mme_paging_remove_enb (const sctp_assoc_id_t assoc_id);
+
+/*
+ * The PAGING is encoded once and the same PDU is sent on stream 0 to every
+ * eNB in S1AP_READY state serving at least one TAI of the request.
+ */
+int  s1ap_mme_handle_paging_request (const itti_s1ap_paging_request_t * const paging_request_p);
+
+#endif /* FILE_S1AP_MME_PAGING_SEEN */
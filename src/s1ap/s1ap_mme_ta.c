@@ -27,37 +27,30 @@
 #include "assertions.h"
 #include "conversions.h"
 #include "mme_config.h"
+#include "mme_config_snapshot.h"
 #include "s1ap_common.h"
 #include "s1ap_mme_ta.h"
 
 static
   int
 s1ap_mme_compare_plmn (
+  const mme_config_snapshot_t * const snapshot,
   const S1ap_PLMNidentity_t * const plmn)
 {
-  int                                     i = 0;
   uint16_t                                mcc = 0;
   uint16_t                                mnc = 0;
   uint16_t                                mnc_len = 0;
 
   DevAssert (plmn != NULL);
   TBCD_TO_MCC_MNC (plmn, mcc, mnc, mnc_len);
-  mme_config_read_lock (&mme_config);
-
-  for (i = 0; i < mme_config.served_tai.nb_tai; i++) {
-    OAILOG_TRACE (LOG_S1AP, "Comparing plmn_mcc %d/%d, plmn_mnc %d/%d plmn_mnc_len %d/%d\n",
-        mme_config.served_tai.plmn_mcc[i], mcc, mme_config.served_tai.plmn_mnc[i], mnc, mme_config.served_tai.plmn_mnc_len[i], mnc_len);
-
-    if ((mme_config.served_tai.plmn_mcc[i] == mcc) &&
-        (mme_config.served_tai.plmn_mnc[i] == mnc) &&
-        (mme_config.served_tai.plmn_mnc_len[i] == mnc_len))
-      /*
-       * There is a matching plmn
-       */
-      return TA_LIST_AT_LEAST_ONE_MATCH;
-  }
+  OAILOG_TRACE (LOG_S1AP, "Looking for plmn_mcc %d, plmn_mnc %d plmn_mnc_len %d\n", mcc, mnc, mnc_len);
+
+  if (mme_config_snapshot_served_plmn (snapshot, mcc, mnc, mnc_len))
+    /*
+     * There is a matching plmn
+     */
+    return TA_LIST_AT_LEAST_ONE_MATCH;
 
-  mme_config_unlock (&mme_config);
   return TA_LIST_NO_MATCH;
 }
 
@@ -66,6 +59,7 @@ s1ap_mme_compare_plmn (
 static
   int
 s1ap_mme_compare_plmns (
+  const mme_config_snapshot_t * const snapshot,
   S1ap_BPLMNs_t * b_plmns)
 {
   int                                     i =0;
@@ -74,7 +68,7 @@ s1ap_mme_compare_plmns (
   DevAssert (b_plmns != NULL);
 
   for (i = 0; i < b_plmns->list.count; i++) {
-    if (s1ap_mme_compare_plmn (b_plmns->list.array[i])
+    if (s1ap_mme_compare_plmn (snapshot, b_plmns->list.array[i])
         == TA_LIST_AT_LEAST_ONE_MATCH)
       matching_occurence++;
   }
@@ -92,23 +86,18 @@ s1ap_mme_compare_plmns (
 static
   int
 s1ap_mme_compare_tac (
+  const mme_config_snapshot_t * const snapshot,
   const S1ap_TAC_t * const tac)
 {
-  int                                     i = 0;
   uint16_t                                tac_value = 0;
 
   DevAssert (tac != NULL);
   OCTET_STRING_TO_TAC (tac, tac_value);
-  mme_config_read_lock (&mme_config);
+  OAILOG_TRACE (LOG_S1AP, "Looking for tac = %d\n", tac_value);
 
-  for (i = 0; i < mme_config.served_tai.nb_tai; i++) {
-    OAILOG_TRACE (LOG_S1AP, "Comparing config tac %d, received tac = %d\n", mme_config.served_tai.tac[i], tac_value);
-
-    if (mme_config.served_tai.tac[i] == tac_value)
-      return TA_LIST_AT_LEAST_ONE_MATCH;
-  }
+  if (mme_config_snapshot_served_tac (snapshot, tac_value))
+    return TA_LIST_AT_LEAST_ONE_MATCH;
 
-  mme_config_unlock (&mme_config);
   return TA_LIST_NO_MATCH;
 }
 
@@ -125,30 +114,34 @@ s1ap_mme_compare_ta_lists (
   int                                     i;
   int                                     tac_ret,
                                           bplmn_ret;
+  int                                     ret = TA_LIST_RET_OK;
+  const mme_config_snapshot_t            *snapshot = NULL;
 
   DevAssert (ta_list != NULL);
+  snapshot = mme_config_snapshot_acquire ();
 
   /*
    * Parse every item in the list and try to find matching parameters
    */
-  for (i = 0; i < ta_list->list.count; i++) {
+  for (i = 0; (i < ta_list->list.count) && (ret == TA_LIST_RET_OK); i++) {
     S1ap_SupportedTAs_Item_t               *ta;
 
     ta = ta_list->list.array[i];
     DevAssert (ta != NULL);
-    tac_ret = s1ap_mme_compare_tac (&ta->tAC);
-    bplmn_ret = s1ap_mme_compare_plmns (&ta->broadcastPLMNs);
+    tac_ret = s1ap_mme_compare_tac (snapshot, &ta->tAC);
+    bplmn_ret = s1ap_mme_compare_plmns (snapshot, &ta->broadcastPLMNs);
 
     if (tac_ret == TA_LIST_NO_MATCH && bplmn_ret == TA_LIST_NO_MATCH) {
-      return TA_LIST_UNKNOWN_PLMN + TA_LIST_UNKNOWN_TAC;
+      ret = TA_LIST_UNKNOWN_PLMN + TA_LIST_UNKNOWN_TAC;
     } else {
       if (tac_ret > TA_LIST_NO_MATCH && bplmn_ret == TA_LIST_NO_MATCH) {
-        return TA_LIST_UNKNOWN_PLMN;
+        ret = TA_LIST_UNKNOWN_PLMN;
       } else if (tac_ret == TA_LIST_NO_MATCH && bplmn_ret > TA_LIST_NO_MATCH) {
-        return TA_LIST_UNKNOWN_TAC;
+        ret = TA_LIST_UNKNOWN_TAC;
       }
     }
   }
 
-  return TA_LIST_RET_OK;
+  mme_config_snapshot_release ();
+  return ret;
 }
@@ -0,0 +1,208 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_tai_index.c
+  \brief Index of the eNBs serving a tracking area, built from the supported
+  TAs of the S1 SETUP REQUEST, to address the paging of a UE to the eNBs of
+  its TAI list only.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "dynamic_memory_check.h"
+#include "s1ap_mme_tai_index.h"
+
+#define S1AP_TAI_INDEX_FIRST_ENBS_SIZE    8
+
+//------------------------------------------------------------------------------
+static void s1ap_tai_index_free_tai (void **tai_pp)
+{
+  s1ap_tai_index_tai_t                   *tai_p = (s1ap_tai_index_tai_t *)*tai_pp;
+
+  if (tai_p) {
+    free_wrapper ((void **)&tai_p->enbs);
+    free_wrapper (tai_pp);
+  }
+}
+
+//------------------------------------------------------------------------------
+s1ap_tai_index_t *s1ap_tai_index_create (const hash_size_t nb_enbs)
+{
+  s1ap_tai_index_t                       *index = calloc (1, sizeof (s1ap_tai_index_t));
+  bstring                                 bs = NULL;
+
+  if (!index) {
+    return NULL;
+  }
+  bs = bfromcstr ("s1ap_tai_index_tais");
+  index->tais = hashtable_create (nb_enbs, NULL, s1ap_tai_index_free_tai, bs);
+  bdestroy (bs);
+  bs = bfromcstr ("s1ap_tai_index_enbs");
+  index->enbs = hashtable_create (nb_enbs, NULL, NULL, bs);
+  bdestroy (bs);
+  if ((!index->tais) || (!index->enbs)) {
+    s1ap_tai_index_destroy (index);
+    return NULL;
+  }
+  index->tais->log_enabled = false;
+  index->enbs->log_enabled = false;
+  return index;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_tai_index_destroy (s1ap_tai_index_t * index)
+{
+  if (index) {
+    if (index->tais) {
+      hashtable_destroy (index->tais);
+    }
+    if (index->enbs) {
+      hashtable_destroy (index->enbs);
+    }
+    free_wrapper ((void **)&index);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_tai_index_link (s1ap_tai_index_t * const index, const hash_key_t key, s1ap_tai_index_enb_t * const enb_p)
+{
+  s1ap_tai_index_tai_t                   *tai_p = NULL;
+
+  if (HASH_TABLE_OK != hashtable_get (index->tais, key, (void **)&tai_p)) {
+    tai_p = calloc (1, sizeof (s1ap_tai_index_tai_t));
+    if ((!tai_p) || (HASH_TABLE_OK != hashtable_insert (index->tais, key, tai_p))) {
+      free_wrapper ((void **)&tai_p);
+      return RETURNerror;
+    }
+  }
+  for (uint32_t i = 0; i < tai_p->nb_enbs; i++) {
+    if (tai_p->enbs[i] == enb_p) {
+      // TAI broadcast twice by the eNB
+      return RETURNok;
+    }
+  }
+  if (tai_p->nb_enbs == tai_p->size) {
+    uint32_t                                size = tai_p->size ? 2 * tai_p->size : S1AP_TAI_INDEX_FIRST_ENBS_SIZE;
+    s1ap_tai_index_enb_t                  **enbs = realloc (tai_p->enbs, size * sizeof (s1ap_tai_index_enb_t *));
+
+    if (!enbs) {
+      return RETURNerror;
+    }
+    tai_p->enbs = enbs;
+    tai_p->size = size;
+  }
+  tai_p->enbs[tai_p->nb_enbs++] = enb_p;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_tai_index_unlink (s1ap_tai_index_t * const index, const hash_key_t key, const s1ap_tai_index_enb_t * const enb_p)
+{
+  s1ap_tai_index_tai_t                   *tai_p = NULL;
+
+  if (HASH_TABLE_OK != hashtable_get (index->tais, key, (void **)&tai_p)) {
+    return;
+  }
+  for (uint32_t i = 0; i < tai_p->nb_enbs; i++) {
+    if (tai_p->enbs[i] == enb_p) {
+      tai_p->enbs[i] = tai_p->enbs[--tai_p->nb_enbs];
+      break;
+    }
+  }
+  if (!tai_p->nb_enbs) {
+    hashtable_free (index->tais, key);
+  }
+}
+
+//------------------------------------------------------------------------------
+int s1ap_tai_index_add_enb (s1ap_tai_index_t * const index, const sctp_assoc_id_t assoc_id, const tai_t * const tais, const uint32_t nb_tais)
+{
+  s1ap_tai_index_enb_t                   *enb_p = NULL;
+  uint32_t                                nb = (nb_tais > S1AP_TAI_INDEX_MAX_TAIS_PER_ENB) ? S1AP_TAI_INDEX_MAX_TAIS_PER_ENB : nb_tais;
+
+  s1ap_tai_index_remove_enb (index, assoc_id);
+  enb_p = calloc (1, sizeof (s1ap_tai_index_enb_t) + nb * sizeof (hash_key_t));
+  if (!enb_p) {
+    return RETURNerror;
+  }
+  enb_p->assoc_id = assoc_id;
+  enb_p->epoch = index->epoch;
+  if (HASH_TABLE_OK != hashtable_insert (index->enbs, (const hash_key_t)assoc_id, enb_p)) {
+    free_wrapper ((void **)&enb_p);
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < nb; i++) {
+    enb_p->tais[enb_p->nb_tais] = S1AP_TAI_INDEX_KEY (&tais[i]);
+    if (s1ap_tai_index_link (index, enb_p->tais[enb_p->nb_tais], enb_p) != RETURNok) {
+      s1ap_tai_index_remove_enb (index, assoc_id);
+      return RETURNerror;
+    }
+    enb_p->nb_tais++;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_tai_index_remove_enb (s1ap_tai_index_t * const index, const sctp_assoc_id_t assoc_id)
+{
+  s1ap_tai_index_enb_t                   *enb_p = NULL;
+
+  if (HASH_TABLE_OK != hashtable_remove (index->enbs, (const hash_key_t)assoc_id, (void **)&enb_p)) {
+    return;
+  }
+  for (uint32_t i = 0; i < enb_p->nb_tais; i++) {
+    s1ap_tai_index_unlink (index, enb_p->tais[i], enb_p);
+  }
+  free_wrapper ((void **)&enb_p);
+}
+
+//------------------------------------------------------------------------------
+uint32_t s1ap_tai_index_lookup (s1ap_tai_index_t * const index, const tai_t * const tais, const uint32_t nb_tais,
+                                void (*enb_cb)(const sctp_assoc_id_t assoc_id, void *arg), void *arg)
+{
+  s1ap_tai_index_tai_t                   *tai_p = NULL;
+  uint32_t                                nb_enbs = 0;
+
+  index->epoch++;
+  for (uint32_t i = 0; i < nb_tais; i++) {
+    if (HASH_TABLE_OK != hashtable_get (index->tais, S1AP_TAI_INDEX_KEY (&tais[i]), (void **)&tai_p)) {
+      continue;
+    }
+    for (uint32_t j = 0; j < tai_p->nb_enbs; j++) {
+      s1ap_tai_index_enb_t                 *enb_p = tai_p->enbs[j];
+
+      if (enb_p->epoch != index->epoch) {
+        enb_p->epoch = index->epoch;
+        enb_cb (enb_p->assoc_id, arg);
+        nb_enbs++;
+      }
+    }
+  }
+  return nb_enbs;
+}
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_tai_index.h
+  \brief Index of the eNBs serving a tracking area, built from the supported
+  TAs of the S1 SETUP REQUEST, to address the paging of a UE to the eNBs of
+  its TAI list only.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_S1AP_MME_TAI_INDEX_SEEN
+#define FILE_S1AP_MME_TAI_INDEX_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+#include "hashtable.h"
+
+/*
+ * A TAI is a key of 40 bits: the PLMN identity, as 6 BCD digits in the order
+ * of plmn_t, followed by the TAC. Every TAI maps to the eNBs broadcasting it,
+ * every eNB keeps the keys of its TAIs so that it can leave the index when
+ * its association goes down.
+ *
+ * The index is used by the S1AP task only and is not thread safe.
+ */
+#define S1AP_TAI_INDEX_MAX_TAIS_PER_ENB   (256 * 6)   // maxnoofTACs * maxnoofBPLMNs
+
+#define S1AP_TAI_INDEX_KEY(tAi_PtR)                                 \
+  ((((hash_key_t)(tAi_PtR)->plmn.mcc_digit2) << 36) |               \
+   (((hash_key_t)(tAi_PtR)->plmn.mcc_digit1) << 32) |               \
+   (((hash_key_t)(tAi_PtR)->plmn.mnc_digit3) << 28) |               \
+   (((hash_key_t)(tAi_PtR)->plmn.mcc_digit3) << 24) |               \
+   (((hash_key_t)(tAi_PtR)->plmn.mnc_digit2) << 20) |               \
+   (((hash_key_t)(tAi_PtR)->plmn.mnc_digit1) << 16) |               \
+   ((hash_key_t)(tAi_PtR)->tac))
+
+typedef struct s1ap_tai_index_enb_s {
+  sctp_assoc_id_t                 assoc_id;
+  uint32_t                        epoch;      // of the last lookup that returned this eNB
+  uint32_t                        nb_tais;
+  hash_key_t                      tais[];     // nb_tais keys
+} s1ap_tai_index_enb_t;
+
+typedef struct s1ap_tai_index_tai_s {
+  uint32_t                        nb_enbs;
+  uint32_t                        size;       // of enbs
+  s1ap_tai_index_enb_t          **enbs;
+} s1ap_tai_index_tai_t;
+
+typedef struct s1ap_tai_index_s {
+  hash_table_t                   *tais;       // s1ap_tai_index_tai_t, key is S1AP_TAI_INDEX_KEY
+  hash_table_t                   *enbs;       // s1ap_tai_index_enb_t, key is the SCTP association id
+  uint32_t                        epoch;      // lookups done, to return an eNB once per lookup
+} s1ap_tai_index_t;
+
+s1ap_tai_index_t *s1ap_tai_index_create (const hash_size_t nb_enbs);
+
+void s1ap_tai_index_destroy (s1ap_tai_index_t * index);
+
+// Sets the TAIs served by an eNB, replacing the ones of a previous S1 setup
+int s1ap_tai_index_add_enb (s1ap_tai_index_t * const index, const sctp_assoc_id_t assoc_id, const tai_t * const tais, const uint32_t nb_tais);
+
+void s1ap_tai_index_remove_enb (s1ap_tai_index_t * const index, const sctp_assoc_id_t assoc_id);
+
+/*
+ * Calls enb_cb once for every eNB serving at least one of the TAIs, whatever
+ * the number of TAIs it serves in the list.
+ * @returns the number of eNBs
+ */
+uint32_t s1ap_tai_index_lookup (s1ap_tai_index_t * const index, const tai_t * const tais, const uint32_t nb_tais,
+                                void (*enb_cb)(const sctp_assoc_id_t assoc_id, void *arg), void *arg);
+
+#endif /* FILE_S1AP_MME_TAI_INDEX_SEEN */
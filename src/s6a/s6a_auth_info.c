@@ -32,6 +32,8 @@
 #include "s6a_defs.h"
 #include "s6a_messages.h"
 #include "msc.h"
+#include "mme_app_shard.h"
+#include "mme_app_statistics.h"
 
 static
   int
@@ -213,6 +215,8 @@ s6a_aia_cb (
   /*
    * Retrieve the original query associated with the asnwer
    */
+  // the request is answered whatever the content of the answer
+  update_mme_app_stats_s6a_request_sub ();
   CHECK_FCT (fd_msg_answ_getq (ans, &qry));
   DevAssert (qry );
   message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
@@ -284,102 +288,31 @@ s6a_aia_cb (
     }
   }
 
-  itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (nas_task_of_imsi (s6a_auth_info_ans_p->imsi), INSTANCE_DEFAULT, message_p);
 err:
   return RETURNok;
 }
 
 int
-s6a_generate_authentication_info_req (
-  s6a_auth_info_req_t * air_p)
+s6a_build_authentication_info_req (
+  const s6a_request_params_t * params,
+  s6a_request_template_t * template_p,
+  struct msg **msg_pP)
 {
+  const s6a_auth_info_req_t              *air_p = &params->air;
   struct avp                             *avp;
   struct msg                             *msg;
-  struct session                         *sess;
   union avp_value                         value;
 
-  DevAssert (air_p );
-  /*
-   * Create the new update location request message
-   */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, 0, &msg));
-  /*
-   * Create a new session
-   */
-  CHECK_FCT (fd_sess_new (&sess, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
-  {
-    os0_t                                   sid;
-    size_t                                  sidlen;
-
-    CHECK_FCT (fd_sess_getsid (sess, &sid, &sidlen));
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp));
-    value.os.data = sid;
-    value.os.len = sidlen;
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_FIRST_CHILD, avp));
-  }
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp));
-  /*
-   * No State maintained
-   */
-  value.i32 = 1;
-  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  /*
-   * Add Origin_Host & Origin_Realm
-   */
-  CHECK_FCT (fd_msg_add_origin (msg, 0));
-  mme_config_read_lock (&mme_config);
-  /*
-   * Destination Host
-   */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    bdestroy(host);
-  }
-  /*
-   * Destination_Realm
-   */
-  {
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp));
-    value.os.data = (unsigned char *)bdata(mme_config.realm);
-    value.os.len = blength(mme_config.realm);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-  }
-  mme_config_unlock (&mme_config);
   /*
-   * Adding the User-Name (IMSI)
+   * Create the new authentication information request message with the AVPs
+   * of the template of the peer and the User-Name (IMSI)
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp));
-  value.os.data = (unsigned char *)air_p->imsi;
-  value.os.len = strlen (air_p->imsi);
-  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  CHECK_FCT (s6a_request_template_new (template_p, s6a_fd_cnf.dataobj_s6a_air, air_p->imsi, &msg));
   /*
    * Adding the visited plmn id
    */
-  {
-    uint8_t                                 plmn[3] = { 0x00, 0x00, 0x00 };     //{ 0x02, 0xF8, 0x29 };
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp));
-    PLMN_T_TO_TBCD (air_p->visited_plmn,
-                    plmn, mme_config_find_mnc_length (air_p->visited_plmn.mcc_digit1, air_p->visited_plmn.mcc_digit2, air_p->visited_plmn.mcc_digit3, air_p->visited_plmn.mnc_digit1, air_p->visited_plmn.mnc_digit2, air_p->visited_plmn.mnc_digit3)
-      );
-    value.os.data = plmn;
-    value.os.len = 3;
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    OAILOG_DEBUG (LOG_S6A, "%s plmn: %02X%02X%02X\n", __FUNCTION__, plmn[0], plmn[1], plmn[2]);
-    OAILOG_DEBUG (LOG_S6A, "%s visited_plmn: %02X%02X%02X\n", __FUNCTION__, value.os.data[0], value.os.data[1], value.os.data[2]);
-  }
+  CHECK_FCT (s6a_request_template_add_visited_plmn (template_p, msg, &air_p->visited_plmn));
   /*
    * Adding the requested E-UTRAN authentication info AVP
    */
@@ -410,13 +343,47 @@ s6a_generate_authentication_info_req (
     if (air_p->re_synchronization) {
       CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp));
       value.os.len = RESYNC_PARAM_LENGTH;
-      value.os.data = (air_p->resync_param);
+      value.os.data = (uint8_t *)(air_p->resync_param);
       CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
       CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
     }
 
     CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
   }
-  CHECK_FCT (fd_msg_send (&msg, NULL, NULL));
+  *msg_pP = msg;
   return RETURNok;
 }
+
+void
+s6a_authentication_info_req_failed (
+  const s6a_request_params_t * params)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_ans_t                    *s6a_auth_info_ans_p = NULL;
+
+  /*
+   * No HSS peer answered, NAS is answered as if the HSS could not be reached
+   */
+  OAILOG_ERROR (LOG_S6A, "No answer to the air for imsi=%s\n", params->air.imsi);
+  update_mme_app_stats_s6a_request_sub ();
+  message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+  s6a_auth_info_ans_p = &message_p->ittiMsg.s6a_auth_info_ans;
+  memset (s6a_auth_info_ans_p, 0, sizeof (s6a_auth_info_ans_t));
+  snprintf (s6a_auth_info_ans_p->imsi, sizeof (s6a_auth_info_ans_p->imsi), "%s", params->air.imsi);
+  s6a_auth_info_ans_p->imsi_length = strlen (s6a_auth_info_ans_p->imsi);
+  s6a_auth_info_ans_p->result.present = S6A_RESULT_BASE;
+  s6a_auth_info_ans_p->result.choice.base = DIAMETER_UNABLE_TO_DELIVER;
+  itti_send_msg_to_task (nas_task_of_imsi (s6a_auth_info_ans_p->imsi), INSTANCE_DEFAULT, message_p);
+}
+
+int
+s6a_generate_authentication_info_req (
+  s6a_auth_info_req_t * air_p)
+{
+  s6a_request_params_t                    params;
+
+  DevAssert (air_p );
+  params.air = *air_p;
+  update_mme_app_stats_s6a_request_add ();
+  return s6a_router_submit (S6A_REQUEST_AIR, &params);
+}
@@ -32,6 +32,7 @@
 
 #include "mme_config.h"
 #include "queue.h"
+#include "s6a_template.h"
 
 
 #define VENDOR_3GPP (10415)
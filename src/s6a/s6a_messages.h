@@ -23,9 +23,21 @@
 #ifndef S6A_MESSAGES_H_
 #define S6A_MESSAGES_H_
 
+#include "s6a_router.h"
+
 int s6a_generate_update_location(s6a_update_location_req_t *ulr_p);
 int s6a_generate_authentication_info_req(s6a_auth_info_req_t *uar_p);
 
+/* Request handlers of the S6a router */
+int  s6a_build_update_location(const s6a_request_params_t *params,
+                               s6a_request_template_t *template_p,
+                               struct msg **msg_pP);
+void s6a_update_location_failed(const s6a_request_params_t *params);
+int  s6a_build_authentication_info_req(const s6a_request_params_t *params,
+                                       s6a_request_template_t *template_p,
+                                       struct msg **msg_pP);
+void s6a_authentication_info_req_failed(const s6a_request_params_t *params);
+
 int s6a_ula_cb(struct msg **msg, struct avp *paramavp,
                struct session *sess, void *opaque,
                enum disp_action *act);
@@ -95,11 +95,6 @@ s6a_fd_new_peer (
   struct peer_info                        info = {0};
 #endif
 
-  if (mme_config_read_lock (&mme_config) ) {
-    OAILOG_ERROR (LOG_S6A, "Failed to lock configuration for reading\n");
-    return RETURNerror;
-  }
-
   if (fd_g_config->cnf_diamid ) {
     free (fd_g_config->cnf_diamid);
     fd_g_config->cnf_diamid_len = 0;
@@ -113,80 +108,67 @@ s6a_fd_new_peer (
   fd_g_config->cnf_diamid = strdup (host_name);
   fd_g_config->cnf_diamid_len = strlen (fd_g_config->cnf_diamid);
   OAILOG_DEBUG (LOG_S6A, "Diameter identity of MME: %s with length: %zd\n", fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len);
-  bstring                                 hss_name = bstrcpy(mme_config.s6a_config.hss_host_name);
-  bconchar(hss_name, '.');
-  bconcat (hss_name, mme_config.realm);
-
-  if (mme_config_unlock (&mme_config) ) {
-    OAILOG_ERROR (LOG_S6A, "Failed to unlock configuration\n");
+  /*
+   * The AVPs of the requests that do not depend on the UE, one template per HSS peer
+   */
+  if (RETURNok != s6a_router_set_origin (fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len)) {
     return RETURNerror;
   }
 #if FD_CONF_FILE_NO_CONNECT_PEERS_CONFIGURED
-  info.pi_diamid    = bdata(hss_name);
-  info.pi_diamidlen = blength (hss_name);
-  OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
-  info.config.pic_flags.sec     = PI_SEC_NONE;
-  info.config.pic_flags.pro3    = PI_P3_DEFAULT;
-  info.config.pic_flags.pro4    = PI_P4_TCP;
-  info.config.pic_flags.alg     = PI_ALGPREF_TCP;
-  info.config.pic_flags.exp     = PI_EXP_INACTIVE;
-  info.config.pic_flags.persist = PI_PRST_NONE;
-  info.config.pic_port          = 3868;
-  info.config.pic_lft           = 3600;
-  info.config.pic_tctimer       = 7; // retry time-out connection
-  info.config.pic_twtimer       = 60; // watchdog
-  CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
+  for (int p = 0; p < s6a_router_nb_peers (); p++) {
+    info.pi_diamid    = (DiamId_t)bdata (s6a_router_peer_id (p));
+    info.pi_diamidlen = blength (s6a_router_peer_id (p));
+    OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
+    info.config.pic_flags.sec     = PI_SEC_NONE;
+    info.config.pic_flags.pro3    = PI_P3_DEFAULT;
+    info.config.pic_flags.pro4    = PI_P4_TCP;
+    info.config.pic_flags.alg     = PI_ALGPREF_TCP;
+    info.config.pic_flags.exp     = PI_EXP_INACTIVE;
+    info.config.pic_flags.persist = PI_PRST_NONE;
+    info.config.pic_port          = 3868;
+    info.config.pic_lft           = 3600;
+    info.config.pic_tctimer       = 7; // retry time-out connection
+    info.config.pic_twtimer       = 60; // watchdog
+    CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
+  }
 
   return ret;
 #else
-  DiamId_t          diamid    = bdata(hss_name);
-  size_t            diamidlen = blength (hss_name);
-  struct peer_hdr  *peer      = NULL;
   int               nb_tries  = 0;
   int               timeout   = fd_g_config->cnf_timer_tc;
 
   for (nb_tries = 0; nb_tries < NB_MAX_TRIES; nb_tries++) {
     OAILOG_DEBUG (LOG_S6A, "S6a peer connection attempt %d / %d\n",
                   1 + nb_tries, NB_MAX_TRIES);
-    ret = fd_peer_getbyid( diamid, diamidlen, 0, &peer );
-
-    if (peer && peer->info.config.pic_tctimer != 0) {
-        timeout = peer->info.config.pic_tctimer;
-    }
-
-    if (!ret) {
-      if (peer) {
-        ret = fd_peer_get_state(peer);
-        if (STATE_OPEN == ret) {
-          MessageDef                             *message_p;
-
-          OAILOG_DEBUG (LOG_S6A, "Peer %*s is now connected...\n", (int)diamidlen, diamid);
-          /*
-           * Inform S1AP that connection to HSS is established
-           */
-          message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
-          itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
-
-          {
-            FILE *fp = NULL;
-            bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
-            fp = fopen(bdata(filename), "w+");
-            bdestroy(filename);
-            fflush(fp);
-            fclose(fp);
-          }
-          bdestroy(hss_name);
-          return RETURNok;
-        } else {
-          OAILOG_DEBUG (LOG_S6A, "S6a peer state is %d\n", ret);
-        }
+    /*
+     * One open HSS peer is enough to serve the UEs, the others join the
+     * routing when the periodic check sees them open
+     */
+    ret = s6a_router_check_peers ();
+    if (0 < ret) {
+      MessageDef                             *message_p;
+
+      OAILOG_DEBUG (LOG_S6A, "%d / %d S6a peers are now connected...\n", ret, s6a_router_nb_peers ());
+      /*
+       * Inform S1AP that connection to HSS is established
+       */
+      message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
+      itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
+
+      {
+        FILE *fp = NULL;
+        bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
+        fp = fopen(bdata(filename), "w+");
+        bdestroy(filename);
+        fflush(fp);
+        fclose(fp);
       }
+      return RETURNok;
     } else {
-      OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer\n");
+      OAILOG_DEBUG (LOG_S6A, "No S6a peer open yet\n");
     }
     sleep(timeout);
   }
-  bdestroy(hss_name);
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
   return RETURNerror;
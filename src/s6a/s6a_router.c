@@ -0,0 +1,558 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_router.c
+  \brief Routing of the S6a requests of the MME to several HSS peers.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "queue.h"
+#include "common_defs.h"
+#include "assertions.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "metrics.h"
+#include "s6a_defs.h"
+#include "s6a_router.h"
+
+typedef struct s6a_request_s {
+  STAILQ_ENTRY (s6a_request_s)            entries;
+  s6a_request_type_t                      type;
+  int                                     peer;           // peer of the request in flight, -1 while queued
+  uint32_t                                tried_peers;    // bit per peer the request was sent to
+  uint64_t                                queued_ns;      // submit or fail over
+  uint64_t                                sent_ns;
+  s6a_request_params_t                    params;
+} s6a_request_t;
+
+STAILQ_HEAD (s6a_request_queue_s, s6a_request_s);
+
+typedef struct s6a_router_peer_s {
+  bstring                                 diameter_id;
+  uint32_t                                weight;
+  int64_t                                 current_weight; // smooth weighted round robin
+  bool                                    open;
+  uint32_t                                in_flight;
+  s6a_request_template_t                 *template_p;
+  uint64_t                                nb_requests;
+  uint64_t                                nb_answers;
+  uint64_t                                nb_timeouts;
+  metrics_histogram_cell_t                round_trip;     // from the send to the answer
+  metrics_histogram_cell_t                queue_wait;     // from the submit (or the fail over) to the send
+} s6a_router_peer_t;
+
+static struct {
+  pthread_mutex_t                         mutex;
+  s6a_request_handlers_t                  handlers[S6A_REQUEST_TYPE_MAX];
+  bool                                    weighted_routing;
+  uint32_t                                inflight_window;
+  uint32_t                                queue_size;
+  uint32_t                                request_timeout_ms;
+  bstring                                 realm;
+  int                                     nb_peers;
+  int                                     next_peer;      // first peer compared, spreads the ties
+  s6a_router_peer_t                       peers[S6A_ROUTER_MAX_PEERS];
+  struct s6a_request_queue_s              queue;
+  uint32_t                                queue_depth;
+  uint64_t                                nb_rejected;    // no room in the queue
+  uint64_t                                nb_failovers;
+  uint64_t                                nb_failed;      // no answer from any peer
+} s6a_router = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static void s6a_router_answer_cb (void *data, struct msg **msg_pP);
+static void s6a_router_expire_cb (void *data, DiamId_t sent_to, size_t sent_to_length, struct msg **msg_pP);
+static void s6a_router_retry (s6a_request_t * const request, struct s6a_request_queue_s * const failed);
+
+//------------------------------------------------------------------------------
+static void s6a_router_histogram_record (metrics_histogram_cell_t * const cell, const uint64_t value_us)
+{
+  cell->buckets[metrics_histogram_bucket (value_us)]++;
+  cell->sum += value_us;
+  cell->count++;
+}
+
+//------------------------------------------------------------------------------
+int s6a_router_init (const mme_config_t * const config_pP, const s6a_request_handlers_t handlers[S6A_REQUEST_TYPE_MAX])
+{
+  if ((0 == config_pP->s6a_config.nb_hss) || (S6A_ROUTER_MAX_PEERS < config_pP->s6a_config.nb_hss)) {
+    OAILOG_ERROR (LOG_S6A, "Bad number of HSS peers %d\n", config_pP->s6a_config.nb_hss);
+    return RETURNerror;
+  }
+  pthread_mutex_lock (&s6a_router.mutex);
+  memcpy (s6a_router.handlers, handlers, sizeof (s6a_router.handlers));
+  s6a_router.weighted_routing = config_pP->s6a_config.weighted_routing;
+  s6a_router.inflight_window = config_pP->s6a_config.inflight_window;
+  s6a_router.queue_size = config_pP->s6a_config.queue_size;
+  s6a_router.request_timeout_ms = config_pP->s6a_config.request_timeout_ms;
+  bdestroy (s6a_router.realm);
+  s6a_router.realm = bstrcpy (config_pP->realm);
+  STAILQ_INIT (&s6a_router.queue);
+  s6a_router.queue_depth = 0;
+  s6a_router.nb_rejected = 0;
+  s6a_router.nb_failovers = 0;
+  s6a_router.nb_failed = 0;
+  s6a_router.next_peer = 0;
+  s6a_router.nb_peers = config_pP->s6a_config.nb_hss;
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    memset (&s6a_router.peers[p], 0, sizeof (s6a_router_peer_t));
+    s6a_router.peers[p].diameter_id = bformat ("%s.%s", bdata (config_pP->s6a_config.hss[p].host_name), bdata (config_pP->realm));
+    s6a_router.peers[p].weight = config_pP->s6a_config.hss[p].weight ? config_pP->s6a_config.hss[p].weight : 1;
+  }
+  pthread_mutex_unlock (&s6a_router.mutex);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// the requests still in flight are freed by freeDiameter on its shutdown, before this call
+void s6a_router_exit (void)
+{
+  s6a_request_t                          *request = NULL;
+
+  pthread_mutex_lock (&s6a_router.mutex);
+  while ((request = STAILQ_FIRST (&s6a_router.queue))) {
+    STAILQ_REMOVE_HEAD (&s6a_router.queue, entries);
+    free_wrapper ((void **)&request);
+  }
+  s6a_router.queue_depth = 0;
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    s6a_request_template_destroy (&s6a_router.peers[p].template_p);
+    bdestroy (s6a_router.peers[p].diameter_id);
+    s6a_router.peers[p].diameter_id = NULL;
+  }
+  s6a_router.nb_peers = 0;
+  bdestroy (s6a_router.realm);
+  s6a_router.realm = NULL;
+  pthread_mutex_unlock (&s6a_router.mutex);
+}
+
+//------------------------------------------------------------------------------
+int s6a_router_set_origin (const char * const origin_host, const size_t origin_host_length)
+{
+  int                                     rc = RETURNok;
+
+  pthread_mutex_lock (&s6a_router.mutex);
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    s6a_request_template_destroy (&s6a_router.peers[p].template_p);
+    s6a_router.peers[p].template_p = s6a_request_template_create (origin_host, origin_host_length, s6a_router.peers[p].diameter_id, s6a_router.realm);
+    if (!s6a_router.peers[p].template_p) {
+      rc = RETURNerror;
+    }
+  }
+  pthread_mutex_unlock (&s6a_router.mutex);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int s6a_router_nb_peers (void)
+{
+  return s6a_router.nb_peers;
+}
+
+//------------------------------------------------------------------------------
+const_bstring s6a_router_peer_id (const int peer)
+{
+  return ((0 <= peer) && (s6a_router.nb_peers > peer)) ? s6a_router.peers[peer].diameter_id : NULL;
+}
+
+//------------------------------------------------------------------------------
+// an open peer the request was not sent to yet, mutex held
+static bool s6a_router_has_candidate (const s6a_request_t * const request)
+{
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    if ((s6a_router.peers[p].open) && (!(request->tried_peers & (1U << p)))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// the peer for the request among the open ones with room in their window, -1 if none, mutex held
+static int s6a_router_select_peer (const s6a_request_t * const request)
+{
+  s6a_router_peer_t                      *peer = NULL;
+  s6a_router_peer_t                      *best = NULL;
+  int                                     best_index = -1;
+  int64_t                                 total_weight = 0;
+
+  for (int i = 0; i < s6a_router.nb_peers; i++) {
+    const int                               p = (s6a_router.next_peer + i) % s6a_router.nb_peers;
+
+    peer = &s6a_router.peers[p];
+    if ((!peer->open) || (request->tried_peers & (1U << p)) || (!peer->template_p)
+        || ((s6a_router.inflight_window) && (peer->in_flight >= s6a_router.inflight_window))) {
+      continue;
+    }
+    if (s6a_router.weighted_routing) {
+      peer->current_weight += peer->weight;
+      total_weight += peer->weight;
+      if ((!best) || (peer->current_weight > best->current_weight)) {
+        best = peer;
+        best_index = p;
+      }
+    } else if ((!best) || ((uint64_t)peer->in_flight * best->weight < (uint64_t)best->in_flight * peer->weight)) {
+      // least outstanding requests per weight
+      best = peer;
+      best_index = p;
+    }
+  }
+  if (best) {
+    if (s6a_router.weighted_routing) {
+      best->current_weight -= total_weight;
+    }
+    s6a_router.next_peer = (best_index + 1) % s6a_router.nb_peers;
+  }
+  return best_index;
+}
+
+//------------------------------------------------------------------------------
+// mutex held, freeDiameter does not call the callbacks of the request from this thread
+static int s6a_router_send (s6a_request_t * const request, const int p)
+{
+  s6a_router_peer_t                      *peer = &s6a_router.peers[p];
+  struct msg                             *msg_p = NULL;
+  struct timespec                         timeout = {0};
+
+  // tried even if it fails, the request then goes to another peer
+  request->tried_peers |= (1U << p);
+  if (RETURNok != s6a_router.handlers[request->type].build (&request->params, peer->template_p, &msg_p)) {
+    OAILOG_ERROR (LOG_S6A, "Failed to build the S6a request for %s\n", bdata (peer->diameter_id));
+    return RETURNerror;
+  }
+  request->peer = p;
+  request->sent_ns = metrics_now_ns ();
+  s6a_router_histogram_record (&peer->queue_wait, (request->sent_ns - request->queued_ns) / 1000);
+  clock_gettime (CLOCK_REALTIME, &timeout);
+  timeout.tv_sec += s6a_router.request_timeout_ms / 1000;
+  timeout.tv_nsec += (s6a_router.request_timeout_ms % 1000) * 1000000;
+  if (timeout.tv_nsec >= 1000000000) {
+    timeout.tv_sec += 1;
+    timeout.tv_nsec -= 1000000000;
+  }
+  peer->in_flight++;
+  peer->nb_requests++;
+  if (fd_msg_send_timeout (&msg_p, s6a_router_answer_cb, request, s6a_router_expire_cb, &timeout)) {
+    OAILOG_ERROR (LOG_S6A, "Failed to send the S6a request to %s\n", bdata (peer->diameter_id));
+    peer->in_flight--;
+    request->peer = -1;
+    if (msg_p) {
+      fd_msg_free (msg_p);
+    }
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// sends the queued requests in order while a peer has room, mutex held
+static void s6a_router_drain (struct s6a_request_queue_s * const failed)
+{
+  s6a_request_t                          *request = NULL;
+  int                                     p = -1;
+
+  while ((request = STAILQ_FIRST (&s6a_router.queue))) {
+    p = s6a_router_select_peer (request);
+    if (0 > p) {
+      if (s6a_router_has_candidate (request)) {
+        // wait for an answer freeing a window
+        break;
+      }
+      for (p = 0; (p < s6a_router.nb_peers) && (!s6a_router.peers[p].open); p++);
+      if (p == s6a_router.nb_peers) {
+        // no open peer, wait for one up to the request timeout
+        break;
+      }
+      // every open peer was tried
+      STAILQ_REMOVE_HEAD (&s6a_router.queue, entries);
+      s6a_router.queue_depth--;
+      STAILQ_INSERT_TAIL (failed, request, entries);
+      continue;
+    }
+    STAILQ_REMOVE_HEAD (&s6a_router.queue, entries);
+    s6a_router.queue_depth--;
+    if (RETURNok != s6a_router_send (request, p)) {
+      // fails over as for a timeout, the next iteration selects another peer
+      s6a_router_retry (request, failed);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// calls the failed handlers, without the mutex
+static void s6a_router_fail (struct s6a_request_queue_s * const failed)
+{
+  s6a_request_t                          *request = NULL;
+
+  while ((request = STAILQ_FIRST (failed))) {
+    STAILQ_REMOVE_HEAD (failed, entries);
+    __sync_fetch_and_add (&s6a_router.nb_failed, 1);
+    if (s6a_router.handlers[request->type].failed) {
+      s6a_router.handlers[request->type].failed (&request->params);
+    }
+    free_wrapper ((void **)&request);
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_router_submit (const s6a_request_type_t type, const s6a_request_params_t * const params)
+{
+  struct s6a_request_queue_s              failed = STAILQ_HEAD_INITIALIZER (failed);
+  s6a_request_t                          *request = NULL;
+  int                                     rc = RETURNok;
+
+  DevAssert (S6A_REQUEST_TYPE_MAX > type);
+  request = calloc (1, sizeof (s6a_request_t));
+  request->type = type;
+  request->peer = -1;
+  request->params = *params;
+  request->queued_ns = metrics_now_ns ();
+  pthread_mutex_lock (&s6a_router.mutex);
+  if (s6a_router.queue_depth < s6a_router.queue_size) {
+    STAILQ_INSERT_TAIL (&s6a_router.queue, request, entries);
+    s6a_router.queue_depth++;
+    s6a_router_drain (&failed);
+  } else {
+    s6a_router.nb_rejected++;
+    STAILQ_INSERT_TAIL (&failed, request, entries);
+    rc = RETURNerror;
+  }
+  pthread_mutex_unlock (&s6a_router.mutex);
+  if (RETURNerror == rc) {
+    OAILOG_WARNING (LOG_S6A, "S6a queue full (%u requests), rejecting the request\n", s6a_router.queue_size);
+  }
+  s6a_router_fail (&failed);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// the request goes ahead of the new ones if a peer is left to try, not limited by the queue size, mutex held
+static void s6a_router_retry (s6a_request_t * const request, struct s6a_request_queue_s * const failed)
+{
+  request->peer = -1;
+  request->queued_ns = metrics_now_ns ();
+  if (s6a_router_has_candidate (request)) {
+    STAILQ_INSERT_HEAD (&s6a_router.queue, request, entries);
+    s6a_router.queue_depth++;
+    s6a_router.nb_failovers++;
+  } else {
+    STAILQ_INSERT_TAIL (failed, request, entries);
+  }
+}
+
+//------------------------------------------------------------------------------
+static uint32_t s6a_router_result_code (struct msg * const answer)
+{
+  struct avp                             *avp = NULL;
+  struct avp_hdr                         *hdr = NULL;
+
+  if ((0 == fd_msg_search_avp (answer, s6a_fd_cnf.dataobj_s6a_result_code, &avp)) && (avp)
+      && (0 == fd_msg_avp_hdr (avp, &hdr)) && (hdr->avp_value)) {
+    return hdr->avp_value->u32;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_router_answer_cb (void *data, struct msg **msg_pP)
+{
+  struct s6a_request_queue_s              failed = STAILQ_HEAD_INITIALIZER (failed);
+  s6a_request_t                          *request = (s6a_request_t *)data;
+  s6a_router_peer_t                      *peer = NULL;
+  const uint32_t                          result_code = s6a_router_result_code (*msg_pP);
+  enum disp_action                        action;
+
+  pthread_mutex_lock (&s6a_router.mutex);
+  peer = &s6a_router.peers[request->peer];
+  peer->in_flight--;
+  if ((DIAMETER_UNABLE_TO_DELIVER == result_code) || (DIAMETER_TOO_BUSY == result_code)) {
+    /*
+     * Pending requests of a lost peer are answered by freeDiameter itself, the
+     * Destination-Host being the lost peer
+     */
+    OAILOG_WARNING (LOG_S6A, "S6a request to %s answered %u\n", bdata (peer->diameter_id), result_code);
+    if (DIAMETER_UNABLE_TO_DELIVER == result_code) {
+      peer->open = false;
+    }
+    s6a_router_retry (request, &failed);
+    s6a_router_drain (&failed);
+    pthread_mutex_unlock (&s6a_router.mutex);
+    fd_msg_free (*msg_pP);
+    *msg_pP = NULL;
+    s6a_router_fail (&failed);
+    return;
+  }
+  peer->nb_answers++;
+  s6a_router_histogram_record (&peer->round_trip, (metrics_now_ns () - request->sent_ns) / 1000);
+  s6a_router_drain (&failed);
+  pthread_mutex_unlock (&s6a_router.mutex);
+
+  s6a_router.handlers[request->type].answer (msg_pP, NULL, NULL, NULL, &action);
+  if (*msg_pP) {
+    // the query is freed with its answer
+    fd_msg_free (*msg_pP);
+    *msg_pP = NULL;
+  }
+  free_wrapper ((void **)&request);
+  s6a_router_fail (&failed);
+}
+
+//------------------------------------------------------------------------------
+// no answer before the timeout, the request fails over to a peer it was not sent to
+static void s6a_router_expire_cb (void *data, DiamId_t sent_to, size_t sent_to_length, struct msg **msg_pP)
+{
+  struct s6a_request_queue_s              failed = STAILQ_HEAD_INITIALIZER (failed);
+  s6a_request_t                          *request = (s6a_request_t *)data;
+  s6a_router_peer_t                      *peer = NULL;
+
+  if (*msg_pP) {
+    fd_msg_free (*msg_pP);
+    *msg_pP = NULL;
+  }
+  pthread_mutex_lock (&s6a_router.mutex);
+  peer = &s6a_router.peers[request->peer];
+  peer->in_flight--;
+  peer->nb_timeouts++;
+  OAILOG_WARNING (LOG_S6A, "S6a request to %s timed out\n", bdata (peer->diameter_id));
+  s6a_router_retry (request, &failed);
+  s6a_router_drain (&failed);
+  pthread_mutex_unlock (&s6a_router.mutex);
+  s6a_router_fail (&failed);
+}
+
+//------------------------------------------------------------------------------
+int s6a_router_check_peers (void)
+{
+  struct s6a_request_queue_s              failed = STAILQ_HEAD_INITIALIZER (failed);
+  bool                                    open[S6A_ROUTER_MAX_PEERS] = {false};
+  struct peer_hdr                        *fd_peer = NULL;
+  s6a_request_t                          *request = NULL;
+  const uint64_t                          now = metrics_now_ns ();
+  int                                     nb_open = 0;
+
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    fd_peer = NULL;
+    open[p] = (0 == fd_peer_getbyid ((DiamId_t)bdata (s6a_router.peers[p].diameter_id), blength (s6a_router.peers[p].diameter_id), 0, &fd_peer))
+        && (fd_peer) && (STATE_OPEN == fd_peer_get_state (fd_peer));
+  }
+  pthread_mutex_lock (&s6a_router.mutex);
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    if (open[p] != s6a_router.peers[p].open) {
+      OAILOG_NOTICE (LOG_S6A, "HSS peer %s is now %s (%u requests in flight)\n",
+                     bdata (s6a_router.peers[p].diameter_id), open[p] ? "open" : "closed", s6a_router.peers[p].in_flight);
+      s6a_router.peers[p].open = open[p];
+      s6a_router.peers[p].current_weight = 0;
+    }
+    nb_open += open[p] ? 1 : 0;
+  }
+  // the requests waiting for an open peer for too long
+  while ((request = STAILQ_FIRST (&s6a_router.queue)) && ((now - request->queued_ns) / 1000000 >= s6a_router.request_timeout_ms)) {
+    STAILQ_REMOVE_HEAD (&s6a_router.queue, entries);
+    s6a_router.queue_depth--;
+    STAILQ_INSERT_TAIL (&failed, request, entries);
+  }
+  s6a_router_drain (&failed);
+  pthread_mutex_unlock (&s6a_router.mutex);
+  s6a_router_fail (&failed);
+  return nb_open;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_router_dump_summary (bstring out, const char * const name, const char * const peer_id, const metrics_histogram_cell_t * const cell,
+                                     metrics_histogram_report_t * const report)
+{
+  static const double                     quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+  report->count = cell->count;
+  report->sum = cell->sum;
+  memcpy (report->buckets, cell->buckets, sizeof (report->buckets));
+  for (int q = 0; q < sizeof (quantiles) / sizeof (quantiles[0]); q++) {
+    bformata (out, "%s{peer=\"%s\",quantile=\"%g\"} %.6f\n", name, peer_id, quantiles[q],
+        (double)metrics_histogram_percentile (report, quantiles[q] * 100.0) / 1000000.0);
+  }
+  bformata (out, "%s_sum{peer=\"%s\"} %.6f\n%s_count{peer=\"%s\"} %" PRIu64 "\n",
+      name, peer_id, (double)report->sum / 1000000.0, name, peer_id, report->count);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Registered as a metrics collector, the values are labelled by peer. The
+ * latencies are exported as summaries, like the ITTI queue wait times.
+ */
+void s6a_router_dump_prometheus (bstring out)
+{
+  metrics_histogram_report_t             *report = malloc (sizeof (metrics_histogram_report_t));
+  s6a_router_peer_t                      *peer = NULL;
+
+  if (!report) {
+    return;
+  }
+  pthread_mutex_lock (&s6a_router.mutex);
+  bformata (out, "# HELP s6a_peer_open 1 if the connection to the HSS peer is open\n# TYPE s6a_peer_open gauge\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    bformata (out, "s6a_peer_open{peer=\"%s\"} %d\n", bdata (s6a_router.peers[p].diameter_id), s6a_router.peers[p].open ? 1 : 0);
+  }
+  bformata (out, "# HELP s6a_peer_in_flight S6a requests sent to the HSS peer waiting for their answer\n# TYPE s6a_peer_in_flight gauge\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    bformata (out, "s6a_peer_in_flight{peer=\"%s\"} %u\n", bdata (s6a_router.peers[p].diameter_id), s6a_router.peers[p].in_flight);
+  }
+  bformata (out, "# HELP s6a_peer_requests_total S6a requests sent to the HSS peer\n# TYPE s6a_peer_requests_total counter\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    bformata (out, "s6a_peer_requests_total{peer=\"%s\"} %" PRIu64 "\n", bdata (s6a_router.peers[p].diameter_id), s6a_router.peers[p].nb_requests);
+  }
+  bformata (out, "# HELP s6a_peer_answers_total S6a answers received from the HSS peer\n# TYPE s6a_peer_answers_total counter\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    bformata (out, "s6a_peer_answers_total{peer=\"%s\"} %" PRIu64 "\n", bdata (s6a_router.peers[p].diameter_id), s6a_router.peers[p].nb_answers);
+  }
+  bformata (out, "# HELP s6a_peer_timeouts_total S6a requests sent to the HSS peer left without answer\n# TYPE s6a_peer_timeouts_total counter\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    bformata (out, "s6a_peer_timeouts_total{peer=\"%s\"} %" PRIu64 "\n", bdata (s6a_router.peers[p].diameter_id), s6a_router.peers[p].nb_timeouts);
+  }
+  bformata (out, "# HELP s6a_peer_round_trip_seconds Time from the S6a request to its answer\n# TYPE s6a_peer_round_trip_seconds summary\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    peer = &s6a_router.peers[p];
+    s6a_router_dump_summary (out, "s6a_peer_round_trip_seconds", bdata (peer->diameter_id), &peer->round_trip, report);
+  }
+  bformata (out, "# HELP s6a_peer_queue_wait_seconds Time spent by the S6a request waiting for a window\n# TYPE s6a_peer_queue_wait_seconds summary\n");
+  for (int p = 0; p < s6a_router.nb_peers; p++) {
+    peer = &s6a_router.peers[p];
+    s6a_router_dump_summary (out, "s6a_peer_queue_wait_seconds", bdata (peer->diameter_id), &peer->queue_wait, report);
+  }
+  bformata (out, "# HELP s6a_queue_depth S6a requests waiting for a window\n# TYPE s6a_queue_depth gauge\ns6a_queue_depth %u\n", s6a_router.queue_depth);
+  bformata (out, "# HELP s6a_requests_rejected_total S6a requests rejected, the queue being full\n# TYPE s6a_requests_rejected_total counter\n"
+      "s6a_requests_rejected_total %" PRIu64 "\n", s6a_router.nb_rejected);
+  bformata (out, "# HELP s6a_failovers_total S6a requests sent again to another peer after a time out\n# TYPE s6a_failovers_total counter\n"
+      "s6a_failovers_total %" PRIu64 "\n", s6a_router.nb_failovers);
+  bformata (out, "# HELP s6a_requests_failed_total S6a requests without answer from any peer, or rejected\n# TYPE s6a_requests_failed_total counter\n"
+      "s6a_requests_failed_total %" PRIu64 "\n", __atomic_load_n (&s6a_router.nb_failed, __ATOMIC_RELAXED));
+  pthread_mutex_unlock (&s6a_router.mutex);
+  free (report);
+}
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_router.h
+  \brief Routing of the S6a requests of the MME to several HSS peers, with
+  per peer in-flight windows, a queue of the requests waiting for a window
+  and fail over of the requests left without answer.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_S6A_ROUTER_SEEN
+#define FILE_S6A_ROUTER_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <freeDiameter/freeDiameter-host.h>
+#include <freeDiameter/libfdcore.h>
+
+#include "bstrlib.h"
+#include "intertask_interface.h"
+#include "mme_config.h"
+#include "s6a_template.h"
+
+/*
+ * A request is sent to an open peer with room in its in-flight window, chosen
+ * by the least outstanding requests per weight or by smooth weighted round
+ * robin. When no peer has room, it waits in a FIFO shared by the peers and is
+ * sent when an answer frees a window or a peer opens. A request without answer
+ * after the request timeout, or answered DIAMETER_UNABLE_TO_DELIVER (by
+ * freeDiameter when its peer is lost) or DIAMETER_TOO_BUSY, is sent again to
+ * a peer it was not sent to, until every open peer has been tried. A request that could not be sent nor queued
+ * is given to the failed handler of its type, so is a request waiting longer
+ * than the request timeout in the queue.
+ *
+ * The answers and the time outs are handled in the threads of freeDiameter,
+ * the router state is protected by a mutex. The answer handler is called
+ * without the mutex held.
+ */
+#define S6A_ROUTER_MAX_PEERS        MME_CONFIG_MAX_HSS_PEERS
+
+typedef enum s6a_request_type_e {
+  S6A_REQUEST_AIR = 0,
+  S6A_REQUEST_ULR,
+  S6A_REQUEST_TYPE_MAX,
+} s6a_request_type_t;
+
+typedef union s6a_request_params_u {
+  s6a_auth_info_req_t                     air;
+  s6a_update_location_req_t               ulr;
+} s6a_request_params_t;
+
+typedef struct s6a_request_handlers_s {
+  // the request towards the peer of the template
+  int  (*build) (const s6a_request_params_t * const params, s6a_request_template_t * const template_p, struct msg ** msg_pP);
+  // a dispatch callback of the answer, the router frees the answer it leaves
+  int  (*answer) (struct msg ** msg_pP, struct avp * paramavp, struct session * sess, void * opaque, enum disp_action * act);
+  // no answer from any peer, or no room in the queue
+  void (*failed) (const s6a_request_params_t * const params);
+} s6a_request_handlers_t;
+
+int  s6a_router_init (const mme_config_t * const config_pP, const s6a_request_handlers_t handlers[S6A_REQUEST_TYPE_MAX]);
+void s6a_router_exit (void);
+
+// builds the templates of the peers once the Diameter identity of the MME is known
+int  s6a_router_set_origin (const char * const origin_host, const size_t origin_host_length);
+
+int  s6a_router_nb_peers (void);
+// Diameter identity of a peer, <host name>.<realm>
+const_bstring s6a_router_peer_id (const int peer);
+
+// polls the state of the peers in freeDiameter, drains the queue towards the peers that opened, returns the number of open peers
+int  s6a_router_check_peers (void);
+
+int  s6a_router_submit (const s6a_request_type_t type, const s6a_request_params_t * const params);
+
+// per peer state, counters and latencies, labelled by peer
+void s6a_router_dump_prometheus (bstring out);
+
+#endif /* FILE_S6A_ROUTER_SEEN */
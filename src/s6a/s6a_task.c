@@ -43,9 +43,12 @@
 
 #define S6A_PEER_CONNECT_TIMEOUT_MICRO_SEC  (0)
 #define S6A_PEER_CONNECT_TIMEOUT_SEC        (1)
+#define S6A_PEER_CHECK_PERIOD_MICRO_SEC     (0)
+#define S6A_PEER_CHECK_PERIOD_SEC           (1)
 
 static int                              gnutls_log_level = 9;
 static long                             timer_id = 0;
+static long                             check_timer_id = 0;
 struct session_handler                 *ts_sess_hdl;
 
 s6a_fd_cnf_t                            s6a_fd_cnf;
@@ -108,6 +111,13 @@ void *s6a_thread (void *args)
       }
       break;
     case TIMER_HAS_EXPIRED:{
+        if ((check_timer_id) && (received_message_p->ittiMsg.timer_has_expired.timer_id == check_timer_id)) {
+          /*
+           * Peers opened or lost, queued requests waiting too long
+           */
+          s6a_router_check_peers ();
+          break;
+        }
         /*
          * Trying to connect to peers
          */
@@ -124,6 +134,10 @@ void *s6a_thread (void *args)
           timer_setup(S6A_PEER_CONNECT_TIMEOUT_SEC,
                       S6A_PEER_CONNECT_TIMEOUT_MICRO_SEC, TASK_S6A,
                       INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
+        } else if (!check_timer_id) {
+          timer_setup(S6A_PEER_CHECK_PERIOD_SEC,
+                      S6A_PEER_CHECK_PERIOD_MICRO_SEC, TASK_S6A,
+                      INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &check_timer_id);
         }
       }
       break;
@@ -236,6 +250,23 @@ int s6a_init (
     OAILOG_DEBUG (LOG_S6A, "s6a_fd_init_dict_objs done\n");
   }
 
+  /*
+   * Routing of the requests to the HSS peers, the answers are parsed by the
+   * same callbacks as the ones registered for the dispatch
+   */
+  {
+    const s6a_request_handlers_t            handlers[S6A_REQUEST_TYPE_MAX] = {
+      [S6A_REQUEST_AIR] = {s6a_build_authentication_info_req, s6a_aia_cb, s6a_authentication_info_req_failed},
+      [S6A_REQUEST_ULR] = {s6a_build_update_location, s6a_ula_cb, s6a_update_location_failed},
+    };
+
+    ret = s6a_router_init (mme_config_p, handlers);
+    if (ret) {
+      OAILOG_ERROR (LOG_S6A, "An error occurred during s6a_router_init.\n");
+      return ret;
+    }
+  }
+
   if (itti_create_task (TASK_S6A, &s6a_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S6A, "s6a create task\n");
     return RETURNerror;
@@ -255,6 +286,10 @@ static void s6a_exit(void)
   if (timer_id) {
     timer_remove(timer_id);
   }
+  if (check_timer_id) {
+    timer_remove(check_timer_id);
+    check_timer_id = 0;
+  }
   // Release all resources
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
@@ -270,4 +305,5 @@ static void s6a_exit(void)
   if (rv) {
     OAI_FPRINTF_ERR ("An error occurred during fd_core_wait_shutdown_complete().\n");
   }
+  s6a_router_exit ();
 }
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_template.c
+  \brief Per peer templates of the S6a requests of the MME.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "mme_config_snapshot.h"
+#include "s6a_defs.h"
+#include "s6a_template.h"
+
+#define S6A_SESSION_ID_OPTIONAL_VALUE   "apps6a"
+
+// <high 32 bits><low 32 bits> of the Session-Ids, the high part starts at the startup time as in freeDiameter
+static uint64_t                         s6a_session_id_counter = 0;
+
+//------------------------------------------------------------------------------
+static int s6a_add_os_avp (struct msg * const msg_p, struct dict_object * const model, const uint8_t * const data, const size_t length)
+{
+  struct avp                             *avp_p = NULL;
+  union avp_value                         value;
+
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp_p));
+  value.os.data = (uint8_t *)data;
+  value.os.len = length;
+  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
+  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+s6a_request_template_t *s6a_request_template_create (const char * const origin_host, const size_t origin_host_length,
+                                                     const_bstring destination_host, const_bstring destination_realm)
+{
+  s6a_request_template_t                 *template_p = NULL;
+  uint64_t                                unset = 0;
+
+  if ((!origin_host) || (origin_host_length + 1 + 2 * 11 + sizeof (S6A_SESSION_ID_OPTIONAL_VALUE) > S6A_SESSION_ID_MAX_LENGTH)) {
+    OAILOG_ERROR (LOG_S6A, "Bad Diameter identity of the MME for the Session-Id\n");
+    return NULL;
+  }
+  template_p = calloc (1, sizeof (s6a_request_template_t));
+  template_p->destination_host = bstrcpy (destination_host);
+  template_p->destination_realm = bstrcpy (destination_realm);
+  memcpy (template_p->session_id, origin_host, origin_host_length);
+  template_p->session_id[origin_host_length] = ';';
+  template_p->session_id_prefix_length = origin_host_length + 1;
+  // unique across restarts of the MME, set by the first template
+  __atomic_compare_exchange_n (&s6a_session_id_counter, &unset, ((uint64_t)(uint32_t)time (NULL)) << 32,
+                               false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  OAILOG_DEBUG (LOG_S6A, "S6a request template for %s realm %s\n", bdata (template_p->destination_host), bdata (template_p->destination_realm));
+  return template_p;
+}
+
+//------------------------------------------------------------------------------
+void s6a_request_template_destroy (s6a_request_template_t ** template_pP)
+{
+  if ((template_pP) && (*template_pP)) {
+    bdestroy ((*template_pP)->destination_host);
+    bdestroy ((*template_pP)->destination_realm);
+    free_wrapper ((void **)template_pP);
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_request_template_new (s6a_request_template_t * const template_p, struct dict_object * const command,
+                              const char * const imsi, struct msg ** msg_pP)
+{
+  struct msg                             *msg_p = NULL;
+  struct avp                             *avp_p = NULL;
+  union avp_value                         value;
+  uint64_t                                session_id = 0;
+  int                                     length = 0;
+
+  DevAssert (template_p);
+  CHECK_FCT (fd_msg_new (command, 0, &msg_p));
+  /*
+   * Session-Id first
+   */
+  session_id = __atomic_add_fetch (&s6a_session_id_counter, 1, __ATOMIC_RELAXED);
+  length = snprintf (&template_p->session_id[template_p->session_id_prefix_length],
+                     S6A_SESSION_ID_MAX_LENGTH - template_p->session_id_prefix_length,
+                     "%u;%u;" S6A_SESSION_ID_OPTIONAL_VALUE, (uint32_t)(session_id >> 32), (uint32_t)session_id);
+  CHECK_FCT (s6a_add_os_avp (msg_p, s6a_fd_cnf.dataobj_s6a_session_id, (uint8_t *)template_p->session_id,
+                             template_p->session_id_prefix_length + length));
+  /*
+   * No State maintained
+   */
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp_p));
+  value.i32 = 1;
+  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
+  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+  CHECK_FCT (fd_msg_add_origin (msg_p, 0));
+  CHECK_FCT (s6a_add_os_avp (msg_p, s6a_fd_cnf.dataobj_s6a_destination_host,
+                             (uint8_t *)bdata (template_p->destination_host), blength (template_p->destination_host)));
+  CHECK_FCT (s6a_add_os_avp (msg_p, s6a_fd_cnf.dataobj_s6a_destination_realm,
+                             (uint8_t *)bdata (template_p->destination_realm), blength (template_p->destination_realm)));
+  CHECK_FCT (s6a_add_os_avp (msg_p, s6a_fd_cnf.dataobj_s6a_user_name, (const uint8_t *)imsi, strlen (imsi)));
+  *msg_pP = msg_p;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int s6a_request_template_add_visited_plmn (s6a_request_template_t * const template_p, struct msg * const msg_p,
+                                           const plmn_t * const plmn_p)
+{
+  const mme_config_snapshot_t            *snapshot = mme_config_snapshot_acquire ();
+
+  // the MNC length of a PLMN is the one of the TAI list, it may change on a reload only
+  if ((!template_p->visited_plmn_valid) || (template_p->visited_plmn_generation != snapshot->generation)
+      || memcmp (&template_p->visited_plmn, plmn_p, sizeof (plmn_t))) {
+    const uint16_t                          mcc = 100 * plmn_p->mcc_digit1 + 10 * plmn_p->mcc_digit2 + plmn_p->mcc_digit3;
+    const uint16_t                          mnc2 = 10 * plmn_p->mnc_digit1 + plmn_p->mnc_digit2;
+    const uint16_t                          mnc3 = 100 * plmn_p->mnc_digit1 + 10 * plmn_p->mnc_digit2 + plmn_p->mnc_digit3;
+
+    PLMN_T_TO_TBCD ((*plmn_p), template_p->visited_plmn_tbcd, mme_config_snapshot_mnc_length (snapshot, mcc, mnc2, mnc3));
+    template_p->visited_plmn = *plmn_p;
+    template_p->visited_plmn_generation = snapshot->generation;
+    template_p->visited_plmn_valid = true;
+  }
+  mme_config_snapshot_release ();
+  return s6a_add_os_avp (msg_p, s6a_fd_cnf.dataobj_s6a_visited_plmn_id, template_p->visited_plmn_tbcd, sizeof (template_p->visited_plmn_tbcd));
+}
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_template.h
+  \brief Per peer templates of the S6a requests of the MME: the AVPs that do
+  not depend on the UE are computed once when the peer is set up, the ULR and
+  the AIR only add the User-Name, the Session-Id and their own AVPs.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_S6A_TEMPLATE_SEEN
+#define FILE_S6A_TEMPLATE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <freeDiameter/freeDiameter-host.h>
+#include <freeDiameter/libfdcore.h>
+
+#include "bstrlib.h"
+#include "3gpp_23.003.h"
+
+// "<DiameterIdentity>;<high 32 bits>;<low 32 bits>;apps6a", RFC 6733 section 8.8
+#define S6A_SESSION_ID_MAX_LENGTH   (256 + 2 * 11 + 8)
+
+/*
+ * A template is owned by the S6A task, the only one generating requests, and
+ * is not locked. The Session-Ids are generated from a counter instead of
+ * fd_sess_new(): the MME keeps no state per S6a session, a session object in
+ * the freeDiameter session table is only created by the dispatch of the answer.
+ * The counter is shared by the templates of all the peers, the Session-Ids of
+ * the MME are unique whatever the peer they are sent to.
+ */
+typedef struct s6a_request_template_s {
+  bstring                         destination_host;       // Diameter identity of the HSS
+  bstring                         destination_realm;
+  char                            session_id[S6A_SESSION_ID_MAX_LENGTH];
+  size_t                          session_id_prefix_length;  // "<DiameterIdentity>;"
+
+  // Visited-PLMN-Id of the last request, valid for a configuration snapshot
+  bool                            visited_plmn_valid;
+  uint64_t                        visited_plmn_generation;
+  plmn_t                          visited_plmn;
+  uint8_t                         visited_plmn_tbcd[3];
+} s6a_request_template_t;
+
+// the origin is the Diameter identity of the MME
+s6a_request_template_t *s6a_request_template_create (const char * const origin_host, const size_t origin_host_length,
+                                                     const_bstring destination_host, const_bstring destination_realm);
+void s6a_request_template_destroy (s6a_request_template_t ** template_pP);
+
+// new request with Session-Id, Auth-Session-State, Origin-Host/Realm, Destination-Host/Realm and User-Name
+int s6a_request_template_new (s6a_request_template_t * const template_p, struct dict_object * const command,
+                              const char * const imsi, struct msg ** msg_pP);
+// Visited-PLMN-Id in TBCD, the MNC length being the one of the served PLMN
+int s6a_request_template_add_visited_plmn (s6a_request_template_t * const template_p, struct msg * const msg_p,
+                                           const plmn_t * const plmn_p);
+
+#endif /* FILE_S6A_TEMPLATE_SEEN */
@@ -31,6 +31,9 @@
 #include "s6a_messages.h"
 #include "msc.h"
 #include "log.h"
+#include "mme_app_shard.h"
+#include "mme_app_statistics.h"
+#include "mme_config_snapshot.h"
 
 
 int
@@ -53,6 +56,8 @@ s6a_ula_cb (
   /*
    * Retrieve the original query associated with the asnwer
    */
+  // the request is answered whatever the content of the answer
+  update_mme_app_stats_s6a_request_sub ();
   CHECK_FCT (fd_msg_answ_getq (ans_p, &qry_p));
   DevAssert (qry_p );
   message_p = itti_alloc_new_message (TASK_S6A, S6A_UPDATE_LOCATION_ANS);
@@ -144,7 +149,7 @@ s6a_ula_cb (
 
 err:
   ans_p = NULL;
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (mme_app_task_of_imsi (s6a_update_location_ans_p->imsi), INSTANCE_DEFAULT, message_p);
   OAILOG_DEBUG (LOG_S6A, "Sending S6A_UPDATE_LOCATION_ANS to task MME_APP\n");
   return RETURNok;
 }
@@ -152,98 +157,30 @@ err:
 
 
 int
-s6a_generate_update_location (
-  s6a_update_location_req_t * ulr_pP)
+s6a_build_update_location (
+  const s6a_request_params_t * params,
+  s6a_request_template_t * template_p,
+  struct msg **msg_pP)
 {
+  const s6a_update_location_req_t        *ulr_pP = &params->ulr;
   struct avp                             *avp_p = NULL;
   struct msg                             *msg_p = NULL;
-  struct session                         *sess_p = NULL;
   union avp_value                         value;
 
-  DevAssert (ulr_pP );
-  /*
-   * Create the new update location request message
-   */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, 0, &msg_p));
-  /*
-   * Create a new session
-   */
-  CHECK_FCT (fd_sess_new (&sess_p, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
-  {
-    os0_t                                   sid;
-    size_t                                  sidlen;
-
-    CHECK_FCT (fd_sess_getsid (sess_p, &sid, &sidlen));
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp_p));
-    value.os.data = sid;
-    value.os.len = sidlen;
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_FIRST_CHILD, avp_p));
-  }
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_auth_session_state, 0, &avp_p));
-  /*
-   * No State maintained
-   */
-  value.i32 = 1;
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  /*
-   * Add Origin_Host & Origin_Realm
-   */
-  CHECK_FCT (fd_msg_add_origin (msg_p, 0));
-  mme_config_read_lock (&mme_config);
-  /*
-   * Destination Host
-   */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp_p));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-    bdestroy(host);
-  }
-  /*
-   * Destination_Realm
-   */
-  {
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_realm, 0, &avp_p));
-    value.os.data = (unsigned char *)bdata(mme_config.realm);
-    value.os.len = blength(mme_config.realm);
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  }
-  mme_config_unlock (&mme_config);
   /*
-   * Adding the User-Name (IMSI)
+   * Create the new update location request message with the AVPs of the template
+   * of the peer and the User-Name (IMSI)
    */
-  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_user_name, 0, &avp_p));
-  value.os.data = (unsigned char *)ulr_pP->imsi;
-  value.os.len = strlen (ulr_pP->imsi);
-  CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-  CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+  CHECK_FCT (s6a_request_template_new (template_p, s6a_fd_cnf.dataobj_s6a_ulr, ulr_pP->imsi, &msg_p));
   /*
-   * Adding the visited plmn id
+   * Adding the visited plmn id, the one of the first served GUMMEI
    */
   {
-    uint8_t                                 plmn[3];
-    plmn_t                                  plmn_mme;
+    const mme_config_snapshot_t            *snapshot = mme_config_snapshot_acquire ();
+    plmn_t                                  plmn_mme = snapshot->gummei[0].plmn;
 
-    plmn_mme = mme_config.gummei.gummei[0].plmn;
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_visited_plmn_id, 0, &avp_p));
-    PLMN_T_TO_TBCD (plmn_mme,
-                    plmn,
-                    mme_config_find_mnc_length (plmn_mme.mcc_digit1, plmn_mme.mcc_digit2, plmn_mme.mcc_digit3, plmn_mme.mnc_digit1, plmn_mme.mnc_digit2, plmn_mme.mnc_digit3)
-      );
-    value.os.data = plmn;
-    value.os.len = 3;
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
+    mme_config_snapshot_release ();
+    CHECK_FCT (s6a_request_template_add_visited_plmn (template_p, msg_p, &plmn_mme));
   }
   /*
    * Adding the RAT-Type
@@ -276,7 +213,41 @@ s6a_generate_update_location (
 
   CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
   CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  CHECK_FCT (fd_msg_send (&msg_p, NULL, NULL));
+  *msg_pP = msg_p;
   OAILOG_DEBUG (LOG_S6A, "Sending s6a ulr for imsi=%s\n", ulr_pP->imsi);
   return RETURNok;
 }
+
+void
+s6a_update_location_failed (
+  const s6a_request_params_t * params)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_update_location_ans_t              *s6a_update_location_ans_p = NULL;
+
+  /*
+   * No HSS peer answered, MME_APP is answered as if the HSS could not be reached
+   */
+  OAILOG_ERROR (LOG_S6A, "No answer to the ulr for imsi=%s\n", params->ulr.imsi);
+  update_mme_app_stats_s6a_request_sub ();
+  message_p = itti_alloc_new_message (TASK_S6A, S6A_UPDATE_LOCATION_ANS);
+  s6a_update_location_ans_p = &message_p->ittiMsg.s6a_update_location_ans;
+  memset (s6a_update_location_ans_p, 0, sizeof (s6a_update_location_ans_t));
+  snprintf (s6a_update_location_ans_p->imsi, sizeof (s6a_update_location_ans_p->imsi), "%s", params->ulr.imsi);
+  s6a_update_location_ans_p->imsi_length = strlen (s6a_update_location_ans_p->imsi);
+  s6a_update_location_ans_p->result.present = S6A_RESULT_BASE;
+  s6a_update_location_ans_p->result.choice.base = DIAMETER_UNABLE_TO_DELIVER;
+  itti_send_msg_to_task (mme_app_task_of_imsi (s6a_update_location_ans_p->imsi), INSTANCE_DEFAULT, message_p);
+}
+
+int
+s6a_generate_update_location (
+  s6a_update_location_req_t * ulr_pP)
+{
+  s6a_request_params_t                    params;
+
+  DevAssert (ulr_pP );
+  params.ulr = *ulr_pP;
+  update_mme_app_stats_s6a_request_add ();
+  return s6a_router_submit (S6A_REQUEST_ULR, &params);
+}
@@ -40,7 +40,6 @@ nas_stream_encrypt_eea2 (
   uint8_t                                 m[16];
   uint32_t                                local_count;
   void                                   *ctx;
-  uint8_t                                *data;
   uint32_t                                zero_bit = 0;
   uint32_t                                byte_length;
 
@@ -53,7 +52,6 @@ nas_stream_encrypt_eea2 (
     byte_length += 1;
 
   ctx = malloc (nettle_aes128.context_size);
-  data = malloc (byte_length);
   local_count = hton_int32 (stream_cipher->count);
   memset (m, 0, sizeof (m));
   memcpy (&m[0], &local_count, 4);
@@ -68,13 +66,12 @@ nas_stream_encrypt_eea2 (
   nettle_aes128.set_encrypt_key(ctx,
                                 stream_cipher->key);
 #endif
-  nettle_ctr_crypt (ctx, nettle_aes128.encrypt, nettle_aes128.block_size, m, byte_length, data, stream_cipher->message);
+  // straight into out, which may be the message itself
+  nettle_ctr_crypt (ctx, nettle_aes128.encrypt, nettle_aes128.block_size, m, byte_length, out, stream_cipher->message);
 
   if (zero_bit > 0)
-    data[byte_length - 1] = data[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
+    out[byte_length - 1] = out[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
 
-  memcpy (out, data, byte_length);
-  free_wrapper ((void**) &data);
   free_wrapper (&ctx);
   return 0;
 }
@@ -50,7 +50,7 @@ nas_stream_encrypt_eia2 (
   nas_stream_cipher_t * const stream_cipher,
   uint8_t const out[4])
 {
-  uint8_t                                *m = NULL;
+  uint8_t                                 m[8] = {0};
   uint32_t                                local_count = 0;
   size_t                                  size = 4;
   uint8_t                                 data[16] = {0};
@@ -69,24 +69,26 @@ nas_stream_encrypt_eia2 (
   if (zero_bit > 0)
     m_length += 1;
 
+  /*
+   * The CMAC runs over COUNT | BEARER | DIRECTION | 0 followed by the message,
+   * fed in two updates rather than copied after the 8 bytes of prefix.
+   */
   local_count = hton_int32 (stream_cipher->count);
-  m = calloc (m_length + 8, sizeof (uint8_t));
   memcpy (&m[0], &local_count, 4);
   m[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
-  memcpy (&m[8], stream_cipher->message, m_length);
 
   OAILOG_TRACE (LOG_NAS, "Byte length: %u, Zero bits: %u:\n", m_length + 8, zero_bit);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "m:", m, m_length + 8);
+  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "m:", m, sizeof (m));
   OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Key:", stream_cipher->key, stream_cipher->key_length);
   OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Message:", stream_cipher->message, m_length);
 
   cmac_ctx = CMAC_CTX_new ();
   CMAC_Init (cmac_ctx, stream_cipher->key, stream_cipher->key_length, cipher, NULL);
-  CMAC_Update (cmac_ctx, m, m_length + 8);
+  CMAC_Update (cmac_ctx, m, sizeof (m));
+  CMAC_Update (cmac_ctx, stream_cipher->message, m_length);
   CMAC_Final (cmac_ctx, data, &size);
   CMAC_CTX_free (cmac_ctx);
   OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Out:", data, size);
   memcpy ((void*)out, data, 4);
-  free_wrapper ((void**) &m);
   return 0;
 }
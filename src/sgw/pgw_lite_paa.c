@@ -46,6 +46,7 @@
 #include "sgw_defs.h"
 #include "spgw_config.h"
 #include "sgw.h"
+#include "sgw_shard.h"
 #include "pgw_lite_paa.h"
 
 
@@ -61,16 +62,21 @@ pgw_load_pool_ip_addresses (
 {
   struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
   struct ipv4_list_elm_s        *ipv4_p = NULL;
+  int                            shard = 0;
   //struct conf_ipv6_list_elm_s   *conf_ipv6_p = NULL;
   //struct ipv6_list_elm_s        *ipv6_p = NULL;
   //char                           print_buffer[INET6_ADDRSTRLEN];
 
-  STAILQ_INIT (&pgw_app.ipv4_list_free);
-  STAILQ_INIT (&pgw_app.ipv4_list_allocated);
+  for (int i = 0; i < SGW_MAX_WORKERS; i++) {
+    STAILQ_INIT (&pgw_app.ipv4_pool_slices[i].ipv4_list_free);
+    STAILQ_INIT (&pgw_app.ipv4_pool_slices[i].ipv4_list_allocated);
+  }
+  // addresses are dealt round robin to the slices of the SPGW_APP shards
   STAILQ_FOREACH (conf_ipv4_p, &spgw_config.pgw_config.ipv4_pool_list, ipv4_entries) {
     ipv4_p = calloc (1, sizeof (struct ipv4_list_elm_s));
     ipv4_p->addr.s_addr = ntohl (conf_ipv4_p->addr.s_addr);
-    STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
+    STAILQ_INSERT_TAIL (&pgw_app.ipv4_pool_slices[shard].ipv4_list_free, ipv4_p, ipv4_entries);
+    shard = (shard + 1) % sgw_nb_workers;
     //SPGW_APP_DEBUG("Loaded IPv4 PAA address in pool: %s\n",
     //        inet_ntoa(conf_ipv4_p->addr));
   }
@@ -105,16 +111,17 @@ int
 pgw_get_free_ipv4_paa_address (
   struct in_addr *const addr_pP)
 {
+  pgw_ipv4_pool_slice_t         *slice = &pgw_app.ipv4_pool_slices[sgw_current_shard];
   struct ipv4_list_elm_s        *ipv4_p = NULL;
 
-  if (STAILQ_EMPTY (&pgw_app.ipv4_list_free)) {
+  if (STAILQ_EMPTY (&slice->ipv4_list_free)) {
     addr_pP->s_addr = INADDR_ANY;
     return RETURNerror;
   }
 
-  ipv4_p = STAILQ_FIRST (&pgw_app.ipv4_list_free);
-  STAILQ_REMOVE (&pgw_app.ipv4_list_free, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-  STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_entries);
+  ipv4_p = STAILQ_FIRST (&slice->ipv4_list_free);
+  STAILQ_REMOVE_HEAD (&slice->ipv4_list_free, ipv4_entries);
+  STAILQ_INSERT_TAIL (&slice->ipv4_list_allocated, ipv4_p, ipv4_entries);
   addr_pP->s_addr = ipv4_p->addr.s_addr;
   return RETURNok;
 }
@@ -123,12 +130,14 @@ int
 pgw_release_free_ipv4_paa_address (
   const struct in_addr *const addr_pP)
 {
+  // the session is released by the shard which allocated its address
+  pgw_ipv4_pool_slice_t         *slice = &pgw_app.ipv4_pool_slices[sgw_current_shard];
   struct ipv4_list_elm_s        *ipv4_p = NULL;
 
-  STAILQ_FOREACH (ipv4_p, &pgw_app.ipv4_list_allocated, ipv4_entries) {
+  STAILQ_FOREACH (ipv4_p, &slice->ipv4_list_allocated, ipv4_entries) {
     if (ipv4_p->addr.s_addr == addr_pP->s_addr) {
-      STAILQ_REMOVE (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-      STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
+      STAILQ_REMOVE (&slice->ipv4_list_allocated, ipv4_p, ipv4_list_elm_s, ipv4_entries);
+      STAILQ_INSERT_TAIL (&slice->ipv4_list_free, ipv4_p, ipv4_entries);
       return RETURNok;
     }
   }
@@ -32,6 +32,9 @@
 #include <netinet/in.h>
 #include "bstrlib.h"
 #include "hashtable.h"
+#include "id_index.h"
+#include "slab_pool.h"
+#include "sgw_shard.h"
 #include "queue.h"
 #include "commonDef.h"
 #include "common_types.h"
@@ -49,13 +52,18 @@ typedef struct sgw_app_s {
   ipv4_nbo_t sgw_ip_address_S5_S8_up; // unused now
 
   // key is S11 S-GW local teid
-  hash_table_ts_t *s11teid2mme_hashtable;
+  id_index_t *s11teid2mme;
 
   // key is S1-U S-GW local teid
   //hash_table_t *s1uteid2enb_hashtable;
 
-  // the key of this hashtable is the S11 s-gw local teid.
-  hash_table_ts_t *s11_bearer_context_information_hashtable;
+  // the key of this index is the S11 s-gw local teid.
+  id_index_t *s11_bearer_context_information;
+
+  // s_plus_p_gw_eps_bearer_context_information_t, their default bearer is embedded
+  slab_pool_t *bearer_context_information_pool;
+  // sgw_eps_bearer_entry_t of the other bearers
+  slab_pool_t *eps_bearer_entry_pool;
 
   gtpv1u_data_t    gtpv1u_data;
 } sgw_app_t;
@@ -67,9 +75,14 @@ struct ipv4_list_elm_s {
 };
 
 
-typedef struct pgw_app_s {
+// UE IPv4 addresses of a SPGW_APP shard, only used by this shard
+typedef struct pgw_ipv4_pool_slice_s {
   STAILQ_HEAD(ipv4_list_free_head_s,     ipv4_list_elm_s) ipv4_list_free;
   STAILQ_HEAD(pv4_list_allocated_head_s, ipv4_list_elm_s) ipv4_list_allocated;
+} __attribute__ ((aligned (64))) pgw_ipv4_pool_slice_t;
+
+typedef struct pgw_app_s {
+  pgw_ipv4_pool_slice_t ipv4_pool_slices[SGW_MAX_WORKERS];
 } pgw_app_t;
 
 #endif
@@ -62,6 +62,7 @@ void sgw_config_init (sgw_config_t * config_pP)
 {
   memset(config_pP, 0, sizeof(*config_pP));
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
+  config_pP->nb_workers = 1;
 }
 //------------------------------------------------------------------------------
 int sgw_config_process (sgw_config_t * config_pP)
@@ -83,6 +84,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   char                                   *sgw_if_name_S11 = NULL;
   char                                   *S11 = NULL;
   libconfig_int                           sgw_udp_port_S1u_S12_S4_up = 2152;
+  libconfig_int                           nb_workers = 1;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
   bstring                                 address = NULL;
@@ -187,6 +189,10 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
     }
     OAILOG_SET_CONFIG(&config_pP->log_config);
 
+    if (config_setting_lookup_int (setting_sgw, SGW_CONFIG_STRING_WORKERS, &nb_workers)) {
+      config_pP->nb_workers = (uint32_t)nb_workers;
+    }
+
     subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_NETWORK_INTERFACES_CONFIG);
 
     if (subsetting) {
@@ -270,6 +276,7 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- S11:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    S11 iface ............: %s\n", bdata(config_p->ipv4.if_name_S11));
   OAILOG_INFO (LOG_SPGW_APP, "    S11 ip ...............: %s/%u\n", inet_ntoa (*((struct in_addr *)&config_p->ipv4.S11)), config_p->ipv4.netmask_S11);
+  OAILOG_INFO (LOG_SPGW_APP, "- Workers ..............: %u\n", config_p->nb_workers);
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
   OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
@@ -44,6 +44,7 @@
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S5_S8_UP         "SGW_IPV4_ADDRESS_FOR_S5_S8_UP"
 #define SGW_CONFIG_STRING_SGW_INTERFACE_NAME_FOR_S11            "SGW_INTERFACE_NAME_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
+#define SGW_CONFIG_STRING_WORKERS                               "WORKERS"
 
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
@@ -74,6 +75,8 @@ typedef struct sgw_config_s {
 
   bool         local_to_eNB;
 
+  uint32_t     nb_workers;                      // SPGW_APP tasks, sessions are sharded on them
+
   log_config_t log_config;
 
   bstring      config_file;
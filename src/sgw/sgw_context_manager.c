@@ -48,6 +48,7 @@
 #include "sgw_defs.h"
 #include "sgw_context_manager.h"
 #include "sgw.h"
+#include "sgw_shard.h"
 
 extern sgw_app_t                        sgw_app;
 
@@ -81,29 +82,24 @@ sgw_display_s11teid2mme_mappings (
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "| MME <--- S11 TE ID MAPPINGS ---> SGW |\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
-  hashtable_ts_apply_callback_on_elements (sgw_app.s11teid2mme_hashtable, sgw_display_s11teid2mme_mapping, NULL, NULL);
+  id_index_apply_callback_on_elements (sgw_app.s11teid2mme, sgw_display_s11teid2mme_mapping, NULL, NULL);
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
 }
 
 //-----------------------------------------------------------------------------
-static bool
+static void
 sgw_display_pdn_connection_sgw_eps_bearers (
-  uint64_t keyP,
-  void *dataP,
-  void *unused_parameterP,
-  void **unused_resultP)
+  const sgw_pdn_connection_t * const pdn_connectionP)
 //-----------------------------------------------------------------------------
 {
   sgw_eps_bearer_entry_t                 *eps_bearer_entry = NULL;
 
-  if (dataP ) {
-    eps_bearer_entry = (sgw_eps_bearer_entry_t *) dataP;
-    OAILOG_DEBUG (LOG_SPGW_APP, "|\t\t\t\t%" PRId64 "\t<-> ebi: %u, enb_teid_for_S1u: %u, s_gw_teid_for_S1u_S12_S4_up: %u (tbc)\n",
-                    keyP, eps_bearer_entry->eps_bearer_id, eps_bearer_entry->enb_teid_S1u, eps_bearer_entry->s_gw_teid_S1u_S12_S4_up);
-  } else {
-    OAILOG_DEBUG (LOG_SPGW_APP, "\t\t\t\tINVALID eps_bearer_entry FOUND\n");
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if ((eps_bearer_entry = pdn_connectionP->sgw_eps_bearers[i])) {
+      OAILOG_DEBUG (LOG_SPGW_APP, "|\t\t\t\t%d\t<-> ebi: %u, enb_teid_for_S1u: %u, s_gw_teid_for_S1u_S12_S4_up: %u (tbc)\n",
+                      i, eps_bearer_entry->eps_bearer_id, eps_bearer_entry->enb_teid_S1u, eps_bearer_entry->s_gw_teid_S1u_S12_S4_up);
+    }
   }
-  return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -116,7 +112,6 @@ sgw_display_s11_bearer_context_information (
 //-----------------------------------------------------------------------------
 {
   s_plus_p_gw_eps_bearer_context_information_t *sp_context_information = NULL;
-  hashtable_rc_t                                hash_rc = HASH_TABLE_OK;
 
   if (dataP ) {
     sp_context_information = (s_plus_p_gw_eps_bearer_context_information_t *) dataP;
@@ -134,12 +129,7 @@ sgw_display_s11_bearer_context_information (
     OAILOG_DEBUG (LOG_SPGW_APP, "|\t\t\tapn_in_use:        %s\n", sp_context_information->sgw_eps_bearer_context_information.pdn_connection.apn_in_use);
     OAILOG_DEBUG (LOG_SPGW_APP, "|\t\t\tdefault_bearer:    %u\n", sp_context_information->sgw_eps_bearer_context_information.pdn_connection.default_bearer);
     OAILOG_DEBUG (LOG_SPGW_APP, "|\t\t\teps_bearers:\n");
-    hash_rc = hashtable_ts_apply_callback_on_elements (sp_context_information->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
-                                                       sgw_display_pdn_connection_sgw_eps_bearers, NULL, NULL);
-
-    if (HASH_TABLE_OK != hash_rc) {
-      OAILOG_DEBUG (LOG_SPGW_APP, "Invalid sgw_eps_bearers hashtable for display\n");
-    }
+    sgw_display_pdn_connection_sgw_eps_bearers (&sp_context_information->sgw_eps_bearer_context_information.pdn_connection);
     //void                  *trxn;
     //uint32_t               peer_ip;
   } else {
@@ -157,7 +147,7 @@ sgw_display_s11_bearer_context_information_mapping (
   OAILOG_DEBUG (LOG_SPGW_APP, "+-----------------------------------------+\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "| S11 BEARER CONTEXT INFORMATION MAPPINGS |\n");
   OAILOG_DEBUG (LOG_SPGW_APP, "+-----------------------------------------+\n");
-  hashtable_ts_apply_callback_on_elements (sgw_app.s11_bearer_context_information_hashtable, sgw_display_s11_bearer_context_information, NULL, NULL);
+  id_index_apply_callback_on_elements (sgw_app.s11_bearer_context_information, sgw_display_s11_bearer_context_information, NULL, NULL);
   OAILOG_DEBUG (LOG_SPGW_APP, "+--------------------------------------+\n");
 }
 
@@ -181,10 +171,7 @@ sgw_get_new_S11_tunnel_id (
 //-----------------------------------------------------------------------------
 {
   // TO DO: RANDOM
-  static teid_t                           tunnel_id = 0;
-
-  tunnel_id += 1;
-  return tunnel_id;
+  return sgw_shard_new_s11_teid ();
 }
 
 //-----------------------------------------------------------------------------
@@ -195,6 +182,7 @@ sgw_cm_create_s11_tunnel (
 //-----------------------------------------------------------------------------
 {
   mme_sgw_tunnel_t                       *new_tunnel = NULL;
+  hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
 
   new_tunnel = calloc (1, sizeof (mme_sgw_tunnel_t));
 
@@ -212,7 +200,12 @@ sgw_cm_create_s11_tunnel (
    * Trying to insert the new tunnel into the tree.
    * * * * If collision_p is not NULL (0), it means tunnel is already present.
    */
-  hashtable_ts_insert (sgw_app.s11teid2mme_hashtable, local_teid, new_tunnel);
+  hash_rc = id_index_insert (sgw_app.s11teid2mme, local_teid, new_tunnel);
+  if (HASH_TABLE_OK != hash_rc) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Failed to index tunnel for local_teid %u\n", local_teid);
+    free_wrapper ((void**) &new_tunnel);
+    return NULL;
+  }
   return new_tunnel;
 }
 
@@ -224,7 +217,11 @@ sgw_cm_remove_s11_tunnel (
 {
   int                                     temp = 0;
 
-  temp = hashtable_ts_free (sgw_app.s11teid2mme_hashtable, local_teid);
+  temp = id_index_free (sgw_app.s11teid2mme, local_teid);
+  // the tunnel owns the local TEID, the bearer context information is removed first
+  if (HASH_TABLE_OK == temp) {
+    sgw_shard_release_s11_teid (local_teid);
+  }
   return temp;
 }
 
@@ -236,7 +233,7 @@ sgw_cm_create_eps_bearer_entry (
 {
   sgw_eps_bearer_entry_t                 *eps_bearer_entry = NULL;
 
-  eps_bearer_entry = calloc (1, sizeof (sgw_eps_bearer_entry_t));
+  eps_bearer_entry = slab_pool_alloc (sgw_app.eps_bearer_entry_pool);
 
   if (eps_bearer_entry == NULL) {
     /*
@@ -268,17 +265,6 @@ sgw_cm_create_pdn_connection (
     return NULL;
   }
 
-  bstring b = bfromcstr("sgw_eps_bearers");
-  pdn_connection->sgw_eps_bearers = hashtable_ts_create (12, NULL, NULL, b);
-  bdestroy(b);
-
-  if (pdn_connection->sgw_eps_bearers == NULL) {
-    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create eps bearers collection object\n");
-    free_wrapper ((void**) &pdn_connection);
-    pdn_connection = NULL;
-    return NULL;
-  }
-
   return pdn_connection;
 }
 
@@ -288,13 +274,24 @@ sgw_cm_free_pdn_connection (
   sgw_pdn_connection_t ** pdn_connectionP)
 //-----------------------------------------------------------------------------
 {
-  if (pdn_connectionP ) {
-    if ((*pdn_connectionP)->sgw_eps_bearers ) {
-      hashtable_ts_destroy ((*pdn_connectionP)->sgw_eps_bearers);
-    }
+  if ((pdn_connectionP) && (*pdn_connectionP)) {
+    sgw_cm_free_pdn_connection_content (*pdn_connectionP);
+    free_wrapper ((void**) pdn_connectionP);
   }
 }
 
+//-----------------------------------------------------------------------------
+void
+sgw_cm_free_pdn_connection_content (
+  sgw_pdn_connection_t * const pdn_connectionP)
+//-----------------------------------------------------------------------------
+{
+  for (ebi_t ebi = EPS_BEARER_IDENTITY_FIRST; ebi <= EPS_BEARER_IDENTITY_LAST; ebi++) {
+    sgw_cm_remove_eps_bearer_entry (pdn_connectionP, ebi);
+  }
+  free_wrapper ((void**) &pdn_connectionP->apn_in_use);
+}
+
 //-----------------------------------------------------------------------------
 void
 sgw_cm_free_s_plus_p_gw_eps_bearer_context_information (
@@ -305,20 +302,13 @@ sgw_cm_free_s_plus_p_gw_eps_bearer_context_information (
     return;
   }
 
-  /*
-   * if (contextP->sgw_eps_bearer_context_information.pdn_connections ) {
-   * obj_hashtable_ts_destroy(contextP->sgw_eps_bearer_context_information.pdn_connections);
-   * }
-   */
-  if ((*contextP)->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers ) {
-    hashtable_ts_destroy ((*contextP)->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers);
-  }
+  sgw_cm_free_pdn_connection_content (&(*contextP)->sgw_eps_bearer_context_information.pdn_connection);
 
   if ((*contextP)->pgw_eps_bearer_context_information.apns ) {
     obj_hashtable_ts_destroy ((*contextP)->pgw_eps_bearer_context_information.apns);
   }
 
-  free_wrapper ((void**) contextP);
+  slab_pool_free (sgw_app.bearer_context_information_pool, (void**) contextP);
 }
 
 //-----------------------------------------------------------------------------
@@ -328,8 +318,9 @@ sgw_cm_create_bearer_context_information_in_collection (
 //-----------------------------------------------------------------------------
 {
   s_plus_p_gw_eps_bearer_context_information_t *new_bearer_context_information = NULL;
+  hashtable_rc_t                                hash_rc = HASH_TABLE_OK;
 
-  new_bearer_context_information = calloc (1, sizeof (s_plus_p_gw_eps_bearer_context_information_t));
+  new_bearer_context_information = slab_pool_alloc (sgw_app.bearer_context_information_pool);
 
   if (new_bearer_context_information == NULL) {
     /*
@@ -341,41 +332,38 @@ sgw_cm_create_bearer_context_information_in_collection (
 
   OAILOG_DEBUG (LOG_SPGW_APP, "sgw_cm_create_bearer_context_information_in_collection %d\n", teid);
   /*
-   * new_bearer_context_information->sgw_eps_bearer_context_information.pdn_connections = obj_hashtable_ts_create(32, NULL, NULL, sgw_cm_free_pdn_connection);
-   * 
-   * if ( new_bearer_context_information->sgw_eps_bearer_context_information.pdn_connections == NULL) {
-   * SPGW_APP_ERROR("Failed to create PDN connections collection object entry for EPS bearer teid %u \n", teid);
-   * sgw_cm_free_s_plus_p_gw_eps_bearer_context_information(new_bearer_context_information);
-   * return NULL;
-   * }
+   * The EPS bearers are stored in the PDN connection, the P-GW APNs are not
+   * tracked yet: no collection to create.
    */
-  bstring b = bfromcstr("pgw_eps_bearer_ctxt_info_apns");
-  new_bearer_context_information->pgw_eps_bearer_context_information.apns =
-      obj_hashtable_ts_create (32, NULL, NULL, (void (*) (void **))pgw_lite_cm_free_apn, b);
-  bdestroy(b);
-
-  if (new_bearer_context_information->pgw_eps_bearer_context_information.apns == NULL) {
-    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create APN collection object entry for EPS bearer S11 teid %u \n", teid);
+  hash_rc = id_index_insert (sgw_app.s11_bearer_context_information, teid, new_bearer_context_information);
+  if (HASH_TABLE_OK != hash_rc) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Failed to index bearer context information for S11 teid %u\n", teid);
     sgw_cm_free_s_plus_p_gw_eps_bearer_context_information (&new_bearer_context_information);
     return NULL;
   }
-
-  /*
-   * Trying to insert the new tunnel into the tree.
-   * * * * If collision_p is not NULL (0), it means tunnel is already present.
-   */
-  hashtable_ts_insert (sgw_app.s11_bearer_context_information_hashtable, teid, new_bearer_context_information);
-  OAILOG_DEBUG (LOG_SPGW_APP, "Added new s_plus_p_gw_eps_bearer_context_information_t in s11_bearer_context_information_hashtable key teid %u\n", teid);
+  OAILOG_DEBUG (LOG_SPGW_APP, "Added new s_plus_p_gw_eps_bearer_context_information_t in s11_bearer_context_information key teid %u\n", teid);
   return new_bearer_context_information;
 }
 
+//-----------------------------------------------------------------------------
+s_plus_p_gw_eps_bearer_context_information_t *
+sgw_cm_get_bearer_context_information (
+  teid_t teid)
+//-----------------------------------------------------------------------------
+{
+  s_plus_p_gw_eps_bearer_context_information_t *bearer_context_information = NULL;
+
+  id_index_get (sgw_app.s11_bearer_context_information, teid, (void **)&bearer_context_information);
+  return bearer_context_information;
+}
+
 int
 sgw_cm_remove_bearer_context_information (
   teid_t teid)
 {
   int                                     temp = 0;
 
-  temp = hashtable_ts_free (sgw_app.s11_bearer_context_information_hashtable, teid);
+  temp = id_index_free (sgw_app.s11_bearer_context_information, teid);
   return temp;
 }
 
@@ -384,60 +372,104 @@ sgw_cm_remove_bearer_context_information (
 //-----------------------------------------------------------------------------
 sgw_eps_bearer_entry_t                 *
 sgw_cm_create_eps_bearer_entry_in_collection (
-  hash_table_ts_t * eps_bearersP,
+  sgw_pdn_connection_t * const pdn_connectionP,
   ebi_t eps_bearer_idP)
 //-----------------------------------------------------------------------------
 {
   sgw_eps_bearer_entry_t                 *new_eps_bearer_entry = NULL;
-  hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
+  bool                                    is_embedded_bearer_used = false;
 
-  if (eps_bearersP == NULL) {
-    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create EPS bearer entry for EPS bearer id %u. reason eps bearer hashtable is NULL \n", eps_bearer_idP);
+  if ((eps_bearer_idP < EPS_BEARER_IDENTITY_FIRST) || (eps_bearer_idP > EPS_BEARER_IDENTITY_LAST)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create EPS bearer entry for EPS bearer id %u. reason invalid EPS bearer id\n", eps_bearer_idP);
     return NULL;
   }
 
-  new_eps_bearer_entry = calloc (1, sizeof (sgw_eps_bearer_entry_t));
+  if (pdn_connectionP->sgw_eps_bearers[SGW_EBI_TO_INDEX (eps_bearer_idP)]) {
+    OAILOG_WARNING (LOG_SPGW_APP, "This EPS bearer entry already exists: %u\n", eps_bearer_idP);
+    return pdn_connectionP->sgw_eps_bearers[SGW_EBI_TO_INDEX (eps_bearer_idP)];
+  }
 
-  if (new_eps_bearer_entry == NULL) {
-    /*
-     * Malloc failed, may be ENOMEM error
-     */
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if (pdn_connectionP->sgw_eps_bearers[i] == &pdn_connectionP->embedded_bearer) {
+      is_embedded_bearer_used = true;
+      break;
+    }
+  }
+
+  if (!is_embedded_bearer_used) {
+    new_eps_bearer_entry = &pdn_connectionP->embedded_bearer;
+    memset (new_eps_bearer_entry, 0, sizeof (sgw_eps_bearer_entry_t));
+  } else if (!(new_eps_bearer_entry = sgw_cm_create_eps_bearer_entry ())) {
     OAILOG_ERROR (LOG_SPGW_APP, "Failed to create EPS bearer entry for EPS bearer id %u \n", eps_bearer_idP);
     return NULL;
   }
 
   new_eps_bearer_entry->eps_bearer_id = eps_bearer_idP;
-  hash_rc = hashtable_ts_insert (eps_bearersP, eps_bearer_idP, new_eps_bearer_entry);
-  OAILOG_DEBUG (LOG_SPGW_APP, "Inserted new EPS bearer entry for EPS bearer id %u status %s\n", eps_bearer_idP, hashtable_rc_code2string (hash_rc));
-  hash_rc = hashtable_ts_apply_callback_on_elements (eps_bearersP, sgw_display_pdn_connection_sgw_eps_bearers, NULL, NULL);
+  pdn_connectionP->sgw_eps_bearers[SGW_EBI_TO_INDEX (eps_bearer_idP)] = new_eps_bearer_entry;
+  OAILOG_DEBUG (LOG_SPGW_APP, "Inserted new EPS bearer entry for EPS bearer id %u\n", eps_bearer_idP);
+  return new_eps_bearer_entry;
+}
 
-  if (HASH_TABLE_OK != hash_rc) {
-    OAILOG_DEBUG (LOG_SPGW_APP, "Invalid sgw_eps_bearers hashtable for display\n");
+//-----------------------------------------------------------------------------
+sgw_eps_bearer_entry_t                 *
+sgw_cm_get_eps_bearer_entry (
+  const sgw_pdn_connection_t * const pdn_connectionP,
+  ebi_t eps_bearer_idP)
+//-----------------------------------------------------------------------------
+{
+  if ((eps_bearer_idP < EPS_BEARER_IDENTITY_FIRST) || (eps_bearer_idP > EPS_BEARER_IDENTITY_LAST)) {
+    return NULL;
   }
-
-  /*
-   * CHECK DUPLICATES IN HASH TABLES ? if (temp == 1) {
-   * SPGW_APP_WARN("This EPS bearer entry already exists: %u\n", eps_bearer_idP);
-   * free_wrapper(new_eps_bearer_entry);
-   * new_eps_bearer_entry = collision_p;
-   * }
-   */
-  return new_eps_bearer_entry;
+  return pdn_connectionP->sgw_eps_bearers[SGW_EBI_TO_INDEX (eps_bearer_idP)];
 }
 
 //-----------------------------------------------------------------------------
 int
 sgw_cm_remove_eps_bearer_entry (
-  hash_table_ts_t * eps_bearersP,
+  sgw_pdn_connection_t * const pdn_connectionP,
   ebi_t eps_bearer_idP)
 //-----------------------------------------------------------------------------
 {
-  int                                     temp = 0;
+  sgw_eps_bearer_entry_t                **eps_bearer_entry = NULL;
 
-  if (eps_bearersP == NULL) {
+  if ((pdn_connectionP == NULL) || (eps_bearer_idP < EPS_BEARER_IDENTITY_FIRST) || (eps_bearer_idP > EPS_BEARER_IDENTITY_LAST)) {
     return RETURNerror;
   }
 
-  temp = hashtable_ts_free (eps_bearersP, eps_bearer_idP);
-  return temp;
+  eps_bearer_entry = &pdn_connectionP->sgw_eps_bearers[SGW_EBI_TO_INDEX (eps_bearer_idP)];
+  if (*eps_bearer_entry == NULL) {
+    return RETURNerror;
+  }
+  if ((*eps_bearer_entry)->s_gw_teid_S1u_S12_S4_up) {
+    sgw_shard_release_s1u_teid ((*eps_bearer_entry)->s_gw_teid_S1u_S12_S4_up);
+  }
+  if (*eps_bearer_entry == &pdn_connectionP->embedded_bearer) {
+    *eps_bearer_entry = NULL;
+  } else {
+    slab_pool_free (sgw_app.eps_bearer_entry_pool, (void**) eps_bearer_entry);
+  }
+  return RETURNok;
+}
+
+//-----------------------------------------------------------------------------
+void
+sgw_cm_memory_report (
+  bstring str)
+//-----------------------------------------------------------------------------
+{
+  slab_pool_stats_t                       context_stats = {0};
+  slab_pool_stats_t                       bearer_stats = {0};
+  const uint64_t                          nb_tunnels = id_index_num_elements (sgw_app.s11teid2mme);
+  uint64_t                                bytes_in_use = 0;
+
+  slab_pool_get_stats (sgw_app.bearer_context_information_pool, &context_stats);
+  slab_pool_get_stats (sgw_app.eps_bearer_entry_pool, &bearer_stats);
+  bytes_in_use = context_stats.nb_in_use * context_stats.object_size + bearer_stats.nb_in_use * bearer_stats.object_size +
+                 nb_tunnels * sizeof (mme_sgw_tunnel_t) + id_index_memory_bytes (sgw_app.s11teid2mme) +
+                 id_index_memory_bytes (sgw_app.s11_bearer_context_information);
+  bformata (str, "Session contexts         %6zu B x %10" PRIu64 "\n", context_stats.object_size, context_stats.nb_in_use);
+  bformata (str, "Dedicated bearer entries %6zu B x %10" PRIu64 "\n", bearer_stats.object_size, bearer_stats.nb_in_use);
+  bformata (str, "S11 tunnels              %6zu B x %10" PRIu64 "\n", sizeof (mme_sgw_tunnel_t), nb_tunnels);
+  bformata (str, "S11 TEID indexes         %6zu B\n", id_index_memory_bytes (sgw_app.s11teid2mme) + id_index_memory_bytes (sgw_app.s11_bearer_context_information));
+  bformata (str, "Memory per session       %6" PRIu64 " B\n", (context_stats.nb_in_use) ? bytes_in_use / context_stats.nb_in_use : 0);
 }
@@ -33,7 +33,10 @@
 /********************************
 *     Paired contexts           *
 *********************************/
-// data entry for s11_bearer_context_information_hashtable
+// slot of an EPS bearer in sgw_pdn_connection_t.sgw_eps_bearers
+#define SGW_EBI_TO_INDEX(eBI)                  ((eBI) - EPS_BEARER_IDENTITY_FIRST)
+
+// data entry for s11_bearer_context_information, allocated from bearer_context_information_pool
 // like this if needed in future, the split of S and P GW should be easier.
 typedef struct s_plus_p_gw_eps_bearer_context_information_s {
   sgw_eps_bearer_context_information_t sgw_eps_bearer_context_information;
@@ -41,7 +44,7 @@ typedef struct s_plus_p_gw_eps_bearer_context_information_s {
 } s_plus_p_gw_eps_bearer_context_information_t;
 
 
-// data entry for s11teid2mme_hashtable
+// data entry for s11teid2mme
 typedef struct mme_sgw_tunnel_s {
   uint32_t local_teid;   ///< Tunnel endpoint Identifier
   uint32_t remote_teid;  ///< Tunnel endpoint Identifier
@@ -66,11 +69,15 @@ int                                    sgw_cm_remove_s11_tunnel(teid_t local_tei
 sgw_eps_bearer_entry_t *               sgw_cm_create_eps_bearer_entry(void);
 sgw_pdn_connection_t *                 sgw_cm_create_pdn_connection(void);
 void                                   sgw_cm_free_pdn_connection(sgw_pdn_connection_t **pdn_connectionP);
+void                                   sgw_cm_free_pdn_connection_content(sgw_pdn_connection_t * const pdn_connectionP);
 s_plus_p_gw_eps_bearer_context_information_t * sgw_cm_create_bearer_context_information_in_collection(teid_t teid);
+s_plus_p_gw_eps_bearer_context_information_t * sgw_cm_get_bearer_context_information(teid_t teid);
 void                                   sgw_cm_free_s_plus_p_gw_eps_bearer_context_information
     (s_plus_p_gw_eps_bearer_context_information_t **contextP);
 int                                    sgw_cm_remove_bearer_context_information(teid_t teid);
-sgw_eps_bearer_entry_t *               sgw_cm_create_eps_bearer_entry_in_collection(hash_table_ts_t *eps_bearersP, ebi_t eps_bearer_idP);
-int                                    sgw_cm_remove_eps_bearer_entry(hash_table_ts_t *eps_bearersP, ebi_t eps_bearer_idP);
+sgw_eps_bearer_entry_t *               sgw_cm_create_eps_bearer_entry_in_collection(sgw_pdn_connection_t * const pdn_connectionP, ebi_t eps_bearer_idP);
+sgw_eps_bearer_entry_t *               sgw_cm_get_eps_bearer_entry(const sgw_pdn_connection_t * const pdn_connectionP, ebi_t eps_bearer_idP);
+int                                    sgw_cm_remove_eps_bearer_entry(sgw_pdn_connection_t * const pdn_connectionP, ebi_t eps_bearer_idP);
+void                                   sgw_cm_memory_report(bstring str);
 
 #endif /* FILE_SGW_CONTEXT_MANAGER_SEEN */
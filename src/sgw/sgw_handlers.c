@@ -52,6 +52,7 @@
 #include "sgw_handlers.h"
 #include "sgw_context_manager.h"
 #include "sgw.h"
+#include "sgw_shard.h"
 #include "pgw_pco.h"
 #include "spgw_config.h"
 #include "ProtocolConfigurationOptions.h"
@@ -62,15 +63,12 @@ extern sgw_app_t                        sgw_app;
 extern spgw_config_t                    spgw_config;
 extern struct gtp_tunnel_ops            *gtp_tunnel_ops;
 
-static uint32_t                         g_gtpv1u_teid = 0;
-
 //------------------------------------------------------------------------------
 uint32_t
 sgw_get_new_teid (
   void)
 {
-  g_gtpv1u_teid = g_gtpv1u_teid + 1;
-  return g_gtpv1u_teid;
+  return sgw_shard_new_s1u_teid ();
 }
 
 
@@ -82,6 +80,7 @@ sgw_handle_create_session_request (
   mme_sgw_tunnel_t                       *new_endpoint_p = NULL;
   s_plus_p_gw_eps_bearer_context_information_t *s_plus_p_gw_eps_bearer_ctxt_info_p = NULL;
   sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
+  teid_t                                  local_teid = 0;
 
   OAILOG_FUNC_IN(LOG_SPGW_APP);
   /*
@@ -109,7 +108,12 @@ sgw_handle_create_session_request (
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
 
-  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, sgw_get_new_S11_tunnel_id ());
+  if (!(local_teid = sgw_get_new_S11_tunnel_id ())) {
+    OAILOG_ERROR (LOG_SPGW_APP, "No S11 TEID left on SPGW_APP shard %d\n", sgw_current_shard);
+    OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
+  }
+
+  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, local_teid);
 
   if (new_endpoint_p == NULL) {
     OAILOG_WARNING (LOG_SPGW_APP, "Could not create new tunnel endpoint between S-GW and MME " "for S11 abstraction\n");
@@ -153,22 +157,11 @@ sgw_handle_create_session_request (
      * OAILOG_FUNC_RETURN(LOG_SPGW_APP,  RETURNerror);
      * }
      */
-    memset (&s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, 0, sizeof (sgw_pdn_connection_t));
-
-    bstring b = bfromcstr("sgw_eps_bearers");
-    s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers = hashtable_ts_create (12, NULL, NULL, b);
-    bdestroy(b);
-
-    if (s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers == NULL) {
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to create eps bearers collection object\n");
-      DevMessage ("Failed to create eps bearers collection object\n");
-      OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
-    }
 
     if (session_req_pP->apn) {
       s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = strdup (session_req_pP->apn);
     } else {
-      s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = "NO APN";
+      s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.apn_in_use = strdup ("NO APN");
     }
 
     s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer = session_req_pP->bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id;
@@ -178,14 +171,13 @@ sgw_handle_create_session_request (
     // EPS bearer entry
     //--------------------------------------
     // TODO several bearers
-    eps_bearer_entry_p = sgw_cm_create_eps_bearer_entry_in_collection (s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
+    eps_bearer_entry_p = sgw_cm_create_eps_bearer_entry_in_collection (&s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
         session_req_pP->bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id);
-    sgw_display_s11teid2mme_mappings ();
-    sgw_display_s11_bearer_context_information_mapping ();
 
     if (eps_bearer_entry_p == NULL) {
       OAILOG_ERROR (LOG_SPGW_APP, "Failed to create new EPS bearer entry\n");
-      // TO DO free_wrapper new_bearer_ctxt_info_p and by cascade...
+      sgw_cm_remove_bearer_context_information (new_endpoint_p->local_teid);
+      sgw_cm_remove_s11_tunnel (new_endpoint_p->local_teid);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
     }
 
@@ -224,12 +216,17 @@ sgw_handle_create_session_request (
       createTunnelResp.context_teid = new_endpoint_p->local_teid;
       createTunnelResp.eps_bearer_id = session_req_pP->bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id;
       createTunnelResp.status = 0x00;
-      createTunnelResp.S1u_teid = sgw_get_new_teid ();
+      if (!(createTunnelResp.S1u_teid = sgw_get_new_teid ())) {
+        OAILOG_ERROR (LOG_SPGW_APP, "No S1-U TEID left on SPGW_APP shard %d\n", sgw_current_shard);
+        sgw_cm_remove_bearer_context_information (new_endpoint_p->local_teid);
+        sgw_cm_remove_s11_tunnel (new_endpoint_p->local_teid);
+        OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
+      }
       sgw_handle_gtpv1uCreateTunnelResp (&createTunnelResp);
     }
   } else {
     OAILOG_WARNING (LOG_SPGW_APP, "Could not create new transaction for SESSION_CREATE message\n");
-    free_wrapper ((void**) &new_endpoint_p);
+    sgw_cm_remove_s11_tunnel (new_endpoint_p->local_teid);
     new_endpoint_p = NULL;
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
@@ -251,7 +248,7 @@ sgw_handle_sgi_endpoint_created (
 
   OAILOG_FUNC_IN(LOG_SPGW_APP);
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_CREATE_ENDPOINT_RESPONSE,Context: S11 teid %u, SGW S1U teid %u EPS bearer id %u\n", resp_pP->context_teid, resp_pP->sgw_S1u_teid, resp_pP->eps_bearer_id);
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
 
   message_p = itti_alloc_new_message (TASK_SPGW_APP, S11_CREATE_SESSION_RESPONSE);
 
@@ -281,10 +278,9 @@ sgw_handle_sgi_endpoint_created (
       {
         sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
 
-        hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
-            resp_pP->eps_bearer_id, (void **)&eps_bearer_entry_p);
+        eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, resp_pP->eps_bearer_id);
 
-        if ((hash_rc == HASH_TABLE_KEY_NOT_EXISTS) || (hash_rc == HASH_TABLE_BAD_PARAMETER_HASHTABLE)) {
+        if (eps_bearer_entry_p == NULL) {
           OAILOG_ERROR (LOG_SPGW_APP, "ERROR UNABLE TO GET EPS BEARER ENTRY\n");
         } else {
           AssertFatal (sizeof (eps_bearer_entry_p->paa) == sizeof (resp_pP->paa), "Mismatch in lengths");       // sceptic mode
@@ -363,14 +359,13 @@ sgw_handle_gtpv1uCreateTunnelResp (
 
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx GTPV1U_CREATE_TUNNEL_RESP, Context S-GW S11 teid %u, S-GW S1U teid %u EPS bearer id %u status %d\n",
                   endpoint_created_pP->context_teid, endpoint_created_pP->S1u_teid, endpoint_created_pP->eps_bearer_id, endpoint_created_pP->status);
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, endpoint_created_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, endpoint_created_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
-    hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, endpoint_created_pP->eps_bearer_id, (void **)&eps_bearer_entry_p);
-    DevAssert (HASH_TABLE_OK == hash_rc);
+    eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, endpoint_created_pP->eps_bearer_id);
+    DevAssert (eps_bearer_entry_p);
     OAILOG_DEBUG (LOG_SPGW_APP, "Updated eps_bearer_entry_p eps_b_id %u with SGW S1U teid %u\n", endpoint_created_pP->eps_bearer_id, endpoint_created_pP->S1u_teid);
     eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up = endpoint_created_pP->S1u_teid;
-    sgw_display_s11_bearer_context_information_mapping ();
     memset (&sgi_create_endpoint_resp, 0, sizeof (itti_sgi_create_end_point_response_t));
 
     //--------------------------------------------------------------------------
@@ -527,12 +522,12 @@ sgw_handle_gtpv1uUpdateTunnelResp (
   OAILOG_FUNC_IN(LOG_SPGW_APP);
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx GTPV1U_UPDATE_TUNNEL_RESP, Context teid %u, SGW S1U teid %u, eNB S1U teid %u, EPS bearer id %u, status %d\n",
                   endpoint_updated_pP->context_teid, endpoint_updated_pP->sgw_S1u_teid, endpoint_updated_pP->enb_S1u_teid, endpoint_updated_pP->eps_bearer_id, endpoint_updated_pP->status);
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, endpoint_updated_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, endpoint_updated_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
-    hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, endpoint_updated_pP->eps_bearer_id, (void **)&eps_bearer_entry_p);
+    eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, endpoint_updated_pP->eps_bearer_id);
 
-    if ((hash_rc == HASH_TABLE_KEY_NOT_EXISTS) || (hash_rc == HASH_TABLE_BAD_PARAMETER_HASHTABLE)) {
+    if (eps_bearer_entry_p == NULL) {
       OAILOG_DEBUG (LOG_SPGW_APP, "Sending S11_MODIFY_BEARER_RESPONSE trxn %p bearer %u CONTEXT_NOT_FOUND (sgw_eps_bearers)\n", new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn, endpoint_updated_pP->eps_bearer_id);
       message_p = itti_alloc_new_message (TASK_SPGW_APP, S11_MODIFY_BEARER_RESPONSE);
 
@@ -549,7 +544,7 @@ sgw_handle_gtpv1uUpdateTunnelResp (
       modify_response_p->trxn = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
       rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
-    } else if (HASH_TABLE_OK == hash_rc) {
+    } else {
       message_p = itti_alloc_new_message (TASK_SPGW_APP, SGI_UPDATE_ENDPOINT_REQUEST);
 
       if (!message_p) {
@@ -619,13 +614,13 @@ sgw_handle_sgi_endpoint_updated (
 
   modify_response_p = &message_p->ittiMsg.s11_modify_bearer_response;
   memset (modify_response_p, 0, sizeof (itti_s11_modify_bearer_response_t));
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
-  hash_rc2 = hashtable_ts_get (sgw_app.s11teid2mme_hashtable, resp_pP->context_teid /*local teid*/, (void **)&tun_pair_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc2 = id_index_get (sgw_app.s11teid2mme, resp_pP->context_teid /*local teid*/, (void **)&tun_pair_p);
 
   if ((HASH_TABLE_OK == hash_rc) && (HASH_TABLE_OK == hash_rc2)) {
-    hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, resp_pP->eps_bearer_id, (void **)&eps_bearer_entry_p);
+    eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, resp_pP->eps_bearer_id);
 
-    if ((hash_rc == HASH_TABLE_KEY_NOT_EXISTS) || (hash_rc == HASH_TABLE_BAD_PARAMETER_HASHTABLE)) {
+    if (eps_bearer_entry_p == NULL) {
       OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_UPDATE_ENDPOINT_RESPONSE: CONTEXT_NOT_FOUND (pdn_connection.sgw_eps_bearers context)\n");
 
       modify_response_p->teid = tun_pair_p->remote_teid;
@@ -640,7 +635,7 @@ sgw_handle_sgi_endpoint_updated (
                           modify_response_p->trxn);
       rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
-    } else if (HASH_TABLE_OK == hash_rc) {
+    } else {
       OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_UPDATE_ENDPOINT_RESPONSE: REQUEST_ACCEPTED\n");
       // accept anyway
       modify_response_p->teid = tun_pair_p->remote_teid;
@@ -706,14 +701,14 @@ sgw_handle_sgi_endpoint_deleted (
   OAILOG_DEBUG (LOG_SPGW_APP, "bcom Rx SGI_DELETE_ENDPOINT_REQUEST, Context teid %u, SGW S1U teid %u, EPS bearer id %u\n",
                 resp_pP->context_teid, resp_pP->sgw_S1u_teid, resp_pP->eps_bearer_id);
 
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
-    hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, resp_pP->eps_bearer_id, (void **)&eps_bearer_entry_p);
+    eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection, resp_pP->eps_bearer_id);
 
-    if ((hash_rc == HASH_TABLE_KEY_NOT_EXISTS) || (hash_rc == HASH_TABLE_BAD_PARAMETER_HASHTABLE)) {
+    if (eps_bearer_entry_p == NULL) {
       OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_DELETE_ENDPOINT_REQUEST: CONTEXT_NOT_FOUND (pdn_connection.sgw_eps_bearers context)\n");
-    } else if (HASH_TABLE_OK == hash_rc) {
+    } else {
       OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_DELETE_ENDPOINT_REQUEST: REQUEST_ACCEPTED\n");
       // if default bearer
       //#pragma message  "TODO define constant for default eps_bearer id"
@@ -784,18 +779,16 @@ sgw_handle_modify_bearer_request (
   OAILOG_FUNC_IN(LOG_SPGW_APP);
 
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx MODIFY_BEARER_REQUEST, teid %u\n", modify_bearer_pP->teid);
-  sgw_display_s11teid2mme_mappings ();
-  sgw_display_s11_bearer_context_information_mapping ();
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, modify_bearer_pP->teid, (void **)&new_bearer_ctxt_info_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, modify_bearer_pP->teid, (void **)&new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
     new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer =
         modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id;
     new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn = modify_bearer_pP->trxn;
-    hash_rc = hashtable_ts_is_key_exists (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
+    eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
         modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id);
 
-    if (hash_rc == HASH_TABLE_KEY_NOT_EXISTS) {
+    if (eps_bearer_entry_p == NULL) {
       message_p = itti_alloc_new_message (TASK_SPGW_APP, S11_MODIFY_BEARER_RESPONSE);
 
       if (!message_p) {
@@ -817,10 +810,8 @@ sgw_handle_modify_bearer_request (
                           modify_response_p->bearer_contexts_marked_for_removal.bearer_contexts[0].eps_bearer_id, modify_response_p->trxn);
       rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
-    } else if (HASH_TABLE_OK == hash_rc) {
+    } else {
       // TO DO
-      hash_rc = hashtable_ts_get (new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
-          modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id, (void **)&eps_bearer_entry_p);
       FTEID_T_2_IP_ADDRESS_T ((&modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].s1_eNB_fteid), (&eps_bearer_entry_p->enb_ip_address_S1u));
       eps_bearer_entry_p->enb_teid_S1u = modify_bearer_pP->bearer_contexts_to_be_modified.bearer_contexts[0].s1_eNB_fteid.teid;
       {
@@ -883,8 +874,8 @@ sgw_handle_delete_session_request (
     OAILOG_DEBUG (LOG_SPGW_APP, "OI flag is set for this message indicating the request" "should be forwarded to P-GW entity\n");
   }
 
-  hash_rc = hashtable_ts_get (
-      sgw_app.s11_bearer_context_information_hashtable,
+  hash_rc = id_index_get (
+      sgw_app.s11_bearer_context_information,
       delete_session_req_pP->teid, (void **)&ctx_p);
 
   if (HASH_TABLE_OK == hash_rc) {
@@ -906,21 +897,20 @@ sgw_handle_delete_session_request (
       itti_sgi_delete_end_point_request_t      sgi_delete_end_point_request;
       sgw_eps_bearer_entry_t                   *eps_bearer_entry_p = NULL;
 
-      hash_rc = hashtable_ts_get (ctx_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, delete_session_req_pP->lbi, (void **)&eps_bearer_entry_p);
-      sgi_delete_end_point_request.context_teid = delete_session_req_pP->teid ;
-      sgi_delete_end_point_request.sgw_S1u_teid = eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up;
-      sgi_delete_end_point_request.eps_bearer_id = delete_session_req_pP->lbi;
-      sgi_delete_end_point_request.pdn_type = ctx_p->sgw_eps_bearer_context_information.saved_message.pdn_type;
-      memcpy (&sgi_delete_end_point_request.paa, &eps_bearer_entry_p->paa, sizeof (PAA_t));
+      eps_bearer_entry_p = sgw_cm_get_eps_bearer_entry (&ctx_p->sgw_eps_bearer_context_information.pdn_connection, delete_session_req_pP->lbi);
+      if (eps_bearer_entry_p) {
+        sgi_delete_end_point_request.context_teid = delete_session_req_pP->teid ;
+        sgi_delete_end_point_request.sgw_S1u_teid = eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up;
+        sgi_delete_end_point_request.eps_bearer_id = delete_session_req_pP->lbi;
+        sgi_delete_end_point_request.pdn_type = ctx_p->sgw_eps_bearer_context_information.saved_message.pdn_type;
+        memcpy (&sgi_delete_end_point_request.paa, &eps_bearer_entry_p->paa, sizeof (PAA_t));
 
-      sgw_handle_sgi_endpoint_deleted (&sgi_delete_end_point_request);
+        sgw_handle_sgi_endpoint_deleted (&sgi_delete_end_point_request);
+      }
 
       /*
-       * Remove eps bearer context, S11 bearer context and s11 tunnel
+       * Remove S11 bearer context, with its eps bearers, and s11 tunnel
        */
-      sgw_cm_remove_eps_bearer_entry(
-        ctx_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers,
-        delete_session_req_pP->lbi);
       sgw_cm_remove_bearer_context_information(delete_session_req_pP->teid);
       sgw_cm_remove_s11_tunnel(delete_session_req_pP->teid);
     }
@@ -954,25 +944,21 @@ sgw_handle_delete_session_request (
   OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
 }
 
-/*
-   Callback of hashtable_ts_apply_funct_on_elements()
-*/
 //------------------------------------------------------------------------------
-static bool
+static void
 sgw_release_all_enb_related_information (
-  hash_key_t keyP,
-  void *dataP,
-  void *unused_parameterP,
-  void **unused_resultP)
+  sgw_pdn_connection_t * const pdn_connection_p)
 {
-  sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = (sgw_eps_bearer_entry_t *) dataP;
+  sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
 
   OAILOG_FUNC_IN(LOG_SPGW_APP);
-  if ( eps_bearer_entry_p) {
-    memset (&eps_bearer_entry_p->enb_ip_address_S1u, 0, sizeof (eps_bearer_entry_p->enb_ip_address_S1u));
-    eps_bearer_entry_p->enb_teid_S1u = 0;
+  for (int i = 0; i < BEARERS_PER_UE; i++) {
+    if ((eps_bearer_entry_p = pdn_connection_p->sgw_eps_bearers[i])) {
+      memset (&eps_bearer_entry_p->enb_ip_address_S1u, 0, sizeof (eps_bearer_entry_p->enb_ip_address_S1u));
+      eps_bearer_entry_p->enb_teid_S1u = 0;
+    }
   }
-  OAILOG_FUNC_RETURN(LOG_SPGW_APP, false);
+  OAILOG_FUNC_OUT(LOG_SPGW_APP);
 }
 
 
@@ -1006,14 +992,14 @@ sgw_handle_release_access_bearers_request (
   release_access_bearers_resp_p = &message_p->ittiMsg.s11_release_access_bearers_response;
   memset((void*)release_access_bearers_resp_p, 0, sizeof(*release_access_bearers_resp_p));
 
-  hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, release_access_bearers_req_pP->teid, (void **)&ctx_p);
+  hash_rc = id_index_get (sgw_app.s11_bearer_context_information, release_access_bearers_req_pP->teid, (void **)&ctx_p);
 
   if (HASH_TABLE_OK == hash_rc) {
     release_access_bearers_resp_p->cause = REQUEST_ACCEPTED;
     release_access_bearers_resp_p->teid = ctx_p->sgw_eps_bearer_context_information.mme_teid_S11;
     release_access_bearers_resp_p->trxn = release_access_bearers_req_pP->trxn;
 //#pragma message  "TODO Here the release (sgw_handle_release_access_bearers_request)"
-    hash_rc = hashtable_ts_apply_callback_on_elements (ctx_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers, sgw_release_all_enb_related_information, NULL, NULL);
+    sgw_release_all_enb_related_information (&ctx_p->sgw_eps_bearer_context_information.pdn_connection);
     // TODO The S-GW starts buffering downlink packets received for the UE
     // (set target on GTPUSP to order the buffering)
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_RESPONSE S11 MME teid %u cause REQUEST_ACCEPTED", release_access_bearers_resp_p->teid);
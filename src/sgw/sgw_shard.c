@@ -0,0 +1,220 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sgw_shard.c
+  \brief TEID allocation per shard and routing of S11 messages to the SPGW_APP task owning the session.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "log.h"
+#include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "sgw_shard.h"
+
+int                                     sgw_nb_workers = 1;
+__thread int                            sgw_current_shard = 0;
+
+const task_id_t                         sgw_shard_tasks[SGW_MAX_WORKERS] = {
+  TASK_SPGW_APP,    TASK_SPGW_APP_1,  TASK_SPGW_APP_2,  TASK_SPGW_APP_3,
+  TASK_SPGW_APP_4,  TASK_SPGW_APP_5,  TASK_SPGW_APP_6,  TASK_SPGW_APP_7,
+  TASK_SPGW_APP_8,  TASK_SPGW_APP_9,  TASK_SPGW_APP_10, TASK_SPGW_APP_11,
+  TASK_SPGW_APP_12, TASK_SPGW_APP_13, TASK_SPGW_APP_14, TASK_SPGW_APP_15
+};
+
+/*
+ * TEIDs of a shard: next is the counter of the first never allocated one, the
+ * released ones are kept in a min-heap and given again lowest first, so that
+ * the TEIDs in use stay dense whatever the churn of sessions.
+ */
+typedef struct sgw_shard_teid_pool_s {
+  teid_t                                  next;
+  teid_t                                 *released;
+  uint32_t                                nb_released;
+  uint32_t                                size;
+} sgw_shard_teid_pool_t;
+
+// pools of a shard, on their own cache line since they are only used by this shard
+typedef struct sgw_shard_teid_generators_s {
+  sgw_shard_teid_pool_t                   s11;
+  sgw_shard_teid_pool_t                   s1u;
+} __attribute__ ((aligned (64))) sgw_shard_teid_generators_t;
+
+static sgw_shard_teid_generators_t      sgw_shard_teid_generators[SGW_MAX_WORKERS];
+// shard tasks that have not processed TERMINATE yet
+static int                              sgw_shard_running = 0;
+// set by sgw_shard_exit(), the sessions freed afterwards do not give their TEIDs back
+static bool                             sgw_shard_teid_pools_released = false;
+
+#define SGW_SHARD_TEID_POOL_MIN_SIZE    256
+
+//------------------------------------------------------------------------------
+int sgw_shard_init (const uint32_t nb_workers)
+{
+  if ((nb_workers < 1) || (nb_workers > SGW_MAX_WORKERS)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Bad number of SPGW_APP workers %u, must be in [1..%d]\n", nb_workers, SGW_MAX_WORKERS);
+    return RETURNerror;
+  }
+  sgw_nb_workers = (int)nb_workers;
+  sgw_shard_running = sgw_nb_workers;
+  for (int i = 0; i < SGW_MAX_WORKERS; i++) {
+    memset (&sgw_shard_teid_generators[i], 0, sizeof (sgw_shard_teid_generators_t));
+    sgw_shard_teid_generators[i].s11.next = 1;
+    sgw_shard_teid_generators[i].s1u.next = 1;
+  }
+  OAILOG_INFO (LOG_SPGW_APP, "Sessions sharded on %d SPGW_APP workers\n", sgw_nb_workers);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+bool sgw_shard_exit_is_last (void)
+{
+  return (0 == __sync_sub_and_fetch (&sgw_shard_running, 1));
+}
+
+//------------------------------------------------------------------------------
+void sgw_shard_exit (void)
+{
+  sgw_shard_teid_pools_released = true;
+  for (int i = 0; i < SGW_MAX_WORKERS; i++) {
+    free_wrapper ((void **)&sgw_shard_teid_generators[i].s11.released);
+    free_wrapper ((void **)&sgw_shard_teid_generators[i].s1u.released);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The TEIDs of a shard are c * nb_workers + shard, c >= 1 so that 0 is never
+ * returned. Dense over all shards, they keep the S11 TEID indexes compact.
+ * c stops before c * nb_workers + shard wraps, it would then land in the
+ * residue class of another shard: 0 is returned once all of them are in use.
+ */
+static teid_t sgw_shard_teid_pool_get (sgw_shard_teid_pool_t * const pool)
+{
+  teid_t                                  teid = 0;
+  uint32_t                                i = 0;
+
+  if (!pool->nb_released) {
+    if (pool->next > (UINT32_MAX - (teid_t)sgw_current_shard) / (teid_t)sgw_nb_workers) {
+      return 0;
+    }
+    return pool->next++ * (teid_t)sgw_nb_workers + (teid_t)sgw_current_shard;
+  }
+  teid = pool->released[0];
+  pool->released[0] = pool->released[--pool->nb_released];
+  // sift down
+  for (;;) {
+    uint32_t                                smallest = i;
+    const uint32_t                          left = 2 * i + 1;
+    const uint32_t                          right = left + 1;
+
+    if ((left < pool->nb_released) && (pool->released[left] < pool->released[smallest])) {
+      smallest = left;
+    }
+    if ((right < pool->nb_released) && (pool->released[right] < pool->released[smallest])) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      break;
+    }
+    const teid_t                            tmp = pool->released[i];
+
+    pool->released[i] = pool->released[smallest];
+    pool->released[smallest] = tmp;
+    i = smallest;
+  }
+  return teid;
+}
+
+//------------------------------------------------------------------------------
+static void sgw_shard_teid_pool_put (sgw_shard_teid_pool_t * const pool, const teid_t teid)
+{
+  uint32_t                                i = 0;
+
+  if (sgw_shard_teid_pools_released) {
+    return;
+  }
+  if ((0 == teid) || (sgw_shard_of_s11_teid (teid) != sgw_current_shard)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "TEID %u released by shard %d, not allocated by it\n", teid, sgw_current_shard);
+    return;
+  }
+  if (pool->nb_released == pool->size) {
+    const uint32_t                          size = (pool->size) ? 2 * pool->size : SGW_SHARD_TEID_POOL_MIN_SIZE;
+    teid_t                                 *released = realloc (pool->released, size * sizeof (teid_t));
+
+    if (!released) {
+      OAILOG_ERROR (LOG_SPGW_APP, "TEID %u not recycled, no memory\n", teid);
+      return;
+    }
+    pool->released = released;
+    pool->size = size;
+  }
+  // sift up
+  i = pool->nb_released++;
+  while (i && (pool->released[(i - 1) / 2] > teid)) {
+    pool->released[i] = pool->released[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  pool->released[i] = teid;
+}
+
+//------------------------------------------------------------------------------
+teid_t sgw_shard_new_s11_teid (void)
+{
+  return sgw_shard_teid_pool_get (&sgw_shard_teid_generators[sgw_current_shard].s11);
+}
+
+//------------------------------------------------------------------------------
+void sgw_shard_release_s11_teid (const teid_t teid)
+{
+  sgw_shard_teid_pool_put (&sgw_shard_teid_generators[sgw_current_shard].s11, teid);
+}
+
+//------------------------------------------------------------------------------
+teid_t sgw_shard_new_s1u_teid (void)
+{
+  return sgw_shard_teid_pool_get (&sgw_shard_teid_generators[sgw_current_shard].s1u);
+}
+
+//------------------------------------------------------------------------------
+void sgw_shard_release_s1u_teid (const teid_t teid)
+{
+  sgw_shard_teid_pool_put (&sgw_shard_teid_generators[sgw_current_shard].s1u, teid);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The MME may encode its own shard in the low bits of its S11 TEIDs, a
+ * multiplicative hash spreads them on all the S-GW shards anyway.
+ */
+int sgw_shard_of_new_session (const teid_t mme_s11_teid)
+{
+  if (1 == sgw_nb_workers) {
+    return 0;
+  }
+  return (int)((((uint64_t)(mme_s11_teid * 2654435761U)) * (uint64_t)sgw_nb_workers) >> 32);
+}
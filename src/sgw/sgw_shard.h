@@ -0,0 +1,85 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sgw_shard.h
+  \brief S/P-GW sessions are partitioned on nb_workers SPGW_APP tasks (shards).
+  A session belongs to the shard local S11 TEID % nb_workers for its whole life
+  and only the task of this shard handles it. The S11 TEIDs and the S1-U TEIDs
+  are allocated by each shard in its own residue class and recycled by it once
+  released, the UE IPv4 address pool is split in one slice per shard: the
+  shards do not share any lock.
+  \author
+  \company
+  \email
+*/
+
+#ifndef FILE_SGW_SHARD_SEEN
+#define FILE_SGW_SHARD_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common_types.h"
+#include "intertask_interface_types.h"
+
+#define SGW_MAX_WORKERS           16
+
+extern int                              sgw_nb_workers;
+extern const task_id_t                  sgw_shard_tasks[SGW_MAX_WORKERS];
+// shard of the SPGW_APP task running on the calling thread, 0 for other threads
+extern __thread int                     sgw_current_shard;
+
+int sgw_shard_init (const uint32_t nb_workers);
+
+// Called by each shard task on TERMINATE, true for the last one: the state shared by the shards may then be freed
+bool sgw_shard_exit_is_last (void);
+
+void sgw_shard_exit (void);
+
+// Identifiers allocated by the shard of the calling SPGW_APP task, released by the same shard, 0 if none is left
+teid_t sgw_shard_new_s11_teid (void);
+
+void sgw_shard_release_s11_teid (const teid_t teid);
+
+teid_t sgw_shard_new_s1u_teid (void);
+
+void sgw_shard_release_s1u_teid (const teid_t teid);
+
+// Shard of a new session, the MME S11 TEIDs are spread on the shards
+int sgw_shard_of_new_session (const teid_t mme_s11_teid);
+
+static inline int sgw_shard_of_s11_teid (const teid_t teid)
+{
+  return (int)(teid % (teid_t)sgw_nb_workers);
+}
+
+static inline task_id_t sgw_task_of_s11_teid (const teid_t teid)
+{
+  return sgw_shard_tasks[sgw_shard_of_s11_teid (teid)];
+}
+
+// A Create Session Request carries the S-GW S11 TEID in its header if the MME has already a session on this S-GW
+static inline task_id_t sgw_task_of_create_session_request (const teid_t teid, const teid_t mme_s11_teid)
+{
+  return sgw_shard_tasks[(teid) ? sgw_shard_of_s11_teid (teid) : sgw_shard_of_new_session (mme_s11_teid)];
+}
+
+#endif /* FILE_SGW_SHARD_SEEN */
@@ -48,6 +48,7 @@
 #include "sgw_defs.h"
 #include "sgw_handlers.h"
 #include "sgw.h"
+#include "sgw_shard.h"
 #include "spgw_config.h"
 #include "pgw_ue_ip_address_alloc.h"
 
@@ -62,14 +63,17 @@ static void sgw_exit(void);
 //------------------------------------------------------------------------------
 static void *sgw_intertask_interface (void *args_p)
 {
-  itti_mark_task_ready (TASK_SPGW_APP);
+  const task_id_t                         task_id = sgw_shard_tasks[(int)(uintptr_t)args_p];
+
+  sgw_current_shard = (int)(uintptr_t)args_p;
+  itti_mark_task_ready (task_id);
   OAILOG_START_USE ();
   MSC_START_USE ();
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_SPGW_APP, &received_message_p);
+    itti_receive_msg (task_id, &received_message_p);
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case S11_CREATE_SESSION_REQUEST:{
@@ -120,7 +124,13 @@ static void *sgw_intertask_interface (void *args_p)
       break;
 
     case TERMINATE_MESSAGE:{
-        sgw_exit();
+        /*
+         * The shared indexes and pools are released by the last shard to
+         * exit, the others may still use them until then.
+         */
+        if (sgw_shard_exit_is_last ()) {
+          sgw_exit();
+        }
         itti_exit_task ();
       }
       break;
@@ -152,14 +162,29 @@ int sgw_init (spgw_config_t *spgw_config_pP)
     return RETURNerror;
   }
 
+  if (sgw_shard_init (spgw_config_pP->sgw_config.nb_workers) < 0) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+    return RETURNerror;
+  }
+
   pgw_ip_address_pool_init (); 
 
-  bstring b = bfromcstr("sgw_s11teid2mme_hashtable");
-  sgw_app.s11teid2mme_hashtable = hashtable_ts_create (512, NULL, NULL, b);
-  btrunc(b, 0);
+  bstring b = bfromcstr("sgw_bearer_context_information_pool");
+  sgw_app.bearer_context_information_pool = slab_pool_create (sizeof (s_plus_p_gw_eps_bearer_context_information_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
+  bassigncstr(b, "sgw_eps_bearer_entry_pool");
+  sgw_app.eps_bearer_entry_pool = slab_pool_create (sizeof (sgw_eps_bearer_entry_t), 0, UE_CONTEXT_POOL_HUGEPAGES, b);
 
-  if (sgw_app.s11teid2mme_hashtable == NULL) {
-    perror ("hashtable_ts_create");
+  if ((sgw_app.bearer_context_information_pool == NULL) || (sgw_app.eps_bearer_entry_pool == NULL)) {
+    bdestroy(b);
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+    return RETURNerror;
+  }
+
+  bassigncstr(b, "sgw_s11teid2mme");
+  sgw_app.s11teid2mme = id_index_create (NULL, b);
+
+  if (sgw_app.s11teid2mme == NULL) {
+    perror ("id_index_create");
     bdestroy(b);
     OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
     return RETURNerror;
@@ -173,13 +198,13 @@ int sgw_init (spgw_config_t *spgw_config_pP)
     return RETURNerror;
   }*/
 
-  bassigncstr(b, "sgw_s11_bearer_context_information_hashtable");
-  sgw_app.s11_bearer_context_information_hashtable = hashtable_ts_create (512, NULL,
+  bassigncstr(b, "sgw_s11_bearer_context_information");
+  sgw_app.s11_bearer_context_information = id_index_create (
           (void (*)(void**))sgw_cm_free_s_plus_p_gw_eps_bearer_context_information,b);
   bdestroy(b);
 
-  if (sgw_app.s11_bearer_context_information_hashtable == NULL) {
-    perror ("hashtable_ts_create");
+  if (sgw_app.s11_bearer_context_information == NULL) {
+    perror ("id_index_create");
     OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
     return RETURNerror;
   }
@@ -191,10 +216,15 @@ int sgw_init (spgw_config_t *spgw_config_pP)
 
   sgw_app.sgw_ip_address_S5_S8_up      = spgw_config_pP->sgw_config.ipv4.S5_S8_up;
 
-  if (itti_create_task (TASK_SPGW_APP, &sgw_intertask_interface, NULL) < 0) {
-    perror ("pthread_create");
-    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
-    return RETURNerror;
+  /*
+   * One task per shard of sessions
+   */
+  for (int shard = 0; shard < sgw_nb_workers; shard++) {
+    if (itti_create_task (sgw_shard_tasks[shard], &sgw_intertask_interface, (void *)(uintptr_t)shard) < 0) {
+      perror ("pthread_create");
+      OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+      return RETURNerror;
+    }
   }
 
   FILE *fp = NULL;
@@ -212,16 +242,23 @@ int sgw_init (spgw_config_t *spgw_config_pP)
 //------------------------------------------------------------------------------
 static void sgw_exit(void)
 {
-
-  if (sgw_app.s11teid2mme_hashtable) {
-    hashtable_ts_destroy (sgw_app.s11teid2mme_hashtable);
+  bstring                                 report = bfromcstr ("");
+
+  sgw_cm_memory_report (report);
+  OAILOG_DEBUG (LOG_SPGW_APP, "Session storage:\n%s\n", bdata (report));
+  bdestroy (report);
+  sgw_shard_exit ();
+  if (sgw_app.s11teid2mme) {
+    id_index_destroy (sgw_app.s11teid2mme);
   }
   /*if (sgw_app.s1uteid2enb_hashtable) {
     hashtable_destroy (sgw_app.s1uteid2enb_hashtable);
   }*/
-  if (sgw_app.s11_bearer_context_information_hashtable) {
-    hashtable_ts_destroy (sgw_app.s11_bearer_context_information_hashtable);
+  if (sgw_app.s11_bearer_context_information) {
+    id_index_destroy (sgw_app.s11_bearer_context_information);
   }
+  slab_pool_destroy (sgw_app.eps_bearer_entry_pool);
+  slab_pool_destroy (sgw_app.bearer_context_information_pool);
 
   //P-GW code
   struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
@@ -0,0 +1,128 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+################################################################################
+# Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.
+# The OpenAirInterface Software Alliance licenses this file to You under
+# the Apache License, Version 2.0  (the "License"); you may not use this file
+# except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+# For more information about the OpenAirInterface (OAI) Software Alliance:
+#      contact@openairinterface.org
+################################################################################
+#
+# Extracts the fuzzing seeds of the S1AP, NAS and GTPv2-C parsers from a
+# capture, the same captures as the ones given to
+# mme_test_s1_generate_scenario_from_pcap:
+#   - every S1AP PDU is written in <output_dir>/s1ap,
+#   - every NAS PDU carried by an S1AP PDU is written in <output_dir>/nas,
+#   - every GTPv2-C message is written in <output_dir>/gtpv2c.
+# The seeds are named <pcap file name>_<frame number>_<index>.bin.
+#
+import sys
+import subprocess
+import json
+import os, errno
+import argparse
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--pcap_file", "-p", type=str, required=True, help="input pcap file to extract the seeds from")
+parser.add_argument("--output_dir", "-o", type=str, default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "corpus"), help="corpus directory, default is the corpus of the fuzz targets")
+parser.add_argument("--uplink_only", "-u", action="store_true", help="only keep the S1AP PDUs sent to the MME (SCTP destination port 36412)")
+args = parser.parse_args()
+
+pcap_file = args.pcap_file.strip()
+pcap_name = os.path.splitext(os.path.basename(pcap_file))[0]
+
+# layer of the JSON output of tshark -> corpus sub directory
+layers = {'s1ap': 's1ap', 'gtpv2': 'gtpv2c'}
+nas_field = 's1ap.NAS_PDU'
+s1ap_port = 36412
+
+
+def mkdir_p(path):
+    try:
+        os.makedirs(path)
+    except OSError as exc:
+        if exc.errno == errno.EEXIST and os.path.isdir(path):
+            pass
+        else:
+            raise
+
+
+def raw_bytes(raw):
+    # depending on the tshark version a raw field is the hex string or [hex, pos, len, bitmask, type]
+    if isinstance(raw, list):
+        raw = raw[0]
+    return bytearray.fromhex(raw.replace(':', ''))
+
+
+def as_list(value):
+    if isinstance(value, list) and len(value) and isinstance(value[0], (dict, list)):
+        return value
+    return [value]
+
+
+def find_fields(node, name, found):
+    # the NAS PDUs are nested in the IEs of the S1AP PDU
+    if isinstance(node, dict):
+        for key, value in node.items():
+            if key == name + '_raw':
+                for raw in as_list(value):
+                    found.append(raw_bytes(raw))
+            else:
+                find_fields(value, name, found)
+    elif isinstance(node, list):
+        for item in node:
+            find_fields(item, name, found)
+    return found
+
+
+def write_seed(directory, frame, index, data):
+    path = os.path.join(args.output_dir, directory, "%s_%d_%d.bin" % (pcap_name, frame, index))
+    with open(path, 'wb') as seed:
+        seed.write(data)
+    print("Wrote %s (%d bytes)" % (path, len(data)))
+
+
+for directory in list(layers.values()) + ['nas']:
+    mkdir_p(os.path.join(args.output_dir, directory))
+
+pcap_json = subprocess.check_output(["tshark", '-T', 'json', '-x', '-Y', 's1ap || gtpv2', '-r', pcap_file])
+packets = json.loads(pcap_json)
+count = 0
+
+for packet in packets:
+    packet_layers = packet['_source']['layers']
+    frame = int(packet_layers['frame']['frame.number'])
+    index = 0
+    if args.uplink_only and 'sctp' in packet_layers:
+        sctp = as_list(packet_layers['sctp'])[0]
+        if int(sctp['sctp.dstport']) != s1ap_port:
+            continue
+    for layer, directory in layers.items():
+        if layer + '_raw' not in packet_layers:
+            continue
+        # a frame carries several S1AP PDUs when several SCTP DATA chunks are bundled
+        for raw in as_list(packet_layers[layer + '_raw']):
+            write_seed(directory, frame, index, raw_bytes(raw))
+            index += 1
+            count += 1
+    if 's1ap' in packet_layers:
+        for nas_pdu in find_fields(packet_layers['s1ap'], nas_field, []):
+            write_seed('nas', frame, index, nas_pdu)
+            index += 1
+            count += 1
+
+print("%d seeds extracted from %s" % (count, pcap_file))
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Decode throughput of a fuzz target: every file of the corpus, one message
+ * type per seed, is given NB_OF_ITERATIONS times to the target and the
+ * number of decodes per second is reported per file.
+ *
+ *   <benchmark> [-n iterations] <file or directory>...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define NB_OF_ITERATIONS     (100 * 1000)
+#define FUZZ_INPUT_MAX_SIZE  (64 * 1024)
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size);
+int LLVMFuzzerInitialize (int *argc, char ***argv) __attribute__ ((weak));
+
+static int                              iterations = NB_OF_ITERATIONS;
+static uint8_t                          input[FUZZ_INPUT_MAX_SIZE];
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int run_file (const char *path)
+{
+  FILE                                   *stream = fopen (path, "rb");
+  const char                             *name = strrchr (path, '/');
+  size_t                                  size = 0;
+  uint64_t                                elapsed = 0;
+
+  if (!stream) {
+    fprintf (stderr, "Cannot open %s\n", path);
+    return 0;
+  }
+  size = fread (input, 1, sizeof (input), stream);
+  fclose (stream);
+
+  elapsed = now_ns ();
+  for (int i = 0; i < iterations; i++) {
+    LLVMFuzzerTestOneInput (input, size);
+  }
+  elapsed = now_ns () - elapsed;
+  if (0 == elapsed) {
+    elapsed = 1;
+  }
+  fprintf (stdout, "%-48s %6zu %10" PRIu64 " %12" PRIu64 "\n", name ? name + 1 : path, size,
+      elapsed / iterations, ((uint64_t) iterations * 1000000000ULL) / elapsed);
+  return 1;
+}
+
+static int run_path (const char *path)
+{
+  struct stat                             st = {0};
+  struct dirent                         **entries = NULL;
+  int                                     nb_entries = 0;
+  int                                     count = 0;
+
+  if (stat (path, &st) < 0) {
+    fprintf (stderr, "Cannot stat %s\n", path);
+    return 0;
+  }
+  if (!S_ISDIR (st.st_mode)) {
+    return run_file (path);
+  }
+  // sorted so that two runs can be compared line by line
+  if ((nb_entries = scandir (path, &entries, NULL, alphasort)) < 0) {
+    return 0;
+  }
+  for (int i = 0; i < nb_entries; i++) {
+    char                                    file[1024];
+
+    if ('.' != entries[i]->d_name[0]) {
+      snprintf (file, sizeof (file), "%s/%s", path, entries[i]->d_name);
+      count += run_path (file);
+    }
+    free (entries[i]);
+  }
+  free (entries);
+  return count;
+}
+
+int main (int argc, char *argv[])
+{
+  int                                     first = 1;
+
+  if ((argc > 2) && (0 == strcmp (argv[1], "-n"))) {
+    iterations = atoi (argv[2]);
+    first = 3;
+  }
+  if ((first >= argc) || (iterations <= 0)) {
+    fprintf (stderr, "Usage: %s [-n iterations] <file or directory>...\n", argv[0]);
+    return 1;
+  }
+  if (LLVMFuzzerInitialize) {
+    LLVMFuzzerInitialize (&argc, &argv);
+  }
+  fprintf (stdout, "%-48s %6s %10s %12s\n", "message", "bytes", "ns/decode", "decodes/s");
+  for (int i = first; i < argc; i++) {
+    run_path (argv[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Fuzz target of the GTPv2-C message parsing done on the S11 datagrams:
+ * the header checks of nwGtpv2cProcessUdpReq, the copy of the datagram by
+ * nwGtpv2cMsgFromBufferNew, the validation of the IEs against the parse info
+ * of the message type and the dispatch of the IEs by nwGtpv2cMsgParserRun
+ * to the S11 IE readers of s11_ie_formatter.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "NwGtpv2cMsgParser.h"
+#include "NwGtpv2cPrivate.h"
+#include "NwGtpv2cMsgIeParseInfo.h"
+#include "3gpp_24.008.h"
+#include "s11_messages_types.h"
+#include "s11_ie_formatter.h"
+
+typedef NwRcT (*ie_reader_t) (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
+
+typedef struct fuzz_ie_s {
+  uint8_t                                 type;
+  ie_reader_t                             reader;
+  size_t                                  size;
+} fuzz_ie_t;
+
+/*
+ * Every reader is given an argument of the exact size of the structure it
+ * fills, so that a write past the structure is detected by ASan
+ */
+static const fuzz_ie_t                  ies[] = {
+  {NW_GTPV2C_IE_IMSI,            s11_imsi_ie_get,               sizeof (Imsi_t)},
+  {NW_GTPV2C_IE_MSISDN,          s11_msisdn_ie_get,             sizeof (Msisdn_t)},
+  {NW_GTPV2C_IE_MEI,             s11_mei_ie_get,                sizeof (Mei_t)},
+  {NW_GTPV2C_IE_NODE_TYPE,       s11_node_type_ie_get,          sizeof (node_type_t)},
+  {NW_GTPV2C_IE_PDN_TYPE,        s11_pdn_type_ie_get,           sizeof (pdn_type_t)},
+  {NW_GTPV2C_IE_RAT_TYPE,        s11_rat_type_ie_get,           sizeof (rat_type_t)},
+  {NW_GTPV2C_IE_EBI,             s11_ebi_ie_get,                sizeof (uint8_t)},
+  {NW_GTPV2C_IE_CAUSE,           s11_cause_ie_get,              sizeof (SGWCause_t)},
+  {NW_GTPV2C_IE_SERVING_NETWORK, s11_serving_network_ie_get,    sizeof (ServingNetwork_t)},
+  {NW_GTPV2C_IE_FTEID,           s11_fteid_ie_get,              sizeof (FTeid_t)},
+  {NW_GTPV2C_IE_PCO,             s11_pco_ie_get,                sizeof (protocol_configuration_options_t)},
+  {NW_GTPV2C_IE_PAA,             s11_paa_ie_get,                sizeof (PAA_t)},
+  {NW_GTPV2C_IE_APN,             s11_apn_ie_get,                APN_MAX_LENGTH + 1},
+  {NW_GTPV2C_IE_AMBR,            s11_ambr_ie_get,               sizeof (ambr_t)},
+  {NW_GTPV2C_IE_ULI,             s11_uli_ie_get,                sizeof (Uli_t)},
+  {NW_GTPV2C_IE_BEARER_LEVEL_QOS, s11_bearer_qos_ie_get,        sizeof (BearerQOS_t)},
+  {NW_GTPV2C_IE_IP_ADDRESS,      s11_ip_address_ie_get,         sizeof (gtp_ip_address_t)},
+  {NW_GTPV2C_IE_DELAY_VALUE,     s11_delay_value_ie_get,        sizeof (DelayValue_t)},
+  {NW_GTPV2C_IE_UE_TIME_ZONE,    s11_ue_time_zone_ie_get,       sizeof (UETimeZone_t)},
+  {NW_GTPV2C_IE_TARGET_IDENTIFICATION, s11_target_identification_ie_get, sizeof (target_identification_t)},
+  {NW_GTPV2C_IE_BEARER_FLAGS,    s11_bearer_flags_ie_get,       sizeof (bearer_flags_t)},
+  {NW_GTPV2C_IE_INDICATION,      s11_indication_flags_ie_get,   sizeof (indication_flags_t)},
+  {NW_GTPV2C_IE_FQ_CSID,         s11_fqcsid_ie_get,             sizeof (FQ_CSID_t)},
+};
+
+#define NB_OF_IES  (sizeof (ies) / sizeof (ies[0]))
+
+// a reader is registered for every instance an IE can have
+#define FUZZ_IE_INSTANCES  (NW_GTPV2C_IE_INSTANCE_MAXIMUM)
+
+/*
+ * The parser functions only use the stack handle for their memory manager,
+ * a zeroed stack falls back on malloc
+ */
+static NwGtpv2cStackT                   stack;
+static NwGtpv2cStackHandleT             hStack = 0;
+static NwGtpv2cMsgIeParseInfoT         *parse_info[256] = {NULL};
+
+/*
+ * The arguments of the readers are allocated once, so that the time spent
+ * per input is the one of the parsing when the target is benchmarked
+ */
+static void                            *args[NB_OF_IES][FUZZ_IE_INSTANCES] = {{NULL}};
+static void                            *bearer_args[3][FUZZ_IE_INSTANCES] = {{NULL}};
+
+static const size_t                     bearer_sizes[3] = {
+  sizeof (bearer_contexts_to_be_created_t),
+  sizeof (bearer_contexts_to_be_modified_t),
+  sizeof (bearer_contexts_created_t),
+};
+
+int LLVMFuzzerInitialize (int *argc, char ***argv)
+{
+  hStack = (NwGtpv2cStackHandleT) & stack;
+  for (int type = 0; type < 256; type++) {
+    parse_info[type] = nwGtpv2cMsgIeParseInfoNew (hStack, (uint8_t) type);
+  }
+  for (int instance = 0; instance < FUZZ_IE_INSTANCES; instance++) {
+    for (int i = 0; i < NB_OF_IES; i++) {
+      args[i][instance] = calloc (1, ies[i].size);
+    }
+    for (int i = 0; i < 3; i++) {
+      bearer_args[i][instance] = calloc (1, bearer_sizes[i]);
+    }
+  }
+  return 0;
+}
+
+/*
+ * The bearer context reader of a message depends on its type, as in the
+ * S11 handlers of the MME and of the SGW
+ */
+static ie_reader_t bearer_context_reader (const uint8_t msgType, int * const index)
+{
+  switch (msgType) {
+  case NW_GTP_CREATE_SESSION_REQ:
+    *index = 0;
+    return s11_bearer_context_to_be_created_ie_get;
+
+  case NW_GTP_MODIFY_BEARER_REQ:
+    *index = 1;
+    return s11_bearer_context_to_be_modified_ie_get;
+
+  default:
+    *index = 2;
+    return s11_bearer_context_created_ie_get;
+  }
+}
+
+static void run_parser (const uint8_t msgType, NwGtpv2cMsgHandleT hMsg)
+{
+  NwGtpv2cMsgParserT                     *parser = NULL;
+  ie_reader_t                             bearer_reader = NULL;
+  int                                     bearer_index = 0;
+  uint8_t                                 offendingIeType = 0;
+  uint8_t                                 offendingIeInstance = 0;
+  uint16_t                                offendingIeLength = 0;
+
+  if (NW_OK != nwGtpv2cMsgParserNew (hStack, msgType, NULL, NULL, &parser)) {
+    return;
+  }
+  bearer_reader = bearer_context_reader (msgType, &bearer_index);
+  for (int instance = 0; instance < FUZZ_IE_INSTANCES; instance++) {
+    for (int i = 0; i < NB_OF_IES; i++) {
+      nwGtpv2cMsgParserAddIe (parser, ies[i].type, instance, NW_GTPV2C_IE_PRESENCE_OPTIONAL, ies[i].reader, args[i][instance]);
+    }
+    nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_BEARER_CONTEXT, instance, NW_GTPV2C_IE_PRESENCE_OPTIONAL, bearer_reader, bearer_args[bearer_index][instance]);
+  }
+
+  nwGtpv2cMsgParserRun (parser, hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+
+  nwGtpv2cMsgParserDelete (hStack, parser);
+  for (int instance = 0; instance < FUZZ_IE_INSTANCES; instance++) {
+    for (int i = 0; i < NB_OF_IES; i++) {
+      if (NW_GTPV2C_IE_PCO == ies[i].type) {
+        clear_protocol_configuration_options (args[i][instance]);
+      }
+      memset (args[i][instance], 0, ies[i].size);
+    }
+    memset (bearer_args[bearer_index][instance], 0, bearer_sizes[bearer_index]);
+  }
+}
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+  NwGtpv2cMsgHandleT                      hMsg = 0;
+  NwGtpv2cErrorT                          error = {0};
+  uint8_t                                 msgType = 0;
+
+  // the checks done by nwGtpv2cProcessUdpReq before anything is parsed
+  if ((size < NW_GTPV2C_MINIMUM_HEADER_SIZE) || (size > NW_GTPV2C_MAX_MSG_LEN)) {
+    return 0;
+  }
+  if ((ntohs (*((uint16_t *) & data[2])) + ((data[0] & 0x08) ? 4 : 0)) > size) {
+    return 0;
+  }
+  if (NW_GTP_VERSION != (data[0] >> 5)) {
+    return 0;
+  }
+  msgType = data[1];
+
+  if (NW_OK != nwGtpv2cMsgFromBufferNew (hStack, (uint8_t *) data, size, &hMsg)) {
+    return 0;
+  }
+  if (parse_info[msgType]) {
+    nwGtpv2cMsgIeParse (parse_info[msgType], hMsg, &error);
+  }
+  run_parser (msgType, hMsg);
+  nwGtpv2cMsgDelete (hStack, hMsg);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Standalone driver of the fuzz targets, linked instead of libFuzzer:
+ *  - with files or directories as arguments, every file is given once to
+ *    the target, to replay a corpus or a crash,
+ *  - without argument, the standard input is given to the target, which is
+ *    what AFL expects from a binary built with afl-gcc or afl-clang-fast.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define FUZZ_INPUT_MAX_SIZE  (64 * 1024)
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size);
+int LLVMFuzzerInitialize (int *argc, char ***argv) __attribute__ ((weak));
+
+static uint8_t                          input[FUZZ_INPUT_MAX_SIZE];
+
+static int run_stream (FILE * stream)
+{
+  const size_t                            size = fread (input, 1, sizeof (input), stream);
+  uint8_t                                *data = malloc (size ? size : 1);
+
+  // an exact copy so that a read past the end of the input is detected by ASan
+  memcpy (data, input, size);
+  LLVMFuzzerTestOneInput (data, size);
+  free (data);
+  return 1;
+}
+
+static int run_file (const char *path)
+{
+  FILE                                   *stream = fopen (path, "rb");
+  int                                     count = 0;
+
+  if (!stream) {
+    fprintf (stderr, "Cannot open %s\n", path);
+    return 0;
+  }
+  count = run_stream (stream);
+  fclose (stream);
+  return count;
+}
+
+static int run_path (const char *path)
+{
+  struct stat                             st = {0};
+  struct dirent                          *entry = NULL;
+  DIR                                    *dir = NULL;
+  int                                     count = 0;
+
+  if (stat (path, &st) < 0) {
+    fprintf (stderr, "Cannot stat %s\n", path);
+    return 0;
+  }
+  if (!S_ISDIR (st.st_mode)) {
+    return run_file (path);
+  }
+  if (!(dir = opendir (path))) {
+    return 0;
+  }
+  while ((entry = readdir (dir))) {
+    char                                    file[1024];
+
+    if ('.' == entry->d_name[0]) {
+      continue;
+    }
+    snprintf (file, sizeof (file), "%s/%s", path, entry->d_name);
+    count += run_path (file);
+  }
+  closedir (dir);
+  return count;
+}
+
+int main (int argc, char *argv[])
+{
+  int                                     count = 0;
+
+  if (LLVMFuzzerInitialize) {
+    LLVMFuzzerInitialize (&argc, &argv);
+  }
+  if (argc < 2) {
+    run_stream (stdin);
+    return 0;
+  }
+  for (int i = 1; i < argc; i++) {
+    count += run_path (argv[i]);
+  }
+  fprintf (stdout, "%s: %d inputs run\n", argv[0], count);
+  return 0;
+}
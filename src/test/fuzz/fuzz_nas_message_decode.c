@@ -0,0 +1,79 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Fuzz target of nas_message_decode, the entry point of the uplink NAS
+ * messages received in S1AP NAS PDU IEs. Every input is decoded twice:
+ * without security context, as for an Attach Request of an unknown UE, and
+ * with an EIA2/EEA2 security context, so that the integrity check and the
+ * deciphering paths are reached too.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.301.h"
+#include "nas_message.h"
+#include "secu_defs.h"
+#include "emmData.h"
+
+/*
+ * The decoded messages own bstrings and there is no function to release a
+ * decoded nas_message_t, the leaks are not what this target looks for
+ */
+const char *__asan_default_options (void)
+{
+  return "detect_leaks=0";
+}
+
+static emm_security_context_t           security;
+
+static void security_init (emm_security_context_t * const sc)
+{
+  memset (sc, 0, sizeof (*sc));
+  for (int i = 0; i < AUTH_KNAS_ENC_SIZE; i++) {
+    sc->knas_enc[i] = (uint8_t)(i * 3);
+    sc->knas_int[i] = (uint8_t)(i * 5);
+  }
+  sc->selected_algorithms.encryption = NAS_SECURITY_ALGORITHMS_EEA2;
+  sc->selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA2;
+}
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+  nas_message_t                           msg;
+  nas_message_decode_status_t             status;
+
+  memset (&msg, 0, sizeof (msg));
+  memset (&status, 0, sizeof (status));
+  nas_message_decode (data, &msg, size, NULL, &status);
+
+  // the sequence numbers of the context are updated by the decoder
+  security_init (&security);
+  memset (&msg, 0, sizeof (msg));
+  memset (&status, 0, sizeof (status));
+  nas_message_decode (data, &msg, size, &security, &status);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Fuzz target of s1ap_mme_decode_pdu, the decoder of the S1AP PDUs received
+ * from the eNBs on the SCTP associations: APER decoding of the PDU, decoding
+ * of the IEs of the procedure and XER dump of the message sent to the ITTI
+ * logger.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "intertask_interface.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_decoder.h"
+
+/*
+ * The decoder sends the XER dump of every message to the ITTI logger task,
+ * ITTI is not started by the target so the message is only released
+ */
+MessageDef *itti_alloc_new_message_sized (task_id_t origin_task_id, MessagesIds message_id, MessageHeaderSize size)
+{
+  MessageDef                             *message_p = calloc (1, sizeof (MessageHeader) + size);
+
+  message_p->ittiMsgHeader.messageId = message_id;
+  message_p->ittiMsgHeader.originTaskId = origin_task_id;
+  message_p->ittiMsgHeader.ittiMsgSize = size;
+  return message_p;
+}
+
+int itti_send_msg_to_task (task_id_t task_id, instance_t instance, MessageDef *message)
+{
+  free (message);
+  return 0;
+}
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+  s1ap_message                            message;
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  bstring                                 raw = blk2bstr (data, size);
+
+  memset (&message, 0, sizeof (message));
+  if (0 == s1ap_mme_decode_pdu (&message, raw, &message_id)) {
+    s1ap_free_mme_decode_pdu (&message, message_id);
+  }
+  bdestroy (raw);
+  return 0;
+}
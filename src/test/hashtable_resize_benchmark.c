@@ -0,0 +1,122 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Insert latency percentiles of the hash tables while they grow by themselves
+ * from 1k buckets to 10M elements, resizes included.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+#include "obj_hashtable.h"
+
+#define INITIAL_SIZE      1024
+#define NB_OF_ELEMENTS    (10 * 1000 * 1000)
+
+static uint32_t                         latency_ns[NB_OF_ELEMENTS];
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int compare_latency (const void *a, const void *b)
+{
+  const uint32_t                          la = *(const uint32_t *)a;
+  const uint32_t                          lb = *(const uint32_t *)b;
+
+  return (la > lb) - (la < lb);
+}
+
+static void report (const char *title, const uint64_t total_ns, const hash_size_t final_size)
+{
+  static const double                     percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99, 99.999};
+
+  qsort (latency_ns, NB_OF_ELEMENTS, sizeof (latency_ns[0]), compare_latency);
+  printf ("%-24s %d inserts, %zu buckets, %.1f ns/insert\n", title, NB_OF_ELEMENTS, final_size, (double)total_ns / NB_OF_ELEMENTS);
+  for (int i = 0; i < sizeof (percentiles) / sizeof (percentiles[0]); i++) {
+    printf ("%-24s   p%-7g %8" PRIu32 " ns\n", title, percentiles[i], latency_ns[(size_t)((percentiles[i] / 100.0) * (NB_OF_ELEMENTS - 1))]);
+  }
+  printf ("%-24s   max      %8" PRIu32 " ns\n", title, latency_ns[NB_OF_ELEMENTS - 1]);
+}
+
+static void run_hashtable_ts (void)
+{
+  bstring                                 name = bfromcstr ("hashtable_ts");
+  hash_table_ts_t                        *htbl = hashtable_ts_create (INITIAL_SIZE, NULL, hash_free_int_func, name);
+  uint64_t                                start = now_ns ();
+  uint64_t                                t0 = 0;
+  void                                   *data = NULL;
+
+  for (uint64_t k = 0; k < NB_OF_ELEMENTS; k++) {
+    t0 = now_ns ();
+    hashtable_ts_insert (htbl, k * 2654435761ULL, (void *)(uintptr_t)(k + 1));
+    latency_ns[k] = (uint32_t)(now_ns () - t0);
+  }
+  report ("hashtable_ts_insert", now_ns () - start, htbl->size);
+  for (uint64_t k = 0; k < NB_OF_ELEMENTS; k++) {
+    if ((HASH_TABLE_OK != hashtable_ts_get (htbl, k * 2654435761ULL, &data)) || ((uintptr_t)data != k + 1)) {
+      printf ("hashtable_ts lost key %" PRIu64 "\n", k);
+      exit (EXIT_FAILURE);
+    }
+  }
+  hashtable_ts_destroy (htbl);
+  bdestroy (name);
+}
+
+static void run_obj_hashtable_ts (void)
+{
+  bstring                                 name = bfromcstr ("obj_hashtable_ts");
+  obj_hash_table_t                       *htbl = obj_hashtable_ts_create (INITIAL_SIZE, NULL, NULL, hash_free_int_func, name);
+  uint64_t                                start = now_ns ();
+  uint64_t                                t0 = 0;
+  void                                   *data = NULL;
+
+  for (uint64_t k = 0; k < NB_OF_ELEMENTS; k++) {
+    t0 = now_ns ();
+    obj_hashtable_ts_insert (htbl, &k, sizeof (k), (void *)(uintptr_t)(k + 1));
+    latency_ns[k] = (uint32_t)(now_ns () - t0);
+  }
+  report ("obj_hashtable_ts_insert", now_ns () - start, htbl->size);
+  for (uint64_t k = 0; k < NB_OF_ELEMENTS; k++) {
+    if ((HASH_TABLE_OK != obj_hashtable_ts_get (htbl, &k, sizeof (k), &data)) || ((uintptr_t)data != k + 1)) {
+      printf ("obj_hashtable_ts lost key %" PRIu64 "\n", k);
+      exit (EXIT_FAILURE);
+    }
+  }
+  obj_hashtable_ts_destroy (htbl);
+  bdestroy (name);
+}
+
+int main (int argc, char *argv[])
+{
+  run_hashtable_ts ();
+  run_obj_hashtable_ts ();
+  return 0;
+}
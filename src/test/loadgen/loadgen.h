@@ -0,0 +1,260 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen.h
+  \brief Synthetic eNB/UE load generator of the MME: simulated eNBs connected
+  over SCTP, each serving simulated UEs that run attach, detach, tracking area
+  update and service request procedures with NAS security.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_LOADGEN_SEEN
+#define FILE_LOADGEN_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "metrics.h"
+
+/*
+ * The eNBs are spread over the worker threads, a worker owns its eNBs, their
+ * UEs and the timers of these UEs: nothing is shared between workers but the
+ * configuration and the metrics (per thread slots).
+ */
+#define LOADGEN_MAX_WORKERS               (METRICS_MAX_SLOTS - 2)
+
+/*
+ * The eNB UE S1AP ID of a UE is its index in the eNB plus a generation,
+ * incremented every time the UE gives up its S1 connection on a timeout, so
+ * that the late messages of the MME for the previous connection are dropped.
+ */
+#define LOADGEN_MAX_UES_PER_ENB           (1 << 16)
+#define LOADGEN_ENB_UE_S1AP_ID(iNDEX, gEN)  ((((uint32_t)(gEN)) << 16) | (iNDEX))
+#define LOADGEN_ENB_UE_S1AP_ID_INDEX(iD)    ((iD) & 0xFFFF)
+#define LOADGEN_ENB_UE_S1AP_ID_GEN(iD)      (((iD) >> 16) & 0xFF)
+
+#define LOADGEN_S1AP_PORT                 36412
+#define LOADGEN_S1AP_PPID                 18
+#define LOADGEN_SCTP_STREAMS              32
+#define LOADGEN_MAX_PDU_SIZE              2048
+
+#define LOADGEN_TIMER_NONE                UINT32_MAX
+
+typedef enum loadgen_procedure_e {
+  LOADGEN_PROC_NONE = -1,
+  LOADGEN_PROC_ATTACH = 0,
+  LOADGEN_PROC_DETACH,
+  LOADGEN_PROC_TAU,
+  LOADGEN_PROC_SERVICE_REQUEST,
+  LOADGEN_PROC_RELEASE,
+  LOADGEN_PROC_MAX
+} loadgen_procedure_t;
+
+extern const char * const               loadgen_procedure_names[LOADGEN_PROC_MAX];
+
+typedef struct loadgen_config_s {
+  char                                   *mme_address;
+  char                                   *local_address;      // NULL: any
+  uint16_t                                mme_port;
+  uint32_t                                nb_enbs;
+  uint32_t                                nb_ues;
+  uint32_t                                nb_workers;
+  uint32_t                                attach_rate;        // initial attaches per second, 0: no limit
+  uint32_t                                think_time_ms;      // mean time between two procedures of a UE
+  uint32_t                                timeout_ms;         // of a procedure, S1 release included
+  uint32_t                                duration_s;         // 0: until interrupted
+  uint32_t                                weights[LOADGEN_PROC_MAX]; // procedure mix of the idle UEs
+  uint16_t                                mcc;
+  uint16_t                                mnc;
+  uint8_t                                 mnc_digit_length;
+  uint16_t                                tac;
+  uint32_t                                enb_id_base;        // macro eNB ID of the first eNB
+  uint64_t                                imsi_base;          // IMSI of the first UE
+  uint8_t                                 k[16];
+  uint8_t                                 opc[16];
+  uint16_t                                metrics_port;       // 0: no metrics server
+  uint8_t                                 plmn[3];            // TBCD, derived from mcc, mnc
+  uint8_t                                 s1u_address[4];     // of the eNBs in the E-RAB setup items
+} loadgen_config_t;
+
+extern loadgen_config_t                 loadgen_config;
+
+struct loadgen_enb_s;
+struct loadgen_worker_s;
+
+typedef struct loadgen_ue_s {
+  uint64_t                                imsi;
+  uint64_t                                deadline_ns;        // of the armed timer
+  uint64_t                                procedure_start_ns;
+  struct loadgen_enb_s                   *enb;
+  uint32_t                                timer_index;        // in the timer heap of the worker
+  uint32_t                                mme_ue_s1ap_id;
+  uint32_t                                enb_ue_s1ap_id;
+  uint16_t                                index;              // in the eNB
+  uint8_t                                 generation;
+  int8_t                                  procedure;          // loadgen_procedure_t
+  bool                                    registered;
+  bool                                    connected;          // S1 connection established
+  bool                                    completed;          // procedure done, waiting for the S1 release
+  bool                                    rejected;
+  bool                                    secured;            // EPS security context in use
+
+  // EPS security context
+  uint8_t                                 ksi;
+  uint8_t                                 eea;
+  uint8_t                                 eia;
+  uint32_t                                ul_count;
+  uint32_t                                dl_count;
+  uint8_t                                 kasme[32];
+  uint8_t                                 knas_enc[16];
+  uint8_t                                 knas_int[16];
+
+  // allocated by the MME
+  uint8_t                                 guti_plmn[3];
+  uint16_t                                mme_gid;
+  uint8_t                                 mme_code;
+  uint32_t                                m_tmsi;
+  uint8_t                                 ebi;                // default bearer, 0 until the Attach Accept
+  uint8_t                                 pti;                // of the Activate Default EPS Bearer Context Request
+} loadgen_ue_t;
+
+typedef struct loadgen_enb_s {
+  struct loadgen_worker_s                *worker;
+  int                                     fd;
+  uint32_t                                enb_id;
+  bool                                    setup;              // S1 Setup Response received
+  uint8_t                                 overload_level;     // s1ap_overload_level_t of the last OVERLOAD START
+  uint16_t                                outstreams;
+  uint8_t                                 cell_id[4];         // E-UTRAN cell identity, 28 bits
+  uint32_t                                nb_ues;
+  loadgen_ue_t                           *ues;
+} loadgen_enb_t;
+
+typedef struct loadgen_worker_s {
+  pthread_t                               thread;
+  uint32_t                                index;
+  int                                     epoll_fd;
+  uint32_t                                seed;
+  uint32_t                                nb_enbs;
+  loadgen_enb_t                          *enbs;
+  uint32_t                                nb_ues;
+  // min heap of the UE timers, on deadline_ns
+  uint32_t                                nb_timers;
+  loadgen_ue_t                          **timers;
+} loadgen_worker_t;
+
+typedef struct loadgen_procedure_metrics_s {
+  metric_id_t                             started;
+  metric_id_t                             completed;
+  metric_id_t                             rejected;
+  metric_id_t                             timed_out;
+  metric_id_t                             latency;
+} loadgen_procedure_metrics_t;
+
+typedef struct loadgen_metrics_s {
+  loadgen_procedure_metrics_t             procedures[LOADGEN_PROC_MAX];
+  metric_id_t                             enbs_setup;
+  metric_id_t                             ues_registered;
+  metric_id_t                             s1ap_sent;
+  metric_id_t                             s1ap_received;
+  metric_id_t                             s1ap_errors;
+  metric_id_t                             nas_errors;
+  metric_id_t                             overload_rejected;
+} loadgen_metrics_t;
+
+extern loadgen_metrics_t                loadgen_metrics;
+
+extern volatile bool                    loadgen_running;
+
+//------------------------------------------------------------------------------
+// loadgen_usim.c: authentication of the UE
+
+/*
+ * Checks the AUTN of an Authentication Request, computes RES and KASME.
+ * Returns RETURNerror on a MAC failure.
+ */
+int loadgen_usim_authenticate (const uint8_t rand[16], const uint8_t autn[16], uint8_t res[8], uint8_t kasme[32]);
+
+//------------------------------------------------------------------------------
+// loadgen_nas.c: uplink NAS messages and NAS security of the UE
+
+int loadgen_nas_attach_request (const loadgen_ue_t * const ue, uint8_t *buffer);
+int loadgen_nas_authentication_response (const uint8_t res[8], uint8_t *buffer);
+int loadgen_nas_identity_response (const loadgen_ue_t * const ue, uint8_t *buffer);
+int loadgen_nas_security_mode_complete (uint8_t *buffer);
+int loadgen_nas_attach_complete (const loadgen_ue_t * const ue, const uint8_t pti, uint8_t *buffer);
+int loadgen_nas_tracking_area_update_request (const loadgen_ue_t * const ue, uint8_t *buffer);
+int loadgen_nas_tracking_area_update_complete (uint8_t *buffer);
+int loadgen_nas_detach_request (const loadgen_ue_t * const ue, uint8_t *buffer);
+int loadgen_nas_detach_accept (uint8_t *buffer);
+
+// Integrity protects (and ciphers) plain into out, out and plain may not overlap
+int loadgen_nas_protect (loadgen_ue_t * const ue, const uint8_t security_header_type, const uint8_t *plain, const int length, uint8_t *out);
+int loadgen_nas_service_request (loadgen_ue_t * const ue, uint8_t *buffer);
+
+/*
+ * Checks the MAC of a downlink NAS message and deciphers it in place, returns
+ * the offset of the plain message in pdu or RETURNerror.
+ */
+int loadgen_nas_unprotect (loadgen_ue_t * const ue, uint8_t *pdu, const int length);
+
+// Derives the NAS keys of the algorithms selected by a Security Mode Command
+void loadgen_nas_derive_keys (loadgen_ue_t * const ue);
+
+//------------------------------------------------------------------------------
+// loadgen_s1ap.c: S1AP messages of the eNBs
+
+int loadgen_s1ap_s1_setup_request (loadgen_enb_t * const enb);
+int loadgen_s1ap_initial_ue_message (loadgen_ue_t * const ue, uint8_t *nas, const int length, const long rrc_cause, const bool s_tmsi);
+int loadgen_s1ap_uplink_nas_transport (loadgen_ue_t * const ue, uint8_t *nas, const int length);
+int loadgen_s1ap_initial_context_setup_response (loadgen_ue_t * const ue, const long e_rab_id);
+int loadgen_s1ap_ue_context_release_request (loadgen_ue_t * const ue);
+int loadgen_s1ap_ue_context_release_complete (loadgen_enb_t * const enb, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id);
+
+// Decodes a PDU received on the association of the eNB and runs its handler
+int loadgen_s1ap_handle_pdu (loadgen_enb_t * const enb, const uint8_t * const buffer, const uint32_t length);
+
+//------------------------------------------------------------------------------
+// loadgen_enb.c: SCTP associations of the eNBs
+
+int  loadgen_enb_connect (loadgen_enb_t * const enb);
+int  loadgen_enb_send (loadgen_enb_t * const enb, const uint16_t stream, const uint8_t * const buffer, const uint32_t length);
+void loadgen_enb_receive (loadgen_enb_t * const enb);
+void loadgen_enb_close (loadgen_enb_t * const enb);
+
+//------------------------------------------------------------------------------
+// loadgen_ue.c: procedures of the UEs and their timers
+
+void loadgen_ue_init (loadgen_ue_t * const ue, loadgen_enb_t * const enb, const uint16_t index, const uint64_t imsi);
+void loadgen_ue_timer_arm (loadgen_ue_t * const ue, const uint64_t deadline_ns);
+void loadgen_ue_timer_expired (loadgen_ue_t * const ue);
+uint64_t loadgen_ue_next_deadline (const loadgen_worker_t * const worker);
+loadgen_ue_t *loadgen_ue_pop_expired (loadgen_worker_t * const worker, const uint64_t now_ns);
+
+loadgen_ue_t *loadgen_ue_find (loadgen_enb_t * const enb, const uint32_t enb_ue_s1ap_id);
+void loadgen_ue_downlink_nas (loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id, uint8_t *pdu, const int length);
+void loadgen_ue_initial_context_setup (loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id, const long e_rab_id, uint8_t *pdu, const int length);
+// The UE Context Release Complete is sent by the S1AP layer
+void loadgen_ue_context_release (loadgen_ue_t * const ue);
+
+#endif /* FILE_LOADGEN_SEEN */
@@ -0,0 +1,187 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_enb.c
+  \brief SCTP associations of the simulated eNBs: one one-to-one socket per
+  eNB, non blocking once connected and polled by the epoll of its worker.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "common_defs.h"
+#include "loadgen.h"
+
+//------------------------------------------------------------------------------
+int loadgen_enb_connect (loadgen_enb_t * const enb)
+{
+  struct sctp_initmsg                     init = {0};
+  struct sctp_event_subscribe             events = {0};
+  struct sctp_status                      status = {0};
+  struct sockaddr_in                      addr = {0};
+  struct epoll_event                      event = {0};
+  socklen_t                               status_length = sizeof (status);
+  int                                     sd = -1;
+
+  if ((sd = socket (AF_INET, SOCK_STREAM, IPPROTO_SCTP)) < 0) {
+    fprintf (stderr, "eNB %u: socket: %s\n", enb->enb_id, strerror (errno));
+    return RETURNerror;
+  }
+  init.sinit_num_ostreams = LOADGEN_SCTP_STREAMS;
+  init.sinit_max_instreams = LOADGEN_SCTP_STREAMS;
+  init.sinit_max_attempts = 3;
+  if (setsockopt (sd, IPPROTO_SCTP, SCTP_INITMSG, &init, sizeof (init)) < 0) {
+    fprintf (stderr, "eNB %u: setsockopt SCTP_INITMSG: %s\n", enb->enb_id, strerror (errno));
+    goto error;
+  }
+  // the stream of the received messages is not used, the notifications are skipped
+  events.sctp_data_io_event = 1;
+  if (setsockopt (sd, IPPROTO_SCTP, SCTP_EVENTS, &events, sizeof (events)) < 0) {
+    fprintf (stderr, "eNB %u: setsockopt SCTP_EVENTS: %s\n", enb->enb_id, strerror (errno));
+    goto error;
+  }
+
+  addr.sin_family = AF_INET;
+  if (loadgen_config.local_address) {
+    if (inet_pton (AF_INET, loadgen_config.local_address, &addr.sin_addr) != 1) {
+      fprintf (stderr, "Invalid local address %s\n", loadgen_config.local_address);
+      goto error;
+    }
+    if (bind (sd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+      fprintf (stderr, "eNB %u: bind: %s\n", enb->enb_id, strerror (errno));
+      goto error;
+    }
+  }
+  addr.sin_port = htons (loadgen_config.mme_port);
+  if (inet_pton (AF_INET, loadgen_config.mme_address, &addr.sin_addr) != 1) {
+    fprintf (stderr, "Invalid MME address %s\n", loadgen_config.mme_address);
+    goto error;
+  }
+  if (connect (sd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    fprintf (stderr, "eNB %u: connect to %s:%u: %s\n", enb->enb_id, loadgen_config.mme_address, loadgen_config.mme_port, strerror (errno));
+    goto error;
+  }
+  if (getsockopt (sd, IPPROTO_SCTP, SCTP_STATUS, &status, &status_length) < 0) {
+    fprintf (stderr, "eNB %u: getsockopt SCTP_STATUS: %s\n", enb->enb_id, strerror (errno));
+    goto error;
+  }
+  enb->outstreams = status.sstat_outstrms;
+
+  if (fcntl (sd, F_SETFL, fcntl (sd, F_GETFL) | O_NONBLOCK) < 0) {
+    fprintf (stderr, "eNB %u: fcntl: %s\n", enb->enb_id, strerror (errno));
+    goto error;
+  }
+  event.events = EPOLLIN;
+  event.data.ptr = enb;
+  if (epoll_ctl (enb->worker->epoll_fd, EPOLL_CTL_ADD, sd, &event) < 0) {
+    fprintf (stderr, "eNB %u: epoll_ctl: %s\n", enb->enb_id, strerror (errno));
+    goto error;
+  }
+  enb->fd = sd;
+  return loadgen_s1ap_s1_setup_request (enb);
+
+error:
+  close (sd);
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_enb_send (loadgen_enb_t * const enb, const uint16_t stream, const uint8_t * const buffer, const uint32_t length)
+{
+  struct pollfd                           pfd = {.fd = enb->fd,.events = POLLOUT };
+  int                                     rc = RETURNok;
+
+  while (sctp_sendmsg (enb->fd, buffer, length, NULL, 0, htonl (LOADGEN_S1AP_PPID), 0, stream, 0, 0) < 0) {
+    if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+      fprintf (stderr, "eNB %u: sctp_sendmsg: %s\n", enb->enb_id, strerror (errno));
+      metrics_counter_add (loadgen_metrics.s1ap_errors, 1);
+      rc = RETURNerror;
+      break;
+    }
+    // the send buffer of the association is full, the MME is lagging behind
+    poll (&pfd, 1, 100);
+  }
+  if (RETURNok == rc) {
+    metrics_counter_add (loadgen_metrics.s1ap_sent, 1);
+  }
+  free ((void *)buffer);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_receive (loadgen_enb_t * const enb)
+{
+  uint8_t                                 buffer[LOADGEN_MAX_PDU_SIZE * 4];
+  struct sctp_sndrcvinfo                  sinfo = {0};
+  int                                     flags = 0;
+  ssize_t                                 n = 0;
+
+  for (;;) {
+    flags = 0;
+    n = sctp_recvmsg (enb->fd, buffer, sizeof (buffer), NULL, NULL, &sinfo, &flags);
+    if (n < 0) {
+      if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+        fprintf (stderr, "eNB %u: sctp_recvmsg: %s\n", enb->enb_id, strerror (errno));
+        loadgen_enb_close (enb);
+      }
+      return;
+    }
+    if (0 == n) {
+      fprintf (stderr, "eNB %u: association closed by the MME\n", enb->enb_id);
+      loadgen_enb_close (enb);
+      return;
+    }
+    if (flags & MSG_NOTIFICATION) {
+      continue;
+    }
+    loadgen_s1ap_handle_pdu (enb, buffer, n);
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_close (loadgen_enb_t * const enb)
+{
+  if (enb->fd < 0) {
+    return;
+  }
+  epoll_ctl (enb->worker->epoll_fd, EPOLL_CTL_DEL, enb->fd, NULL);
+  close (enb->fd);
+  enb->fd = -1;
+  if (enb->setup) {
+    metrics_gauge_add (loadgen_metrics.enbs_setup, -1);
+  }
+  // the UEs of the eNB stay idle, their timers only check the setup
+  enb->setup = false;
+}
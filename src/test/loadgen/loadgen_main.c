@@ -0,0 +1,523 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_main.c
+  \brief Synthetic eNB/UE load generator of the MME. The eNBs connect to the
+  MME over SCTP and set up their S1 interface, then their UEs attach at the
+  configured rate and keep running procedures until the end of the test. The
+  procedures per second and the registered UEs are printed every second, the
+  counts and latency percentiles of every procedure at the end; the same
+  metrics can be scraped over HTTP.
+  The subscribers are expected in the HSS with the IMSIs from the IMSI base
+  and the K and OPc of the generator, all UEs share the same keys.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+
+#include "common_defs.h"
+#include "loadgen.h"
+
+#define NS_PER_S                          1000000000ULL
+#define LOADGEN_MAX_EPOLL_EVENTS          64
+#define LOADGEN_MAX_EPOLL_WAIT_MS         100
+
+loadgen_config_t                        loadgen_config = {
+  .mme_address = "127.0.0.1",
+  .local_address = NULL,
+  .mme_port = LOADGEN_S1AP_PORT,
+  .nb_enbs = 1,
+  .nb_ues = 1000,
+  .nb_workers = 1,
+  .attach_rate = 100,
+  .think_time_ms = 10000,
+  .timeout_ms = 10000,
+  .duration_s = 60,
+  .weights = {
+    [LOADGEN_PROC_ATTACH] = 0,
+    [LOADGEN_PROC_DETACH] = 10,
+    [LOADGEN_PROC_TAU] = 30,
+    [LOADGEN_PROC_SERVICE_REQUEST] = 60,
+    [LOADGEN_PROC_RELEASE] = 0,
+  },
+  // first TAI of etc/mme.conf
+  .mcc = 1,
+  .mnc = 1,
+  .mnc_digit_length = 2,
+  .tac = 205,
+  .enb_id_base = 1,
+  .imsi_base = 1010000000001ULL,
+  // TS 35.208 test set 1
+  .k = {0x46, 0x5b, 0x5c, 0xe8, 0xb1, 0x99, 0xb4, 0x9f, 0xaa, 0x5f, 0x0a, 0x2e, 0xe2, 0x38, 0xa6, 0xbc},
+  .opc = {0xcd, 0x63, 0xcb, 0x71, 0x95, 0x4a, 0x9f, 0x4e, 0x48, 0xa5, 0x99, 0x4e, 0x37, 0xa0, 0x2b, 0xaf},
+  .metrics_port = 0,
+  .s1u_address = {127, 0, 0, 1},
+};
+
+loadgen_metrics_t                       loadgen_metrics;
+volatile bool                           loadgen_running = true;
+
+static loadgen_worker_t                *workers = NULL;
+static loadgen_enb_t                   *enbs = NULL;
+
+//------------------------------------------------------------------------------
+static void usage (const char *name)
+{
+  fprintf (stderr,
+           "Usage: %s [options]\n"
+           "  -m, --mme ADDRESS          MME S1-C address (%s)\n"
+           "  -p, --port PORT            MME S1-C port (%u)\n"
+           "  -l, --local ADDRESS        local address of the eNBs, also their S1-U address\n"
+           "  -e, --enbs N               number of eNBs (%u)\n"
+           "  -u, --ues N                number of UEs, spread over the eNBs (%u)\n"
+           "  -t, --threads N            worker threads, the eNBs are spread over them (%u)\n"
+           "  -r, --attach-rate N        initial attaches per second, 0 for no ramp (%u)\n"
+           "  -T, --think-ms N           mean time between two procedures of a UE (%u)\n"
+           "  -o, --timeout-ms N         procedure timeout (%u)\n"
+           "  -d, --duration N           test duration in seconds, 0 until interrupted (%u)\n"
+           "  -x, --mix TAU:SR:DETACH    weights of the procedures of the idle UEs (%u:%u:%u)\n"
+           "      --mcc MCC --mnc MNC    PLMN of the eNBs (%03u %02u)\n"
+           "      --tac TAC              TAC of the eNBs (%u)\n"
+           "      --enb-id N             macro eNB ID of the first eNB (%u)\n"
+           "  -i, --imsi-base IMSI       IMSI of the first UE (%015" PRIu64 ")\n"
+           "  -k, --key HEX              K of the UEs\n"
+           "  -c, --opc HEX              OPc of the UEs\n"
+           "  -M, --metrics-port PORT    serve the metrics over HTTP on this port\n",
+           name, loadgen_config.mme_address, loadgen_config.mme_port, loadgen_config.nb_enbs, loadgen_config.nb_ues,
+           loadgen_config.nb_workers, loadgen_config.attach_rate, loadgen_config.think_time_ms, loadgen_config.timeout_ms,
+           loadgen_config.duration_s, loadgen_config.weights[LOADGEN_PROC_TAU], loadgen_config.weights[LOADGEN_PROC_SERVICE_REQUEST],
+           loadgen_config.weights[LOADGEN_PROC_DETACH], loadgen_config.mcc, loadgen_config.mnc, loadgen_config.tac,
+           loadgen_config.enb_id_base, loadgen_config.imsi_base);
+}
+
+//------------------------------------------------------------------------------
+static int parse_key (const char *hex, uint8_t key[16])
+{
+  unsigned int                            byte = 0;
+
+  if (strlen (hex) != 32) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < 16; i++) {
+    if (sscanf (&hex[2 * i], "%2x", &byte) != 1) {
+      return RETURNerror;
+    }
+    key[i] = byte;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int parse_options (int argc, char *argv[])
+{
+  enum { OPT_MCC = 256, OPT_MNC, OPT_TAC, OPT_ENB_ID };
+  static const struct option              options[] = {
+    {"mme", required_argument, NULL, 'm'},
+    {"port", required_argument, NULL, 'p'},
+    {"local", required_argument, NULL, 'l'},
+    {"enbs", required_argument, NULL, 'e'},
+    {"ues", required_argument, NULL, 'u'},
+    {"threads", required_argument, NULL, 't'},
+    {"attach-rate", required_argument, NULL, 'r'},
+    {"think-ms", required_argument, NULL, 'T'},
+    {"timeout-ms", required_argument, NULL, 'o'},
+    {"duration", required_argument, NULL, 'd'},
+    {"mix", required_argument, NULL, 'x'},
+    {"mcc", required_argument, NULL, OPT_MCC},
+    {"mnc", required_argument, NULL, OPT_MNC},
+    {"tac", required_argument, NULL, OPT_TAC},
+    {"enb-id", required_argument, NULL, OPT_ENB_ID},
+    {"imsi-base", required_argument, NULL, 'i'},
+    {"key", required_argument, NULL, 'k'},
+    {"opc", required_argument, NULL, 'c'},
+    {"metrics-port", required_argument, NULL, 'M'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  int                                     c = 0;
+
+  while ((c = getopt_long (argc, argv, "m:p:l:e:u:t:r:T:o:d:x:i:k:c:M:h", options, NULL)) != -1) {
+    switch (c) {
+    case 'm':
+      loadgen_config.mme_address = optarg;
+      break;
+    case 'p':
+      loadgen_config.mme_port = atoi (optarg);
+      break;
+    case 'l':
+      loadgen_config.local_address = optarg;
+      if (inet_pton (AF_INET, optarg, loadgen_config.s1u_address) != 1) {
+        fprintf (stderr, "Invalid local address %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'e':
+      loadgen_config.nb_enbs = strtoul (optarg, NULL, 0);
+      break;
+    case 'u':
+      loadgen_config.nb_ues = strtoul (optarg, NULL, 0);
+      break;
+    case 't':
+      loadgen_config.nb_workers = strtoul (optarg, NULL, 0);
+      break;
+    case 'r':
+      loadgen_config.attach_rate = strtoul (optarg, NULL, 0);
+      break;
+    case 'T':
+      loadgen_config.think_time_ms = strtoul (optarg, NULL, 0);
+      break;
+    case 'o':
+      loadgen_config.timeout_ms = strtoul (optarg, NULL, 0);
+      break;
+    case 'd':
+      loadgen_config.duration_s = strtoul (optarg, NULL, 0);
+      break;
+    case 'x':
+      if (sscanf (optarg, "%u:%u:%u", &loadgen_config.weights[LOADGEN_PROC_TAU], &loadgen_config.weights[LOADGEN_PROC_SERVICE_REQUEST],
+                  &loadgen_config.weights[LOADGEN_PROC_DETACH]) != 3) {
+        fprintf (stderr, "Invalid procedure mix %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case OPT_MCC:
+      loadgen_config.mcc = atoi (optarg);
+      break;
+    case OPT_MNC:
+      loadgen_config.mnc = atoi (optarg);
+      loadgen_config.mnc_digit_length = strlen (optarg) == 3 ? 3 : 2;
+      break;
+    case OPT_TAC:
+      loadgen_config.tac = strtoul (optarg, NULL, 0);
+      break;
+    case OPT_ENB_ID:
+      loadgen_config.enb_id_base = strtoul (optarg, NULL, 0);
+      break;
+    case 'i':
+      loadgen_config.imsi_base = strtoull (optarg, NULL, 10);
+      break;
+    case 'k':
+      if (RETURNok != parse_key (optarg, loadgen_config.k)) {
+        fprintf (stderr, "Invalid K %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'c':
+      if (RETURNok != parse_key (optarg, loadgen_config.opc)) {
+        fprintf (stderr, "Invalid OPc %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'M':
+      loadgen_config.metrics_port = atoi (optarg);
+      break;
+    default:
+      usage (argv[0]);
+      return RETURNerror;
+    }
+  }
+
+  if ((0 == loadgen_config.nb_enbs) || (0 == loadgen_config.nb_ues) || (0 == loadgen_config.nb_workers)) {
+    fprintf (stderr, "At least one eNB, one UE and one thread are needed\n");
+    return RETURNerror;
+  }
+  if (loadgen_config.nb_workers > LOADGEN_MAX_WORKERS) {
+    fprintf (stderr, "At most %d threads\n", LOADGEN_MAX_WORKERS);
+    return RETURNerror;
+  }
+  if (loadgen_config.nb_workers > loadgen_config.nb_enbs) {
+    loadgen_config.nb_workers = loadgen_config.nb_enbs;
+  }
+  if ((loadgen_config.nb_ues + loadgen_config.nb_enbs - 1) / loadgen_config.nb_enbs > LOADGEN_MAX_UES_PER_ENB) {
+    fprintf (stderr, "At most %d UEs per eNB\n", LOADGEN_MAX_UES_PER_ENB);
+    return RETURNerror;
+  }
+  if (loadgen_config.enb_id_base + loadgen_config.nb_enbs > (1 << 20)) {
+    fprintf (stderr, "The macro eNB IDs are 20 bits long\n");
+    return RETURNerror;
+  }
+  if (0 == loadgen_config.weights[LOADGEN_PROC_TAU] + loadgen_config.weights[LOADGEN_PROC_SERVICE_REQUEST] + loadgen_config.weights[LOADGEN_PROC_DETACH]) {
+    loadgen_config.weights[LOADGEN_PROC_SERVICE_REQUEST] = 1;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// TBCD encoded PLMN identity, TS 24.008 10.5.1.13
+static void encode_plmn (void)
+{
+  const uint16_t                          mcc = loadgen_config.mcc;
+  const uint16_t                          mnc = loadgen_config.mnc;
+
+  loadgen_config.plmn[0] = (((mcc / 10) % 10) << 4) | (mcc / 100);
+  if (3 == loadgen_config.mnc_digit_length) {
+    loadgen_config.plmn[1] = ((mnc % 10) << 4) | (mcc % 10);
+    loadgen_config.plmn[2] = (((mnc / 10) % 10) << 4) | (mnc / 100);
+  } else {
+    loadgen_config.plmn[1] = 0xF0 | (mcc % 10);
+    loadgen_config.plmn[2] = ((mnc % 10) << 4) | ((mnc / 10) % 10);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void register_metrics (void)
+{
+  char                                    name[METRICS_NAME_MAX_LENGTH];
+  char                                    help[METRICS_HELP_MAX_LENGTH];
+
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    loadgen_procedure_metrics_t            *metrics = &loadgen_metrics.procedures[p];
+
+    snprintf (name, sizeof (name), "loadgen_%s_started_total", loadgen_procedure_names[p]);
+    snprintf (help, sizeof (help), "Number of %s procedures started", loadgen_procedure_names[p]);
+    metrics->started = metrics_register_counter (name, help);
+    snprintf (name, sizeof (name), "loadgen_%s_completed_total", loadgen_procedure_names[p]);
+    snprintf (help, sizeof (help), "Number of %s procedures completed", loadgen_procedure_names[p]);
+    metrics->completed = metrics_register_counter (name, help);
+    snprintf (name, sizeof (name), "loadgen_%s_rejected_total", loadgen_procedure_names[p]);
+    snprintf (help, sizeof (help), "Number of %s procedures rejected by the network or by the overload control", loadgen_procedure_names[p]);
+    metrics->rejected = metrics_register_counter (name, help);
+    snprintf (name, sizeof (name), "loadgen_%s_timed_out_total", loadgen_procedure_names[p]);
+    snprintf (help, sizeof (help), "Number of %s procedures timed out", loadgen_procedure_names[p]);
+    metrics->timed_out = metrics_register_counter (name, help);
+    snprintf (name, sizeof (name), "loadgen_%s_latency_seconds", loadgen_procedure_names[p]);
+    snprintf (help, sizeof (help), "Latency of the completed %s procedures", loadgen_procedure_names[p]);
+    metrics->latency = metrics_register_histogram (name, help);
+  }
+  loadgen_metrics.enbs_setup = metrics_register_gauge ("loadgen_enbs_setup", "Number of eNBs with their S1 interface set up");
+  loadgen_metrics.ues_registered = metrics_register_gauge ("loadgen_ues_registered", "Number of UEs registered to the network");
+  loadgen_metrics.s1ap_sent = metrics_register_counter ("loadgen_s1ap_sent_total", "Number of S1AP PDUs sent");
+  loadgen_metrics.s1ap_received = metrics_register_counter ("loadgen_s1ap_received_total", "Number of S1AP PDUs received");
+  loadgen_metrics.s1ap_errors = metrics_register_counter ("loadgen_s1ap_errors_total", "Number of S1AP PDUs that could not be encoded, sent or decoded");
+  loadgen_metrics.nas_errors = metrics_register_counter ("loadgen_nas_errors_total", "Number of NAS messages failing the security checks or malformed");
+  loadgen_metrics.overload_rejected = metrics_register_counter ("loadgen_overload_rejected_total", "Number of procedures not started because of an MME overload");
+}
+
+//------------------------------------------------------------------------------
+static int setup (void)
+{
+  const uint64_t                          start_ns = metrics_now_ns ();
+  uint32_t                                ues_per_enb = loadgen_config.nb_ues / loadgen_config.nb_enbs;
+  uint32_t                                extra_ues = loadgen_config.nb_ues % loadgen_config.nb_enbs;
+
+  workers = calloc (loadgen_config.nb_workers, sizeof (loadgen_worker_t));
+  enbs = calloc (loadgen_config.nb_enbs, sizeof (loadgen_enb_t));
+  if (!workers || !enbs) {
+    return RETURNerror;
+  }
+  for (uint32_t w = 0; w < loadgen_config.nb_workers; w++) {
+    workers[w].index = w;
+    workers[w].seed = w + 1;
+    if ((workers[w].epoll_fd = epoll_create1 (0)) < 0) {
+      perror ("epoll_create1");
+      return RETURNerror;
+    }
+  }
+
+  // eNB e is served by worker e % nb_workers, UE g is camping on eNB g % nb_enbs
+  for (uint32_t e = 0; e < loadgen_config.nb_enbs; e++) {
+    loadgen_enb_t                          *enb = &enbs[e];
+    const uint32_t                          cell_identity = (loadgen_config.enb_id_base + e) << 8;
+
+    enb->worker = &workers[e % loadgen_config.nb_workers];
+    enb->worker->nb_enbs++;
+    enb->fd = -1;
+    enb->enb_id = loadgen_config.enb_id_base + e;
+    // 28 bits, the macro eNB ID and cell 0
+    enb->cell_id[0] = cell_identity >> 20;
+    enb->cell_id[1] = (cell_identity >> 12) & 0xFF;
+    enb->cell_id[2] = (cell_identity >> 4) & 0xFF;
+    enb->cell_id[3] = (cell_identity << 4) & 0xF0;
+    enb->nb_ues = ues_per_enb + ((e < extra_ues) ? 1 : 0);
+    if (enb->nb_ues && !(enb->ues = calloc (enb->nb_ues, sizeof (loadgen_ue_t)))) {
+      return RETURNerror;
+    }
+    enb->worker->nb_ues += enb->nb_ues;
+  }
+  for (uint32_t w = 0; w < loadgen_config.nb_workers; w++) {
+    if (!(workers[w].timers = calloc (workers[w].nb_ues, sizeof (loadgen_ue_t *)))) {
+      return RETURNerror;
+    }
+  }
+  for (uint32_t g = 0; g < loadgen_config.nb_ues; g++) {
+    loadgen_enb_t                          *enb = &enbs[g % loadgen_config.nb_enbs];
+    loadgen_ue_t                           *ue = &enb->ues[g / loadgen_config.nb_enbs];
+
+    loadgen_ue_init (ue, enb, g / loadgen_config.nb_enbs, loadgen_config.imsi_base + g);
+    // the first attach of the UEs follows the ramp
+    loadgen_ue_timer_arm (ue, start_ns + (loadgen_config.attach_rate ? (g * NS_PER_S) / loadgen_config.attach_rate : 0));
+  }
+
+  for (uint32_t e = 0; e < loadgen_config.nb_enbs; e++) {
+    if (RETURNok != loadgen_enb_connect (&enbs[e])) {
+      fprintf (stderr, "eNB %u not connected, its UEs stay idle\n", enbs[e].enb_id);
+    }
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void *worker_main (void *arg)
+{
+  loadgen_worker_t                       *worker = (loadgen_worker_t *) arg;
+  struct epoll_event                      events[LOADGEN_MAX_EPOLL_EVENTS];
+  loadgen_ue_t                           *ue = NULL;
+  uint64_t                                now_ns = 0;
+  uint64_t                                next_ns = 0;
+  int                                     timeout_ms = 0;
+  int                                     n = 0;
+
+  while (loadgen_running) {
+    now_ns = metrics_now_ns ();
+    while ((ue = loadgen_ue_pop_expired (worker, now_ns))) {
+      loadgen_ue_timer_expired (ue);
+    }
+    next_ns = loadgen_ue_next_deadline (worker);
+    timeout_ms = LOADGEN_MAX_EPOLL_WAIT_MS;
+    if (next_ns <= now_ns) {
+      timeout_ms = 0;
+    } else if (next_ns - now_ns < (uint64_t)LOADGEN_MAX_EPOLL_WAIT_MS * 1000000) {
+      timeout_ms = (next_ns - now_ns + 999999) / 1000000;
+    }
+    n = epoll_wait (worker->epoll_fd, events, LOADGEN_MAX_EPOLL_EVENTS, timeout_ms);
+    for (int i = 0; i < n; i++) {
+      loadgen_enb_receive ((loadgen_enb_t *) events[i].data.ptr);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void signal_handler (int signum)
+{
+  loadgen_running = false;
+}
+
+//------------------------------------------------------------------------------
+static void report_progress (const uint32_t elapsed_s, int64_t last_completed[LOADGEN_PROC_MAX])
+{
+  printf ("%5us enbs %" PRId64 " registered %" PRId64, elapsed_s, metrics_get_value (loadgen_metrics.enbs_setup),
+          metrics_get_value (loadgen_metrics.ues_registered));
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    const int64_t                           completed = metrics_get_value (loadgen_metrics.procedures[p].completed);
+
+    printf (" %s/s %" PRId64, loadgen_procedure_names[p], completed - last_completed[p]);
+    last_completed[p] = completed;
+  }
+  printf ("\n");
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+static void report_final (const double elapsed_s)
+{
+  metrics_histogram_report_t              report;
+
+  printf ("\n%-16s %10s %10s %10s %10s %10s %9s %9s %9s %9s\n", "procedure", "started", "completed", "rejected", "timed out",
+          "per sec", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms");
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    const loadgen_procedure_metrics_t      *metrics = &loadgen_metrics.procedures[p];
+    const int64_t                           completed = metrics_get_value (metrics->completed);
+
+    metrics_get_histogram (metrics->latency, &report);
+    printf ("%-16s %10" PRId64 " %10" PRId64 " %10" PRId64 " %10" PRId64 " %10.1f %9.2f %9.2f %9.2f %9.2f\n", loadgen_procedure_names[p],
+            metrics_get_value (metrics->started), completed, metrics_get_value (metrics->rejected), metrics_get_value (metrics->timed_out),
+            elapsed_s > 0 ? completed / elapsed_s : 0.0,
+            metrics_histogram_percentile (&report, 50.0) / 1000.0, metrics_histogram_percentile (&report, 90.0) / 1000.0,
+            metrics_histogram_percentile (&report, 99.0) / 1000.0, metrics_histogram_percentile (&report, 99.9) / 1000.0);
+  }
+  printf ("\nregistered UEs %" PRId64 ", S1AP sent %" PRId64 " received %" PRId64 " errors %" PRId64 ", NAS errors %" PRId64
+          ", overload rejections %" PRId64 "\n", metrics_get_value (loadgen_metrics.ues_registered),
+          metrics_get_value (loadgen_metrics.s1ap_sent), metrics_get_value (loadgen_metrics.s1ap_received),
+          metrics_get_value (loadgen_metrics.s1ap_errors), metrics_get_value (loadgen_metrics.nas_errors),
+          metrics_get_value (loadgen_metrics.overload_rejected));
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int64_t                                 last_completed[LOADGEN_PROC_MAX] = {0};
+  uint64_t                                start_ns = 0;
+  uint32_t                                elapsed_s = 0;
+
+  if (RETURNok != parse_options (argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  encode_plmn ();
+  register_metrics ();
+  signal (SIGINT, signal_handler);
+  signal (SIGTERM, signal_handler);
+  signal (SIGPIPE, SIG_IGN);
+
+  if (RETURNok != setup ()) {
+    fprintf (stderr, "Setup of the eNBs and UEs failed\n");
+    return EXIT_FAILURE;
+  }
+  if (loadgen_config.metrics_port && (RETURNok != metrics_server_start (NULL, loadgen_config.metrics_port))) {
+    fprintf (stderr, "Metrics server not started on port %u\n", loadgen_config.metrics_port);
+  }
+
+  start_ns = metrics_now_ns ();
+  for (uint32_t w = 0; w < loadgen_config.nb_workers; w++) {
+    if (pthread_create (&workers[w].thread, NULL, worker_main, &workers[w])) {
+      fprintf (stderr, "Worker thread %u not started\n", w);
+      loadgen_running = false;
+      loadgen_config.nb_workers = w;
+      break;
+    }
+  }
+
+  while (loadgen_running) {
+    sleep (1);
+    elapsed_s = (metrics_now_ns () - start_ns) / NS_PER_S;
+    report_progress (elapsed_s, last_completed);
+    if (loadgen_config.duration_s && (elapsed_s >= loadgen_config.duration_s)) {
+      loadgen_running = false;
+    }
+  }
+  for (uint32_t w = 0; w < loadgen_config.nb_workers; w++) {
+    pthread_join (workers[w].thread, NULL);
+  }
+  report_final ((double)(metrics_now_ns () - start_ns) / NS_PER_S);
+
+  metrics_server_stop ();
+  for (uint32_t e = 0; e < loadgen_config.nb_enbs; e++) {
+    loadgen_enb_close (&enbs[e]);
+    free (enbs[e].ues);
+  }
+  for (uint32_t w = 0; w < loadgen_config.nb_workers; w++) {
+    close (workers[w].epoll_fd);
+    free (workers[w].timers);
+  }
+  free (enbs);
+  free (workers);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,334 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_nas.c
+  \brief Uplink NAS messages of the simulated UEs and their NAS security
+  (TS 24.301 4.4, TS 33.401 8.1), on top of the secu library of the MME.
+  The messages are written octet by octet: a UE sends the same few messages
+  with a handful of variable fields, going through the NAS message structures
+  of the MME would only cost the load generator CPU.
+  \author
+  \company
+  \email
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.301.h"
+#include "NasSecurityAlgorithms.h"
+#include "secu_defs.h"
+#include "loadgen.h"
+
+#define PD_EMM                  EPS_MOBILITY_MANAGEMENT_MESSAGE
+#define PD_ESM                  EPS_SESSION_MANAGEMENT_MESSAGE
+
+#define NAS_KSI_NO_KEY          0x07
+#define EPS_ATTACH_TYPE_EPS     0x01
+#define EPS_UPDATE_TYPE_TA      0x00
+#define DETACH_TYPE_EPS         0x01
+#define MOBILE_IDENTITY_IMSI    0x01
+#define MOBILE_IDENTITY_GUTI    0x06
+#define PDN_TYPE_IPV4           0x01
+#define REQUEST_TYPE_INITIAL    0x01
+#define PTI_ATTACH              0x01
+
+#define IEI_DRX_PARAMETER       0x5C
+#define IEI_UE_NET_CAPABILITY   0x58
+#define IEI_BEARER_CTX_STATUS   0x57
+
+#define NAS_MAC_OFFSET          1
+#define NAS_SQN_OFFSET          5
+
+// EEA0, EEA1, EEA2 and EIA0, EIA1, EIA2
+static const uint8_t                    ue_network_capability[] = {0x02, 0xe0, 0xe0};
+
+//------------------------------------------------------------------------------
+// IMSI mobile identity, LV, of 15 digits
+static int nas_imsi (const uint64_t imsi, uint8_t *buffer)
+{
+  uint8_t                                 digits[15];
+  uint64_t                                value = imsi;
+
+  for (int i = 14; i >= 0; i--) {
+    digits[i] = value % 10;
+    value /= 10;
+  }
+  buffer[0] = 8;
+  // odd number of digits
+  buffer[1] = (digits[0] << 4) | 0x08 | MOBILE_IDENTITY_IMSI;
+  for (int i = 0; i < 7; i++) {
+    buffer[2 + i] = (digits[2 + 2 * i] << 4) | digits[1 + 2 * i];
+  }
+  return 9;
+}
+
+//------------------------------------------------------------------------------
+// GUTI EPS mobile identity, LV
+static int nas_guti (const loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  buffer[0] = 11;
+  buffer[1] = 0xf0 | MOBILE_IDENTITY_GUTI;
+  memcpy (&buffer[2], ue->guti_plmn, 3);
+  buffer[5] = ue->mme_gid >> 8;
+  buffer[6] = ue->mme_gid;
+  buffer[7] = ue->mme_code;
+  buffer[8] = ue->m_tmsi >> 24;
+  buffer[9] = ue->m_tmsi >> 16;
+  buffer[10] = ue->m_tmsi >> 8;
+  buffer[11] = ue->m_tmsi;
+  return 12;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_attach_request (const loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  int                                     size = 0;
+
+  buffer[size++] = PD_EMM;
+  buffer[size++] = ATTACH_REQUEST;
+  buffer[size++] = (NAS_KSI_NO_KEY << 4) | EPS_ATTACH_TYPE_EPS;
+  size += nas_imsi (ue->imsi, &buffer[size]);
+  memcpy (&buffer[size], ue_network_capability, sizeof (ue_network_capability));
+  size += sizeof (ue_network_capability);
+  // ESM message container: PDN Connectivity Request, APN of the subscription
+  buffer[size++] = 0;
+  buffer[size++] = 4;
+  buffer[size++] = PD_ESM;
+  buffer[size++] = PTI_ATTACH;
+  buffer[size++] = PDN_CONNECTIVITY_REQUEST;
+  buffer[size++] = (PDN_TYPE_IPV4 << 4) | REQUEST_TYPE_INITIAL;
+  buffer[size++] = IEI_DRX_PARAMETER;
+  buffer[size++] = 0x0a;
+  buffer[size++] = 0x00;
+  return size;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_authentication_response (const uint8_t res[8], uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = AUTHENTICATION_RESPONSE;
+  buffer[2] = 8;
+  memcpy (&buffer[3], res, 8);
+  return 11;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_identity_response (const loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = IDENTITY_RESPONSE;
+  return 2 + nas_imsi (ue->imsi, &buffer[2]);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_security_mode_complete (uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = SECURITY_MODE_COMPLETE;
+  return 2;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_attach_complete (const loadgen_ue_t * const ue, const uint8_t pti, uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = ATTACH_COMPLETE;
+  // ESM message container: Activate Default EPS Bearer Context Accept
+  buffer[2] = 0;
+  buffer[3] = 3;
+  buffer[4] = (ue->ebi << 4) | PD_ESM;
+  buffer[5] = pti;
+  buffer[6] = ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_ACCEPT;
+  return 7;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_tracking_area_update_request (const loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  int                                     size = 0;
+
+  buffer[size++] = PD_EMM;
+  buffer[size++] = TRACKING_AREA_UPDATE_REQUEST;
+  buffer[size++] = (ue->ksi << 4) | EPS_UPDATE_TYPE_TA;
+  size += nas_guti (ue, &buffer[size]);
+  buffer[size++] = IEI_UE_NET_CAPABILITY;
+  memcpy (&buffer[size], ue_network_capability, sizeof (ue_network_capability));
+  size += sizeof (ue_network_capability);
+  buffer[size++] = IEI_BEARER_CTX_STATUS;
+  buffer[size++] = 2;
+  buffer[size++] = (ue->ebi < 8) ? (1 << ue->ebi) : 0;
+  buffer[size++] = (ue->ebi < 8) ? 0 : (1 << (ue->ebi - 8));
+  return size;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_tracking_area_update_complete (uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = TRACKING_AREA_UPDATE_COMPLETE;
+  return 2;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_detach_request (const loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = DETACH_REQUEST;
+  buffer[2] = (ue->ksi << 4) | DETACH_TYPE_EPS;
+  return 3 + nas_guti (ue, &buffer[3]);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_detach_accept (uint8_t *buffer)
+{
+  buffer[0] = PD_EMM;
+  buffer[1] = DETACH_ACCEPT;
+  return 2;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_nas_derive_keys (loadgen_ue_t * const ue)
+{
+  derive_key_nas_enc (ue->eea, ue->kasme, ue->knas_enc);
+  derive_key_nas_int (ue->eia, ue->kasme, ue->knas_int);
+}
+
+//------------------------------------------------------------------------------
+static void nas_mac (const loadgen_ue_t * const ue, const uint8_t direction, const uint32_t count, uint8_t *message, const int length, uint8_t mac[4])
+{
+  nas_stream_cipher_t                     stream_cipher = {0};
+
+  stream_cipher.key = (uint8_t *)ue->knas_int;
+  stream_cipher.key_length = sizeof (ue->knas_int);
+  stream_cipher.count = count;
+  stream_cipher.bearer = 0x00;  // 33.401 section 8.1.1
+  stream_cipher.direction = direction;
+  stream_cipher.message = message;
+  stream_cipher.blength = length << 3;
+  switch (ue->eia) {
+  case NAS_SECURITY_ALGORITHMS_EIA1:
+    nas_stream_encrypt_eia1 (&stream_cipher, mac);
+    break;
+  case NAS_SECURITY_ALGORITHMS_EIA2:
+    nas_stream_encrypt_eia2 (&stream_cipher, mac);
+    break;
+  default:
+    memset (mac, 0, 4);
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void nas_cipher (const loadgen_ue_t * const ue, const uint8_t direction, const uint32_t count, uint8_t *message, const int length, uint8_t *out)
+{
+  nas_stream_cipher_t                     stream_cipher = {0};
+
+  stream_cipher.key = (uint8_t *)ue->knas_enc;
+  stream_cipher.key_length = sizeof (ue->knas_enc);
+  stream_cipher.count = count;
+  stream_cipher.bearer = 0x00;
+  stream_cipher.direction = direction;
+  stream_cipher.message = message;
+  stream_cipher.blength = length << 3;
+  switch (ue->eea) {
+  case NAS_SECURITY_ALGORITHMS_EEA1:
+    nas_stream_encrypt_eea1 (&stream_cipher, out);
+    break;
+  case NAS_SECURITY_ALGORITHMS_EEA2:
+    nas_stream_encrypt_eea2 (&stream_cipher, out);
+    break;
+  default:
+    memmove (out, message, length);
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_protect (loadgen_ue_t * const ue, const uint8_t security_header_type, const uint8_t *plain, const int length, uint8_t *out)
+{
+  uint8_t                                 mac[4];
+
+  out[0] = (security_header_type << 4) | PD_EMM;
+  out[NAS_SQN_OFFSET] = ue->ul_count & 0xFF;
+  if ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED == security_header_type) ||
+      (SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW == security_header_type)) {
+    nas_cipher (ue, SECU_DIRECTION_UPLINK, ue->ul_count, (uint8_t *)plain, length, &out[NAS_SQN_OFFSET + 1]);
+  } else {
+    memcpy (&out[NAS_SQN_OFFSET + 1], plain, length);
+  }
+  nas_mac (ue, SECU_DIRECTION_UPLINK, ue->ul_count, &out[NAS_SQN_OFFSET], length + 1, mac);
+  memcpy (&out[NAS_MAC_OFFSET], mac, 4);
+  ue->ul_count = (ue->ul_count + 1) & 0x00FFFFFF;
+  return NAS_SQN_OFFSET + 1 + length;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_service_request (loadgen_ue_t * const ue, uint8_t *buffer)
+{
+  uint8_t                                 mac[4];
+
+  // the short MAC is the 2 last octets of the MAC of the 2 first octets
+  buffer[0] = (SECURITY_HEADER_TYPE_SERVICE_REQUEST << 4) | PD_EMM;
+  buffer[1] = ((ue->ksi & 0x07) << 5) | (ue->ul_count & 0x1F);
+  nas_mac (ue, SECU_DIRECTION_UPLINK, ue->ul_count, buffer, 2, mac);
+  buffer[2] = mac[2];
+  buffer[3] = mac[3];
+  ue->ul_count = (ue->ul_count + 1) & 0x00FFFFFF;
+  return 4;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_unprotect (loadgen_ue_t * const ue, uint8_t *pdu, const int length)
+{
+  uint8_t                                 security_header_type = pdu[0] >> 4;
+  uint8_t                                 mac[4];
+  uint8_t                                 plain[LOADGEN_MAX_PDU_SIZE];
+  uint32_t                                count = 0;
+  const int                               offset = NAS_SQN_OFFSET + 1;
+
+  if (SECURITY_HEADER_TYPE_NOT_PROTECTED == security_header_type) {
+    return 0;
+  }
+  if ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW < security_header_type) || (offset + 2 > length) ||
+      (LOADGEN_MAX_PDU_SIZE < length)) {
+    return RETURNerror;
+  }
+  // NAS COUNT estimated from the 8 bits sequence number
+  count = (ue->dl_count & 0x00FFFF00) | pdu[NAS_SQN_OFFSET];
+  if (count < ue->dl_count) {
+    count += 0x100;
+  }
+  nas_mac (ue, SECU_DIRECTION_DOWNLINK, count, &pdu[NAS_SQN_OFFSET], length - NAS_SQN_OFFSET, mac);
+  if (memcmp (mac, &pdu[NAS_MAC_OFFSET], 4)) {
+    return RETURNerror;
+  }
+  if ((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED == security_header_type) ||
+      (SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW == security_header_type)) {
+    nas_cipher (ue, SECU_DIRECTION_DOWNLINK, count, &pdu[offset], length - offset, plain);
+    memcpy (&pdu[offset], plain, length - offset);
+  }
+  ue->dl_count = (count + 1) & 0x00FFFFFF;
+  return offset;
+}
@@ -0,0 +1,429 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_s1ap.c
+  \brief S1AP messages of the simulated eNBs, encoded and decoded with the
+  asn1c structures of the MME. The octet and bit strings of the IEs point to
+  buffers of the eNB or of the UE, nothing is allocated per message but the
+  encoded PDU.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_overload.h"
+#include "loadgen.h"
+
+// Stream 0 is reserved to the non UE associated signalling
+static inline uint16_t s1ap_ue_stream (const loadgen_ue_t * const ue)
+{
+  const uint16_t                          outstreams = ue->enb->outstreams;
+
+  return (outstreams > 1) ? 1 + (ue->index % (outstreams - 1)) : 0;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_send (loadgen_enb_t * const enb, const uint16_t stream, uint8_t *buffer, const uint32_t length, const ssize_t encoded)
+{
+  if (encoded <= 0) {
+    metrics_counter_add (loadgen_metrics.s1ap_errors, 1);
+    return RETURNerror;
+  }
+  return loadgen_enb_send (enb, stream, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_s1_setup_request (loadgen_enb_t * const enb)
+{
+  S1ap_S1SetupRequestIEs_t                ies = {0};
+  S1ap_S1SetupRequest_t                   s1_setup_request = {0};
+  S1ap_SupportedTAs_Item_t                ta = {{0}};
+  S1ap_PLMNidentity_t                     plmn = {0};
+  uint8_t                                 enb_id[3];
+  uint8_t                                 tac[2];
+  char                                    name[32];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  // macro eNB ID, 20 bits
+  enb_id[0] = (enb->enb_id >> 12) & 0xFF;
+  enb_id[1] = (enb->enb_id >> 4) & 0xFF;
+  enb_id[2] = (enb->enb_id << 4) & 0xF0;
+  tac[0] = loadgen_config.tac >> 8;
+  tac[1] = loadgen_config.tac & 0xFF;
+  snprintf (name, sizeof (name), "loadgen-%u", enb->enb_id);
+
+  ies.global_ENB_ID.pLMNidentity.buf = loadgen_config.plmn;
+  ies.global_ENB_ID.pLMNidentity.size = 3;
+  ies.global_ENB_ID.eNB_ID.present = S1ap_ENB_ID_PR_macroENB_ID;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.buf = enb_id;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.size = 3;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.bits_unused = 4;
+  ies.presenceMask |= S1AP_S1SETUPREQUESTIES_ENBNAME_PRESENT;
+  ies.eNBname.buf = (uint8_t *)name;
+  ies.eNBname.size = strlen (name);
+  ta.tAC.buf = tac;
+  ta.tAC.size = 2;
+  plmn.buf = loadgen_config.plmn;
+  plmn.size = 3;
+  ASN_SEQUENCE_ADD (&ta.broadcastPLMNs, &plmn);
+  ASN_SEQUENCE_ADD (&ies.supportedTAs, &ta);
+  ies.defaultPagingDRX = S1ap_PagingDRX_v64;
+
+  if (s1ap_encode_s1ap_s1setuprequesties (&s1_setup_request, &ies) >= 0) {
+    encoded = s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_S1Setup, S1ap_Criticality_reject,
+                                                &asn_DEF_S1ap_S1SetupRequest, &s1_setup_request);
+  }
+  free (ta.broadcastPLMNs.list.array);
+  free (ies.supportedTAs.list.array);
+  return s1ap_send (enb, 0, buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_initial_ue_message (loadgen_ue_t * const ue, uint8_t *nas, const int nas_length, const long rrc_cause, const bool s_tmsi)
+{
+  S1ap_InitialUEMessageIEs_t              ies = {0};
+  S1ap_InitialUEMessage_t                 initial_ue_message = {0};
+  uint8_t                                 tac[2];
+  uint8_t                                 m_tmsi[4];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  tac[0] = loadgen_config.tac >> 8;
+  tac[1] = loadgen_config.tac & 0xFF;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  ies.nas_pdu.buf = nas;
+  ies.nas_pdu.size = nas_length;
+  ies.tai.pLMNidentity.buf = loadgen_config.plmn;
+  ies.tai.pLMNidentity.size = 3;
+  ies.tai.tAC.buf = tac;
+  ies.tai.tAC.size = 2;
+  ies.eutran_cgi.pLMNidentity.buf = loadgen_config.plmn;
+  ies.eutran_cgi.pLMNidentity.size = 3;
+  ies.eutran_cgi.cell_ID.buf = ue->enb->cell_id;
+  ies.eutran_cgi.cell_ID.size = 4;
+  ies.eutran_cgi.cell_ID.bits_unused = 4;
+  ies.rrC_Establishment_Cause = rrc_cause;
+  if (s_tmsi) {
+    m_tmsi[0] = ue->m_tmsi >> 24;
+    m_tmsi[1] = (ue->m_tmsi >> 16) & 0xFF;
+    m_tmsi[2] = (ue->m_tmsi >> 8) & 0xFF;
+    m_tmsi[3] = ue->m_tmsi & 0xFF;
+    ies.presenceMask |= S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT;
+    ies.s_tmsi.mMEC.buf = &ue->mme_code;
+    ies.s_tmsi.mMEC.size = 1;
+    ies.s_tmsi.m_TMSI.buf = m_tmsi;
+    ies.s_tmsi.m_TMSI.size = 4;
+  }
+
+  if (s1ap_encode_s1ap_initialuemessageies (&initial_ue_message, &ies) >= 0) {
+    encoded = s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_initialUEMessage, S1ap_Criticality_ignore,
+                                                &asn_DEF_S1ap_InitialUEMessage, &initial_ue_message);
+  }
+  return s1ap_send (ue->enb, s1ap_ue_stream (ue), buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_uplink_nas_transport (loadgen_ue_t * const ue, uint8_t *nas, const int nas_length)
+{
+  S1ap_UplinkNASTransportIEs_t            ies = {0};
+  S1ap_UplinkNASTransport_t               uplink_nas_transport = {0};
+  uint8_t                                 tac[2];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  tac[0] = loadgen_config.tac >> 8;
+  tac[1] = loadgen_config.tac & 0xFF;
+  ies.mme_ue_s1ap_id = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  ies.nas_pdu.buf = nas;
+  ies.nas_pdu.size = nas_length;
+  ies.tai.pLMNidentity.buf = loadgen_config.plmn;
+  ies.tai.pLMNidentity.size = 3;
+  ies.tai.tAC.buf = tac;
+  ies.tai.tAC.size = 2;
+  ies.eutran_cgi.pLMNidentity.buf = loadgen_config.plmn;
+  ies.eutran_cgi.pLMNidentity.size = 3;
+  ies.eutran_cgi.cell_ID.buf = ue->enb->cell_id;
+  ies.eutran_cgi.cell_ID.size = 4;
+  ies.eutran_cgi.cell_ID.bits_unused = 4;
+
+  if (s1ap_encode_s1ap_uplinknastransporties (&uplink_nas_transport, &ies) >= 0) {
+    encoded = s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_uplinkNASTransport, S1ap_Criticality_ignore,
+                                                &asn_DEF_S1ap_UplinkNASTransport, &uplink_nas_transport);
+  }
+  return s1ap_send (ue->enb, s1ap_ue_stream (ue), buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_initial_context_setup_response (loadgen_ue_t * const ue, const long e_rab_id)
+{
+  S1ap_InitialContextSetupResponseIEs_t   ies = {0};
+  S1ap_InitialContextSetupResponse_t      initial_context_setup_response = {0};
+  S1ap_E_RABSetupItemCtxtSURes_t          e_rab = {0};
+  uint8_t                                 teid[4];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  // the S1-U TEID of the eNB is its UE S1AP ID, unique on the eNB
+  teid[0] = ue->enb_ue_s1ap_id >> 24;
+  teid[1] = (ue->enb_ue_s1ap_id >> 16) & 0xFF;
+  teid[2] = (ue->enb_ue_s1ap_id >> 8) & 0xFF;
+  teid[3] = ue->enb_ue_s1ap_id & 0xFF;
+  ies.mme_ue_s1ap_id = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  e_rab.e_RAB_ID = e_rab_id;
+  e_rab.transportLayerAddress.buf = loadgen_config.s1u_address;
+  e_rab.transportLayerAddress.size = 4;
+  e_rab.gTP_TEID.buf = teid;
+  e_rab.gTP_TEID.size = 4;
+  ASN_SEQUENCE_ADD (&ies.e_RABSetupListCtxtSURes, &e_rab);
+
+  if (s1ap_encode_s1ap_initialcontextsetupresponseies (&initial_context_setup_response, &ies) >= 0) {
+    encoded = s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_InitialContextSetup, S1ap_Criticality_reject,
+                                                 &asn_DEF_S1ap_InitialContextSetupResponse, &initial_context_setup_response);
+  }
+  free (ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.array);
+  return s1ap_send (ue->enb, s1ap_ue_stream (ue), buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_ue_context_release_request (loadgen_ue_t * const ue)
+{
+  S1ap_UEContextReleaseRequestIEs_t       ies = {0};
+  S1ap_UEContextReleaseRequest_t          ue_context_release_request = {0};
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  ies.mme_ue_s1ap_id = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = ue->enb_ue_s1ap_id;
+  ies.cause.present = S1ap_Cause_PR_radioNetwork;
+  ies.cause.choice.radioNetwork = S1ap_CauseRadioNetwork_user_inactivity;
+
+  if (s1ap_encode_s1ap_uecontextreleaserequesties (&ue_context_release_request, &ies) >= 0) {
+    encoded = s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_UEContextReleaseRequest, S1ap_Criticality_ignore,
+                                                &asn_DEF_S1ap_UEContextReleaseRequest, &ue_context_release_request);
+  }
+  return s1ap_send (ue->enb, s1ap_ue_stream (ue), buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_ue_context_release_complete (loadgen_enb_t * const enb, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id)
+{
+  S1ap_UEContextReleaseCompleteIEs_t      ies = {0};
+  S1ap_UEContextReleaseComplete_t         ue_context_release_complete = {0};
+  const uint16_t                          outstreams = enb->outstreams;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  ssize_t                                 encoded = 0;
+
+  ies.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+
+  if (s1ap_encode_s1ap_uecontextreleasecompleteies (&ue_context_release_complete, &ies) >= 0) {
+    encoded = s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_UEContextRelease, S1ap_Criticality_reject,
+                                                 &asn_DEF_S1ap_UEContextReleaseComplete, &ue_context_release_complete);
+  }
+  // the UE may be unknown, the stream is the one of its index
+  return s1ap_send (enb, (outstreams > 1) ? 1 + (LOADGEN_ENB_UE_S1AP_ID_INDEX (enb_ue_s1ap_id) % (outstreams - 1)) : 0,
+                    buffer, length, encoded);
+}
+
+//------------------------------------------------------------------------------
+// Handlers of the PDUs received from the MME
+//------------------------------------------------------------------------------
+
+static int s1ap_handle_downlink_nas_transport (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_DownlinkNASTransportIEs_t          ies = {0};
+  loadgen_ue_t                           *ue = NULL;
+
+  if (s1ap_decode_s1ap_downlinknastransporties (&ies, value) < 0) {
+    return RETURNerror;
+  }
+  if ((ue = loadgen_ue_find (enb, ies.eNB_UE_S1AP_ID))) {
+    loadgen_ue_downlink_nas (ue, ies.mme_ue_s1ap_id, ies.nas_pdu.buf, ies.nas_pdu.size);
+  }
+  free_s1ap_downlinknastransport (&ies);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_handle_initial_context_setup_request (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_InitialContextSetupRequestIEs_t    ies = {0};
+  S1ap_E_RABToBeSetupItemCtxtSUReq_t     *e_rab = NULL;
+  loadgen_ue_t                           *ue = NULL;
+
+  if (s1ap_decode_s1ap_initialcontextsetuprequesties (&ies, value) < 0) {
+    return RETURNerror;
+  }
+  if (ies.e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.count < 1) {
+    free_s1ap_initialcontextsetuprequest (&ies);
+    return RETURNerror;
+  }
+  e_rab = ies.e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.array[0];
+  if ((ue = loadgen_ue_find (enb, ies.eNB_UE_S1AP_ID))) {
+    loadgen_ue_initial_context_setup (ue, ies.mme_ue_s1ap_id, e_rab->e_RAB_ID,
+                                      e_rab->nAS_PDU ? e_rab->nAS_PDU->buf : NULL, e_rab->nAS_PDU ? e_rab->nAS_PDU->size : 0);
+  }
+  free_s1ap_initialcontextsetuprequest (&ies);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_handle_ue_context_release_command (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_UEContextReleaseCommandIEs_t       ies = {0};
+  loadgen_ue_t                           *ue = NULL;
+  uint32_t                                mme_ue_s1ap_id = 0;
+  uint32_t                                enb_ue_s1ap_id = 0;
+
+  if (s1ap_decode_s1ap_uecontextreleasecommandies (&ies, value) < 0) {
+    return RETURNerror;
+  }
+  if (S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair != ies.uE_S1AP_IDs.present) {
+    // the eNBs always give their UE S1AP ID to the MME
+    free_s1ap_uecontextreleasecommand (&ies);
+    return RETURNerror;
+  }
+  mme_ue_s1ap_id = ies.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID;
+  enb_ue_s1ap_id = ies.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID;
+  free_s1ap_uecontextreleasecommand (&ies);
+
+  loadgen_s1ap_ue_context_release_complete (enb, mme_ue_s1ap_id, enb_ue_s1ap_id);
+  if ((ue = loadgen_ue_find (enb, enb_ue_s1ap_id))) {
+    loadgen_ue_context_release (ue);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_handle_overload_start (loadgen_enb_t * const enb, ANY_t * const value)
+{
+  S1ap_OverloadStartIEs_t                 ies = {0};
+
+  if (s1ap_decode_s1ap_overloadstarties (&ies, value) < 0) {
+    return RETURNerror;
+  }
+  switch (ies.overloadResponse.choice.overloadAction) {
+  case S1ap_OverloadAction_reject_delay_tolerant_access:
+    enb->overload_level = S1AP_OVERLOAD_REJECT_DELAY_TOLERANT;
+    break;
+  case S1ap_OverloadAction_reject_non_emergency_mo_dt:
+    enb->overload_level = S1AP_OVERLOAD_REJECT_MO_DATA;
+    break;
+  case S1ap_OverloadAction_permit_high_priority_sessions_and_mobile_terminated_services_only:
+    enb->overload_level = S1AP_OVERLOAD_PERMIT_HIGH_PRIORITY_MT;
+    break;
+  default:
+    enb->overload_level = S1AP_OVERLOAD_PERMIT_EMERGENCY_MT;
+    break;
+  }
+  free_s1ap_overloadstart (&ies);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_handle_initiating (loadgen_enb_t * const enb, S1ap_InitiatingMessage_t * const initiating_p)
+{
+  switch (initiating_p->procedureCode) {
+  case S1ap_ProcedureCode_id_downlinkNASTransport:
+    return s1ap_handle_downlink_nas_transport (enb, &initiating_p->value);
+
+  case S1ap_ProcedureCode_id_InitialContextSetup:
+    return s1ap_handle_initial_context_setup_request (enb, &initiating_p->value);
+
+  case S1ap_ProcedureCode_id_UEContextRelease:
+    return s1ap_handle_ue_context_release_command (enb, &initiating_p->value);
+
+  case S1ap_ProcedureCode_id_OverloadStart:
+    return s1ap_handle_overload_start (enb, &initiating_p->value);
+
+  case S1ap_ProcedureCode_id_OverloadStop:
+    enb->overload_level = S1AP_OVERLOAD_NONE;
+    return RETURNok;
+
+  default:
+    // Paging, Error Indication, MME Configuration Update...
+    return RETURNok;
+  }
+}
+
+//------------------------------------------------------------------------------
+int loadgen_s1ap_handle_pdu (loadgen_enb_t * const enb, const uint8_t * const buffer, const uint32_t length)
+{
+  S1AP_PDU_t                              pdu = {(S1AP_PDU_PR_NOTHING)};
+  S1AP_PDU_t                             *pdu_p = &pdu;
+  asn_dec_rval_t                          dec_ret = {(RC_OK)};
+  int                                     rc = RETURNok;
+
+  metrics_counter_add (loadgen_metrics.s1ap_received, 1);
+  dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, buffer, length, 0, 0);
+  if (RC_OK != dec_ret.code) {
+    ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, pdu_p);
+    metrics_counter_add (loadgen_metrics.s1ap_errors, 1);
+    return RETURNerror;
+  }
+
+  switch (pdu_p->present) {
+  case S1AP_PDU_PR_initiatingMessage:
+    rc = s1ap_handle_initiating (enb, &pdu_p->choice.initiatingMessage);
+    break;
+
+  case S1AP_PDU_PR_successfulOutcome:
+    if (S1ap_ProcedureCode_id_S1Setup == pdu_p->choice.successfulOutcome.procedureCode) {
+      enb->setup = true;
+      metrics_gauge_add (loadgen_metrics.enbs_setup, 1);
+    }
+    break;
+
+  case S1AP_PDU_PR_unsuccessfulOutcome:
+    if (S1ap_ProcedureCode_id_S1Setup == pdu_p->choice.unsuccessfulOutcome.procedureCode) {
+      // the UEs of the eNB never start, the TAC or the PLMN does not match the MME configuration
+      fprintf (stderr, "S1 Setup of eNB %u rejected by the MME\n", enb->enb_id);
+    }
+    rc = RETURNerror;
+    break;
+
+  default:
+    rc = RETURNerror;
+    break;
+  }
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, pdu_p);
+  if (RETURNok != rc) {
+    metrics_counter_add (loadgen_metrics.s1ap_errors, 1);
+  }
+  return rc;
+}
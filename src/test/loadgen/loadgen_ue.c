@@ -0,0 +1,615 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_ue.c
+  \brief Procedures of the simulated UEs. A UE runs one procedure at a time:
+  attach when deregistered, S1 release (user inactivity) when connected, and
+  when idle a tracking area update, a service request or a detach, drawn with
+  the weights of the configuration. A procedure starts with its initial
+  message and is timed until the UE is back in a stable state:
+    - attach: Attach Complete sent, after the Initial Context Setup,
+    - service request: Initial Context Setup Response sent,
+    - tracking area update and detach: S1 connection released,
+    - release: UE Context Release Complete sent.
+  The UE then waits a think time before its next procedure. A UE timer is
+  either this think time or the timeout of the running procedure.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.301.h"
+#include "S1ap-RRC-Establishment-Cause.h"
+#include "s1ap_mme_overload.h"
+#include "loadgen.h"
+
+#define NS_PER_MS                     1000000ULL
+
+#define IEI_GUTI                      0x50
+#define IEI_LAI                       0x13
+#define GUTI_LENGTH                   11
+
+// while the eNB is not set up, the UE timers are postponed by this delay
+#define LOADGEN_ENB_SETUP_POLL_MS     100
+
+//------------------------------------------------------------------------------
+// Timer heap of the worker
+//------------------------------------------------------------------------------
+
+static inline bool timer_before (const loadgen_ue_t * const a, const loadgen_ue_t * const b)
+{
+  return a->deadline_ns < b->deadline_ns;
+}
+
+static void timer_swap (loadgen_worker_t * const worker, const uint32_t i, const uint32_t j)
+{
+  loadgen_ue_t                           *ue = worker->timers[i];
+
+  worker->timers[i] = worker->timers[j];
+  worker->timers[j] = ue;
+  worker->timers[i]->timer_index = i;
+  worker->timers[j]->timer_index = j;
+}
+
+static void timer_up (loadgen_worker_t * const worker, uint32_t i)
+{
+  while ((i > 0) && timer_before (worker->timers[i], worker->timers[(i - 1) / 2])) {
+    timer_swap (worker, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+static void timer_down (loadgen_worker_t * const worker, uint32_t i)
+{
+  for (;;) {
+    uint32_t                                smallest = i;
+    uint32_t                                child = 2 * i + 1;
+
+    if ((child < worker->nb_timers) && timer_before (worker->timers[child], worker->timers[smallest])) {
+      smallest = child;
+    }
+    if ((child + 1 < worker->nb_timers) && timer_before (worker->timers[child + 1], worker->timers[smallest])) {
+      smallest = child + 1;
+    }
+    if (smallest == i) {
+      return;
+    }
+    timer_swap (worker, i, smallest);
+    i = smallest;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_timer_arm (loadgen_ue_t * const ue, const uint64_t deadline_ns)
+{
+  loadgen_worker_t                       *worker = ue->enb->worker;
+
+  ue->deadline_ns = deadline_ns;
+  if (LOADGEN_TIMER_NONE == ue->timer_index) {
+    ue->timer_index = worker->nb_timers++;
+    worker->timers[ue->timer_index] = ue;
+  }
+  // the deadline moved either way
+  timer_up (worker, ue->timer_index);
+  timer_down (worker, ue->timer_index);
+}
+
+//------------------------------------------------------------------------------
+uint64_t loadgen_ue_next_deadline (const loadgen_worker_t * const worker)
+{
+  return worker->nb_timers ? worker->timers[0]->deadline_ns : UINT64_MAX;
+}
+
+//------------------------------------------------------------------------------
+loadgen_ue_t *loadgen_ue_pop_expired (loadgen_worker_t * const worker, const uint64_t now_ns)
+{
+  loadgen_ue_t                           *ue = NULL;
+
+  if ((0 == worker->nb_timers) || (worker->timers[0]->deadline_ns > now_ns)) {
+    return NULL;
+  }
+  ue = worker->timers[0];
+  timer_swap (worker, 0, --worker->nb_timers);
+  ue->timer_index = LOADGEN_TIMER_NONE;
+  timer_down (worker, 0);
+  return ue;
+}
+
+//------------------------------------------------------------------------------
+// Procedures
+//------------------------------------------------------------------------------
+
+const char * const                      loadgen_procedure_names[LOADGEN_PROC_MAX] = {
+  "attach",
+  "detach",
+  "tau",
+  "service_request",
+  "release",
+};
+
+//------------------------------------------------------------------------------
+void loadgen_ue_init (loadgen_ue_t * const ue, loadgen_enb_t * const enb, const uint16_t index, const uint64_t imsi)
+{
+  memset (ue, 0, sizeof (*ue));
+  ue->imsi = imsi;
+  ue->enb = enb;
+  ue->index = index;
+  ue->timer_index = LOADGEN_TIMER_NONE;
+  ue->procedure = LOADGEN_PROC_NONE;
+  ue->mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+  ue->enb_ue_s1ap_id = LOADGEN_ENB_UE_S1AP_ID (index, 0);
+}
+
+//------------------------------------------------------------------------------
+loadgen_ue_t *loadgen_ue_find (loadgen_enb_t * const enb, const uint32_t enb_ue_s1ap_id)
+{
+  loadgen_ue_t                           *ue = NULL;
+
+  if (LOADGEN_ENB_UE_S1AP_ID_INDEX (enb_ue_s1ap_id) >= enb->nb_ues) {
+    return NULL;
+  }
+  ue = &enb->ues[LOADGEN_ENB_UE_S1AP_ID_INDEX (enb_ue_s1ap_id)];
+  // a message for a previous S1 connection of the UE
+  if (ue->enb_ue_s1ap_id != enb_ue_s1ap_id) {
+    return NULL;
+  }
+  return ue;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t ue_think_time_ns (loadgen_ue_t * const ue)
+{
+  uint64_t                                think = (uint64_t)loadgen_config.think_time_ms * NS_PER_MS;
+
+  // uniform in [think / 2, 3 * think / 2]
+  return think / 2 + ((think + 1) * (uint64_t)rand_r (&ue->enb->worker->seed)) / ((uint64_t)RAND_MAX + 1);
+}
+
+//------------------------------------------------------------------------------
+static void ue_set_registered (loadgen_ue_t * const ue, const bool registered)
+{
+  if (ue->registered != registered) {
+    metrics_gauge_add (loadgen_metrics.ues_registered, registered ? 1 : -1);
+  }
+  ue->registered = registered;
+  if (!registered) {
+    ue->secured = false;
+    ue->ebi = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// The procedure reached its outcome, the UE may still wait for its S1 release
+static void ue_procedure_done (loadgen_ue_t * const ue, const bool rejected)
+{
+  const loadgen_procedure_metrics_t      *metrics = &loadgen_metrics.procedures[ue->procedure];
+
+  if (ue->completed) {
+    return;
+  }
+  ue->completed = true;
+  ue->rejected = rejected;
+  if (rejected) {
+    metrics_counter_add (metrics->rejected, 1);
+  } else {
+    metrics_counter_add (metrics->completed, 1);
+    metrics_histogram_record_since (metrics->latency, ue->procedure_start_ns);
+  }
+}
+
+//------------------------------------------------------------------------------
+// The UE is in a stable state, its next procedure starts after a think time
+static void ue_procedure_finish (loadgen_ue_t * const ue)
+{
+  ue->procedure = LOADGEN_PROC_NONE;
+  ue->completed = false;
+  loadgen_ue_timer_arm (ue, metrics_now_ns () + ue_think_time_ns (ue));
+}
+
+//------------------------------------------------------------------------------
+// A new S1 connection, the late messages for the previous one are ignored
+static void ue_new_connection (loadgen_ue_t * const ue)
+{
+  ue->generation++;
+  ue->enb_ue_s1ap_id = LOADGEN_ENB_UE_S1AP_ID (ue->index, ue->generation);
+  ue->mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+  ue->connected = true;
+}
+
+//------------------------------------------------------------------------------
+static void ue_send_nas (loadgen_ue_t * const ue, const uint8_t security_header_type, uint8_t *plain, int length)
+{
+  uint8_t                                 pdu[LOADGEN_MAX_PDU_SIZE];
+
+  if (SECURITY_HEADER_TYPE_NOT_PROTECTED != security_header_type) {
+    length = loadgen_nas_protect (ue, security_header_type, plain, length, pdu);
+    plain = pdu;
+  }
+  loadgen_s1ap_uplink_nas_transport (ue, plain, length);
+}
+
+//------------------------------------------------------------------------------
+static void ue_send_initial_nas (loadgen_ue_t * const ue, const uint8_t security_header_type, uint8_t *plain, int length, const long rrc_cause)
+{
+  uint8_t                                 pdu[LOADGEN_MAX_PDU_SIZE];
+
+  if (SECURITY_HEADER_TYPE_NOT_PROTECTED != security_header_type) {
+    length = loadgen_nas_protect (ue, security_header_type, plain, length, pdu);
+    plain = pdu;
+  }
+  loadgen_s1ap_initial_ue_message (ue, plain, length, rrc_cause, ue->registered);
+}
+
+//------------------------------------------------------------------------------
+static loadgen_procedure_t ue_next_procedure (loadgen_ue_t * const ue)
+{
+  static const loadgen_procedure_t        idle_procedures[] = {LOADGEN_PROC_TAU, LOADGEN_PROC_SERVICE_REQUEST, LOADGEN_PROC_DETACH};
+  uint32_t                                total = 0;
+  uint32_t                                draw = 0;
+
+  if (!ue->registered) {
+    return LOADGEN_PROC_ATTACH;
+  }
+  if (ue->connected) {
+    return LOADGEN_PROC_RELEASE;
+  }
+  for (int i = 0; i < sizeof (idle_procedures) / sizeof (idle_procedures[0]); i++) {
+    total += loadgen_config.weights[idle_procedures[i]];
+  }
+  draw = (uint32_t)(((uint64_t)total * rand_r (&ue->enb->worker->seed)) / ((uint64_t)RAND_MAX + 1));
+  for (int i = 0; i < sizeof (idle_procedures) / sizeof (idle_procedures[0]); i++) {
+    if (draw < loadgen_config.weights[idle_procedures[i]]) {
+      return idle_procedures[i];
+    }
+    draw -= loadgen_config.weights[idle_procedures[i]];
+  }
+  return LOADGEN_PROC_SERVICE_REQUEST;
+}
+
+//------------------------------------------------------------------------------
+static void ue_start_procedure (loadgen_ue_t * const ue, const loadgen_procedure_t procedure)
+{
+  uint8_t                                 plain[LOADGEN_MAX_PDU_SIZE];
+  const long                              rrc_cause = (LOADGEN_PROC_SERVICE_REQUEST == procedure) ?
+                                                       S1ap_RRC_Establishment_Cause_mo_Data : S1ap_RRC_Establishment_Cause_mo_Signalling;
+  int                                     length = 0;
+
+  ue->procedure = procedure;
+  ue->completed = false;
+  ue->rejected = false;
+  ue->procedure_start_ns = metrics_now_ns ();
+  metrics_counter_add (loadgen_metrics.procedures[procedure].started, 1);
+
+  // the eNB applies the overload action of the MME to the RRC connection requests
+  if ((LOADGEN_PROC_RELEASE != procedure) &&
+      !s1ap_mme_overload_admit ((s1ap_overload_level_t)ue->enb->overload_level, (as_cause_t)(rrc_cause + 1))) {
+    metrics_counter_add (loadgen_metrics.overload_rejected, 1);
+    ue_procedure_done (ue, true);
+    ue_procedure_finish (ue);
+    return;
+  }
+  loadgen_ue_timer_arm (ue, ue->procedure_start_ns + (uint64_t)loadgen_config.timeout_ms * NS_PER_MS);
+
+  switch (procedure) {
+  case LOADGEN_PROC_ATTACH:
+    ue_set_registered (ue, false);
+    ue->ksi = 7;
+    ue->ul_count = 0;
+    ue->dl_count = 0;
+    ue_new_connection (ue);
+    length = loadgen_nas_attach_request (ue, plain);
+    ue_send_initial_nas (ue, SECURITY_HEADER_TYPE_NOT_PROTECTED, plain, length, rrc_cause);
+    break;
+
+  case LOADGEN_PROC_TAU:
+    ue_new_connection (ue);
+    length = loadgen_nas_tracking_area_update_request (ue, plain);
+    ue_send_initial_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED, plain, length, rrc_cause);
+    break;
+
+  case LOADGEN_PROC_SERVICE_REQUEST:
+    ue_new_connection (ue);
+    length = loadgen_nas_service_request (ue, plain);
+    loadgen_s1ap_initial_ue_message (ue, plain, length, rrc_cause, true);
+    break;
+
+  case LOADGEN_PROC_DETACH:
+    ue_new_connection (ue);
+    length = loadgen_nas_detach_request (ue, plain);
+    ue_send_initial_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED, plain, length, rrc_cause);
+    break;
+
+  case LOADGEN_PROC_RELEASE:
+    loadgen_s1ap_ue_context_release_request (ue);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_timer_expired (loadgen_ue_t * const ue)
+{
+  if (LOADGEN_PROC_NONE == ue->procedure) {
+    if (!ue->enb->setup) {
+      loadgen_ue_timer_arm (ue, metrics_now_ns () + LOADGEN_ENB_SETUP_POLL_MS * NS_PER_MS);
+      return;
+    }
+    ue_start_procedure (ue, ue_next_procedure (ue));
+    return;
+  }
+
+  /*
+   * Procedure timeout: the UE forgets its S1 connection and its registration
+   * unless the procedure reached its outcome and only the S1 release is late.
+   */
+  if (!ue->completed) {
+    metrics_counter_add (loadgen_metrics.procedures[ue->procedure].timed_out, 1);
+    ue_set_registered (ue, false);
+  }
+  ue->connected = false;
+  ue->enb_ue_s1ap_id = LOADGEN_ENB_UE_S1AP_ID (ue->index, ++ue->generation);
+  ue_procedure_finish (ue);
+}
+
+//------------------------------------------------------------------------------
+// Optional IEs of the Attach Accept and Tracking Area Update Accept, only the GUTI is kept
+static void ue_parse_accept_ies (loadgen_ue_t * const ue, const uint8_t *ies, const int length, bool *guti)
+{
+  int                                     offset = 0;
+
+  while (offset < length) {
+    const uint8_t                           iei = ies[offset];
+
+    if (iei & 0x80) {
+      // type 1 IE, IEI and value in one octet
+      offset += 1;
+    } else if ((0x5A == iei) || (0x53 == iei) || (0x17 == iei) || (0x59 == iei)) {
+      // type 3: T3412, EMM cause, T3402, T3423
+      offset += 2;
+    } else if (IEI_LAI == iei) {
+      offset += 6;
+    } else if (offset + 1 < length) {
+      // type 4
+      if ((IEI_GUTI == iei) && (GUTI_LENGTH == ies[offset + 1]) && (offset + 2 + GUTI_LENGTH <= length)) {
+        const uint8_t                          *value = &ies[offset + 3];
+
+        memcpy (ue->guti_plmn, value, 3);
+        ue->mme_gid = (value[3] << 8) | value[4];
+        ue->mme_code = value[5];
+        ue->m_tmsi = ((uint32_t)value[6] << 24) | (value[7] << 16) | (value[8] << 8) | value[9];
+        *guti = true;
+      }
+      offset += 2 + ies[offset + 1];
+    } else {
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void ue_attach_accept (loadgen_ue_t * const ue, const uint8_t *message, const int length)
+{
+  int                                     offset = 4;   // EPS attach result, T3412
+  int                                     esm_length = 0;
+  bool                                    guti = false;
+
+  // TAI list
+  if (offset >= length) {
+    goto error;
+  }
+  offset += 1 + message[offset];
+  // ESM message container: Activate Default EPS Bearer Context Request
+  if (offset + 2 > length) {
+    goto error;
+  }
+  esm_length = (message[offset] << 8) | message[offset + 1];
+  offset += 2;
+  if ((esm_length < 3) || (offset + esm_length > length)) {
+    goto error;
+  }
+  ue->ebi = message[offset] >> 4;
+  ue->pti = message[offset + 1];
+  offset += esm_length;
+  ue_parse_accept_ies (ue, &message[offset], length - offset, &guti);
+  if (!guti) {
+    goto error;
+  }
+  return;
+
+error:
+  metrics_counter_add (loadgen_metrics.nas_errors, 1);
+  ue->ebi = 0;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_downlink_nas (loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id, uint8_t *pdu, const int length)
+{
+  uint8_t                                 plain[LOADGEN_MAX_PDU_SIZE];
+  uint8_t                                 res[8];
+  uint8_t                                *message = NULL;
+  int                                     offset = 0;
+  int                                     size = 0;
+  bool                                    guti = false;
+
+  ue->mme_ue_s1ap_id = mme_ue_s1ap_id;
+  if (length < 2) {
+    metrics_counter_add (loadgen_metrics.nas_errors, 1);
+    return;
+  }
+
+  /*
+   * The Security Mode Command is protected with the context it activates:
+   * the keys of the selected algorithms are derived before checking its MAC.
+   */
+  if (((SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW << 4) | EPS_MOBILITY_MANAGEMENT_MESSAGE) == pdu[0] && (length > 9) &&
+      (SECURITY_MODE_COMMAND == pdu[7])) {
+    ue->eea = (pdu[8] >> 4) & 0x07;
+    ue->eia = pdu[8] & 0x07;
+    ue->ksi = pdu[9] & 0x07;
+    ue->ul_count = 0;
+    ue->dl_count = 0;
+    loadgen_nas_derive_keys (ue);
+    ue->secured = true;
+  }
+  if ((offset = loadgen_nas_unprotect (ue, pdu, length)) < 0) {
+    metrics_counter_add (loadgen_metrics.nas_errors, 1);
+    return;
+  }
+  message = &pdu[offset];
+  if ((offset + 2 > length) || (EPS_MOBILITY_MANAGEMENT_MESSAGE != (message[0] & 0x0F))) {
+    return;
+  }
+
+  switch (message[1]) {
+  case AUTHENTICATION_REQUEST:
+    // NAS key set identifier, RAND, AUTN (LV)
+    if ((length - offset < 36) || (16 != message[19]) ||
+        (RETURNok != loadgen_usim_authenticate (&message[3], &message[20], res, ue->kasme))) {
+      metrics_counter_add (loadgen_metrics.nas_errors, 1);
+      ue_procedure_done (ue, true);
+      return;
+    }
+    ue->ksi = message[2] & 0x07;
+    size = loadgen_nas_authentication_response (res, plain);
+    ue_send_nas (ue, SECURITY_HEADER_TYPE_NOT_PROTECTED, plain, size);
+    break;
+
+  case SECURITY_MODE_COMMAND:
+    size = loadgen_nas_security_mode_complete (plain);
+    ue_send_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED_NEW, plain, size);
+    break;
+
+  case IDENTITY_REQUEST:
+    size = loadgen_nas_identity_response (ue, plain);
+    ue_send_nas (ue, ue->secured ? SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED : SECURITY_HEADER_TYPE_NOT_PROTECTED, plain, size);
+    break;
+
+  case ATTACH_ACCEPT:
+    // completed with the Attach Complete, once the Initial Context Setup is answered
+    ue_attach_accept (ue, message, length - offset);
+    break;
+
+  case TRACKING_AREA_UPDATE_ACCEPT:
+    ue_parse_accept_ies (ue, &message[3], length - offset - 3, &guti);
+    if (guti) {
+      size = loadgen_nas_tracking_area_update_complete (plain);
+      ue_send_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED, plain, size);
+    }
+    if (LOADGEN_PROC_TAU == ue->procedure) {
+      ue_procedure_done (ue, false);
+    }
+    break;
+
+  case DETACH_ACCEPT:
+    ue_set_registered (ue, false);
+    if (LOADGEN_PROC_DETACH == ue->procedure) {
+      ue_procedure_done (ue, false);
+    }
+    break;
+
+  case DETACH_REQUEST:
+    // network initiated, the S1 release follows
+    size = loadgen_nas_detach_accept (plain);
+    ue_send_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED, plain, size);
+    ue_set_registered (ue, false);
+    if (LOADGEN_PROC_NONE != ue->procedure) {
+      ue_procedure_done (ue, true);
+    }
+    break;
+
+  case ATTACH_REJECT:
+  case AUTHENTICATION_REJECT:
+  case TRACKING_AREA_UPDATE_REJECT:
+  case SERVICE_REJECT:
+    ue_set_registered (ue, false);
+    if (LOADGEN_PROC_NONE != ue->procedure) {
+      ue_procedure_done (ue, true);
+    }
+    break;
+
+  default:
+    // EMM Information, EMM Status
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_initial_context_setup (loadgen_ue_t * const ue, const uint32_t mme_ue_s1ap_id, const long e_rab_id, uint8_t *pdu, const int length)
+{
+  uint8_t                                 plain[LOADGEN_MAX_PDU_SIZE];
+  int                                     size = 0;
+
+  ue->mme_ue_s1ap_id = mme_ue_s1ap_id;
+  if (pdu) {
+    loadgen_ue_downlink_nas (ue, mme_ue_s1ap_id, pdu, length);
+  }
+  loadgen_s1ap_initial_context_setup_response (ue, e_rab_id);
+
+  switch (ue->procedure) {
+  case LOADGEN_PROC_ATTACH:
+    if ((0 == ue->ebi) || ue->completed) {
+      return;
+    }
+    size = loadgen_nas_attach_complete (ue, ue->pti, plain);
+    ue_send_nas (ue, SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED, plain, size);
+    ue_set_registered (ue, true);
+    ue_procedure_done (ue, false);
+    ue_procedure_finish (ue);
+    break;
+
+  case LOADGEN_PROC_SERVICE_REQUEST:
+    ue_procedure_done (ue, false);
+    ue_procedure_finish (ue);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_ue_context_release (loadgen_ue_t * const ue)
+{
+  ue->connected = false;
+  ue->mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+  if (LOADGEN_PROC_NONE == ue->procedure) {
+    return;
+  }
+  if (LOADGEN_PROC_RELEASE == ue->procedure) {
+    ue_procedure_done (ue, false);
+  } else if (!ue->completed) {
+    // released by the MME before the procedure reached its outcome
+    if (LOADGEN_PROC_ATTACH == ue->procedure) {
+      ue_set_registered (ue, false);
+    }
+    ue_procedure_done (ue, true);
+  }
+  ue_procedure_finish (ue);
+}
@@ -0,0 +1,56 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file loadgen_usim.c
+  \brief USIM side of the EPS AKA: checks the AUTN of the network and
+  computes RES and KASME with the MILENAGE functions of milenage.c.
+  \author
+  \company
+  \email
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "milenage.h"
+#include "loadgen.h"
+
+//------------------------------------------------------------------------------
+int loadgen_usim_authenticate (const uint8_t rand[16], const uint8_t autn[16], uint8_t res[8], uint8_t kasme[32])
+{
+  uint8_t                                 ck[16];
+  uint8_t                                 ik[16];
+  uint8_t                                 ak[6];
+  uint8_t                                 sqn[6];
+  uint8_t                                 mac_a[8];
+
+  milenage_f2345 (loadgen_config.k, loadgen_config.opc, rand, res, ck, ik, ak);
+  // AUTN = SQN xor AK || AMF || MAC-A, the SQN is not checked against the USIM one
+  for (int i = 0; i < 6; i++) {
+    sqn[i] = autn[i] ^ ak[i];
+  }
+  milenage_f1 (loadgen_config.k, loadgen_config.opc, rand, sqn, &autn[6], mac_a);
+  if (memcmp (mac_a, &autn[8], 8)) {
+    return RETURNerror;
+  }
+  milenage_kasme (ck, ik, loadgen_config.plmn, autn, kasme);
+  return RETURNok;
+}
@@ -0,0 +1,129 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file milenage.c
+  \brief MILENAGE f1 to f5 (TS 35.206) and KASME (TS 33.401 A.2), shared by
+  the USIM of the load generator and the vectors of the stub HSS. Unlike the
+  HSS implementation the key schedule is on the stack, the callers compute
+  their vectors concurrently.
+  \author
+  \company
+  \email
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include <nettle/aes.h>
+
+#include "security_types.h"
+#include "secu_defs.h"
+#include "milenage.h"
+
+//------------------------------------------------------------------------------
+static void milenage_temp (struct aes_ctx *ctx, const uint8_t k[16], const uint8_t opc[16], const uint8_t rand[16], uint8_t temp[16])
+{
+  uint8_t                                 in[16];
+
+  aes_set_encrypt_key (ctx, 16, k);
+  for (int i = 0; i < 16; i++) {
+    in[i] = rand[i] ^ opc[i];
+  }
+  aes_encrypt (ctx, 16, temp, in);
+}
+
+//------------------------------------------------------------------------------
+// OUT = E[rot(TEMP xor OPc, r) xor c]K xor OPc, c having its last byte only set
+static void milenage_out (struct aes_ctx *ctx, const uint8_t opc[16], const uint8_t temp[16], const int r_bytes, const uint8_t c, uint8_t out[16])
+{
+  uint8_t                                 in[16];
+
+  for (int i = 0; i < 16; i++) {
+    in[(i + 16 - r_bytes) % 16] = temp[i] ^ opc[i];
+  }
+  in[15] ^= c;
+  aes_encrypt (ctx, 16, out, in);
+  for (int i = 0; i < 16; i++) {
+    out[i] ^= opc[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+void milenage_f1 (const uint8_t k[16], const uint8_t opc[16], const uint8_t rand[16], const uint8_t sqn[6], const uint8_t amf[2], uint8_t mac_a[8])
+{
+  struct aes_ctx                          ctx;
+  uint8_t                                 temp[16];
+  uint8_t                                 in[16];
+  uint8_t                                 out[16];
+
+  milenage_temp (&ctx, k, opc, rand, temp);
+  memcpy (&in[0], sqn, 6);
+  memcpy (&in[6], amf, 2);
+  memcpy (&in[8], sqn, 6);
+  memcpy (&in[14], amf, 2);
+  // OUT1 = E[TEMP xor rot(IN1 xor OPc, r1)]K xor OPc, r1 = 64 bits, c1 = 0
+  for (int i = 0; i < 16; i++) {
+    out[(i + 8) % 16] = in[i] ^ opc[i];
+  }
+  for (int i = 0; i < 16; i++) {
+    in[i] = out[i] ^ temp[i];
+  }
+  aes_encrypt (&ctx, 16, out, in);
+  for (int i = 0; i < 8; i++) {
+    mac_a[i] = out[i] ^ opc[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+void milenage_f2345 (const uint8_t k[16], const uint8_t opc[16], const uint8_t rand[16], uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6])
+{
+  struct aes_ctx                          ctx;
+  uint8_t                                 temp[16];
+  uint8_t                                 out[16];
+
+  milenage_temp (&ctx, k, opc, rand, temp);
+  // f2 and f5: r2 = 0, c2 = 1
+  milenage_out (&ctx, opc, temp, 0, 1, out);
+  memcpy (res, &out[8], 8);
+  memcpy (ak, &out[0], 6);
+  // f3: r3 = 32 bits, c3 = 2
+  milenage_out (&ctx, opc, temp, 4, 2, ck);
+  // f4: r4 = 64 bits, c4 = 4
+  milenage_out (&ctx, opc, temp, 8, 4, ik);
+}
+
+//------------------------------------------------------------------------------
+void milenage_kasme (const uint8_t ck[16], const uint8_t ik[16], const uint8_t plmn[3], const uint8_t sqn_xor_ak[6], uint8_t kasme[32])
+{
+  uint8_t                                 key[32];
+  uint8_t                                 s[14];
+
+  memcpy (&key[0], ck, 16);
+  memcpy (&key[16], ik, 16);
+  // S = FC || SN id || 0x00 0x03 || SQN xor AK || 0x00 0x06
+  s[0] = FC_KASME;
+  memcpy (&s[1], plmn, 3);
+  s[4] = 0x00;
+  s[5] = 0x03;
+  memcpy (&s[6], sqn_xor_ak, 6);
+  s[12] = 0x00;
+  s[13] = 0x06;
+  kdf (key, 32, s, 14, kasme, 32);
+}
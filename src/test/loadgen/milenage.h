@@ -0,0 +1,43 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file milenage.h
+  \brief MILENAGE algorithm set (TS 35.206) and KASME derivation (TS 33.401
+  A.2) of the EPS AKA, for the simulated USIMs and the stub HSS.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_MILENAGE_SEEN
+#define FILE_MILENAGE_SEEN
+
+#include <stdint.h>
+
+// f1: network authentication code MAC-A
+void milenage_f1 (const uint8_t k[16], const uint8_t opc[16], const uint8_t rand[16], const uint8_t sqn[6], const uint8_t amf[2], uint8_t mac_a[8]);
+
+// f2 to f5: RES, CK, IK and AK
+void milenage_f2345 (const uint8_t k[16], const uint8_t opc[16], const uint8_t rand[16], uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6]);
+
+// KASME = KDF (CK || IK, FC || SN id || SQN xor AK), the SN id being the TBCD encoded PLMN
+void milenage_kasme (const uint8_t ck[16], const uint8_t ik[16], const uint8_t plmn[3], const uint8_t sqn_xor_ak[6], uint8_t kasme[32]);
+
+#endif /* FILE_MILENAGE_SEEN */
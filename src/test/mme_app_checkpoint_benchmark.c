@@ -0,0 +1,257 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Restore time of the UE context checkpoint of mme_app_checkpoint.c:
+ * NB_OF_UES records of registered UEs in ECM-IDLE (one default bearer,
+ * subscription data, security context) are written in the slots of their
+ * shard of a checkpoint file, as the MME_APP tasks do, the file is closed and
+ * evicted from the page cache, then mapped again and every record is
+ * restored: UE context, subscription and bearer context from the slab pools,
+ * mme_ue_s1ap_id, IMSI, S11 TEID and GUTI keys as MME_APP keeps them. The EMM
+ * and ESM contexts (9 KB per UE) are not rebuilt here, their copy from the
+ * record costs as much as the copy of the MME_APP context.
+ *
+ * usage: mme_app_checkpoint_benchmark [file (/tmp/mme_ue_contexts.ckpt)] [UEs (1000000)] [shards (4)]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "hashtable.h"
+#include "obj_hashtable.h"
+#include "slab_pool.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_checkpoint_file.h"
+
+#define NB_OF_UES                   (1000 * 1000)
+#define NB_OF_SHARDS                4
+#define DEFAULT_EBI                 5
+
+static struct {
+  hash_table_ts_t                        *mme_ue_s1ap_id_htbl;
+  hash_table_ts_t                        *imsi_htbl;
+  hash_table_ts_t                        *tun11_htbl;
+  obj_hash_table_t                       *guti_htbl;
+  slab_pool_t                            *ue_context_pool;
+  slab_pool_t                            *subscription_pool;
+  uint64_t                                nb_restored;
+  uint64_t                                nb_bad;
+} bench;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t rss_bytes (void)
+{
+  unsigned long                           size = 0;
+  unsigned long                           resident = 0;
+  FILE                                   *f = fopen ("/proc/self/statm", "r");
+
+  if (f) {
+    if (2 != fscanf (f, "%lu %lu", &size, &resident)) {
+      resident = 0;
+    }
+    fclose (f);
+  }
+  return (uint64_t)resident * sysconf (_SC_PAGESIZE);
+}
+
+// the tables do not own the contexts
+static void no_free (void **data)
+{
+  *data = NULL;
+}
+
+static void fill_record (mme_app_checkpoint_record_t * const record, const mme_ue_s1ap_id_t ue_id, const int nb_shards)
+{
+  memset (record, 0, sizeof (*record));
+  record->mme_ue_s1ap_id = ue_id;
+  record->imsi = 208930000000000ULL + ue_id;
+  record->guti.gummei.mme_code = 1;
+  record->guti.gummei.mme_gid = 4;
+  record->guti.m_tmsi = (ue_id << 4) | (ue_id % nb_shards);
+  record->mme_s11_teid = (ue_id << 6) | (ue_id % nb_shards);
+  record->sgw_s11_teid = ue_id;
+  record->default_bearer_id = DEFAULT_EBI;
+  record->bearers[0].ebi = DEFAULT_EBI;
+  record->bearers[0].has_context = true;
+  record->bearers[0].has_esm = true;
+  record->bearers[0].is_default = true;
+  record->bearers[0].context.s_gw_teid = ue_id;
+  record->bearers[0].context.qci = 9;
+  record->has_subscription = true;
+  record->subscription.apn_profile.nb_apns = 1;
+  record->subscription.subscribed_ambr.br_ul = 50000000;
+  record->subscription.subscribed_ambr.br_dl = 100000000;
+  memset (record->security.knas_int, (int)ue_id, sizeof (record->security.knas_int));
+  memset (record->vector.kasme, (int)ue_id, sizeof (record->vector.kasme));
+  record->pdns[0].pid = 0;
+  strcpy (record->pdns[0].apn, "internet");
+  record->pdns[1].pid = -1;
+}
+
+static bool restore_ue (const mme_app_checkpoint_record_t * const record, const int shard, const uint32_t slot, void * const arg)
+{
+  ue_context_t                           *ue_context_p = NULL;
+
+  if ((int)(record->mme_ue_s1ap_id % *(int *)arg) != shard) {
+    bench.nb_bad++;
+    return false;
+  }
+  ue_context_p = slab_pool_alloc (bench.ue_context_pool);
+  if (!ue_context_p) {
+    return false;
+  }
+  ue_context_p->mme_ue_s1ap_id = record->mme_ue_s1ap_id;
+  ue_context_p->imsi = record->imsi;
+  ue_context_p->guti = record->guti;
+  ue_context_p->is_guti_set = true;
+  ue_context_p->mme_s11_teid = record->mme_s11_teid;
+  ue_context_p->sgw_s11_teid = record->sgw_s11_teid;
+  ue_context_p->default_bearer_id = record->default_bearer_id;
+  ue_context_p->last_tai = record->last_tai;
+  ue_context_p->e_utran_cgi = record->e_utran_cgi;
+  ue_context_p->used_ambr = record->used_ambr;
+  ue_context_p->paa = record->paa;
+  ue_context_p->ecm_state = ECM_IDLE;
+  ue_context_p->checkpoint_slot = slot;
+  if (record->has_subscription) {
+    ue_context_p->subscription = slab_pool_alloc (bench.subscription_pool);
+    *ue_context_p->subscription = record->subscription;
+  }
+  for (int i = 0; i < MME_APP_CHECKPOINT_MAX_BEARERS; i++) {
+    if ((record->bearers[i].ebi) && (record->bearers[i].has_context)) {
+      // the first bearer of a UE is embedded in its context
+      ue_context_p->embedded_bearer = record->bearers[i].context;
+      ue_context_p->eps_bearers[record->bearers[i].ebi] = &ue_context_p->embedded_bearer;
+    }
+  }
+  hashtable_ts_insert (bench.mme_ue_s1ap_id_htbl, ue_context_p->mme_ue_s1ap_id, ue_context_p);
+  hashtable_ts_insert (bench.imsi_htbl, ue_context_p->imsi, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+  hashtable_ts_insert (bench.tun11_htbl, ue_context_p->mme_s11_teid, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+  obj_hashtable_ts_insert (bench.guti_htbl, &ue_context_p->guti, sizeof (ue_context_p->guti), (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+  bench.nb_restored++;
+  return true;
+}
+
+static void drop_page_cache (const char * const path)
+{
+  int                                     fd = open (path, O_RDONLY);
+
+  if (fd >= 0) {
+    fdatasync (fd);
+    posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+    close (fd);
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  const char                             *path = (argc > 1) ? argv[1] : "/tmp/mme_ue_contexts.ckpt";
+  uint64_t                                nb_ues = (argc > 2) ? strtoull (argv[2], NULL, 10) : NB_OF_UES;
+  int                                     nb_shards = (argc > 3) ? atoi (argv[3]) : NB_OF_SHARDS;
+  gummei_t                                gummei = {.mme_gid = 4, .mme_code = 1};
+  mme_app_checkpoint_file_stats_t         stats = {0};
+  mme_app_checkpoint_record_t             record;
+  uint64_t                                start_ns = 0;
+  uint64_t                                rss_before = 0;
+  ue_context_t                           *ue_context_p = NULL;
+  int                                     nb_kept = 0;
+
+  if ((nb_shards < 1) || (nb_shards > 16) || (nb_ues >= UINT32_MAX)) {
+    fprintf (stderr, "Bad arguments\n");
+    return EXIT_FAILURE;
+  }
+  unlink (path);
+  if (mme_app_checkpoint_file_open (path, nb_ues, nb_shards, &gummei, NULL, NULL) < 0) {
+    fprintf (stderr, "Failed to map %s\n", path);
+    return EXIT_FAILURE;
+  }
+  printf ("%" PRIu64 " UEs on %d shards, %zu bytes per record\n", nb_ues, nb_shards, sizeof (mme_app_checkpoint_record_t));
+
+  /*
+   * Checkpoint, ids c * nb_shards + shard as given by the shards
+   */
+  start_ns = now_ns ();
+  for (mme_ue_s1ap_id_t ue_id = nb_shards; ue_id < nb_ues + nb_shards; ue_id++) {
+    int                                   shard = ue_id % nb_shards;
+    uint32_t                              slot = mme_app_checkpoint_file_alloc (shard);
+
+    if (MME_APP_CHECKPOINT_SLOT_NONE == slot) {
+      fprintf (stderr, "Checkpoint file full\n");
+      return EXIT_FAILURE;
+    }
+    fill_record (&record, ue_id, nb_shards);
+    mme_app_checkpoint_file_write (shard, slot, &record);
+  }
+  for (int shard = 0; shard < nb_shards; shard++) {
+    mme_app_checkpoint_file_sync (shard);
+  }
+  mme_app_checkpoint_file_get_stats (&stats);
+  printf ("checkpoint  %8.1f ms  %10.0f records/s  %" PRIu64 " records, file %.1f MB\n", (double)(now_ns () - start_ns) / 1e6,
+      (double)nb_ues * 1e9 / (double)(now_ns () - start_ns), stats.nb_records, (double)stats.file_bytes / (1024 * 1024));
+  start_ns = now_ns ();
+  mme_app_checkpoint_file_close ();
+  printf ("close       %8.1f ms  (synchronous write back)\n", (double)(now_ns () - start_ns) / 1e6);
+  drop_page_cache (path);
+
+  /*
+   * Restart: restore into the MME_APP collections
+   */
+  bench.mme_ue_s1ap_id_htbl = hashtable_ts_create (nb_ues, NULL, no_free, NULL);
+  bench.imsi_htbl = hashtable_ts_create (nb_ues, NULL, hash_free_int_func, NULL);
+  bench.tun11_htbl = hashtable_ts_create (nb_ues, NULL, hash_free_int_func, NULL);
+  bench.guti_htbl = obj_hashtable_ts_create (nb_ues, NULL, hash_free_int_func, hash_free_int_func, NULL);
+  bench.ue_context_pool = slab_pool_create (sizeof (ue_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  bench.subscription_pool = slab_pool_create (sizeof (ue_subscription_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  if ((!bench.ue_context_pool) || (!bench.subscription_pool)) {
+    fprintf (stderr, "Allocation failed\n");
+    return EXIT_FAILURE;
+  }
+  rss_before = rss_bytes ();
+  start_ns = now_ns ();
+  nb_kept = mme_app_checkpoint_file_open (path, nb_ues, nb_shards, &gummei, restore_ue, &nb_shards);
+  printf ("restore     %8.1f ms  %10.0f UEs/s  %d UEs restored (%" PRIu64 " rejected), RSS +%.1f MB\n", (double)(now_ns () - start_ns) / 1e6,
+      (double)bench.nb_restored * 1e9 / (double)(now_ns () - start_ns), nb_kept, bench.nb_bad, (double)(rss_bytes () - rss_before) / (1024 * 1024));
+
+  // a restored UE is found by its GUTI as on its TAU
+  fill_record (&record, nb_shards + nb_ues / 2, nb_shards);
+  if ((HASH_TABLE_OK != hashtable_ts_get (bench.mme_ue_s1ap_id_htbl, record.mme_ue_s1ap_id, (void **)&ue_context_p)) ||
+      (memcmp (&ue_context_p->guti, &record.guti, sizeof (guti_t))) || (ue_context_p->eps_bearers[DEFAULT_EBI]->s_gw_teid != record.bearers[0].context.s_gw_teid) ||
+      (nb_kept != (int)nb_ues)) {
+    fprintf (stderr, "Restored contexts differ from the checkpoint\n");
+    return EXIT_FAILURE;
+  }
+  mme_app_checkpoint_file_close ();
+  unlink (path);
+  return EXIT_SUCCESS;
+}
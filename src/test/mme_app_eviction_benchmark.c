@@ -0,0 +1,494 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Soak of the UE context eviction, linked with mme_app_eviction.c, the record
+ * codec of mme_app_checkpoint_file.c and mme_app_cold_store.c as the MME runs
+ * them: NB_OF_IMSIS distinct IMSIs attach once and go to ECM-IDLE (UE context,
+ * subscription data and the mme_ue_s1ap_id, IMSI and GUTI keys, as MME_APP
+ * keeps them), one attach in REATTACH_EVERY is a UE which left memory earlier
+ * coming back with its GUTI. Every ATTACHES_PER_PERIOD attaches, the eviction
+ * timer of the MME_APP task runs: the UEs over the memory budget are packed in
+ * records (MME_APP and NAS parts) and released, or implicitly detached into
+ * the cold store over MAX_EVICTED_UES records. A returning UE is restored from
+ * its record, else identified from the cold store, else identified again.
+ *
+ * The ITTI messages between MME_APP and NAS are queued and handled in this
+ * thread, NAS completing the records as nas_proc_ue_record_req does. The EMM
+ * and ESM contexts are not kept here, the records carry their parts. The
+ * resident contexts, the records and the RSS are printed along the run: with
+ * a budget the RSS levels off once the budget is reached, without budget
+ * (first argument 0) it grows with the number of subscribers.
+ *
+ * usage: mme_app_eviction_benchmark [budget MB (256)] [IMSIs (5000000)] [cold store records (1000000)] [max evicted UEs (0 for IMSIs)]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "intertask_interface.h"
+#include "timer.h"
+#include "hashtable.h"
+#include "obj_hashtable.h"
+#include "slab_pool.h"
+#include "mme_config.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_shard.h"
+#include "mme_app_cold_store.h"
+#include "mme_app_checkpoint_file.h"
+
+#define NB_OF_IMSIS                 (5 * 1000 * 1000)
+#define ATTACHES_PER_PERIOD         (50 * 1000)
+#define REPORT_EVERY                (500 * 1000)
+#define REATTACH_EVERY              10
+#define LEFT_UES                    (64 * 1024)     // UEs which left memory recently, power of 2
+#define DEFAULT_EBI                 5
+#define T3412_MIN                   54
+
+typedef struct left_ue_s {
+  guti_t                                  guti;
+  imsi64_t                                imsi;
+} left_ue_t;
+
+TAILQ_HEAD (message_queue_s, queued_message_s);
+
+typedef struct queued_message_s {
+  TAILQ_ENTRY (queued_message_s)          entries;
+  MessageDef                             *message_p;
+} queued_message_t;
+
+mme_app_desc_t                          mme_app_desc;
+mme_config_t                            mme_config;
+
+static struct {
+  struct message_queue_s                  queue;          // to MME_APP and NAS
+  mme_ue_s1ap_id_t                        next_ue_id;
+  tmsi_t                                  next_m_tmsi;
+  teid_t                                  next_teid;
+  left_ue_t                               left_ues[LEFT_UES];
+  uint64_t                                nb_left;
+  uint64_t                                nb_reattaches;
+  uint64_t                                nb_restored;
+  uint64_t                                nb_cold_hits;
+  uint64_t                                nb_identified;
+  uint64_t                                nb_detached;
+} soak;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t rss_bytes (void)
+{
+  unsigned long                           size = 0;
+  unsigned long                           resident = 0;
+  FILE                                   *f = fopen ("/proc/self/statm", "r");
+
+  if (f) {
+    if (2 != fscanf (f, "%lu %lu", &size, &resident)) {
+      resident = 0;
+    }
+    fclose (f);
+  }
+  return (uint64_t)resident * sysconf (_SC_PAGESIZE);
+}
+
+// the tables do not own the contexts
+static void no_free (void **data)
+{
+  *data = NULL;
+}
+
+static void imsi64_to_imsi (const imsi64_t imsi64, imsi_t * const imsi)
+{
+  memset (imsi, 0, sizeof (*imsi));
+  imsi->length = 15;
+  memcpy (imsi->u.value, &imsi64, sizeof (imsi64));
+}
+
+//------------------------------------------------------------------------------
+// ITTI, timers and logs of the MME, the messages are handled by dispatch ()
+MessageDef *itti_alloc_new_message (task_id_t origin_task_id, MessagesIds message_id)
+{
+  MessageDef                             *message_p = calloc (1, sizeof (MessageDef));
+
+  if (!message_p) {
+    fprintf (stderr, "Message allocation failed\n");
+    exit (EXIT_FAILURE);
+  }
+  message_p->ittiMsgHeader.messageId = message_id;
+  message_p->ittiMsgHeader.originTaskId = origin_task_id;
+  return message_p;
+}
+
+int itti_send_msg_to_task (task_id_t task_id, instance_t instance, MessageDef *message_p)
+{
+  queued_message_t                       *queued_p = calloc (1, sizeof (queued_message_t));
+
+  message_p->ittiMsgHeader.destinationTaskId = task_id;
+  message_p->ittiMsgHeader.instance = instance;
+  queued_p->message_p = message_p;
+  TAILQ_INSERT_TAIL (&soak.queue, queued_p, entries);
+  return 0;
+}
+
+bool itti_task_overloaded (const task_id_t task_id)
+{
+  return false;
+}
+
+int timer_setup (uint32_t interval_sec, uint32_t interval_us, task_id_t task_id, int32_t instance, timer_type_t type, void *timer_arg, long *timer_id)
+{
+  *timer_id = 1;
+  return 0;
+}
+
+int timer_remove (long timer_id)
+{
+  return 0;
+}
+
+void log_func (bool is_entering, const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const function)
+{
+}
+
+void log_func_return (const log_proto_t protoP, const char *const source_fileP, const unsigned int line_numP, const char *const functionP, const long return_codeP)
+{
+}
+
+void log_message (log_thread_ctxt_t * const thread_ctxtP, const log_level_t log_levelP, const log_proto_t protoP, const char *const source_fileP,
+                  const unsigned int line_numP, char *format, ...)
+{
+}
+
+//------------------------------------------------------------------------------
+// UE contexts of MME_APP, as mme_app_context.c keeps them
+ue_context_t *mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_t * const mme_ue_context, const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  ue_context_t                           *ue_context_p = NULL;
+
+  hashtable_ts_get (mme_ue_context->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void **)&ue_context_p);
+  return ue_context_p;
+}
+
+ue_context_t *mme_ue_context_exists_imsi (mme_ue_context_t * const mme_ue_context, const imsi64_t imsi)
+{
+  void                                   *id = NULL;
+
+  if (HASH_TABLE_OK != hashtable_ts_get (mme_ue_context->imsi_ue_context_htbl, (const hash_key_t)imsi, &id)) {
+    return NULL;
+  }
+  return mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context, (mme_ue_s1ap_id_t)(uintptr_t)id);
+}
+
+static void insert_ue_context (ue_context_t * const ue_context_p)
+{
+  mme_ue_context_t                       *contexts = &mme_app_desc.mme_ue_contexts;
+
+  hashtable_ts_insert (contexts->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id, ue_context_p);
+  hashtable_ts_insert (contexts->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->imsi, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+  hashtable_ts_insert (contexts->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_s11_teid, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+  obj_hashtable_ts_insert (contexts->guti_ue_context_htbl, &ue_context_p->guti, sizeof (ue_context_p->guti), (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id);
+}
+
+void mme_remove_ue_context (mme_ue_context_t * const mme_ue_context, struct ue_context_s * const ue_context_p)
+{
+  void                                   *unused = NULL;
+  ue_context_t                           *context_p = ue_context_p;
+
+  mme_app_eviction_ue_forget (ue_context_p);
+  soak.left_ues[soak.nb_left++ & (LEFT_UES - 1)] = (left_ue_t) {.guti = ue_context_p->guti, .imsi = ue_context_p->imsi};
+  hashtable_ts_remove (mme_ue_context->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id, &unused);
+  hashtable_ts_remove (mme_ue_context->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->imsi, &unused);
+  hashtable_ts_remove (mme_ue_context->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_s11_teid, &unused);
+  obj_hashtable_ts_remove (mme_ue_context->guti_ue_context_htbl, &ue_context_p->guti, sizeof (ue_context_p->guti), &unused);
+  slab_pool_free (mme_ue_context->subscription_pool, (void **)&context_p->subscription);
+  slab_pool_free (mme_ue_context->ue_context_pool, (void **)&context_p);
+}
+
+void mme_app_handle_implicit_detach_timer_expiry (struct ue_context_s *ue_context_p)
+{
+  MessageDef                             *message_p = itti_alloc_new_message (TASK_MME_APP, NAS_IMPLICIT_DETACH_UE_IND);
+
+  NAS_IMPLICIT_DETACH_UE_IND (message_p).ue_id = ue_context_p->mme_ue_s1ap_id;
+  NAS_IMPLICIT_DETACH_UE_IND (message_p).is_idle = true;
+  itti_send_msg_to_task (nas_task_of_ue_id (ue_context_p->mme_ue_s1ap_id), INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+// Records, as mme_app_checkpoint.c fills and restores them, without checkpoint file
+bool mme_app_checkpoint_fill_ue (const struct ue_context_s * const ue_context_p, mme_app_checkpoint_record_t * const record)
+{
+  memset (record, 0, sizeof (*record));
+  record->mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
+  record->imsi = ue_context_p->imsi;
+  record->guti = ue_context_p->guti;
+  record->mme_s11_teid = ue_context_p->mme_s11_teid;
+  record->sgw_s11_teid = ue_context_p->sgw_s11_teid;
+  record->default_bearer_id = ue_context_p->default_bearer_id;
+  record->bearers[0].ebi = DEFAULT_EBI;
+  record->bearers[0].has_context = true;
+  record->bearers[0].has_esm = true;
+  record->bearers[0].is_default = true;
+  record->bearers[0].context.s_gw_teid = ue_context_p->sgw_s11_teid;
+  record->bearers[0].context.qci = 9;
+  record->has_subscription = true;
+  record->subscription = *ue_context_p->subscription;
+  return true;
+}
+
+// EMM and ESM parts, as NAS adds them
+static void fill_nas (mme_app_checkpoint_record_t * const record)
+{
+  memset (record->security.knas_int, (int)record->mme_ue_s1ap_id, sizeof (record->security.knas_int));
+  memset (record->vector.kasme, (int)record->mme_ue_s1ap_id, sizeof (record->vector.kasme));
+  record->pdns[0].pid = 0;
+  strcpy (record->pdns[0].apn, "internet");
+  record->pdns[1].pid = -1;
+}
+
+struct ue_context_s *mme_app_checkpoint_restore_ue_context (const mme_app_checkpoint_record_t * const record)
+{
+  ue_context_t                           *ue_context_p = NULL;
+
+  if (mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, record->mme_ue_s1ap_id)) {
+    return NULL;
+  }
+  if (!(ue_context_p = slab_pool_alloc (mme_app_desc.mme_ue_contexts.ue_context_pool))) {
+    return NULL;
+  }
+  ue_context_p->mme_ue_s1ap_id = record->mme_ue_s1ap_id;
+  ue_context_p->imsi = record->imsi;
+  ue_context_p->guti = record->guti;
+  ue_context_p->is_guti_set = true;
+  ue_context_p->mme_s11_teid = record->mme_s11_teid;
+  ue_context_p->sgw_s11_teid = record->sgw_s11_teid;
+  ue_context_p->default_bearer_id = record->default_bearer_id;
+  ue_context_p->ecm_state = ECM_IDLE;
+  ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  ue_context_p->mobile_reachability_timer.sec = (T3412_MIN + 4) * 60;
+  ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  ue_context_p->implicit_detach_timer.sec = (T3412_MIN + 4) * 60;
+  if ((ue_context_p->subscription = slab_pool_alloc (mme_app_desc.mme_ue_contexts.subscription_pool))) {
+    *ue_context_p->subscription = record->subscription;
+  }
+  insert_ue_context (ue_context_p);
+  return ue_context_p;
+}
+
+uint32_t mme_app_checkpoint_write_record (uint32_t slot, mme_app_checkpoint_record_t * const record)
+{
+  return MME_APP_CHECKPOINT_SLOT_NONE;
+}
+
+void mme_app_checkpoint_release_record (const uint32_t slot)
+{
+}
+
+//------------------------------------------------------------------------------
+// MME_APP and NAS tasks
+static void dispatch (void)
+{
+  queued_message_t                       *queued_p = NULL;
+  MessageDef                             *message_p = NULL;
+  ue_context_t                           *ue_context_p = NULL;
+  imsi_t                                  imsi = {0};
+
+  while ((queued_p = TAILQ_FIRST (&soak.queue))) {
+    TAILQ_REMOVE (&soak.queue, queued_p, entries);
+    message_p = queued_p->message_p;
+    free (queued_p);
+    switch (message_p->ittiMsgHeader.messageId) {
+    case NAS_UE_RECORD_REQ:
+      // NAS completes the record, MME_APP evicts the UE
+      fill_nas (NAS_UE_RECORD_REQ (message_p).record);
+      NAS_UE_RECORD_REQ (message_p).is_valid = true;
+      mme_app_eviction_handle_ue_record_rsp (&NAS_UE_RECORD_REQ (message_p));
+      break;
+
+    case NAS_UE_RESTORE_IND:
+      free (NAS_UE_RESTORE_IND (message_p).record);
+      break;
+
+    case NAS_IMPLICIT_DETACH_UE_IND:
+      // NAS keeps the GUTI with the IMSI, MME_APP removes the context
+      if ((ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, NAS_IMPLICIT_DETACH_UE_IND (message_p).ue_id))) {
+        imsi64_to_imsi (ue_context_p->imsi, &imsi);
+        mme_app_cold_store_save (&ue_context_p->guti, &imsi);
+        mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p);
+        soak.nb_detached++;
+      }
+      break;
+
+    default:
+      // NAS_UE_EVICT_IND, the EMM contexts are not kept here
+      break;
+    }
+    free (message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void attach (const imsi64_t imsi64)
+{
+  ue_context_t                           *ue_context_p = slab_pool_alloc (mme_app_desc.mme_ue_contexts.ue_context_pool);
+
+  if (!ue_context_p) {
+    fprintf (stderr, "UE context pool exhausted\n");
+    exit (EXIT_FAILURE);
+  }
+  ue_context_p->mme_ue_s1ap_id = soak.next_ue_id++;
+  ue_context_p->imsi = imsi64;
+  ue_context_p->subscription = slab_pool_alloc (mme_app_desc.mme_ue_contexts.subscription_pool);
+  ue_context_p->subscription->apn_profile.nb_apns = 1;
+  ue_context_p->subscription->subscribed_ambr.br_ul = 50000000;
+  ue_context_p->subscription->subscribed_ambr.br_dl = 100000000;
+  ue_context_p->guti.gummei.mme_code = 1;
+  ue_context_p->guti.gummei.mme_gid = 4;
+  ue_context_p->guti.m_tmsi = soak.next_m_tmsi;
+  ue_context_p->is_guti_set = true;
+  soak.next_m_tmsi += 1 << MME_APP_SHARD_TAG_BITS;
+  ue_context_p->mme_s11_teid = soak.next_teid;
+  ue_context_p->sgw_s11_teid = soak.next_teid;
+  soak.next_teid += 1 << MME_APP_SHARD_TAG_BITS;
+  ue_context_p->default_bearer_id = DEFAULT_EBI;
+  ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  ue_context_p->mobile_reachability_timer.sec = (T3412_MIN + 4) * 60;
+  ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
+  ue_context_p->implicit_detach_timer.sec = (T3412_MIN + 4) * 60;
+  insert_ue_context (ue_context_p);
+  // attach complete, then S1 release: ECM-IDLE
+  ue_context_p->ecm_state = ECM_IDLE;
+  mme_app_eviction_ue_idle (ue_context_p);
+}
+
+static void reattach (void)
+{
+  imsi_t                                  imsi = {0};
+  imsi64_t                                imsi64 = 0;
+  ue_context_t                           *ue_context_p = NULL;
+  const left_ue_t                        *left_ue = &soak.left_ues[(soak.nb_reattaches * 7919) % LEFT_UES];
+
+  soak.nb_reattaches++;
+  if ((ue_context_p = mme_app_eviction_restore_ue_by_guti (&left_ue->guti))) {
+    // SERVICE REQUEST, then S1 release
+    soak.nb_restored++;
+    mme_app_eviction_ue_forget (ue_context_p);
+    mme_app_eviction_ue_idle (ue_context_p);
+  } else if (mme_app_cold_store_take (&left_ue->guti, &imsi)) {
+    soak.nb_cold_hits++;
+    memcpy (&imsi64, imsi.u.value, sizeof (imsi64));
+    if (!mme_ue_context_exists_imsi (&mme_app_desc.mme_ue_contexts, imsi64)) {
+      attach (imsi64);
+    }
+  } else if ((left_ue->imsi) && (!mme_ue_context_exists_imsi (&mme_app_desc.mme_ue_contexts, left_ue->imsi))) {
+    // IDENTITY REQUEST
+    soak.nb_identified++;
+    attach (left_ue->imsi);
+  }
+  dispatch ();
+}
+
+static void report (const uint64_t nb_attaches, const uint64_t start_ns)
+{
+  mme_app_cold_store_stats_t              cold_stats = {0};
+  slab_pool_stats_t                       ue_stats = {0};
+  slab_pool_stats_t                       subscription_stats = {0};
+
+  slab_pool_get_stats (mme_app_desc.mme_ue_contexts.ue_context_pool, &ue_stats);
+  slab_pool_get_stats (mme_app_desc.mme_ue_contexts.subscription_pool, &subscription_stats);
+  mme_app_cold_store_get_stats (&cold_stats);
+  printf ("%9" PRIu64 " IMSIs  %8.1f s  resident %8" PRIu64 " UEs %7.1f MB  cold store %7" PRIu64 "  back %6" PRIu64 ": restored %6" PRIu64
+      " cold %6" PRIu64 " identified %6" PRIu64 "  detached %8" PRIu64 "  RSS %7.1f MB\n",
+      nb_attaches, (double)(now_ns () - start_ns) / 1e9, ue_stats.nb_in_use,
+      (double)(ue_stats.nb_in_use * ue_stats.object_size + subscription_stats.nb_in_use * subscription_stats.object_size) / (1024 * 1024),
+      cold_stats.nb_records, soak.nb_reattaches, soak.nb_restored, soak.nb_cold_hits, soak.nb_identified, soak.nb_detached,
+      (double)rss_bytes () / (1024 * 1024));
+}
+
+int main (int argc, char *argv[])
+{
+  uint64_t                                budget_mb = (argc > 1) ? strtoull (argv[1], NULL, 10) : 256;
+  uint64_t                                nb_imsis = (argc > 2) ? strtoull (argv[2], NULL, 10) : NB_OF_IMSIS;
+  uint32_t                                cold_store_size = (argc > 3) ? strtoul (argv[3], NULL, 10) : 1000 * 1000;
+  uint32_t                                max_evicted_ues = (argc > 4) ? strtoul (argv[4], NULL, 10) : 0;
+  mme_ue_context_t                       *contexts = &mme_app_desc.mme_ue_contexts;
+  bstring                                 str = NULL;
+  uint64_t                                start_ns = 0;
+
+  memset (&soak, 0, sizeof (soak));
+  TAILQ_INIT (&soak.queue);
+  soak.next_ue_id = 1;
+  soak.next_m_tmsi = 1 << MME_APP_SHARD_TAG_BITS;
+  soak.next_teid = 1 << MME_APP_SHARD_TAG_BITS;
+  mme_config.max_ues = (uint32_t)nb_imsis;
+  mme_config.nas_config.t3412_min = T3412_MIN;
+  mme_config.eviction_config.memory_budget_mb = (uint32_t)budget_mb;
+  mme_config.eviction_config.period_ms = 1000;
+  mme_config.eviction_config.batch = 2 * ATTACHES_PER_PERIOD;
+  mme_config.eviction_config.cold_store_size = cold_store_size;
+  mme_config.eviction_config.max_evicted_ues = max_evicted_ues;
+  contexts->mme_ue_s1ap_id_ue_context_htbl = hashtable_ts_create (mme_config.max_ues, NULL, no_free, NULL);
+  contexts->imsi_ue_context_htbl = hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, NULL);
+  contexts->tun11_ue_context_htbl = hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, NULL);
+  contexts->guti_ue_context_htbl = obj_hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, hash_free_int_func, NULL);
+  contexts->ue_context_pool = slab_pool_create (sizeof (ue_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  contexts->subscription_pool = slab_pool_create (sizeof (ue_subscription_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  if ((!contexts->ue_context_pool) || (!contexts->subscription_pool) || (mme_app_eviction_init () < 0)) {
+    fprintf (stderr, "Allocation failed\n");
+    return EXIT_FAILURE;
+  }
+  printf ("budget %" PRIu64 " MB, %" PRIu64 " IMSIs, cold store %u records, max evicted UEs %u, %zu + %zu bytes per idle UE\n",
+      budget_mb, nb_imsis, cold_store_size, max_evicted_ues, sizeof (ue_context_t), sizeof (ue_subscription_t));
+  start_ns = now_ns ();
+  for (uint64_t i = 1; i <= nb_imsis; i++) {
+    attach (208930000000000ULL + i);
+    if ((0 == i % REATTACH_EVERY) && (soak.nb_left)) {
+      reattach ();
+    }
+    if (0 == i % ATTACHES_PER_PERIOD) {
+      mme_app_eviction_timer_expiry ();
+      dispatch ();
+    }
+    if (0 == i % REPORT_EVERY) {
+      report (i, start_ns);
+    }
+  }
+  if (nb_imsis % REPORT_EVERY) {
+    report (nb_imsis, start_ns);
+  }
+  str = bfromcstr ("");
+  mme_app_eviction_report (str);
+  printf ("%s", bdata (str));
+  bdestroy (str);
+  mme_app_eviction_exit ();
+  return EXIT_SUCCESS;
+}
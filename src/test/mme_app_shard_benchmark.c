@@ -0,0 +1,157 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Scaling of the UE handling with the number of MME_APP/NAS shards: each
+ * shard thread attaches and detaches its own UEs (ids c * nb_workers + shard as
+ * mme_app_shard_new_ue_id gives them), inserting and removing them in the
+ * shared mme_ue_s1ap_id and IMSI tables, the only state the shards share, and
+ * looking the UE up on each of the NAS_MESSAGES_PER_UE messages of its attach.
+ * The attach rate is printed for 1..max shards with the speedup over one
+ * shard, it can not exceed the number of CPUs of the host.
+ *
+ * usage: mme_app_shard_benchmark [max shards (8)] [attaches per shard (1000000)]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "hashtable.h"
+#include "mme_app_shard.h"
+
+#define TABLE_SIZE                  (1 << 20)
+#define UES_PER_SHARD               4096            // attached at once by a shard
+#define NAS_MESSAGES_PER_UE         8
+
+typedef struct shard_arg_s {
+  int                                     shard;
+  uint64_t                                nb_attaches;
+  pthread_t                               thread;
+} shard_arg_t;
+
+static hash_table_ts_t                 *mme_ue_s1ap_id_htbl = NULL;
+static hash_table_ts_t                 *imsi_htbl = NULL;
+static pthread_barrier_t                start_barrier;
+
+int                                     mme_app_nb_workers = 1;
+__thread int                            mme_app_current_shard = 0;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// the tables do not own the contexts
+static void no_free (void **data)
+{
+  *data = NULL;
+}
+
+static void *shard_loop (void *arg)
+{
+  shard_arg_t                            *shard_arg = (shard_arg_t *)arg;
+  mme_ue_s1ap_id_t                        ue_ids[UES_PER_SHARD] = {0};
+  mme_ue_s1ap_id_t                        next = 1;
+  void                                   *data = NULL;
+  uint64_t                                checksum = 0;
+
+  mme_app_current_shard = shard_arg->shard;
+  pthread_barrier_wait (&start_barrier);
+  for (uint64_t i = 0; i < shard_arg->nb_attaches; i++) {
+    mme_ue_s1ap_id_t                     *ue_id = &ue_ids[i % UES_PER_SHARD];
+
+    if (*ue_id) {
+      // detach of the UE attached UES_PER_SHARD attaches ago
+      hashtable_ts_remove (imsi_htbl, 208930000000000ULL + *ue_id, &data);
+      hashtable_ts_remove (mme_ue_s1ap_id_htbl, *ue_id, &data);
+    }
+    *ue_id = next++ * (mme_ue_s1ap_id_t)mme_app_nb_workers + (mme_ue_s1ap_id_t)mme_app_current_shard;
+    hashtable_ts_insert (mme_ue_s1ap_id_htbl, *ue_id, (void *)(uintptr_t)*ue_id);
+    hashtable_ts_insert (imsi_htbl, 208930000000000ULL + *ue_id, (void *)(uintptr_t)*ue_id);
+    for (int m = 0; m < NAS_MESSAGES_PER_UE; m++) {
+      if (HASH_TABLE_OK == hashtable_ts_get (mme_ue_s1ap_id_htbl, *ue_id, &data)) {
+        checksum += mme_app_is_ue_id_in_current_shard ((mme_ue_s1ap_id_t)(uintptr_t)data);
+      }
+    }
+  }
+  if (checksum != shard_arg->nb_attaches * NAS_MESSAGES_PER_UE) {
+    fprintf (stderr, "shard %d: %" PRIu64 " UE lookups failed\n", shard_arg->shard, shard_arg->nb_attaches * NAS_MESSAGES_PER_UE - checksum);
+  }
+  return NULL;
+}
+
+static double run (const int nb, const uint64_t nb_attaches)
+{
+  shard_arg_t                             args[MME_APP_MAX_WORKERS];
+  uint64_t                                start_ns = 0;
+
+  mme_app_nb_workers = nb;
+  mme_ue_s1ap_id_htbl = hashtable_ts_create (TABLE_SIZE, NULL, no_free, NULL);
+  imsi_htbl = hashtable_ts_create (TABLE_SIZE, NULL, hash_free_int_func, NULL);
+  pthread_barrier_init (&start_barrier, NULL, nb + 1);
+  for (int s = 0; s < nb; s++) {
+    args[s].shard = s;
+    args[s].nb_attaches = nb_attaches;
+    pthread_create (&args[s].thread, NULL, shard_loop, &args[s]);
+  }
+  pthread_barrier_wait (&start_barrier);
+  start_ns = now_ns ();
+  for (int s = 0; s < nb; s++) {
+    pthread_join (args[s].thread, NULL);
+  }
+  start_ns = now_ns () - start_ns;
+  pthread_barrier_destroy (&start_barrier);
+  hashtable_ts_destroy (mme_ue_s1ap_id_htbl);
+  hashtable_ts_destroy (imsi_htbl);
+  return (double)(nb_attaches * nb) * 1e9 / (double)start_ns;
+}
+
+int main (int argc, char *argv[])
+{
+  int                                     max_shards = (argc > 1) ? atoi (argv[1]) : 8;
+  uint64_t                                nb_attaches = (argc > 2) ? strtoull (argv[2], NULL, 10) : 1000 * 1000;
+  double                                  one_shard = 0;
+
+  if ((max_shards < 1) || (max_shards > MME_APP_MAX_WORKERS)) {
+    fprintf (stderr, "max shards must be in [1..%d]\n", MME_APP_MAX_WORKERS);
+    return EXIT_FAILURE;
+  }
+  // warm up of the allocator and of the caches
+  run (1, nb_attaches);
+  printf ("%ld CPUs, %" PRIu64 " attaches per shard, %d NAS messages per attach\n", sysconf (_SC_NPROCESSORS_ONLN), nb_attaches, NAS_MESSAGES_PER_UE);
+  for (int nb = 1; nb <= max_shards; nb *= 2) {
+    double                                rate = run (nb, nb_attaches);
+
+    if (1 == nb) {
+      one_shard = rate;
+    }
+    printf ("%2d shards  %10.0f attaches/s  speedup %5.2f\n", nb, rate, rate / one_shard);
+  }
+  return EXIT_SUCCESS;
+}
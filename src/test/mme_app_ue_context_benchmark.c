@@ -0,0 +1,234 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Hot path of the MME_APP on a large attached population: lookup of the UE
+ * context by mme_ue_s1ap_id, ECM/timer/eNB id state transitions and read of
+ * the default bearer, then a sweep of the whole population reading the ECM
+ * state and a timer (as the periodic procedures do), with the previous flat
+ * ue_context_t layout (copied below as legacy_ue_context_t) and with the
+ * hot/cold split layout.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "hashtable.h"
+#include "slab_pool.h"
+#include "mme_app_ue_context.h"
+
+#define NB_OF_UES         (1000 * 1000)
+#define NB_OF_OPERATIONS  (10 * 1000 * 1000)
+
+// ue_context_t layout before the hot/cold split
+typedef struct legacy_ue_context_s {
+  imsi64_t               imsi;
+  unsigned               imsi_auth:1;
+  enb_s1ap_id_key_t      enb_s1ap_id_key;
+  enb_ue_s1ap_id_t       enb_ue_s1ap_id:24;
+  mme_ue_s1ap_id_t       mme_ue_s1ap_id;
+  sctp_assoc_id_t        sctp_assoc_id_key;
+  enum s1cause           ue_context_rel_cause;
+  unsigned               subscription_known:1;
+  uint8_t                msisdn[MSISDN_LENGTH+1];
+  uint8_t                msisdn_length;
+  bool                   pending_handover;
+  mm_state_t             mm_state;
+  ecm_state_t            ecm_state;
+  bool                   is_guti_set;
+  guti_t                 guti;
+  me_identity_t          me_identity;
+  ecgi_t                 e_utran_cgi;
+  time_t                 cell_age;
+  network_access_mode_t  access_mode;
+  apn_config_profile_t   apn_profile;
+  ard_t                  access_restriction_data;
+  subscriber_status_t    sub_status;
+  ambr_t                 subscribed_ambr;
+  ambr_t                 used_ambr;
+  rau_tau_timer_t        rau_tau_timer;
+  uint8_t               *ue_radio_capabilities;
+  int                    ue_radio_cap_length;
+  teid_t                 mme_s11_teid;
+  teid_t                 sgw_s11_teid;
+  PAA_t                  paa;
+  char                   pending_pdn_connectivity_req_imsi[16];
+  uint8_t                pending_pdn_connectivity_req_imsi_length;
+  bstring                pending_pdn_connectivity_req_apn;
+  bstring                pending_pdn_connectivity_req_pdn_addr;
+  int                    pending_pdn_connectivity_req_pti;
+  unsigned               pending_pdn_connectivity_req_ue_id;
+  network_qos_t          pending_pdn_connectivity_req_qos;
+  protocol_configuration_options_t   pending_pdn_connectivity_req_pco;
+  void                  *pending_pdn_connectivity_req_proc_data;
+  int                    pending_pdn_connectivity_req_request_type;
+  ebi_t                  default_bearer_id;
+  bearer_context_t       eps_bearers[BEARERS_PER_UE];
+  struct mme_app_timer_t mobile_reachability_timer;
+  struct mme_app_timer_t implicit_detach_timer;
+  struct mme_app_timer_t initial_context_setup_rsp_timer;
+  struct mme_app_timer_t path_switch_req_timer;
+} legacy_ue_context_t;
+
+static mme_ue_s1ap_id_t                 operation_ids[NB_OF_OPERATIONS];
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint32_t next_random (uint32_t * const state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+// the table does not own the contexts
+static void no_free (void **data)
+{
+  *data = NULL;
+}
+
+static bool legacy_sweep (const hash_key_t key, void * const element, void *parameter, void **result)
+{
+  legacy_ue_context_t                    *ue_context_p = (legacy_ue_context_t *)element;
+
+  if ((ue_context_p->ecm_state == ECM_IDLE) && (ue_context_p->mobile_reachability_timer.id != MME_APP_TIMER_INACTIVE_ID)) {
+    (*(uint64_t *)parameter)++;
+  }
+  return false;
+}
+
+static bool split_sweep (const hash_key_t key, void * const element, void *parameter, void **result)
+{
+  ue_context_t                           *ue_context_p = (ue_context_t *)element;
+
+  if ((ue_context_p->ecm_state == ECM_IDLE) && (ue_context_p->mobile_reachability_timer.id != MME_APP_TIMER_INACTIVE_ID)) {
+    (*(uint64_t *)parameter)++;
+  }
+  return false;
+}
+
+static void report (const char *title, const uint64_t elapsed_ns, const uint64_t checksum, const uint64_t sweep_ns,
+                    const uint64_t nb_idle, const double bytes_per_ue)
+{
+  printf ("%-16s %7.1f ns/op  sweep %6.1f ns/UE  %8.1f bytes/UE  (checksum %" PRIu64 ", idle %" PRIu64 ")\n", title,
+      (double)elapsed_ns / NB_OF_OPERATIONS, (double)sweep_ns / NB_OF_UES, bytes_per_ue, checksum, nb_idle);
+}
+
+static void run_legacy (void)
+{
+  hash_table_ts_t                        *htbl = hashtable_ts_create (NB_OF_UES, NULL, no_free, NULL);
+  legacy_ue_context_t                    *ue_context_p = NULL;
+  uint64_t                                checksum = 0;
+  uint64_t                                nb_idle = 0;
+  uint64_t                                start = 0;
+  uint64_t                                elapsed = 0;
+
+  for (mme_ue_s1ap_id_t id = 1; id <= NB_OF_UES; id++) {
+    ue_context_p = calloc (1, sizeof (legacy_ue_context_t));
+    ue_context_p->mme_ue_s1ap_id = id;
+    ue_context_p->default_bearer_id = 5;
+    ue_context_p->eps_bearers[5].s_gw_teid = id;
+    hashtable_ts_insert (htbl, id, ue_context_p);
+  }
+  start = now_ns ();
+  for (int i = 0; i < NB_OF_OPERATIONS; i++) {
+    hashtable_ts_get (htbl, operation_ids[i], (void **)&ue_context_p);
+    ue_context_p->ecm_state = (ue_context_p->ecm_state == ECM_IDLE) ? ECM_CONNECTED : ECM_IDLE;
+    ue_context_p->enb_ue_s1ap_id = i;
+    ue_context_p->mobile_reachability_timer.id = (ue_context_p->ecm_state == ECM_IDLE) ? i : MME_APP_TIMER_INACTIVE_ID;
+    ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
+    checksum += ue_context_p->eps_bearers[ue_context_p->default_bearer_id].s_gw_teid;
+  }
+  elapsed = now_ns () - start;
+  start = now_ns ();
+  hashtable_ts_apply_callback_on_elements (htbl, legacy_sweep, &nb_idle, NULL);
+  report ("legacy layout", elapsed, checksum, now_ns () - start, nb_idle, sizeof (legacy_ue_context_t));
+  for (mme_ue_s1ap_id_t id = 1; id <= NB_OF_UES; id++) {
+    hashtable_ts_remove (htbl, id, (void **)&ue_context_p);
+    free (ue_context_p);
+  }
+  hashtable_ts_destroy (htbl);
+}
+
+static void run_split (void)
+{
+  hash_table_ts_t                        *htbl = hashtable_ts_create (NB_OF_UES, NULL, no_free, NULL);
+  slab_pool_t                            *ue_context_pool = slab_pool_create (sizeof (ue_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  slab_pool_t                            *subscription_pool = slab_pool_create (sizeof (ue_subscription_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  ue_context_t                           *ue_context_p = NULL;
+  uint64_t                                checksum = 0;
+  uint64_t                                nb_idle = 0;
+  uint64_t                                start = 0;
+  uint64_t                                elapsed = 0;
+
+  // an attached UE owns its subscription data and its default bearer (embedded), no pending PDN connectivity request
+  for (mme_ue_s1ap_id_t id = 1; id <= NB_OF_UES; id++) {
+    ue_context_p = slab_pool_alloc (ue_context_pool);
+    ue_context_p->mme_ue_s1ap_id = id;
+    ue_context_p->default_bearer_id = 5;
+    ue_context_p->subscription = slab_pool_alloc (subscription_pool);
+    ue_context_p->eps_bearers[5] = &ue_context_p->embedded_bearer;
+    ue_context_p->eps_bearers[5]->s_gw_teid = id;
+    hashtable_ts_insert (htbl, id, ue_context_p);
+  }
+  start = now_ns ();
+  for (int i = 0; i < NB_OF_OPERATIONS; i++) {
+    hashtable_ts_get (htbl, operation_ids[i], (void **)&ue_context_p);
+    ue_context_p->ecm_state = (ue_context_p->ecm_state == ECM_IDLE) ? ECM_CONNECTED : ECM_IDLE;
+    ue_context_p->enb_ue_s1ap_id = i;
+    ue_context_p->mobile_reachability_timer.id = (ue_context_p->ecm_state == ECM_IDLE) ? i : MME_APP_TIMER_INACTIVE_ID;
+    ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
+    checksum += ue_context_p->eps_bearers[ue_context_p->default_bearer_id]->s_gw_teid;
+  }
+  elapsed = now_ns () - start;
+  start = now_ns ();
+  hashtable_ts_apply_callback_on_elements (htbl, split_sweep, &nb_idle, NULL);
+  report ("hot/cold split", elapsed, checksum, now_ns () - start, nb_idle,
+      (double)(sizeof (ue_context_t) + sizeof (ue_subscription_t)));
+  printf ("%-16s ue_context_t %zu bytes (%zu cache lines), ue_subscription_t %zu, bearer_context_t %zu, pending_pdn_connectivity_req_t %zu\n",
+      "", sizeof (ue_context_t), sizeof (ue_context_t) / SLAB_POOL_OBJECT_ALIGN, sizeof (ue_subscription_t),
+      sizeof (bearer_context_t), sizeof (pending_pdn_connectivity_req_t));
+  hashtable_ts_destroy (htbl);
+  slab_pool_destroy (subscription_pool);
+  slab_pool_destroy (ue_context_pool);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t                                rnd = 2463534242U;
+
+  for (int i = 0; i < NB_OF_OPERATIONS; i++) {
+    operation_ids[i] = 1 + (next_random (&rnd) % NB_OF_UES);
+  }
+  run_legacy ();
+  run_split ();
+  return 0;
+}
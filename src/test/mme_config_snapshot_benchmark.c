@@ -0,0 +1,233 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Lookups of the served configuration done by the tasks (S1 SETUP supported
+ * TAs, GUTI from S-TMSI, MNC length of the S6A visited PLMN) by 1 to
+ * MAX_READERS threads, while a writer reloads the configuration every
+ * RELOAD_PERIOD_US. The previous access (mme_config read lock, linear scan
+ * of the served TAIs and GUMMEIs) is compared with the snapshot of
+ * mme_config_snapshot.h (no lock, precomputed sets).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common_defs.h"
+#include "mme_config.h"
+#include "mme_config_snapshot.h"
+
+#define NB_OF_LOOKUPS       (4 * 1000 * 1000)     // per reader thread
+#define MAX_READERS         8
+#define NB_TAIS             16
+#define RELOAD_PERIOD_US    1000
+
+static uint32_t                         nb_of_lookups = NB_OF_LOOKUPS;
+static mme_config_t                     config = {0};
+static pthread_rwlock_t                 config_rw_lock = PTHREAD_RWLOCK_INITIALIZER;
+static volatile bool                    readers_running = false;
+static uint64_t                         nb_reloads = 0;
+
+typedef struct reader_s {
+  pthread_t                             thread;
+  bool                                  snapshot;
+  uint64_t                              checksum;
+} reader_t;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void config_build (void)
+{
+  config.max_enbs = 1000;
+  config.relative_capacity = 10;
+  config.served_tai.nb_tai = NB_TAIS;
+  config.served_tai.plmn_mcc = calloc (NB_TAIS, sizeof (uint16_t));
+  config.served_tai.plmn_mnc = calloc (NB_TAIS, sizeof (uint16_t));
+  config.served_tai.plmn_mnc_len = calloc (NB_TAIS, sizeof (uint16_t));
+  config.served_tai.tac = calloc (NB_TAIS, sizeof (uint16_t));
+  for (int i = 0; i < NB_TAIS; i++) {
+    config.served_tai.plmn_mcc[i] = 208;
+    config.served_tai.plmn_mnc[i] = (i < NB_TAIS / 2) ? 93 : 95;
+    config.served_tai.plmn_mnc_len[i] = 2;
+    config.served_tai.tac[i] = 1 + i;
+  }
+  config.gummei.nb = MAX_GUMMEI;
+  for (int i = 0; i < MAX_GUMMEI; i++) {
+    config.gummei.gummei[i].plmn.mcc_digit1 = 2;
+    config.gummei.gummei[i].plmn.mcc_digit2 = 0;
+    config.gummei.gummei[i].plmn.mcc_digit3 = 8;
+    config.gummei.gummei[i].plmn.mnc_digit1 = 9;
+    config.gummei.gummei[i].plmn.mnc_digit2 = 3 + 2 * i;
+    config.gummei.gummei[i].plmn.mnc_digit3 = 0xf;
+    config.gummei.gummei[i].mme_gid = 4;
+    config.gummei.gummei[i].mme_code = 1 + i;
+  }
+}
+
+// the scans done under the read lock before the snapshot
+static uint64_t legacy_lookup (const uint32_t n)
+{
+  const uint16_t                          tac = 1 + (n % (NB_TAIS + 2));
+  const uint16_t                          mnc = (n & 1) ? 93 : 95;
+  const plmn_t                            plmn = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8, .mnc_digit1 = 9, .mnc_digit2 = mnc % 10, .mnc_digit3 = 0xf};
+  const mme_code_t                        mme_code = 1 + (n % 3);
+  uint64_t                                found = 0;
+
+  pthread_rwlock_rdlock (&config_rw_lock);
+  for (int i = 0; i < config.served_tai.nb_tai; i++) {
+    if (config.served_tai.tac[i] == tac) {
+      found++;
+      break;
+    }
+  }
+  for (int i = 0; i < config.served_tai.nb_tai; i++) {
+    if ((config.served_tai.plmn_mcc[i] == 208) && (config.served_tai.plmn_mnc[i] == mnc) && (config.served_tai.plmn_mnc_len[i] == 2)) {
+      found++;
+      break;
+    }
+  }
+  for (int i = 0; i < config.gummei.nb; i++) {
+    if ((plmn.mcc_digit2 == config.gummei.gummei[i].plmn.mcc_digit2) &&
+        (plmn.mcc_digit1 == config.gummei.gummei[i].plmn.mcc_digit1) &&
+        (plmn.mnc_digit3 == config.gummei.gummei[i].plmn.mnc_digit3) &&
+        (plmn.mcc_digit3 == config.gummei.gummei[i].plmn.mcc_digit3) &&
+        (plmn.mnc_digit2 == config.gummei.gummei[i].plmn.mnc_digit2) &&
+        (plmn.mnc_digit1 == config.gummei.gummei[i].plmn.mnc_digit1) &&
+        (mme_code == config.gummei.gummei[i].mme_code)) {
+      found += config.gummei.gummei[i].mme_gid;
+      break;
+    }
+  }
+  found += config.relative_capacity;
+  pthread_rwlock_unlock (&config_rw_lock);
+  return found;
+}
+
+static uint64_t snapshot_lookup (const uint32_t n)
+{
+  const uint16_t                          tac = 1 + (n % (NB_TAIS + 2));
+  const uint16_t                          mnc = (n & 1) ? 93 : 95;
+  const plmn_t                            plmn = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8, .mnc_digit1 = 9, .mnc_digit2 = mnc % 10, .mnc_digit3 = 0xf};
+  const mme_code_t                        mme_code = 1 + (n % 3);
+  const mme_config_snapshot_t            *snapshot = mme_config_snapshot_acquire ();
+  const gummei_t                         *gummei = NULL;
+  uint64_t                                found = 0;
+
+  found += mme_config_snapshot_served_tac (snapshot, tac);
+  found += mme_config_snapshot_served_plmn (snapshot, 208, mnc, 2);
+  gummei = mme_config_snapshot_find_gummei (snapshot, &plmn, mme_code);
+  found += (gummei) ? gummei->mme_gid : 0;
+  found += snapshot->relative_capacity;
+  mme_config_snapshot_release ();
+  return found;
+}
+
+static void *reader_thread (void *arg)
+{
+  reader_t                               *reader = (reader_t *)arg;
+
+  for (uint32_t n = 0; n < nb_of_lookups; n++) {
+    reader->checksum += (reader->snapshot) ? snapshot_lookup (n) : legacy_lookup (n);
+  }
+  return NULL;
+}
+
+static void reload (const bool snapshot)
+{
+  if (snapshot) {
+    mme_config_snapshot_publish (&config);
+  } else {
+    pthread_rwlock_wrlock (&config_rw_lock);
+    config.relative_capacity = 10;
+    pthread_rwlock_unlock (&config_rw_lock);
+  }
+  nb_reloads++;
+}
+
+static void *writer_thread (void *arg)
+{
+  const bool                              snapshot = *(bool *)arg;
+
+  while (readers_running) {
+    usleep (RELOAD_PERIOD_US);
+    reload (snapshot);
+  }
+  return NULL;
+}
+
+static void run (const char * const title, const bool snapshot, const int nb_readers)
+{
+  reader_t                                readers[MAX_READERS];
+  pthread_t                               writer;
+  bool                                    writer_snapshot = snapshot;
+  uint64_t                                checksum = 0;
+  uint64_t                                start = 0;
+  uint64_t                                elapsed = 0;
+
+  memset (readers, 0, sizeof (readers));
+  nb_reloads = 0;
+  readers_running = true;
+  pthread_create (&writer, NULL, writer_thread, &writer_snapshot);
+  start = now_ns ();
+  for (int r = 0; r < nb_readers; r++) {
+    readers[r].snapshot = snapshot;
+    pthread_create (&readers[r].thread, NULL, reader_thread, &readers[r]);
+  }
+  for (int r = 0; r < nb_readers; r++) {
+    pthread_join (readers[r].thread, NULL);
+    checksum += readers[r].checksum;
+  }
+  elapsed = now_ns () - start;
+  readers_running = false;
+  pthread_join (writer, NULL);
+  printf ("%-8s %d readers %12.0f lookups/s  %6.1f ns per reader lookup  %6" PRIu64 " reloads  (checksum %" PRIu64 ")\n",
+      title, nb_readers, (double)nb_readers * nb_of_lookups * 1e9 / elapsed, (double)elapsed / nb_of_lookups, nb_reloads, checksum);
+}
+
+int main (int argc, char *argv[])
+{
+  if (argc > 1) {
+    nb_of_lookups = strtoul (argv[1], NULL, 10);
+  }
+  config_build ();
+  if (RETURNok != mme_config_snapshot_publish (&config)) {
+    return 1;
+  }
+  printf ("%" PRIu32 " lookups per reader, %d served TAIs, %d GUMMEIs, reload every %d us\n", nb_of_lookups, NB_TAIS, MAX_GUMMEI, RELOAD_PERIOD_US);
+  for (int nb_readers = 1; nb_readers <= MAX_READERS; nb_readers *= 2) {
+    run ("rwlock", false, nb_readers);
+    run ("snapshot", true, nb_readers);
+  }
+  mme_config_snapshot_exit ();
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Encoding, integrity protection (EIA2) and ciphering (EEA2) of 1M Attach
+ * Accept messages by a NAS thread, handed over to an S1AP thread which fills
+ * the NAS PDU IE and releases the buffer, as through ITTI:
+ *  - heap: the allocations of the former pipeline, a bstring from
+ *    bfromcstralloc, a scratch buffer for the plain message and the copy of
+ *    the NAS PDU into the OCTET STRING of S1AP,
+ *  - pooled: nas_buffer_alloc, encoded and protected in place, the NAS PDU
+ *    IE points to the buffer, nas_buffer_free.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "bstrlib.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.301.h"
+#include "nas_message.h"
+#include "nas_buffer.h"
+#include "secu_defs.h"
+
+#define NB_OF_MESSAGES    (1000 * 1000)
+#define ESM_CONTAINER_LENGTH   64         // Activate Default EPS Bearer Context Request, IPv4, one APN
+#define RING_SIZE         1024             // messages in flight between the NAS and S1AP threads
+
+/*
+ * Single producer single consumer ring, stands for the ITTI queue of S1AP
+ */
+static bstring                          ring[RING_SIZE];
+static volatile uint64_t                ring_head = 0;
+static volatile uint64_t                ring_tail = 0;
+static bool                             ring_pooled = false;
+static uint64_t                         checksum = 0;
+
+static void ring_push (bstring b)
+{
+  while (ring_tail - __atomic_load_n (&ring_head, __ATOMIC_ACQUIRE) >= RING_SIZE) {
+    sched_yield ();
+  }
+  ring[ring_tail % RING_SIZE] = b;
+  __atomic_store_n (&ring_tail, ring_tail + 1, __ATOMIC_RELEASE);
+}
+
+static void *s1ap_thread (void *unused)
+{
+  for (uint64_t i = 0; i < NB_OF_MESSAGES; i++) {
+    while (__atomic_load_n (&ring_tail, __ATOMIC_ACQUIRE) == ring_head) {
+      sched_yield ();
+    }
+    bstring                                 info = ring[ring_head % RING_SIZE];
+
+    __atomic_store_n (&ring_head, ring_head + 1, __ATOMIC_RELEASE);
+    if (ring_pooled) {
+      // the NAS PDU IE points to the buffer
+      checksum += info->data[info->slen - 1];
+      nas_buffer_free (&info);
+    } else {
+      unsigned char                          *nas_pdu = malloc (info->slen);
+
+      memcpy (nas_pdu, info->data, info->slen);
+      checksum += nas_pdu[info->slen - 1];
+      bdestroy (info);
+      free (nas_pdu);
+    }
+  }
+  return NULL;
+}
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void attach_accept_init (nas_message_t * const msg, bstring esm_container)
+{
+  attach_accept_msg                      *emm_msg = &msg->security_protected.plain.emm.attach_accept;
+
+  memset (msg, 0, sizeof (*msg));
+  msg->header.protocol_discriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  msg->header.security_header_type = SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED;
+  emm_msg->protocoldiscriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  emm_msg->securityheadertype = SECURITY_HEADER_TYPE_NOT_PROTECTED;
+  emm_msg->messagetype = ATTACH_ACCEPT;
+  emm_msg->epsattachresult = EPS_ATTACH_RESULT_EPS;
+  emm_msg->t3412value.unit = GPRS_TIMER_UNIT_60S;
+  emm_msg->t3412value.timervalue = 9;
+  emm_msg->tailist.typeoflist = TRACKING_AREA_IDENTITY_LIST_ONE_PLMN_NON_CONSECUTIVE_TACS;
+  emm_msg->tailist.numberofelements = 0;
+  emm_msg->tailist.mccdigit1[0] = 2;
+  emm_msg->tailist.mccdigit2[0] = 0;
+  emm_msg->tailist.mccdigit3[0] = 8;
+  emm_msg->tailist.mncdigit1[0] = 9;
+  emm_msg->tailist.mncdigit2[0] = 3;
+  emm_msg->tailist.mncdigit3[0] = 0x0F;
+  emm_msg->tailist.tac[0] = 1;
+  emm_msg->esmmessagecontainer = esm_container;
+  emm_msg->presencemask = ATTACH_ACCEPT_GUTI_PRESENT;
+  emm_msg->guti.guti.typeofidentity = EPS_MOBILE_IDENTITY_GUTI;
+  emm_msg->guti.guti.oddeven = EPS_MOBILE_IDENTITY_EVEN;
+  emm_msg->guti.guti.mmegroupid = 4;
+  emm_msg->guti.guti.mmecode = 1;
+  emm_msg->guti.guti.mccdigit1 = 2;
+  emm_msg->guti.guti.mccdigit2 = 0;
+  emm_msg->guti.guti.mccdigit3 = 8;
+  emm_msg->guti.guti.mncdigit1 = 9;
+  emm_msg->guti.guti.mncdigit2 = 3;
+  emm_msg->guti.guti.mncdigit3 = 0x0F;
+  msg->security_protected.header = msg->header;
+}
+
+static void run (const bool pooled)
+{
+  const size_t                            length = NAS_MESSAGE_SECURITY_HEADER_SIZE + 128 + ESM_CONTAINER_LENGTH;
+  nas_message_t                           msg;
+  emm_security_context_t                  security = {0};
+  bstring                                 esm_container = bfromcstralloc (ESM_CONTAINER_LENGTH, "");
+  pthread_t                               s1ap;
+  uint64_t                                start = 0;
+
+  for (int i = 0; i < ESM_CONTAINER_LENGTH; i++) {
+    esm_container->data[i] = (unsigned char)i;
+  }
+  esm_container->slen = ESM_CONTAINER_LENGTH;
+  for (int i = 0; i < AUTH_KNAS_ENC_SIZE; i++) {
+    security.knas_enc[i] = (uint8_t)(i * 3);
+    security.knas_int[i] = (uint8_t)(i * 5);
+  }
+  security.selected_algorithms.encryption = NAS_SECURITY_ALGORITHMS_EEA2;
+  security.selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA2;
+  attach_accept_init (&msg, esm_container);
+
+  ring_head = ring_tail = 0;
+  ring_pooled = pooled;
+  checksum = 0;
+  start = now_ns ();
+  pthread_create (&s1ap, NULL, s1ap_thread, NULL);
+  for (int i = 0; i < NB_OF_MESSAGES; i++) {
+    bstring                                 info = NULL;
+    int                                     bytes = 0;
+
+    msg.header.sequence_number = security.dl_count.seq_num;
+    msg.security_protected.header.sequence_number = security.dl_count.seq_num;
+    if (pooled) {
+      info = nas_buffer_alloc (length);
+      bytes = nas_message_encode (info->data, &msg, length, &security);
+    } else {
+      unsigned char                          *plain = calloc (1, length);
+
+      info = bfromcstralloc (length, "\0");
+      bytes = nas_message_encode (info->data, &msg, length, &security);
+      // the plain message was encoded in the scratch buffer then ciphered to info
+      memcpy (plain, info->data, (bytes > 0) ? bytes : 0);
+      free (plain);
+    }
+    if (bytes <= 0) {
+      fprintf (stderr, "Encoding failed (%d)\n", bytes);
+      exit (1);
+    }
+    info->slen = bytes;
+    ring_push (info);
+  }
+  pthread_join (s1ap, NULL);
+  const uint64_t                          elapsed = now_ns () - start;
+
+  fprintf (stdout, "%-8s %u Attach Accept: %8.3f s, %8.0f msg/s, %6" PRIu64 " ns/msg (checksum %" PRIu64 ")\n",
+      pooled ? "pooled" : "heap", NB_OF_MESSAGES, (double)elapsed / 1e9, (double)NB_OF_MESSAGES * 1e9 / (double)elapsed,
+      elapsed / NB_OF_MESSAGES, checksum);
+  bdestroy (esm_container);
+}
+
+int main (int argc, char *argv[])
+{
+  if (nas_buffer_init () < 0) {
+    return 1;
+  }
+  run (false);
+  run (true);
+  run (false);
+  run (true);
+  return 0;
+}
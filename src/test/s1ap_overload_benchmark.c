@@ -0,0 +1,223 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Attach storm against the overload control of s1ap_mme_overload.h: a
+ * simulated MME serving ATTACH_CAPACITY initial UE messages per second, fed
+ * at 5 times its capacity during STORM_MS by a population of UEs with the
+ * usual mix of RRC establishment causes. The controller samples the queue
+ * depth every CONTROL_PERIOD_MS with the same thresholds and hysteresis as the
+ * MME, the eNBs apply the overload action one period after the MME changed
+ * its level (OVERLOAD START on its way), the MME rejects the messages it still
+ * receives at a small cost.
+ *
+ * Reported per establishment cause, with and without the overload control:
+ * the number of initial UE messages served and rejected and the latency of
+ * the served ones (queueing + service).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "s1ap_mme_overload.h"
+
+#define ATTACH_CAPACITY         1000     // initial UE messages served per second
+#define REJECT_COST_PERCENT     5        // cost of a rejection by the MME, in percent of a served message
+#define OVERLOAD_FACTOR         5
+#define WARMUP_MS               (10 * 1000)
+#define STORM_MS                (30 * 1000)
+#define COOLDOWN_MS             (20 * 1000)
+#define NORMAL_LOAD_PERCENT     50
+#define CONTROL_PERIOD_MS       100
+#define QUEUE_DEPTH_THRESHOLD   200      // QUEUE_DEPTH of the OVERLOAD section
+#define MAX_QUEUED              (4 * 1024 * 1024)
+
+typedef struct cause_mix_s {
+  as_cause_t                              cause;
+  const char                             *name;
+  uint32_t                                per_mille;
+} cause_mix_t;
+
+static const cause_mix_t                cause_mix[] = {
+  {AS_CAUSE_EMERGENCY, "emergency",          10},
+  {AS_CAUSE_HIGH_PRIO, "high-priority",      40},
+  {AS_CAUSE_MT_ACCESS, "mt-access",          150},
+  {AS_CAUSE_MO_SIGNAL, "mo-signalling",      400},
+  {AS_CAUSE_MO_DATA,   "mo-data",            350},
+  {AS_CAUSE_V1020,     "delay-tolerant",     50},
+};
+
+#define NB_CAUSES               (sizeof (cause_mix) / sizeof (cause_mix[0]))
+
+typedef struct queued_s {
+  uint32_t                                arrival_ms;
+  uint8_t                                 cause_index;
+} queued_t;
+
+typedef struct class_stats_s {
+  uint32_t                               *latencies_ms;
+  uint32_t                                nb_served;
+  uint32_t                                nb_rejected_enb;
+  uint32_t                                nb_rejected_mme;
+} class_stats_t;
+
+static queued_t                        *queue = NULL;
+static class_stats_t                    stats[NB_CAUSES];
+static uint64_t                         rand_state = 88172645463325252ULL;
+
+static inline uint32_t xorshift (void)
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return (uint32_t)rand_state;
+}
+
+static int random_cause (void)
+{
+  uint32_t                                draw = xorshift () % 1000;
+
+  for (int i = 0; i < NB_CAUSES; i++) {
+    if (draw < cause_mix[i].per_mille) {
+      return i;
+    }
+    draw -= cause_mix[i].per_mille;
+  }
+  return NB_CAUSES - 1;
+}
+
+static int compare_u32 (const void *a, const void *b)
+{
+  const uint32_t                          x = *(const uint32_t *)a;
+  const uint32_t                          y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static uint32_t percentile (const class_stats_t * const s, const uint32_t per_cent)
+{
+  if (0 == s->nb_served) {
+    return 0;
+  }
+  return s->latencies_ms[((uint64_t)(s->nb_served - 1) * per_cent) / 100];
+}
+
+static void run (const bool overload_control)
+{
+  const uint32_t                          duration_ms = WARMUP_MS + STORM_MS + COOLDOWN_MS;
+  uint32_t                                head = 0,
+                                          tail = 0;
+  uint32_t                                arrivals_milli = 0;     // arrivals in thousandth of message
+  int32_t                                 work_milli = 0;         // service budget in thousandth of message
+  s1ap_overload_level_t                   mme_level = S1AP_OVERLOAD_NONE;
+  s1ap_overload_level_t                   enb_level = S1AP_OVERLOAD_NONE;
+  uint32_t                                max_queued = 0;
+  uint32_t                                level_changes = 0;
+
+  memset (stats, 0, sizeof (stats));
+  for (int i = 0; i < NB_CAUSES; i++) {
+    stats[i].latencies_ms = calloc (duration_ms * OVERLOAD_FACTOR * ATTACH_CAPACITY / 1000, sizeof (uint32_t));
+  }
+  rand_state = 88172645463325252ULL;
+
+  for (uint32_t now_ms = 0; now_ms < duration_ms; now_ms++) {
+    const bool                              storm = (now_ms >= WARMUP_MS) && (now_ms < WARMUP_MS + STORM_MS);
+
+    if ((overload_control) && (0 == now_ms % CONTROL_PERIOD_MS)) {
+      const uint32_t                          load = ((tail - head) * 100) / QUEUE_DEPTH_THRESHOLD;
+      const s1ap_overload_level_t             level = s1ap_mme_overload_next_level (mme_level, load);
+
+      // the eNBs received the previous OVERLOAD START/STOP
+      enb_level = mme_level;
+      if (level != mme_level) {
+        level_changes++;
+      }
+      mme_level = level;
+    }
+    arrivals_milli += storm ? OVERLOAD_FACTOR * ATTACH_CAPACITY : (NORMAL_LOAD_PERCENT * ATTACH_CAPACITY) / 100;
+    while (arrivals_milli >= 1000) {
+      const int                               cause_index = random_cause ();
+
+      arrivals_milli -= 1000;
+      if (!s1ap_mme_overload_admit (enb_level, cause_mix[cause_index].cause)) {
+        stats[cause_index].nb_rejected_enb++;
+        continue;
+      }
+      if (!s1ap_mme_overload_admit (mme_level, cause_mix[cause_index].cause)) {
+        stats[cause_index].nb_rejected_mme++;
+        work_milli -= REJECT_COST_PERCENT * 10;
+        continue;
+      }
+      if (tail - head >= MAX_QUEUED) {
+        fprintf (stderr, "queue full\n");
+        exit (1);
+      }
+      queue[tail % MAX_QUEUED].arrival_ms = now_ms;
+      queue[tail % MAX_QUEUED].cause_index = cause_index;
+      tail++;
+    }
+    if (tail - head > max_queued) {
+      max_queued = tail - head;
+    }
+    work_milli += ATTACH_CAPACITY;
+    while ((work_milli >= 1000) && (head != tail)) {
+      const queued_t                         *q = &queue[head % MAX_QUEUED];
+      class_stats_t                          *s = &stats[q->cause_index];
+
+      s->latencies_ms[s->nb_served++] = now_ms + 1 - q->arrival_ms;
+      work_milli -= 1000;
+      head++;
+    }
+    if (head == tail) {
+      // an idle MME does not bank its capacity
+      work_milli = (work_milli > 1000) ? 1000 : work_milli;
+    }
+  }
+
+  fprintf (stdout, "\n%s overload control: max queue depth %u, %u level changes, %u messages never served\n",
+      overload_control ? "With" : "Without", max_queued, level_changes, tail - head);
+  fprintf (stdout, "%-16s %10s %14s %14s %10s %10s %10s\n", "cause", "served", "rejected(eNB)", "rejected(MME)", "p50(ms)", "p99(ms)", "max(ms)");
+  for (int i = 0; i < NB_CAUSES; i++) {
+    class_stats_t                          *s = &stats[i];
+
+    qsort (s->latencies_ms, s->nb_served, sizeof (uint32_t), compare_u32);
+    fprintf (stdout, "%-16s %10u %14u %14u %10u %10u %10u\n", cause_mix[i].name, s->nb_served, s->nb_rejected_enb, s->nb_rejected_mme,
+        percentile (s, 50), percentile (s, 99), s->nb_served ? s->latencies_ms[s->nb_served - 1] : 0);
+    free (s->latencies_ms);
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  queue = calloc (MAX_QUEUED, sizeof (queued_t));
+  if (!queue) {
+    return 1;
+  }
+  fprintf (stdout, "MME capacity %u initial UE/s, %ux overload during %u s, controller every %u ms, queue depth threshold %u\n",
+      ATTACH_CAPACITY, OVERLOAD_FACTOR, STORM_MS / 1000, CONTROL_PERIOD_MS, QUEUE_DEPTH_THRESHOLD);
+  run (false);
+  run (true);
+  free (queue);
+  return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Paging fan-out of s1ap_mme_tai_index.h: NB_ENBS eNBs spread over NB_TACS
+ * tracking areas (one eNB out of BORDER_ENB_RATIO also serves the next TAC),
+ * NB_UES idle UEs paged once in their last TAI then, without answer, in their
+ * TAI list of TAI_LIST_SIZE consecutive TACs. For every paging the eNBs
+ * serving the TAIs are selected and get a copy of the PAGING PDU, encoded once
+ * per paging (the ASN.1 encoding itself is not part of the benchmark).
+ *
+ * The TAI index is compared with a scan of the supported TAs of every eNB,
+ * reported are the pagings per second and the eNB messages per paging.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "common_types.h"
+#include "common_defs.h"
+#include "s1ap_mme_tai_index.h"
+
+#define NB_ENBS             5000
+#define NB_TACS             100
+#define BORDER_ENB_RATIO    10
+#define NB_OF_UES           (100 * 1000)
+#define TAI_LIST_SIZE       3
+#define PAGING_PDU_SIZE     48    // S-TMSI paging with a few TAIs
+
+typedef struct enb_s {
+  sctp_assoc_id_t                         assoc_id;
+  uint32_t                                nb_tais;
+  tai_t                                   tais[2];
+} enb_t;
+
+typedef struct paging_pdu_s {
+  uint8_t                                 buffer[PAGING_PDU_SIZE];
+  uint64_t                                nb_sent;
+  uint64_t                                checksum;
+} paging_pdu_t;
+
+static enb_t                            enbs[NB_ENBS];
+static uint32_t                         nb_of_ues = NB_OF_UES;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void set_tai (tai_t * const tai, const uint16_t tac)
+{
+  memset (tai, 0, sizeof (*tai));
+  tai->plmn.mcc_digit1 = 2;
+  tai->plmn.mcc_digit2 = 0;
+  tai->plmn.mcc_digit3 = 8;
+  tai->plmn.mnc_digit1 = 9;
+  tai->plmn.mnc_digit2 = 3;
+  tai->plmn.mnc_digit3 = 0xf;
+  tai->tac = tac;
+}
+
+// the copy of the encoded PDU given to SCTP for every eNB (blk2bstr)
+static void send_enb_cb (const sctp_assoc_id_t assoc_id, void *arg)
+{
+  paging_pdu_t                           *pdu = (paging_pdu_t *)arg;
+  uint8_t                                *copy = malloc (PAGING_PDU_SIZE);
+
+  memcpy (copy, pdu->buffer, PAGING_PDU_SIZE);
+  pdu->checksum += assoc_id + copy[assoc_id % PAGING_PDU_SIZE];
+  pdu->nb_sent++;
+  free (copy);
+}
+
+static uint32_t scan_lookup (const tai_t * const tais, const uint32_t nb_tais, paging_pdu_t * const pdu)
+{
+  uint32_t                                nb_enbs = 0;
+
+  for (int e = 0; e < NB_ENBS; e++) {
+    bool                                    found = false;
+
+    for (uint32_t t = 0; (t < enbs[e].nb_tais) && (!found); t++) {
+      for (uint32_t i = 0; (i < nb_tais) && (!found); i++) {
+        found = TAIS_ARE_EQUAL (enbs[e].tais[t], tais[i]);
+      }
+    }
+    if (found) {
+      send_enb_cb (enbs[e].assoc_id, pdu);
+      nb_enbs++;
+    }
+  }
+  return nb_enbs;
+}
+
+static void run (const char * const title, s1ap_tai_index_t * const index)
+{
+  paging_pdu_t                            pdu = {{0}};
+  tai_t                                   tais[TAI_LIST_SIZE];
+  uint64_t                                pagings = 0;
+  uint64_t                                start = 0;
+  uint64_t                                elapsed = 0;
+
+  for (int i = 0; i < PAGING_PDU_SIZE; i++) {
+    pdu.buffer[i] = (uint8_t)i;
+  }
+  srand (1);
+  start = now_ns ();
+  for (uint32_t ue = 0; ue < nb_of_ues; ue++) {
+    const uint16_t                          last_tac = 1 + (rand () % NB_TACS);
+
+    // first attempt in the last TAI
+    set_tai (&tais[0], last_tac);
+    if (index) {
+      s1ap_tai_index_lookup (index, tais, 1, send_enb_cb, &pdu);
+    } else {
+      scan_lookup (tais, 1, &pdu);
+    }
+    // no answer, the TAI list around the last TAI
+    for (int i = 0; i < TAI_LIST_SIZE; i++) {
+      set_tai (&tais[i], 1 + ((last_tac - 1 + NB_TACS - TAI_LIST_SIZE / 2 + i) % NB_TACS));
+    }
+    if (index) {
+      s1ap_tai_index_lookup (index, tais, TAI_LIST_SIZE, send_enb_cb, &pdu);
+    } else {
+      scan_lookup (tais, TAI_LIST_SIZE, &pdu);
+    }
+    pagings += 2;
+  }
+  elapsed = now_ns () - start;
+  printf ("%-6s %10.0f pagings/s  %6.1f eNB messages/paging  %8.2f us/paging  (checksum %" PRIu64 ")\n",
+      title, pagings * 1e9 / elapsed, (double)pdu.nb_sent / pagings, elapsed / 1e3 / pagings, pdu.checksum);
+}
+
+int main (int argc, char *argv[])
+{
+  s1ap_tai_index_t                       *index = s1ap_tai_index_create (NB_ENBS);
+  uint64_t                                start = 0;
+
+  if (argc > 1) {
+    nb_of_ues = strtoul (argv[1], NULL, 10);
+  }
+  if (!index) {
+    return 1;
+  }
+  start = now_ns ();
+  for (int e = 0; e < NB_ENBS; e++) {
+    const uint16_t                          tac = 1 + (e % NB_TACS);
+
+    enbs[e].assoc_id = e + 1;
+    enbs[e].nb_tais = 1;
+    set_tai (&enbs[e].tais[0], tac);
+    if (0 == (e % BORDER_ENB_RATIO)) {
+      set_tai (&enbs[e].tais[enbs[e].nb_tais++], 1 + (tac % NB_TACS));
+    }
+    if (RETURNok != s1ap_tai_index_add_enb (index, enbs[e].assoc_id, enbs[e].tais, enbs[e].nb_tais)) {
+      return 1;
+    }
+  }
+  printf ("%d eNBs over %d TACs indexed in %.1f ms, %" PRIu32 " idle UEs paged in their last TAI then in %d TAIs\n",
+      NB_ENBS, NB_TACS, (now_ns () - start) / 1e6, nb_of_ues, TAI_LIST_SIZE);
+  run ("index", index);
+  run ("scan", NULL);
+  s1ap_tai_index_destroy (index);
+  return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S6a routing of the MME to two mme_stub_hss on the loopback. PHASE_REQUESTS
+ * Authentication Information requests are balanced by least outstanding
+ * requests between the two peers, then the second HSS is killed while
+ * PHASE_REQUESTS more are in flight: every request must be answered, by the
+ * first HSS once the second one is seen closed.
+ *
+ *   s6a_multi_peer_test <mme_stub_hss> <directory of s6a_multi_peer_test_fd.conf and stubs/>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "common_defs.h"
+#include "mme_config.h"
+#include "mme_config_snapshot.h"
+#include "s6a_defs.h"
+#include "s6a_template.h"
+#include "s6a_router.h"
+
+#define PHASE_REQUESTS      (5 * 1000)
+#define WINDOW              64
+#define REQUEST_TIMEOUT_MS  2000
+#define REALM               "ridux.local"
+#define PEER_TIMEOUT_S      10
+#define PHASE_TIMEOUT_S     30
+
+s6a_fd_cnf_t                            s6a_fd_cnf;
+
+static const char * const               hss_host_names[] = {"hss.s6a", "hss2.s6a"};
+static const char * const               hss_fd_configs[] = {"stubs/stub_hss_fd.conf", "stubs/stub_hss2_fd.conf"};
+static pid_t                            hss_pids[2] = {0};
+static mme_config_t                     config = {0};
+static const plmn_t                     visited_plmn = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8, .mnc_digit1 = 9, .mnc_digit2 = 3, .mnc_digit3 = 0xf};
+static pthread_mutex_t                  count_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t                         nb_sent[2] = {0};
+static uint64_t                         nb_answers = 0;
+static uint64_t                         nb_failed = 0;
+static volatile bool                    checking = true;
+
+static void config_build (void)
+{
+  config.realm = bfromcstr (REALM);
+  config.served_tai.nb_tai = 1;
+  config.served_tai.plmn_mcc = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mnc = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mnc_len = calloc (1, sizeof (uint16_t));
+  config.served_tai.tac = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mcc[0] = 208;
+  config.served_tai.plmn_mnc[0] = 93;
+  config.served_tai.plmn_mnc_len[0] = 2;
+  config.served_tai.tac[0] = 1;
+  config.gummei.nb = 1;
+  config.gummei.gummei[0].plmn = visited_plmn;
+  config.s6a_config.nb_hss = 2;
+  for (int p = 0; p < 2; p++) {
+    config.s6a_config.hss[p].host_name = bfromcstr (hss_host_names[p]);
+    config.s6a_config.hss[p].weight = 1;
+  }
+  config.s6a_config.weighted_routing = false;
+  config.s6a_config.inflight_window = WINDOW;
+  config.s6a_config.queue_size = 2 * PHASE_REQUESTS;
+  config.s6a_config.request_timeout_ms = REQUEST_TIMEOUT_MS;
+}
+
+static int add_u32 (struct avp * const parent, struct dict_object * const model, const uint32_t u32)
+{
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp));
+  value.u32 = u32;
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (parent, MSG_BRW_LAST_CHILD, avp));
+  return 0;
+}
+
+static int air_build (const s6a_request_params_t * const params, s6a_request_template_t * const template_p, struct msg ** msg_pP)
+{
+  struct msg                             *msg = NULL;
+  struct avp                             *avp = NULL;
+  const int                               p = biseqcstr (template_p->destination_host, hss_host_names[0]) ? 0 : 1;
+
+  CHECK_FCT (s6a_request_template_new (template_p, s6a_fd_cnf.dataobj_s6a_air, params->air.imsi, &msg));
+  CHECK_FCT (s6a_request_template_add_visited_plmn (template_p, msg, &params->air.visited_plmn));
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info, 0, &avp));
+  CHECK_FCT (add_u32 (avp, s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors, 1));
+  CHECK_FCT (add_u32 (avp, s6a_fd_cnf.dataobj_s6a_immediate_response_pref, 0));
+  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  pthread_mutex_lock (&count_mutex);
+  nb_sent[p]++;
+  pthread_mutex_unlock (&count_mutex);
+  *msg_pP = msg;
+  return 0;
+}
+
+static int air_answer (struct msg ** msg, struct avp * paramavp, struct session * sess, void * opaque, enum disp_action * act)
+{
+  pthread_mutex_lock (&count_mutex);
+  nb_answers++;
+  pthread_mutex_unlock (&count_mutex);
+  return 0;
+}
+
+static void air_failed (const s6a_request_params_t * const params)
+{
+  pthread_mutex_lock (&count_mutex);
+  nb_failed++;
+  pthread_mutex_unlock (&count_mutex);
+}
+
+// the periodic check of the S6A task
+static void *check_thread (void *args)
+{
+  while (checking) {
+    s6a_router_check_peers ();
+    usleep (100 * 1000);
+  }
+  return NULL;
+}
+
+static int dict_search (const char * const name, struct dict_object **object)
+{
+  return fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME_ALL_VENDORS, (void *)name, object, ENOENT);
+}
+
+static int fd_init_dict_objs (void)
+{
+  vendor_id_t                             vendor_3gpp = VENDOR_3GPP;
+  application_id_t                        app_s6a = APP_S6A;
+
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_VENDOR, VENDOR_BY_ID, (void *)&vendor_3gpp, &s6a_fd_cnf.dataobj_s6a_vendor, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_APPLICATION, APPLICATION_BY_ID, (void *)&app_s6a, &s6a_fd_cnf.dataobj_s6a_app, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Authentication-Information-Request", &s6a_fd_cnf.dataobj_s6a_air, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Destination-Host", &s6a_fd_cnf.dataobj_s6a_destination_host, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Destination-Realm", &s6a_fd_cnf.dataobj_s6a_destination_realm, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "User-Name", &s6a_fd_cnf.dataobj_s6a_user_name, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Session-Id", &s6a_fd_cnf.dataobj_s6a_session_id, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Auth-Session-State", &s6a_fd_cnf.dataobj_s6a_auth_session_state, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Result-Code", &s6a_fd_cnf.dataobj_s6a_result_code, ENOENT));
+  CHECK_FCT (dict_search ("Visited-PLMN-Id", &s6a_fd_cnf.dataobj_s6a_visited_plmn_id));
+  CHECK_FCT (dict_search ("Requested-EUTRAN-Authentication-Info", &s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info));
+  CHECK_FCT (dict_search ("Number-Of-Requested-Vectors", &s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors));
+  CHECK_FCT (dict_search ("Immediate-Response-Preferred", &s6a_fd_cnf.dataobj_s6a_immediate_response_pref));
+  CHECK_FCT (fd_disp_app_support (s6a_fd_cnf.dataobj_s6a_app, s6a_fd_cnf.dataobj_s6a_vendor, 1, 0));
+  return 0;
+}
+
+static pid_t hss_start (const char * const hss, const char * const directory, const char * const fd_config)
+{
+  pid_t                                   pid = fork ();
+
+  if (0 == pid) {
+    bstring                                 path = bformat ("%s/%s", directory, fd_config);
+
+    // a few ms of latency, so that requests are in flight when the HSS is killed
+    execl (hss, hss, "-f", bdata (path), "-l", "5", (char *)NULL);
+    _exit (127);
+  }
+  return pid;
+}
+
+static void hss_stop_all (void)
+{
+  for (int p = 0; p < 2; p++) {
+    if (0 < hss_pids[p]) {
+      kill (hss_pids[p], SIGKILL);
+      waitpid (hss_pids[p], NULL, 0);
+      hss_pids[p] = 0;
+    }
+  }
+}
+
+static void submit (const uint32_t first, const uint32_t nb)
+{
+  s6a_request_params_t                    params;
+
+  memset (&params, 0, sizeof (params));
+  params.air.nb_of_vectors = 1;
+  params.air.visited_plmn = visited_plmn;
+  for (uint32_t n = first; n < first + nb; n++) {
+    snprintf (params.air.imsi, sizeof (params.air.imsi), "20893%010" PRIu32, n);
+    s6a_router_submit (S6A_REQUEST_AIR, &params);
+  }
+}
+
+// until nb requests were answered or failed
+static int wait_done (const uint64_t nb)
+{
+  uint64_t                                done = 0;
+
+  for (int t = 0; t < PHASE_TIMEOUT_S * 10; t++) {
+    pthread_mutex_lock (&count_mutex);
+    done = nb_answers + nb_failed;
+    pthread_mutex_unlock (&count_mutex);
+    if (done >= nb) {
+      return 0;
+    }
+    usleep (100 * 1000);
+  }
+  return -1;
+}
+
+static int run (void)
+{
+  uint64_t                                sent[2] = {0};
+  bstring                                 metrics = NULL;
+
+  // balancing
+  submit (0, PHASE_REQUESTS);
+  if (wait_done (PHASE_REQUESTS)) {
+    fprintf (stderr, "Balancing: %" PRIu64 " answers and %" PRIu64 " failures of %u requests\n", nb_answers, nb_failed, PHASE_REQUESTS);
+    return -1;
+  }
+  printf ("Balancing: %" PRIu64 " / %" PRIu64 " requests sent to %s / %s\n", nb_sent[0], nb_sent[1], hss_host_names[0], hss_host_names[1]);
+  if ((nb_failed) || (nb_sent[0] < PHASE_REQUESTS / 4) || (nb_sent[1] < PHASE_REQUESTS / 4)) {
+    fprintf (stderr, "Requests not balanced between the peers\n");
+    return -1;
+  }
+  // fail over, the second HSS is killed with requests in flight
+  submit (PHASE_REQUESTS, PHASE_REQUESTS);
+  wait_done (PHASE_REQUESTS + PHASE_REQUESTS / 10);
+  kill (hss_pids[1], SIGKILL);
+  waitpid (hss_pids[1], NULL, 0);
+  hss_pids[1] = 0;
+  if (wait_done (2 * PHASE_REQUESTS)) {
+    fprintf (stderr, "Fail over: %" PRIu64 " answers and %" PRIu64 " failures of %u requests\n", nb_answers, nb_failed, 2 * PHASE_REQUESTS);
+    return -1;
+  }
+  printf ("Fail over: %" PRIu64 " answers, %" PRIu64 " failures\n", nb_answers, nb_failed);
+  if (nb_failed) {
+    fprintf (stderr, "Requests failed while a peer was left\n");
+    return -1;
+  }
+  // only the first HSS once the second one is seen closed
+  sleep (1);
+  pthread_mutex_lock (&count_mutex);
+  sent[0] = nb_sent[0];
+  sent[1] = nb_sent[1];
+  pthread_mutex_unlock (&count_mutex);
+  submit (2 * PHASE_REQUESTS, PHASE_REQUESTS);
+  if ((wait_done (3 * PHASE_REQUESTS)) || (nb_failed) || (nb_sent[1] != sent[1]) || (nb_sent[0] - sent[0] != PHASE_REQUESTS)) {
+    fprintf (stderr, "After fail over: %" PRIu64 " / %" PRIu64 " requests sent, %" PRIu64 " failures\n", nb_sent[0] - sent[0], nb_sent[1] - sent[1], nb_failed);
+    return -1;
+  }
+  metrics = bfromcstr ("");
+  s6a_router_dump_prometheus (metrics);
+  printf ("%s", bdata (metrics));
+  bdestroy (metrics);
+  return 0;
+}
+
+int main (int argc, char *argv[])
+{
+  const s6a_request_handlers_t            handlers[S6A_REQUEST_TYPE_MAX] = {
+    [S6A_REQUEST_AIR] = {air_build, air_answer, air_failed},
+  };
+  pthread_t                               checker;
+  bstring                                 fd_config = NULL;
+  int                                     rc = 1;
+
+  if (argc < 3) {
+    fprintf (stderr, "Usage: %s <mme_stub_hss> <configuration directory>\n", argv[0]);
+    return 1;
+  }
+  for (int p = 0; p < 2; p++) {
+    hss_pids[p] = hss_start (argv[1], argv[2], hss_fd_configs[p]);
+  }
+  config_build ();
+  mme_config_snapshot_publish (&config);
+  fd_config = bformat ("%s/s6a_multi_peer_test_fd.conf", argv[2]);
+  if (fd_core_initialize () || fd_core_parseconf (bdata (fd_config)) || fd_core_start () || fd_core_waitstartcomplete () || fd_init_dict_objs ()) {
+    fprintf (stderr, "freeDiameter start failed\n");
+    hss_stop_all ();
+    return 1;
+  }
+  bdestroy (fd_config);
+  if ((s6a_router_init (&config, handlers)) || (s6a_router_set_origin (fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len))) {
+    fprintf (stderr, "S6a router init failed\n");
+    hss_stop_all ();
+    return 1;
+  }
+  for (int s = 0; (s < PEER_TIMEOUT_S) && (2 != s6a_router_check_peers ()); s++) {
+    sleep (1);
+  }
+  if (2 != s6a_router_check_peers ()) {
+    fprintf (stderr, "HSS peers not connected, is %s runnable?\n", argv[1]);
+  } else {
+    pthread_create (&checker, NULL, check_thread, NULL);
+    rc = run () ? 1 : 0;
+    checking = false;
+    pthread_join (checker, NULL);
+  }
+  hss_stop_all ();
+  fd_core_shutdown ();
+  fd_core_wait_shutdown_complete ();
+  s6a_router_exit ();
+  mme_config_snapshot_exit ();
+  printf ("%s\n", rc ? "FAILED" : "PASSED");
+  return rc;
+}
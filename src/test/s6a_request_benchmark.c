@@ -0,0 +1,319 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S6a request generation of the MME against mme_stub_hss on the loopback:
+ * NB_OF_REQUESTS Update Location then Authentication Information requests,
+ * WINDOW of them in flight. The previous generation (every AVP built per
+ * request, Destination-Host concatenated, session created with fd_sess_new,
+ * MNC length looked up) is compared with the per peer templates of
+ * s6a_template.h. The time spent building the requests is reported apart
+ * from the request rate, that also includes the stub HSS.
+ *
+ *   mme_stub_hss -f stubs/stub_hss_fd.conf &
+ *   s6a_request_benchmark s6a_request_benchmark_fd.conf [requests]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common_defs.h"
+#include "conversions.h"
+#include "mme_config.h"
+#include "mme_config_snapshot.h"
+#include "s6a_defs.h"
+#include "s6a_template.h"
+
+#define NB_OF_REQUESTS      (100 * 1000)
+#define WINDOW              256
+#define HSS_HOST_NAME       "hss.s6a"
+#define REALM               "ridux.local"
+#define PEER_TIMEOUT_S      10
+
+s6a_fd_cnf_t                            s6a_fd_cnf;
+
+static uint32_t                         nb_of_requests = NB_OF_REQUESTS;
+static mme_config_t                     config = {0};
+static const plmn_t                     visited_plmn = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8, .mnc_digit1 = 9, .mnc_digit2 = 3, .mnc_digit3 = 0xf};
+static bstring                          hss_host_name = NULL;
+static bstring                          realm = NULL;
+static pthread_mutex_t                  window_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   window_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t                         in_flight = 0;
+static uint64_t                         nb_answers = 0;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void config_build (void)
+{
+  config.max_enbs = 1000;
+  config.relative_capacity = 10;
+  config.served_tai.nb_tai = 1;
+  config.served_tai.plmn_mcc = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mnc = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mnc_len = calloc (1, sizeof (uint16_t));
+  config.served_tai.tac = calloc (1, sizeof (uint16_t));
+  config.served_tai.plmn_mcc[0] = 208;
+  config.served_tai.plmn_mnc[0] = 93;
+  config.served_tai.plmn_mnc_len[0] = 2;
+  config.served_tai.tac[0] = 1;
+  config.gummei.nb = 1;
+  config.gummei.gummei[0].plmn = visited_plmn;
+  config.gummei.gummei[0].mme_gid = 4;
+  config.gummei.gummei[0].mme_code = 1;
+}
+
+static int add_os (struct msg * const msg, struct dict_object * const model, const uint8_t * const data, const size_t length)
+{
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp));
+  value.os.data = (uint8_t *)data;
+  value.os.len = length;
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  return 0;
+}
+
+static int add_u32 (struct avp * const parent, struct dict_object * const model, const uint32_t u32)
+{
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp));
+  value.u32 = u32;
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (parent, MSG_BRW_LAST_CHILD, avp));
+  return 0;
+}
+
+// the common AVPs as built before the templates
+static int legacy_new (struct dict_object * const command, const char * const imsi, struct msg ** msg_pP)
+{
+  struct msg                             *msg = NULL;
+  struct avp                             *avp = NULL;
+  struct session                         *sess = NULL;
+  union avp_value                         value;
+  os0_t                                   sid;
+  size_t                                  sidlen;
+  bstring                                 host = bstrcpy (hss_host_name);
+
+  CHECK_FCT (fd_msg_new (command, 0, &msg));
+  CHECK_FCT (fd_sess_new (&sess, fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, (os0_t) "apps6a", 6));
+  CHECK_FCT (fd_sess_getsid (sess, &sid, &sidlen));
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_session_id, 0, &avp));
+  value.os.data = sid;
+  value.os.len = sidlen;
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_FIRST_CHILD, avp));
+  CHECK_FCT (add_u32 ((struct avp *)msg, s6a_fd_cnf.dataobj_s6a_auth_session_state, 1));
+  CHECK_FCT (fd_msg_add_origin (msg, 0));
+  bconchar (host, '.');
+  bconcat (host, realm);
+  CHECK_FCT (add_os (msg, s6a_fd_cnf.dataobj_s6a_destination_host, (uint8_t *)bdata (host), blength (host)));
+  bdestroy (host);
+  CHECK_FCT (add_os (msg, s6a_fd_cnf.dataobj_s6a_destination_realm, (uint8_t *)bdata (realm), blength (realm)));
+  CHECK_FCT (add_os (msg, s6a_fd_cnf.dataobj_s6a_user_name, (const uint8_t *)imsi, strlen (imsi)));
+  *msg_pP = msg;
+  return 0;
+}
+
+static int legacy_add_visited_plmn (struct msg * const msg, const plmn_t * const plmn)
+{
+  const mme_config_snapshot_t            *snapshot = mme_config_snapshot_acquire ();
+  uint8_t                                 tbcd[3];
+
+  PLMN_T_TO_TBCD ((*plmn), tbcd, mme_config_snapshot_mnc_length (snapshot, 100 * plmn->mcc_digit1 + 10 * plmn->mcc_digit2 + plmn->mcc_digit3,
+                                                                  10 * plmn->mnc_digit1 + plmn->mnc_digit2,
+                                                                  100 * plmn->mnc_digit1 + 10 * plmn->mnc_digit2 + plmn->mnc_digit3));
+  mme_config_snapshot_release ();
+  return add_os (msg, s6a_fd_cnf.dataobj_s6a_visited_plmn_id, tbcd, sizeof (tbcd));
+}
+
+static int build_request (s6a_request_template_t * const template_p, const bool ulr, const uint32_t n, struct msg ** msg_pP)
+{
+  struct dict_object                     *command = ulr ? s6a_fd_cnf.dataobj_s6a_ulr : s6a_fd_cnf.dataobj_s6a_air;
+  struct msg                             *msg = NULL;
+  struct avp                             *avp = NULL;
+  char                                    imsi[16];
+
+  snprintf (imsi, sizeof (imsi), "20893%010" PRIu32, n);
+  if (template_p) {
+    CHECK_FCT (s6a_request_template_new (template_p, command, imsi, &msg));
+    CHECK_FCT (s6a_request_template_add_visited_plmn (template_p, msg, &visited_plmn));
+  } else {
+    CHECK_FCT (legacy_new (command, imsi, &msg));
+    CHECK_FCT (legacy_add_visited_plmn (msg, &visited_plmn));
+  }
+  if (ulr) {
+    CHECK_FCT (add_u32 ((struct avp *)msg, s6a_fd_cnf.dataobj_s6a_rat_type, RAT_EUTRAN));
+    CHECK_FCT (add_u32 ((struct avp *)msg, s6a_fd_cnf.dataobj_s6a_ulr_flags, ULR_S6A_S6D_INDICATOR | ULR_INITIAL_ATTACH_IND));
+  } else {
+    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info, 0, &avp));
+    CHECK_FCT (add_u32 (avp, s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors, 1));
+    CHECK_FCT (add_u32 (avp, s6a_fd_cnf.dataobj_s6a_immediate_response_pref, 0));
+    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  }
+  *msg_pP = msg;
+  return 0;
+}
+
+static void answer_cb (void *data, struct msg **msg)
+{
+  fd_msg_free (*msg);
+  *msg = NULL;
+  pthread_mutex_lock (&window_mutex);
+  nb_answers++;
+  in_flight--;
+  pthread_cond_signal (&window_cond);
+  pthread_mutex_unlock (&window_mutex);
+}
+
+static void run (const char * const title, s6a_request_template_t * const template_p, const bool ulr)
+{
+  struct msg                             *msg = NULL;
+  uint64_t                                build_ns = 0;
+  uint64_t                                start = now_ns ();
+  uint64_t                                t = 0;
+  uint64_t                                answers = 0;
+
+  pthread_mutex_lock (&window_mutex);
+  answers = nb_answers;
+  pthread_mutex_unlock (&window_mutex);
+  for (uint32_t n = 0; n < nb_of_requests; n++) {
+    pthread_mutex_lock (&window_mutex);
+    while (in_flight >= WINDOW) {
+      pthread_cond_wait (&window_cond, &window_mutex);
+    }
+    in_flight++;
+    pthread_mutex_unlock (&window_mutex);
+    t = now_ns ();
+    if (build_request (template_p, ulr, n, &msg)) {
+      exit (1);
+    }
+    build_ns += now_ns () - t;
+    if (fd_msg_send (&msg, answer_cb, NULL)) {
+      exit (1);
+    }
+  }
+  pthread_mutex_lock (&window_mutex);
+  while (in_flight) {
+    pthread_cond_wait (&window_cond, &window_mutex);
+  }
+  answers = nb_answers - answers;
+  pthread_mutex_unlock (&window_mutex);
+  printf ("%-8s %s build %7.0f ns/request  %9.0f requests/s  (answers %" PRIu64 ")\n",
+      title, ulr ? "ULR" : "AIR", (double)build_ns / nb_of_requests, nb_of_requests * 1e9 / (now_ns () - start), answers);
+}
+
+static int dict_search (const char * const name, struct dict_object **object)
+{
+  return fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME_ALL_VENDORS, (void *)name, object, ENOENT);
+}
+
+static int fd_init_dict_objs (void)
+{
+  vendor_id_t                             vendor_3gpp = VENDOR_3GPP;
+  application_id_t                        app_s6a = APP_S6A;
+
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_VENDOR, VENDOR_BY_ID, (void *)&vendor_3gpp, &s6a_fd_cnf.dataobj_s6a_vendor, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_APPLICATION, APPLICATION_BY_ID, (void *)&app_s6a, &s6a_fd_cnf.dataobj_s6a_app, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Authentication-Information-Request", &s6a_fd_cnf.dataobj_s6a_air, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Update-Location-Request", &s6a_fd_cnf.dataobj_s6a_ulr, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Destination-Host", &s6a_fd_cnf.dataobj_s6a_destination_host, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Destination-Realm", &s6a_fd_cnf.dataobj_s6a_destination_realm, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "User-Name", &s6a_fd_cnf.dataobj_s6a_user_name, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Session-Id", &s6a_fd_cnf.dataobj_s6a_session_id, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Auth-Session-State", &s6a_fd_cnf.dataobj_s6a_auth_session_state, ENOENT));
+  CHECK_FCT (dict_search ("Visited-PLMN-Id", &s6a_fd_cnf.dataobj_s6a_visited_plmn_id));
+  CHECK_FCT (dict_search ("RAT-Type", &s6a_fd_cnf.dataobj_s6a_rat_type));
+  CHECK_FCT (dict_search ("ULR-Flags", &s6a_fd_cnf.dataobj_s6a_ulr_flags));
+  CHECK_FCT (dict_search ("Requested-EUTRAN-Authentication-Info", &s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info));
+  CHECK_FCT (dict_search ("Number-Of-Requested-Vectors", &s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors));
+  CHECK_FCT (dict_search ("Immediate-Response-Preferred", &s6a_fd_cnf.dataobj_s6a_immediate_response_pref));
+  CHECK_FCT (fd_disp_app_support (s6a_fd_cnf.dataobj_s6a_app, s6a_fd_cnf.dataobj_s6a_vendor, 1, 0));
+  return 0;
+}
+
+static int wait_peer (const_bstring destination_host)
+{
+  struct peer_hdr                        *peer = NULL;
+
+  for (int s = 0; s < PEER_TIMEOUT_S; s++) {
+    if ((0 == fd_peer_getbyid ((DiamId_t)bdata (destination_host), blength (destination_host), 0, &peer)) && peer
+        && (STATE_OPEN == fd_peer_get_state (peer))) {
+      return 0;
+    }
+    sleep (1);
+  }
+  return -1;
+}
+
+int main (int argc, char *argv[])
+{
+  s6a_request_template_t                 *template_p = NULL;
+  bstring                                 destination_host = NULL;
+
+  if (argc < 2) {
+    fprintf (stderr, "Usage: %s <freeDiameter configuration> [requests]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 2) {
+    nb_of_requests = strtoul (argv[2], NULL, 10);
+  }
+  config_build ();
+  mme_config_snapshot_publish (&config);
+  hss_host_name = bfromcstr (HSS_HOST_NAME);
+  realm = bfromcstr (REALM);
+  destination_host = bformat ("%s.%s", HSS_HOST_NAME, REALM);
+  if (fd_core_initialize () || fd_core_parseconf (argv[1]) || fd_core_start () || fd_core_waitstartcomplete () || fd_init_dict_objs ()) {
+    fprintf (stderr, "freeDiameter start failed\n");
+    return 1;
+  }
+  if (wait_peer (destination_host)) {
+    fprintf (stderr, "Peer %s not connected, is mme_stub_hss running?\n", bdata (destination_host));
+    return 1;
+  }
+  template_p = s6a_request_template_create (fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len, destination_host, realm);
+  printf ("%" PRIu32 " requests, %d in flight\n", nb_of_requests, WINDOW);
+  run ("legacy", NULL, true);
+  run ("template", template_p, true);
+  run ("legacy", NULL, false);
+  run ("template", template_p, false);
+  s6a_request_template_destroy (&template_p);
+  fd_core_shutdown ();
+  fd_core_wait_shutdown_complete ();
+  mme_config_snapshot_exit ();
+  return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Create Session / Delete Session storage path of the SGW on a large
+ * population: allocation of the S11 tunnel and of the session context, PDN
+ * connection and default bearer, insertion in the S11 TEID tables, lookup
+ * by TEID, then deletion of every session. The previous storage (a calloc'd
+ * context owning an APN obj_hashtable_ts and an EPS bearer hashtable_ts,
+ * global hashtable_ts keyed by TEID) is compared with the flat storage
+ * (pooled contexts with the default bearer embedded, id_index keyed by TEID).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hashtable.h"
+#include "obj_hashtable.h"
+#include "id_index.h"
+#include "slab_pool.h"
+#include "intertask_interface.h"
+#include "sgw_ie_defs.h"
+#include "3gpp_23.401.h"
+#include "sgw_context_manager.h"
+
+#define NB_OF_SESSIONS    (1000 * 1000)
+#define FIRST_TEID        1
+
+// a session context is about 5 KB (saved Create Session Request), the population can be lowered on small hosts
+static uint32_t                         nb_of_sessions = NB_OF_SESSIONS;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static size_t resident_bytes (void)
+{
+  unsigned long                           size = 0;
+  unsigned long                           resident = 0;
+  FILE                                   *fp = fopen ("/proc/self/statm", "r");
+
+  if (fp) {
+    if (fscanf (fp, "%lu %lu", &size, &resident) != 2) {
+      resident = 0;
+    }
+    fclose (fp);
+  }
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+static void report (const char *title, const uint64_t create_ns, const uint64_t lookup_ns, const uint64_t delete_ns,
+                    const size_t resident_delta, const uint64_t checksum)
+{
+  printf ("%-8s create %9.0f sessions/s  lookup %6.1f ns  delete %9.0f sessions/s  %8.1f bytes/session  (checksum %" PRIu64 ")\n",
+      title, nb_of_sessions * 1e9 / create_ns, (double)lookup_ns / nb_of_sessions, nb_of_sessions * 1e9 / delete_ns,
+      (double)resident_delta / nb_of_sessions, checksum);
+}
+
+// the session context before the flat storage, with its per session collections
+typedef struct legacy_session_s {
+  s_plus_p_gw_eps_bearer_context_information_t  context;
+  obj_hash_table_t                             *apns;
+  hash_table_ts_t                              *sgw_eps_bearers;
+} legacy_session_t;
+
+static void legacy_free_session (void **data)
+{
+  legacy_session_t                       *session_p = (legacy_session_t *)*data;
+
+  obj_hashtable_ts_destroy (session_p->apns);
+  hashtable_ts_destroy (session_p->sgw_eps_bearers);
+  free (session_p);
+  *data = NULL;
+}
+
+static void run_legacy (void)
+{
+  hash_table_ts_t                        *s11teid2mme = hashtable_ts_create (512, NULL, NULL, NULL);
+  hash_table_ts_t                        *sessions = hashtable_ts_create (512, NULL, legacy_free_session, NULL);
+  legacy_session_t                       *session_p = NULL;
+  mme_sgw_tunnel_t                       *tunnel_p = NULL;
+  sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
+  size_t                                  resident = resident_bytes ();
+  size_t                                  resident_delta = 0;
+  uint64_t                                checksum = 0;
+  uint64_t                                start = now_ns ();
+  uint64_t                                create_ns = 0;
+  uint64_t                                lookup_ns = 0;
+
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    tunnel_p = calloc (1, sizeof (mme_sgw_tunnel_t));
+    tunnel_p->local_teid = teid;
+    tunnel_p->remote_teid = teid;
+    hashtable_ts_insert (s11teid2mme, teid, tunnel_p);
+    session_p = calloc (1, sizeof (legacy_session_t));
+    session_p->apns = obj_hashtable_ts_create (32, NULL, NULL, NULL, NULL);
+    session_p->sgw_eps_bearers = hashtable_ts_create (12, NULL, NULL, NULL);
+    hashtable_ts_insert (sessions, teid, session_p);
+    eps_bearer_entry_p = calloc (1, sizeof (sgw_eps_bearer_entry_t));
+    eps_bearer_entry_p->eps_bearer_id = 5;
+    eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up = teid;
+    hashtable_ts_insert (session_p->sgw_eps_bearers, 5, eps_bearer_entry_p);
+  }
+  create_ns = now_ns () - start;
+  resident_delta = resident_bytes () - resident;
+  start = now_ns ();
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    hashtable_ts_get (sessions, teid, (void **)&session_p);
+    hashtable_ts_get (session_p->sgw_eps_bearers, 5, (void **)&eps_bearer_entry_p);
+    checksum += eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up;
+  }
+  lookup_ns = now_ns () - start;
+  start = now_ns ();
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    hashtable_ts_get (sessions, teid, (void **)&session_p);
+    hashtable_ts_free (session_p->sgw_eps_bearers, 5);
+    hashtable_ts_free (sessions, teid);
+    hashtable_ts_free (s11teid2mme, teid);
+  }
+  report ("legacy", create_ns, lookup_ns, now_ns () - start, resident_delta, checksum);
+  hashtable_ts_destroy (sessions);
+  hashtable_ts_destroy (s11teid2mme);
+}
+
+static void run_flat (void)
+{
+  id_index_t                             *s11teid2mme = id_index_create (NULL, NULL);
+  id_index_t                             *sessions = id_index_create (NULL, NULL);
+  slab_pool_t                            *session_pool = slab_pool_create (sizeof (s_plus_p_gw_eps_bearer_context_information_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  s_plus_p_gw_eps_bearer_context_information_t *session_p = NULL;
+  sgw_pdn_connection_t                   *pdn_connection_p = NULL;
+  mme_sgw_tunnel_t                       *tunnel_p = NULL;
+  sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
+  size_t                                  resident = resident_bytes ();
+  size_t                                  resident_delta = 0;
+  uint64_t                                checksum = 0;
+  uint64_t                                start = now_ns ();
+  uint64_t                                create_ns = 0;
+  uint64_t                                lookup_ns = 0;
+
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    tunnel_p = calloc (1, sizeof (mme_sgw_tunnel_t));
+    tunnel_p->local_teid = teid;
+    tunnel_p->remote_teid = teid;
+    id_index_insert (s11teid2mme, teid, tunnel_p);
+    session_p = slab_pool_alloc (session_pool);
+    id_index_insert (sessions, teid, session_p);
+    pdn_connection_p = &session_p->sgw_eps_bearer_context_information.pdn_connection;
+    eps_bearer_entry_p = &pdn_connection_p->embedded_bearer;
+    eps_bearer_entry_p->eps_bearer_id = 5;
+    eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up = teid;
+    pdn_connection_p->sgw_eps_bearers[5 - EPS_BEARER_IDENTITY_FIRST] = eps_bearer_entry_p;
+  }
+  create_ns = now_ns () - start;
+  resident_delta = resident_bytes () - resident;
+  start = now_ns ();
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    id_index_get (sessions, teid, (void **)&session_p);
+    checksum += session_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers[5 - EPS_BEARER_IDENTITY_FIRST]->s_gw_teid_S1u_S12_S4_up;
+  }
+  lookup_ns = now_ns () - start;
+  start = now_ns ();
+  for (teid_t teid = FIRST_TEID; teid < FIRST_TEID + nb_of_sessions; teid++) {
+    id_index_remove (sessions, teid, (void **)&session_p);
+    session_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers[5 - EPS_BEARER_IDENTITY_FIRST] = NULL;
+    slab_pool_free (session_pool, (void **)&session_p);
+    id_index_free (s11teid2mme, teid);
+  }
+  report ("flat", create_ns, lookup_ns, now_ns () - start, resident_delta, checksum);
+  printf ("%-8s s_plus_p_gw_eps_bearer_context_information_t %zu bytes, sgw_eps_bearer_entry_t %zu, TEID indexes %zu bytes\n",
+      "", sizeof (s_plus_p_gw_eps_bearer_context_information_t), sizeof (sgw_eps_bearer_entry_t),
+      id_index_memory_bytes (sessions) + id_index_memory_bytes (s11teid2mme));
+  id_index_destroy (sessions);
+  id_index_destroy (s11teid2mme);
+  slab_pool_destroy (session_pool);
+}
+
+int main (int argc, char *argv[])
+{
+  if (argc > 1) {
+    nb_of_sessions = strtoul (argv[1], NULL, 10);
+  }
+  printf ("%" PRIu32 " sessions\n", nb_of_sessions);
+  run_flat ();
+  // give the pages of the tunnels back, not to lower the resident delta of the next run
+  malloc_trim (0);
+  run_legacy ();
+  return 0;
+}
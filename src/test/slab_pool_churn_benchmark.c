@@ -0,0 +1,187 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Attach/detach churn of the UE contexts (ue_context_t, emm_data_context_t,
+ * S1AP ue_description_t) with calloc/free and with the slab pools: throughput
+ * and RSS growth. Each UE also owns a few variable size heap buffers, as the
+ * real contexts do (radio capabilities, ESM message, ...), which is what
+ * fragments the heap when the contexts themselves live on it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "slab_pool.h"
+#include "mme_app_ue_context.h"
+#include "emmData.h"
+#include "s1ap_mme.h"
+
+#define NB_OF_CYCLES      (10 * 1000 * 1000)
+#define NB_OF_UES         (100 * 1000)     // attached population
+#define NB_OF_REPORTS     10
+
+typedef struct churn_ue_s {
+  ue_context_t                           *ue_context;
+  emm_data_context_t                     *emm_context;
+  ue_description_t                       *ue_description;
+  void                                   *radio_capabilities;
+  void                                   *esm_msg;
+} churn_ue_t;
+
+static churn_ue_t                       ues[NB_OF_UES];
+static slab_pool_t                     *ue_context_pool = NULL;
+static slab_pool_t                     *emm_context_pool = NULL;
+static slab_pool_t                     *ue_description_pool = NULL;
+
+static inline uint64_t now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t rss_kib (void)
+{
+  FILE                                   *fp = fopen ("/proc/self/statm", "r");
+  unsigned long                           size = 0,
+                                          resident = 0;
+
+  if (fp) {
+    if (2 != fscanf (fp, "%lu %lu", &size, &resident)) {
+      resident = 0;
+    }
+    fclose (fp);
+  }
+  return (uint64_t)resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+static inline uint32_t next_random (uint32_t * const state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void attach (churn_ue_t * const ue, const bool use_pools, uint32_t * const rnd)
+{
+  if (use_pools) {
+    ue->ue_context = slab_pool_alloc (ue_context_pool);
+    ue->emm_context = slab_pool_alloc (emm_context_pool);
+    ue->ue_description = slab_pool_alloc (ue_description_pool);
+  } else {
+    ue->ue_context = calloc (1, sizeof (ue_context_t));
+    ue->emm_context = calloc (1, sizeof (emm_data_context_t));
+    ue->ue_description = calloc (1, sizeof (ue_description_t));
+  }
+  ue->radio_capabilities = malloc (64 + (next_random (rnd) % 4000));
+  ue->esm_msg = malloc (16 + (next_random (rnd) % 256));
+  // touch what a procedure touches
+  ue->ue_context->mme_ue_s1ap_id = next_random (rnd);
+  ue->ue_context->ue_radio_capabilities = ue->radio_capabilities;
+  ue->emm_context->ue_id = ue->ue_context->mme_ue_s1ap_id;
+  ue->ue_description->mme_ue_s1ap_id = ue->ue_context->mme_ue_s1ap_id;
+}
+
+static void detach (churn_ue_t * const ue, const bool use_pools)
+{
+  free (ue->radio_capabilities);
+  free (ue->esm_msg);
+  if (use_pools) {
+    slab_pool_free (ue_context_pool, (void **)&ue->ue_context);
+    slab_pool_free (emm_context_pool, (void **)&ue->emm_context);
+    slab_pool_free (ue_description_pool, (void **)&ue->ue_description);
+  } else {
+    free (ue->ue_context);
+    free (ue->emm_context);
+    free (ue->ue_description);
+  }
+  memset (ue, 0, sizeof (*ue));
+}
+
+static void run (const bool use_pools, const uint64_t nb_cycles)
+{
+  const char                             *title = (use_pools) ? "slab pools" : "calloc/free";
+  uint32_t                                rnd = 2463534242U;
+  uint64_t                                start = 0,
+                                          lap = 0;
+
+  if (use_pools) {
+    ue_context_pool = slab_pool_create (sizeof (ue_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+    emm_context_pool = slab_pool_create (sizeof (emm_data_context_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+    ue_description_pool = slab_pool_create (sizeof (ue_description_t), 0, UE_CONTEXT_POOL_HUGEPAGES, NULL);
+  }
+  printf ("%-12s RSS before attach: %8" PRIu64 " KiB\n", title, rss_kib ());
+  for (int i = 0; i < NB_OF_UES; i++) {
+    attach (&ues[i], use_pools, &rnd);
+  }
+  printf ("%-12s RSS %6d UEs:     %8" PRIu64 " KiB\n", title, NB_OF_UES, rss_kib ());
+  start = lap = now_ns ();
+  for (uint64_t c = 1; c <= nb_cycles; c++) {
+    churn_ue_t                             *ue = &ues[next_random (&rnd) % NB_OF_UES];
+
+    detach (ue, use_pools);
+    attach (ue, use_pools, &rnd);
+    if (0 == (c % (nb_cycles / NB_OF_REPORTS))) {
+      uint64_t                                now = now_ns ();
+
+      printf ("%-12s %9" PRIu64 " cycles: %7.1f ns/cycle, RSS %8" PRIu64 " KiB\n", title, c,
+          (double)(now - lap) / (nb_cycles / NB_OF_REPORTS), rss_kib ());
+      lap = now;
+    }
+  }
+  printf ("%-12s total: %.2f M cycles/s\n", title, (double)nb_cycles * 1000.0 / (now_ns () - start));
+  if (use_pools) {
+    bstring                                 stats = bfromcstr ("");
+
+    slab_pool_dump_stats (stats);
+    printf ("%s", bdata (stats));
+    bdestroy (stats);
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_cycles = (argc > 1) ? strtoull (argv[1], NULL, 0) : NB_OF_CYCLES;
+
+  if (nb_cycles < NB_OF_REPORTS) {
+    nb_cycles = NB_OF_REPORTS;
+  }
+  // each run in its own process, so that RSS figures do not mix
+  for (int use_pools = 0; use_pools < 2; use_pools++) {
+    pid_t                                   pid = fork ();
+
+    if (0 == pid) {
+      run (use_pools, nb_cycles);
+      fflush (stdout);
+      _exit (0);
+    }
+    waitpid (pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file stub_common.c
+  \brief Fault injection, delay queue and metrics shared by the stub HSS and
+  the stub SPGW.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common_defs.h"
+#include "stubs.h"
+
+volatile bool                           stub_running = true;
+
+static __thread uint64_t                random_state = 0;
+
+//------------------------------------------------------------------------------
+int stub_parse_latency (const char * const arg, stub_fault_config_t * const config)
+{
+  double                                  latency_ms = 0;
+  double                                  jitter_ms = 0;
+  int                                     n = 0;
+
+  n = sscanf (arg, "%lf:%lf", &latency_ms, &jitter_ms);
+  if ((n < 1) || (latency_ms < 0) || (jitter_ms < 0) || (latency_ms + jitter_ms > 60000)) {
+    return RETURNerror;
+  }
+  config->latency_us = (uint32_t)(latency_ms * 1000);
+  config->jitter_us = (uint32_t)(jitter_ms * 1000);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int stub_parse_percent (const char * const arg, uint32_t * const ppm)
+{
+  char                                   *end = NULL;
+  double                                  percent = strtod (arg, &end);
+
+  if ((end == arg) || (*end && strcmp (end, "%")) || (percent < 0) || (percent > 100)) {
+    return RETURNerror;
+  }
+  *ppm = (uint32_t)(percent * (STUB_PPM / 100));
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int stub_parse_hex (const char * const arg, uint8_t * const bytes, const int length)
+{
+  unsigned int                            byte = 0;
+
+  if (strlen (arg) != 2 * length) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < length; i++) {
+    if (sscanf (&arg[2 * i], "%2x", &byte) != 1) {
+      return RETURNerror;
+    }
+    bytes[i] = (uint8_t) byte;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void stub_register_message_metrics (const char * const stub, const char * const message, stub_message_metrics_t * const metrics)
+{
+  char                                    name[METRICS_NAME_MAX_LENGTH];
+  char                                    help[METRICS_HELP_MAX_LENGTH];
+
+  snprintf (name, sizeof (name), "%s_%s_received_total", stub, message);
+  snprintf (help, sizeof (help), "Number of %s requests received", message);
+  metrics->received = metrics_register_counter (name, help);
+  snprintf (name, sizeof (name), "%s_%s_answered_total", stub, message);
+  snprintf (help, sizeof (help), "Number of %s requests answered with success", message);
+  metrics->answered = metrics_register_counter (name, help);
+  snprintf (name, sizeof (name), "%s_%s_rejected_total", stub, message);
+  snprintf (help, sizeof (help), "Number of %s requests answered with an injected error", message);
+  metrics->rejected = metrics_register_counter (name, help);
+  snprintf (name, sizeof (name), "%s_%s_dropped_total", stub, message);
+  snprintf (help, sizeof (help), "Number of %s requests dropped without answer", message);
+  metrics->dropped = metrics_register_counter (name, help);
+}
+
+//------------------------------------------------------------------------------
+// xorshift64*, one state per thread
+uint64_t stub_random (void)
+{
+  if (0 == random_state) {
+    random_state = metrics_now_ns () ^ ((uint64_t)(uintptr_t)&random_state << 16) ^ 0x9E3779B97F4A7C15ULL;
+  }
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return random_state * 0x2545F4914F6CDD1DULL;
+}
+
+//------------------------------------------------------------------------------
+stub_action_t stub_draw_action (const stub_fault_config_t * const config, const stub_message_metrics_t * const metrics)
+{
+  uint32_t                                draw = 0;
+
+  metrics_counter_add (metrics->received, 1);
+  if (config->drop_ppm || config->reject_ppm) {
+    draw = stub_random () % STUB_PPM;
+    if (draw < config->drop_ppm) {
+      metrics_counter_add (metrics->dropped, 1);
+      return STUB_ACTION_DROP;
+    }
+    if (draw < config->drop_ppm + config->reject_ppm) {
+      metrics_counter_add (metrics->rejected, 1);
+      return STUB_ACTION_REJECT;
+    }
+  }
+  metrics_counter_add (metrics->answered, 1);
+  return STUB_ACTION_ANSWER;
+}
+
+//------------------------------------------------------------------------------
+uint64_t stub_draw_delay_ns (const stub_fault_config_t * const config)
+{
+  uint64_t                                delay_us = config->latency_us;
+
+  if (config->jitter_us) {
+    delay_us += stub_random () % ((uint64_t)config->jitter_us + 1);
+  }
+  return delay_us * NS_PER_US;
+}
+
+//------------------------------------------------------------------------------
+int stub_delay_queue_init (stub_delay_queue_t * const queue, const uint32_t capacity)
+{
+  pthread_condattr_t                      attr;
+
+  memset (queue, 0, sizeof (*queue));
+  queue->heap = calloc (capacity, sizeof (stub_delayed_t));
+  if (!queue->heap) {
+    return RETURNerror;
+  }
+  queue->capacity = capacity;
+  pthread_mutex_init (&queue->mutex, NULL);
+  // the due times are on the monotonic clock of metrics_now_ns
+  pthread_condattr_init (&attr);
+  pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+  pthread_cond_init (&queue->cond, &attr);
+  pthread_condattr_destroy (&attr);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void stub_delay_queue_free (stub_delay_queue_t * const queue)
+{
+  if (queue->heap) {
+    pthread_cond_destroy (&queue->cond);
+    pthread_mutex_destroy (&queue->mutex);
+    free (queue->heap);
+    queue->heap = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+int stub_delay_queue_push (stub_delay_queue_t * const queue, const uint64_t due_ns, void * const item)
+{
+  uint32_t                                i = 0;
+
+  pthread_mutex_lock (&queue->mutex);
+  if (queue->size == queue->capacity) {
+    pthread_mutex_unlock (&queue->mutex);
+    return RETURNerror;
+  }
+  // sift up
+  i = queue->size++;
+  while (i > 0) {
+    const uint32_t                          parent = (i - 1) / 2;
+
+    if (queue->heap[parent].due_ns <= due_ns) {
+      break;
+    }
+    queue->heap[i] = queue->heap[parent];
+    i = parent;
+  }
+  queue->heap[i].due_ns = due_ns;
+  queue->heap[i].item = item;
+  // the waiter sleeps until the previous earliest item, wake it up if it changed
+  if (0 == i) {
+    pthread_cond_signal (&queue->cond);
+  }
+  pthread_mutex_unlock (&queue->mutex);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void *pop_locked (stub_delay_queue_t * const queue)
+{
+  void                                   *item = queue->heap[0].item;
+  const stub_delayed_t                    last = queue->heap[--queue->size];
+  uint32_t                                i = 0;
+
+  // sift down the last element from the root
+  for (;;) {
+    uint32_t                                child = 2 * i + 1;
+
+    if (child >= queue->size) {
+      break;
+    }
+    if ((child + 1 < queue->size) && (queue->heap[child + 1].due_ns < queue->heap[child].due_ns)) {
+      child++;
+    }
+    if (last.due_ns <= queue->heap[child].due_ns) {
+      break;
+    }
+    queue->heap[i] = queue->heap[child];
+    i = child;
+  }
+  queue->heap[i] = last;
+  return item;
+}
+
+//------------------------------------------------------------------------------
+void *stub_delay_queue_pop (stub_delay_queue_t * const queue, const uint64_t now_ns)
+{
+  void                                   *item = NULL;
+
+  pthread_mutex_lock (&queue->mutex);
+  if (queue->size && (queue->heap[0].due_ns <= now_ns)) {
+    item = pop_locked (queue);
+  }
+  pthread_mutex_unlock (&queue->mutex);
+  return item;
+}
+
+//------------------------------------------------------------------------------
+uint64_t stub_delay_queue_next (stub_delay_queue_t * const queue)
+{
+  uint64_t                                due_ns = UINT64_MAX;
+
+  pthread_mutex_lock (&queue->mutex);
+  if (queue->size) {
+    due_ns = queue->heap[0].due_ns;
+  }
+  pthread_mutex_unlock (&queue->mutex);
+  return due_ns;
+}
+
+//------------------------------------------------------------------------------
+void *stub_delay_queue_wait (stub_delay_queue_t * const queue, const uint64_t max_wait_ns)
+{
+  const uint64_t                          deadline_ns = metrics_now_ns () + max_wait_ns;
+  uint64_t                                wake_ns = 0;
+  struct timespec                         ts = {0};
+  void                                   *item = NULL;
+
+  pthread_mutex_lock (&queue->mutex);
+  for (;;) {
+    const uint64_t                          now_ns = metrics_now_ns ();
+
+    if (queue->size && (queue->heap[0].due_ns <= now_ns)) {
+      item = pop_locked (queue);
+      break;
+    }
+    if (now_ns >= deadline_ns) {
+      break;
+    }
+    wake_ns = deadline_ns;
+    if (queue->size && (queue->heap[0].due_ns < wake_ns)) {
+      wake_ns = queue->heap[0].due_ns;
+    }
+    ts.tv_sec = wake_ns / NS_PER_S;
+    ts.tv_nsec = wake_ns % NS_PER_S;
+    pthread_cond_timedwait (&queue->cond, &queue->mutex, &ts);
+  }
+  pthread_mutex_unlock (&queue->mutex);
+  return item;
+}
+
+//------------------------------------------------------------------------------
+void stub_report_messages (const char * const names[], const stub_message_metrics_t metrics[], const int nb_messages, const double elapsed_s)
+{
+  printf ("\n%-10s %10s %10s %10s %10s %10s\n", "message", "received", "answered", "rejected", "dropped", "per sec");
+  for (int m = 0; m < nb_messages; m++) {
+    const int64_t                           received = metrics_get_value (metrics[m].received);
+
+    printf ("%-10s %10" PRId64 " %10" PRId64 " %10" PRId64 " %10" PRId64 " %10.1f\n", names[m], received,
+            metrics_get_value (metrics[m].answered), metrics_get_value (metrics[m].rejected), metrics_get_value (metrics[m].dropped),
+            elapsed_s > 0 ? received / elapsed_s : 0.0);
+  }
+}
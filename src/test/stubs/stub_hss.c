@@ -0,0 +1,777 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file stub_hss.c
+  \brief Stub HSS answering the Authentication Information, Update Location
+  and Purge UE requests of the MME on S6a, without database. Every IMSI is a
+  subscriber sharing the K and OPc of mme_load_generator and the same
+  subscription data. The E-UTRAN vectors of the serving PLMN are computed
+  at startup with a growing SQN and handed out in turn, the USIM of the
+  load generator does not check the freshness of the SQN; a vector of
+  another PLMN is computed when requested.
+  The requests are handled in the dispatch threads of freeDiameter, the
+  delayed answers are sent by a dedicated thread.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common_defs.h"
+#include "s6a_defs.h"
+#include "milenage.h"
+#include "stubs.h"
+
+#define HSS_MAX_VECTORS_PER_ANSWER        5
+#define HSS_DELAY_QUEUE_SIZE              (1 << 16)
+#define HSS_AMF                           0x8000
+
+typedef enum hss_message_e {
+  HSS_AUTHENTICATION_INFORMATION = 0,
+  HSS_UPDATE_LOCATION,
+  HSS_PURGE_UE,
+  HSS_MESSAGE_MAX,
+} hss_message_t;
+
+static const char                      *hss_message_names[HSS_MESSAGE_MAX] = {
+  "AIR", "ULR", "PUR",
+};
+
+static const char                      *hss_metric_names[HSS_MESSAGE_MAX] = {
+  "authentication_information", "update_location", "purge_ue",
+};
+
+typedef struct hss_config_s {
+  const char                             *fd_config;
+  uint16_t                                mcc;
+  uint16_t                                mnc;
+  uint8_t                                 mnc_digit_length;
+  uint8_t                                 plmn[3];
+  uint8_t                                 k[16];
+  uint8_t                                 opc[16];
+  uint32_t                                nb_vectors;
+  const char                             *apn;
+  const char                             *msisdn;
+  uint32_t                                duration_s;
+  uint16_t                                metrics_port;
+  stub_fault_config_t                     faults;
+} hss_config_t;
+
+typedef struct hss_vector_s {
+  uint8_t                                 rand[16];
+  uint8_t                                 xres[8];
+  uint8_t                                 autn[16];
+  uint8_t                                 kasme[32];
+} hss_vector_t;
+
+// answer AVPs of the stub, the request AVPs are the ones of the MME in s6a_fd_cnf
+typedef struct hss_dict_s {
+  struct dict_object                     *vendor_id;
+  struct dict_object                     *experimental_result_code;
+  struct dict_object                     *e_utran_vector;
+  struct dict_object                     *rand;
+  struct dict_object                     *xres;
+  struct dict_object                     *autn;
+  struct dict_object                     *kasme;
+  struct dict_object                     *msisdn;
+  struct dict_object                     *subscriber_status;
+  struct dict_object                     *network_access_mode;
+  struct dict_object                     *ambr;
+  struct dict_object                     *max_bandwidth_ul;
+  struct dict_object                     *max_bandwidth_dl;
+  struct dict_object                     *apn_configuration_profile;
+  struct dict_object                     *context_identifier;
+  struct dict_object                     *all_apn_conf_inc_ind;
+  struct dict_object                     *apn_configuration;
+  struct dict_object                     *pdn_type;
+  struct dict_object                     *eps_subscribed_qos_profile;
+  struct dict_object                     *qos_class_identifier;
+  struct dict_object                     *allocation_retention_priority;
+  struct dict_object                     *priority_level;
+  struct dict_object                     *pre_emption_capability;
+  struct dict_object                     *pre_emption_vulnerability;
+  struct dict_object                     *subscribed_periodic_rau_tau_timer;
+} hss_dict_t;
+
+s6a_fd_cnf_t                            s6a_fd_cnf;
+
+static hss_config_t                     hss_config = {
+  .fd_config = NULL,
+  // first TAI of etc/mme.conf, as mme_load_generator
+  .mcc = 1,
+  .mnc = 1,
+  .mnc_digit_length = 2,
+  // TS 35.208 test set 1
+  .k = {0x46, 0x5b, 0x5c, 0xe8, 0xb1, 0x99, 0xb4, 0x9f, 0xaa, 0x5f, 0x0a, 0x2e, 0xe2, 0x38, 0xa6, 0xbc},
+  .opc = {0xcd, 0x63, 0xcb, 0x71, 0x95, 0x4a, 0x9f, 0x4e, 0x48, 0xa5, 0x99, 0x4e, 0x37, 0xa0, 0x2b, 0xaf},
+  .nb_vectors = 4096,
+  .apn = "oai.ipv4",
+  .msisdn = "33611123456",
+  .duration_s = 0,
+};
+
+static hss_dict_t                       hss_dict;
+static hss_vector_t                    *hss_vectors = NULL;
+static volatile uint32_t                hss_next_vector = 0;
+static volatile uint64_t                hss_sqn = 0;
+static stub_delay_queue_t               hss_queue;
+static pthread_t                        hss_delay_thread;
+
+static stub_message_metrics_t           hss_metrics[HSS_MESSAGE_MAX];
+static metric_id_t                      hss_vectors_computed;
+
+//------------------------------------------------------------------------------
+static void usage (const char *name)
+{
+  fprintf (stderr,
+           "Usage: %s -f FILE [options]\n"
+           "  -f, --fd-config FILE       freeDiameter configuration of the HSS\n"
+           "      --mcc MCC --mnc MNC    serving PLMN of the precomputed vectors (%03u %02u)\n"
+           "  -k, --key HEX              K of the subscribers\n"
+           "  -c, --opc HEX              OPc of the subscribers\n"
+           "  -v, --vectors N            precomputed vectors (%u)\n"
+           "  -a, --apn APN              default APN of the subscribers (%s)\n"
+           "  -n, --msisdn MSISDN        MSISDN of the subscribers (%s)\n"
+           "  -l, --latency MS[:JITTER]  latency of the answers, plus a uniform jitter\n"
+           "  -r, --reject PERCENT       requests rejected, Authentication data unavailable for\n"
+           "                             AIR, User unknown for ULR and PUR\n"
+           "  -D, --drop PERCENT         requests dropped without answer\n"
+           "  -d, --duration N           run duration in seconds, 0 until interrupted (%u)\n"
+           "  -M, --metrics-port PORT    serve the metrics over HTTP on this port\n",
+           name, hss_config.mcc, hss_config.mnc, hss_config.nb_vectors, hss_config.apn, hss_config.msisdn, hss_config.duration_s);
+}
+
+//------------------------------------------------------------------------------
+static int parse_options (int argc, char *argv[])
+{
+  enum { OPT_MCC = 256, OPT_MNC };
+  static const struct option              options[] = {
+    {"fd-config", required_argument, NULL, 'f'},
+    {"mcc", required_argument, NULL, OPT_MCC},
+    {"mnc", required_argument, NULL, OPT_MNC},
+    {"key", required_argument, NULL, 'k'},
+    {"opc", required_argument, NULL, 'c'},
+    {"vectors", required_argument, NULL, 'v'},
+    {"apn", required_argument, NULL, 'a'},
+    {"msisdn", required_argument, NULL, 'n'},
+    {"latency", required_argument, NULL, 'l'},
+    {"reject", required_argument, NULL, 'r'},
+    {"drop", required_argument, NULL, 'D'},
+    {"duration", required_argument, NULL, 'd'},
+    {"metrics-port", required_argument, NULL, 'M'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  int                                     c = 0;
+
+  while ((c = getopt_long (argc, argv, "f:k:c:v:a:n:l:r:D:d:M:h", options, NULL)) != -1) {
+    switch (c) {
+    case 'f':
+      hss_config.fd_config = optarg;
+      break;
+    case OPT_MCC:
+      hss_config.mcc = atoi (optarg);
+      break;
+    case OPT_MNC:
+      hss_config.mnc = atoi (optarg);
+      hss_config.mnc_digit_length = strlen (optarg) == 3 ? 3 : 2;
+      break;
+    case 'k':
+      if (RETURNok != stub_parse_hex (optarg, hss_config.k, sizeof (hss_config.k))) {
+        fprintf (stderr, "Invalid K %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'c':
+      if (RETURNok != stub_parse_hex (optarg, hss_config.opc, sizeof (hss_config.opc))) {
+        fprintf (stderr, "Invalid OPc %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'v':
+      hss_config.nb_vectors = strtoul (optarg, NULL, 0);
+      break;
+    case 'a':
+      hss_config.apn = optarg;
+      break;
+    case 'n':
+      hss_config.msisdn = optarg;
+      break;
+    case 'l':
+      if (RETURNok != stub_parse_latency (optarg, &hss_config.faults)) {
+        fprintf (stderr, "Invalid latency %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'r':
+      if (RETURNok != stub_parse_percent (optarg, &hss_config.faults.reject_ppm)) {
+        fprintf (stderr, "Invalid reject percentage %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'D':
+      if (RETURNok != stub_parse_percent (optarg, &hss_config.faults.drop_ppm)) {
+        fprintf (stderr, "Invalid drop percentage %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'd':
+      hss_config.duration_s = strtoul (optarg, NULL, 0);
+      break;
+    case 'M':
+      hss_config.metrics_port = atoi (optarg);
+      break;
+    default:
+      usage (argv[0]);
+      return RETURNerror;
+    }
+  }
+
+  if (!hss_config.fd_config) {
+    usage (argv[0]);
+    return RETURNerror;
+  }
+  if ((0 == hss_config.nb_vectors) || (strlen (hss_config.msisdn) > 15)) {
+    fprintf (stderr, "At least one vector and an MSISDN of at most 15 digits are needed\n");
+    return RETURNerror;
+  }
+  if ((hss_config.faults.reject_ppm + hss_config.faults.drop_ppm) > STUB_PPM) {
+    fprintf (stderr, "More than 100%% of the requests rejected or dropped\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void encode_plmn (void)
+{
+  const uint16_t                          mcc = hss_config.mcc;
+  const uint16_t                          mnc = hss_config.mnc;
+
+  hss_config.plmn[0] = (((mcc / 10) % 10) << 4) | (mcc / 100);
+  if (3 == hss_config.mnc_digit_length) {
+    hss_config.plmn[1] = ((mnc % 10) << 4) | (mcc % 10);
+    hss_config.plmn[2] = (((mnc / 10) % 10) << 4) | (mnc / 100);
+  } else {
+    hss_config.plmn[1] = 0xF0 | (mcc % 10);
+    hss_config.plmn[2] = ((mnc % 10) << 4) | ((mnc / 10) % 10);
+  }
+}
+
+//------------------------------------------------------------------------------
+// TS 33.102 6.3.2 and TS 33.401 A.2, AUTN = SQN ^ AK || AMF || MAC-A
+static void hss_generate_vector (const uint8_t plmn[3], hss_vector_t * const vector)
+{
+  const uint64_t                          sqn = __sync_add_and_fetch (&hss_sqn, 1);
+  const uint8_t                           amf[2] = {HSS_AMF >> 8, HSS_AMF & 0xFF};
+  uint8_t                                 sqn_bytes[6];
+  uint8_t                                 ck[16];
+  uint8_t                                 ik[16];
+  uint8_t                                 ak[6];
+  uint8_t                                 mac_a[8];
+  uint64_t                                random = 0;
+
+  for (int i = 0; i < 16; i++) {
+    if (0 == (i % 8)) {
+      random = stub_random ();
+    }
+    vector->rand[i] = (uint8_t)(random >> (8 * (i % 8)));
+  }
+  for (int i = 0; i < 6; i++) {
+    sqn_bytes[i] = (uint8_t)(sqn >> (8 * (5 - i)));
+  }
+  milenage_f1 (hss_config.k, hss_config.opc, vector->rand, sqn_bytes, amf, mac_a);
+  milenage_f2345 (hss_config.k, hss_config.opc, vector->rand, vector->xres, ck, ik, ak);
+  for (int i = 0; i < 6; i++) {
+    vector->autn[i] = sqn_bytes[i] ^ ak[i];
+  }
+  memcpy (&vector->autn[6], amf, sizeof (amf));
+  memcpy (&vector->autn[8], mac_a, sizeof (mac_a));
+  milenage_kasme (ck, ik, plmn, vector->autn, vector->kasme);
+  metrics_counter_add (hss_vectors_computed, 1);
+}
+
+//------------------------------------------------------------------------------
+static int hss_vectors_init (void)
+{
+  hss_vectors = calloc (hss_config.nb_vectors, sizeof (hss_vector_t));
+  if (!hss_vectors) {
+    return RETURNerror;
+  }
+  for (uint32_t v = 0; v < hss_config.nb_vectors; v++) {
+    hss_generate_vector (hss_config.plmn, &hss_vectors[v]);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int hss_add_u32 (struct avp * const parent, struct dict_object * const model, const uint32_t u32)
+{
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  value.u32 = u32;
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp));
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (parent, MSG_BRW_LAST_CHILD, avp));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_add_os (struct avp * const parent, struct dict_object * const model, const uint8_t * const data, const size_t length)
+{
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  value.os.data = (uint8_t *) data;
+  value.os.len = length;
+  CHECK_FCT (fd_msg_avp_new (model, 0, &avp));
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  CHECK_FCT (fd_msg_avp_add (parent, MSG_BRW_LAST_CHILD, avp));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// same layout as s6a_add_result_code of the OAI HSS
+static int hss_add_result_code (struct msg * const ans, const uint32_t result_code)
+{
+  struct avp                             *experimental_result = NULL;
+
+  if (DIAMETER_ERROR_IS_VENDOR (result_code)) {
+    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_experimental_result, 0, &experimental_result));
+    CHECK_FCT (hss_add_u32 (experimental_result, hss_dict.vendor_id, VENDOR_3GPP));
+    CHECK_FCT (hss_add_u32 (experimental_result, hss_dict.experimental_result_code, result_code));
+    CHECK_FCT (fd_msg_avp_add (ans, MSG_BRW_LAST_CHILD, experimental_result));
+    CHECK_FCT (fd_msg_add_origin (ans, 0));
+  } else {
+    CHECK_FCT (fd_msg_rescode_set (ans, "DIAMETER_SUCCESS", NULL, NULL, 1));
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_copy_auth_session_state (struct msg * const qry, struct msg * const ans)
+{
+  struct avp                             *avp = NULL;
+  struct avp_hdr                         *hdr = NULL;
+
+  CHECK_FCT (fd_msg_search_avp (qry, s6a_fd_cnf.dataobj_s6a_auth_session_state, &avp));
+  if (avp) {
+    CHECK_FCT (fd_msg_avp_hdr (avp, &hdr));
+    CHECK_FCT (hss_add_u32 ((struct avp *)ans, s6a_fd_cnf.dataobj_s6a_auth_session_state, hdr->avp_value->u32));
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_add_vector (struct msg * const ans, const hss_vector_t * const vector)
+{
+  struct avp                             *authentication_info = NULL;
+  struct avp                             *e_utran_vector = NULL;
+
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_authentication_info, 0, &authentication_info));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.e_utran_vector, 0, &e_utran_vector));
+  CHECK_FCT (hss_add_os (e_utran_vector, hss_dict.rand, vector->rand, sizeof (vector->rand)));
+  CHECK_FCT (hss_add_os (e_utran_vector, hss_dict.xres, vector->xres, sizeof (vector->xres)));
+  CHECK_FCT (hss_add_os (e_utran_vector, hss_dict.autn, vector->autn, sizeof (vector->autn)));
+  CHECK_FCT (hss_add_os (e_utran_vector, hss_dict.kasme, vector->kasme, sizeof (vector->kasme)));
+  CHECK_FCT (fd_msg_avp_add (authentication_info, MSG_BRW_LAST_CHILD, e_utran_vector));
+  CHECK_FCT (fd_msg_avp_add (ans, MSG_BRW_LAST_CHILD, authentication_info));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_add_subscription_data (struct msg * const ans)
+{
+  struct avp                             *subscription_data = NULL;
+  struct avp                             *ambr = NULL;
+  struct avp                             *apn_profile = NULL;
+  struct avp                             *apn_configuration = NULL;
+  struct avp                             *qos_profile = NULL;
+  struct avp                             *arp = NULL;
+  uint8_t                                 msisdn[8] = {0};
+  const size_t                            msisdn_length = strlen (hss_config.msisdn);
+
+  // TBCD, the filler of an odd number of digits in the last high nibble
+  for (size_t i = 0; i < msisdn_length; i++) {
+    if (i & 0x01) {
+      msisdn[i >> 1] = (msisdn[i >> 1] & 0x0F) | ((hss_config.msisdn[i] - '0') << 4);
+    } else {
+      msisdn[i >> 1] = 0xF0 | (hss_config.msisdn[i] - '0');
+    }
+  }
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_subscription_data, 0, &subscription_data));
+  CHECK_FCT (hss_add_os (subscription_data, hss_dict.msisdn, msisdn, (msisdn_length + 1) / 2));
+  // SERVICE_GRANTED, ONLY_PACKET
+  CHECK_FCT (hss_add_u32 (subscription_data, hss_dict.subscriber_status, 0));
+  CHECK_FCT (hss_add_u32 (subscription_data, hss_dict.network_access_mode, 2));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.ambr, 0, &ambr));
+  CHECK_FCT (hss_add_u32 (ambr, hss_dict.max_bandwidth_ul, 50000000));
+  CHECK_FCT (hss_add_u32 (ambr, hss_dict.max_bandwidth_dl, 100000000));
+  CHECK_FCT (fd_msg_avp_add (subscription_data, MSG_BRW_LAST_CHILD, ambr));
+
+  CHECK_FCT (fd_msg_avp_new (hss_dict.apn_configuration_profile, 0, &apn_profile));
+  CHECK_FCT (hss_add_u32 (apn_profile, hss_dict.context_identifier, 0));
+  CHECK_FCT (hss_add_u32 (apn_profile, hss_dict.all_apn_conf_inc_ind, 0));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.apn_configuration, 0, &apn_configuration));
+  CHECK_FCT (hss_add_u32 (apn_configuration, hss_dict.context_identifier, 0));
+  // IPv4, the address is allocated by the SPGW
+  CHECK_FCT (hss_add_u32 (apn_configuration, hss_dict.pdn_type, 0));
+  CHECK_FCT (hss_add_os (apn_configuration, s6a_fd_cnf.dataobj_s6a_service_selection, (const uint8_t *)hss_config.apn, strlen (hss_config.apn)));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.eps_subscribed_qos_profile, 0, &qos_profile));
+  CHECK_FCT (hss_add_u32 (qos_profile, hss_dict.qos_class_identifier, 9));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.allocation_retention_priority, 0, &arp));
+  CHECK_FCT (hss_add_u32 (arp, hss_dict.priority_level, 15));
+  // PRE-EMPTION_CAPABILITY_DISABLED, PRE-EMPTION_VULNERABILITY_ENABLED
+  CHECK_FCT (hss_add_u32 (arp, hss_dict.pre_emption_capability, 1));
+  CHECK_FCT (hss_add_u32 (arp, hss_dict.pre_emption_vulnerability, 0));
+  CHECK_FCT (fd_msg_avp_add (qos_profile, MSG_BRW_LAST_CHILD, arp));
+  CHECK_FCT (fd_msg_avp_add (apn_configuration, MSG_BRW_LAST_CHILD, qos_profile));
+  CHECK_FCT (fd_msg_avp_new (hss_dict.ambr, 0, &ambr));
+  CHECK_FCT (hss_add_u32 (ambr, hss_dict.max_bandwidth_ul, 50000000));
+  CHECK_FCT (hss_add_u32 (ambr, hss_dict.max_bandwidth_dl, 100000000));
+  CHECK_FCT (fd_msg_avp_add (apn_configuration, MSG_BRW_LAST_CHILD, ambr));
+  CHECK_FCT (fd_msg_avp_add (apn_profile, MSG_BRW_LAST_CHILD, apn_configuration));
+  CHECK_FCT (fd_msg_avp_add (subscription_data, MSG_BRW_LAST_CHILD, apn_profile));
+
+  CHECK_FCT (hss_add_u32 (subscription_data, hss_dict.subscribed_periodic_rau_tau_timer, 120));
+  CHECK_FCT (fd_msg_avp_add (ans, MSG_BRW_LAST_CHILD, subscription_data));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t hss_requested_vectors (struct msg * const qry)
+{
+  struct avp                             *avp = NULL;
+  struct avp                             *child = NULL;
+  struct avp_hdr                         *hdr = NULL;
+  uint32_t                                nb_vectors = 1;
+
+  if (fd_msg_search_avp (qry, s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info, &avp) || !avp) {
+    return nb_vectors;
+  }
+  if ((0 == fd_msg_search_avp (avp, s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors, &child)) && child
+      && (0 == fd_msg_avp_hdr (child, &hdr))) {
+    nb_vectors = hdr->avp_value->u32;
+  }
+  if (0 == nb_vectors) {
+    nb_vectors = 1;
+  }
+  return (nb_vectors > HSS_MAX_VECTORS_PER_ANSWER) ? HSS_MAX_VECTORS_PER_ANSWER : nb_vectors;
+}
+
+//------------------------------------------------------------------------------
+static int hss_add_vectors (struct msg * const qry, struct msg * const ans)
+{
+  struct avp                             *avp = NULL;
+  struct avp_hdr                         *hdr = NULL;
+  const uint32_t                          nb_vectors = hss_requested_vectors (qry);
+  hss_vector_t                            vector;
+
+  CHECK_FCT (fd_msg_search_avp (qry, s6a_fd_cnf.dataobj_s6a_visited_plmn_id, &avp));
+  if (avp) {
+    CHECK_FCT (fd_msg_avp_hdr (avp, &hdr));
+  }
+  for (uint32_t v = 0; v < nb_vectors; v++) {
+    if (hdr && (3 == hdr->avp_value->os.len) && memcmp (hdr->avp_value->os.data, hss_config.plmn, 3)) {
+      // KASME is bound to the serving network
+      hss_generate_vector (hdr->avp_value->os.data, &vector);
+      CHECK_FCT (hss_add_vector (ans, &vector));
+    } else {
+      CHECK_FCT (hss_add_vector (ans, &hss_vectors[__sync_fetch_and_add (&hss_next_vector, 1) % hss_config.nb_vectors]));
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_answer (struct msg ** msg, const hss_message_t message)
+{
+  struct msg                             *qry = *msg;
+  struct msg                             *ans = NULL;
+  const stub_action_t                     action = stub_draw_action (&hss_config.faults, &hss_metrics[message]);
+  uint64_t                                delay_ns = 0;
+
+  if (STUB_ACTION_DROP == action) {
+    fd_msg_free (qry);
+    *msg = NULL;
+    return 0;
+  }
+  CHECK_FCT (fd_msg_new_answer_from_req (fd_g_config->cnf_dict, msg, 0));
+  ans = *msg;
+
+  if (STUB_ACTION_REJECT == action) {
+    CHECK_FCT (hss_copy_auth_session_state (qry, ans));
+    CHECK_FCT (hss_add_result_code (ans, (HSS_AUTHENTICATION_INFORMATION == message) ?
+                                    DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE : DIAMETER_ERROR_USER_UNKNOWN));
+  } else {
+    switch (message) {
+    case HSS_AUTHENTICATION_INFORMATION:
+      CHECK_FCT (hss_add_vectors (qry, ans));
+      CHECK_FCT (hss_copy_auth_session_state (qry, ans));
+      break;
+
+    case HSS_UPDATE_LOCATION:
+      CHECK_FCT (hss_copy_auth_session_state (qry, ans));
+      CHECK_FCT (hss_add_u32 ((struct avp *)ans, s6a_fd_cnf.dataobj_s6a_ula_flags, ULA_SEPARATION_IND));
+      CHECK_FCT (hss_add_subscription_data (ans));
+      break;
+
+    default:
+      CHECK_FCT (hss_copy_auth_session_state (qry, ans));
+      break;
+    }
+    CHECK_FCT (hss_add_result_code (ans, ER_DIAMETER_SUCCESS));
+  }
+
+  delay_ns = stub_draw_delay_ns (&hss_config.faults);
+  if (delay_ns && (RETURNok == stub_delay_queue_push (&hss_queue, metrics_now_ns () + delay_ns, ans))) {
+    *msg = NULL;
+    return 0;
+  }
+  CHECK_FCT (fd_msg_send (msg, NULL, NULL));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_air_cb (struct msg **msg, struct avp *paramavp, struct session *sess, void *opaque, enum disp_action *act)
+{
+  return msg ? hss_answer (msg, HSS_AUTHENTICATION_INFORMATION) : EINVAL;
+}
+
+//------------------------------------------------------------------------------
+static int hss_ulr_cb (struct msg **msg, struct avp *paramavp, struct session *sess, void *opaque, enum disp_action *act)
+{
+  return msg ? hss_answer (msg, HSS_UPDATE_LOCATION) : EINVAL;
+}
+
+//------------------------------------------------------------------------------
+static int hss_pur_cb (struct msg **msg, struct avp *paramavp, struct session *sess, void *opaque, enum disp_action *act)
+{
+  return msg ? hss_answer (msg, HSS_PURGE_UE) : EINVAL;
+}
+
+//------------------------------------------------------------------------------
+// any MME is accepted, without TLS
+static int hss_peer_validate (struct peer_info *info, int *auth, int (**cb2) (struct peer_info *))
+{
+  if (info == NULL) {
+    return EINVAL;
+  }
+  *auth = 1;
+  info->config.pic_flags.sec = PI_SEC_NONE;
+  info->config.pic_flags.persist = PI_PRST_NONE;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void *hss_delay_main (void *arg)
+{
+  struct msg                             *ans = NULL;
+
+  while (stub_running) {
+    if ((ans = stub_delay_queue_wait (&hss_queue, 100 * NS_PER_MS))) {
+      fd_msg_send (&ans, NULL, NULL);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int hss_dict_search (const char * const name, struct dict_object **object)
+{
+  return fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME_ALL_VENDORS, (void *)name, object, ENOENT);
+}
+
+//------------------------------------------------------------------------------
+static int hss_fd_init_dict_objs (void)
+{
+  struct disp_when                        when;
+  struct disp_hdl                        *handle = NULL;
+  vendor_id_t                             vendor_3gpp = VENDOR_3GPP;
+  application_id_t                        app_s6a = APP_S6A;
+
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_VENDOR, VENDOR_BY_ID, (void *)&vendor_3gpp, &s6a_fd_cnf.dataobj_s6a_vendor, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_APPLICATION, APPLICATION_BY_ID, (void *)&app_s6a, &s6a_fd_cnf.dataobj_s6a_app, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Authentication-Information-Request", &s6a_fd_cnf.dataobj_s6a_air, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Update-Location-Request", &s6a_fd_cnf.dataobj_s6a_ulr, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_COMMAND, CMD_BY_NAME, "Purge-UE-Request", &s6a_fd_cnf.dataobj_s6a_pur, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Auth-Session-State", &s6a_fd_cnf.dataobj_s6a_auth_session_state, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Experimental-Result", &s6a_fd_cnf.dataobj_s6a_experimental_result, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Vendor-Id", &hss_dict.vendor_id, ENOENT));
+  CHECK_FCT (fd_dict_search (fd_g_config->cnf_dict, DICT_AVP, AVP_BY_NAME, "Experimental-Result-Code", &hss_dict.experimental_result_code, ENOENT));
+  CHECK_FCT (hss_dict_search ("Visited-PLMN-Id", &s6a_fd_cnf.dataobj_s6a_visited_plmn_id));
+  CHECK_FCT (hss_dict_search ("ULA-Flags", &s6a_fd_cnf.dataobj_s6a_ula_flags));
+  CHECK_FCT (hss_dict_search ("Subscription-Data", &s6a_fd_cnf.dataobj_s6a_subscription_data));
+  CHECK_FCT (hss_dict_search ("Requested-EUTRAN-Authentication-Info", &s6a_fd_cnf.dataobj_s6a_req_eutran_auth_info));
+  CHECK_FCT (hss_dict_search ("Number-Of-Requested-Vectors", &s6a_fd_cnf.dataobj_s6a_number_of_requested_vectors));
+  CHECK_FCT (hss_dict_search ("Authentication-Info", &s6a_fd_cnf.dataobj_s6a_authentication_info));
+  CHECK_FCT (hss_dict_search ("Service-Selection", &s6a_fd_cnf.dataobj_s6a_service_selection));
+  CHECK_FCT (hss_dict_search ("E-UTRAN-Vector", &hss_dict.e_utran_vector));
+  CHECK_FCT (hss_dict_search ("RAND", &hss_dict.rand));
+  CHECK_FCT (hss_dict_search ("XRES", &hss_dict.xres));
+  CHECK_FCT (hss_dict_search ("AUTN", &hss_dict.autn));
+  CHECK_FCT (hss_dict_search ("KASME", &hss_dict.kasme));
+  CHECK_FCT (hss_dict_search ("MSISDN", &hss_dict.msisdn));
+  CHECK_FCT (hss_dict_search ("Subscriber-Status", &hss_dict.subscriber_status));
+  CHECK_FCT (hss_dict_search ("Network-Access-Mode", &hss_dict.network_access_mode));
+  CHECK_FCT (hss_dict_search ("AMBR", &hss_dict.ambr));
+  CHECK_FCT (hss_dict_search ("Max-Requested-Bandwidth-UL", &hss_dict.max_bandwidth_ul));
+  CHECK_FCT (hss_dict_search ("Max-Requested-Bandwidth-DL", &hss_dict.max_bandwidth_dl));
+  CHECK_FCT (hss_dict_search ("APN-Configuration-Profile", &hss_dict.apn_configuration_profile));
+  CHECK_FCT (hss_dict_search ("Context-Identifier", &hss_dict.context_identifier));
+  CHECK_FCT (hss_dict_search ("All-APN-Configurations-Included-Indicator", &hss_dict.all_apn_conf_inc_ind));
+  CHECK_FCT (hss_dict_search ("APN-Configuration", &hss_dict.apn_configuration));
+  CHECK_FCT (hss_dict_search ("PDN-Type", &hss_dict.pdn_type));
+  CHECK_FCT (hss_dict_search ("EPS-Subscribed-QoS-Profile", &hss_dict.eps_subscribed_qos_profile));
+  CHECK_FCT (hss_dict_search ("QoS-Class-Identifier", &hss_dict.qos_class_identifier));
+  CHECK_FCT (hss_dict_search ("Allocation-Retention-Priority", &hss_dict.allocation_retention_priority));
+  CHECK_FCT (hss_dict_search ("Priority-Level", &hss_dict.priority_level));
+  CHECK_FCT (hss_dict_search ("Pre-emption-Capability", &hss_dict.pre_emption_capability));
+  CHECK_FCT (hss_dict_search ("Pre-emption-Vulnerability", &hss_dict.pre_emption_vulnerability));
+  CHECK_FCT (hss_dict_search ("Subscribed-Periodic-RAU-TAU-Timer", &hss_dict.subscribed_periodic_rau_tau_timer));
+
+  memset (&when, 0, sizeof (when));
+  when.app = s6a_fd_cnf.dataobj_s6a_app;
+  when.command = s6a_fd_cnf.dataobj_s6a_air;
+  CHECK_FCT (fd_disp_register (hss_air_cb, DISP_HOW_CC, &when, NULL, &handle));
+  when.command = s6a_fd_cnf.dataobj_s6a_ulr;
+  CHECK_FCT (fd_disp_register (hss_ulr_cb, DISP_HOW_CC, &when, NULL, &handle));
+  when.command = s6a_fd_cnf.dataobj_s6a_pur;
+  CHECK_FCT (fd_disp_register (hss_pur_cb, DISP_HOW_CC, &when, NULL, &handle));
+  CHECK_FCT (fd_disp_app_support (s6a_fd_cnf.dataobj_s6a_app, s6a_fd_cnf.dataobj_s6a_vendor, 1, 0));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int hss_fd_start (void)
+{
+  if (fd_core_initialize () || fd_core_parseconf (hss_config.fd_config) || fd_core_start ()) {
+    return RETURNerror;
+  }
+  if (fd_core_waitstartcomplete ()) {
+    return RETURNerror;
+  }
+  fd_peer_validate_register (hss_peer_validate);
+  return hss_fd_init_dict_objs () ? RETURNerror : RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void register_metrics (void)
+{
+  for (int m = 0; m < HSS_MESSAGE_MAX; m++) {
+    stub_register_message_metrics ("hss_stub", hss_metric_names[m], &hss_metrics[m]);
+  }
+  hss_vectors_computed = metrics_register_counter ("hss_stub_vectors_computed_total", "Number of E-UTRAN vectors computed");
+}
+
+//------------------------------------------------------------------------------
+static void signal_handler (int signum)
+{
+  stub_running = false;
+}
+
+//------------------------------------------------------------------------------
+static void report_progress (const uint32_t elapsed_s, int64_t last_received[HSS_MESSAGE_MAX])
+{
+  printf ("%5us", elapsed_s);
+  for (int m = 0; m < HSS_MESSAGE_MAX; m++) {
+    const int64_t                           received = metrics_get_value (hss_metrics[m].received);
+
+    printf (" %s/s %" PRId64, hss_message_names[m], received - last_received[m]);
+    last_received[m] = received;
+  }
+  printf ("\n");
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int64_t                                 last_received[HSS_MESSAGE_MAX] = {0};
+  uint64_t                                start_ns = 0;
+  uint32_t                                elapsed_s = 0;
+  struct msg                             *ans = NULL;
+
+  if (RETURNok != parse_options (argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  encode_plmn ();
+  register_metrics ();
+
+  if ((RETURNok != hss_vectors_init ()) || (RETURNok != stub_delay_queue_init (&hss_queue, HSS_DELAY_QUEUE_SIZE))) {
+    fprintf (stderr, "Allocation of %u vectors failed\n", hss_config.nb_vectors);
+    return EXIT_FAILURE;
+  }
+  if (pthread_create (&hss_delay_thread, NULL, hss_delay_main, NULL)) {
+    fprintf (stderr, "Delay thread not started\n");
+    return EXIT_FAILURE;
+  }
+  if (RETURNok != hss_fd_start ()) {
+    fprintf (stderr, "freeDiameter not started with %s\n", hss_config.fd_config);
+    stub_running = false;
+    pthread_join (hss_delay_thread, NULL);
+    return EXIT_FAILURE;
+  }
+  // after freeDiameter, which installs its own handlers
+  signal (SIGINT, signal_handler);
+  signal (SIGTERM, signal_handler);
+  if (hss_config.metrics_port && (RETURNok != metrics_server_start (NULL, hss_config.metrics_port))) {
+    fprintf (stderr, "Metrics server not started on port %u\n", hss_config.metrics_port);
+  }
+  printf ("Stub HSS, %u vectors, latency %.3f ms jitter %.3f ms, reject %.2f%% drop %.2f%%\n", hss_config.nb_vectors,
+          hss_config.faults.latency_us / 1000.0, hss_config.faults.jitter_us / 1000.0, hss_config.faults.reject_ppm / 10000.0,
+          hss_config.faults.drop_ppm / 10000.0);
+
+  start_ns = metrics_now_ns ();
+  while (stub_running) {
+    sleep (1);
+    elapsed_s = (metrics_now_ns () - start_ns) / NS_PER_S;
+    report_progress (elapsed_s, last_received);
+    if (hss_config.duration_s && (elapsed_s >= hss_config.duration_s)) {
+      stub_running = false;
+    }
+  }
+  pthread_join (hss_delay_thread, NULL);
+  stub_report_messages (hss_message_names, hss_metrics, HSS_MESSAGE_MAX, (double)(metrics_now_ns () - start_ns) / NS_PER_S);
+  printf ("\nvectors computed %" PRId64 "\n", metrics_get_value (hss_vectors_computed));
+
+  metrics_server_stop ();
+  fd_core_shutdown ();
+  fd_core_wait_shutdown_complete ();
+  while ((ans = stub_delay_queue_pop (&hss_queue, UINT64_MAX))) {
+    fd_msg_free (ans);
+  }
+  stub_delay_queue_free (&hss_queue);
+  free (hss_vectors);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,729 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file stub_mme.c
+  \brief Stub MME loading the SPGW on S11: a window of sessions is kept in
+  flight, each one sends a Create Session Request, then a Delete Session
+  Request on the S11 TEID of the SGW once the session is created, then starts
+  over with a new session. The MME S11 TEIDs are drawn from a counter, they
+  spread the sessions over the workers of the SPGW.
+  The datagrams go through the nwgtpv2c stack like in the MME, the messages
+  are built with the IE formatters of s11_ie_formatter.c. The stub runs in a
+  single thread, like stub_spgw.c.
+  \author
+  \company
+  \email
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "NwLog.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "NwGtpv2cMsgParser.h"
+#include "3gpp_24.008.h"
+#include "s11_messages_types.h"
+#include "s11_common.h"
+#include "s11_ie_formatter.h"
+#include "stubs.h"
+
+#define MME_S11_PORT                      2123
+#define MME_MAX_DATAGRAM_SIZE             4096
+#define MME_MAX_DATAGRAMS_PER_POLL        64
+#define MME_MAX_POLL_WAIT_NS              (100 * NS_PER_MS)
+#define MME_DEFAULT_EBI                   5
+
+typedef enum mme_message_e {
+  MME_CREATE_SESSION = 0,
+  MME_DELETE_SESSION,
+  MME_MESSAGE_MAX,
+} mme_message_t;
+
+static const char                      *mme_message_names[MME_MESSAGE_MAX] = {
+  "CSR", "DSR",
+};
+
+static const char                      *mme_metric_names[MME_MESSAGE_MAX] = {
+  "create_session", "delete_session",
+};
+
+typedef struct mme_config_s {
+  const char                             *address;
+  const char                             *spgw_address;
+  uint16_t                                port;
+  struct in_addr                          s11_address;
+  struct in_addr                          spgw_s11_address;
+  uint32_t                                window;
+  uint32_t                                nb_sessions;        // sessions to create, 0 until the end of the duration
+  uint32_t                                duration_s;
+  uint16_t                                metrics_port;
+} mme_config_t;
+
+typedef enum mme_session_state_e {
+  MME_SESSION_IDLE = 0,
+  MME_SESSION_CREATING,
+  MME_SESSION_DELETING,
+} mme_session_state_t;
+
+// a slot of the window, the index plus one is the handle of its transaction
+typedef struct mme_session_s {
+  mme_session_state_t                     state;
+  uint32_t                                teid;               // MME S11 TEID
+  uint32_t                                sgw_teid;
+  NwGtpv2cTunnelHandleT                   hTunnel;
+  uint64_t                                start_ns;
+} mme_session_t;
+
+typedef struct mme_message_metrics_s {
+  metric_id_t                             sent;
+  metric_id_t                             completed;
+  metric_id_t                             rejected;
+  metric_id_t                             timed_out;
+  metric_id_t                             latency;
+} mme_message_metrics_t;
+
+// the stack runs a single timer at a time, the earliest of its transactions
+typedef struct mme_timer_s {
+  bool                                    armed;
+  uint64_t                                due_ns;
+  void                                   *arg;
+} mme_timer_t;
+
+static mme_config_t                     mme_config = {
+  .address = "127.0.0.1",
+  .spgw_address = "127.0.0.2",
+  .port = MME_S11_PORT,
+  .window = 256,
+  .nb_sessions = 0,
+  .duration_s = 10,
+};
+
+static NwGtpv2cStackHandleT             mme_stack = 0;
+static int                              mme_fd = -1;
+static mme_timer_t                      mme_timer = {0};
+
+static mme_session_t                   *mme_sessions = NULL;
+static uint32_t                         mme_next_teid = 1;
+static uint32_t                         mme_created = 0;
+
+static mme_message_metrics_t            mme_metrics[MME_MESSAGE_MAX];
+static metric_id_t                      mme_sessions_gauge;
+static metric_id_t                      mme_errors;
+
+//------------------------------------------------------------------------------
+static void usage (const char *name)
+{
+  fprintf (stderr,
+           "Usage: %s [options]\n"
+           "  -a, --address ADDRESS      local S11 address (%s)\n"
+           "  -S, --spgw ADDRESS         S11 address of the SPGW (%s)\n"
+           "  -p, --port PORT            S11 port, local and of the SPGW (%u)\n"
+           "  -w, --window N             sessions in flight (%u)\n"
+           "  -n, --sessions N           sessions to create, 0 until the end of the duration (%u)\n"
+           "  -d, --duration N           run duration in seconds, 0 until interrupted (%u)\n"
+           "  -M, --metrics-port PORT    serve the metrics over HTTP on this port\n",
+           name, mme_config.address, mme_config.spgw_address, mme_config.port, mme_config.window, mme_config.nb_sessions,
+           mme_config.duration_s);
+}
+
+//------------------------------------------------------------------------------
+static int parse_options (int argc, char *argv[])
+{
+  static const struct option              options[] = {
+    {"address", required_argument, NULL, 'a'},
+    {"spgw", required_argument, NULL, 'S'},
+    {"port", required_argument, NULL, 'p'},
+    {"window", required_argument, NULL, 'w'},
+    {"sessions", required_argument, NULL, 'n'},
+    {"duration", required_argument, NULL, 'd'},
+    {"metrics-port", required_argument, NULL, 'M'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  int                                     c = 0;
+
+  while ((c = getopt_long (argc, argv, "a:S:p:w:n:d:M:h", options, NULL)) != -1) {
+    switch (c) {
+    case 'a':
+      mme_config.address = optarg;
+      break;
+    case 'S':
+      mme_config.spgw_address = optarg;
+      break;
+    case 'p':
+      mme_config.port = atoi (optarg);
+      break;
+    case 'w':
+      mme_config.window = strtoul (optarg, NULL, 0);
+      break;
+    case 'n':
+      mme_config.nb_sessions = strtoul (optarg, NULL, 0);
+      break;
+    case 'd':
+      mme_config.duration_s = strtoul (optarg, NULL, 0);
+      break;
+    case 'M':
+      mme_config.metrics_port = atoi (optarg);
+      break;
+    default:
+      usage (argv[0]);
+      return RETURNerror;
+    }
+  }
+
+  if (inet_pton (AF_INET, mme_config.address, &mme_config.s11_address) != 1) {
+    fprintf (stderr, "Invalid S11 address %s\n", mme_config.address);
+    return RETURNerror;
+  }
+  if (inet_pton (AF_INET, mme_config.spgw_address, &mme_config.spgw_s11_address) != 1) {
+    fprintf (stderr, "Invalid SPGW S11 address %s\n", mme_config.spgw_address);
+    return RETURNerror;
+  }
+  if (0 == mme_config.window) {
+    fprintf (stderr, "Invalid window %u\n", mme_config.window);
+    return RETURNerror;
+  }
+  if ((0 == mme_config.nb_sessions) && (0 == mme_config.duration_s)) {
+    fprintf (stderr, "Neither a number of sessions nor a duration, the run would not end\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t mme_session_index (const mme_session_t * const session)
+{
+  return (uint32_t)(session - mme_sessions);
+}
+
+//------------------------------------------------------------------------------
+static mme_session_t *mme_session_of_trxn (const NwGtpv2cUlpTrxnHandleT hUlpTrxn)
+{
+  if ((0 == hUlpTrxn) || (hUlpTrxn > mme_config.window)) {
+    return NULL;
+  }
+  return &mme_sessions[hUlpTrxn - 1];
+}
+
+//------------------------------------------------------------------------------
+static void mme_delete_local_tunnel (mme_session_t * const session)
+{
+  NwGtpv2cUlpApiT                         ulp_req = {0};
+
+  if (session->hTunnel) {
+    ulp_req.apiType = NW_GTPV2C_ULP_DELETE_LOCAL_TUNNEL;
+    ulp_req.apiInfo.deleteLocalTunnelInfo.hTunnel = session->hTunnel;
+    nwGtpv2cProcessUlpReq (mme_stack, &ulp_req);
+    session->hTunnel = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_send_create_session_request (mme_session_t * const session)
+{
+  NwGtpv2cUlpApiT                         ulp_req = {0};
+  Imsi_t                                  imsi = {{0}};
+  rat_type_t                              rat_type = RAT_EUTRAN;
+  pdn_type_t                              pdn_type = IPv4;
+  PAA_t                                   paa = {0};
+  ServingNetwork_t                        serving_network = {.mcc = {0, 0, 1},.mnc = {0x0F, 0, 1} };
+  bearer_context_to_be_created_t          bearer_context = {0};
+  uint8_t                                 restart_counter = 0;
+
+  // 0 is not a valid TEID
+  if (0 == mme_next_teid) {
+    mme_next_teid = 1;
+  }
+  session->teid = mme_next_teid++;
+  session->sgw_teid = 0;
+  session->hTunnel = 0;
+
+  ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
+  if (NW_OK != nwGtpv2cMsgNew (mme_stack, NW_TRUE, NW_GTP_CREATE_SESSION_REQ, 0, 0, &ulp_req.hMsg)) {
+    metrics_counter_add (mme_errors, 1);
+    return;
+  }
+  ulp_req.apiInfo.initialReqInfo.peerIp = mme_config.spgw_s11_address.s_addr;
+  ulp_req.apiInfo.initialReqInfo.teidLocal = session->teid;
+  ulp_req.apiInfo.initialReqInfo.hUlpTrxn = (NwGtpv2cUlpTrxnHandleT) mme_session_index (session) + 1;
+  ulp_req.apiInfo.initialReqInfo.hUlpTunnel = (NwGtpv2cUlpTunnelHandleT) mme_session_index (session) + 1;
+
+  nwGtpv2cMsgAddIe (ulp_req.hMsg, NW_GTPV2C_IE_RECOVERY, 1, 0, &restart_counter);
+  imsi.length = snprintf ((char *)imsi.digit, sizeof (imsi.digit), "00101%010" PRIu32, session->teid);
+  s11_imsi_ie_set (&ulp_req.hMsg, &imsi);
+  s11_rat_type_ie_set (&ulp_req.hMsg, &rat_type);
+  s11_pdn_type_ie_set (&ulp_req.hMsg, &pdn_type);
+  paa.pdn_type = IPv4;
+  s11_paa_ie_set (&ulp_req.hMsg, &paa);
+  s11_apn_restriction_ie_set (&ulp_req.hMsg, 0x01);
+  nwGtpv2cMsgAddIeFteid (ulp_req.hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, S11_MME_GTP_C, session->teid, ntohl (mme_config.s11_address.s_addr), NULL);
+  s11_apn_ie_set (&ulp_req.hMsg, "oai.ipv4");
+  s11_serving_network_ie_set (&ulp_req.hMsg, &serving_network);
+  bearer_context.eps_bearer_id = MME_DEFAULT_EBI;
+  bearer_context.bearer_level_qos.qci = 9;
+  bearer_context.bearer_level_qos.pl = 15;
+  s11_bearer_context_to_be_created_ie_set (&ulp_req.hMsg, &bearer_context);
+
+  session->start_ns = metrics_now_ns ();
+  if (NW_OK != nwGtpv2cProcessUlpReq (mme_stack, &ulp_req)) {
+    metrics_counter_add (mme_errors, 1);
+    return;
+  }
+  session->state = MME_SESSION_CREATING;
+  session->hTunnel = ulp_req.apiInfo.initialReqInfo.hTunnel;
+  metrics_counter_add (mme_metrics[MME_CREATE_SESSION].sent, 1);
+}
+
+//------------------------------------------------------------------------------
+static void mme_send_delete_session_request (mme_session_t * const session)
+{
+  NwGtpv2cUlpApiT                         ulp_req = {0};
+  indication_flags_t                      indication_flags = {0};
+
+  ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
+  if (NW_OK != nwGtpv2cMsgNew (mme_stack, NW_TRUE, NW_GTP_DELETE_SESSION_REQ, session->sgw_teid, 0, &ulp_req.hMsg)) {
+    metrics_counter_add (mme_errors, 1);
+    return;
+  }
+  ulp_req.apiInfo.initialReqInfo.peerIp = mme_config.spgw_s11_address.s_addr;
+  ulp_req.apiInfo.initialReqInfo.teidLocal = session->teid;
+  ulp_req.apiInfo.initialReqInfo.hTunnel = session->hTunnel;
+  ulp_req.apiInfo.initialReqInfo.hUlpTrxn = (NwGtpv2cUlpTrxnHandleT) mme_session_index (session) + 1;
+
+  nwGtpv2cMsgAddIeFteid (ulp_req.hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, S11_MME_GTP_C, session->teid, ntohl (mme_config.s11_address.s_addr), NULL);
+  s11_ebi_ie_set (&ulp_req.hMsg, MME_DEFAULT_EBI);
+  indication_flags.oi = 1;
+  s11_indication_flags_ie_set (&ulp_req.hMsg, &indication_flags);
+
+  session->start_ns = metrics_now_ns ();
+  if (NW_OK != nwGtpv2cProcessUlpReq (mme_stack, &ulp_req)) {
+    metrics_counter_add (mme_errors, 1);
+    return;
+  }
+  session->state = MME_SESSION_DELETING;
+  metrics_counter_add (mme_metrics[MME_DELETE_SESSION].sent, 1);
+}
+
+//------------------------------------------------------------------------------
+static void mme_session_start (mme_session_t * const session)
+{
+  session->state = MME_SESSION_IDLE;
+  if (mme_config.nb_sessions && (mme_created >= mme_config.nb_sessions)) {
+    return;
+  }
+  mme_created++;
+  mme_send_create_session_request (session);
+}
+
+//------------------------------------------------------------------------------
+static int mme_parse_response (const NwGtpv2cUlpApiT * const pUlpApi, gtp_cause_t * const cause, FTeid_t * const sgw_fteid)
+{
+  NwGtpv2cMsgParserT                     *parser = NULL;
+  uint8_t                                 offending_type = 0;
+  uint8_t                                 offending_instance = 0;
+  uint16_t                                offending_length = 0;
+  NwRcT                                   rc = NW_OK;
+
+  if (NW_OK != nwGtpv2cMsgParserNew (mme_stack, pUlpApi->apiInfo.triggeredRspIndInfo.msgType, s11_ie_indication_generic, NULL, &parser)) {
+    return RETURNerror;
+  }
+  // only the IEs the next request needs are read, the other ones are skipped
+  nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+                          s11_cause_ie_get, cause);
+  if (sgw_fteid) {
+    nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+                            s11_fteid_ie_get, sgw_fteid);
+  }
+  rc = nwGtpv2cMsgParserRun (parser, pUlpApi->hMsg, &offending_type, &offending_instance, &offending_length);
+  nwGtpv2cMsgParserDelete (mme_stack, parser);
+  return (NW_OK == rc) ? RETURNok : RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+static void mme_handle_response (NwGtpv2cUlpApiT * const pUlpApi)
+{
+  mme_session_t                          *session = mme_session_of_trxn (pUlpApi->apiInfo.triggeredRspIndInfo.hUlpTrxn);
+  gtp_cause_t                             cause = {0};
+  FTeid_t                                 sgw_fteid = {0};
+  mme_message_t                           message = MME_CREATE_SESSION;
+  int                                     rc = RETURNerror;
+
+  if (!session || (MME_SESSION_IDLE == session->state)) {
+    metrics_counter_add (mme_errors, 1);
+    nwGtpv2cMsgDelete (mme_stack, pUlpApi->hMsg);
+    return;
+  }
+  if (NW_GTP_CREATE_SESSION_RSP == pUlpApi->apiInfo.triggeredRspIndInfo.msgType) {
+    rc = mme_parse_response (pUlpApi, &cause, &sgw_fteid);
+  } else {
+    message = MME_DELETE_SESSION;
+    rc = mme_parse_response (pUlpApi, &cause, NULL);
+  }
+  nwGtpv2cMsgDelete (mme_stack, pUlpApi->hMsg);
+  metrics_histogram_record_since (mme_metrics[message].latency, session->start_ns);
+
+  if ((RETURNok != rc) || (REQUEST_ACCEPTED != cause.cause_value) || ((MME_CREATE_SESSION == message) && !sgw_fteid.teid)) {
+    metrics_counter_add (mme_metrics[message].rejected, 1);
+    // a rejected session is not deleted, the SPGW did not keep it
+    mme_delete_local_tunnel (session);
+    if (MME_DELETE_SESSION == message) {
+      metrics_gauge_add (mme_sessions_gauge, -1);
+    }
+    mme_session_start (session);
+    return;
+  }
+  metrics_counter_add (mme_metrics[message].completed, 1);
+  if (MME_CREATE_SESSION == message) {
+    metrics_gauge_add (mme_sessions_gauge, 1);
+    session->sgw_teid = sgw_fteid.teid;
+    mme_send_delete_session_request (session);
+  } else {
+    metrics_gauge_add (mme_sessions_gauge, -1);
+    mme_delete_local_tunnel (session);
+    mme_session_start (session);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_handle_failure (NwGtpv2cUlpApiT * const pUlpApi)
+{
+  mme_session_t                          *session = mme_session_of_trxn (pUlpApi->apiInfo.rspFailureInfo.hUlpTrxn);
+
+  if (!session || (MME_SESSION_IDLE == session->state)) {
+    return;
+  }
+  // the retransmissions of the stack were not answered, the SPGW may keep the session
+  if (MME_SESSION_CREATING == session->state) {
+    metrics_counter_add (mme_metrics[MME_CREATE_SESSION].timed_out, 1);
+  } else {
+    metrics_counter_add (mme_metrics[MME_DELETE_SESSION].timed_out, 1);
+    metrics_gauge_add (mme_sessions_gauge, -1);
+  }
+  mme_delete_local_tunnel (session);
+  mme_session_start (session);
+}
+
+//------------------------------------------------------------------------------
+static NwRcT mme_ulp_req (NwGtpv2cUlpHandleT hUlp, NwGtpv2cUlpApiT * pUlpApi)
+{
+  switch (pUlpApi->apiType & 0x00FFFFFF) {
+  case NW_GTPV2C_ULP_API_TRIGGERED_RSP_IND:
+    mme_handle_response (pUlpApi);
+    break;
+
+  case NW_GTPV2C_ULP_API_RSP_FAILURE_IND:
+    mme_handle_failure (pUlpApi);
+    break;
+
+  default:
+    // the SPGW initiates nothing the stub handles
+    if (pUlpApi->hMsg) {
+      nwGtpv2cMsgDelete (mme_stack, pUlpApi->hMsg);
+    }
+    break;
+  }
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT mme_udp_data_req (NwGtpv2cUdpHandleT hUdp, uint8_t * dataBuf, uint32_t dataSize, uint32_t peerIp, uint32_t peerPort)
+{
+  struct sockaddr_in                      peer = {0};
+
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons (peerPort);
+  peer.sin_addr.s_addr = peerIp;
+  if (sendto (mme_fd, dataBuf, dataSize, 0, (struct sockaddr *)&peer, sizeof (peer)) < 0) {
+    fprintf (stderr, "sendto: %s\n", strerror (errno));
+    return NW_FAILURE;
+  }
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT mme_timer_start (NwGtpv2cTimerMgrHandleT tmrMgrHandle, uint32_t timeoutSec, uint32_t timeoutUsec, uint32_t tmrType, void *tmrArg,
+                              NwGtpv2cTimerHandleT * tmrHandle)
+{
+  mme_timer.armed = true;
+  mme_timer.due_ns = metrics_now_ns () + timeoutSec * NS_PER_S + timeoutUsec * NS_PER_US;
+  mme_timer.arg = tmrArg;
+  *tmrHandle = (NwGtpv2cTimerHandleT) & mme_timer;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT mme_timer_stop (NwGtpv2cTimerMgrHandleT tmrMgrHandle, NwGtpv2cTimerHandleT tmrHandle)
+{
+  mme_timer.armed = false;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT mme_log_req (NwGtpv2cLogMgrHandleT hLogMgr, uint32_t logLevel, NwCharT * file, uint32_t line, NwCharT * logStr)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static int mme_stack_init (void)
+{
+  NwGtpv2cUlpEntityT                      ulp = {0};
+  NwGtpv2cUdpEntityT                      udp = {0};
+  NwGtpv2cTimerMgrEntityT                 tmr_mgr = {0};
+  NwGtpv2cLogMgrEntityT                   log_mgr = {0};
+
+  if (NW_OK != nwGtpv2cInitialize (&mme_stack)) {
+    return RETURNerror;
+  }
+  ulp.hUlp = (NwGtpv2cUlpHandleT) NULL;
+  ulp.ulpReqCallback = mme_ulp_req;
+  udp.hUdp = (NwGtpv2cUdpHandleT) NULL;
+  udp.udpDataReqCallback = mme_udp_data_req;
+  tmr_mgr.tmrMgrHandle = 0;
+  tmr_mgr.tmrStartCallback = mme_timer_start;
+  tmr_mgr.tmrStopCallback = mme_timer_stop;
+  log_mgr.logMgrHandle = 0;
+  log_mgr.logReqCallback = mme_log_req;
+  if ((NW_OK != nwGtpv2cSetUlpEntity (mme_stack, &ulp)) || (NW_OK != nwGtpv2cSetUdpEntity (mme_stack, &udp)) ||
+      (NW_OK != nwGtpv2cSetTimerMgrEntity (mme_stack, &tmr_mgr)) || (NW_OK != nwGtpv2cSetLogMgrEntity (mme_stack, &log_mgr))) {
+    return RETURNerror;
+  }
+  nwGtpv2cSetLogLevel (mme_stack, NW_LOG_LEVEL_ERRO);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int mme_socket_open (void)
+{
+  struct sockaddr_in                      addr = {0};
+  int                                     buffer_size = 4 * 1024 * 1024;
+
+  if ((mme_fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP)) < 0) {
+    fprintf (stderr, "socket: %s\n", strerror (errno));
+    return RETURNerror;
+  }
+  // the answers to a whole window may arrive at once
+  setsockopt (mme_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof (buffer_size));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (mme_config.port);
+  addr.sin_addr = mme_config.s11_address;
+  if (bind (mme_fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    fprintf (stderr, "bind %s:%u: %s\n", mme_config.address, mme_config.port, strerror (errno));
+    close (mme_fd);
+    mme_fd = -1;
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void mme_receive (void)
+{
+  uint8_t                                 buffer[MME_MAX_DATAGRAM_SIZE];
+  struct sockaddr_in                      peer = {0};
+  socklen_t                               peer_length = 0;
+  ssize_t                                 n = 0;
+
+  for (int d = 0; d < MME_MAX_DATAGRAMS_PER_POLL; d++) {
+    peer_length = sizeof (peer);
+    n = recvfrom (mme_fd, buffer, sizeof (buffer), 0, (struct sockaddr *)&peer, &peer_length);
+    if (n < 0) {
+      if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+        fprintf (stderr, "recvfrom: %s\n", strerror (errno));
+      }
+      return;
+    }
+    if (n < 4) {
+      continue;
+    }
+    nwGtpv2cProcessUdpReq (mme_stack, buffer, n, ntohs (peer.sin_port), peer.sin_addr.s_addr);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_wait (void)
+{
+  struct pollfd                           pfd = {.fd = mme_fd,.events = POLLIN };
+  struct timespec                         timeout = {0};
+  const uint64_t                          now = metrics_now_ns ();
+  uint64_t                                due = now + MME_MAX_POLL_WAIT_NS;
+
+  if (mme_timer.armed && (mme_timer.due_ns < due)) {
+    due = mme_timer.due_ns;
+  }
+  due = (due > now) ? due - now : 0;
+  timeout.tv_sec = due / NS_PER_S;
+  timeout.tv_nsec = due % NS_PER_S;
+  if ((ppoll (&pfd, 1, &timeout, NULL) > 0) && (pfd.revents & POLLIN)) {
+    mme_receive ();
+  }
+  if (mme_timer.armed && (mme_timer.due_ns <= metrics_now_ns ())) {
+    // the stack arms its next timer from the timeout handler
+    mme_timer.armed = false;
+    nwGtpv2cProcessTimeout (mme_timer.arg);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool mme_sessions_in_flight (void)
+{
+  for (uint32_t s = 0; s < mme_config.window; s++) {
+    if (MME_SESSION_IDLE != mme_sessions[s].state) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static void register_metrics (void)
+{
+  char                                    name[128];
+
+  for (int m = 0; m < MME_MESSAGE_MAX; m++) {
+    snprintf (name, sizeof (name), "mme_stub_%s_sent_total", mme_metric_names[m]);
+    mme_metrics[m].sent = metrics_register_counter (name, "Number of requests sent");
+    snprintf (name, sizeof (name), "mme_stub_%s_completed_total", mme_metric_names[m]);
+    mme_metrics[m].completed = metrics_register_counter (name, "Number of requests accepted");
+    snprintf (name, sizeof (name), "mme_stub_%s_rejected_total", mme_metric_names[m]);
+    mme_metrics[m].rejected = metrics_register_counter (name, "Number of requests rejected or with a malformed answer");
+    snprintf (name, sizeof (name), "mme_stub_%s_timed_out_total", mme_metric_names[m]);
+    mme_metrics[m].timed_out = metrics_register_counter (name, "Number of requests not answered after the retransmissions");
+    snprintf (name, sizeof (name), "mme_stub_%s_latency_seconds", mme_metric_names[m]);
+    mme_metrics[m].latency = metrics_register_histogram (name, "Time from the request to its answer");
+  }
+  mme_sessions_gauge = metrics_register_gauge ("mme_stub_sessions", "Number of sessions created on the SPGW and not deleted yet");
+  mme_errors = metrics_register_counter ("mme_stub_errors_total", "Number of requests not sent or answers not matching a request");
+}
+
+//------------------------------------------------------------------------------
+static void signal_handler (int signum)
+{
+  stub_running = false;
+}
+
+//------------------------------------------------------------------------------
+static void report_progress (const uint32_t elapsed_s, int64_t last_completed[MME_MESSAGE_MAX])
+{
+  printf ("%5us sessions %" PRId64, elapsed_s, metrics_get_value (mme_sessions_gauge));
+  for (int m = 0; m < MME_MESSAGE_MAX; m++) {
+    const int64_t                           completed = metrics_get_value (mme_metrics[m].completed);
+
+    printf (" %s/s %" PRId64, mme_message_names[m], completed - last_completed[m]);
+    last_completed[m] = completed;
+  }
+  printf ("\n");
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+static void report_final (const double elapsed_s)
+{
+  metrics_histogram_report_t              report;
+
+  printf ("\n%-10s %10s %10s %10s %10s %10s %9s %9s %9s %9s\n", "message", "sent", "completed", "rejected", "timed out",
+          "per sec", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms");
+  for (int m = 0; m < MME_MESSAGE_MAX; m++) {
+    const int64_t                           completed = metrics_get_value (mme_metrics[m].completed);
+
+    metrics_get_histogram (mme_metrics[m].latency, &report);
+    printf ("%-10s %10" PRId64 " %10" PRId64 " %10" PRId64 " %10" PRId64 " %10.1f %9.2f %9.2f %9.2f %9.2f\n", mme_message_names[m],
+            metrics_get_value (mme_metrics[m].sent), completed, metrics_get_value (mme_metrics[m].rejected),
+            metrics_get_value (mme_metrics[m].timed_out), elapsed_s > 0 ? completed / elapsed_s : 0.0,
+            metrics_histogram_percentile (&report, 50.0) / 1000.0, metrics_histogram_percentile (&report, 90.0) / 1000.0,
+            metrics_histogram_percentile (&report, 99.0) / 1000.0, metrics_histogram_percentile (&report, 99.9) / 1000.0);
+  }
+  printf ("\nsessions %" PRId64 ", errors %" PRId64 "\n", metrics_get_value (mme_sessions_gauge), metrics_get_value (mme_errors));
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int64_t                                 last_completed[MME_MESSAGE_MAX] = {0};
+  uint64_t                                start_ns = 0;
+  uint64_t                                next_report_ns = 0;
+  uint32_t                                elapsed_s = 0;
+
+  if (RETURNok != parse_options (argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  register_metrics ();
+  signal (SIGINT, signal_handler);
+  signal (SIGTERM, signal_handler);
+
+  if (!(mme_sessions = calloc (mme_config.window, sizeof (mme_session_t)))) {
+    fprintf (stderr, "Allocation of a window of %u sessions failed\n", mme_config.window);
+    return EXIT_FAILURE;
+  }
+  if ((RETURNok != mme_stack_init ()) || (RETURNok != mme_socket_open ())) {
+    fprintf (stderr, "S11 not started on %s:%u\n", mme_config.address, mme_config.port);
+    return EXIT_FAILURE;
+  }
+  if (mme_config.metrics_port && (RETURNok != metrics_server_start (NULL, mme_config.metrics_port))) {
+    fprintf (stderr, "Metrics server not started on port %u\n", mme_config.metrics_port);
+  }
+  printf ("Stub MME on %s:%u, SPGW %s, window %u\n", mme_config.address, mme_config.port, mme_config.spgw_address, mme_config.window);
+
+  start_ns = metrics_now_ns ();
+  next_report_ns = start_ns + NS_PER_S;
+  for (uint32_t s = 0; s < mme_config.window; s++) {
+    mme_session_start (&mme_sessions[s]);
+  }
+  while (stub_running) {
+    mme_wait ();
+    if (metrics_now_ns () >= next_report_ns) {
+      next_report_ns += NS_PER_S;
+      elapsed_s = (metrics_now_ns () - start_ns) / NS_PER_S;
+      report_progress (elapsed_s, last_completed);
+      if (mme_config.duration_s && (elapsed_s >= mme_config.duration_s)) {
+        stub_running = false;
+      }
+    }
+    // all the sessions asked for went through
+    if (mme_config.nb_sessions && (mme_created >= mme_config.nb_sessions) && !mme_sessions_in_flight ()) {
+      stub_running = false;
+    }
+  }
+  report_final ((double)(metrics_now_ns () - start_ns) / NS_PER_S);
+
+  metrics_server_stop ();
+  close (mme_fd);
+  nwGtpv2cFinalize (mme_stack);
+  free (mme_sessions);
+  return EXIT_SUCCESS;
+}
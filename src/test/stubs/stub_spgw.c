@@ -0,0 +1,798 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file stub_spgw.c
+  \brief Stub SPGW answering the Create Session, Modify Bearer, Delete
+  Session and Release Access Bearers requests of the MME on S11. The
+  datagrams go through the nwgtpv2c stack like in the MME, the messages are
+  built with the IE formatters of s11_ie_formatter.c. A session only holds
+  the TEIDs of the MME and the bearer ID, the S11 and S1-U TEIDs of the
+  SPGW are the index of the session plus one and the UE address is the
+  base of the pool plus this index. No user plane.
+  The stub runs in a single thread: poll of the S11 socket, expiry of the
+  single timer the stack asks for, then the answers whose latency elapsed.
+  \author
+  \company
+  \email
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "NwLog.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "NwGtpv2cMsgParser.h"
+#include "3gpp_24.008.h"
+#include "s11_messages_types.h"
+#include "s11_common.h"
+#include "s11_ie_formatter.h"
+#include "stubs.h"
+
+#define SPGW_S11_PORT                     2123
+#define SPGW_MAX_DATAGRAM_SIZE            4096
+#define SPGW_MAX_DATAGRAMS_PER_POLL       64
+#define SPGW_MAX_POLL_WAIT_NS             (100 * NS_PER_MS)
+#define SPGW_DELAY_QUEUE_SIZE             (1 << 16)
+
+typedef enum spgw_message_e {
+  SPGW_CREATE_SESSION = 0,
+  SPGW_MODIFY_BEARER,
+  SPGW_DELETE_SESSION,
+  SPGW_RELEASE_ACCESS_BEARERS,
+  SPGW_MESSAGE_MAX,
+} spgw_message_t;
+
+static const char                      *spgw_message_names[SPGW_MESSAGE_MAX] = {
+  "CSR", "MBR", "DSR", "RABR",
+};
+
+static const char                      *spgw_metric_names[SPGW_MESSAGE_MAX] = {
+  "create_session", "modify_bearer", "delete_session", "release_access_bearers",
+};
+
+static const NwGtpv2cMsgTypeT           spgw_response_types[SPGW_MESSAGE_MAX] = {
+  NW_GTP_CREATE_SESSION_RSP, NW_GTP_MODIFY_BEARER_RSP, NW_GTP_DELETE_SESSION_RSP, NW_GTP_RELEASE_ACCESS_BEARERS_RSP,
+};
+
+typedef struct spgw_config_s {
+  const char                             *address;
+  uint16_t                                port;
+  struct in_addr                          s11_address;
+  struct in_addr                          s1u_address;
+  uint32_t                                ue_pool;            // host byte order
+  uint32_t                                nb_sessions;
+  uint32_t                                duration_s;
+  uint16_t                                metrics_port;
+  stub_fault_config_t                     faults;
+} spgw_config_t;
+
+typedef struct spgw_session_s {
+  bool                                    in_use;
+  uint8_t                                 ebi;
+  uint32_t                                mme_teid;
+  NwGtpv2cTunnelHandleT                   hTunnel;
+  uint32_t                                next_free;
+} spgw_session_t;
+
+/*
+ * A request waiting for its answer, what the answer needs is read from the
+ * request when it is received since the stack frees it right after
+ */
+typedef struct spgw_pending_s {
+  NwGtpv2cTrxnHandleT                     hTrxn;
+  spgw_message_t                          message;
+  bool                                    reject;
+  uint32_t                                teid;               // local S11 TEID, 0 for a CSR
+  uint32_t                                mme_teid;           // CSR only
+  uint8_t                                 ebi;
+} spgw_pending_t;
+
+// the stack runs a single timer at a time, the earliest of its transactions
+typedef struct spgw_timer_s {
+  bool                                    armed;
+  uint64_t                                due_ns;
+  void                                   *arg;
+} spgw_timer_t;
+
+static spgw_config_t                    spgw_config = {
+  .address = "127.0.0.2",
+  .port = SPGW_S11_PORT,
+  .nb_sessions = 1 << 20,
+  .duration_s = 0,
+};
+
+static NwGtpv2cStackHandleT             spgw_stack = 0;
+static int                              spgw_fd = -1;
+static spgw_timer_t                     spgw_timer = {0};
+static stub_delay_queue_t               spgw_queue;
+
+static spgw_session_t                  *spgw_sessions = NULL;
+static uint32_t                         spgw_free_session = 0;
+
+// fate of the request being handed to the stack, drawn on the datagram
+static stub_action_t                    spgw_action = STUB_ACTION_ANSWER;
+
+static stub_message_metrics_t           spgw_metrics[SPGW_MESSAGE_MAX];
+static metric_id_t                      spgw_sessions_gauge;
+static metric_id_t                      spgw_errors;
+
+//------------------------------------------------------------------------------
+static void usage (const char *name)
+{
+  fprintf (stderr,
+           "Usage: %s [options]\n"
+           "  -a, --address ADDRESS      S11 address, the SGW S11 address of the MME (%s)\n"
+           "  -p, --port PORT            S11 port (%u)\n"
+           "  -u, --s1u ADDRESS          S1-U address given to the MME, the S11 address by default\n"
+           "  -P, --pool ADDRESS         first UE address (10.0.0.1)\n"
+           "  -s, --sessions N           maximum number of sessions (%u)\n"
+           "  -l, --latency MS[:JITTER]  latency of the answers, plus a uniform jitter\n"
+           "  -r, --reject PERCENT       requests rejected with cause Request rejected\n"
+           "  -D, --drop PERCENT         requests dropped without answer\n"
+           "  -d, --duration N           run duration in seconds, 0 until interrupted (%u)\n"
+           "  -M, --metrics-port PORT    serve the metrics over HTTP on this port\n",
+           name, spgw_config.address, spgw_config.port, spgw_config.nb_sessions, spgw_config.duration_s);
+}
+
+//------------------------------------------------------------------------------
+static int parse_options (int argc, char *argv[])
+{
+  static const struct option              options[] = {
+    {"address", required_argument, NULL, 'a'},
+    {"port", required_argument, NULL, 'p'},
+    {"s1u", required_argument, NULL, 'u'},
+    {"pool", required_argument, NULL, 'P'},
+    {"sessions", required_argument, NULL, 's'},
+    {"latency", required_argument, NULL, 'l'},
+    {"reject", required_argument, NULL, 'r'},
+    {"drop", required_argument, NULL, 'D'},
+    {"duration", required_argument, NULL, 'd'},
+    {"metrics-port", required_argument, NULL, 'M'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  const char                             *s1u = NULL;
+  const char                             *pool = "10.0.0.1";
+  struct in_addr                          ue_pool = {0};
+  int                                     c = 0;
+
+  while ((c = getopt_long (argc, argv, "a:p:u:P:s:l:r:D:d:M:h", options, NULL)) != -1) {
+    switch (c) {
+    case 'a':
+      spgw_config.address = optarg;
+      break;
+    case 'p':
+      spgw_config.port = atoi (optarg);
+      break;
+    case 'u':
+      s1u = optarg;
+      break;
+    case 'P':
+      pool = optarg;
+      break;
+    case 's':
+      spgw_config.nb_sessions = strtoul (optarg, NULL, 0);
+      break;
+    case 'l':
+      if (RETURNok != stub_parse_latency (optarg, &spgw_config.faults)) {
+        fprintf (stderr, "Invalid latency %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'r':
+      if (RETURNok != stub_parse_percent (optarg, &spgw_config.faults.reject_ppm)) {
+        fprintf (stderr, "Invalid reject percentage %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'D':
+      if (RETURNok != stub_parse_percent (optarg, &spgw_config.faults.drop_ppm)) {
+        fprintf (stderr, "Invalid drop percentage %s\n", optarg);
+        return RETURNerror;
+      }
+      break;
+    case 'd':
+      spgw_config.duration_s = strtoul (optarg, NULL, 0);
+      break;
+    case 'M':
+      spgw_config.metrics_port = atoi (optarg);
+      break;
+    default:
+      usage (argv[0]);
+      return RETURNerror;
+    }
+  }
+
+  if (inet_pton (AF_INET, spgw_config.address, &spgw_config.s11_address) != 1) {
+    fprintf (stderr, "Invalid S11 address %s\n", spgw_config.address);
+    return RETURNerror;
+  }
+  spgw_config.s1u_address = spgw_config.s11_address;
+  if (s1u && (inet_pton (AF_INET, s1u, &spgw_config.s1u_address) != 1)) {
+    fprintf (stderr, "Invalid S1-U address %s\n", s1u);
+    return RETURNerror;
+  }
+  if (inet_pton (AF_INET, pool, &ue_pool) != 1) {
+    fprintf (stderr, "Invalid UE pool %s\n", pool);
+    return RETURNerror;
+  }
+  spgw_config.ue_pool = ntohl (ue_pool.s_addr);
+  // the TEIDs are the session index plus one, 0 is not a valid TEID
+  if ((0 == spgw_config.nb_sessions) || (spgw_config.nb_sessions >= UINT32_MAX)) {
+    fprintf (stderr, "Invalid number of sessions %u\n", spgw_config.nb_sessions);
+    return RETURNerror;
+  }
+  if ((spgw_config.faults.reject_ppm + spgw_config.faults.drop_ppm) > STUB_PPM) {
+    fprintf (stderr, "More than 100%% of the requests rejected or dropped\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int spgw_sessions_init (void)
+{
+  spgw_sessions = calloc (spgw_config.nb_sessions, sizeof (spgw_session_t));
+  if (!spgw_sessions) {
+    return RETURNerror;
+  }
+  for (uint32_t s = 0; s < spgw_config.nb_sessions; s++) {
+    spgw_sessions[s].next_free = s + 1;
+  }
+  spgw_free_session = 0;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static spgw_session_t *spgw_session_new (void)
+{
+  spgw_session_t                         *session = NULL;
+
+  if (spgw_free_session >= spgw_config.nb_sessions) {
+    return NULL;
+  }
+  session = &spgw_sessions[spgw_free_session];
+  spgw_free_session = session->next_free;
+  session->in_use = true;
+  metrics_gauge_add (spgw_sessions_gauge, 1);
+  return session;
+}
+
+//------------------------------------------------------------------------------
+static void spgw_session_free (spgw_session_t * const session)
+{
+  memset (session, 0, sizeof (*session));
+  session->next_free = spgw_free_session;
+  spgw_free_session = session - spgw_sessions;
+  metrics_gauge_add (spgw_sessions_gauge, -1);
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t spgw_session_teid (const spgw_session_t * const session)
+{
+  return (uint32_t)(session - spgw_sessions) + 1;
+}
+
+//------------------------------------------------------------------------------
+static spgw_session_t *spgw_session_get (const uint32_t teid)
+{
+  if ((0 == teid) || (teid > spgw_config.nb_sessions) || !spgw_sessions[teid - 1].in_use) {
+    return NULL;
+  }
+  return &spgw_sessions[teid - 1];
+}
+
+//------------------------------------------------------------------------------
+static void spgw_add_bearer_context_created (NwGtpv2cMsgHandleT * hMsg, const spgw_session_t * const session)
+{
+  bearer_context_created_t                bearer_context = {0};
+
+  bearer_context.eps_bearer_id = session->ebi;
+  bearer_context.cause = REQUEST_ACCEPTED;
+  bearer_context.s1u_sgw_fteid.ipv4 = 1;
+  bearer_context.s1u_sgw_fteid.interface_type = S1_U_SGW_GTP_U;
+  bearer_context.s1u_sgw_fteid.teid = spgw_session_teid (session);
+  bearer_context.s1u_sgw_fteid.ipv4_address = spgw_config.s1u_address.s_addr;
+  s11_bearer_context_created_ie_set (hMsg, &bearer_context);
+}
+
+//------------------------------------------------------------------------------
+static void spgw_answer (const spgw_pending_t * const pending)
+{
+  NwGtpv2cUlpApiT                         ulp_req = {0};
+  gtp_cause_t                             cause = {0};
+  spgw_session_t                         *session = NULL;
+  PAA_t                                   paa = {0};
+  uint32_t                                ue_address = 0;
+  NwRcT                                   rc = NW_OK;
+
+  cause.cause_value = pending->reject ? REQUEST_REJECTED : REQUEST_ACCEPTED;
+  if (SPGW_CREATE_SESSION == pending->message) {
+    if (!pending->reject) {
+      if ((session = spgw_session_new ())) {
+        session->mme_teid = pending->mme_teid;
+        session->ebi = pending->ebi;
+      } else {
+        cause.cause_value = NO_RESOURCES_AVAILABLE;
+        metrics_counter_add (spgw_errors, 1);
+      }
+    }
+  } else if (!(session = spgw_session_get (pending->teid))) {
+    // the session was deleted while the request was waiting, or was never created
+    cause.cause_value = CONTEXT_NOT_FOUND;
+    metrics_counter_add (spgw_errors, 1);
+  }
+
+  ulp_req.apiType = NW_GTPV2C_ULP_API_TRIGGERED_RSP;
+  ulp_req.apiInfo.triggeredRspInfo.hTrxn = pending->hTrxn;
+  rc = nwGtpv2cMsgNew (spgw_stack, NW_TRUE, spgw_response_types[pending->message], 0, 0, &ulp_req.hMsg);
+  if (NW_OK != rc) {
+    return;
+  }
+  nwGtpv2cMsgSetTeid (ulp_req.hMsg, session ? session->mme_teid : pending->mme_teid);
+  s11_cause_ie_set (&ulp_req.hMsg, &cause);
+
+  if (REQUEST_ACCEPTED == cause.cause_value) {
+    switch (pending->message) {
+    case SPGW_CREATE_SESSION:
+      nwGtpv2cMsgAddIeFteid (ulp_req.hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, S11_SGW_GTP_C, spgw_session_teid (session),
+                             ntohl (spgw_config.s11_address.s_addr), NULL);
+      nwGtpv2cMsgAddIeFteid (ulp_req.hMsg, NW_GTPV2C_IE_INSTANCE_ONE, S5_S8_PGW_GTP_C, spgw_session_teid (session),
+                             ntohl (spgw_config.s11_address.s_addr), NULL);
+      ue_address = spgw_config.ue_pool + (spgw_session_teid (session) - 1);
+      paa.pdn_type = IPv4;
+      paa.ipv4_address[0] = (uint8_t)(ue_address >> 24);
+      paa.ipv4_address[1] = (uint8_t)(ue_address >> 16);
+      paa.ipv4_address[2] = (uint8_t)(ue_address >> 8);
+      paa.ipv4_address[3] = (uint8_t)(ue_address);
+      s11_paa_ie_set (&ulp_req.hMsg, &paa);
+      s11_apn_restriction_ie_set (&ulp_req.hMsg, 0);
+      spgw_add_bearer_context_created (&ulp_req.hMsg, session);
+      // the later requests of the MME are sent on the S11 TEID of the session
+      ulp_req.apiType |= NW_GTPV2C_ULP_API_FLAG_CREATE_LOCAL_TUNNEL;
+      ulp_req.apiInfo.triggeredRspInfo.teidLocal = spgw_session_teid (session);
+      ulp_req.apiInfo.triggeredRspInfo.hUlpTunnel = (NwGtpv2cUlpTunnelHandleT) spgw_session_teid (session);
+      break;
+
+    case SPGW_MODIFY_BEARER:
+      if (pending->ebi) {
+        session->ebi = pending->ebi;
+      }
+      spgw_add_bearer_context_created (&ulp_req.hMsg, session);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  rc = nwGtpv2cProcessUlpReq (spgw_stack, &ulp_req);
+  if (!session) {
+    return;
+  }
+  if ((SPGW_CREATE_SESSION == pending->message) && (REQUEST_ACCEPTED == cause.cause_value)) {
+    if ((NW_OK != rc) || !ulp_req.apiInfo.triggeredRspInfo.hTunnel) {
+      fprintf (stderr, "S11 tunnel of TEID %u not created\n", spgw_session_teid (session));
+    }
+    session->hTunnel = ulp_req.apiInfo.triggeredRspInfo.hTunnel;
+  } else if (SPGW_DELETE_SESSION == pending->message) {
+    // the MME releases the session whatever the answer, so does the stub
+    if (session->hTunnel) {
+      memset (&ulp_req, 0, sizeof (ulp_req));
+      ulp_req.apiType = NW_GTPV2C_ULP_DELETE_LOCAL_TUNNEL;
+      ulp_req.apiInfo.deleteLocalTunnelInfo.hTunnel = session->hTunnel;
+      nwGtpv2cProcessUlpReq (spgw_stack, &ulp_req);
+    }
+    spgw_session_free (session);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int spgw_parse_request (const NwGtpv2cUlpApiT * const pUlpApi, spgw_pending_t * const pending)
+{
+  NwGtpv2cMsgParserT                     *parser = NULL;
+  bearer_contexts_to_be_created_t         created = {0};
+  bearer_contexts_to_be_modified_t        modified = {0};
+  FTeid_t                                 sender_fteid = {0};
+  uint8_t                                 offending_type = 0;
+  uint8_t                                 offending_instance = 0;
+  uint16_t                                offending_length = 0;
+  NwRcT                                   rc = NW_OK;
+
+  if (NW_OK != nwGtpv2cMsgParserNew (spgw_stack, pUlpApi->apiInfo.initialReqIndInfo.msgType, s11_ie_indication_generic, NULL, &parser)) {
+    return RETURNerror;
+  }
+  // only the IEs the answer needs are read, the other ones are skipped
+  if (SPGW_CREATE_SESSION == pending->message) {
+    nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+                            s11_fteid_ie_get, &sender_fteid);
+    nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+                            s11_bearer_context_to_be_created_ie_get, &created);
+  } else if (SPGW_MODIFY_BEARER == pending->message) {
+    nwGtpv2cMsgParserAddIe (parser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+                            s11_bearer_context_to_be_modified_ie_get, &modified);
+  }
+  rc = nwGtpv2cMsgParserRun (parser, pUlpApi->hMsg, &offending_type, &offending_instance, &offending_length);
+  nwGtpv2cMsgParserDelete (spgw_stack, parser);
+  if (NW_OK != rc) {
+    return RETURNerror;
+  }
+
+  if (SPGW_CREATE_SESSION == pending->message) {
+    pending->mme_teid = sender_fteid.teid;
+    pending->ebi = created.num_bearer_context ? created.bearer_contexts[0].eps_bearer_id : 5;
+  } else {
+    pending->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
+    pending->ebi = modified.num_bearer_context ? modified.bearer_contexts[0].eps_bearer_id : 0;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int spgw_message_of_request (const NwGtpv2cMsgTypeT msg_type)
+{
+  switch (msg_type) {
+  case NW_GTP_CREATE_SESSION_REQ:
+    return SPGW_CREATE_SESSION;
+  case NW_GTP_MODIFY_BEARER_REQ:
+    return SPGW_MODIFY_BEARER;
+  case NW_GTP_DELETE_SESSION_REQ:
+    return SPGW_DELETE_SESSION;
+  case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
+    return SPGW_RELEASE_ACCESS_BEARERS;
+  default:
+    return -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void spgw_handle_request (NwGtpv2cUlpApiT * const pUlpApi)
+{
+  spgw_pending_t                          pending = {0};
+  spgw_pending_t                         *delayed = NULL;
+  uint64_t                                delay_ns = 0;
+  const int                               message = spgw_message_of_request (pUlpApi->apiInfo.initialReqIndInfo.msgType);
+
+  if (message < 0) {
+    nwGtpv2cMsgDelete (spgw_stack, pUlpApi->hMsg);
+    return;
+  }
+  pending.hTrxn = pUlpApi->apiInfo.initialReqIndInfo.hTrxn;
+  pending.message = message;
+  pending.reject = (STUB_ACTION_REJECT == spgw_action);
+  if (RETURNok != spgw_parse_request (pUlpApi, &pending)) {
+    // answered at once, a malformed request is not part of the test
+    pending.reject = true;
+    metrics_counter_add (spgw_errors, 1);
+    nwGtpv2cMsgDelete (spgw_stack, pUlpApi->hMsg);
+    spgw_answer (&pending);
+    return;
+  }
+  nwGtpv2cMsgDelete (spgw_stack, pUlpApi->hMsg);
+
+  delay_ns = stub_draw_delay_ns (&spgw_config.faults);
+  if (0 == delay_ns) {
+    spgw_answer (&pending);
+    return;
+  }
+  // the transaction of the request stays in the stack until it is answered
+  delayed = malloc (sizeof (*delayed));
+  if (delayed) {
+    *delayed = pending;
+    if (RETURNok == stub_delay_queue_push (&spgw_queue, metrics_now_ns () + delay_ns, delayed)) {
+      return;
+    }
+    free (delayed);
+  }
+  spgw_answer (&pending);
+}
+
+//------------------------------------------------------------------------------
+static NwRcT spgw_ulp_req (NwGtpv2cUlpHandleT hUlp, NwGtpv2cUlpApiT * pUlpApi)
+{
+  switch (pUlpApi->apiType & 0x00FFFFFF) {
+  case NW_GTPV2C_ULP_API_INITIAL_REQ_IND:
+    spgw_handle_request (pUlpApi);
+    break;
+
+  default:
+    // no request is sent, there is neither response nor failure to handle
+    if (pUlpApi->hMsg) {
+      nwGtpv2cMsgDelete (spgw_stack, pUlpApi->hMsg);
+    }
+    break;
+  }
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT spgw_udp_data_req (NwGtpv2cUdpHandleT hUdp, uint8_t * dataBuf, uint32_t dataSize, uint32_t peerIp, uint32_t peerPort)
+{
+  struct sockaddr_in                      peer = {0};
+
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons (peerPort);
+  peer.sin_addr.s_addr = peerIp;
+  if (sendto (spgw_fd, dataBuf, dataSize, 0, (struct sockaddr *)&peer, sizeof (peer)) < 0) {
+    fprintf (stderr, "sendto: %s\n", strerror (errno));
+    return NW_FAILURE;
+  }
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT spgw_timer_start (NwGtpv2cTimerMgrHandleT tmrMgrHandle, uint32_t timeoutSec, uint32_t timeoutUsec, uint32_t tmrType, void *tmrArg,
+                               NwGtpv2cTimerHandleT * tmrHandle)
+{
+  spgw_timer.armed = true;
+  spgw_timer.due_ns = metrics_now_ns () + timeoutSec * NS_PER_S + timeoutUsec * NS_PER_US;
+  spgw_timer.arg = tmrArg;
+  *tmrHandle = (NwGtpv2cTimerHandleT) & spgw_timer;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT spgw_timer_stop (NwGtpv2cTimerMgrHandleT tmrMgrHandle, NwGtpv2cTimerHandleT tmrHandle)
+{
+  spgw_timer.armed = false;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static NwRcT spgw_log_req (NwGtpv2cLogMgrHandleT hLogMgr, uint32_t logLevel, NwCharT * file, uint32_t line, NwCharT * logStr)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static int spgw_stack_init (void)
+{
+  NwGtpv2cUlpEntityT                      ulp = {0};
+  NwGtpv2cUdpEntityT                      udp = {0};
+  NwGtpv2cTimerMgrEntityT                 tmr_mgr = {0};
+  NwGtpv2cLogMgrEntityT                   log_mgr = {0};
+
+  if (NW_OK != nwGtpv2cInitialize (&spgw_stack)) {
+    return RETURNerror;
+  }
+  ulp.hUlp = (NwGtpv2cUlpHandleT) NULL;
+  ulp.ulpReqCallback = spgw_ulp_req;
+  udp.hUdp = (NwGtpv2cUdpHandleT) NULL;
+  udp.udpDataReqCallback = spgw_udp_data_req;
+  tmr_mgr.tmrMgrHandle = 0;
+  tmr_mgr.tmrStartCallback = spgw_timer_start;
+  tmr_mgr.tmrStopCallback = spgw_timer_stop;
+  log_mgr.logMgrHandle = 0;
+  log_mgr.logReqCallback = spgw_log_req;
+  if ((NW_OK != nwGtpv2cSetUlpEntity (spgw_stack, &ulp)) || (NW_OK != nwGtpv2cSetUdpEntity (spgw_stack, &udp)) ||
+      (NW_OK != nwGtpv2cSetTimerMgrEntity (spgw_stack, &tmr_mgr)) || (NW_OK != nwGtpv2cSetLogMgrEntity (spgw_stack, &log_mgr))) {
+    return RETURNerror;
+  }
+  nwGtpv2cSetLogLevel (spgw_stack, NW_LOG_LEVEL_ERRO);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int spgw_socket_open (void)
+{
+  struct sockaddr_in                      addr = {0};
+  int                                     buffer_size = 4 * 1024 * 1024;
+
+  if ((spgw_fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP)) < 0) {
+    fprintf (stderr, "socket: %s\n", strerror (errno));
+    return RETURNerror;
+  }
+  // bursts of attaches must not overflow the receive buffer
+  setsockopt (spgw_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof (buffer_size));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (spgw_config.port);
+  addr.sin_addr = spgw_config.s11_address;
+  if (bind (spgw_fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    fprintf (stderr, "bind %s:%u: %s\n", spgw_config.address, spgw_config.port, strerror (errno));
+    close (spgw_fd);
+    spgw_fd = -1;
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void spgw_receive (void)
+{
+  uint8_t                                 buffer[SPGW_MAX_DATAGRAM_SIZE];
+  struct sockaddr_in                      peer = {0};
+  socklen_t                               peer_length = 0;
+  ssize_t                                 n = 0;
+  int                                     message = 0;
+
+  for (int d = 0; d < SPGW_MAX_DATAGRAMS_PER_POLL; d++) {
+    peer_length = sizeof (peer);
+    n = recvfrom (spgw_fd, buffer, sizeof (buffer), 0, (struct sockaddr *)&peer, &peer_length);
+    if (n < 0) {
+      if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+        fprintf (stderr, "recvfrom: %s\n", strerror (errno));
+      }
+      return;
+    }
+    if (n < 4) {
+      continue;
+    }
+    /*
+     * The fate of a request is drawn before the stack sees it: a dropped
+     * request must not leave a transaction behind, a retransmission of the
+     * MME is drawn again like a new request
+     */
+    spgw_action = STUB_ACTION_ANSWER;
+    if ((message = spgw_message_of_request (buffer[1])) >= 0) {
+      spgw_action = stub_draw_action (&spgw_config.faults, &spgw_metrics[message]);
+      if (STUB_ACTION_DROP == spgw_action) {
+        continue;
+      }
+    }
+    nwGtpv2cProcessUdpReq (spgw_stack, buffer, n, ntohs (peer.sin_port), peer.sin_addr.s_addr);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void spgw_run_due (void)
+{
+  const uint64_t                          now = metrics_now_ns ();
+  spgw_pending_t                         *pending = NULL;
+
+  if (spgw_timer.armed && (spgw_timer.due_ns <= now)) {
+    // the stack arms its next timer from the timeout handler
+    spgw_timer.armed = false;
+    nwGtpv2cProcessTimeout (spgw_timer.arg);
+  }
+  while ((pending = stub_delay_queue_pop (&spgw_queue, now))) {
+    spgw_answer (pending);
+    free (pending);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void spgw_wait (void)
+{
+  struct pollfd                           pfd = {.fd = spgw_fd,.events = POLLIN };
+  struct timespec                         timeout = {0};
+  const uint64_t                          now = metrics_now_ns ();
+  uint64_t                                due = now + SPGW_MAX_POLL_WAIT_NS;
+  uint64_t                                next = stub_delay_queue_next (&spgw_queue);
+
+  if (spgw_timer.armed && (spgw_timer.due_ns < due)) {
+    due = spgw_timer.due_ns;
+  }
+  if (next < due) {
+    due = next;
+  }
+  due = (due > now) ? due - now : 0;
+  timeout.tv_sec = due / NS_PER_S;
+  timeout.tv_nsec = due % NS_PER_S;
+  if ((ppoll (&pfd, 1, &timeout, NULL) > 0) && (pfd.revents & POLLIN)) {
+    spgw_receive ();
+  }
+}
+
+//------------------------------------------------------------------------------
+static void register_metrics (void)
+{
+  for (int m = 0; m < SPGW_MESSAGE_MAX; m++) {
+    stub_register_message_metrics ("spgw_stub", spgw_metric_names[m], &spgw_metrics[m]);
+  }
+  spgw_sessions_gauge = metrics_register_gauge ("spgw_stub_sessions", "Number of sessions of the stub SPGW");
+  spgw_errors = metrics_register_counter ("spgw_stub_errors_total", "Number of requests answered with an error that was not injected");
+}
+
+//------------------------------------------------------------------------------
+static void signal_handler (int signum)
+{
+  stub_running = false;
+}
+
+//------------------------------------------------------------------------------
+static void report_progress (const uint32_t elapsed_s, int64_t last_received[SPGW_MESSAGE_MAX])
+{
+  printf ("%5us sessions %" PRId64, elapsed_s, metrics_get_value (spgw_sessions_gauge));
+  for (int m = 0; m < SPGW_MESSAGE_MAX; m++) {
+    const int64_t                           received = metrics_get_value (spgw_metrics[m].received);
+
+    printf (" %s/s %" PRId64, spgw_message_names[m], received - last_received[m]);
+    last_received[m] = received;
+  }
+  printf ("\n");
+  fflush (stdout);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int64_t                                 last_received[SPGW_MESSAGE_MAX] = {0};
+  uint64_t                                start_ns = 0;
+  uint64_t                                next_report_ns = 0;
+  uint32_t                                elapsed_s = 0;
+  spgw_pending_t                         *pending = NULL;
+
+  if (RETURNok != parse_options (argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  register_metrics ();
+  signal (SIGINT, signal_handler);
+  signal (SIGTERM, signal_handler);
+
+  if ((RETURNok != spgw_sessions_init ()) || (RETURNok != stub_delay_queue_init (&spgw_queue, SPGW_DELAY_QUEUE_SIZE))) {
+    fprintf (stderr, "Allocation of %u sessions failed\n", spgw_config.nb_sessions);
+    return EXIT_FAILURE;
+  }
+  if ((RETURNok != spgw_stack_init ()) || (RETURNok != spgw_socket_open ())) {
+    fprintf (stderr, "S11 not started on %s:%u\n", spgw_config.address, spgw_config.port);
+    return EXIT_FAILURE;
+  }
+  if (spgw_config.metrics_port && (RETURNok != metrics_server_start (NULL, spgw_config.metrics_port))) {
+    fprintf (stderr, "Metrics server not started on port %u\n", spgw_config.metrics_port);
+  }
+  printf ("Stub SPGW on %s:%u, latency %.3f ms jitter %.3f ms, reject %.2f%% drop %.2f%%\n", spgw_config.address, spgw_config.port,
+          spgw_config.faults.latency_us / 1000.0, spgw_config.faults.jitter_us / 1000.0, spgw_config.faults.reject_ppm / 10000.0,
+          spgw_config.faults.drop_ppm / 10000.0);
+
+  start_ns = metrics_now_ns ();
+  next_report_ns = start_ns + NS_PER_S;
+  while (stub_running) {
+    spgw_wait ();
+    spgw_run_due ();
+    if (metrics_now_ns () >= next_report_ns) {
+      next_report_ns += NS_PER_S;
+      elapsed_s = (metrics_now_ns () - start_ns) / NS_PER_S;
+      report_progress (elapsed_s, last_received);
+      if (spgw_config.duration_s && (elapsed_s >= spgw_config.duration_s)) {
+        stub_running = false;
+      }
+    }
+  }
+  stub_report_messages (spgw_message_names, spgw_metrics, SPGW_MESSAGE_MAX, (double)(metrics_now_ns () - start_ns) / NS_PER_S);
+  printf ("\nsessions %" PRId64 ", errors %" PRId64 "\n", metrics_get_value (spgw_sessions_gauge), metrics_get_value (spgw_errors));
+
+  metrics_server_stop ();
+  while ((pending = stub_delay_queue_pop (&spgw_queue, UINT64_MAX))) {
+    free (pending);
+  }
+  stub_delay_queue_free (&spgw_queue);
+  close (spgw_fd);
+  nwGtpv2cFinalize (spgw_stack);
+  free (spgw_sessions);
+  return EXIT_SUCCESS;
+}
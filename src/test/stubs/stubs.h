@@ -0,0 +1,127 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file stubs.h
+  \brief Stub HSS and SPGW answering the MME on S6a and S11, for performance
+  tests of the MME on a single host. The answers can be delayed by a fixed
+  latency plus a random jitter, a share of the requests can be rejected with
+  an error cause or dropped without answer. The stub MME does the reverse,
+  it loads the SPGW on S11.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_STUBS_SEEN
+#define FILE_STUBS_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "metrics.h"
+
+#define NS_PER_US                         1000ULL
+#define NS_PER_MS                         1000000ULL
+#define NS_PER_S                          1000000000ULL
+
+// probabilities are in parts per million of the requests
+#define STUB_PPM                          1000000
+
+typedef struct stub_fault_config_s {
+  uint32_t                                latency_us;         // added to every answer
+  uint32_t                                jitter_us;          // uniform in [0, jitter]
+  uint32_t                                reject_ppm;         // answered with an error cause
+  uint32_t                                drop_ppm;           // never answered
+} stub_fault_config_t;
+
+typedef enum stub_action_e {
+  STUB_ACTION_ANSWER = 0,
+  STUB_ACTION_REJECT,
+  STUB_ACTION_DROP,
+} stub_action_t;
+
+typedef struct stub_message_metrics_s {
+  metric_id_t                             received;
+  metric_id_t                             answered;
+  metric_id_t                             rejected;
+  metric_id_t                             dropped;
+} stub_message_metrics_t;
+
+/*
+ * Answers waiting for their latency, min heap on the due time. The queue is
+ * locked, the HSS pushes from the dispatch threads of freeDiameter.
+ */
+typedef struct stub_delayed_s {
+  uint64_t                                due_ns;
+  void                                   *item;
+} stub_delayed_t;
+
+typedef struct stub_delay_queue_s {
+  pthread_mutex_t                         mutex;
+  pthread_cond_t                          cond;
+  uint32_t                                size;
+  uint32_t                                capacity;
+  stub_delayed_t                         *heap;
+} stub_delay_queue_t;
+
+extern volatile bool                    stub_running;
+
+//------------------------------------------------------------------------------
+// stub_common.c
+
+// "MS" or "MS:JITTER_MS", fractions of milliseconds allowed
+int stub_parse_latency (const char * const arg, stub_fault_config_t * const config);
+
+// "PERCENT", fractions allowed
+int stub_parse_percent (const char * const arg, uint32_t * const ppm);
+
+// exactly 2 * length hexadecimal digits, for the K and OPc
+int stub_parse_hex (const char * const arg, uint8_t * const bytes, const int length);
+
+void stub_register_message_metrics (const char * const stub, const char * const message, stub_message_metrics_t * const metrics);
+
+// draws the fate of a request, counts it
+stub_action_t stub_draw_action (const stub_fault_config_t * const config, const stub_message_metrics_t * const metrics);
+
+// latency of an answer, jitter drawn
+uint64_t stub_draw_delay_ns (const stub_fault_config_t * const config);
+
+uint64_t stub_random (void);
+
+int stub_delay_queue_init (stub_delay_queue_t * const queue, const uint32_t capacity);
+void stub_delay_queue_free (stub_delay_queue_t * const queue);
+
+// RETURNerror if the queue is full
+int stub_delay_queue_push (stub_delay_queue_t * const queue, const uint64_t due_ns, void * const item);
+
+// the earliest item due at now_ns, NULL if none
+void *stub_delay_queue_pop (stub_delay_queue_t * const queue, const uint64_t now_ns);
+
+// due time of the earliest item, UINT64_MAX if the queue is empty
+uint64_t stub_delay_queue_next (stub_delay_queue_t * const queue);
+
+// blocks until an item is due or until max_wait_ns elapsed, NULL in the latter case
+void *stub_delay_queue_wait (stub_delay_queue_t * const queue, const uint64_t max_wait_ns);
+
+void stub_report_messages (const char * const names[], const stub_message_metrics_t metrics[], const int nb_messages, const double elapsed_s);
+
+#endif /* FILE_STUBS_SEEN */
@@ -0,0 +1,172 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * The NAS COUNT used by nas_message_encrypt and nas_message_decrypt for
+ * EEA1 and EEA2 (TS 33.401 section 8.1.1): 0x00 || NAS OVERFLOW || NAS SQN.
+ * The ciphered octets are compared with the stream cipher run directly on
+ * a COUNT whose overflow and sequence number are neither 0 nor 1.
+ * EEA1 ciphers its input in place by words of 4 octets, so the messages are
+ * copied into buffers of a multiple of 4 octets.
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "3gpp_24.301.h"
+#include "NasSecurityAlgorithms.h"
+#include "emmData.h"
+#include "nas_message.h"
+#include "secu_defs.h"
+
+#define COUNT_TEST_OVERFLOW  0x0102
+#define COUNT_TEST_SEQ_NUM   0x34
+#define COUNT_TEST_COUNT     0x00010234
+#define COUNT_TEST_HEADER_LENGTH  6
+
+static const uint8_t                    plain[] = {
+  0x07, 0x62, 0x11, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11
+};
+
+static void count_test_context (emm_security_context_t * ctx, uint8_t encryption)
+{
+  memset (ctx, 0, sizeof (*ctx));
+  for (int i = 0; i < AUTH_KNAS_ENC_SIZE; i++) {
+    ctx->knas_enc[i] = 0x10 + i;
+  }
+  ctx->selected_algorithms.encryption = encryption;
+  ctx->selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA0;
+}
+
+static void count_test_cipher (emm_security_context_t * ctx, uint8_t encryption, uint8_t direction, uint8_t * out, size_t length)
+{
+  nas_stream_cipher_t                     stream_cipher;
+  uint8_t                                 in[sizeof (plain)];
+
+  memcpy (in, plain, sizeof (plain));
+  stream_cipher.key = ctx->knas_enc;
+  stream_cipher.key_length = AUTH_KNAS_ENC_SIZE;
+  stream_cipher.count = COUNT_TEST_COUNT;
+  stream_cipher.bearer = 0x00;
+  stream_cipher.direction = direction;
+  stream_cipher.message = in;
+  stream_cipher.blength = length << 3;
+  if (NAS_SECURITY_ALGORITHMS_EEA1 == encryption) {
+    nas_stream_encrypt_eea1 (&stream_cipher, out);
+  } else {
+    nas_stream_encrypt_eea2 (&stream_cipher, out);
+  }
+}
+
+static void count_test_encrypt (uint8_t encryption)
+{
+  emm_security_context_t                  ctx;
+  nas_message_security_header_t           header;
+  uint8_t                                 in[sizeof (plain)];
+  uint8_t                                 out[COUNT_TEST_HEADER_LENGTH + sizeof (plain)];
+  uint8_t                                 expected[sizeof (plain)];
+
+  count_test_context (&ctx, encryption);
+  ctx.dl_count.overflow = COUNT_TEST_OVERFLOW;
+  ctx.dl_count.seq_num = COUNT_TEST_SEQ_NUM;
+  memset (&header, 0, sizeof (header));
+  header.protocol_discriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  header.security_header_type = SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED;
+  header.sequence_number = COUNT_TEST_SEQ_NUM;
+
+  memcpy (in, plain, sizeof (plain));
+  ck_assert_int_eq(nas_message_encrypt (in, out, &header, sizeof (out), &ctx), sizeof (out));
+  count_test_cipher (&ctx, encryption, SECU_DIRECTION_DOWNLINK, expected, sizeof (plain));
+  ck_assert_int_eq(out[COUNT_TEST_HEADER_LENGTH - 1], COUNT_TEST_SEQ_NUM);
+  ck_assert_msg(0 == memcmp (out + COUNT_TEST_HEADER_LENGTH, expected, sizeof (plain)), "downlink ciphered with a wrong COUNT");
+}
+
+START_TEST(nas_message_count_encrypt_eea1_test)
+{
+  count_test_encrypt (NAS_SECURITY_ALGORITHMS_EEA1);
+}
+END_TEST
+
+START_TEST(nas_message_count_encrypt_eea2_test)
+{
+  count_test_encrypt (NAS_SECURITY_ALGORITHMS_EEA2);
+}
+END_TEST
+
+START_TEST(nas_message_count_decrypt_eea2_test)
+{
+  emm_security_context_t                  ctx;
+  nas_message_security_header_t           header;
+  nas_message_decode_status_t             status;
+  uint8_t                                 in[COUNT_TEST_HEADER_LENGTH + sizeof (plain)];
+  uint8_t                                 out[sizeof (in)];
+
+  count_test_context (&ctx, NAS_SECURITY_ALGORITHMS_EEA2);
+  ctx.ul_count.overflow = COUNT_TEST_OVERFLOW;
+  ctx.ul_count.seq_num = COUNT_TEST_SEQ_NUM - 1;
+  // header with a null MAC, that EIA0 matches
+  memset (in, 0, COUNT_TEST_HEADER_LENGTH);
+  in[0] = (SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED << 4) | EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  in[COUNT_TEST_HEADER_LENGTH - 1] = COUNT_TEST_SEQ_NUM;
+  count_test_cipher (&ctx, NAS_SECURITY_ALGORITHMS_EEA2, SECU_DIRECTION_UPLINK, in + COUNT_TEST_HEADER_LENGTH, sizeof (plain));
+
+  memset (&header, 0, sizeof (header));
+  memset (&status, 0, sizeof (status));
+  ck_assert_int_eq(nas_message_decrypt (in, out, &header, sizeof (in), &ctx, &status), sizeof (plain));
+  ck_assert_int_eq(ctx.ul_count.overflow, COUNT_TEST_OVERFLOW);
+  ck_assert_msg(0 == memcmp (out, plain, sizeof (plain)), "uplink deciphered with a wrong COUNT");
+}
+END_TEST
+
+Suite * nas_message_count_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("NAS message COUNT tests");
+
+    tc_core = tcase_create("NAS message COUNT test");
+    tcase_add_test(tc_core, nas_message_count_encrypt_eea1_test);
+    tcase_add_test(tc_core, nas_message_count_encrypt_eea2_test);
+    tcase_add_test(tc_core, nas_message_count_decrypt_eea2_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = nas_message_count_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
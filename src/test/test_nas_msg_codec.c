@@ -0,0 +1,269 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * The codecs of nas/emm/msg on a corpus of Attach Request, Attach Accept and
+ * Tracking Area Update Request bodies (the octets following the message type):
+ * round trip byte for byte, truncated messages, unknown IEI, a length octet
+ * pointing past the end of the message and identities shorter than their
+ * longest encoding.
+ */
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "TLVDecoder.h"
+#include "emm_msg.h"
+
+#define CORPUS_MESSAGE_MAX_LENGTH  128
+
+typedef struct corpus_message_s {
+  const char                             *name;
+  uint8_t                                 message_type;
+  uint32_t                                length;
+  uint8_t                                 bytes[CORPUS_MESSAGE_MAX_LENGTH];
+} corpus_message_t;
+
+static const corpus_message_t           corpus[] = {
+  {"attach request, IMSI", ATTACH_REQUEST, 27,
+   {0x71,
+    0x08, 0x09, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98, 0xf0,
+    0x02, 0xe0, 0xe0,
+    0x00, 0x0c, 0x02, 0x01, 0xd0, 0x11, 0xd1, 0x27, 0x05, 0x80, 0x80, 0x21, 0x10, 0x01}},
+  {"attach request, GUTI and optional IEs", ATTACH_REQUEST, 54,
+   {0x12,
+    0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x04, 0x01, 0xde, 0xad, 0xbe, 0xef,
+    0x05, 0xe0, 0xe0, 0xc0, 0x40, 0x19,
+    0x00, 0x04, 0x02, 0x01, 0xd0, 0x11,
+    0x52, 0x02, 0xf8, 0x39, 0x00, 0x01,
+    0x5c, 0x0a, 0x00,
+    0x31, 0x03, 0xe5, 0xe0, 0x34,
+    0x13, 0x02, 0xf8, 0x39, 0x00, 0x01,
+    0x91,
+    0x11, 0x03, 0x57, 0x58, 0xa6,
+    0x5d, 0x01, 0x00}},
+  {"attach request, type 1 IEs", ATTACH_REQUEST, 22,
+   {0x02,
+    0x08, 0x09, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98, 0xf0,
+    0x02, 0xe0, 0xe0,
+    0x00, 0x02, 0xd0, 0x11,
+    0x19, 0x01, 0x02, 0x03,
+    0xe1}},
+  {"attach accept, GUTI", ATTACH_ACCEPT, 37,
+   {0x01,
+    0x29,
+    0x06, 0x00, 0x02, 0xf8, 0x39, 0x00, 0x01,
+    0x00, 0x06, 0x52, 0x01, 0xc1, 0x01, 0x09, 0x08,
+    0x50, 0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x04, 0x01, 0xde, 0xad, 0xbe, 0xef,
+    0x17, 0x2c,
+    0x59, 0x49,
+    0x64, 0x01, 0x01}},
+  {"attach accept, two TACs and EMM cause", ATTACH_ACCEPT, 25,
+   {0x02,
+    0x49,
+    0x08, 0x01, 0x02, 0xf8, 0x39, 0x00, 0x01, 0x00, 0x02,
+    0x00, 0x04, 0x52, 0x05, 0xc1, 0x01,
+    0x13, 0x02, 0xf8, 0x39, 0x00, 0x01,
+    0x53, 0x12}},
+  {"tracking area update request", TRACKING_AREA_UPDATE_REQUEST, 13,
+   {0x70,
+    0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x04, 0x01, 0xde, 0xad, 0xbe, 0xef}},
+  {"tracking area update request, optional IEs", TRACKING_AREA_UPDATE_REQUEST, 41,
+   {0x21,
+    0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x04, 0x01, 0xde, 0xad, 0xbe, 0xef,
+    0x55, 0x01, 0x02, 0x03, 0x04,
+    0x58, 0x02, 0xe0, 0xe0,
+    0x52, 0x02, 0xf8, 0x39, 0x00, 0x01,
+    0x5c, 0x0a, 0x00,
+    0xa1,
+    0x57, 0x02, 0x20, 0x00,
+    0x31, 0x03, 0xe5, 0xe0, 0x34}},
+};
+
+#define CORPUS_SIZE  (sizeof (corpus) / sizeof (corpus[0]))
+
+static int corpus_decode (const uint8_t message_type, EMM_msg * msg, uint8_t *buffer, uint32_t len)
+{
+  switch (message_type) {
+  case ATTACH_REQUEST:
+    return decode_attach_request (&msg->attach_request, buffer, len);
+  case ATTACH_ACCEPT:
+    return decode_attach_accept (&msg->attach_accept, buffer, len);
+  default:
+    return decode_tracking_area_update_request (&msg->tracking_area_update_request, buffer, len);
+  }
+}
+
+static int corpus_encode (const uint8_t message_type, EMM_msg * msg, uint8_t *buffer, uint32_t len)
+{
+  switch (message_type) {
+  case ATTACH_REQUEST:
+    return encode_attach_request (&msg->attach_request, buffer, len);
+  case ATTACH_ACCEPT:
+    return encode_attach_accept (&msg->attach_accept, buffer, len);
+  default:
+    return encode_tracking_area_update_request (&msg->tracking_area_update_request, buffer, len);
+  }
+}
+
+START_TEST(nas_msg_codec_round_trip_test)
+{
+  for (int i = 0; i < CORPUS_SIZE; i++) {
+    const corpus_message_t *c = &corpus[i];
+    uint8_t buffer[CORPUS_MESSAGE_MAX_LENGTH];
+    uint8_t out[CORPUS_MESSAGE_MAX_LENGTH];
+    EMM_msg msg;
+    int rc;
+
+    memset (&msg, 0, sizeof (msg));
+    memcpy (buffer, c->bytes, c->length);
+    rc = corpus_decode (c->message_type, &msg, buffer, c->length);
+    ck_assert_msg(rc == c->length, "%s: %d decoded, expected %u", c->name, rc, c->length);
+
+    // the decoded message encodes back to the corpus byte for byte
+    rc = corpus_encode (c->message_type, &msg, out, sizeof (out));
+    ck_assert_msg(rc == c->length, "%s: %d encoded, expected %u", c->name, rc, c->length);
+    ck_assert_msg(0 == memcmp (out, c->bytes, c->length), "%s: encoded octets differ", c->name);
+  }
+}
+END_TEST
+
+START_TEST(nas_msg_codec_truncated_test)
+{
+  for (int i = 0; i < CORPUS_SIZE; i++) {
+    const corpus_message_t *c = &corpus[i];
+
+    for (uint32_t length = 0; length < c->length; length++) {
+      // exactly sized so that an overread is caught by valgrind or ASan
+      uint8_t *buffer = malloc (length ? length : 1);
+      EMM_msg msg;
+      int rc;
+
+      memcpy (buffer, c->bytes, length);
+      memset (&msg, 0, sizeof (msg));
+      rc = corpus_decode (c->message_type, &msg, buffer, length);
+      // a message cut between two optional IEs is valid
+      ck_assert_msg((rc < 0) || (rc == length), "%s cut at %u: returned %d", c->name, length, rc);
+      free (buffer);
+    }
+  }
+}
+END_TEST
+
+START_TEST(nas_msg_codec_unknown_iei_test)
+{
+  uint8_t buffer[CORPUS_MESSAGE_MAX_LENGTH];
+  EMM_msg msg;
+
+  memcpy (buffer, corpus[0].bytes, corpus[0].length);
+  buffer[corpus[0].length] = 0x7e;
+  buffer[corpus[0].length + 1] = 0x00;
+  memset (&msg, 0, sizeof (msg));
+  ck_assert_int_eq(decode_attach_request (&msg.attach_request, buffer, corpus[0].length + 2), TLV_UNEXPECTED_IEI);
+
+  // a length octet pointing past the end of the message
+  memcpy (buffer, corpus[1].bytes, corpus[1].length);
+  buffer[corpus[1].length - 2] = 0x7f;
+  memset (&msg, 0, sizeof (msg));
+  ck_assert(decode_attach_request (&msg.attach_request, buffer, corpus[1].length) < 0);
+}
+END_TEST
+
+START_TEST(nas_msg_codec_short_identity_test)
+{
+  // 13 digit IMSI in 7 octets, then an even 12 digit IMSI, TMSI in 5 octets
+  const uint8_t imsi_odd[] = {0x07, 0x09, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98};
+  const uint8_t imsi_even[] = {0x07, 0x01, 0x10, 0x10, 0x32, 0x54, 0x76, 0xf8};
+  const uint8_t imsi_no_end_mark[] = {0x07, 0x01, 0x10, 0x10, 0x32, 0x54, 0x76, 0x98};
+  const uint8_t tmsi[] = {0x05, 0xf4, 0xde, 0xad, 0xbe, 0xef};
+  EpsMobileIdentity eps_id;
+  MobileIdentity id;
+  uint8_t *buffer;
+
+  // exactly sized, the identity is the last IE of the message
+  buffer = malloc (sizeof (imsi_odd));
+  memcpy (buffer, imsi_odd, sizeof (imsi_odd));
+  memset (&eps_id, 0, sizeof (eps_id));
+  ck_assert_int_eq(decode_eps_mobile_identity (&eps_id, 0, buffer, sizeof (imsi_odd)), sizeof (imsi_odd));
+  ck_assert_int_eq(eps_id.imsi.digit13, 9);
+  ck_assert_int_eq(eps_id.imsi.digit14, 0xf);
+  memset (&id, 0, sizeof (id));
+  ck_assert_int_eq(decode_mobile_identity (&id, 0, buffer, sizeof (imsi_odd)), sizeof (imsi_odd));
+  ck_assert_int_eq(id.imsi.digit13, 9);
+  free (buffer);
+
+  buffer = malloc (sizeof (imsi_even));
+  memcpy (buffer, imsi_even, sizeof (imsi_even));
+  ck_assert_int_eq(decode_eps_mobile_identity (&eps_id, 0, buffer, sizeof (imsi_even)), sizeof (imsi_even));
+  ck_assert_int_eq(eps_id.imsi.digit12, 8);
+  memcpy (buffer, imsi_no_end_mark, sizeof (imsi_no_end_mark));
+  ck_assert_int_eq(decode_eps_mobile_identity (&eps_id, 0, buffer, sizeof (imsi_no_end_mark)), TLV_VALUE_DOESNT_MATCH);
+  ck_assert_int_eq(decode_mobile_identity (&id, 0, buffer, sizeof (imsi_no_end_mark)), TLV_VALUE_DOESNT_MATCH);
+  free (buffer);
+
+  buffer = malloc (sizeof (tmsi));
+  memcpy (buffer, tmsi, sizeof (tmsi));
+  memset (&id, 0, sizeof (id));
+  ck_assert_int_eq(decode_mobile_identity (&id, 0, buffer, sizeof (tmsi)), sizeof (tmsi));
+  ck_assert_int_eq(id.tmsi.digit2, 0xe);
+  ck_assert_int_eq(id.tmsi.digit10, 0xf);
+  // a GUTI needs all of its octets
+  buffer[1] = 0xf6;
+  ck_assert_int_eq(decode_eps_mobile_identity (&eps_id, 0, buffer, sizeof (tmsi)), TLV_VALUE_DOESNT_MATCH);
+  free (buffer);
+}
+END_TEST
+
+Suite * nas_msg_codec_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("NAS message codec tests");
+
+    tc_core = tcase_create("NAS message codec test");
+    tcase_add_test(tc_core, nas_msg_codec_round_trip_test);
+    tcase_add_test(tc_core, nas_msg_codec_truncated_test);
+    tcase_add_test(tc_core, nas_msg_codec_unknown_iei_test);
+    tcase_add_test(tc_core, nas_msg_codec_short_identity_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = nas_msg_codec_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -43,6 +43,7 @@
 #  define PRINT_HASHTABLE(...)
 #endif
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
 char                                   *
 hashtable_rc_code2string (
   hashtable_rc_t rcP)
@@ -94,17 +95,7 @@ static inline hash_size_t def_hashfunc (const uint64_t keyP)
 }
 
 //------------------------------------------------------------------------------
-/*
-   Initialization
-   hashtable_create() set up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
-   The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
-   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
-*/
-hash_table_t * hashtable_init (hash_table_t * const hashtblP,
-    const hash_size_t sizeP,
-    hash_size_t (*hashfuncP) (const hash_key_t),
-    void (*freefuncP) (void **),
-    bstring display_name_pP)
+static hash_size_t hashtable_upper_power_of_two (const hash_size_t sizeP)
 {
   hash_size_t size = sizeP;
   // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
@@ -117,13 +108,91 @@ hash_table_t * hashtable_init (hash_table_t * const hashtblP,
   // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
   // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
   // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
+  if (0 == size) {
+    return 1;
+  }
   size--;
   size |= size >> 1;
   size |= size >> 2;
   size |= size >> 4;
   size |= size >> 8;
   size |= size >> 16;
+  size |= (size >> 16) >> 16;
   size++;
+  return size;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Returns the link pointing to the node of key keyP, searching the current bucket array and, if a resize
+   is in progress, the bucket array being migrated. NULL if the key is not in the table.
+*/
+static inline hash_node_t ** hashtable_find_link (
+  hash_node_t ** const nodesP,
+  const hash_size_t sizeP,
+  hash_node_t ** const old_nodesP,
+  const hash_size_t old_sizeP,
+  const hash_size_t hashP,
+  const hash_key_t keyP)
+{
+  hash_node_t                           **link = &nodesP[hashP % sizeP];
+
+  while (*link) {
+    if ((*link)->key == keyP) {
+      return link;
+    }
+    link = &(*link)->next;
+  }
+  if (old_nodesP) {
+    link = &old_nodesP[hashP % old_sizeP];
+    while (*link) {
+      if ((*link)->key == keyP) {
+        return link;
+      }
+      link = &(*link)->next;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Moves all nodes of one bucket of the old bucket array to their bucket in the new bucket array.
+*/
+static inline void hashtable_migrate_bucket (
+  hash_node_t ** const old_bucketP,
+  hash_node_t ** const nodesP,
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP) (const hash_key_t))
+{
+  hash_node_t                            *node = *old_bucketP;
+  hash_node_t                            *next = NULL;
+  hash_size_t                             hash = 0;
+
+  while (node) {
+    next = node->next;
+    hash = hashfuncP (node->key) % sizeP;
+    node->next = nodesP[hash];
+    nodesP[hash] = node;
+    node = next;
+  }
+  *old_bucketP = NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_create() set up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
+   The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
+   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
+*/
+hash_table_t * hashtable_init (hash_table_t * const hashtblP,
+    const hash_size_t sizeP,
+    hash_size_t (*hashfuncP) (const hash_key_t),
+    void (*freefuncP) (void **),
+    bstring display_name_pP)
+{
+  hash_size_t size = hashtable_upper_power_of_two (sizeP);
 
   if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_t *)))) {
     free_wrapper((void **) &hashtblP);
@@ -133,6 +202,9 @@ hash_table_t * hashtable_init (hash_table_t * const hashtblP,
 
   PRINT_HASHTABLE (hashtblP, "allocated nodes\n");
   hashtblP->size = size;
+  hashtblP->old_nodes = NULL;
+  hashtblP->old_size = 0;
+  hashtblP->migrate_index = 0;
 
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
@@ -185,6 +257,8 @@ hashtable_create (
    hashtable_ts_create() sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
    If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
+   Buckets are protected by lock stripes: there are at most HASH_TABLE_TS_MAX_LOCK_STRIPES locks, a key is protected by lock hash % lock_count.
+   Since sizes are powers of two never below lock_count, a key keeps the same lock whatever the size of the table.
 */
 hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
     const hash_size_t sizeP,
@@ -192,24 +266,7 @@ hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
     void (*freefuncP) (void **),
     bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
+  hash_size_t size = hashtable_upper_power_of_two (sizeP);
 
   memset(hashtblP, 0, sizeof(*hashtblP));
 
@@ -218,7 +275,8 @@ hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
     return NULL;
   }
 
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
+  hashtblP->lock_count = (size > HASH_TABLE_TS_MAX_LOCK_STRIPES) ? HASH_TABLE_TS_MAX_LOCK_STRIPES : size;
+  if (!(hashtblP->lock_nodes = calloc (hashtblP->lock_count, sizeof (pthread_mutex_t)))) {
     free_wrapper((void **) &hashtblP->nodes);
     free_wrapper((void **) &hashtblP->name);
     free_wrapper((void **) &hashtblP);
@@ -226,7 +284,7 @@ hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
   }
 
   pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
+  for (int i = 0; i < hashtblP->lock_count; i++) {
     pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
   }
 
@@ -277,6 +335,147 @@ hashtable_ts_create (
   return hashtbl;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Incremental resize
+   Moves at most max_bucketsP buckets of the bucket array being migrated to the current bucket array.
+   When the last bucket has been moved the old bucket array is released.
+*/
+static void
+hashtable_migrate (
+  hash_table_t * const hashtblP,
+  const hash_size_t max_bucketsP)
+{
+  hash_size_t                             n = 0;
+
+  while ((hashtblP->old_nodes) && (n < max_bucketsP)) {
+    hashtable_migrate_bucket (&hashtblP->old_nodes[hashtblP->migrate_index], hashtblP->nodes, hashtblP->size, hashtblP->hashfunc);
+    hashtblP->migrate_index += 1;
+    n += 1;
+    if (hashtblP->migrate_index == hashtblP->old_size) {
+      free_wrapper((void **) &hashtblP->old_nodes);
+      hashtblP->old_size = 0;
+      hashtblP->migrate_index = 0;
+      PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Allocates a new bucket array of sizeP buckets, the current one is kept aside for being migrated incrementally.
+   A resize still in progress is completed first.
+*/
+static hashtable_rc_t
+hashtable_start_resize (
+  hash_table_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  hash_node_t                           **nodes = NULL;
+
+  hashtable_migrate (hashtblP, SIZE_MAX);
+  if (sizeP == hashtblP->size) {
+    return HASH_TABLE_OK;
+  }
+  if (!(nodes = calloc (sizeP, sizeof (hash_node_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->migrate_index = 0;
+  hashtblP->nodes = nodes;
+  hashtblP->size = sizeP;
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Incremental resize of the thread safe table, must be called with hashtblP->mutex locked.
+   Each bucket is moved under its lock stripe, the old and the new bucket of a key share the same stripe.
+*/
+static void
+hashtable_ts_migrate (
+  hash_table_ts_t * const hashtblP,
+  const hash_size_t max_bucketsP)
+{
+  hash_size_t                             n = 0;
+  hash_node_t                           **old_nodes = NULL;
+  pthread_mutex_t                        *lock = NULL;
+
+  while ((hashtblP->old_nodes) && (n < max_bucketsP)) {
+    lock = &hashtblP->lock_nodes[hashtblP->migrate_index % hashtblP->lock_count];
+    pthread_mutex_lock (lock);
+    hashtable_migrate_bucket (&hashtblP->old_nodes[hashtblP->migrate_index], hashtblP->nodes, hashtblP->size, hashtblP->hashfunc);
+    pthread_mutex_unlock (lock);
+    hashtblP->migrate_index += 1;
+    n += 1;
+    if (hashtblP->migrate_index == hashtblP->old_size) {
+      // all stripes, no reader may still be looking at the old bucket array
+      for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+        pthread_mutex_lock (&hashtblP->lock_nodes[i]);
+      }
+      old_nodes = hashtblP->old_nodes;
+      hashtblP->old_nodes = NULL;
+      hashtblP->old_size = 0;
+      hashtblP->migrate_index = 0;
+      for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+        pthread_mutex_unlock (&hashtblP->lock_nodes[i]);
+      }
+      free_wrapper((void **) &old_nodes);
+      PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Must be called with hashtblP->mutex locked and no lock stripe held.
+   Only the switch of bucket arrays is done with all lock stripes held, its cost does not depend on the number of elements.
+*/
+static hashtable_rc_t
+hashtable_ts_start_resize (
+  hash_table_ts_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  hash_node_t                           **nodes = NULL;
+  hash_size_t                             size = (sizeP < hashtblP->lock_count) ? hashtblP->lock_count : sizeP;
+
+  hashtable_ts_migrate (hashtblP, SIZE_MAX);
+  if (size == hashtblP->size) {
+    return HASH_TABLE_OK;
+  }
+  if (!(nodes = calloc (size, sizeof (hash_node_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+    pthread_mutex_lock (&hashtblP->lock_nodes[i]);
+  }
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->migrate_index = 0;
+  hashtblP->nodes = nodes;
+  hashtblP->size = size;
+  for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+    pthread_mutex_unlock (&hashtblP->lock_nodes[i]);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Bounded amount of resize work done by insert/remove operations of the thread safe table.
+   Skipped if another thread is already migrating buckets.
+*/
+static inline void
+hashtable_ts_migrate_step (
+  hash_table_ts_t * const hashtblP)
+{
+  if ((hashtblP->old_nodes) && (0 == pthread_mutex_trylock (&hashtblP->mutex))) {
+    hashtable_ts_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+    pthread_mutex_unlock (&hashtblP->mutex);
+  }
+}
+
 //------------------------------------------------------------------------------
 /*
    Cleanup
@@ -286,16 +485,14 @@ hashtable_rc_t
 hashtable_destroy (
   hash_table_t * hashtblP)
 {
-  hash_size_t                             n = 0;
-  hash_node_t                            *node = NULL,
-                                         *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    node = hashtblP->nodes[n];
+  hashtable_migrate (hashtblP, SIZE_MAX);
+  for (hash_size_t n = 0; n < hashtblP->size; ++n) {
+    hash_node_t                          *node = hashtblP->nodes[n];
+    hash_node_t                          *oldnode = NULL;
 
     while (node) {
       oldnode = node;
@@ -326,33 +523,35 @@ hashtable_rc_t
 hashtable_ts_destroy (
   hash_table_ts_t * hashtblP)
 {
-  hash_size_t                             n = 0;
-  hash_node_t                            *node = NULL,
-                                         *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
+  pthread_mutex_lock (&hashtblP->mutex);
+  hashtable_ts_migrate (hashtblP, SIZE_MAX);
+  pthread_mutex_unlock (&hashtblP->mutex);
+  for (hash_size_t s = 0; s < hashtblP->lock_count; ++s) {
+    pthread_mutex_lock (&hashtblP->lock_nodes[s]);
+    for (hash_size_t n = s; n < hashtblP->size; n += hashtblP->lock_count) {
+      hash_node_t                        *node = hashtblP->nodes[n];
+      hash_node_t                        *oldnode = NULL;
 
-    while (node) {
-      oldnode = node;
-      node = node->next;
+      while (node) {
+        oldnode = node;
+        node = node->next;
 
-      if (oldnode->data) {
-        hashtblP->freefunc (&oldnode->data);
-      }
+        if (oldnode->data) {
+          hashtblP->freefunc (&oldnode->data);
+        }
 
-      free_wrapper((void **) &oldnode);
+        free_wrapper((void **) &oldnode);
+      }
     }
-
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
+    pthread_mutex_unlock (&hashtblP->lock_nodes[s]);
+    pthread_mutex_destroy (&hashtblP->lock_nodes[s]);
   }
 
+  pthread_mutex_destroy (&hashtblP->mutex);
   free_wrapper((void **) &hashtblP->nodes);
   free_wrapper((void **) &hashtblP->lock_nodes);
   bdestroy(hashtblP->name);
@@ -370,23 +569,16 @@ hashtable_is_key_exists (
   const hash_table_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
+  hash_node_t                           **link = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hashtblP->hashfunc (keyP), keyP);
+  if (link) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -400,27 +592,23 @@ hashtable_ts_is_key_exists (
   const hash_table_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
+  pthread_mutex_t                        *lock = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock (lock);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
+  pthread_mutex_unlock (lock);
+  if (link) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -442,6 +630,8 @@ hashtable_apply_callback_on_elements (
   void **resultP)
 {
   hash_node_t                            *node = NULL;
+  hash_node_t                           **nodes[2] = {NULL, NULL};
+  hash_size_t                             sizes[2] = {0, 0};
   unsigned int                            i = 0;
   unsigned int                            num_elements = 0;
 
@@ -449,19 +639,26 @@ hashtable_apply_callback_on_elements (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          return HASH_TABLE_OK;
+  nodes[0] = hashtblP->nodes;
+  sizes[0] = hashtblP->size;
+  nodes[1] = hashtblP->old_nodes;
+  sizes[1] = hashtblP->old_size;
+  for (int t = 0; t < 2; t++) {
+    i = 0;
+    while ((num_elements < hashtblP->num_elements) && (i < sizes[t])) {
+      if (nodes[t][i] != NULL) {
+        node = nodes[t][i];
+
+        while (node) {
+          num_elements++;
+          if (funct_cb (node->key, node->data, parameterP, resultP)) {
+            return HASH_TABLE_OK;
+          }
+          node = node->next;
         }
-        node = node->next;
       }
+      i++;
     }
-    i++;
   }
 
   return HASH_TABLE_OK;
@@ -471,6 +668,7 @@ hashtable_apply_callback_on_elements (
 // may cost a lot CPU...
 // Also useful if we want to find an element in the collection based on compare criteria different than the single key
 // The compare criteria in implemented in the funct_cb function
+// The table is walked lock stripe by lock stripe, the elements of a stripe are in the same buckets whatever the table size.
 hashtable_rc_t
 hashtable_ts_apply_callback_on_elements (
   hash_table_ts_t * const hashtblP,
@@ -482,29 +680,34 @@ hashtable_ts_apply_callback_on_elements (
   void** resultP)
 {
   hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
+  hash_size_t                             s = 0;
   unsigned int                            num_elements = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
+  while ((num_elements < hashtblP->num_elements) && (s < hashtblP->lock_count)) {
+    pthread_mutex_lock(&hashtblP->lock_nodes[s]);
+    hash_node_t                         **nodes[2] = {hashtblP->nodes, hashtblP->old_nodes};
+    hash_size_t                           sizes[2] = {hashtblP->size, hashtblP->old_size};
+
+    for (int t = 0; t < 2; t++) {
+      for (hash_size_t i = s; i < sizes[t]; i += hashtblP->lock_count) {
+        node = nodes[t][i];
+
+        while (node) {
+          num_elements++;
+          if (funct_cb (node->key, node->data, parameterP, resultP)) {
+            pthread_mutex_unlock(&hashtblP->lock_nodes[s]);
+            return HASH_TABLE_OK;
+          }
+          node = node->next;
         }
-        node = node->next;
       }
     }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
+    pthread_mutex_unlock(&hashtblP->lock_nodes[s]);
+    s++;
   }
 
   return HASH_TABLE_OK;
@@ -518,6 +721,8 @@ hashtable_dump_content (
   bstring str)
 {
   hash_node_t                            *node = NULL;
+  hash_node_t                           **nodes[2] = {NULL, NULL};
+  hash_size_t                             sizes[2] = {0, 0};
   unsigned int                            i = 0;
 
   if (!hashtblP) {
@@ -525,23 +730,30 @@ hashtable_dump_content (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
+  nodes[0] = hashtblP->nodes;
+  sizes[0] = hashtblP->size;
+  nodes[1] = hashtblP->old_nodes;
+  sizes[1] = hashtblP->old_size;
+  for (int t = 0; t < 2; t++) {
+    i = 0;
+    while (i < sizes[t]) {
+      if (nodes[t][i] != NULL) {
+        node = nodes[t][i];
+
+        while (node) {
+          bstring b0 = bformat("Key 0x%"PRIx64" Element %p Node %p\n", node->key, node->data, node);
+          if (!b0) {
+            PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+          } else {
+            bconcat(str, b0);
+            bdestroy(b0);
+          }
+          node = node->next;
 
-      while (node) {
-        bstring b0 = bformat("Key 0x%"PRIx64" Element %p Node %p\n", node->key, node->data, node);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy(b0);
         }
-        node = node->next;
-
       }
+      i += 1;
     }
-    i += 1;
   }
   return HASH_TABLE_OK;
 }
@@ -553,32 +765,37 @@ hashtable_ts_dump_content (
   bstring str)
 {
   hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
+  hash_size_t                             s = 0;
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
+  while (s < hashtblP->lock_count) {
+    pthread_mutex_lock(&hashtblP->lock_nodes[s]);
+    hash_node_t                         **nodes[2] = {hashtblP->nodes, hashtblP->old_nodes};
+    hash_size_t                           sizes[2] = {hashtblP->size, hashtblP->old_size};
+
+    for (int t = 0; t < 2; t++) {
+      for (hash_size_t i = s; i < sizes[t]; i += hashtblP->lock_count) {
+        node = nodes[t][i];
+
+        while (node) {
+          bstring b0 = bformat ("Key 0x%"PRIx64" Element %p Node %p Next %p\n", node->key, node->data, node, node->next);
+          if (!b0) {
+            PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+          } else {
+            bconcat(str, b0);
+            bdestroy(b0);
+          }
+          node = node->next;
 
-      while (node) {
-        bstring b0 = bformat ("Key 0x%"PRIx64" Element %p Node %p Next %p\n", node->key, node->data, node, node->next);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy(b0);
         }
-        node = node->next;
-
       }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
     }
-    i += 1;
+    pthread_mutex_unlock(&hashtblP->lock_nodes[s]);
+    s += 1;
   }
   return HASH_TABLE_OK;
 }
@@ -589,6 +806,7 @@ hashtable_ts_dump_content (
 /*
    Adding a new element
    To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   New elements always go in the current bucket array. The table grows when the load factor is exceeded.
 */
 hashtable_rc_t
 hashtable_insert (
@@ -597,44 +815,42 @@ hashtable_insert (
   void *dataP)
 {
   hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
+  hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  hash = hashtblP->hashfunc (keyP);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
 
-      node->data = dataP;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  if (link) {
+    node = *link;
+    if (node->data) {
+      hashtblP->freefunc (&node->data);
     }
 
-    node = node->next;
+    node->data = dataP;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
   }
 
   if (!(node = malloc (sizeof (hash_node_t))))
-    return -1;
+    return HASH_TABLE_SYSTEM_ERROR;
 
   node->key = keyP;
   node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
+  hash = hash % hashtblP->size;
+  node->next = hashtblP->nodes[hash];
   hashtblP->nodes[hash] = node;
   hashtblP->num_elements += 1;
 
+  if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)) {
+    hashtable_start_resize (hashtblP, hashtblP->size << 1);
+  }
+
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
   return HASH_TABLE_OK;
 }
@@ -644,6 +860,7 @@ hashtable_insert (
 /*
    Adding a new element
    To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   New elements always go in the current bucket array. The table grows when the load factor is exceeded.
 */
 hashtable_rc_t
 hashtable_ts_insert (
@@ -652,53 +869,53 @@ hashtable_ts_insert (
   void *dataP)
 {
   hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
+  pthread_mutex_t                        *lock = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
 
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  if (link) {
+    node = *link;
+    if (node->data) {
+      hashtblP->freefunc (&node->data);
     }
-
-    node = node->next;
+    node->data = dataP;
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
   }
 
-  if (!(node = malloc (sizeof (hash_node_t))))
-    return -1;
+  if (!(node = malloc (sizeof (hash_node_t)))) {
+    pthread_mutex_unlock(lock);
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
 
   node->key = keyP;
   node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
+  hash = hash % hashtblP->size;
+  node->next = hashtblP->nodes[hash];
   hashtblP->nodes[hash] = node;
   __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
-#define TEMPORARY_DEBUG 1
-#if TEMPORARY_DEBUG
-  bstring b = bfromcstr(" ");
-  hashtable_ts_dump_content(hashtblP, b);
-  PRINT_HASHTABLE (hashtblP, "%s:%s\n", bdata(hashtblP->name), bdata(b));
-  bdestroy(b);
-#endif
+  pthread_mutex_unlock(lock);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+
+  // unlocked reads are only a hint, checked again under the table mutex
+  if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)
+      && (0 == pthread_mutex_trylock (&hashtblP->mutex))) {
+    if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)) {
+      hashtable_ts_start_resize (hashtblP, hashtblP->size << 1);
+    }
+    pthread_mutex_unlock (&hashtblP->mutex);
+  }
   return HASH_TABLE_OK;
 }
 
@@ -714,36 +931,28 @@ hashtable_free (
   hash_table_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
+  hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hashtblP->hashfunc (keyP), keyP);
 
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
+  if (link) {
+    node = *link;
+    *link = node->next;
 
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
+    if (node->data) {
+      hashtblP->freefunc (&node->data);
     }
 
-    prevnode = node;
-    node = node->next;
+    free_wrapper((void **) &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -761,42 +970,38 @@ hashtable_ts_free (
   hash_table_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
+  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
+  pthread_mutex_t                        *lock = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
 
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
+  if (link) {
+    node = *link;
+    *link = node->next;
 
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
+    if (node->data) {
+      hashtblP->freefunc (&node->data);
     }
 
-    prevnode = node;
-    node = node->next;
+    free_wrapper((void **) &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
 
-   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  pthread_mutex_unlock(lock);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -813,33 +1018,24 @@ hashtable_remove (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      *dataP = node->data;
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hashtblP->hashfunc (keyP), keyP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    *dataP = node->data;
+    free_wrapper((void **) &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -858,37 +1054,32 @@ hashtable_ts_remove (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
+  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
+  pthread_mutex_t                        *lock = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      *dataP = node->data;
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    *dataP = node->data;
+    free_wrapper((void **) &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -906,25 +1097,18 @@ hashtable_get (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
+  hash_node_t                           **link = NULL;
 
   *dataP = NULL;
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hashtblP->hashfunc (keyP), keyP);
+  if (link) {
+    *dataP = (*link)->data;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
@@ -943,39 +1127,27 @@ hashtable_ts_get (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node = NULL;
+  hash_node_t                           **link = NULL;
   hash_size_t                             hash = 0;
+  pthread_mutex_t                        *lock = NULL;
 
   *dataP = NULL;
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = hashtable_find_link (hashtblP->nodes, hashtblP->size, hashtblP->old_nodes, hashtblP->old_size, hash, keyP);
+  if (link) {
+    *dataP = (*link)->data;
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-
-#define TEMPORARY_DEBUG 1
-#if TEMPORARY_DEBUG
-  bstring b = bfromcstr(" ");
-  hashtable_ts_dump_content(hashtblP, b);
-  PRINT_HASHTABLE (hashtblP, "%s:%s\n", bdata(hashtblP->name), bdata(b));
-  bdestroy(b);
-#endif
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -986,9 +1158,8 @@ hashtable_ts_get (
    If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
    If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
    Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_insert() and hashtable_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
+   The new bucket array is allocated here, the elements are then moved a few buckets at a time by the following insert/remove operations,
+   so that no single operation pays for rehashing the whole table.
 */
 
 hashtable_rc_t
@@ -996,53 +1167,10 @@ hashtable_resize (
   hash_table_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_t                            newtbl;
-  hash_size_t                             n;
-  hash_node_t                            *node,
-                                         *next;
-  void                                   *dummy = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_t *))))
-    return -1;
-
-
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_remove (hashtblP, node->key, &dummy);
-      hashtable_insert (&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->size = newtbl.size;
-  return HASH_TABLE_OK;
+  return hashtable_start_resize (hashtblP, hashtable_upper_power_of_two (sizeP));
 }
 
 
@@ -1053,10 +1181,8 @@ hashtable_resize (
    If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
    If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
    Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_insert() and hashtable_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   The new bucket array is allocated here, the elements are then moved a few buckets at a time by the following insert/remove operations,
+   so that no single operation pays for rehashing the whole table. The table never shrinks below its number of lock stripes.
 */
 
 hashtable_rc_t
@@ -1064,62 +1190,13 @@ hashtable_ts_resize (
   hash_table_ts_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_ts_t                         newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n      = 0;
-  hash_node_t                            *node   = NULL,
-                                         *next   = NULL;
-  void                                   *dummy  = NULL;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper((void **) &newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
   pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_ts_remove (hashtblP, node->key, &dummy);
-      hashtable_ts_insert (&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
+  rc = hashtable_ts_start_resize (hashtblP, hashtable_upper_power_of_two (sizeP));
   pthread_mutex_unlock(&hashtblP->mutex);
-  return HASH_TABLE_OK;
+  return rc;
 }
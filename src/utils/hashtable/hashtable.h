@@ -57,6 +57,24 @@ typedef enum hashtable_return_code_e {
 #define HASH_TABLE_DEFAULT_HASH_FUNC NULL
 #define HASH_TABLE_DEFAULT_free_wrapper_FUNC NULL
 
+/*
+ * Tables grow automatically (x2) when the number of elements exceeds
+ * HASH_TABLE_MAX_LOAD_FACTOR times the number of buckets. The rehash is
+ * incremental: the previous bucket array is kept aside and each insert/remove
+ * moves at most HASH_TABLE_MIGRATE_BUCKETS_PER_OP of its buckets to the new
+ * array, lookups search both arrays until the migration is complete.
+ */
+#ifndef HASH_TABLE_MAX_LOAD_FACTOR
+#  define HASH_TABLE_MAX_LOAD_FACTOR        1
+#endif
+#ifndef HASH_TABLE_MIGRATE_BUCKETS_PER_OP
+#  define HASH_TABLE_MIGRATE_BUCKETS_PER_OP 8
+#endif
+// Thread safe tables lock stripes of buckets, a key always maps to the same stripe whatever the table size.
+#ifndef HASH_TABLE_TS_MAX_LOCK_STRIPES
+#  define HASH_TABLE_TS_MAX_LOCK_STRIPES    1024
+#endif
+
 
 typedef struct hash_node_s {
     hash_key_t          key;
@@ -69,6 +87,9 @@ typedef struct hash_table_s {
     hash_size_t         size;
     hash_size_t         num_elements;
     struct hash_node_s **nodes;
+    struct hash_node_s **old_nodes;     // bucket array being migrated, NULL if no resize in progress
+    hash_size_t         old_size;
+    hash_size_t         migrate_index;  // next bucket of old_nodes to migrate
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -81,7 +102,11 @@ typedef struct hash_table_ts_s {
     hash_size_t         size;
     hash_size_t         num_elements;
     struct hash_node_s **nodes;
+    struct hash_node_s **old_nodes;     // bucket array being migrated, NULL if no resize in progress
+    hash_size_t         old_size;
+    hash_size_t         migrate_index;  // next bucket of old_nodes to migrate, protected by mutex
     pthread_mutex_t     *lock_nodes;
+    hash_size_t         lock_count;     // number of lock stripes, power of two, never above size
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -31,6 +31,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
 #include "obj_hashtable.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
@@ -53,38 +55,110 @@ obj_hashtable_no_free_key_callback (
 //------------------------------------------------------------------------------
 /*
    Default hash function
-   def_hashfunc() is the default used by hashtable_create() when the user didn't specify one.
-   This is a simple/naive hash function which adds the key's ASCII char values. It will probably generate lots of collisions on large hash tables.
+   obj_hashtable_hash() is the default used by obj_hashtable_create() when the user didn't specify one.
+   It follows the construction of wyhash: keys are read 4 or 8 bytes at a time and mixed with 64x64->128 bits
+   multiplications. The process seed, drawn when the first table is created, makes collisions unpredictable
+   from keys received from the network.
 */
+#define OBJ_HASH_P0 0xa0761d6478bd642fULL
+#define OBJ_HASH_P1 0xe7037ed1a0b428dbULL
+#define OBJ_HASH_P2 0x8ebc6af09c88c6e3ULL
+#define OBJ_HASH_P3 0x589965cc75374cc3ULL
 
-static                                  hash_size_t
-def_hashfunc (
+uint64_t                                obj_hashtable_seed = 0;
+
+static inline uint64_t obj_hash_mix (const uint64_t aP, const uint64_t bP)
+{
+  __uint128_t                             r = (__uint128_t)aP * bP;
+
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t obj_hash_read8 (const uint8_t * const p)
+{
+  uint64_t                                v;
+
+  memcpy (&v, p, sizeof (v));
+  return v;
+}
+
+static inline uint64_t obj_hash_read4 (const uint8_t * const p)
+{
+  uint32_t                                v;
+
+  memcpy (&v, p, sizeof (v));
+  return v;
+}
+
+hash_size_t
+obj_hashtable_hash (
   const void *const keyP,
   int key_sizeP)
 {
-  hash_size_t                             hash = 0;
+  const uint8_t                          *p = (const uint8_t *)keyP;
+  size_t                                  len = (key_sizeP > 0) ? key_sizeP : 0;
+  size_t                                  i = len;
+  uint64_t                                seed = obj_hashtable_seed ^ obj_hash_mix (obj_hashtable_seed ^ OBJ_HASH_P0, OBJ_HASH_P1);
+  uint64_t                                a = 0;
+  uint64_t                                b = 0;
+
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (obj_hash_read4 (p) << 32) | obj_hash_read4 (p + ((len >> 3) << 2));
+      b = (obj_hash_read4 (p + len - 4) << 32) | obj_hash_read4 (p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = (((uint64_t)p[0]) << 16) | (((uint64_t)p[len >> 1]) << 8) | p[len - 1];
+    }
+  } else {
+    if (i > 48) {
+      uint64_t                                see1 = seed;
+      uint64_t                                see2 = seed;
+
+      do {
+        seed = obj_hash_mix (obj_hash_read8 (p) ^ OBJ_HASH_P1, obj_hash_read8 (p + 8) ^ seed);
+        see1 = obj_hash_mix (obj_hash_read8 (p + 16) ^ OBJ_HASH_P2, obj_hash_read8 (p + 24) ^ see1);
+        see2 = obj_hash_mix (obj_hash_read8 (p + 32) ^ OBJ_HASH_P3, obj_hash_read8 (p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = obj_hash_mix (obj_hash_read8 (p) ^ OBJ_HASH_P1, obj_hash_read8 (p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = obj_hash_read8 (p + i - 16);
+    b = obj_hash_read8 (p + i - 8);
+  }
+  return (hash_size_t)obj_hash_mix (OBJ_HASH_P1 ^ len, obj_hash_mix (a ^ OBJ_HASH_P1, b ^ seed));
+}
 
-  while (key_sizeP)
-    hash ^= ((unsigned char *)keyP)[--key_sizeP];
+//------------------------------------------------------------------------------
+static void obj_hashtable_init_seed (void)
+{
+  struct timespec                         ts = {0};
+  uint64_t                                seed = 0;
+  FILE                                   *fp = NULL;
 
-  return hash;
+  if (obj_hashtable_seed) {
+    return;
+  }
+  if ((fp = fopen ("/dev/urandom", "r"))) {
+    if (1 != fread (&seed, sizeof (seed), 1, fp)) {
+      seed = 0;
+    }
+    fclose (fp);
+  }
+  if (!seed) {
+    clock_gettime (CLOCK_REALTIME, &ts);
+    seed = obj_hash_mix (((uint64_t)ts.tv_sec << 32) ^ ts.tv_nsec ^ OBJ_HASH_P2, (uint64_t)getpid () ^ OBJ_HASH_P3);
+  }
+  __sync_bool_compare_and_swap (&obj_hashtable_seed, 0, seed | 1);
 }
 
 //------------------------------------------------------------------------------
-/*
- *    Initialization
- *    obj_hashtable_init() sets up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
- *    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
- *    If an error occurred, NULL is returned. All other values in the returned obj_hash_table_t pointer should be released with hashtable_destroy().
- *
- */
-obj_hash_table_t *obj_hashtable_init (
-  obj_hash_table_t * const hashtblP,
-  const hash_size_t sizeP,
-  hash_size_t (*hashfuncP) (const void *,int),
-  void (*freekeyfuncP) (void **),
-  void (*freedatafuncP) (void **),
-  bstring display_name_pP)
+static hash_size_t obj_hashtable_upper_power_of_two (const hash_size_t sizeP)
 {
   hash_size_t size = sizeP;
   // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
@@ -97,25 +171,300 @@ obj_hash_table_t *obj_hashtable_init (
   // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
   // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
   // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
+  if (0 == size) {
+    return 1;
+  }
   size--;
   size |= size >> 1;
   size |= size >> 2;
   size |= size >> 4;
   size |= size >> 8;
   size |= size >> 16;
+  size |= (size >> 16) >> 16;
   size++;
+  return size;
+}
+
+//------------------------------------------------------------------------------
+static inline bool obj_hashtable_key_match (
+  const obj_hash_node_t * const nodeP,
+  const hash_size_t hashP,
+  const void *const keyP,
+  const int key_sizeP)
+{
+  return ((nodeP->hash == hashP) && (nodeP->key_size == key_sizeP) && ((nodeP->key == keyP) || (memcmp (nodeP->key, keyP, key_sizeP) == 0)));
+}
+
+//------------------------------------------------------------------------------
+/*
+   Returns the link pointing to the node of key keyP, searching the current bucket array and, if a resize
+   is in progress, the bucket array being migrated. NULL if the key is not in the table.
+*/
+static inline obj_hash_node_t ** obj_hashtable_find_link (
+  const obj_hash_table_t * const hashtblP,
+  const hash_size_t hashP,
+  const void *const keyP,
+  const int key_sizeP)
+{
+  obj_hash_node_t                       **link = &hashtblP->nodes[hashP % hashtblP->size];
+
+  while (*link) {
+    if (obj_hashtable_key_match (*link, hashP, keyP, key_sizeP)) {
+      return link;
+    }
+    link = &(*link)->next;
+  }
+  if (hashtblP->old_nodes) {
+    link = &hashtblP->old_nodes[hashP % hashtblP->old_size];
+    while (*link) {
+      if (obj_hashtable_key_match (*link, hashP, keyP, key_sizeP)) {
+        return link;
+      }
+      link = &(*link)->next;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Allocates a node holding a copy of the key, in the node itself when it is small enough.
+*/
+static obj_hash_node_t * obj_hashtable_new_node (
+  const hash_size_t hashP,
+  const void *const keyP,
+  const int key_sizeP,
+  void *dataP)
+{
+  obj_hash_node_t                        *node = NULL;
+
+  if (!(node = malloc (sizeof (obj_hash_node_t)))) {
+    return NULL;
+  }
+  if (key_sizeP <= OBJ_HASH_NODE_INLINE_KEY_SIZE) {
+    node->key = node->key_inline;
+  } else if (!(node->key = malloc (key_sizeP))) {
+    free_wrapper((void **) &node);
+    return NULL;
+  }
+  memcpy (node->key, keyP, key_sizeP);
+  node->key_size = key_sizeP;
+  node->hash = hashP;
+  node->data = dataP;
+  node->next = NULL;
+  return node;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Releases a node and its key copy, keys stored in the node are never given to freekeyfunc.
+*/
+static inline void obj_hashtable_free_node (
+  const obj_hash_table_t * const hashtblP,
+  obj_hash_node_t ** const nodeP)
+{
+  if ((*nodeP)->key != (*nodeP)->key_inline) {
+    hashtblP->freekeyfunc (&(*nodeP)->key);
+  }
+  free_wrapper((void **) nodeP);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Moves all nodes of bucket old_bucketP of the old bucket array to their bucket in the new bucket array.
+*/
+static inline void obj_hashtable_migrate_bucket (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t old_bucketP)
+{
+  obj_hash_node_t                        *node = hashtblP->old_nodes[old_bucketP];
+  obj_hash_node_t                        *next = NULL;
+  hash_size_t                             hash = 0;
+
+  while (node) {
+    next = node->next;
+    hash = node->hash % hashtblP->size;
+    node->next = hashtblP->nodes[hash];
+    hashtblP->nodes[hash] = node;
+    node = next;
+  }
+  hashtblP->old_nodes[old_bucketP] = NULL;
+}
 
+//------------------------------------------------------------------------------
+/*
+   Incremental resize
+   Moves at most max_bucketsP buckets of the bucket array being migrated to the current bucket array.
+   When the last bucket has been moved the old bucket array is released.
+*/
+static void
+obj_hashtable_migrate (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t max_bucketsP)
+{
+  hash_size_t                             n = 0;
+
+  while ((hashtblP->old_nodes) && (n < max_bucketsP)) {
+    obj_hashtable_migrate_bucket (hashtblP, hashtblP->migrate_index);
+    hashtblP->migrate_index += 1;
+    n += 1;
+    if (hashtblP->migrate_index == hashtblP->old_size) {
+      free_wrapper((void **) &hashtblP->old_nodes);
+      hashtblP->old_size = 0;
+      hashtblP->migrate_index = 0;
+      PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Allocates a new bucket array of sizeP buckets, the current one is kept aside for being migrated incrementally.
+   A resize still in progress is completed first.
+*/
+static hashtable_rc_t
+obj_hashtable_start_resize (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  obj_hash_node_t                       **nodes = NULL;
+
+  obj_hashtable_migrate (hashtblP, SIZE_MAX);
+  if (sizeP == hashtblP->size) {
+    return HASH_TABLE_OK;
+  }
+  if (!(nodes = calloc (sizeP, sizeof (obj_hash_node_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->migrate_index = 0;
+  hashtblP->nodes = nodes;
+  hashtblP->size = sizeP;
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Incremental resize of the thread safe table, must be called with hashtblP->mutex locked.
+   Each bucket is moved under its lock stripe, the old and the new bucket of a key share the same stripe.
+*/
+static void
+obj_hashtable_ts_migrate (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t max_bucketsP)
+{
+  hash_size_t                             n = 0;
+  obj_hash_node_t                       **old_nodes = NULL;
+  pthread_mutex_t                        *lock = NULL;
+
+  while ((hashtblP->old_nodes) && (n < max_bucketsP)) {
+    lock = &hashtblP->lock_nodes[hashtblP->migrate_index % hashtblP->lock_count];
+    pthread_mutex_lock (lock);
+    obj_hashtable_migrate_bucket (hashtblP, hashtblP->migrate_index);
+    pthread_mutex_unlock (lock);
+    hashtblP->migrate_index += 1;
+    n += 1;
+    if (hashtblP->migrate_index == hashtblP->old_size) {
+      // all stripes, no reader may still be looking at the old bucket array
+      for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+        pthread_mutex_lock (&hashtblP->lock_nodes[i]);
+      }
+      old_nodes = hashtblP->old_nodes;
+      hashtblP->old_nodes = NULL;
+      hashtblP->old_size = 0;
+      hashtblP->migrate_index = 0;
+      for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+        pthread_mutex_unlock (&hashtblP->lock_nodes[i]);
+      }
+      free_wrapper((void **) &old_nodes);
+      PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu buckets\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->size);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Must be called with hashtblP->mutex locked and no lock stripe held.
+   Only the switch of bucket arrays is done with all lock stripes held, its cost does not depend on the number of elements.
+*/
+static hashtable_rc_t
+obj_hashtable_ts_start_resize (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  obj_hash_node_t                       **nodes = NULL;
+  hash_size_t                             size = (sizeP < hashtblP->lock_count) ? hashtblP->lock_count : sizeP;
+
+  obj_hashtable_ts_migrate (hashtblP, SIZE_MAX);
+  if (size == hashtblP->size) {
+    return HASH_TABLE_OK;
+  }
+  if (!(nodes = calloc (size, sizeof (obj_hash_node_t *)))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+    pthread_mutex_lock (&hashtblP->lock_nodes[i]);
+  }
+  hashtblP->old_nodes = hashtblP->nodes;
+  hashtblP->old_size = hashtblP->size;
+  hashtblP->migrate_index = 0;
+  hashtblP->nodes = nodes;
+  hashtblP->size = size;
+  for (hash_size_t i = 0; i < hashtblP->lock_count; i++) {
+    pthread_mutex_unlock (&hashtblP->lock_nodes[i]);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Bounded amount of resize work done by insert/remove operations of the thread safe table.
+   Skipped if another thread is already migrating buckets.
+*/
+static inline void
+obj_hashtable_ts_migrate_step (
+  obj_hash_table_t * const hashtblP)
+{
+  if ((hashtblP->old_nodes) && (0 == pthread_mutex_trylock (&hashtblP->mutex))) {
+    obj_hashtable_ts_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+    pthread_mutex_unlock (&hashtblP->mutex);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ *    Initialization
+ *    obj_hashtable_init() sets up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
+ *    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
+ *    If an error occurred, NULL is returned. All other values in the returned obj_hash_table_t pointer should be released with hashtable_destroy().
+ *
+ */
+obj_hash_table_t *obj_hashtable_init (
+  obj_hash_table_t * const hashtblP,
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP) (const void *,int),
+  void (*freekeyfuncP) (void **),
+  void (*freedatafuncP) (void **),
+  bstring display_name_pP)
+{
+  hash_size_t size = obj_hashtable_upper_power_of_two (sizeP);
+
+  obj_hashtable_init_seed ();
   if (!(hashtblP->nodes = calloc (size, sizeof (obj_hash_node_t *)))) {
     free_wrapper((void **) &hashtblP);
     return NULL;
   }
 
   hashtblP->size = size;
+  hashtblP->old_nodes = NULL;
+  hashtblP->old_size = 0;
+  hashtblP->migrate_index = 0;
 
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
   else
-    hashtblP->hashfunc = def_hashfunc;
+    hashtblP->hashfunc = obj_hashtable_hash;
 
   if (freekeyfuncP)
     hashtblP->freekeyfunc = freekeyfuncP;
@@ -168,6 +517,7 @@ obj_hashtable_create (
    obj_hashtable_ts_init() sets up the initial structure of the hash table. The user specified size will be allocated and initialized to NULL.
    The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
    If an error occurred, NULL is returned. All other values in the returned obj_hash_table_t pointer should be released with hashtable_destroy().
+   Buckets are protected by lock stripes: there are at most HASH_TABLE_TS_MAX_LOCK_STRIPES locks, a key is protected by lock hash % lock_count.
 */
 obj_hash_table_t                       *
 obj_hashtable_ts_init (
@@ -179,26 +529,10 @@ obj_hashtable_ts_init (
   void (*freedatafuncP) (void **),
   bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
+  hash_size_t size = obj_hashtable_upper_power_of_two (sizeP);
 
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
+  hashtblP->lock_count = (size > HASH_TABLE_TS_MAX_LOCK_STRIPES) ? HASH_TABLE_TS_MAX_LOCK_STRIPES : size;
+  if (!(hashtblP->lock_nodes = calloc (hashtblP->lock_count, sizeof (pthread_mutex_t)))) {
     free_wrapper((void **) &hashtblP->nodes);
     free_wrapper((void **) &hashtblP->name);
     free_wrapper((void **) &hashtblP);
@@ -206,7 +540,7 @@ obj_hashtable_ts_init (
   }
 
   pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
+  for (int i = 0; i < hashtblP->lock_count; i++) {
     pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
   }
 
@@ -231,25 +565,7 @@ obj_hashtable_ts_create (
   bstring display_name_pP)
 {
   obj_hash_table_t                       *hashtbl = NULL;
-
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
+  hash_size_t                             size = obj_hashtable_upper_power_of_two (sizeP);
 
   if (!(hashtbl = obj_hashtable_create (size,hashfuncP,freekeyfuncP,freedatafuncP,display_name_pP))) {
     return NULL;
@@ -271,15 +587,15 @@ obj_hashtable_destroy (
   obj_hash_node_t                        *node,
                                          *oldnode;
 
+  obj_hashtable_migrate (hashtblP, SIZE_MAX);
   for (n = 0; n < hashtblP->size; ++n) {
     node = hashtblP->nodes[n];
 
     while (node) {
       oldnode = node;
       node = node->next;
-      hashtblP->freekeyfunc (&oldnode->key);
       hashtblP->freedatafunc (&oldnode->data);
-      free_wrapper((void **) &oldnode);
+      obj_hashtable_free_node (hashtblP, &oldnode);
     }
   }
 
@@ -302,21 +618,26 @@ obj_hashtable_ts_destroy (
   obj_hash_node_t                        *node,
                                          *oldnode;
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
+  pthread_mutex_lock (&hashtblP->mutex);
+  obj_hashtable_ts_migrate (hashtblP, SIZE_MAX);
+  pthread_mutex_unlock (&hashtblP->mutex);
+  for (hash_size_t s = 0; s < hashtblP->lock_count; ++s) {
+    pthread_mutex_lock (&hashtblP->lock_nodes[s]);
+    for (n = s; n < hashtblP->size; n += hashtblP->lock_count) {
+      node = hashtblP->nodes[n];
 
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      hashtblP->freekeyfunc (&oldnode->key);
-      hashtblP->freedatafunc (&oldnode->data);
-      free_wrapper((void **) &oldnode);
+      while (node) {
+        oldnode = node;
+        node = node->next;
+        hashtblP->freedatafunc (&oldnode->data);
+        obj_hashtable_free_node (hashtblP, &oldnode);
+      }
     }
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
+    pthread_mutex_unlock (&hashtblP->lock_nodes[s]);
+    pthread_mutex_destroy (&hashtblP->lock_nodes[s]);
   }
 
+  pthread_mutex_destroy (&hashtblP->mutex);
   free_wrapper((void **) &hashtblP->nodes);
   free_wrapper((void**) &hashtblP->lock_nodes);
   bdestroy(hashtblP->name);
@@ -331,7 +652,6 @@ obj_hashtable_is_key_exists (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node;
   hash_size_t                             hash;
 
   if (hashtblP == NULL) {
@@ -343,21 +663,10 @@ obj_hashtable_is_key_exists (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  if (obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
@@ -370,8 +679,9 @@ obj_hashtable_ts_is_key_exists (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node;
   hash_size_t                             hash;
+  pthread_mutex_t                        *lock = NULL;
+  obj_hash_node_t                       **link = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -382,26 +692,15 @@ obj_hashtable_ts_is_key_exists (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock (lock);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+  pthread_mutex_unlock (lock);
+  if (link) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
 
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -414,6 +713,8 @@ obj_hashtable_dump_content (
   bstring str)
 {
   obj_hash_node_t                        *node = NULL;
+  obj_hash_node_t                       **nodes[2] = {NULL, NULL};
+  hash_size_t                             sizes[2] = {0, 0};
   unsigned int                            i = 0;
 
   if (hashtblP == NULL) {
@@ -421,22 +722,29 @@ obj_hashtable_dump_content (
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat("Hash %x Key %p Key length %d Element %p\n", i, node->key, node->key_size, node->data);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy(b0);
+  nodes[0] = hashtblP->nodes;
+  sizes[0] = hashtblP->size;
+  nodes[1] = hashtblP->old_nodes;
+  sizes[1] = hashtblP->old_size;
+  for (int t = 0; t < 2; t++) {
+    i = 0;
+    while (i < sizes[t]) {
+      if (nodes[t][i] != NULL) {
+        node = nodes[t][i];
+
+        while (node) {
+          bstring b0 = bformat("Hash %x Key %p Key length %d Element %p\n", i, node->key, node->key_size, node->data);
+          if (!b0) {
+            PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+          } else {
+            bconcat(str, b0);
+            bdestroy(b0);
+          }
+          node = node->next;
         }
-        node = node->next;
       }
+      i += 1;
     }
-    i += 1;
   }
 
   return HASH_TABLE_OK;
@@ -448,31 +756,36 @@ obj_hashtable_ts_dump_content (
   bstring str)
 {
   obj_hash_node_t                        *node = NULL;
-  unsigned int                            i = 0;
+  hash_size_t                             s = 0;
 
   if (hashtblP == NULL) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat("Hash %x Key %p Key length %d Element %p\n", i, node->key, node->key_size, node->data);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy(b0);
+  while (s < hashtblP->lock_count) {
+    pthread_mutex_lock(&hashtblP->lock_nodes[s]);
+    obj_hash_node_t                     **nodes[2] = {hashtblP->nodes, hashtblP->old_nodes};
+    hash_size_t                           sizes[2] = {hashtblP->size, hashtblP->old_size};
+
+    for (int t = 0; t < 2; t++) {
+      for (hash_size_t i = s; i < sizes[t]; i += hashtblP->lock_count) {
+        node = nodes[t][i];
+
+        while (node) {
+          bstring b0 = bformat("Hash %x Key %p Key length %d Element %p\n", (unsigned int)i, node->key, node->key_size, node->data);
+          if (!b0) {
+            PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+          } else {
+            bconcat(str, b0);
+            bdestroy(b0);
+          }
+          node = node->next;
         }
-        node = node->next;
       }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
     }
-    i += 1;
+    pthread_mutex_unlock(&hashtblP->lock_nodes[s]);
+    s += 1;
   }
   return HASH_TABLE_OK;
 }
@@ -481,6 +794,7 @@ obj_hashtable_ts_dump_content (
 /*
    Adding a new element
    To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   New elements always go in the current bucket array. The table grows when the load factor is exceeded.
 */
 hashtable_rc_t
 obj_hashtable_insert (
@@ -490,6 +804,7 @@ obj_hashtable_insert (
   void *dataP)
 {
   obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
 
   if (hashtblP == NULL) {
@@ -501,48 +816,34 @@ obj_hashtable_insert (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data) {
-        hashtblP->freedatafunc (&node->data);
-      }
+  obj_hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
 
-      node->data = dataP;
-      node->key_size = key_sizeP;
-      // waste of memory here (keyP is lost) we should free_wrapper it now
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
-      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  if (link) {
+    node = *link;
+    if (node->data) {
+      hashtblP->freedatafunc (&node->data);
     }
 
-    node = node->next;
+    node->data = dataP;
+    // the node keeps its own copy of the key
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
   }
 
-  if (!(node = malloc (sizeof (obj_hash_node_t)))) {
+  if (!(node = obj_hashtable_new_node (hash, keyP, key_sizeP, dataP))) {
     PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
     return HASH_TABLE_SYSTEM_ERROR;
   }
 
-  if (!(node->key = malloc (key_sizeP))) {
-    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-    free_wrapper((void **) &node);
-    return -1;
-  }
-
-  memcpy (node->key, keyP, key_sizeP);
-  node->data = dataP;
-  node->key_size = key_sizeP;
+  node->next = hashtblP->nodes[hash % hashtblP->size];
+  hashtblP->nodes[hash % hashtblP->size] = node;
+  __sync_fetch_and_add (&hashtblP->num_elements, 1);
 
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
+  if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)) {
+    obj_hashtable_start_resize (hashtblP, hashtblP->size << 1);
   }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add (&hashtblP->num_elements, 1);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
   return HASH_TABLE_OK;
 }
@@ -551,6 +852,7 @@ obj_hashtable_insert (
 /*
    Adding a new element
    To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   New elements always go in the current bucket array. The table grows when the load factor is exceeded.
 */
 hashtable_rc_t
 obj_hashtable_ts_insert (
@@ -560,7 +862,9 @@ obj_hashtable_ts_insert (
   void *dataP)
 {
   obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
+  pthread_mutex_t                        *lock = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -571,55 +875,45 @@ obj_hashtable_ts_insert (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  obj_hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
 
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data) {
-        hashtblP->freedatafunc (&node->data);
-      }
-
-      node->data = dataP;
-      node->key_size = key_sizeP;
-      // no waste of memory here because if node->key == keyP, it is a reuse of the same key
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
-      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  if (link) {
+    node = *link;
+    if (node->data) {
+      hashtblP->freedatafunc (&node->data);
     }
 
-    node = node->next;
-  }
-
-  if (!(node = malloc (sizeof (obj_hash_node_t)))) {
-    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-    return HASH_TABLE_SYSTEM_ERROR;
+    node->data = dataP;
+    // the node keeps its own copy of the key
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
   }
 
-  if (!(node->key = malloc (key_sizeP))) {
-    free_wrapper((void **) &node);
-    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
+  if (!(node = obj_hashtable_new_node (hash, keyP, key_sizeP, dataP))) {
+    pthread_mutex_unlock (lock);
     PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
     return HASH_TABLE_SYSTEM_ERROR;
   }
 
-
-  memcpy (node->key, keyP, key_sizeP);
-  node->data = dataP;
-  node->key_size = key_sizeP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
-  hashtblP->nodes[hash] = node;
+  node->next = hashtblP->nodes[hash % hashtblP->size];
+  hashtblP->nodes[hash % hashtblP->size] = node;
   __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
+
+  // unlocked reads are only a hint, checked again under the table mutex
+  if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)
+      && (0 == pthread_mutex_trylock (&hashtblP->mutex))) {
+    if ((!hashtblP->old_nodes) && (hashtblP->num_elements > hashtblP->size * HASH_TABLE_MAX_LOAD_FACTOR)) {
+      obj_hashtable_ts_start_resize (hashtblP, hashtblP->size << 1);
+    }
+    pthread_mutex_unlock (&hashtblP->mutex);
+  }
   return HASH_TABLE_OK;
 }
 
@@ -634,8 +928,8 @@ obj_hashtable_free (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
+  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
 
   if (hashtblP == NULL) {
@@ -647,27 +941,18 @@ obj_hashtable_free (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
-
-      hashtblP->freekeyfunc (&node->key);
-      hashtblP->freedatafunc (&node->data);
-      free_wrapper((void **) &node);
-      hashtblP->num_elements -= 1;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  obj_hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    hashtblP->freedatafunc (&node->data);
+    obj_hashtable_free_node (hashtblP, &node);
+    hashtblP->num_elements -= 1;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
 
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -684,9 +969,10 @@ obj_hashtable_ts_free (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
+  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
+  pthread_mutex_t                        *lock = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -697,31 +983,23 @@ obj_hashtable_ts_free (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
-
-      hashtblP->freekeyfunc (&node->key);
-      hashtblP->freedatafunc (&node->data);
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  obj_hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    hashtblP->freedatafunc (&node->data);
+    obj_hashtable_free_node (hashtblP, &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
 
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -738,8 +1016,8 @@ obj_hashtable_remove (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
+  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
 
   if (hashtblP == NULL) {
@@ -751,27 +1029,18 @@ obj_hashtable_remove (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
-
-      hashtblP->freekeyfunc (&node->key);
-      *dataP = node->data;
-      free_wrapper((void **) &node);
-      hashtblP->num_elements -= 1;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  obj_hashtable_migrate (hashtblP, HASH_TABLE_MIGRATE_BUCKETS_PER_OP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    *dataP = node->data;
+    obj_hashtable_free_node (hashtblP, &node);
+    hashtblP->num_elements -= 1;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
 
   return HASH_TABLE_KEY_NOT_EXISTS;
@@ -789,9 +1058,10 @@ obj_hashtable_ts_remove (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
+  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
+  pthread_mutex_t                        *lock = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -802,31 +1072,23 @@ obj_hashtable_ts_remove (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
-
-      hashtblP->freekeyfunc (&node->key);
-      *dataP = node->data;
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  obj_hashtable_ts_migrate_step (hashtblP);
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+
+  if (link) {
+    node = *link;
+    *link = node->next;
+    *dataP = node->data;
+    obj_hashtable_free_node (hashtblP, &node);
+    __sync_fetch_and_sub (&hashtblP->num_elements, 1);
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
 
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -843,7 +1105,7 @@ obj_hashtable_get (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
 
   if (hashtblP == NULL) {
@@ -856,23 +1118,12 @@ obj_hashtable_get (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        *dataP = node->data;
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+  if (link) {
+    *dataP = (*link)->data;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
+    return HASH_TABLE_OK;
   }
 
   *dataP = NULL;
@@ -892,8 +1143,9 @@ obj_hashtable_ts_get (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node;
+  obj_hash_node_t                       **link;
   hash_size_t                             hash;
+  pthread_mutex_t                        *lock = NULL;
 
   if (hashtblP == NULL) {
     *dataP = NULL;
@@ -905,30 +1157,19 @@ obj_hashtable_ts_get (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        *dataP = node->data;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  hash = hashtblP->hashfunc (keyP, key_sizeP);
+  lock = &hashtblP->lock_nodes[hash % hashtblP->lock_count];
+  pthread_mutex_lock(lock);
+  link = obj_hashtable_find_link (hashtblP, hash, keyP, key_sizeP);
+  if (link) {
+    *dataP = (*link)->data;
+    pthread_mutex_unlock(lock);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hash);
+    return HASH_TABLE_OK;
   }
 
   *dataP = NULL;
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
+  pthread_mutex_unlock(lock);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -958,7 +1199,13 @@ obj_hashtable_get_keys (
   if (keysP) {
     for (n = 0; n < hashtblP->size; ++n) {
       for (node = hashtblP->nodes[n]; node; node = next) {
-        keysP[*sizeP++] = node->key;
+        keysP[(*sizeP)++] = node->key;
+        next = node->next;
+      }
+    }
+    for (n = 0; n < hashtblP->old_size; ++n) {
+      for (node = hashtblP->old_nodes[n]; node; node = next) {
+        keysP[(*sizeP)++] = node->key;
         next = node->next;
       }
     }
@@ -980,7 +1227,6 @@ obj_hashtable_ts_get_keys (
   void **keysP,
   unsigned int *sizeP)
 {
-  size_t                                  n = 0;
   obj_hash_node_t                        *node = NULL;
   obj_hash_node_t                        *next = NULL;
 
@@ -993,13 +1239,20 @@ obj_hashtable_ts_get_keys (
   keysP = calloc (hashtblP->num_elements,  sizeof (void *));
 
   if (keysP) {
-    for (n = 0; n < hashtblP->size; ++n) {
-      pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-      for (node = hashtblP->nodes[n]; node; node = next) {
-        keysP[*sizeP++] = node->key;
-        next = node->next;
+    for (hash_size_t s = 0; s < hashtblP->lock_count; ++s) {
+      pthread_mutex_lock (&hashtblP->lock_nodes[s]);
+      obj_hash_node_t                   **nodes[2] = {hashtblP->nodes, hashtblP->old_nodes};
+      hash_size_t                         sizes[2] = {hashtblP->size, hashtblP->old_size};
+
+      for (int t = 0; t < 2; t++) {
+        for (hash_size_t n = s; n < sizes[t]; n += hashtblP->lock_count) {
+          for (node = nodes[t][n]; node; node = next) {
+            keysP[(*sizeP)++] = node->key;
+            next = node->next;
+          }
+        }
       }
-      pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
+      pthread_mutex_unlock (&hashtblP->lock_nodes[s]);
     }
 
     PRINT_HASHTABLE (hashtblP, "return OK\n");
@@ -1016,62 +1269,18 @@ obj_hashtable_ts_get_keys (
    If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
    If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
    Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary obj_hash_table_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_insert() and hashtable_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
+   The new bucket array is allocated here, the elements are then moved a few buckets at a time by the following insert/remove operations,
+   so that no single operation pays for rehashing the whole table.
 */
 hashtable_rc_t
 obj_hashtable_resize (
   obj_hash_table_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  obj_hash_table_t                        newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n;
-  obj_hash_node_t                        *node,
-                                         *next;
-  void                                   *dummy = NULL;
-
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (obj_hash_node_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      obj_hashtable_remove (hashtblP, node->key, node->key_size, &dummy);
-      obj_hashtable_insert (&newtbl, node->key, node->key_size, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  PRINT_HASHTABLE (hashtblP, "return OK\n");
-  return HASH_TABLE_OK;
+  return obj_hashtable_start_resize (hashtblP, obj_hashtable_upper_power_of_two (sizeP));
 }
 
 //------------------------------------------------------------------------------
@@ -1081,72 +1290,21 @@ obj_hashtable_resize (
    If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
    If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
    Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary obj_hash_table_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_insert() and hashtable_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
+   The new bucket array is allocated here, the elements are then moved a few buckets at a time by the following insert/remove operations,
+   so that no single operation pays for rehashing the whole table. The table never shrinks below its number of lock stripes.
 */
 hashtable_rc_t
 obj_hashtable_ts_resize (
   obj_hash_table_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  obj_hash_table_t                        newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n;
-  obj_hash_node_t                        *node,
-                                         *next;
-  void                                   *dummy = NULL;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (obj_hash_node_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper((void **) &newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
   pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      obj_hashtable_ts_remove (hashtblP, node->key, node->key_size, &dummy);
-      obj_hashtable_insert (&newtbl, node->key, node->key_size, node->data);
-    }
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
+  rc = obj_hashtable_ts_start_resize (hashtblP, obj_hashtable_upper_power_of_two (sizeP));
   pthread_mutex_unlock(&hashtblP->mutex);
-  PRINT_HASHTABLE (hashtblP, "return OK\n");
-  return HASH_TABLE_OK;
+  return rc;
 }
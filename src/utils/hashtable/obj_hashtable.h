@@ -36,11 +36,23 @@
 
 #include "hashtable.h"
 
+/*
+ * Keys up to OBJ_HASH_NODE_INLINE_KEY_SIZE bytes (GUTI, short APNs) are copied
+ * in the node itself, larger keys in a separate allocation. The full hash of
+ * the key is kept in the node, it filters key comparisons and avoids hashing
+ * again the keys when the table is resized.
+ */
+#ifndef OBJ_HASH_NODE_INLINE_KEY_SIZE
+#  define OBJ_HASH_NODE_INLINE_KEY_SIZE 24
+#endif
+
 typedef struct obj_hash_node_s {
     int                 key_size;
-    void               *key;
+    hash_size_t         hash;
+    void               *key;                // key_inline or allocated copy of the key
     void               *data;
     struct obj_hash_node_s *next;
+    uint8_t             key_inline[OBJ_HASH_NODE_INLINE_KEY_SIZE];
 } obj_hash_node_t;
 
 typedef struct obj_hash_table_s {
@@ -48,7 +60,11 @@ typedef struct obj_hash_table_s {
     hash_size_t         size;
     hash_size_t         num_elements;
     struct obj_hash_node_s **nodes;
+    struct obj_hash_node_s **old_nodes;     // bucket array being migrated, NULL if no resize in progress
+    hash_size_t         old_size;
+    hash_size_t         migrate_index;      // next bucket of old_nodes to migrate
     pthread_mutex_t     *lock_nodes;
+    hash_size_t         lock_count;         // number of lock stripes (thread safe tables only)
     hash_size_t       (*hashfunc)(const void*, int);
     void              (*freekeyfunc)(void**);
     void              (*freedatafunc)(void**);
@@ -56,7 +72,10 @@ typedef struct obj_hash_table_s {
     bool                log_enabled;
 } obj_hash_table_t;
 
+extern uint64_t     obj_hashtable_seed;
+
 void                obj_hashtable_no_free_key_callback(void* param);
+hash_size_t         obj_hashtable_hash (const void * const keyP, int key_sizeP) __attribute__ ((hot));
 obj_hash_table_t   *obj_hashtable_init (obj_hash_table_t * const hashtblP, const hash_size_t sizeP, hash_size_t
 (*hashfuncP) (const void *,int),void (*freekeyfuncP) (void **),void (*freedatafuncP) (void **), bstring
 display_name_pP);
@@ -88,5 +107,18 @@ hashtable_rc_t      obj_hashtable_ts_get     (const obj_hash_table_t * const has
 hashtable_rc_t      obj_hashtable_ts_get_keys(const obj_hash_table_t * const hashtblP, void ** keysP, unsigned int * sizeP);
 hashtable_rc_t      obj_hashtable_ts_resize  (obj_hash_table_t * const hashtblP, const hash_size_t sizeP);
 
+//------------------------------------------------------------------------------
+/*
+ * Mixes two 64 bits words with the process hash seed, building block for the
+ * hash functions of fixed size keys (see guti_hashfunc()).
+ */
+static inline hash_size_t obj_hashtable_hash_2x64 (const uint64_t aP, const uint64_t bP)
+{
+  __uint128_t r = (__uint128_t)(aP ^ obj_hashtable_seed ^ 0xe7037ed1a0b428dbULL) * (bP ^ 0x8ebc6af09c88c6e3ULL);
+
+  r = (__uint128_t)((uint64_t)r ^ 0xa0761d6478bd642fULL) * ((uint64_t)(r >> 64) ^ obj_hashtable_seed);
+  return (hash_size_t)((uint64_t)r ^ (uint64_t)(r >> 64));
+}
+
 #endif
 
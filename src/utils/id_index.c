@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file id_index.c
+   \brief Lock free index of elements by dense 32 bits identifiers.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "id_index.h"
+
+#define ID_INDEX_ROOT(kEY)  ((kEY) >> (ID_INDEX_DIR_BITS + ID_INDEX_LEAF_BITS))
+#define ID_INDEX_DIR(kEY)   (((kEY) >> ID_INDEX_LEAF_BITS) & (ID_INDEX_DIR_SLOTS - 1))
+#define ID_INDEX_LEAF(kEY)  ((kEY) & (ID_INDEX_LEAF_SLOTS - 1))
+
+#define ID_INDEX_LEAF_DEAD  UINT32_MAX
+
+static int                              id_index_next_reader_stripe = 0;
+static __thread int                     id_index_reader_stripe = -1;
+// read side sections of the calling thread, on all indexes
+static __thread int                     id_index_read_depth = 0;
+
+//------------------------------------------------------------------------------
+static void id_index_free_element (id_index_t * const index, void **element)
+{
+  if (index->freefunc) {
+    index->freefunc (element);
+  } else {
+    free_wrapper (element);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline id_index_readers_t *id_index_readers (id_index_t * const index)
+{
+  if (id_index_reader_stripe < 0) {
+    id_index_reader_stripe = __sync_fetch_and_add (&id_index_next_reader_stripe, 1) % ID_INDEX_READER_STRIPES;
+  }
+  return &index->readers[id_index_reader_stripe];
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The leaves seen in a read side section are not freed before its end. The
+ * pointers to the levels are loaded sequentially consistent after the
+ * counter increment, so that a reader counted after the scan of a grace
+ * period cannot see a leaf detached before it.
+ */
+static inline int id_index_read_lock (id_index_t * const index)
+{
+  const int                               epoch = __atomic_load_n (&index->epoch, __ATOMIC_SEQ_CST) & 1;
+
+  __atomic_add_fetch (&id_index_readers (index)->count[epoch], 1, __ATOMIC_SEQ_CST);
+  id_index_read_depth++;
+  return epoch;
+}
+
+//------------------------------------------------------------------------------
+static inline void id_index_read_unlock (id_index_t * const index, const int epoch)
+{
+  id_index_read_depth--;
+  __atomic_sub_fetch (&id_index_readers (index)->count[epoch], 1, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Waits for the end of the read side sections that may have seen a leaf
+ * detached before the call. A reader loads the epoch before counting itself
+ * in it, so the epoch is flipped twice: the readers of the epoch preceding
+ * the first flip are waited by the second pass.
+ */
+static void id_index_synchronize (id_index_t * const index)
+{
+  pthread_mutex_lock (&index->reclaim_mutex);
+  for (int pass = 0; pass < 2; pass++) {
+    const int                               epoch = __atomic_load_n (&index->epoch, __ATOMIC_RELAXED) & 1;
+    uint64_t                                readers = 0;
+
+    __atomic_store_n (&index->epoch, epoch ^ 1, __ATOMIC_SEQ_CST);
+    do {
+      readers = 0;
+      for (int i = 0; i < ID_INDEX_READER_STRIPES; i++) {
+        readers += __atomic_load_n (&index->readers[i].count[epoch], __ATOMIC_SEQ_CST);
+      }
+      if (readers) {
+        sched_yield ();
+      }
+    } while (readers);
+  }
+  pthread_mutex_unlock (&index->reclaim_mutex);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Returns the slot of key, NULL if its leaf does not exist yet. Missing
+ * levels are allocated when create is set, a thread losing the race to
+ * install a level frees its copy and uses the winner's one. Called in a read
+ * side section.
+ */
+static void **id_index_slot (id_index_t * const index, const id_index_key_t key, const bool create, id_index_leaf_t **leaf_p)
+{
+  id_index_dir_t                         *dir = __atomic_load_n (&index->dirs[ID_INDEX_ROOT (key)], __ATOMIC_SEQ_CST);
+  id_index_leaf_t                        *leaf = NULL;
+
+  if (!dir) {
+    if (!create) {
+      return NULL;
+    }
+    id_index_dir_t                         *new_dir = calloc (1, sizeof (id_index_dir_t));
+
+    if (!new_dir) {
+      return NULL;
+    }
+    dir = __sync_val_compare_and_swap (&index->dirs[ID_INDEX_ROOT (key)], NULL, new_dir);
+    if (dir) {
+      free_wrapper ((void **)&new_dir);
+    } else {
+      dir = new_dir;
+      __sync_fetch_and_add (&index->nb_dirs, 1);
+    }
+  }
+  leaf = __atomic_load_n (&dir->leaves[ID_INDEX_DIR (key)], __ATOMIC_SEQ_CST);
+  if (!leaf) {
+    if (!create) {
+      return NULL;
+    }
+    id_index_leaf_t                        *new_leaf = calloc (1, sizeof (id_index_leaf_t));
+
+    if (!new_leaf) {
+      return NULL;
+    }
+    leaf = __sync_val_compare_and_swap (&dir->leaves[ID_INDEX_DIR (key)], NULL, new_leaf);
+    if (leaf) {
+      free_wrapper ((void **)&new_leaf);
+    } else {
+      leaf = new_leaf;
+      __sync_fetch_and_add (&index->nb_leaves, 1);
+    }
+  }
+  if (leaf_p) {
+    *leaf_p = leaf;
+  }
+  return &leaf->elements[ID_INDEX_LEAF (key)];
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Gives back a slot reserved in leaf. The thread releasing the last one marks
+ * the leaf dead, so that no insert reserves it anymore, detaches it and
+ * returns it to be freed after a grace period. Called in a read side section,
+ * not nested in a walk that would wait for itself.
+ */
+static id_index_leaf_t *id_index_leaf_release (id_index_t * const index, const id_index_key_t key, id_index_leaf_t * const leaf)
+{
+  uint32_t                                nb_elements = 0;
+
+  if (1 != __atomic_fetch_sub (&leaf->nb_elements, 1, __ATOMIC_SEQ_CST)) {
+    return NULL;
+  }
+  if ((1 < id_index_read_depth) || !__atomic_compare_exchange_n (&leaf->nb_elements, &nb_elements, ID_INDEX_LEAF_DEAD, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    return NULL;
+  }
+  __atomic_store_n (&index->dirs[ID_INDEX_ROOT (key)]->leaves[ID_INDEX_DIR (key)], NULL, __ATOMIC_SEQ_CST);
+  __sync_fetch_and_sub (&index->nb_leaves, 1);
+  return leaf;
+}
+
+//------------------------------------------------------------------------------
+static void id_index_leaf_free (id_index_t * const index, id_index_leaf_t * leaf)
+{
+  if (leaf) {
+    id_index_synchronize (index);
+    free_wrapper ((void **)&leaf);
+  }
+}
+
+//------------------------------------------------------------------------------
+id_index_t *id_index_create (void (*freefunc)(void**), bstring name)
+{
+  id_index_t                             *index = calloc (1, sizeof (id_index_t));
+
+  if (!index) {
+    return NULL;
+  }
+  index->freefunc = freefunc;
+  index->name = (name) ? bstrcpy (name) : bfromcstr ("id_index");
+  pthread_mutex_init (&index->reclaim_mutex, NULL);
+  return index;
+}
+
+//------------------------------------------------------------------------------
+void id_index_destroy (id_index_t * const index)
+{
+  if (!index) {
+    return;
+  }
+  for (int r = 0; r < ID_INDEX_ROOT_SLOTS; r++) {
+    id_index_dir_t                         *dir = index->dirs[r];
+
+    if (!dir) {
+      continue;
+    }
+    for (int d = 0; d < ID_INDEX_DIR_SLOTS; d++) {
+      id_index_leaf_t                        *leaf = dir->leaves[d];
+
+      if (!leaf) {
+        continue;
+      }
+      for (int l = 0; l < ID_INDEX_LEAF_SLOTS; l++) {
+        if (leaf->elements[l]) {
+          id_index_free_element (index, &leaf->elements[l]);
+        }
+      }
+      free_wrapper ((void **)&dir->leaves[d]);
+    }
+    free_wrapper ((void **)&index->dirs[r]);
+  }
+  pthread_mutex_destroy (&index->reclaim_mutex);
+  bdestroy (index->name);
+  free_wrapper ((void **)&index);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t id_index_insert (id_index_t * const index, const id_index_key_t key, void *element)
+{
+  void                                  **slot = NULL;
+  void                                   *previous = NULL;
+  id_index_leaf_t                        *leaf = NULL;
+  id_index_leaf_t                        *dead_leaf = NULL;
+  uint32_t                                nb_elements = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  int                                     epoch = 0;
+
+  if (!index) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  if (!element) {
+    return HASH_TABLE_BAD_PARAMETER_KEY;
+  }
+  epoch = id_index_read_lock (index);
+  for (;;) {
+    if (!(slot = id_index_slot (index, key, true, &leaf))) {
+      rc = HASH_TABLE_SYSTEM_ERROR;
+      break;
+    }
+    // reserve the slot in its leaf, a dead leaf is detached right after being marked: look it up again
+    nb_elements = __atomic_load_n (&leaf->nb_elements, __ATOMIC_RELAXED);
+    do {
+      if (ID_INDEX_LEAF_DEAD == nb_elements) {
+        break;
+      }
+    } while (!__atomic_compare_exchange_n (&leaf->nb_elements, &nb_elements, nb_elements + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    if (ID_INDEX_LEAF_DEAD == nb_elements) {
+      continue;
+    }
+    previous = NULL;
+    if (__atomic_compare_exchange_n (slot, &previous, element, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      __sync_fetch_and_add (&index->num_elements, 1);
+    } else {
+      dead_leaf = id_index_leaf_release (index, key, leaf);
+      rc = HASH_TABLE_KEY_ALREADY_EXISTS;
+    }
+    break;
+  }
+  id_index_read_unlock (index, epoch);
+  id_index_leaf_free (index, dead_leaf);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t id_index_get (const id_index_t * const index, const id_index_key_t key, void **element)
+{
+  void                                  **slot = NULL;
+  int                                     epoch = 0;
+
+  if (!index) {
+    *element = NULL;
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  epoch = id_index_read_lock ((id_index_t *)index);
+  slot = id_index_slot ((id_index_t *)index, key, false, NULL);
+  *element = (slot) ? __atomic_load_n (slot, __ATOMIC_ACQUIRE) : NULL;
+  id_index_read_unlock ((id_index_t *)index, epoch);
+  return (*element) ? HASH_TABLE_OK : HASH_TABLE_KEY_NOT_EXISTS;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t id_index_remove (id_index_t * const index, const id_index_key_t key, void **element)
+{
+  void                                  **slot = NULL;
+  id_index_leaf_t                        *leaf = NULL;
+  id_index_leaf_t                        *dead_leaf = NULL;
+  int                                     epoch = 0;
+
+  *element = NULL;
+  if (!index) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  epoch = id_index_read_lock (index);
+  if ((slot = id_index_slot (index, key, false, &leaf))) {
+    *element = __atomic_exchange_n (slot, NULL, __ATOMIC_ACQ_REL);
+    if (*element) {
+      dead_leaf = id_index_leaf_release (index, key, leaf);
+    }
+  }
+  id_index_read_unlock (index, epoch);
+  if (!*element) {
+    return HASH_TABLE_KEY_NOT_EXISTS;
+  }
+  __sync_fetch_and_sub (&index->num_elements, 1);
+  id_index_leaf_free (index, dead_leaf);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t id_index_free (id_index_t * const index, const id_index_key_t key)
+{
+  void                                   *element = NULL;
+  hashtable_rc_t                          rc = id_index_remove (index, key, &element);
+
+  if (HASH_TABLE_OK == rc) {
+    id_index_free_element (index, &element);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t id_index_apply_callback_on_elements (id_index_t * const index,
+                                                    bool func_cb(const hash_key_t key, void* const element, void* parameter, void**result),
+                                                    void* parameter,
+                                                    void**result)
+{
+  int                                     epoch = 0;
+
+  if (!index) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  // one read side section for the whole walk, func_cb may remove the elements it is given
+  epoch = id_index_read_lock (index);
+  for (uint32_t r = 0; r < ID_INDEX_ROOT_SLOTS; r++) {
+    id_index_dir_t                         *dir = __atomic_load_n (&index->dirs[r], __ATOMIC_SEQ_CST);
+
+    if (!dir) {
+      continue;
+    }
+    for (uint32_t d = 0; d < ID_INDEX_DIR_SLOTS; d++) {
+      id_index_leaf_t                        *leaf = __atomic_load_n (&dir->leaves[d], __ATOMIC_SEQ_CST);
+
+      if (!leaf) {
+        continue;
+      }
+      for (uint32_t l = 0; l < ID_INDEX_LEAF_SLOTS; l++) {
+        void                                   *element = __atomic_load_n (&leaf->elements[l], __ATOMIC_ACQUIRE);
+
+        if (element) {
+          const hash_key_t                        key = ((hash_key_t)r << (ID_INDEX_DIR_BITS + ID_INDEX_LEAF_BITS)) | (d << ID_INDEX_LEAF_BITS) | l;
+
+          if (func_cb (key, element, parameter, result)) {
+            id_index_read_unlock (index, epoch);
+            return HASH_TABLE_OK;
+          }
+        }
+      }
+    }
+  }
+  id_index_read_unlock (index, epoch);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+uint64_t id_index_num_elements (const id_index_t * const index)
+{
+  return (index) ? __atomic_load_n (&index->num_elements, __ATOMIC_RELAXED) : 0;
+}
+
+//------------------------------------------------------------------------------
+size_t id_index_memory_bytes (const id_index_t * const index)
+{
+  if (!index) {
+    return 0;
+  }
+  return sizeof (id_index_t) + __atomic_load_n (&index->nb_dirs, __ATOMIC_RELAXED) * sizeof (id_index_dir_t) +
+         __atomic_load_n (&index->nb_leaves, __ATOMIC_RELAXED) * sizeof (id_index_leaf_t);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#ifndef FILE_ID_INDEX_SEEN
+#define FILE_ID_INDEX_SEEN
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+
+/*
+ * Index of elements by a 32 bits identifier allocated by the node itself
+ * (TEIDs, S1AP UE ids, ...), so keys are dense and need no hashing.
+ *
+ * The index is a three level radix tree: a root of ID_INDEX_ROOT_SLOTS
+ * pointers, directories of ID_INDEX_DIR_SLOTS pointers and leaves of
+ * ID_INDEX_LEAF_SLOTS element pointers. Directories and leaves are allocated
+ * on first use and installed with a compare and swap, it never rehashes.
+ * Directories are kept until id_index_destroy(), a leaf is reclaimed when its
+ * last element is removed: the index holds the leaves of the keys in use, the
+ * callers recycle their identifiers to keep them dense.
+ *
+ * Insert, remove and get are lock free and may be called concurrently, also
+ * for the same key. They run in a read side section of the index (a counter
+ * per reader stripe), a leaf is freed once the sections that may still see it
+ * are over. As with hashtables, the caller makes sure that an element is not
+ * freed while another thread may still use it.
+ */
+#define ID_INDEX_LEAF_BITS          12
+#define ID_INDEX_DIR_BITS           10
+#define ID_INDEX_ROOT_BITS          (32 - ID_INDEX_DIR_BITS - ID_INDEX_LEAF_BITS)
+#define ID_INDEX_LEAF_SLOTS         (1 << ID_INDEX_LEAF_BITS)
+#define ID_INDEX_DIR_SLOTS          (1 << ID_INDEX_DIR_BITS)
+#define ID_INDEX_ROOT_SLOTS         (1 << ID_INDEX_ROOT_BITS)
+#define ID_INDEX_READER_STRIPES     16
+
+typedef uint32_t id_index_key_t;
+
+typedef struct id_index_leaf_s {
+  void                      *elements[ID_INDEX_LEAF_SLOTS];
+  uint32_t                   nb_elements;         // slots reserved by inserts, ID_INDEX_LEAF_DEAD once reclaimed
+} id_index_leaf_t;
+
+typedef struct id_index_dir_s {
+  id_index_leaf_t           *leaves[ID_INDEX_DIR_SLOTS];
+} id_index_dir_t;
+
+// readers in a read side section, per epoch, a stripe per cache line
+typedef struct id_index_readers_s {
+  uint64_t                   count[2];
+} __attribute__ ((aligned (64))) id_index_readers_t;
+
+typedef struct id_index_s {
+  id_index_dir_t            *dirs[ID_INDEX_ROOT_SLOTS];
+  void                     (*freefunc)(void**);
+  bstring                    name;
+  uint64_t                   num_elements;        // updated atomically
+  uint64_t                   nb_dirs;             // updated atomically
+  uint64_t                   nb_leaves;           // updated atomically
+  uint32_t                   epoch;               // flipped by the grace periods
+  pthread_mutex_t            reclaim_mutex;       // serializes the grace periods
+  id_index_readers_t         readers[ID_INDEX_READER_STRIPES];
+} id_index_t;
+
+// freefunc NULL frees the elements with free_wrapper()
+id_index_t     *id_index_create (void (*freefunc)(void**), bstring name);
+// frees the remaining elements
+void            id_index_destroy (id_index_t * const index);
+// HASH_TABLE_KEY_ALREADY_EXISTS if the key is in use, the element in place is left untouched
+hashtable_rc_t  id_index_insert (id_index_t * const index, const id_index_key_t key, void *element);
+hashtable_rc_t  id_index_get (const id_index_t * const index, const id_index_key_t key, void **element) __attribute__ ((hot));
+hashtable_rc_t  id_index_remove (id_index_t * const index, const id_index_key_t key, void **element);
+hashtable_rc_t  id_index_free (id_index_t * const index, const id_index_key_t key);
+// walks the keys in increasing order until func_cb returns true, not a snapshot if the index is modified meanwhile,
+// leaves emptied by func_cb are not reclaimed
+hashtable_rc_t  id_index_apply_callback_on_elements (id_index_t * const index,
+                                                     bool func_cb(const hash_key_t key, void* const element, void* parameter, void**result),
+                                                     void* parameter,
+                                                     void**result);
+uint64_t        id_index_num_elements (const id_index_t * const index);
+// memory of the index itself, elements excluded
+size_t          id_index_memory_bytes (const id_index_t * const index);
+
+#endif /* FILE_ID_INDEX_SEEN */
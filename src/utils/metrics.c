@@ -0,0 +1,544 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file metrics.c
+  \brief Process wide counters, gauges and latency histograms, exported in the
+  Prometheus text format.
+  \author
+  \company
+  \email
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "log.h"
+#include "metrics.h"
+
+typedef enum {
+  METRIC_TYPE_COUNTER = 0,
+  METRIC_TYPE_GAUGE,
+  METRIC_TYPE_HISTOGRAM,
+} metric_type_t;
+
+typedef struct metric_desc_s {
+  metric_type_t                           type;
+  char                                    name[METRICS_NAME_MAX_LENGTH];
+  char                                    help[METRICS_HELP_MAX_LENGTH];
+} metric_desc_t;
+
+// quantiles exported along the histograms
+static const double                     metrics_quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+__thread metrics_slot_t                *metrics_my_slot = NULL;
+
+static pthread_mutex_t                  metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static metric_desc_t                    metrics_values[METRICS_MAX_VALUES];
+static metric_desc_t                    metrics_histograms[METRICS_MAX_HISTOGRAMS];
+static int64_t                          metrics_set_values[METRICS_MAX_VALUES] = {0}; // gauges set, not in the slots
+static int                              metrics_nb_values = 0;
+static int                              metrics_nb_histograms = 0;
+static metrics_slot_t                  *metrics_slots[METRICS_MAX_SLOTS] = {NULL};
+static int                              metrics_nb_slots = 0;
+static metrics_collector_t              metrics_collectors[METRICS_MAX_COLLECTORS] = {NULL};
+static int                              metrics_nb_collectors = 0;
+
+typedef struct metrics_server_handler_desc_s {
+  char                                    path[METRICS_NAME_MAX_LENGTH];
+  const char                             *content_type;
+  metrics_server_handler_t                handler;
+} metrics_server_handler_desc_t;
+
+static struct {
+  pthread_t                               thread;
+  metrics_server_handler_desc_t           handlers[METRICS_SERVER_MAX_HANDLERS];
+  int                                     nb_handlers;
+  bool                                    running;
+  int                                     unix_fd;
+  int                                     tcp_fd;
+  char                                    unix_socket_path[sizeof (((struct sockaddr_un *)0)->sun_path)];
+} metrics_server = {.running = false, .unix_fd = -1, .tcp_fd = -1};
+
+//------------------------------------------------------------------------------
+/*
+ * Called once by every thread, on its first update.
+ */
+metrics_slot_t *metrics_slot_register (void)
+{
+  metrics_slot_t                         *slot = NULL;
+
+  pthread_mutex_lock (&metrics_mutex);
+  if (metrics_nb_slots < METRICS_MAX_SLOTS) {
+    if (posix_memalign ((void **)&slot, 64, sizeof (metrics_slot_t)) == 0) {
+      memset (slot, 0, sizeof (metrics_slot_t));
+      metrics_slots[metrics_nb_slots] = slot;
+      __atomic_store_n (&metrics_nb_slots, metrics_nb_slots + 1, __ATOMIC_RELEASE);
+    }
+  }
+  if (!slot) {
+    // shared by all the threads above the limit
+    slot = metrics_slots[METRICS_MAX_SLOTS - 1];
+  }
+  pthread_mutex_unlock (&metrics_mutex);
+  metrics_my_slot = slot;
+  return slot;
+}
+
+//------------------------------------------------------------------------------
+static metric_id_t metrics_register (metric_desc_t * const descs, int * const nb, const int max, const metric_type_t type,
+    const char * const name, const char * const help)
+{
+  metric_id_t                             id = METRIC_ID_INVALID;
+
+  pthread_mutex_lock (&metrics_mutex);
+  if (*nb < max) {
+    id = *nb;
+    descs[id].type = type;
+    snprintf (descs[id].name, METRICS_NAME_MAX_LENGTH, "%s", name);
+    snprintf (descs[id].help, METRICS_HELP_MAX_LENGTH, "%s", help);
+    __atomic_store_n (nb, *nb + 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock (&metrics_mutex);
+  if (METRIC_ID_INVALID == id) {
+    OAILOG_ERROR (LOG_UTIL, "Cannot register metric %s, no room left\n", name);
+  }
+  return id;
+}
+
+//------------------------------------------------------------------------------
+metric_id_t metrics_register_counter (const char * const name, const char * const help)
+{
+  return metrics_register (metrics_values, &metrics_nb_values, METRICS_MAX_VALUES, METRIC_TYPE_COUNTER, name, help);
+}
+
+//------------------------------------------------------------------------------
+metric_id_t metrics_register_gauge (const char * const name, const char * const help)
+{
+  return metrics_register (metrics_values, &metrics_nb_values, METRICS_MAX_VALUES, METRIC_TYPE_GAUGE, name, help);
+}
+
+//------------------------------------------------------------------------------
+metric_id_t metrics_register_histogram (const char * const name, const char * const help)
+{
+  return metrics_register (metrics_histograms, &metrics_nb_histograms, METRICS_MAX_HISTOGRAMS, METRIC_TYPE_HISTOGRAM, name, help);
+}
+
+//------------------------------------------------------------------------------
+void metrics_gauge_set (const metric_id_t id, const int64_t value)
+{
+  if ((0 <= id) && (METRICS_MAX_VALUES > id)) {
+    __atomic_store_n (&metrics_set_values[id], value, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+int64_t metrics_get_value (const metric_id_t id)
+{
+  int                                     nb_slots = __atomic_load_n (&metrics_nb_slots, __ATOMIC_ACQUIRE);
+  int64_t                                 value = 0;
+
+  if ((0 <= id) && (METRICS_MAX_VALUES > id)) {
+    value = __atomic_load_n (&metrics_set_values[id], __ATOMIC_RELAXED);
+    for (int s = 0; s < nb_slots; s++) {
+      value += __atomic_load_n (&metrics_slots[s]->values[id], __ATOMIC_RELAXED);
+    }
+  }
+  return value;
+}
+
+//------------------------------------------------------------------------------
+void metrics_get_histogram (const metric_id_t id, metrics_histogram_report_t * const report)
+{
+  int                                     nb_slots = __atomic_load_n (&metrics_nb_slots, __ATOMIC_ACQUIRE);
+  const metrics_histogram_cell_t         *cell = NULL;
+
+  memset (report, 0, sizeof (*report));
+  if ((0 > id) || (METRICS_MAX_HISTOGRAMS <= id)) {
+    return;
+  }
+  for (int s = 0; s < nb_slots; s++) {
+    cell = &metrics_slots[s]->histograms[id];
+    report->count += __atomic_load_n (&cell->count, __ATOMIC_RELAXED);
+    report->sum += __atomic_load_n (&cell->sum, __ATOMIC_RELAXED);
+    for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+      report->buckets[b] += __atomic_load_n (&cell->buckets[b], __ATOMIC_RELAXED);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Highest value counted in a bucket
+static uint64_t metrics_histogram_bucket_max (const int bucket)
+{
+  const int                               group = bucket >> METRICS_HISTOGRAM_SUB_BUCKET_BITS;
+  const uint64_t                          sub = bucket & ((1 << METRICS_HISTOGRAM_SUB_BUCKET_BITS) - 1);
+
+  if (0 == group) {
+    return sub;
+  }
+  return ((((uint64_t)1 << METRICS_HISTOGRAM_SUB_BUCKET_BITS) + sub + 1) << (group - 1)) - 1;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Returns the upper bound of the bucket holding the given percentile (0..100)
+ * of the recorded values, in microseconds.
+ */
+uint64_t metrics_histogram_percentile (const metrics_histogram_report_t * const report, const double percentile)
+{
+  uint64_t                                rank = 0;
+  uint64_t                                seen = 0;
+
+  if (0 == report->count) {
+    return 0;
+  }
+  rank = (uint64_t)((percentile / 100.0) * (double)report->count + 0.5);
+  if (0 == rank) {
+    rank = 1;
+  }
+  for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+    seen += report->buckets[b];
+    if (seen >= rank) {
+      return metrics_histogram_bucket_max (b);
+    }
+  }
+  return metrics_histogram_bucket_max (METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Histograms are exported with one bucket per power of two microseconds,
+ * which are boundaries of the internal buckets so the cumulated counts are
+ * exact, and with the quantiles computed on the internal buckets.
+ */
+static void metrics_dump_histogram (bstring out, const metric_desc_t * const desc, const metrics_histogram_report_t * const report)
+{
+  uint64_t                                cumulated = 0;
+  int                                     b = 0;
+
+  bformata (out, "# HELP %s %s\n# TYPE %s histogram\n", desc->name, desc->help, desc->name);
+  for (int bit = METRICS_HISTOGRAM_SUB_BUCKET_BITS; bit < METRICS_HISTOGRAM_MAX_BITS; bit++) {
+    // values strictly below 2^bit us
+    for (; b < metrics_histogram_bucket ((uint64_t)1 << bit); b++) {
+      cumulated += report->buckets[b];
+    }
+    bformata (out, "%s_bucket{le=\"%.6f\"} %" PRIu64 "\n", desc->name, (double)((uint64_t)1 << bit) / 1000000.0, cumulated);
+  }
+  bformata (out, "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n", desc->name, report->count);
+  bformata (out, "%s_sum %.6f\n%s_count %" PRIu64 "\n", desc->name, (double)report->sum / 1000000.0, desc->name, report->count);
+  bformata (out, "# HELP %s_quantile %s (quantiles)\n# TYPE %s_quantile gauge\n", desc->name, desc->help, desc->name);
+  for (int q = 0; q < sizeof (metrics_quantiles) / sizeof (metrics_quantiles[0]); q++) {
+    bformata (out, "%s_quantile{quantile=\"%g\"} %.6f\n", desc->name, metrics_quantiles[q],
+        (double)metrics_histogram_percentile (report, metrics_quantiles[q] * 100.0) / 1000000.0);
+  }
+}
+
+//------------------------------------------------------------------------------
+void metrics_dump_prometheus (bstring out)
+{
+  const int                               nb_values = __atomic_load_n (&metrics_nb_values, __ATOMIC_ACQUIRE);
+  const int                               nb_histograms = __atomic_load_n (&metrics_nb_histograms, __ATOMIC_ACQUIRE);
+  metrics_histogram_report_t             *report = NULL;
+
+  for (metric_id_t id = 0; id < nb_values; id++) {
+    bformata (out, "# HELP %s %s\n# TYPE %s %s\n%s %" PRId64 "\n", metrics_values[id].name, metrics_values[id].help, metrics_values[id].name,
+        (METRIC_TYPE_COUNTER == metrics_values[id].type) ? "counter" : "gauge", metrics_values[id].name, metrics_get_value (id));
+  }
+  if (nb_histograms) {
+    report = malloc (sizeof (metrics_histogram_report_t));
+    if (report) {
+      for (metric_id_t id = 0; id < nb_histograms; id++) {
+        metrics_get_histogram (id, report);
+        metrics_dump_histogram (out, &metrics_histograms[id], report);
+      }
+      free (report);
+    }
+  }
+  for (int i = 0; i < __atomic_load_n (&metrics_nb_collectors, __ATOMIC_ACQUIRE); i++) {
+    metrics_collectors[i] (out);
+  }
+}
+
+//------------------------------------------------------------------------------
+int metrics_register_collector (metrics_collector_t collector)
+{
+  int                                     rc = RETURNerror;
+
+  pthread_mutex_lock (&metrics_mutex);
+  if (METRICS_MAX_COLLECTORS > metrics_nb_collectors) {
+    metrics_collectors[metrics_nb_collectors] = collector;
+    __atomic_store_n (&metrics_nb_collectors, metrics_nb_collectors + 1, __ATOMIC_RELEASE);
+    rc = RETURNok;
+  } else {
+    OAILOG_ERROR (LOG_UTIL, "No room left for a metrics collector\n");
+  }
+  pthread_mutex_unlock (&metrics_mutex);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+uint64_t metrics_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void metrics_server_write (const int fd, const char *buffer, size_t length)
+{
+  ssize_t                                 written = 0;
+
+  while (length > 0) {
+    written = send (fd, buffer, length, MSG_NOSIGNAL);
+    if (written <= 0) {
+      if ((written < 0) && (EINTR == errno)) {
+        continue;
+      }
+      return;
+    }
+    buffer += written;
+    length -= written;
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool metrics_server_match (const char * const request, const char * const path)
+{
+  size_t                                  length = strlen (path);
+
+  return (strncmp (request, "GET ", 4) == 0) && (strncmp (request + 4, path, length) == 0) &&
+      ((request[4 + length] == ' ') || (request[4 + length] == '?'));
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Minimal HTTP/1.0 server: one request per connection, GET /metrics (or /) and
+ * the paths added by metrics_server_add_handler only, the connection is closed
+ * after the answer.
+ */
+static void metrics_server_handle_connection (const int fd)
+{
+  char                                    request[1024] = {0};
+  ssize_t                                 length = 0;
+  struct timeval                          timeout = {.tv_sec = 1, .tv_usec = 0};
+  bstring                                 body = NULL;
+  bstring                                 header = NULL;
+  metrics_server_handler_t                handler = NULL;
+  const char                             *content_type = "text/plain; version=0.0.4";
+
+  setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+  setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+  length = recv (fd, request, sizeof (request) - 1, 0);
+  if (length <= 0) {
+    return;
+  }
+  if ((metrics_server_match (request, "/metrics")) || (metrics_server_match (request, "/"))) {
+    handler = metrics_dump_prometheus;
+  } else {
+    for (int i = 0; i < metrics_server.nb_handlers; i++) {
+      if (metrics_server_match (request, metrics_server.handlers[i].path)) {
+        handler = metrics_server.handlers[i].handler;
+        content_type = metrics_server.handlers[i].content_type;
+        break;
+      }
+    }
+  }
+  if (NULL == handler) {
+    static const char                       not_found[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+    metrics_server_write (fd, not_found, sizeof (not_found) - 1);
+    return;
+  }
+  body = bfromcstralloc (16384, "");
+  (*handler) (body);
+  header = bformat ("HTTP/1.0 200 OK\r\nContent-Type: %s\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", content_type, blength (body));
+  metrics_server_write (fd, bdata (header), blength (header));
+  metrics_server_write (fd, bdata (body), blength (body));
+  bdestroy (header);
+  bdestroy (body);
+}
+
+//------------------------------------------------------------------------------
+static void *metrics_server_thread (void *args)
+{
+  struct pollfd                           fds[2];
+  int                                     nfds = 0;
+  int                                     fd = -1;
+
+  if (metrics_server.unix_fd >= 0) {
+    fds[nfds].fd = metrics_server.unix_fd;
+    fds[nfds++].events = POLLIN;
+  }
+  if (metrics_server.tcp_fd >= 0) {
+    fds[nfds].fd = metrics_server.tcp_fd;
+    fds[nfds++].events = POLLIN;
+  }
+  while (__atomic_load_n (&metrics_server.running, __ATOMIC_ACQUIRE)) {
+    // timeout so that metrics_server_stop is noticed
+    if (poll (fds, nfds, 500) <= 0) {
+      continue;
+    }
+    for (int i = 0; i < nfds; i++) {
+      if (fds[i].revents & POLLIN) {
+        fd = accept (fds[i].fd, NULL, NULL);
+        if (fd >= 0) {
+          metrics_server_handle_connection (fd);
+          close (fd);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int metrics_server_listen_unix (const char * const path)
+{
+  struct sockaddr_un                      addr = {.sun_family = AF_UNIX};
+  int                                     fd = -1;
+
+  if (strlen (path) >= sizeof (addr.sun_path)) {
+    OAILOG_ERROR (LOG_UTIL, "Metrics socket path too long %s\n", path);
+    return -1;
+  }
+  strcpy (addr.sun_path, path);
+  unlink (path);
+  if (((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) ||
+      (bind (fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) ||
+      (listen (fd, 8) < 0)) {
+    OAILOG_ERROR (LOG_UTIL, "Cannot listen on metrics socket %s: %s\n", path, strerror (errno));
+    if (fd >= 0) {
+      close (fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static int metrics_server_listen_tcp (const uint16_t port)
+{
+  struct sockaddr_in                      addr = {.sin_family = AF_INET};
+  int                                     fd = -1;
+  int                                     reuse = 1;
+
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (((fd = socket (AF_INET, SOCK_STREAM, 0)) < 0) ||
+      (setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse)) < 0) ||
+      (bind (fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) ||
+      (listen (fd, 8) < 0)) {
+    OAILOG_ERROR (LOG_UTIL, "Cannot listen on metrics port 127.0.0.1:%u: %s\n", port, strerror (errno));
+    if (fd >= 0) {
+      close (fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+int metrics_server_add_handler (const char * const path, const char * const content_type, metrics_server_handler_t handler)
+{
+  metrics_server_handler_desc_t          *desc = NULL;
+
+  if ((metrics_server.running) || (METRICS_SERVER_MAX_HANDLERS <= metrics_server.nb_handlers) ||
+      (strlen (path) >= METRICS_NAME_MAX_LENGTH)) {
+    OAILOG_ERROR (LOG_UTIL, "Cannot serve %s on the metrics server\n", path);
+    return RETURNerror;
+  }
+  desc = &metrics_server.handlers[metrics_server.nb_handlers++];
+  strcpy (desc->path, path);
+  desc->content_type = content_type;
+  desc->handler = handler;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int metrics_server_start (const char * const unix_socket_path, const uint16_t tcp_port)
+{
+  if (metrics_server.running) {
+    return RETURNerror;
+  }
+  if ((unix_socket_path) && (unix_socket_path[0])) {
+    if ((metrics_server.unix_fd = metrics_server_listen_unix (unix_socket_path)) < 0) {
+      return RETURNerror;
+    }
+    snprintf (metrics_server.unix_socket_path, sizeof (metrics_server.unix_socket_path), "%s", unix_socket_path);
+  }
+  if (tcp_port) {
+    if ((metrics_server.tcp_fd = metrics_server_listen_tcp (tcp_port)) < 0) {
+      metrics_server_stop ();
+      return RETURNerror;
+    }
+  }
+  if ((metrics_server.unix_fd < 0) && (metrics_server.tcp_fd < 0)) {
+    // nothing to serve
+    return RETURNok;
+  }
+  metrics_server.running = true;
+  if (pthread_create (&metrics_server.thread, NULL, metrics_server_thread, NULL) != 0) {
+    OAILOG_ERROR (LOG_UTIL, "Cannot start metrics server thread: %s\n", strerror (errno));
+    metrics_server.running = false;
+    metrics_server_stop ();
+    return RETURNerror;
+  }
+  if (metrics_server.unix_fd >= 0) {
+    OAILOG_INFO (LOG_UTIL, "Metrics served on unix socket %s\n", metrics_server.unix_socket_path);
+  }
+  if (metrics_server.tcp_fd >= 0) {
+    OAILOG_INFO (LOG_UTIL, "Metrics served on 127.0.0.1:%u\n", tcp_port);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void metrics_server_stop (void)
+{
+  if (__atomic_exchange_n (&metrics_server.running, false, __ATOMIC_ACQ_REL)) {
+    pthread_join (metrics_server.thread, NULL);
+  }
+  if (metrics_server.unix_fd >= 0) {
+    close (metrics_server.unix_fd);
+    unlink (metrics_server.unix_socket_path);
+    metrics_server.unix_fd = -1;
+  }
+  if (metrics_server.tcp_fd >= 0) {
+    close (metrics_server.tcp_fd);
+    metrics_server.tcp_fd = -1;
+  }
+}
@@ -0,0 +1,204 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file metrics.h
+  \brief Process wide counters, gauges and latency histograms, exported in the
+  Prometheus text format.
+  \author
+  \company
+  \email
+*/
+#ifndef FILE_METRICS_SEEN
+#define FILE_METRICS_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+
+/*
+ * Each thread updating metrics owns a slot holding a cell of every metric, so
+ * that updates never take a lock nor share a cache line with another thread.
+ * The slots are only summed when the metrics are read (export, display).
+ * Threads above METRICS_MAX_SLOTS share the last slot, updates are atomic so
+ * this only costs some contention.
+ */
+#define METRICS_MAX_VALUES                128   // counters and gauges
+#define METRICS_MAX_HISTOGRAMS            32
+#define METRICS_MAX_SLOTS                 64
+#define METRICS_NAME_MAX_LENGTH           64
+#define METRICS_HELP_MAX_LENGTH           128
+#define METRICS_SERVER_MAX_HANDLERS       8
+#define METRICS_MAX_COLLECTORS            8
+
+/*
+ * HDR like histograms of durations in microseconds: values below
+ * 2^METRICS_HISTOGRAM_SUB_BUCKET_BITS have their own bucket, then every power
+ * of two range is split in 2^METRICS_HISTOGRAM_SUB_BUCKET_BITS buckets, that is
+ * a relative error below 6.25%. Values above 2^METRICS_HISTOGRAM_MAX_BITS us
+ * (71 minutes) are counted in the last bucket.
+ */
+#define METRICS_HISTOGRAM_SUB_BUCKET_BITS 4
+#define METRICS_HISTOGRAM_MAX_BITS        32
+#define METRICS_HISTOGRAM_BUCKETS         ((METRICS_HISTOGRAM_MAX_BITS - METRICS_HISTOGRAM_SUB_BUCKET_BITS + 1) << METRICS_HISTOGRAM_SUB_BUCKET_BITS)
+
+typedef int metric_id_t;
+
+#define METRIC_ID_INVALID                 (-1)
+
+typedef struct metrics_histogram_cell_s {
+  uint64_t                                count;
+  uint64_t                                sum;        // microseconds
+  uint64_t                                buckets[METRICS_HISTOGRAM_BUCKETS];
+} metrics_histogram_cell_t;
+
+typedef struct metrics_slot_s {
+  int64_t                                 values[METRICS_MAX_VALUES];
+  metrics_histogram_cell_t                histograms[METRICS_MAX_HISTOGRAMS];
+} __attribute__ ((aligned (64))) metrics_slot_t;
+
+// Aggregated view of a histogram, for reporting only
+typedef struct metrics_histogram_report_s {
+  uint64_t                                count;
+  uint64_t                                sum;
+  uint64_t                                buckets[METRICS_HISTOGRAM_BUCKETS];
+} metrics_histogram_report_t;
+
+extern __thread metrics_slot_t           *metrics_my_slot;
+
+metrics_slot_t *metrics_slot_register (void);
+
+/*
+ * Registration is expected at init, before the threads updating the metrics
+ * are started. Names follow the Prometheus conventions (snake case, _total
+ * suffix for counters, _seconds suffix for histograms which are exported in
+ * seconds). Returns METRIC_ID_INVALID if there is no room left, updates of an
+ * invalid metric are ignored.
+ */
+metric_id_t metrics_register_counter (const char * const name, const char * const help);
+metric_id_t metrics_register_gauge (const char * const name, const char * const help);
+metric_id_t metrics_register_histogram (const char * const name, const char * const help);
+
+/*
+ * A gauge mirroring a count its module keeps itself is set rather than
+ * updated with metrics_gauge_add, it is then never off the count.
+ */
+void     metrics_gauge_set (const metric_id_t id, const int64_t value);
+
+int64_t  metrics_get_value (const metric_id_t id);
+void     metrics_get_histogram (const metric_id_t id, metrics_histogram_report_t * const report);
+uint64_t metrics_histogram_percentile (const metrics_histogram_report_t * const report, const double percentile);
+void     metrics_dump_prometheus (bstring out);
+
+/*
+ * A collector appends to the export metrics it keeps itself, labelled values
+ * (per task, per message) that are not registered metrics. To be called at
+ * init, like the registrations.
+ */
+typedef void (*metrics_collector_t) (bstring out);
+
+int      metrics_register_collector (metrics_collector_t collector);
+
+/*
+ * Serve the metrics over HTTP (GET /metrics) on a Unix socket and/or on a TCP
+ * port of the loopback interface, from a dedicated thread. A NULL path or a 0
+ * port disables the corresponding listener.
+ */
+int  metrics_server_start (const char * const unix_socket_path, const uint16_t tcp_port);
+void metrics_server_stop (void);
+
+/*
+ * Serves the output of handler on GET path too (diagnostics of other modules),
+ * to be called before metrics_server_start.
+ */
+typedef void (*metrics_server_handler_t) (bstring out);
+
+int  metrics_server_add_handler (const char * const path, const char * const content_type, metrics_server_handler_t handler);
+
+uint64_t metrics_now_ns (void);
+
+//------------------------------------------------------------------------------
+static inline metrics_slot_t *metrics_slot (void)
+{
+  if (__builtin_expect (metrics_my_slot == NULL, 0)) {
+    return metrics_slot_register ();
+  }
+  return metrics_my_slot;
+}
+
+//------------------------------------------------------------------------------
+static inline void metrics_counter_add (const metric_id_t id, const uint64_t n)
+{
+  if ((0 <= id) && (METRICS_MAX_VALUES > id)) {
+    __atomic_fetch_add (&metrics_slot ()->values[id], (int64_t)n, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void metrics_gauge_add (const metric_id_t id, const int64_t delta)
+{
+  if ((0 <= id) && (METRICS_MAX_VALUES > id)) {
+    __atomic_fetch_add (&metrics_slot ()->values[id], delta, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline int metrics_histogram_bucket (const uint64_t value)
+{
+  int                                     msb = 0;
+
+  if (value < (1 << METRICS_HISTOGRAM_SUB_BUCKET_BITS)) {
+    return (int)value;
+  }
+  if (value >> METRICS_HISTOGRAM_MAX_BITS) {
+    return METRICS_HISTOGRAM_BUCKETS - 1;
+  }
+  msb = 63 - __builtin_clzll (value);
+  return ((msb - METRICS_HISTOGRAM_SUB_BUCKET_BITS + 1) << METRICS_HISTOGRAM_SUB_BUCKET_BITS) +
+      (int)((value >> (msb - METRICS_HISTOGRAM_SUB_BUCKET_BITS)) & ((1 << METRICS_HISTOGRAM_SUB_BUCKET_BITS) - 1));
+}
+
+//------------------------------------------------------------------------------
+static inline void metrics_histogram_record (const metric_id_t id, const uint64_t value_us)
+{
+  metrics_histogram_cell_t               *cell = NULL;
+
+  if ((0 <= id) && (METRICS_MAX_HISTOGRAMS > id)) {
+    cell = &metrics_slot ()->histograms[id];
+    __atomic_fetch_add (&cell->buckets[metrics_histogram_bucket (value_us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&cell->sum, value_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&cell->count, 1, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Records the time elapsed since start_ns (metrics_now_ns ()), a start of 0
+ * means the procedure was not timed and nothing is recorded.
+ */
+static inline void metrics_histogram_record_since (const metric_id_t id, const uint64_t start_ns)
+{
+  if (start_ns) {
+    metrics_histogram_record (id, (metrics_now_ns () - start_ns) / 1000);
+  }
+}
+
+#endif /* FILE_METRICS_SEEN */
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file slab_pool.c
+   \brief Fixed size object allocator with per thread free lists.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "slab_pool.h"
+
+typedef struct slab_pool_cache_s {
+  slab_pool_object_t        *head;
+  uint32_t                   count;
+  uint32_t                   serial;              // serial of the pool the objects belong to
+} slab_pool_cache_t;
+
+static slab_pool_t                     *g_slab_pools[SLAB_POOL_MAX_POOLS] = {NULL};
+static pthread_mutex_t                  g_slab_pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t                         g_slab_pool_serial = 0;
+static pthread_key_t                    g_slab_pool_cache_key;
+static pthread_once_t                   g_slab_pool_cache_key_once = PTHREAD_ONCE_INIT;
+static __thread slab_pool_cache_t       t_slab_pool_caches[SLAB_POOL_MAX_POOLS];
+static __thread bool                    t_slab_pool_caches_registered = false;
+
+static void slab_pool_cache_drain (slab_pool_t * const pool, slab_pool_cache_t * const cache, const uint32_t nb_objects);
+
+//------------------------------------------------------------------------------
+/*
+ * Gives the objects cached by an exiting thread back to their pools.
+ */
+static void slab_pool_thread_exit (void *arg)
+{
+  slab_pool_cache_t                      *caches = (slab_pool_cache_t *)arg;
+
+  pthread_mutex_lock (&g_slab_pools_mutex);
+  for (int i = 0; i < SLAB_POOL_MAX_POOLS; i++) {
+    if ((g_slab_pools[i]) && (caches[i].head) && (caches[i].serial == g_slab_pools[i]->serial)) {
+      slab_pool_cache_drain (g_slab_pools[i], &caches[i], caches[i].count);
+    }
+  }
+  pthread_mutex_unlock (&g_slab_pools_mutex);
+}
+
+//------------------------------------------------------------------------------
+static void slab_pool_create_cache_key (void)
+{
+  pthread_key_create (&g_slab_pool_cache_key, slab_pool_thread_exit);
+}
+
+//------------------------------------------------------------------------------
+static inline slab_pool_cache_t *slab_pool_my_cache (slab_pool_t * const pool)
+{
+  slab_pool_cache_t                      *cache = &t_slab_pool_caches[pool->id];
+
+  if (__builtin_expect (!t_slab_pool_caches_registered, 0)) {
+    pthread_once (&g_slab_pool_cache_key_once, slab_pool_create_cache_key);
+    pthread_setspecific (g_slab_pool_cache_key, t_slab_pool_caches);
+    t_slab_pool_caches_registered = true;
+  }
+  if (__builtin_expect (cache->serial != pool->serial, 0)) {
+    // objects left by a destroyed pool with the same id are gone with its slabs
+    cache->head = NULL;
+    cache->count = 0;
+    cache->serial = pool->serial;
+  }
+  return cache;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Maps a new slab and puts its objects in the free list of the pool, in
+ * address order. Called with the pool mutex locked.
+ */
+static bool slab_pool_grow (slab_pool_t * const pool)
+{
+  slab_pool_slab_t                       *slab = calloc (1, sizeof (slab_pool_slab_t));
+  size_t                                  length = pool->object_size * pool->objects_per_slab;
+  void                                   *base = MAP_FAILED;
+
+  if (!slab) {
+    pool->nb_failed_slabs++;
+    return false;
+  }
+  if (pool->use_hugepages) {
+    length = (length + SLAB_POOL_HUGEPAGE_SIZE - 1) & ~((size_t)SLAB_POOL_HUGEPAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+    base = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    slab->is_hugepage = (MAP_FAILED != base);
+#endif
+  }
+  if (MAP_FAILED == base) {
+    // no reserved huge pages: fall back on regular pages, still eligible for transparent huge pages
+    base = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == base) {
+      free_wrapper ((void **)&slab);
+      pool->nb_failed_slabs++;
+      return false;
+    }
+#ifdef MADV_HUGEPAGE
+    if (pool->use_hugepages) {
+      madvise (base, length, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  slab->base = base;
+  slab->length = length;
+  slab->next = pool->slabs;
+  pool->slabs = slab;
+  pool->nb_slabs++;
+  if (slab->is_hugepage) {
+    pool->nb_hugepage_slabs++;
+  }
+
+  size_t                                  nb_objects = length / pool->object_size;
+  slab_pool_object_t                     *object = NULL;
+
+  for (size_t i = nb_objects; i > 0; i--) {
+    object = (slab_pool_object_t *)((uint8_t *)base + (i - 1) * pool->object_size);
+    object->next = pool->free_list;
+    pool->free_list = object;
+  }
+  pool->nb_free += nb_objects;
+  pool->nb_objects += nb_objects;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Moves up to SLAB_POOL_CACHE_BATCH objects of the pool free list to the
+ * thread cache.
+ */
+static void slab_pool_cache_refill (slab_pool_t * const pool, slab_pool_cache_t * const cache)
+{
+  slab_pool_object_t                     *object = NULL;
+
+  pthread_mutex_lock (&pool->mutex);
+  if ((!pool->free_list) && (!slab_pool_grow (pool))) {
+    pthread_mutex_unlock (&pool->mutex);
+    return;
+  }
+  for (int i = 0; (i < SLAB_POOL_CACHE_BATCH) && (pool->free_list); i++) {
+    object = pool->free_list;
+    pool->free_list = object->next;
+    object->next = cache->head;
+    cache->head = object;
+    cache->count++;
+    pool->nb_free--;
+  }
+  pthread_mutex_unlock (&pool->mutex);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Gives nb_objects objects of the thread cache back to the pool free list.
+ * The chain is detached before the pool mutex is taken.
+ */
+static void slab_pool_cache_drain (slab_pool_t * const pool, slab_pool_cache_t * const cache, const uint32_t nb_objects)
+{
+  slab_pool_object_t                     *first = cache->head;
+  slab_pool_object_t                     *last = cache->head;
+  uint32_t                                n = 1;
+
+  if ((0 == nb_objects) || (!first)) {
+    return;
+  }
+  while ((n < nb_objects) && (last->next)) {
+    last = last->next;
+    n++;
+  }
+  cache->head = last->next;
+  cache->count -= n;
+  pthread_mutex_lock (&pool->mutex);
+  last->next = pool->free_list;
+  pool->free_list = first;
+  pool->nb_free += n;
+  pthread_mutex_unlock (&pool->mutex);
+}
+
+//------------------------------------------------------------------------------
+slab_pool_t *slab_pool_create (const size_t object_size, const size_t objects_per_slab, const bool use_hugepages, bstring name)
+{
+  slab_pool_t                            *pool = calloc (1, sizeof (slab_pool_t));
+
+  if (!pool) {
+    return NULL;
+  }
+  pthread_mutex_init (&pool->mutex, NULL);
+  pool->object_size = (object_size < sizeof (slab_pool_object_t)) ? sizeof (slab_pool_object_t) : object_size;
+  pool->object_size = (pool->object_size + SLAB_POOL_OBJECT_ALIGN - 1) & ~((size_t)SLAB_POOL_OBJECT_ALIGN - 1);
+  pool->objects_per_slab = (objects_per_slab) ? objects_per_slab : SLAB_POOL_HUGEPAGE_SIZE / pool->object_size;
+  if (0 == pool->objects_per_slab) {
+    pool->objects_per_slab = 1;
+  }
+  pool->use_hugepages = use_hugepages;
+  pool->name = (name) ? bstrcpy (name) : bfromcstr ("slab_pool");
+  pool->id = -1;
+
+  pthread_mutex_lock (&g_slab_pools_mutex);
+  for (int i = 0; i < SLAB_POOL_MAX_POOLS; i++) {
+    if (!g_slab_pools[i]) {
+      pool->id = i;
+      pool->serial = ++g_slab_pool_serial;
+      g_slab_pools[i] = pool;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&g_slab_pools_mutex);
+  if (0 > pool->id) {
+    bdestroy (pool->name);
+    pthread_mutex_destroy (&pool->mutex);
+    free_wrapper ((void **)&pool);
+  }
+  return pool;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * All objects of the pool are released, whether they were freed or not.
+ */
+void slab_pool_destroy (slab_pool_t * pool)
+{
+  slab_pool_slab_t                       *slab = NULL;
+
+  if (!pool) {
+    return;
+  }
+  pthread_mutex_lock (&g_slab_pools_mutex);
+  g_slab_pools[pool->id] = NULL;
+  pthread_mutex_unlock (&g_slab_pools_mutex);
+  while (pool->slabs) {
+    slab = pool->slabs;
+    pool->slabs = slab->next;
+    munmap (slab->base, slab->length);
+    free_wrapper ((void **)&slab);
+  }
+  bdestroy (pool->name);
+  pthread_mutex_destroy (&pool->mutex);
+  free_wrapper ((void **)&pool);
+}
+
+//------------------------------------------------------------------------------
+void *slab_pool_alloc (slab_pool_t * const pool)
+{
+  slab_pool_cache_t                      *cache = slab_pool_my_cache (pool);
+  slab_pool_object_t                     *object = NULL;
+
+  if (__builtin_expect (!cache->head, 0)) {
+    slab_pool_cache_refill (pool, cache);
+    if (!cache->head) {
+      return NULL;
+    }
+  }
+  object = cache->head;
+  cache->head = object->next;
+  cache->count--;
+  memset (object, 0, pool->object_size);
+  return object;
+}
+
+//------------------------------------------------------------------------------
+void slab_pool_free (slab_pool_t * const pool, void **object)
+{
+  slab_pool_cache_t                      *cache = NULL;
+  slab_pool_object_t                     *obj = NULL;
+
+  if ((!object) || (!*object)) {
+    return;
+  }
+  cache = slab_pool_my_cache (pool);
+  obj = (slab_pool_object_t *)*object;
+  obj->next = cache->head;
+  cache->head = obj;
+  cache->count++;
+  *object = NULL;
+  if (__builtin_expect (cache->count > SLAB_POOL_CACHE_MAX, 0)) {
+    slab_pool_cache_drain (pool, cache, SLAB_POOL_CACHE_BATCH);
+  }
+}
+
+//------------------------------------------------------------------------------
+void slab_pool_get_stats (slab_pool_t * const pool, slab_pool_stats_t * const stats)
+{
+  slab_pool_slab_t                       *slab = NULL;
+
+  memset (stats, 0, sizeof (*stats));
+  pthread_mutex_lock (&pool->mutex);
+  stats->object_size       = pool->object_size;
+  stats->nb_objects        = pool->nb_objects;
+  stats->nb_free           = pool->nb_free;
+  stats->nb_in_use         = pool->nb_objects - pool->nb_free;
+  stats->nb_slabs          = pool->nb_slabs;
+  stats->nb_hugepage_slabs = pool->nb_hugepage_slabs;
+  stats->nb_failed_slabs   = pool->nb_failed_slabs;
+  for (slab = pool->slabs; slab; slab = slab->next) {
+    stats->memory_bytes += slab->length;
+  }
+  pthread_mutex_unlock (&pool->mutex);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Appends one line of occupancy statistics per pool to str.
+ */
+void slab_pool_dump_stats (bstring str)
+{
+  slab_pool_stats_t                       stats = {0};
+
+  pthread_mutex_lock (&g_slab_pools_mutex);
+  for (int i = 0; i < SLAB_POOL_MAX_POOLS; i++) {
+    if (g_slab_pools[i]) {
+      slab_pool_get_stats (g_slab_pools[i], &stats);
+      bformata (str, "%-24s| obj %5zu B | in use %10" PRIu64 " | free %10" PRIu64 " | slabs %6" PRIu64 " (huge %6" PRIu64 ", failed %" PRIu64 ") | %8" PRIu64 " KiB\n",
+          bdata (g_slab_pools[i]->name), stats.object_size, stats.nb_in_use, stats.nb_free, stats.nb_slabs, stats.nb_hugepage_slabs,
+          stats.nb_failed_slabs, stats.memory_bytes / 1024);
+    }
+  }
+  pthread_mutex_unlock (&g_slab_pools_mutex);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#ifndef FILE_SLAB_POOL_SEEN
+#define FILE_SLAB_POOL_SEEN
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+/*
+ * Fixed size object allocator for long lived contexts (UE contexts, ...).
+ * Objects are carved out of big slabs that are never given back to the system
+ * before the pool is destroyed: churn does not fragment the heap and the RSS
+ * is bounded by the high watermark of the number of objects.
+ *
+ * Each thread keeps a small free list per pool, objects move between these
+ * thread caches and the shared free list of the pool by batches of
+ * SLAB_POOL_CACHE_BATCH, so the pool mutex is taken once every batch at most.
+ * An object may be freed by a thread other than the one which allocated it.
+ */
+#ifndef SLAB_POOL_MAX_POOLS
+#  define SLAB_POOL_MAX_POOLS       16
+#endif
+#ifndef SLAB_POOL_CACHE_BATCH
+#  define SLAB_POOL_CACHE_BATCH     32
+#endif
+#define SLAB_POOL_CACHE_MAX         (2 * SLAB_POOL_CACHE_BATCH)
+#define SLAB_POOL_OBJECT_ALIGN      64            // objects start on a cache line
+#define SLAB_POOL_HUGEPAGE_SIZE     (2 * 1024 * 1024)
+// build option, huge page backing of the UE context pools
+#ifndef UE_CONTEXT_POOL_HUGEPAGES
+#  define UE_CONTEXT_POOL_HUGEPAGES 0
+#endif
+
+typedef struct slab_pool_object_s {
+  struct slab_pool_object_s *next;
+} slab_pool_object_t;
+
+typedef struct slab_pool_slab_s {
+  struct slab_pool_slab_s   *next;
+  void                      *base;
+  size_t                     length;
+  bool                       is_hugepage;         // backed by MAP_HUGETLB pages
+} slab_pool_slab_t;
+
+typedef struct slab_pool_s {
+  pthread_mutex_t            mutex;
+  int                        id;                  // index in the registry of pools, also index of thread caches
+  uint32_t                   serial;              // tells thread caches of a destroyed pool from the ones of its successor
+  size_t                     object_size;         // rounded up to SLAB_POOL_OBJECT_ALIGN
+  size_t                     objects_per_slab;
+  bool                       use_hugepages;
+  bstring                    name;
+  // following fields are protected by mutex
+  slab_pool_object_t        *free_list;
+  uint64_t                   nb_free;             // objects in free_list
+  uint64_t                   nb_objects;
+  uint64_t                   nb_slabs;
+  uint64_t                   nb_hugepage_slabs;
+  uint64_t                   nb_failed_slabs;     // slab allocations that failed
+  slab_pool_slab_t          *slabs;
+} slab_pool_t;
+
+typedef struct slab_pool_stats_s {
+  size_t                     object_size;
+  uint64_t                   nb_objects;          // capacity of all slabs
+  uint64_t                   nb_in_use;           // includes free objects held in thread caches (SLAB_POOL_CACHE_MAX per thread at most)
+  uint64_t                   nb_free;
+  uint64_t                   nb_slabs;
+  uint64_t                   nb_hugepage_slabs;
+  uint64_t                   nb_failed_slabs;
+  uint64_t                   memory_bytes;        // memory mapped for slabs
+} slab_pool_stats_t;
+
+// objects_per_slab 0 sizes slabs to one huge page
+slab_pool_t *slab_pool_create (const size_t object_size, const size_t objects_per_slab, const bool use_hugepages, bstring name);
+void         slab_pool_destroy (slab_pool_t * pool);
+// returns a zeroed object, NULL if the pool cannot grow
+void        *slab_pool_alloc (slab_pool_t * const pool) __attribute__ ((hot, malloc));
+void         slab_pool_free (slab_pool_t * const pool, void **object) __attribute__ ((hot));
+void         slab_pool_get_stats (slab_pool_t * const pool, slab_pool_stats_t * const stats);
+void         slab_pool_dump_stats (bstring str);
+
+#endif /* FILE_SLAB_POOL_SEEN */